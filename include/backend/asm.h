@@ -2,6 +2,7 @@
 #define __sysycompiler_backend_asm_h__
 
 #include <memory>
+#include <vector>
 
 #include "backend/instruction.h"
 #include "ir/ir.h"
@@ -40,8 +41,22 @@ void TranslateStoreInst(const std::shared_ptr<Function> &func,
                         const ir::StoreInst &inst);
 void TranslateGetelementptrInst(const std::shared_ptr<Function> &func,
                                 const ir::GetelementptrInst &inst);
+void TranslateBitwiseOpInst(const std::shared_ptr<Function> &func,
+                            const ir::BitwiseOpInst &inst);
+void TranslateZextInst(const std::shared_ptr<Function> &func,
+                       const ir::ZextInst &inst);
 void TranslateBitcastInst(const std::shared_ptr<Function> &func,
                           const ir::BitcastInst &inst);
+void TranslateIcmpInst(const std::shared_ptr<Function> &func,
+                       const ir::IcmpInst &inst);
+void TranslateSelectInst(const std::shared_ptr<Function> &func,
+                         const ir::SelectInst &inst);
+void TranslateCallInst(const std::shared_ptr<Function> &func,
+                       const ir::CallInst &inst);
+void TranslateInsertElementInst(const std::shared_ptr<Function> &func,
+                                const ir::InsertElementInst &inst);
+void TranslateExtractElementInst(const std::shared_ptr<Function> &func,
+                                 const ir::ExtractElementInst &inst);
 
 }  // namespace backend
 
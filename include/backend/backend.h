@@ -2,9 +2,18 @@
 #define __sysycompiler_backend_backend_h__
 
 #include "backend/asm.h"
+#include "backend/peephole.h"
+#include "backend/regalloc.h"
+#include "ir/ir.h"
 
 extern backend::Assembly assembly;
+extern backend::Peephole peephole;
+extern backend::GreedyRegAlloc greedy_reg_alloc;
+extern backend::ColoringRegAlloc coloring_reg_alloc;
+// the allocator Assembling() runs, the greedy one unless set otherwise
+extern backend::RegAlloc *reg_alloc;
 
-int Assembling();
+// translate the module into the global assembly
+int Assembling(const ir::Module &module);
 
 #endif
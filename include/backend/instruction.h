@@ -11,7 +11,9 @@
 #include <utility>
 #include <vector>
 
+#include "casting.h"
 #include "backend/operand.h"
+#include "emitter.h"
 
 namespace backend {
 
@@ -20,6 +22,9 @@ namespace backend {
 class Inst;
 
 class InsMov;
+class InsMvn;
+class InsMovw;
+class InsMovt;
 class InsLdr;
 class InsStr;
 class InsPush;
@@ -37,9 +42,24 @@ class InsMul;
 class InsSDiv;
 class InsAnd;
 class InsOrr;
+class InsEor;
+class InsLsl;
+class InsAsr;
+class InsLsr;
+
+class InsVld1;
+class InsVst1;
+class InsVadd;
+class InsVsub;
+class InsVmul;
+class InsVdup;
+class InsVmov;
+class InsVsetLane;
+class InsVgetLane;
 
 class InsNop;
 class InsLabel;
+class InsLtorg;
 
 class GlobalVar;
 class Function;
@@ -51,6 +71,9 @@ class Inst {
   public:
     enum InstKind {
         kInsMov,
+        kInsMvn,
+        kInsMovw,
+        kInsMovt,
         kInsLdr,
         kInsStr,
         kInsPush,
@@ -69,14 +92,30 @@ class Inst {
 
         kInsAnd,
         kInsOrr,
+        kInsEor,
+        kInsLsl,
+        kInsAsr,
+        kInsLsr,
+
+        kInsVld1,
+        kInsVst1,
+        kInsVadd,
+        kInsVsub,
+        kInsVmul,
+        kInsVdup,
+        kInsVmov,
+        kInsVsetLane,
+        kInsVgetLane,
 
         kInsNop,
-        kInsLabel
+        kInsLabel,
+        kInsLtorg
     };
     const InstKind op;
 
-    enum CondKind { kAL, kEQ, kNE, kGT, kGE, kLT, kLE };
-    const CondKind cond;
+    // after kAL in the order of ir::IcmpInst::CmpKind
+    enum CondKind { kAL, kEQ, kNE, kGT, kGE, kLT, kLE, kHI, kHS, kLO, kLS };
+    CondKind cond;  // set by the peephole when it predicates a branch away
 
     explicit Inst(const InstKind op, const CondKind cond = kAL)
         : op(op), cond(cond) {}
@@ -87,31 +126,71 @@ class Inst {
     Inst(Inst &&) = delete;
     Inst &operator=(Inst &&) = delete;
 
-    virtual std::string Str() const = 0;
+    std::string Str() const;
+    virtual void Emit(util::Emitter &emitter) const = 0;
+
+    // registers written by the instruction
+    virtual std::vector<std::shared_ptr<RegOperand>> GetDefList() const {
+        return {};
+    }
+    // registers read by the instruction
+    virtual std::vector<std::shared_ptr<RegOperand>> GetUseList() const {
+        return {};
+    }
+    // replace every occurrence of the register operand from (compared by
+    // address) with to
+    virtual void ReplaceReg(const std::shared_ptr<RegOperand> &from,
+                            const std::shared_ptr<RegOperand> &to) {}
+
+    // the same for the NEON q registers
+    virtual std::vector<std::shared_ptr<QRegOperand>> GetQDefList() const {
+        return {};
+    }
+    virtual std::vector<std::shared_ptr<QRegOperand>> GetQUseList() const {
+        return {};
+    }
+    virtual void ReplaceQReg(const std::shared_ptr<QRegOperand> &from,
+                             const std::shared_ptr<QRegOperand> &to) {}
+
+    static bool classof(const Inst *inst) { return true; }
 
     template <typename T>
     T &Cast() {
-        return dynamic_cast<T &>(*this);
+        return util::cast<T>(*this);
+    }
+    template <typename T>
+    const T &Cast() const {
+        return util::cast<T>(*this);
     }
 
   protected:
-    static const std::array<std::string, kInsLabel + 1> op_map;
-    static const std::array<std::string, kLE + 1> cond_map;
+    inline static const std::array<std::string, kInsLtorg + 1> op_map
+        = {"    mov",      "    mvn",      "    movw",    "    movt",
+           "    ldr",      "    str",      "    push",    "    pop",
+           "    cmp",      "    b",        "    bl",      "    bx",
+           "    add",      "    sub",      "    rsb",     "    mul",
+           "    sdiv",     "    and",      "    orr",     "    eor",
+           "    lsl",      "    asr",      "    lsr",     "    vld1.32",
+           "    vst1.32",  "    vadd.i32", "    vsub.i32", "    vmul.i32",
+           "    vdup.32",  "    vmov",     "    vmov.32", "    vmov.32",
+           "    nop",      "",             "    .ltorg"};
+    inline static const std::array<std::string, kLS + 1> cond_map
+        = {"  ", "eq", "ne", "gt", "ge", "lt", "le", "hi", "hs", "lo", "ls"};
 };
 
-const std::array<std::string, Inst::kInsLabel + 1> Inst::op_map
-    = {"    mov", "    ldr",  "    str", "    push", "    pop", "    cmp",
-       "    b",   "    bl",   "    bx",  "    add",  "    sub", "    rsb",
-       "    mul", "    sdiv", "    and", "    orr",  "    nop", ""};
-
-const std::array<std::string, Inst::kLE + 1> Inst::cond_map
-    = {"  ", "eq", "ne", "gt", "ge", "lt", "le"};
+inline util::Emitter &operator<<(util::Emitter &emitter, const Inst &inst) {
+    inst.Emit(emitter);
+    return emitter;
+}
 
 // mov{cond} Rd, Rm
 // mov{cond} Rd, #<imm16>
 // mov{cond} Rd, #<imm8m>
+// @ note: the assembler turns ~#<imm8m> into mvn
 class InsMov final : public Inst {
   public:
+    static bool classof(const Inst *inst) { return inst->op == kInsMov; }
+
     InsMov(std::shared_ptr<RegOperand> Rd,
            const std::shared_ptr<RegOperand> &Rm,
            const CondKind cond = kAL)
@@ -123,21 +202,130 @@ class InsMov final : public Inst {
         CheckImm();
     }
 
-    std::string Str() const override;
+    const std::shared_ptr<RegOperand> &GetRd() const { return Rd; }
+    const std::shared_ptr<Operand> &GetRmImm() const { return Rm_imm; }
+
+    void Emit(util::Emitter &emitter) const override;
+    std::vector<std::shared_ptr<RegOperand>> GetDefList() const override {
+        return {Rd};
+    }
+    std::vector<std::shared_ptr<RegOperand>> GetUseList() const override;
+    void ReplaceReg(const std::shared_ptr<RegOperand> &from,
+                    const std::shared_ptr<RegOperand> &to) override;
+
+  private:
+    std::shared_ptr<RegOperand> Rd;
+    std::shared_ptr<Operand> Rm_imm;
+
+    void CheckImm() const;
+};
+
+// mvn{cond} Rd, Rm
+// mvn{cond} Rd, #<imm8m>
+class InsMvn final : public Inst {
+  public:
+    static bool classof(const Inst *inst) { return inst->op == kInsMvn; }
+
+    InsMvn(std::shared_ptr<RegOperand> Rd,
+           const std::shared_ptr<RegOperand> &Rm,
+           const CondKind cond = kAL)
+        : Inst(kInsMvn, cond), Rd(std::move(Rd)), Rm_imm(Rm) {}
+    InsMvn(std::shared_ptr<RegOperand> Rd,
+           const std::shared_ptr<ImmOperand> &imm8m,
+           const CondKind cond = kAL)
+        : Inst(kInsMvn, cond), Rd(std::move(Rd)), Rm_imm(imm8m) {
+        CheckImm();
+    }
+
+    const std::shared_ptr<RegOperand> &GetRd() const { return Rd; }
+    const std::shared_ptr<Operand> &GetRmImm() const { return Rm_imm; }
+
+    void Emit(util::Emitter &emitter) const override;
+    std::vector<std::shared_ptr<RegOperand>> GetDefList() const override {
+        return {Rd};
+    }
+    std::vector<std::shared_ptr<RegOperand>> GetUseList() const override;
+    void ReplaceReg(const std::shared_ptr<RegOperand> &from,
+                    const std::shared_ptr<RegOperand> &to) override;
 
   private:
-    const std::shared_ptr<RegOperand> Rd;
-    const std::shared_ptr<Operand> Rm_imm;
+    std::shared_ptr<RegOperand> Rd;
+    std::shared_ptr<Operand> Rm_imm;
+
+    void CheckImm() const;
+};
+
+// movw{cond} Rd, #<imm16>
+// @ note: Rd = imm16, the upper halfword is cleared
+class InsMovw final : public Inst {
+  public:
+    static bool classof(const Inst *inst) { return inst->op == kInsMovw; }
+
+    InsMovw(std::shared_ptr<RegOperand> Rd,
+            std::shared_ptr<ImmOperand> imm16,
+            const CondKind cond = kAL)
+        : Inst(kInsMovw, cond), Rd(std::move(Rd)), imm16(std::move(imm16)) {
+        CheckImm();
+    }
+
+    const std::shared_ptr<RegOperand> &GetRd() const { return Rd; }
+    const std::shared_ptr<ImmOperand> &GetImm() const { return imm16; }
+
+    void Emit(util::Emitter &emitter) const override;
+    std::vector<std::shared_ptr<RegOperand>> GetDefList() const override {
+        return {Rd};
+    }
+    void ReplaceReg(const std::shared_ptr<RegOperand> &from,
+                    const std::shared_ptr<RegOperand> &to) override;
+
+  private:
+    std::shared_ptr<RegOperand> Rd;
+    const std::shared_ptr<ImmOperand> imm16;
+
+    void CheckImm() const;
+};
+
+// movt{cond} Rd, #<imm16>
+// @ note: the upper halfword of Rd = imm16, the lower halfword is kept
+class InsMovt final : public Inst {
+  public:
+    static bool classof(const Inst *inst) { return inst->op == kInsMovt; }
+
+    InsMovt(std::shared_ptr<RegOperand> Rd,
+            std::shared_ptr<ImmOperand> imm16,
+            const CondKind cond = kAL)
+        : Inst(kInsMovt, cond), Rd(std::move(Rd)), imm16(std::move(imm16)) {
+        CheckImm();
+    }
+
+    const std::shared_ptr<RegOperand> &GetRd() const { return Rd; }
+    const std::shared_ptr<ImmOperand> &GetImm() const { return imm16; }
+
+    void Emit(util::Emitter &emitter) const override;
+    std::vector<std::shared_ptr<RegOperand>> GetDefList() const override {
+        return {Rd};
+    }
+    std::vector<std::shared_ptr<RegOperand>> GetUseList() const override {
+        return {Rd};
+    }
+    void ReplaceReg(const std::shared_ptr<RegOperand> &from,
+                    const std::shared_ptr<RegOperand> &to) override;
+
+  private:
+    std::shared_ptr<RegOperand> Rd;
+    const std::shared_ptr<ImmOperand> imm16;
 
     void CheckImm() const;
 };
 
 // ldr{cond} Rd, [Rn]
 // ldr{cond} Rd, [Rn, #<offset>]
-// ldr{cond} Rd, =#<imm32>      @ pseudo-instruction
+// ldr{cond} Rd, =<imm32>       @ pseudo-instruction
 // ldr{cond} Rd, =label         @ pseudo-instruction
 class InsLdr final : public Inst {
   public:
+    static bool classof(const Inst *inst) { return inst->op == kInsLdr; }
+
     InsLdr(std::shared_ptr<RegOperand> Rd,
            const std::shared_ptr<RegOperand> &Rn,
            const CondKind cond = kAL)
@@ -159,11 +347,24 @@ class InsLdr final : public Inst {
            const CondKind cond = kAL)
         : Inst(kInsLdr, cond), Rd(std::move(Rd)), Rn_imm_label(label) {}
 
-    std::string Str() const override;
+    const std::shared_ptr<RegOperand> &GetRd() const { return Rd; }
+    const std::shared_ptr<Operand> &GetRnImmLabel() const {
+        return Rn_imm_label;
+    }
+    bool HasOffset() const { return offset != nullptr; }
+    const std::shared_ptr<ImmOperand> &GetOffset() const { return offset; }
+
+    void Emit(util::Emitter &emitter) const override;
+    std::vector<std::shared_ptr<RegOperand>> GetDefList() const override {
+        return {Rd};
+    }
+    std::vector<std::shared_ptr<RegOperand>> GetUseList() const override;
+    void ReplaceReg(const std::shared_ptr<RegOperand> &from,
+                    const std::shared_ptr<RegOperand> &to) override;
 
   private:
-    const std::shared_ptr<RegOperand> Rd;
-    const std::shared_ptr<Operand> Rn_imm_label;
+    std::shared_ptr<RegOperand> Rd;
+    std::shared_ptr<Operand> Rn_imm_label;
     const std::shared_ptr<ImmOperand> offset;
 };
 
@@ -171,6 +372,8 @@ class InsLdr final : public Inst {
 // str{cond} Rd, [Rn, #<offset>]
 class InsStr final : public Inst {
   public:
+    static bool classof(const Inst *inst) { return inst->op == kInsStr; }
+
     InsStr(std::shared_ptr<RegOperand> Rd,
            std::shared_ptr<RegOperand> Rn,
            const CondKind cond = kAL)
@@ -184,11 +387,21 @@ class InsStr final : public Inst {
         , Rn(std::move(Rn))
         , offset(std::move(offset)) {}
 
-    std::string Str() const override;
+    const std::shared_ptr<RegOperand> &GetRd() const { return Rd; }
+    const std::shared_ptr<RegOperand> &GetRn() const { return Rn; }
+    bool HasOffset() const { return offset != nullptr; }
+    const std::shared_ptr<ImmOperand> &GetOffset() const { return offset; }
+
+    void Emit(util::Emitter &emitter) const override;
+    std::vector<std::shared_ptr<RegOperand>> GetUseList() const override {
+        return {Rd, Rn};
+    }
+    void ReplaceReg(const std::shared_ptr<RegOperand> &from,
+                    const std::shared_ptr<RegOperand> &to) override;
 
   private:
-    const std::shared_ptr<RegOperand> Rd;
-    const std::shared_ptr<RegOperand> Rn;
+    std::shared_ptr<RegOperand> Rd;
+    std::shared_ptr<RegOperand> Rn;
     const std::shared_ptr<ImmOperand> offset;
 };
 
@@ -197,13 +410,24 @@ class InsStr final : public Inst {
 // @ curly braces '{' and '}'
 class InsPush final : public Inst {
   public:
+    static bool classof(const Inst *inst) { return inst->op == kInsPush; }
+
     // push {fp, lr}
     InsPush();
     explicit InsPush(std::vector<std::shared_ptr<RegOperand>> reg_list,
                      const CondKind cond = kAL)
         : Inst(kInsPush, cond), reg_list(std::move(reg_list)) {}
 
-    std::string Str() const override;
+    const std::vector<std::shared_ptr<RegOperand>> &GetRegList() const {
+        return reg_list;
+    }
+
+    void Emit(util::Emitter &emitter) const override;
+    std::vector<std::shared_ptr<RegOperand>> GetUseList() const override {
+        return reg_list;
+    }
+    void ReplaceReg(const std::shared_ptr<RegOperand> &from,
+                    const std::shared_ptr<RegOperand> &to) override;
 
   private:
     std::vector<std::shared_ptr<RegOperand>> reg_list;
@@ -214,13 +438,24 @@ class InsPush final : public Inst {
 // @ curly braces '{' and '}'
 class InsPop final : public Inst {
   public:
+    static bool classof(const Inst *inst) { return inst->op == kInsPop; }
+
     // pop {fp, lr}
     InsPop();
     explicit InsPop(std::vector<std::shared_ptr<RegOperand>> reg_list,
                     const CondKind cond = kAL)
         : Inst(kInsPop, cond), reg_list(std::move(reg_list)) {}
 
-    std::string Str() const override;
+    const std::vector<std::shared_ptr<RegOperand>> &GetRegList() const {
+        return reg_list;
+    }
+
+    void Emit(util::Emitter &emitter) const override;
+    std::vector<std::shared_ptr<RegOperand>> GetDefList() const override {
+        return reg_list;
+    }
+    void ReplaceReg(const std::shared_ptr<RegOperand> &from,
+                    const std::shared_ptr<RegOperand> &to) override;
 
   private:
     std::vector<std::shared_ptr<RegOperand>> reg_list;
@@ -230,6 +465,8 @@ class InsPop final : public Inst {
 // cmp{cond}, Rn, #<imm8m>
 class InsCmp final : public Inst {
   public:
+    static bool classof(const Inst *inst) { return inst->op == kInsCmp; }
+
     InsCmp(std::shared_ptr<RegOperand> Rn,
            const std::shared_ptr<RegOperand> &Rm,
            const CondKind cond = kAL)
@@ -241,11 +478,17 @@ class InsCmp final : public Inst {
         CheckImm();
     }
 
-    std::string Str() const override;
+    const std::shared_ptr<RegOperand> &GetRn() const { return Rn; }
+    const std::shared_ptr<Operand> &GetRmImm() const { return Rm_imm; }
+
+    void Emit(util::Emitter &emitter) const override;
+    std::vector<std::shared_ptr<RegOperand>> GetUseList() const override;
+    void ReplaceReg(const std::shared_ptr<RegOperand> &from,
+                    const std::shared_ptr<RegOperand> &to) override;
 
   private:
-    const std::shared_ptr<RegOperand> Rn;
-    const std::shared_ptr<Operand> Rm_imm;
+    std::shared_ptr<RegOperand> Rn;
+    std::shared_ptr<Operand> Rm_imm;
 
     void CheckImm() const;
 };
@@ -253,11 +496,15 @@ class InsCmp final : public Inst {
 // b{cond} label
 class InsB final : public Inst {
   public:
+    static bool classof(const Inst *inst) { return inst->op == kInsB; }
+
     explicit InsB(std::shared_ptr<LabelOperand> label,
                   const CondKind cond = kAL)
         : Inst(kInsB, cond), label(std::move(label)) {}
 
-    std::string Str() const override;
+    const std::shared_ptr<LabelOperand> &GetLabel() const { return label; }
+
+    void Emit(util::Emitter &emitter) const override;
 
   private:
     const std::shared_ptr<LabelOperand> label;
@@ -266,34 +513,63 @@ class InsB final : public Inst {
 // bl{cond} label(PLT)
 class InsBl final : public Inst {
   public:
+    static bool classof(const Inst *inst) { return inst->op == kInsBl; }
+
     explicit InsBl(std::shared_ptr<LabelOperand> label,
                    const CondKind cond = kAL)
-        : Inst(kInsBl, cond), label(std::move(label)) {}
-
-    std::string Str() const override;
+        : Inst(kInsBl, cond), label(std::move(label)), reg_arg_num(4) {}
+    // reg_arg_num: how many of r0-r3 carry arguments
+    InsBl(std::shared_ptr<LabelOperand> label,
+          const int reg_arg_num,
+          const CondKind cond = kAL)
+        : Inst(kInsBl, cond)
+        , label(std::move(label))
+        , reg_arg_num(reg_arg_num) {}
+
+    const std::shared_ptr<LabelOperand> &GetLabel() const { return label; }
+    int GetRegArgNum() const { return reg_arg_num; }
+
+    void Emit(util::Emitter &emitter) const override;
+    // r0-r3, ip and lr are not preserved
+    std::vector<std::shared_ptr<RegOperand>> GetDefList() const override;
+    std::vector<std::shared_ptr<RegOperand>> GetUseList() const override;
+    // nor are q0-q3 and q8-q15
+    std::vector<std::shared_ptr<QRegOperand>> GetQDefList() const override;
 
   private:
     const std::shared_ptr<LabelOperand> label;
+    const int reg_arg_num;
 };
 
 // bx{cond} Rm
 class InsBx final : public Inst {
   public:
+    static bool classof(const Inst *inst) { return inst->op == kInsBx; }
+
     // bx lr
     InsBx() : Inst(kInsBx, kAL), Rm(new RegOperand(RegOperand::kLr)) {}
     explicit InsBx(std::shared_ptr<RegOperand> Rm, const CondKind cond = kAL)
         : Inst(kInsBx, cond), Rm(std::move(Rm)) {}
 
-    std::string Str() const override;
+    const std::shared_ptr<RegOperand> &GetRm() const { return Rm; }
+
+    void Emit(util::Emitter &emitter) const override;
+    std::vector<std::shared_ptr<RegOperand>> GetUseList() const override {
+        return {Rm};
+    }
+    void ReplaceReg(const std::shared_ptr<RegOperand> &from,
+                    const std::shared_ptr<RegOperand> &to) override;
 
   private:
-    const std::shared_ptr<RegOperand> Rm;
+    std::shared_ptr<RegOperand> Rm;
 };
 
 // add{cond} Rd, Rn, Rm
 // add{cond} Rd, Rn, #<imm8m>
 class InsAdd final : public Inst {
   public:
+    static bool classof(const Inst *inst) { return inst->op == kInsAdd; }
+
     InsAdd(std::shared_ptr<RegOperand> Rd,
            std::shared_ptr<RegOperand> Rn,
            const std::shared_ptr<RegOperand> &Rm,
@@ -313,12 +589,22 @@ class InsAdd final : public Inst {
         CheckImm();
     }
 
-    std::string Str() const override;
+    const std::shared_ptr<RegOperand> &GetRd() const { return Rd; }
+    const std::shared_ptr<RegOperand> &GetRn() const { return Rn; }
+    const std::shared_ptr<Operand> &GetRmImm() const { return Rm_imm; }
+
+    void Emit(util::Emitter &emitter) const override;
+    std::vector<std::shared_ptr<RegOperand>> GetDefList() const override {
+        return {Rd};
+    }
+    std::vector<std::shared_ptr<RegOperand>> GetUseList() const override;
+    void ReplaceReg(const std::shared_ptr<RegOperand> &from,
+                    const std::shared_ptr<RegOperand> &to) override;
 
   private:
-    const std::shared_ptr<RegOperand> Rd;
-    const std::shared_ptr<RegOperand> Rn;
-    const std::shared_ptr<Operand> Rm_imm;
+    std::shared_ptr<RegOperand> Rd;
+    std::shared_ptr<RegOperand> Rn;
+    std::shared_ptr<Operand> Rm_imm;
 
     void CheckImm() const;
 };
@@ -327,6 +613,8 @@ class InsAdd final : public Inst {
 // sub{cond} Rd, Rn, #<imm8m>
 class InsSub final : public Inst {
   public:
+    static bool classof(const Inst *inst) { return inst->op == kInsSub; }
+
     InsSub(std::shared_ptr<RegOperand> Rd,
            std::shared_ptr<RegOperand> Rn,
            const std::shared_ptr<RegOperand> &Rm,
@@ -346,12 +634,22 @@ class InsSub final : public Inst {
         CheckImm();
     }
 
-    std::string Str() const override;
+    const std::shared_ptr<RegOperand> &GetRd() const { return Rd; }
+    const std::shared_ptr<RegOperand> &GetRn() const { return Rn; }
+    const std::shared_ptr<Operand> &GetRmImm() const { return Rm_imm; }
+
+    void Emit(util::Emitter &emitter) const override;
+    std::vector<std::shared_ptr<RegOperand>> GetDefList() const override {
+        return {Rd};
+    }
+    std::vector<std::shared_ptr<RegOperand>> GetUseList() const override;
+    void ReplaceReg(const std::shared_ptr<RegOperand> &from,
+                    const std::shared_ptr<RegOperand> &to) override;
 
   private:
-    const std::shared_ptr<RegOperand> Rd;
-    const std::shared_ptr<RegOperand> Rn;
-    const std::shared_ptr<Operand> Rm_imm;
+    std::shared_ptr<RegOperand> Rd;
+    std::shared_ptr<RegOperand> Rn;
+    std::shared_ptr<Operand> Rm_imm;
 
     void CheckImm() const;
 };
@@ -360,6 +658,8 @@ class InsSub final : public Inst {
 // rsb{cond} Rd, Rn, #<imm8m>
 class InsRsb final : public Inst {
   public:
+    static bool classof(const Inst *inst) { return inst->op == kInsRsb; }
+
     InsRsb(std::shared_ptr<RegOperand> Rd,
            std::shared_ptr<RegOperand> Rn,
            const std::shared_ptr<RegOperand> &Rm,
@@ -379,12 +679,22 @@ class InsRsb final : public Inst {
         CheckImm();
     }
 
-    std::string Str() const override;
+    const std::shared_ptr<RegOperand> &GetRd() const { return Rd; }
+    const std::shared_ptr<RegOperand> &GetRn() const { return Rn; }
+    const std::shared_ptr<Operand> &GetRmImm() const { return Rm_imm; }
+
+    void Emit(util::Emitter &emitter) const override;
+    std::vector<std::shared_ptr<RegOperand>> GetDefList() const override {
+        return {Rd};
+    }
+    std::vector<std::shared_ptr<RegOperand>> GetUseList() const override;
+    void ReplaceReg(const std::shared_ptr<RegOperand> &from,
+                    const std::shared_ptr<RegOperand> &to) override;
 
   private:
-    const std::shared_ptr<RegOperand> Rd;
-    const std::shared_ptr<RegOperand> Rn;
-    const std::shared_ptr<Operand> Rm_imm;
+    std::shared_ptr<RegOperand> Rd;
+    std::shared_ptr<RegOperand> Rn;
+    std::shared_ptr<Operand> Rm_imm;
 
     void CheckImm() const;
 };
@@ -392,41 +702,67 @@ class InsRsb final : public Inst {
 // mul{cond} Rd, Rm, Rs
 class InsMul final : public Inst {
   public:
+    static bool classof(const Inst *inst) { return inst->op == kInsMul; }
+
     InsMul(std::shared_ptr<RegOperand> Rd,
            std::shared_ptr<RegOperand> Rn,
            const std::shared_ptr<RegOperand> &Rs,
            const CondKind cond = kAL)
         : Inst(kInsMul, cond), Rd(std::move(Rd)), Rn(std::move(Rn)), Rs(Rs) {}
 
-    std::string Str() const override;
+    const std::shared_ptr<RegOperand> &GetRd() const { return Rd; }
+    const std::shared_ptr<RegOperand> &GetRn() const { return Rn; }
+    const std::shared_ptr<Operand> &GetRs() const { return Rs; }
+
+    void Emit(util::Emitter &emitter) const override;
+    std::vector<std::shared_ptr<RegOperand>> GetDefList() const override {
+        return {Rd};
+    }
+    std::vector<std::shared_ptr<RegOperand>> GetUseList() const override;
+    void ReplaceReg(const std::shared_ptr<RegOperand> &from,
+                    const std::shared_ptr<RegOperand> &to) override;
 
   private:
-    const std::shared_ptr<RegOperand> Rd;
-    const std::shared_ptr<RegOperand> Rn;
-    const std::shared_ptr<Operand> Rs;
+    std::shared_ptr<RegOperand> Rd;
+    std::shared_ptr<RegOperand> Rn;
+    std::shared_ptr<Operand> Rs;
 };
 
 // sdiv{cond} Rd, Rn, Rm
 class InsSDiv final : public Inst {
   public:
+    static bool classof(const Inst *inst) { return inst->op == kInsSDiv; }
+
     InsSDiv(std::shared_ptr<RegOperand> Rd,
             std::shared_ptr<RegOperand> Rn,
             const std::shared_ptr<RegOperand> &Rs,
             const CondKind cond = kAL)
         : Inst(kInsSDiv, cond), Rd(std::move(Rd)), Rn(std::move(Rn)), Rs(Rs) {}
 
-    std::string Str() const override;
+    const std::shared_ptr<RegOperand> &GetRd() const { return Rd; }
+    const std::shared_ptr<RegOperand> &GetRn() const { return Rn; }
+    const std::shared_ptr<Operand> &GetRs() const { return Rs; }
+
+    void Emit(util::Emitter &emitter) const override;
+    std::vector<std::shared_ptr<RegOperand>> GetDefList() const override {
+        return {Rd};
+    }
+    std::vector<std::shared_ptr<RegOperand>> GetUseList() const override;
+    void ReplaceReg(const std::shared_ptr<RegOperand> &from,
+                    const std::shared_ptr<RegOperand> &to) override;
 
   private:
-    const std::shared_ptr<RegOperand> Rd;
-    const std::shared_ptr<RegOperand> Rn;
-    const std::shared_ptr<Operand> Rs;
+    std::shared_ptr<RegOperand> Rd;
+    std::shared_ptr<RegOperand> Rn;
+    std::shared_ptr<Operand> Rs;
 };
 
 // and{cond} Rd, Rn, Rm
 // and{cond} Rd, Rn, #<imm8m>
 class InsAnd final : public Inst {
   public:
+    static bool classof(const Inst *inst) { return inst->op == kInsAnd; }
+
     InsAnd(std::shared_ptr<RegOperand> Rd,
            std::shared_ptr<RegOperand> Rn,
            const std::shared_ptr<RegOperand> &Rm,
@@ -446,12 +782,22 @@ class InsAnd final : public Inst {
         CheckImm();
     }
 
-    std::string Str() const override;
+    const std::shared_ptr<RegOperand> &GetRd() const { return Rd; }
+    const std::shared_ptr<RegOperand> &GetRn() const { return Rn; }
+    const std::shared_ptr<Operand> &GetRmImm() const { return Rm_imm; }
+
+    void Emit(util::Emitter &emitter) const override;
+    std::vector<std::shared_ptr<RegOperand>> GetDefList() const override {
+        return {Rd};
+    }
+    std::vector<std::shared_ptr<RegOperand>> GetUseList() const override;
+    void ReplaceReg(const std::shared_ptr<RegOperand> &from,
+                    const std::shared_ptr<RegOperand> &to) override;
 
   private:
-    const std::shared_ptr<RegOperand> Rd;
-    const std::shared_ptr<RegOperand> Rn;
-    const std::shared_ptr<Operand> Rm_imm;
+    std::shared_ptr<RegOperand> Rd;
+    std::shared_ptr<RegOperand> Rn;
+    std::shared_ptr<Operand> Rm_imm;
 
     void CheckImm() const;
 };
@@ -460,6 +806,8 @@ class InsAnd final : public Inst {
 // orr{cond} Rd, Rn, #<imm8m>
 class InsOrr final : public Inst {
   public:
+    static bool classof(const Inst *inst) { return inst->op == kInsOrr; }
+
     InsOrr(std::shared_ptr<RegOperand> Rd,
            std::shared_ptr<RegOperand> Rn,
            const std::shared_ptr<RegOperand> &Rm,
@@ -479,36 +827,546 @@ class InsOrr final : public Inst {
         CheckImm();
     }
 
-    std::string Str() const override;
+    const std::shared_ptr<RegOperand> &GetRd() const { return Rd; }
+    const std::shared_ptr<RegOperand> &GetRn() const { return Rn; }
+    const std::shared_ptr<Operand> &GetRmImm() const { return Rm_imm; }
+
+    void Emit(util::Emitter &emitter) const override;
+    std::vector<std::shared_ptr<RegOperand>> GetDefList() const override {
+        return {Rd};
+    }
+    std::vector<std::shared_ptr<RegOperand>> GetUseList() const override;
+    void ReplaceReg(const std::shared_ptr<RegOperand> &from,
+                    const std::shared_ptr<RegOperand> &to) override;
 
   private:
-    const std::shared_ptr<RegOperand> Rd;
-    const std::shared_ptr<RegOperand> Rn;
-    const std::shared_ptr<Operand> Rm_imm;
+    std::shared_ptr<RegOperand> Rd;
+    std::shared_ptr<RegOperand> Rn;
+    std::shared_ptr<Operand> Rm_imm;
 
     void CheckImm() const;
 };
 
+// eor{cond} Rd, Rn, Rm
+// eor{cond} Rd, Rn, #<imm8m>
+class InsEor final : public Inst {
+  public:
+    static bool classof(const Inst *inst) { return inst->op == kInsEor; }
+
+    InsEor(std::shared_ptr<RegOperand> Rd,
+           std::shared_ptr<RegOperand> Rn,
+           const std::shared_ptr<RegOperand> &Rm,
+           const CondKind cond = kAL)
+        : Inst(kInsEor, cond)
+        , Rd(std::move(Rd))
+        , Rn(std::move(Rn))
+        , Rm_imm(Rm) {}
+    InsEor(std::shared_ptr<RegOperand> Rd,
+           std::shared_ptr<RegOperand> Rn,
+           const std::shared_ptr<ImmOperand> &imm8m,
+           const CondKind cond = kAL)
+        : Inst(kInsEor, cond)
+        , Rd(std::move(Rd))
+        , Rn(std::move(Rn))
+        , Rm_imm(imm8m) {
+        CheckImm();
+    }
+
+    const std::shared_ptr<RegOperand> &GetRd() const { return Rd; }
+    const std::shared_ptr<RegOperand> &GetRn() const { return Rn; }
+    const std::shared_ptr<Operand> &GetRmImm() const { return Rm_imm; }
+
+    void Emit(util::Emitter &emitter) const override;
+    std::vector<std::shared_ptr<RegOperand>> GetDefList() const override {
+        return {Rd};
+    }
+    std::vector<std::shared_ptr<RegOperand>> GetUseList() const override;
+    void ReplaceReg(const std::shared_ptr<RegOperand> &from,
+                    const std::shared_ptr<RegOperand> &to) override;
+
+  private:
+    std::shared_ptr<RegOperand> Rd;
+    std::shared_ptr<RegOperand> Rn;
+    std::shared_ptr<Operand> Rm_imm;
+
+    void CheckImm() const;
+};
+
+// lsl{cond} Rd, Rm, Rs
+// lsl{cond} Rd, Rm, #<0-31>
+class InsLsl final : public Inst {
+  public:
+    static bool classof(const Inst *inst) { return inst->op == kInsLsl; }
+
+    InsLsl(std::shared_ptr<RegOperand> Rd,
+           std::shared_ptr<RegOperand> Rm,
+           const std::shared_ptr<RegOperand> &Rs,
+           const CondKind cond = kAL)
+        : Inst(kInsLsl, cond)
+        , Rd(std::move(Rd))
+        , Rm(std::move(Rm))
+        , Rs_imm(Rs) {}
+    InsLsl(std::shared_ptr<RegOperand> Rd,
+           std::shared_ptr<RegOperand> Rm,
+           const std::shared_ptr<ImmOperand> &imm,
+           const CondKind cond = kAL)
+        : Inst(kInsLsl, cond)
+        , Rd(std::move(Rd))
+        , Rm(std::move(Rm))
+        , Rs_imm(imm) {
+        CheckImm();
+    }
+
+    const std::shared_ptr<RegOperand> &GetRd() const { return Rd; }
+    const std::shared_ptr<RegOperand> &GetRm() const { return Rm; }
+    const std::shared_ptr<Operand> &GetRsImm() const { return Rs_imm; }
+
+    void Emit(util::Emitter &emitter) const override;
+    std::vector<std::shared_ptr<RegOperand>> GetDefList() const override {
+        return {Rd};
+    }
+    std::vector<std::shared_ptr<RegOperand>> GetUseList() const override;
+    void ReplaceReg(const std::shared_ptr<RegOperand> &from,
+                    const std::shared_ptr<RegOperand> &to) override;
+
+  private:
+    std::shared_ptr<RegOperand> Rd;
+    std::shared_ptr<RegOperand> Rm;
+    std::shared_ptr<Operand> Rs_imm;
+
+    void CheckImm() const;
+};
+
+// asr{cond} Rd, Rm, Rs
+// asr{cond} Rd, Rm, #<1-32>
+class InsAsr final : public Inst {
+  public:
+    static bool classof(const Inst *inst) { return inst->op == kInsAsr; }
+
+    InsAsr(std::shared_ptr<RegOperand> Rd,
+           std::shared_ptr<RegOperand> Rm,
+           const std::shared_ptr<RegOperand> &Rs,
+           const CondKind cond = kAL)
+        : Inst(kInsAsr, cond)
+        , Rd(std::move(Rd))
+        , Rm(std::move(Rm))
+        , Rs_imm(Rs) {}
+    InsAsr(std::shared_ptr<RegOperand> Rd,
+           std::shared_ptr<RegOperand> Rm,
+           const std::shared_ptr<ImmOperand> &imm,
+           const CondKind cond = kAL)
+        : Inst(kInsAsr, cond)
+        , Rd(std::move(Rd))
+        , Rm(std::move(Rm))
+        , Rs_imm(imm) {
+        CheckImm();
+    }
+
+    const std::shared_ptr<RegOperand> &GetRd() const { return Rd; }
+    const std::shared_ptr<RegOperand> &GetRm() const { return Rm; }
+    const std::shared_ptr<Operand> &GetRsImm() const { return Rs_imm; }
+
+    void Emit(util::Emitter &emitter) const override;
+    std::vector<std::shared_ptr<RegOperand>> GetDefList() const override {
+        return {Rd};
+    }
+    std::vector<std::shared_ptr<RegOperand>> GetUseList() const override;
+    void ReplaceReg(const std::shared_ptr<RegOperand> &from,
+                    const std::shared_ptr<RegOperand> &to) override;
+
+  private:
+    std::shared_ptr<RegOperand> Rd;
+    std::shared_ptr<RegOperand> Rm;
+    std::shared_ptr<Operand> Rs_imm;
+
+    void CheckImm() const;
+};
+
+// lsr{cond} Rd, Rm, Rs
+// lsr{cond} Rd, Rm, #<1-32>
+class InsLsr final : public Inst {
+  public:
+    static bool classof(const Inst *inst) { return inst->op == kInsLsr; }
+
+    InsLsr(std::shared_ptr<RegOperand> Rd,
+           std::shared_ptr<RegOperand> Rm,
+           const std::shared_ptr<RegOperand> &Rs,
+           const CondKind cond = kAL)
+        : Inst(kInsLsr, cond)
+        , Rd(std::move(Rd))
+        , Rm(std::move(Rm))
+        , Rs_imm(Rs) {}
+    InsLsr(std::shared_ptr<RegOperand> Rd,
+           std::shared_ptr<RegOperand> Rm,
+           const std::shared_ptr<ImmOperand> &imm,
+           const CondKind cond = kAL)
+        : Inst(kInsLsr, cond)
+        , Rd(std::move(Rd))
+        , Rm(std::move(Rm))
+        , Rs_imm(imm) {
+        CheckImm();
+    }
+
+    const std::shared_ptr<RegOperand> &GetRd() const { return Rd; }
+    const std::shared_ptr<RegOperand> &GetRm() const { return Rm; }
+    const std::shared_ptr<Operand> &GetRsImm() const { return Rs_imm; }
+
+    void Emit(util::Emitter &emitter) const override;
+    std::vector<std::shared_ptr<RegOperand>> GetDefList() const override {
+        return {Rd};
+    }
+    std::vector<std::shared_ptr<RegOperand>> GetUseList() const override;
+    void ReplaceReg(const std::shared_ptr<RegOperand> &from,
+                    const std::shared_ptr<RegOperand> &to) override;
+
+  private:
+    std::shared_ptr<RegOperand> Rd;
+    std::shared_ptr<RegOperand> Rm;
+    std::shared_ptr<Operand> Rs_imm;
+
+    void CheckImm() const;
+};
+
+/* NEON, unconditional in the ARM state, the lanes are i32 */
+
+// vld1.32 {Dd, Dd+1}, [Rn]
+// @ note: loads the four lanes of Qd, Rn need only be word aligned
+class InsVld1 final : public Inst {
+  public:
+    static bool classof(const Inst *inst) { return inst->op == kInsVld1; }
+
+    InsVld1(std::shared_ptr<QRegOperand> Qd, std::shared_ptr<RegOperand> Rn)
+        : Inst(kInsVld1), Qd(std::move(Qd)), Rn(std::move(Rn)) {}
+
+    const std::shared_ptr<QRegOperand> &GetQd() const { return Qd; }
+    const std::shared_ptr<RegOperand> &GetRn() const { return Rn; }
+
+    void Emit(util::Emitter &emitter) const override;
+    std::vector<std::shared_ptr<RegOperand>> GetUseList() const override {
+        return {Rn};
+    }
+    void ReplaceReg(const std::shared_ptr<RegOperand> &from,
+                    const std::shared_ptr<RegOperand> &to) override;
+    std::vector<std::shared_ptr<QRegOperand>> GetQDefList() const override {
+        return {Qd};
+    }
+    void ReplaceQReg(const std::shared_ptr<QRegOperand> &from,
+                     const std::shared_ptr<QRegOperand> &to) override;
+
+  private:
+    std::shared_ptr<QRegOperand> Qd;
+    std::shared_ptr<RegOperand> Rn;
+};
+
+// vst1.32 {Dd, Dd+1}, [Rn]
+class InsVst1 final : public Inst {
+  public:
+    static bool classof(const Inst *inst) { return inst->op == kInsVst1; }
+
+    InsVst1(std::shared_ptr<QRegOperand> Qd, std::shared_ptr<RegOperand> Rn)
+        : Inst(kInsVst1), Qd(std::move(Qd)), Rn(std::move(Rn)) {}
+
+    const std::shared_ptr<QRegOperand> &GetQd() const { return Qd; }
+    const std::shared_ptr<RegOperand> &GetRn() const { return Rn; }
+
+    void Emit(util::Emitter &emitter) const override;
+    std::vector<std::shared_ptr<RegOperand>> GetUseList() const override {
+        return {Rn};
+    }
+    void ReplaceReg(const std::shared_ptr<RegOperand> &from,
+                    const std::shared_ptr<RegOperand> &to) override;
+    std::vector<std::shared_ptr<QRegOperand>> GetQUseList() const override {
+        return {Qd};
+    }
+    void ReplaceQReg(const std::shared_ptr<QRegOperand> &from,
+                     const std::shared_ptr<QRegOperand> &to) override;
+
+  private:
+    std::shared_ptr<QRegOperand> Qd;
+    std::shared_ptr<RegOperand> Rn;
+};
+
+// vadd.i32 Qd, Qn, Qm
+class InsVadd final : public Inst {
+  public:
+    static bool classof(const Inst *inst) { return inst->op == kInsVadd; }
+
+    InsVadd(std::shared_ptr<QRegOperand> Qd,
+            std::shared_ptr<QRegOperand> Qn,
+            std::shared_ptr<QRegOperand> Qm)
+        : Inst(kInsVadd),
+          Qd(std::move(Qd)),
+          Qn(std::move(Qn)),
+          Qm(std::move(Qm)) {}
+
+    const std::shared_ptr<QRegOperand> &GetQd() const { return Qd; }
+    const std::shared_ptr<QRegOperand> &GetQn() const { return Qn; }
+    const std::shared_ptr<QRegOperand> &GetQm() const { return Qm; }
+
+    void Emit(util::Emitter &emitter) const override;
+    std::vector<std::shared_ptr<QRegOperand>> GetQDefList() const override {
+        return {Qd};
+    }
+    std::vector<std::shared_ptr<QRegOperand>> GetQUseList() const override {
+        return {Qn, Qm};
+    }
+    void ReplaceQReg(const std::shared_ptr<QRegOperand> &from,
+                     const std::shared_ptr<QRegOperand> &to) override;
+
+  private:
+    std::shared_ptr<QRegOperand> Qd;
+    std::shared_ptr<QRegOperand> Qn;
+    std::shared_ptr<QRegOperand> Qm;
+};
+
+// vsub.i32 Qd, Qn, Qm
+class InsVsub final : public Inst {
+  public:
+    static bool classof(const Inst *inst) { return inst->op == kInsVsub; }
+
+    InsVsub(std::shared_ptr<QRegOperand> Qd,
+            std::shared_ptr<QRegOperand> Qn,
+            std::shared_ptr<QRegOperand> Qm)
+        : Inst(kInsVsub),
+          Qd(std::move(Qd)),
+          Qn(std::move(Qn)),
+          Qm(std::move(Qm)) {}
+
+    const std::shared_ptr<QRegOperand> &GetQd() const { return Qd; }
+    const std::shared_ptr<QRegOperand> &GetQn() const { return Qn; }
+    const std::shared_ptr<QRegOperand> &GetQm() const { return Qm; }
+
+    void Emit(util::Emitter &emitter) const override;
+    std::vector<std::shared_ptr<QRegOperand>> GetQDefList() const override {
+        return {Qd};
+    }
+    std::vector<std::shared_ptr<QRegOperand>> GetQUseList() const override {
+        return {Qn, Qm};
+    }
+    void ReplaceQReg(const std::shared_ptr<QRegOperand> &from,
+                     const std::shared_ptr<QRegOperand> &to) override;
+
+  private:
+    std::shared_ptr<QRegOperand> Qd;
+    std::shared_ptr<QRegOperand> Qn;
+    std::shared_ptr<QRegOperand> Qm;
+};
+
+// vmul.i32 Qd, Qn, Qm
+class InsVmul final : public Inst {
+  public:
+    static bool classof(const Inst *inst) { return inst->op == kInsVmul; }
+
+    InsVmul(std::shared_ptr<QRegOperand> Qd,
+            std::shared_ptr<QRegOperand> Qn,
+            std::shared_ptr<QRegOperand> Qm)
+        : Inst(kInsVmul),
+          Qd(std::move(Qd)),
+          Qn(std::move(Qn)),
+          Qm(std::move(Qm)) {}
+
+    const std::shared_ptr<QRegOperand> &GetQd() const { return Qd; }
+    const std::shared_ptr<QRegOperand> &GetQn() const { return Qn; }
+    const std::shared_ptr<QRegOperand> &GetQm() const { return Qm; }
+
+    void Emit(util::Emitter &emitter) const override;
+    std::vector<std::shared_ptr<QRegOperand>> GetQDefList() const override {
+        return {Qd};
+    }
+    std::vector<std::shared_ptr<QRegOperand>> GetQUseList() const override {
+        return {Qn, Qm};
+    }
+    void ReplaceQReg(const std::shared_ptr<QRegOperand> &from,
+                     const std::shared_ptr<QRegOperand> &to) override;
+
+  private:
+    std::shared_ptr<QRegOperand> Qd;
+    std::shared_ptr<QRegOperand> Qn;
+    std::shared_ptr<QRegOperand> Qm;
+};
+
+// vdup.32 Qd, Rm
+// @ note: every lane of Qd = Rm
+class InsVdup final : public Inst {
+  public:
+    static bool classof(const Inst *inst) { return inst->op == kInsVdup; }
+
+    InsVdup(std::shared_ptr<QRegOperand> Qd, std::shared_ptr<RegOperand> Rm)
+        : Inst(kInsVdup), Qd(std::move(Qd)), Rm(std::move(Rm)) {}
+
+    const std::shared_ptr<QRegOperand> &GetQd() const { return Qd; }
+    const std::shared_ptr<RegOperand> &GetRm() const { return Rm; }
+
+    void Emit(util::Emitter &emitter) const override;
+    std::vector<std::shared_ptr<RegOperand>> GetUseList() const override {
+        return {Rm};
+    }
+    void ReplaceReg(const std::shared_ptr<RegOperand> &from,
+                    const std::shared_ptr<RegOperand> &to) override;
+    std::vector<std::shared_ptr<QRegOperand>> GetQDefList() const override {
+        return {Qd};
+    }
+    void ReplaceQReg(const std::shared_ptr<QRegOperand> &from,
+                     const std::shared_ptr<QRegOperand> &to) override;
+
+  private:
+    std::shared_ptr<QRegOperand> Qd;
+    std::shared_ptr<RegOperand> Rm;
+};
+
+// vmov Qd, Qm
+class InsVmov final : public Inst {
+  public:
+    static bool classof(const Inst *inst) { return inst->op == kInsVmov; }
+
+    InsVmov(std::shared_ptr<QRegOperand> Qd, std::shared_ptr<QRegOperand> Qm)
+        : Inst(kInsVmov), Qd(std::move(Qd)), Qm(std::move(Qm)) {}
+
+    const std::shared_ptr<QRegOperand> &GetQd() const { return Qd; }
+    const std::shared_ptr<QRegOperand> &GetQm() const { return Qm; }
+
+    void Emit(util::Emitter &emitter) const override;
+    std::vector<std::shared_ptr<QRegOperand>> GetQDefList() const override {
+        return {Qd};
+    }
+    std::vector<std::shared_ptr<QRegOperand>> GetQUseList() const override {
+        return {Qm};
+    }
+    void ReplaceQReg(const std::shared_ptr<QRegOperand> &from,
+                     const std::shared_ptr<QRegOperand> &to) override;
+
+  private:
+    std::shared_ptr<QRegOperand> Qd;
+    std::shared_ptr<QRegOperand> Qm;
+};
+
+// vmov.32 Dd[x], Rm
+// @ note: lane of Qd = Rm, the other lanes are kept
+class InsVsetLane final : public Inst {
+  public:
+    static bool classof(const Inst *inst) { return inst->op == kInsVsetLane; }
+
+    InsVsetLane(std::shared_ptr<QRegOperand> Qd,
+                const int lane,
+                std::shared_ptr<RegOperand> Rm)
+        : Inst(kInsVsetLane), Qd(std::move(Qd)), lane(lane), Rm(std::move(Rm)) {
+        CheckLane();
+    }
+
+    const std::shared_ptr<QRegOperand> &GetQd() const { return Qd; }
+    int GetLane() const { return lane; }
+    const std::shared_ptr<RegOperand> &GetRm() const { return Rm; }
+
+    void Emit(util::Emitter &emitter) const override;
+    std::vector<std::shared_ptr<RegOperand>> GetUseList() const override {
+        return {Rm};
+    }
+    void ReplaceReg(const std::shared_ptr<RegOperand> &from,
+                    const std::shared_ptr<RegOperand> &to) override;
+    std::vector<std::shared_ptr<QRegOperand>> GetQDefList() const override {
+        return {Qd};
+    }
+    std::vector<std::shared_ptr<QRegOperand>> GetQUseList() const override {
+        return {Qd};
+    }
+    void ReplaceQReg(const std::shared_ptr<QRegOperand> &from,
+                     const std::shared_ptr<QRegOperand> &to) override;
+
+  private:
+    std::shared_ptr<QRegOperand> Qd;
+    const int lane;
+    std::shared_ptr<RegOperand> Rm;
+
+    void CheckLane() const;
+};
+
+// vmov.32 Rd, Dn[x]
+// @ note: Rd = lane of Qn
+class InsVgetLane final : public Inst {
+  public:
+    static bool classof(const Inst *inst) { return inst->op == kInsVgetLane; }
+
+    InsVgetLane(std::shared_ptr<RegOperand> Rd,
+                std::shared_ptr<QRegOperand> Qn,
+                const int lane)
+        : Inst(kInsVgetLane), Rd(std::move(Rd)), Qn(std::move(Qn)), lane(lane) {
+        CheckLane();
+    }
+
+    const std::shared_ptr<RegOperand> &GetRd() const { return Rd; }
+    const std::shared_ptr<QRegOperand> &GetQn() const { return Qn; }
+    int GetLane() const { return lane; }
+
+    void Emit(util::Emitter &emitter) const override;
+    std::vector<std::shared_ptr<RegOperand>> GetDefList() const override {
+        return {Rd};
+    }
+    void ReplaceReg(const std::shared_ptr<RegOperand> &from,
+                    const std::shared_ptr<RegOperand> &to) override;
+    std::vector<std::shared_ptr<QRegOperand>> GetQUseList() const override {
+        return {Qn};
+    }
+    void ReplaceQReg(const std::shared_ptr<QRegOperand> &from,
+                     const std::shared_ptr<QRegOperand> &to) override;
+
+  private:
+    std::shared_ptr<RegOperand> Rd;
+    std::shared_ptr<QRegOperand> Qn;
+    const int lane;
+
+    void CheckLane() const;
+};
+
 // nop{cond}    @ pseudo-instruction
 class InsNop final : public Inst {
   public:
+    static bool classof(const Inst *inst) { return inst->op == kInsNop; }
+
     explicit InsNop(const CondKind cond = kAL) : Inst(kInsNop, cond) {}
 
-    std::string Str() const override { return op_map[op] + cond_map[cond]; }
+    void Emit(util::Emitter &emitter) const override {
+        emitter << op_map[op] << cond_map[cond];
+    }
 };
 
 // label:
 class InsLabel final : public Inst {
   public:
+    static bool classof(const Inst *inst) { return inst->op == kInsLabel; }
+
     explicit InsLabel(const std::string &label)
         : Inst(kInsLabel, kAL), label(new LabelOperand(label)) {}
     explicit InsLabel(std::shared_ptr<LabelOperand> label)
         : Inst(kInsLabel, kAL), label(std::move(label)) {}
 
-    std::string Str() const override { return label->Str() + ':'; }
+    const std::shared_ptr<LabelOperand> &GetLabel() const { return label; }
+
+    // the times the block runs per call of its function, from the profile,
+    // or < 0 if unknown
+    double GetFrequency() const { return frequency; }
+    void SetFrequency(double frequency) { this->frequency = frequency; }
+
+    void Emit(util::Emitter &emitter) const override {
+        emitter << *label << ':';
+    }
 
   private:
     const std::shared_ptr<LabelOperand> label;
+    double frequency = -1;
+};
+
+// .ltorg      @ directive
+// @ note: dumps the pending literal pool here, must not be reached by the
+// @ control flow
+class InsLtorg final : public Inst {
+  public:
+    static bool classof(const Inst *inst) { return inst->op == kInsLtorg; }
+
+    InsLtorg() : Inst(kInsLtorg, kAL) {}
+
+    void Emit(util::Emitter &emitter) const override {
+        emitter << op_map[op];
+    }
 };
 
 class GlobalVar {
@@ -519,6 +1377,7 @@ class GlobalVar {
     const std::string &GetName() const { return name; }
 
     void Dump(std::ostream &os) const;
+    void Dump(util::Emitter &os) const;
 
   private:
     const std::string name;
@@ -527,49 +1386,102 @@ class GlobalVar {
 
 class Function {
   public:
+    // ldr rX, =<literal> reaches no more than 4KB away, measured in
+    // instructions with some room left for the pool itself
+    static constexpr int kPoolRange = 1000;
+
+    // instructions that address a stack object, see FrameInst()
+    enum FrameKind { kFrameLoad, kFrameStore, kFrameAddr };
+
     explicit Function(std::string name) : name(std::move(name)) {}
 
     const std::string &GetName() const { return name; }
 
     void AddInst(Inst *inst) { inst_list.emplace_back(inst); }
     void AddInst(std::shared_ptr<Inst> inst) { inst_list.emplace_back(inst); }
+    std::list<std::shared_ptr<Inst>> &GetInstList() { return inst_list; }
     const std::list<std::shared_ptr<Inst>> &GetInstList() const {
         return inst_list;
     }
 
-    void Dump(std::ostream &os) const;
-
-    // r0: ret value
-    // r1: binary op result
-    // r2: binary op lhs
-    // r3: binary op rhs
-    // r4: srem, ldr =#
-    // r5: ldr =label
-    // r6: ldr
-    // r7: ldr
-    // r8: str
-    // r9: getelementptr result
+    // Build value in reg with the cheapest of mov, mvn or movw(+movt), no
+    // memory access.
+    void LoadImm(const std::shared_ptr<RegOperand> &reg, std::int32_t value);
+    // Put a .ltorg after every kPoolRange instructions that use the literal
+    // pool, at a point the control flow never falls into. Return the number
+    // of pools.
+    int PlaceLiteralPool();
 
-    // "": available
-    std::array<std::string, 11> reg_state;
+    /* virtual registers */
 
-    // <0: in stack
-    // >=0: in reg
-    std::unordered_map<std::string, int> var_state;
+    std::shared_ptr<RegOperand> NewReg() {
+        return std::make_shared<RegOperand>(next_reg_id++);
+    }
+    // every virtual register id is below it
+    int GetRegNum() const { return next_reg_id; }
 
-    // <var_name, offset>
-    // offset begin from 1
-    std::unordered_map<std::string, unsigned int> stack_state;
+    std::shared_ptr<QRegOperand> NewQReg() {
+        return std::make_shared<QRegOperand>(next_qreg_id++);
+    }
+    // every virtual q register id is below it
+    int GetQRegNum() const { return next_qreg_id; }
+
+    /* stack frame */
+
+    // return the index of a new stack object of size bytes
+    int AddStackObject(int size);
+    // the index-th argument (counting from 0) of this function, passed on
+    // the stack since index >= 4
+    int AddIncomingArg(int index);
+    // reserve bytes at the bottom of the frame for the stack arguments of
+    // the calls made by this function
+    void ReserveCallArg(const int size) {
+        if (size > call_arg_size) call_arg_size = size;
+    }
 
-    // <ptr_name, offset>
-    std::unordered_map<std::string, unsigned int> ptr_state;
+    // ldr reg, <object + offset>
+    // str reg, <object + offset>
+    // add reg, sp, <object + offset>
+    // The offset from sp is unknown until the frame is laid out, so the
+    // instruction is a placeholder fixed by LowerFrame().
+    std::shared_ptr<Inst> FrameInst(FrameKind kind,
+                                    const std::shared_ptr<RegOperand> &reg,
+                                    int object,
+                                    int offset = 0);
+
+    // Lay out the stack frame after register allocation: push the used
+    // callee-saved registers (and lr when the function makes calls), fix the
+    // frame instructions, and add the epilogue before each bx lr. A leaf
+    // function with nothing to save and no stack object gets no frame.
+    void LowerFrame();
+    int GetFrameSize() const { return frame_size; }
 
-    void GetReg(int id);
+    void Dump(std::ostream &os) const;
+    void Dump(util::Emitter &os) const;
 
   private:
+    struct StackObject {
+        int size;
+        int offset;     // from sp after the prologue
+        int arg_index;  // >= 0 for incoming stack arguments
+    };
+    struct FrameRef {
+        FrameKind kind;
+        int object;
+        int offset;
+    };
+
     const std::string name;
 
     std::list<std::shared_ptr<Inst>> inst_list;
+
+    int next_reg_id = RegOperand::kCpsr + 1;
+    int next_qreg_id = QRegOperand::kPhysNum;
+
+    std::vector<StackObject> object_list;
+    std::unordered_map<const Inst *, FrameRef> frame_ref_map;
+    int call_arg_size = 0;
+    int frame_size = 0;
 };
 
 class Assembly {
@@ -594,7 +1506,12 @@ class Assembly {
         func_list.emplace_back(func);
     }
 
+    const std::vector<std::shared_ptr<Function>> &GetFuncList() const {
+        return func_list;
+    }
+
     void Dump(std::ostream &os) const;
+    void Dump(util::Emitter &os) const;
 
   private:
     std::unordered_map<std::string, std::shared_ptr<GlobalVar>> var_table;
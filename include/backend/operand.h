@@ -4,11 +4,13 @@
 #include <cstdint>
 #include <string>
 
+#include "casting.h"
+#include "emitter.h"
 namespace backend {
 
 class Operand {
   public:
-    enum OperandKind { kReg, kImm, kLabel };
+    enum OperandKind { kReg, kImm, kLabel, kQReg };
     const OperandKind kind;
 
     explicit Operand(const OperandKind kind) : kind(kind) {}
@@ -18,24 +20,66 @@ class Operand {
     Operand(Operand &&) = delete;
     Operand &operator=(Operand &&) = delete;
 
-    virtual std::string Str() const = 0;
+    std::string Str() const;
+    virtual void Emit(util::Emitter &emitter) const = 0;
+
+    static bool classof(const Operand *operand) { return true; }
 
     template <typename T>
     T &Cast() {
-        return dynamic_cast<T &>(*this);
+        return util::cast<T>(*this);
     }
 };
 
+inline util::Emitter &operator<<(util::Emitter &emitter,
+                                 const Operand &operand) {
+    operand.Emit(emitter);
+    return emitter;
+}
+
 class RegOperand final : public Operand {
   public:
+    static bool classof(const Operand *operand) {
+        return operand->kind == kReg;
+    }
+
     enum { kFp = 11, kIp, kSp, kLr, kPc, kCpsr };
 
     explicit RegOperand(const int id) : Operand(kReg), id(id) { CheckId(); }
 
+    int GetId() const { return id; }
+
     bool IsVirtual() const { return id > kCpsr; }
     bool IsSpecial() const { return id >= kFp && id <= kCpsr; }
 
-    std::string Str() const override;
+    void Emit(util::Emitter &emitter) const override;
+
+  private:
+    const int id;
+
+    void CheckId() const;
+};
+
+// a NEON quadword register, q0-q15 or a virtual one above, each holding
+// four i32 lanes
+class QRegOperand final : public Operand {
+  public:
+    static bool classof(const Operand *operand) {
+        return operand->kind == kQReg;
+    }
+
+    static constexpr int kPhysNum = 16;
+    static constexpr int kLaneNum = 4;
+
+    explicit QRegOperand(const int id) : Operand(kQReg), id(id) { CheckId(); }
+
+    int GetId() const { return id; }
+
+    bool IsVirtual() const { return id >= kPhysNum; }
+
+    void Emit(util::Emitter &emitter) const override { emitter << 'q' << id; }
+    // the doubleword register and index of the lane, as "d17[0]"
+    void EmitLane(util::Emitter &emitter, int lane) const;
 
   private:
     const int id;
@@ -45,39 +89,54 @@ class RegOperand final : public Operand {
 
 class ImmOperand final : public Operand {
   public:
+    static bool classof(const Operand *operand) {
+        return operand->kind == kImm;
+    }
+
     explicit ImmOperand(const std::int32_t value)
         : Operand(kImm)
         , value(value)
-        , isImm8m(CheckImm8m())
+        , isImm8m(CheckImm8m(value))
+        , isInvImm8m(CheckImm8m(~value))
         , isImm16(CheckImm16m()) {}
 
     int GetValue() const { return value; }
 
-    std::string Str() const override { return '#' + std::to_string(value); }
+    void Emit(util::Emitter &emitter) const override {
+        emitter << '#' << value;
+    }
 
     bool IsImm8m() const { return isImm8m; }
+    bool IsInvImm8m() const { return isInvImm8m; }
     bool IsImm16() const { return isImm16; }
+    // fits in the #<imm16> of movw/movt
+    bool IsUImm16() const { return 0 <= value && value <= 0xffff; }
 
   private:
     const std::int32_t value;
     // A kind of #<imm32> that can be generated through
     // "#<imm8> ror #<imm4>*2"
-    // TODO(neatlii): why ~(#<imm8> ror #<imm4>*2) can also pass
     const bool isImm8m;
+    // ~value is #<imm8m>, so it can be built by mvn
+    const bool isInvImm8m;
     const bool isImm16;
 
-    bool CheckImm8m() const;
+    static bool CheckImm8m(std::uint32_t n);
     bool CheckImm16m() const;
 };
 
 class LabelOperand final : public Operand {
   public:
+    static bool classof(const Operand *operand) {
+        return operand->kind == kLabel;
+    }
+
     explicit LabelOperand(std::string name)
         : Operand(kLabel), name(std::move(name)) {}
 
     const std::string &GetName() const { return name; }
 
-    std::string Str() const override { return name; }
+    void Emit(util::Emitter &emitter) const override { emitter << name; }
 
   private:
     const std::string name;
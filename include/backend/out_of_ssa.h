@@ -0,0 +1,32 @@
+#ifndef __sysycompiler_backend_out_of_ssa_h__
+#define __sysycompiler_backend_out_of_ssa_h__
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "backend/instruction.h"
+#include "backend/operand.h"
+#include "ir/ir.h"
+
+namespace backend {
+
+// Give each edge from a block with two successors into a block with phis a
+// block of its own, so that the copies of the phis can go right before an
+// unconditional branch. Return the number of edges split.
+int SplitPhiEdge(ir::FuncDef &func);
+
+// dst <- src for each pair, all read before any is written
+using ParallelCopy = std::vector<
+    std::pair<std::shared_ptr<RegOperand>, std::shared_ptr<RegOperand>>>;
+
+// Append the copies to func as a sequence of movs. A copy goes once no other
+// copy still reads its destination. When only cycles are left, one
+// destination is saved to a scratch register and its readers read that
+// instead, one scratch serves all the cycles. The movs are left for the
+// register allocator to coalesce.
+void SequentializeCopy(Function &func, ParallelCopy copy);
+
+}  // namespace backend
+
+#endif
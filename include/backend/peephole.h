@@ -0,0 +1,88 @@
+#ifndef __sysycompiler_backend_peephole_h__
+#define __sysycompiler_backend_peephole_h__
+
+#include <list>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "backend/instruction.h"
+
+namespace backend {
+
+// Runs pattern rules over the instruction list of a function until no rule
+// fires any more. Each rule only looks at a small window of instructions
+// starting from the current one.
+class Peephole {
+  public:
+    using InstList = std::list<std::shared_ptr<Inst>>;
+    // Try to rewrite the instructions from iter on, looking at no more than
+    // window instructions. On success iter must be left valid (or end), it is
+    // where the scan goes on.
+    using Matcher = bool (*)(InstList &inst_list,
+                             InstList::iterator &iter,
+                             int window);
+
+    struct Rule {
+        std::string name;
+        int window;
+        Matcher matcher;
+        int count;  // times the rule fired
+    };
+
+    // with the default rule set
+    Peephole();
+
+    void AddRule(const std::string &name, int window, Matcher matcher);
+    const std::vector<Rule> &GetRuleList() const { return rule_list; }
+
+    // return the number of rewrites
+    int Run(Function &func);
+
+    int GetCount(const std::string &name) const;
+    void ClearStatistic();
+    void DumpStatistic(std::ostream &os) const;
+
+  private:
+    std::vector<Rule> rule_list;
+};
+
+/* default rules */
+
+// mov rX, rX
+bool RedundantMov(Peephole::InstList &inst_list,
+                  Peephole::InstList::iterator &iter,
+                  int window);
+// str rX, [rB, #o]; ldr rY, [rB, #o]
+bool StoreLoad(Peephole::InstList &inst_list,
+               Peephole::InstList::iterator &iter,
+               int window);
+// ldr rX, =label; ...; ldr rX, =label
+bool RedundantLabelLoad(Peephole::InstList &inst_list,
+                        Peephole::InstList::iterator &iter,
+                        int window);
+// b label; label:
+bool BranchToNext(Peephole::InstList &inst_list,
+                  Peephole::InstList::iterator &iter,
+                  int window);
+// b<cond> label1; b label2; label1:
+bool InvertBranch(Peephole::InstList &inst_list,
+                  Peephole::InstList::iterator &iter,
+                  int window);
+// add/sub rX, rX, #0
+bool ZeroAddSub(Peephole::InstList &inst_list,
+                Peephole::InstList::iterator &iter,
+                int window);
+// b<cond> L; <then>; L:
+// b<cond> L1; <then>; b L2; L1: <else>; L2:
+// the arms are executed conditionally instead, when each of them is no
+// longer than kMaxPredicated
+bool Predicate(Peephole::InstList &inst_list,
+               Peephole::InstList::iterator &iter,
+               int window);
+constexpr int kMaxPredicated = 4;
+
+}  // namespace backend
+
+#endif
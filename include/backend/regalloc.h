@@ -0,0 +1,127 @@
+#ifndef __sysycompiler_backend_regalloc_h__
+#define __sysycompiler_backend_regalloc_h__
+
+#include <memory>
+#include <unordered_set>
+#include <vector>
+
+#include "backend/instruction.h"
+#include "backend/operand.h"
+
+namespace backend {
+
+// Live ranges of the registers of a function. The instruction at index i
+// reads its operands at slot 2i and writes its results at slot 2i+1, a range
+// is a sorted list of disjoint [begin, end) slot segments.
+class Liveness {
+  public:
+    struct Segment {
+        int begin;
+        int end;
+    };
+    using Range = std::vector<Segment>;
+    // the core registers, or the NEON q registers
+    enum RegClass { kCore, kQ };
+
+    explicit Liveness(const Function &func, RegClass reg_class = kCore);
+
+    // r0-r11 and the virtual registers, ip, sp, lr and pc are left alone;
+    // every q register is tracked
+    static bool IsTracked(const int id) {
+        return id < RegOperand::kIp || id > RegOperand::kCpsr;
+    }
+
+    const std::vector<std::shared_ptr<Inst>> &GetInstList() const {
+        return inst_list;
+    }
+    const Range &GetRange(const int id) const { return range_list[id]; }
+    // times the register is read or written
+    int GetRefCount(const int id) const { return ref_count[id]; }
+
+  private:
+    std::vector<std::shared_ptr<Inst>> inst_list;
+    std::vector<Range> range_list;
+    std::vector<int> ref_count;
+};
+
+// Map the virtual registers of a function to r0-r11. ip stays free as the
+// scratch register of the frame code, lr is never allocated.
+class RegAlloc {
+  public:
+    static constexpr int kRegNum = RegOperand::kIp;
+
+    RegAlloc() = default;
+    virtual ~RegAlloc() = default;
+    RegAlloc(const RegAlloc &) = delete;
+    RegAlloc &operator=(const RegAlloc &) = delete;
+    RegAlloc(RegAlloc &&) = delete;
+    RegAlloc &operator=(RegAlloc &&) = delete;
+
+    virtual void Run(Function &func) = 0;
+
+    // virtual registers sent to the stack so far
+    int GetSpillCount() const { return spill_count; }
+    void ClearStatistic() { spill_count = 0; }
+
+  protected:
+    // Give each spilled register a stack slot, and each instruction that
+    // touches it a new register loaded before and stored after it. The new
+    // registers go to no_spill.
+    void Spill(Function &func,
+               const std::vector<int> &spill_list,
+               std::unordered_set<int> &no_spill);
+    // rewrite the virtual registers, assign_list maps register id to r0-r11
+    static void Assign(Function &func, const std::vector<int> &assign_list);
+    // the allocation of GreedyRegAlloc, no_spill as in Spill
+    void RunGreedy(Function &func, std::unordered_set<int> &no_spill);
+
+  private:
+    int spill_count = 0;
+};
+
+// Live ranges go by spill weight, each takes the first register that is free
+// over the whole range. The ones left are spilled and the allocation starts
+// over.
+class GreedyRegAlloc final : public RegAlloc {
+  public:
+    void Run(Function &func) override;
+};
+
+// Chaitin-Briggs coloring with iterated coalescing (George and Appel). The
+// interference graph is a bit matrix for the membership test plus adjacency
+// vectors for the walks. Moves between registers are coalesced when the
+// Briggs or George test says the result still colors, and a spill candidate
+// has the least cost per degree, each reference costing 10^(loop depth).
+// Slower than the greedy allocator, meant for optimized builds. A function
+// with more than kMaxRegNum registers goes to the greedy allocator, its bit
+// matrix would take over 16 MB.
+class ColoringRegAlloc final : public RegAlloc {
+  public:
+    static constexpr int kMaxRegNum = 1 << 14;
+
+    void Run(Function &func) override;
+
+    // moves removed by coalescing so far
+    int GetCoalesceCount() const { return coalesce_count; }
+    void ClearStatistic() {
+        RegAlloc::ClearStatistic();
+        coalesce_count = 0;
+    }
+
+  private:
+    int coalesce_count = 0;
+};
+
+// Map the virtual q registers of a function to q8-q15 and then q0-q3, which
+// the callers save, so the frame keeps none. Live ranges go by where they
+// start, each takes the register of a vmov partner if it is free, else the
+// first free one. Nothing is spilled: the vectorizers keep few vectors live,
+// and running out throws.
+class QRegAlloc {
+  public:
+    void Run(Function &func);
+};
+
+}  // namespace backend
+
+#endif
@@ -0,0 +1,50 @@
+#ifndef __sysycompiler_casting_h__
+#define __sysycompiler_casting_h__
+
+#include <cassert>
+
+namespace util {
+
+// Casts down a class hierarchy whose base carries a kind tag, in the way of
+// llvm/Support/Casting.h. Every class T in the hierarchy declares
+//     static bool classof(const Base *base);
+// which tells by the kind whether base is a T, so a checked cast is a compare
+// and a static_cast, RTTI is not involved.
+
+template <typename To, typename From>
+bool isa(const From &from) {
+    return To::classof(&from);
+}
+
+template <typename To, typename From>
+bool isa(From *from) {
+    return from != nullptr && To::classof(from);
+}
+
+// from must be a To
+template <typename To, typename From>
+To &cast(From &from) {
+    assert(isa<To>(from) && "cast to an incompatible kind");
+    return static_cast<To &>(from);
+}
+
+template <typename To, typename From>
+const To &cast(const From &from) {
+    assert(isa<To>(from) && "cast to an incompatible kind");
+    return static_cast<const To &>(from);
+}
+
+// nullptr if from is not a To
+template <typename To, typename From>
+To *dyn_cast(From *from) {
+    return isa<To>(from) ? static_cast<To *>(from) : nullptr;
+}
+
+template <typename To, typename From>
+const To *dyn_cast(const From *from) {
+    return isa<To>(from) ? static_cast<const To *>(from) : nullptr;
+}
+
+}  // namespace util
+
+#endif  // __sysycompiler_casting_h__
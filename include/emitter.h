@@ -0,0 +1,107 @@
+#ifndef __sysycompiler_emitter_h__
+#define __sysycompiler_emitter_h__
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+#include "util.h"
+
+namespace util {
+
+// text in the colors of FormatTerminal, for an emitter
+struct Colored {
+    std::string_view text;
+    ForegroundColor fg_color;
+    bool bold = false;
+    bool underline = false;
+};
+
+// A buffered text writer for the dumps. Everything goes into one large
+// buffer which is handed to the file descriptor or ostream when it fills up
+// and on Flush, integers are formatted in place, so writing a line costs no
+// allocation. An emitter on a string appends to it directly.
+class Emitter {
+  public:
+    static constexpr std::size_t kBufferSize = 1 << 16;
+
+    explicit Emitter(int fd);
+    explicit Emitter(std::ostream &ostream);
+    explicit Emitter(std::string &str) : str(&str) {}
+
+    ~Emitter() { Flush(); }
+    Emitter(const Emitter &) = delete;
+    Emitter &operator=(const Emitter &) = delete;
+    Emitter(Emitter &&) = delete;
+    Emitter &operator=(Emitter &&) = delete;
+
+    // Colored text is written plain when color is off
+    bool IsColor() const { return color; }
+    void SetColor(const bool color) { this->color = color; }
+
+    void Write(const char *data, std::size_t size);
+    void Flush();
+    // false once a write to the fd or ostream failed
+    bool Good() const { return good; }
+
+    Emitter &operator<<(const char c) {
+        if (str != nullptr) {
+            str->push_back(c);
+        } else {
+            if (size == kBufferSize) Flush();
+            buffer[size++] = c;
+        }
+        return *this;
+    }
+    Emitter &operator<<(const std::string_view text) {
+        Write(text.data(), text.size());
+        return *this;
+    }
+    Emitter &operator<<(const char *text) {
+        return *this << std::string_view(text);
+    }
+    Emitter &operator<<(const std::string &text) {
+        return *this << std::string_view(text);
+    }
+    Emitter &operator<<(const int value) { return Int(value); }
+    Emitter &operator<<(const long value) { return Int(value); }
+    Emitter &operator<<(const long long value) { return Int(value); }
+    Emitter &operator<<(const unsigned value) { return UInt(value); }
+    Emitter &operator<<(const unsigned long value) { return UInt(value); }
+    Emitter &operator<<(const unsigned long long value) { return UInt(value); }
+    Emitter &operator<<(const Colored &colored);
+
+    // what is written in between is in the color, as by Colored
+    void BeginColor(ForegroundColor fg_color,
+                    bool bold = false,
+                    bool underline = false);
+    void EndColor() {
+        if (color) *this << "\e[0m";
+    }
+
+  private:
+    int fd = -1;
+    std::ostream *ostream = nullptr;
+    std::string *str = nullptr;
+    std::unique_ptr<char[]> buffer;
+    std::size_t size = 0;
+    bool color = true;
+    bool good = true;
+
+    // write to the fd or ostream past the buffer
+    void Sink(const char *data, std::size_t size);
+    Emitter &Int(long long value);
+    Emitter &UInt(unsigned long long value);
+};
+
+// Write the decimal digits of value at first, return the end of them. first
+// must have room for 20 chars.
+char *FormatInt(char *first, long long value);
+char *FormatUInt(char *first, unsigned long long value);
+
+}  // namespace util
+
+#endif  // __sysycompiler_emitter_h__
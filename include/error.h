@@ -84,4 +84,16 @@ class InvalidValueTypeException : public std::runtime_error {
         , need(need) {}
 };
 
+class RuntimeErrorException : public std::runtime_error {
+  public:
+    const std::string func;
+
+    RuntimeErrorException(const std::string &func, const std::string &msg)
+        : std::runtime_error("in function '" + func + "', " + msg)
+        , func(func) {}
+    // an error before any function runs
+    explicit RuntimeErrorException(const std::string &msg)
+        : std::runtime_error(msg) {}
+};
+
 #endif
@@ -5,6 +5,8 @@
 #include <unordered_map>
 #include <vector>
 
+#include "casting.h"
+#include "emitter.h"
 #include "frontend/source_manager.h"
 
 namespace ast {
@@ -70,6 +72,7 @@ class ASTManager {
     Expr &GetExpr(ASTLocation loc) const;
 
     void Dump(std::ostream &ostream) const;
+    void Dump(util::Emitter &emitter) const;
 
   private:
     SourceManager &raw;
@@ -101,7 +104,7 @@ class IdentTable {
         return ident_table.size();
     }
 
-    void DumpIdentTable(std::ostream &ostream) const;
+    void DumpIdentTable(util::Emitter &emitter) const;
 
   protected:
     std::unordered_map<std::string, ASTLocation> ident_table;
@@ -167,9 +170,12 @@ class ASTNode : public IdentTable {
     bool IsStmt() const { return kStmt <= kind && kind <= kInitListExpr; }
     bool IsExpr() const { return kExpr <= kind && kind <= kInitListExpr; }
 
+    static bool classof(const ASTNode *node) { return true; }
+
+    // the node at location, which is this one once it is added
     template <typename T>
     T &Cast() const {
-        return dynamic_cast<T &>(src.GetNode(location));
+        return util::cast<T>(src.GetNode(location));
     }
 
     ASTManager &GetASTManager() const { return src; }
@@ -199,7 +205,7 @@ class ASTNode : public IdentTable {
     virtual void Visit() = 0;
 
     // ast-dump
-    virtual void Dump(std::ostream &ostream,
+    virtual void Dump(util::Emitter &emitter,
                       const std::string &indent,
                       bool is_last) const = 0;
 
@@ -212,14 +218,18 @@ class ASTNode : public IdentTable {
     bool has_parent;
     ASTLocation parent;
 
-    static void DumpIndentAndBranch(std::ostream &ostream,
+    static void DumpIndentAndBranch(util::Emitter &emitter,
                                     const std::string &indent,
                                     bool is_last);
-    void DumpInfo(std::ostream &ostream, const std::string &kind) const;
+    void DumpInfo(util::Emitter &emitter, const std::string &kind) const;
 };
 
 class TranslationUnit final : public ASTNode {
   public:
+    static bool classof(const ASTNode *node) {
+        return node->kind == kTranslationUnit;
+    }
+
     explicit TranslationUnit(ASTManager &src) : ASTNode(kTranslationUnit, src) {
         BuiltIn();
     }
@@ -238,7 +248,7 @@ class TranslationUnit final : public ASTNode {
 
     void Visit() override;
 
-    void Dump(std::ostream &ostream,
+    void Dump(util::Emitter &emitter,
               const std::string &indent,
               bool is_last) const override;
 
@@ -250,6 +260,10 @@ class TranslationUnit final : public ASTNode {
 
 class Decl : public ASTNode {
   public:
+    static bool classof(const ASTNode *node) {
+        return kDecl <= node->kind && node->kind <= kFunctionDecl;
+    }
+
     enum Type { kUndef, kVoid, kInt };
 
     Decl(const ASTNodeKind kind,
@@ -282,6 +296,8 @@ class Decl : public ASTNode {
 
 class VarDecl final : public Decl {
   public:
+    static bool classof(const ASTNode *node) { return node->kind == kVarDecl; }
+
     VarDecl(ASTManager &src,
             const SourceRange &range,
             const TokenLocation ident,
@@ -332,7 +348,7 @@ class VarDecl final : public Decl {
 
     void Visit() override;
 
-    void Dump(std::ostream &ostream,
+    void Dump(util::Emitter &emitter,
               const std::string &indent,
               bool is_last) const override;
 
@@ -346,6 +362,10 @@ class VarDecl final : public Decl {
 
 class ParamVarDecl final : public Decl {
   public:
+    static bool classof(const ASTNode *node) {
+        return node->kind == kParamVarDecl;
+    }
+
     ParamVarDecl(ASTManager &src,
                  const SourceRange &range,
                  const TokenLocation ident,
@@ -375,7 +395,7 @@ class ParamVarDecl final : public Decl {
 
     void Visit() override;
 
-    void Dump(std::ostream &ostream,
+    void Dump(util::Emitter &emitter,
               const std::string &indent,
               bool is_last) const override;
 
@@ -386,6 +406,10 @@ class ParamVarDecl final : public Decl {
 
 class FunctionDecl final : public Decl {
   public:
+    static bool classof(const ASTNode *node) {
+        return node->kind == kFunctionDecl;
+    }
+
     FunctionDecl(ASTManager &src,
                  const SourceRange &range,
                  const TokenLocation ident,
@@ -426,7 +450,7 @@ class FunctionDecl final : public Decl {
 
     void Visit() override;
 
-    void Dump(std::ostream &ostream,
+    void Dump(util::Emitter &emitter,
               const std::string &indent,
               bool is_last) const override;
 
@@ -438,12 +462,20 @@ class FunctionDecl final : public Decl {
 
 class Stmt : public ASTNode {
   public:
+    static bool classof(const ASTNode *node) {
+        return kStmt <= node->kind && node->kind <= kInitListExpr;
+    }
+
     Stmt(const ASTNodeKind kind, ASTManager &src, const SourceRange &range)
         : ASTNode(kind, src, range) {}
 };
 
 class CompoundStmt final : public Stmt {
   public:
+    static bool classof(const ASTNode *node) {
+        return node->kind == kCompoundStmt;
+    }
+
     CompoundStmt(ASTManager &src,
                  const SourceRange &range,
                  std::vector<ASTLocation> stmt_list = {})
@@ -461,7 +493,7 @@ class CompoundStmt final : public Stmt {
 
     void Visit() override;
 
-    void Dump(std::ostream &ostream,
+    void Dump(util::Emitter &emitter,
               const std::string &indent,
               bool is_last) const override;
 
@@ -471,6 +503,8 @@ class CompoundStmt final : public Stmt {
 
 class DeclStmt final : public Stmt {
   public:
+    static bool classof(const ASTNode *node) { return node->kind == kDeclStmt; }
+
     DeclStmt(ASTManager &src,
              const SourceRange &range,
              std::vector<ASTLocation> decl_list)
@@ -489,7 +523,7 @@ class DeclStmt final : public Stmt {
 
     void Visit() override;
 
-    void Dump(std::ostream &ostream,
+    void Dump(util::Emitter &emitter,
               const std::string &indent,
               bool is_last) const override;
 
@@ -499,6 +533,8 @@ class DeclStmt final : public Stmt {
 
 class NullStmt final : public Stmt {
   public:
+    static bool classof(const ASTNode *node) { return node->kind == kNullStmt; }
+
     explicit NullStmt(ASTManager &src, const SourceRange &range)
         : Stmt(kNullStmt, src, range) {}
 
@@ -506,13 +542,15 @@ class NullStmt final : public Stmt {
 
     void Visit() override {}
 
-    void Dump(std::ostream &ostream,
+    void Dump(util::Emitter &emitter,
               const std::string &indent,
               bool is_last) const override;
 };
 
 class IfStmt final : public Stmt {
   public:
+    static bool classof(const ASTNode *node) { return node->kind == kIfStmt; }
+
     IfStmt(ASTManager &src,
            const SourceRange &range,
            const ASTLocation cond,
@@ -548,7 +586,7 @@ class IfStmt final : public Stmt {
 
     void Visit() override;
 
-    void Dump(std::ostream &ostream,
+    void Dump(util::Emitter &emitter,
               const std::string &indent,
               bool is_last) const override;
 
@@ -561,6 +599,10 @@ class IfStmt final : public Stmt {
 
 class WhileStmt final : public Stmt {
   public:
+    static bool classof(const ASTNode *node) {
+        return node->kind == kWhileStmt;
+    }
+
     WhileStmt(ASTManager &src,
               const SourceRange &range,
               const ASTLocation cond,
@@ -577,7 +619,7 @@ class WhileStmt final : public Stmt {
 
     void Visit() override;
 
-    void Dump(std::ostream &ostream,
+    void Dump(util::Emitter &emitter,
               const std::string &indent,
               bool is_last) const override;
 
@@ -588,6 +630,10 @@ class WhileStmt final : public Stmt {
 
 class ContinueStmt final : public Stmt {
   public:
+    static bool classof(const ASTNode *node) {
+        return node->kind == kContinueStmt;
+    }
+
     explicit ContinueStmt(ASTManager &src, const SourceRange &range)
         : Stmt(kContinueStmt, src, range) {}
 
@@ -595,13 +641,17 @@ class ContinueStmt final : public Stmt {
 
     void Visit() override {}
 
-    void Dump(std::ostream &ostream,
+    void Dump(util::Emitter &emitter,
               const std::string &indent,
               bool is_last) const override;
 };
 
 class BreakStmt final : public Stmt {
   public:
+    static bool classof(const ASTNode *node) {
+        return node->kind == kBreakStmt;
+    }
+
     explicit BreakStmt(ASTManager &src, const SourceRange &range)
         : Stmt(kBreakStmt, src, range) {}
 
@@ -609,13 +659,17 @@ class BreakStmt final : public Stmt {
 
     void Visit() override {}
 
-    void Dump(std::ostream &ostream,
+    void Dump(util::Emitter &emitter,
               const std::string &indent,
               bool is_last) const override;
 };
 
 class ReturnStmt final : public Stmt {
   public:
+    static bool classof(const ASTNode *node) {
+        return node->kind == kReturnStmt;
+    }
+
     ReturnStmt(ASTManager &src, const SourceRange &range)
         : Stmt(kReturnStmt, src, range), has_expr(false), expr(0) {}
     ReturnStmt(ASTManager &src,
@@ -632,7 +686,7 @@ class ReturnStmt final : public Stmt {
 
     void Visit() override;
 
-    void Dump(std::ostream &ostream,
+    void Dump(util::Emitter &emitter,
               const std::string &indent,
               bool is_last) const override;
 
@@ -643,6 +697,10 @@ class ReturnStmt final : public Stmt {
 
 class Expr : public Stmt {
   public:
+    static bool classof(const ASTNode *node) {
+        return kExpr <= node->kind && node->kind <= kInitListExpr;
+    }
+
     Expr(const ASTNodeKind kind, ASTManager &src, const SourceRange &range)
         : Stmt(kind, src, range), is_const(false), value(0) {}
     Expr(const ASTNodeKind kind,
@@ -663,11 +721,15 @@ class Expr : public Stmt {
     bool is_const;
     int value;
 
-    void DumpConstExpr(std::ostream &ostream) const;
+    void DumpConstExpr(util::Emitter &emitter) const;
 };
 
 class IntegerLiteral final : public Expr {
   public:
+    static bool classof(const ASTNode *node) {
+        return node->kind == kIntegerLiteral;
+    }
+
     IntegerLiteral(ASTManager &src,
                    const SourceRange &range,
                    const int value,
@@ -678,7 +740,7 @@ class IntegerLiteral final : public Expr {
 
     void Visit() override {}
 
-    void Dump(std::ostream &ostream,
+    void Dump(util::Emitter &emitter,
               const std::string &indent,
               bool is_last) const override;
 
@@ -688,6 +750,10 @@ class IntegerLiteral final : public Expr {
 
 class ParenExpr final : public Expr {
   public:
+    static bool classof(const ASTNode *node) {
+        return node->kind == kParenExpr;
+    }
+
     ParenExpr(ASTManager &src,
               const SourceRange &range,
               const ASTLocation sub_expr)
@@ -700,7 +766,7 @@ class ParenExpr final : public Expr {
 
     void Visit() override;
 
-    void Dump(std::ostream &ostream,
+    void Dump(util::Emitter &emitter,
               const std::string &indent,
               bool is_last) const override;
 
@@ -710,6 +776,10 @@ class ParenExpr final : public Expr {
 
 class DeclRefExpr final : public Expr {
   public:
+    static bool classof(const ASTNode *node) {
+        return node->kind == kDeclRefExpr;
+    }
+
     DeclRefExpr(ASTManager &src,
                 const SourceRange &range,
                 const TokenLocation ident,
@@ -756,7 +826,7 @@ class DeclRefExpr final : public Expr {
 
     void Visit() override;
 
-    void Dump(std::ostream &ostream,
+    void Dump(util::Emitter &emitter,
               const std::string &indent,
               bool is_last) const override;
 
@@ -773,6 +843,8 @@ class DeclRefExpr final : public Expr {
 
 class CallExpr final : public Expr {
   public:
+    static bool classof(const ASTNode *node) { return node->kind == kCallExpr; }
+
     CallExpr(ASTManager &src,
              const SourceRange &range,
              const TokenLocation ident,
@@ -806,7 +878,7 @@ class CallExpr final : public Expr {
 
     bool HasRef() const { return has_ref; }
     const FunctionDecl &GetRef() const {
-        return src.GetNode(ref).Cast<const FunctionDecl &>();
+        return src.GetNode(ref).Cast<FunctionDecl>();
     }
 
     std::string TypeStr() const;
@@ -815,7 +887,7 @@ class CallExpr final : public Expr {
 
     void Visit() override;
 
-    void Dump(std::ostream &ostream,
+    void Dump(util::Emitter &emitter,
               const std::string &indent,
               bool is_last) const override;
 
@@ -831,6 +903,10 @@ class CallExpr final : public Expr {
 
 class BinaryOperator final : public Expr {
   public:
+    static bool classof(const ASTNode *node) {
+        return node->kind == kBinaryOperator;
+    }
+
     enum BinaryOpKind {
         kAdd,
         kSub,
@@ -874,7 +950,7 @@ class BinaryOperator final : public Expr {
 
     void Visit() override;
 
-    void Dump(std::ostream &ostream,
+    void Dump(util::Emitter &emitter,
               const std::string &indent,
               bool is_last) const override;
 
@@ -888,6 +964,10 @@ class BinaryOperator final : public Expr {
 
 class UnaryOperator final : public Expr {
   public:
+    static bool classof(const ASTNode *node) {
+        return node->kind == kUnaryOperator;
+    }
+
     enum UnaryOpKind { kPlus, kMinus, kNot };
     const UnaryOpKind op_code;
 
@@ -908,7 +988,7 @@ class UnaryOperator final : public Expr {
 
     void Visit() override;
 
-    void Dump(std::ostream &ostream,
+    void Dump(util::Emitter &emitter,
               const std::string &indent,
               bool is_last) const override;
 
@@ -921,6 +1001,10 @@ class UnaryOperator final : public Expr {
 
 class InitListExpr final : public Expr {
   public:
+    static bool classof(const ASTNode *node) {
+        return node->kind == kInitListExpr;
+    }
+
     InitListExpr(ASTManager &src,
                  const SourceRange &range,
                  std::vector<ASTLocation> init_list = {},
@@ -955,7 +1039,7 @@ class InitListExpr final : public Expr {
 
     void Visit() override;
 
-    void Dump(std::ostream &ostream,
+    void Dump(util::Emitter &emitter,
               const std::string &indent,
               bool is_last) const override;
 
@@ -1,9 +1,12 @@
 #ifndef __sysycompiler_frontend_source_manager_h__
 #define __sysycompiler_frontend_source_manager_h__
 
+#include <ostream>
 #include <string>
 #include <vector>
 
+#include "emitter.h"
+
 namespace ast {
 
 /* definitions */
@@ -18,6 +21,8 @@ struct SourceRange {
     std::string DumpBegin() const;
     std::string DumpEnd() const;
     std::string Dump() const;
+    void DumpBegin(util::Emitter &emitter) const;
+    void DumpEnd(util::Emitter &emitter) const;
 };
 
 struct Token {
@@ -28,9 +33,9 @@ struct Token {
         : text(std::move(text)), range(range) {}
 
     // colorful
-    std::string DumpText() const;
-    std::string DumpTextRef() const;
-    std::string DumpRange() const;
+    void DumpText(util::Emitter &emitter) const;
+    void DumpTextRef(util::Emitter &emitter) const;
+    void DumpRange(util::Emitter &emitter) const;
 };
 
 // index in token table
@@ -62,6 +67,7 @@ class SourceManager final {
     }
 
     void Dump(std::ostream &ostream) const;
+    void Dump(util::Emitter &emitter) const;
 
   private:
     std::string file_name;
@@ -0,0 +1,77 @@
+#ifndef __sysycompiler_ir_arena_h__
+#define __sysycompiler_ir_arena_h__
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace ir {
+
+// Bump allocation out of large chunks that are only freed all at once when
+// the arena goes away. Whatever lives in the arena must be gone by then, the
+// destructor asserts that every ArenaAllocator allocation was given back.
+class Arena {
+  public:
+    Arena() = default;
+    Arena(const Arena &) = delete;
+    Arena &operator=(const Arena &) = delete;
+    ~Arena();
+
+    void *Allocate(std::size_t size, std::size_t align);
+
+    // the bytes taken from the system so far
+    std::size_t GetCapacity() const { return capacity; }
+    // the ArenaAllocator allocations not given back yet
+    std::size_t GetLiveNum() const { return live_num; }
+
+  private:
+    template <typename T>
+    friend class ArenaAllocator;
+
+    static constexpr std::size_t kChunkSize = 64 * 1024;
+
+    std::vector<std::unique_ptr<char[]>> chunk_list;
+    char *cur = nullptr;
+    char *end = nullptr;
+    std::size_t capacity = 0;
+    std::size_t live_num = 0;
+};
+
+// An allocator over an arena for allocate_shared and the containers, frees
+// only count what is still live.
+template <typename T>
+class ArenaAllocator {
+  public:
+    using value_type = T;
+
+    explicit ArenaAllocator(Arena *arena) : arena(arena) {}
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U> &other) : arena(other.arena) {}
+
+    T *allocate(const std::size_t n) {
+        auto *ptr =
+            static_cast<T *>(arena->Allocate(n * sizeof(T), alignof(T)));
+        ++arena->live_num;
+        return ptr;
+    }
+    void deallocate(T *, std::size_t) { --arena->live_num; }
+
+    template <typename U>
+    bool operator==(const ArenaAllocator<U> &other) const {
+        return arena == other.arena;
+    }
+    template <typename U>
+    bool operator!=(const ArenaAllocator<U> &other) const {
+        return arena != other.arena;
+    }
+
+  private:
+    template <typename U>
+    friend class ArenaAllocator;
+
+    Arena *arena;
+};
+
+}  // namespace ir
+
+#endif
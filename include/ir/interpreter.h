@@ -0,0 +1,146 @@
+#ifndef __sysycompiler_ir_interpreter_h__
+#define __sysycompiler_ir_interpreter_h__
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "emitter.h"
+#include "ir/ir.h"
+
+namespace ir {
+
+// Runs main of a module, with the sylib functions built in: they read input
+// and write output the way sylib does, so what a program prints can be
+// diffed against testcase/*/out. Memory is an array of i32 words, a pointer
+// is the index of a word. Every block and instruction executed is counted.
+//
+// The module is decoded once up front: values become register numbers or
+// constants, allocas get fixed offsets in the frame and phis become copies
+// on the edges into their block. A vector takes a register for each lane and
+// an instruction on it a code for each lane.
+class Interpreter {
+  public:
+    // the most words the globals and the stack may take
+    static constexpr std::int32_t kMaxMemory = 1 << 29;
+    // memory is allocated a page of words at a time on first access
+    static constexpr int kPageBits = 16;
+
+    Interpreter(const Module &module,
+                std::istream &input,
+                util::Emitter &output);
+    Interpreter(const Interpreter &) = delete;
+    Interpreter &operator=(const Interpreter &) = delete;
+
+    // run main, return its return value, throw RuntimeErrorException on an
+    // out of bounds access, a division by zero or a stack overflow
+    int Run();
+
+    // the number of instructions executed, phis included
+    std::uint64_t GetInstCount() const;
+    // the number of instructions executed by opcode, as "add" or "icmp"
+    std::map<std::string, std::uint64_t> GetOpCount() const;
+    // the times the block of label in func was entered
+    std::uint64_t GetBlockCount(const std::string &func,
+                                const std::string &label) const;
+
+    // the counts by opcode, then by block for each function that ran
+    void DumpProfile(util::Emitter &emitter) const;
+    // what the sylib destructor prints for _sysy_starttime/_sysy_stoptime
+    void DumpTimer(util::Emitter &emitter) const;
+
+  private:
+    // a register of the frame or a constant
+    struct Operand {
+        bool is_reg = false;
+        std::int32_t value = 0;
+    };
+
+    // the phis of a block read on the edge from one predecessor
+    struct Edge {
+        int block = 0;
+        std::vector<std::pair<int, Operand>> copy_list;
+    };
+
+    struct GEP {
+        std::int32_t offset = 0;
+        // index and the words it steps over
+        std::vector<std::pair<Operand, std::int32_t>> idx_list;
+    };
+
+    struct Call {
+        // a function of func_list, or < 0 for a builtin
+        int func = 0;
+        std::vector<Operand> arg_list;
+    };
+
+    // a decoded instruction, the meaning of the fields follows the kind
+    struct Code {
+        Inst::InstKind kind;
+        int op_code = 0;
+        int result = 0;
+        Operand a, b, c;
+        // into edge_list, gep_list or call_list
+        int index = 0;
+    };
+
+    struct Block {
+        const BasicBlock *bb = nullptr;
+        std::vector<Code> code_list;
+        std::uint64_t count = 0;
+    };
+
+    struct Function {
+        const FuncDef *def = nullptr;
+        std::vector<Block> block_list;
+        int reg_num = 0;
+        std::int32_t frame_size = 0;
+        std::vector<Edge> edge_list;
+        std::vector<GEP> gep_list;
+        std::vector<Call> call_list;
+    };
+
+    struct Timer {
+        int begin_line = 0;
+        int end_line = 0;
+        std::int64_t us = 0;
+    };
+
+    std::istream &input;
+    util::Emitter &output;
+
+    std::vector<Function> func_list;
+    std::unordered_map<std::string, int> func_map;
+    std::unordered_map<std::string, std::int32_t> global_map;
+
+    std::vector<std::unique_ptr<std::int32_t[]>> page_list;
+    std::int32_t stack_top = 0;
+    std::vector<std::int32_t> reg_stack;
+    std::size_t reg_top = 0;
+    // the values of the phis on an edge before they are written
+    std::vector<std::int32_t> copy_buffer;
+    // the name of the function running
+    const std::string *current = nullptr;
+
+    std::vector<Timer> timer_list;
+    std::chrono::steady_clock::time_point timer_begin;
+
+    void LayoutGlobal(const GlobalVarDef &var);
+    void Decode(Function &func);
+
+    // run the function with its args at reg_top
+    int Execute(int func_index);
+    int CallBuiltin(int builtin, const std::int32_t *arg_list);
+    std::int32_t &At(std::int32_t addr);
+};
+
+}  // namespace ir
+
+#endif
@@ -1,6 +1,7 @@
 #ifndef __sysycompiler_ir_ir_h__
 #define __sysycompiler_ir_ir_h__
 
+#include <cstdint>
 #include <iostream>
 #include <list>
 #include <memory>
@@ -9,8 +10,12 @@
 #include <utility>
 #include <vector>
 
+#include "casting.h"
+#include "emitter.h"
+#include "ir/arena.h"
 #include "ir/type.h"
 #include "ir/value.h"
+#include "util.h"
 
 namespace ir {
 
@@ -28,8 +33,11 @@ class GetelementptrInst;
 class ZextInst;
 class BitcastInst;
 class IcmpInst;
+class SelectInst;
 class PhiInst;
 class CallInst;
+class InsertElementInst;
+class ExtractElementInst;
 
 class BasicBlock;
 
@@ -55,8 +63,11 @@ class Inst {
         kZext,
         kBitcast,
         kIcmp,
+        kSelect,
         kPhi,
-        kCall
+        kCall,
+        kInsertElement,
+        kExtractElement
     };
     const InstKind kind;
 
@@ -69,11 +80,28 @@ class Inst {
 
     bool IsTerminateInst() const { return kRet <= kind && kind <= kBr; }
 
-    virtual std::string Str() const = 0;
+    std::string Str() const;
+    virtual void Emit(util::Emitter &emitter) const = 0;
+
+    // the value defined by the instruction, or nullptr
+    virtual std::shared_ptr<Value> GetResultPtr() const { return nullptr; }
+    // the values read by the instruction, labels excluded
+    virtual std::vector<std::shared_ptr<Value>> GetUseList() const {
+        return {};
+    }
+    // replace every use of from (compared by address) with to
+    virtual void ReplaceUse(const std::shared_ptr<Value> &from,
+                            const std::shared_ptr<Value> &to) {}
+
+    static bool classof(const Inst *inst) { return true; }
 
     template <typename T>
     T &Cast() {
-        return dynamic_cast<T &>(*this);
+        return util::cast<T>(*this);
+    }
+    template <typename T>
+    const T &Cast() const {
+        return util::cast<T>(*this);
     }
 
     static void CheckType(const std::string &inst,
@@ -85,10 +113,17 @@ class Inst {
     virtual void Check() const = 0;
 };
 
+inline util::Emitter &operator<<(util::Emitter &emitter, const Inst &inst) {
+    inst.Emit(emitter);
+    return emitter;
+}
+
 // ret <type> <value>
 // ret void
 class RetInst final : public Inst {
   public:
+    static bool classof(const Inst *inst) { return inst->kind == kRet; }
+
     RetInst() : Inst(kRet) {}
     explicit RetInst(Value *ret) : Inst(kRet), ret(ret) { Check(); }
     explicit RetInst(std::shared_ptr<Value> ret)
@@ -102,7 +137,10 @@ class RetInst final : public Inst {
     void SetRet(std::shared_ptr<Value> ret) { this->ret = std::move(ret); }
     const Value &GetRet() const { return *ret; }
 
-    std::string Str() const override;
+    void Emit(util::Emitter &emitter) const override;
+    std::vector<std::shared_ptr<Value>> GetUseList() const override;
+    void ReplaceUse(const std::shared_ptr<Value> &from,
+                    const std::shared_ptr<Value> &to) override;
 
   private:
     std::shared_ptr<Value> ret;  // i32
@@ -114,6 +152,8 @@ class RetInst final : public Inst {
 // br i1 <cond>, lable <iftrue>, lable <iffalse>
 class BrInst final : public Inst {
   public:
+    static bool classof(const Inst *inst) { return inst->kind == kBr; }
+
     explicit BrInst(Value *cond, int stuff) : Inst(kBr), cond(cond) {}
     explicit BrInst(std::shared_ptr<Value> cond, int stuff)
         : Inst(kBr), cond(std::move(cond)) {}
@@ -147,6 +187,7 @@ class BrInst final : public Inst {
     void SetCond(Value *cond) { this->cond.reset(cond); }
     void SetCond(std::shared_ptr<Value> cond) { this->cond = std::move(cond); }
     const Value &GetCond() const { return *cond; }
+    std::shared_ptr<Value> GetCondPtr() const { return cond; }
 
     void SetTrue(Var *if_true) { this->if_true.reset(if_true); }
     void SetTrue(std::shared_ptr<Var> if_true) {
@@ -160,7 +201,10 @@ class BrInst final : public Inst {
     }
     const Var &GetFalse() const { return *if_false; }
 
-    std::string Str() const override;
+    void Emit(util::Emitter &emitter) const override;
+    std::vector<std::shared_ptr<Value>> GetUseList() const override;
+    void ReplaceUse(const std::shared_ptr<Value> &from,
+                    const std::shared_ptr<Value> &to) override;
 
   private:
     std::shared_ptr<Value> cond;    // i1
@@ -173,7 +217,21 @@ class BrInst final : public Inst {
 // <result> = op <ty> <lhs>, <rhs>
 class BinaryOpInst final : public Inst {
   public:
-    enum BinaryOpKind { kAdd, kSub, kMul, kSDiv, kSRem };
+    static bool classof(const Inst *inst) { return inst->kind == kBinaryOp; }
+
+    enum BinaryOpKind {
+        kAdd,
+        kSub,
+        kMul,
+        kSDiv,
+        kSRem,
+        kShl,
+        kAShr,
+        kLShr,
+        kAnd,
+        kOr,
+        kXor
+    };
     const BinaryOpKind op_code;
 
     BinaryOpInst(const BinaryOpKind op_code,
@@ -213,12 +271,17 @@ class BinaryOpInst final : public Inst {
     void SetRHS(std::shared_ptr<Value> rhs) { this->rhs = std::move(rhs); }
     const Value &GetRHS() const { return *rhs; }
 
-    std::string Str() const override;
+    void Emit(util::Emitter &emitter) const override;
+    std::shared_ptr<Value> GetResultPtr() const override { return result; }
+    std::vector<std::shared_ptr<Value>> GetUseList() const override;
+    void ReplaceUse(const std::shared_ptr<Value> &from,
+                    const std::shared_ptr<Value> &to) override;
 
   private:
-    std::shared_ptr<Var> result;  // i32
-    std::shared_ptr<Value> lhs;   // i32
-    std::shared_ptr<Value> rhs;   // i32
+    // i32, or a vector for add, sub and mul
+    std::shared_ptr<Var> result;
+    std::shared_ptr<Value> lhs;
+    std::shared_ptr<Value> rhs;
 
     void Check() const override;
 };
@@ -226,6 +289,8 @@ class BinaryOpInst final : public Inst {
 // <result> = op <ty> <lhs>, <rhs>
 class BitwiseOpInst final : public Inst {
   public:
+    static bool classof(const Inst *inst) { return inst->kind == kBitwiseOp; }
+
     enum BitwiseOpKind { kAnd, kOr };
     const BitwiseOpKind op_code;
 
@@ -265,7 +330,11 @@ class BitwiseOpInst final : public Inst {
     void SetRHS(std::shared_ptr<Value> rhs) { this->rhs = std::move(rhs); }
     const Value &GetRHS() const { return *rhs; }
 
-    std::string Str() const override;
+    void Emit(util::Emitter &emitter) const override;
+    std::shared_ptr<Value> GetResultPtr() const override { return result; }
+    std::vector<std::shared_ptr<Value>> GetUseList() const override;
+    void ReplaceUse(const std::shared_ptr<Value> &from,
+                    const std::shared_ptr<Value> &to) override;
 
   private:
     std::shared_ptr<Var> result;  // i1
@@ -278,6 +347,8 @@ class BitwiseOpInst final : public Inst {
 // <result> = alloca <ty>
 class AllocaInst final : public Inst {
   public:
+    static bool classof(const Inst *inst) { return inst->kind == kAlloca; }
+
     explicit AllocaInst(Var *result) : Inst(kAlloca), result(result) {
         Check();
     }
@@ -292,7 +363,8 @@ class AllocaInst final : public Inst {
     }
     const Var &GetResult() const { return *result; }
 
-    std::string Str() const override;
+    void Emit(util::Emitter &emitter) const override;
+    std::shared_ptr<Value> GetResultPtr() const override { return result; }
 
   private:
     std::shared_ptr<Var> result;  // ptr
@@ -303,6 +375,8 @@ class AllocaInst final : public Inst {
 // <result> = load <ty>, <ty>* <pointer>
 class LoadInst final : public Inst {
   public:
+    static bool classof(const Inst *inst) { return inst->kind == kLoad; }
+
     LoadInst(Var *result, Var *ptr) : Inst(kLoad), result(result), ptr(ptr) {
         Check();
     }
@@ -320,8 +394,13 @@ class LoadInst final : public Inst {
     void SetPtr(Var *ptr) { this->ptr.reset(ptr); }
     void SetPtr(std::shared_ptr<Var> ptr) { this->ptr = std::move(ptr); }
     const Var &GetPtr() const { return *ptr; }
+    std::shared_ptr<Var> GetPtrPtr() const { return ptr; }
 
-    std::string Str() const override;
+    void Emit(util::Emitter &emitter) const override;
+    std::shared_ptr<Value> GetResultPtr() const override { return result; }
+    std::vector<std::shared_ptr<Value>> GetUseList() const override;
+    void ReplaceUse(const std::shared_ptr<Value> &from,
+                    const std::shared_ptr<Value> &to) override;
 
   private:
     std::shared_ptr<Var> result;
@@ -333,6 +412,8 @@ class LoadInst final : public Inst {
 // store <ty> <value>, <ty>* <pointer>
 class StoreInst final : public Inst {
   public:
+    static bool classof(const Inst *inst) { return inst->kind == kStore; }
+
     StoreInst(Value *result, Value *ptr)
         : Inst(kStore), value(result), ptr(ptr) {
         Check();
@@ -347,12 +428,17 @@ class StoreInst final : public Inst {
         this->value = std::move(value);
     }
     const Value &GetValue() const { return *value; }
+    std::shared_ptr<Value> GetValuePtr() const { return value; }
 
     void SetPtr(Value *ptr) { this->ptr.reset(ptr); }
     void SetPtr(std::shared_ptr<Value> ptr) { this->ptr = std::move(ptr); }
     const Value &GetPtr() const { return *ptr; }
+    std::shared_ptr<Value> GetPtrPtr() const { return ptr; }
 
-    std::string Str() const override;
+    void Emit(util::Emitter &emitter) const override;
+    std::vector<std::shared_ptr<Value>> GetUseList() const override;
+    void ReplaceUse(const std::shared_ptr<Value> &from,
+                    const std::shared_ptr<Value> &to) override;
 
   private:
     std::shared_ptr<Value> value;
@@ -364,6 +450,10 @@ class StoreInst final : public Inst {
 // <result> = getelementptr <ty>, <ty>* <ptrval>{, <ty> <idx>}*
 class GetelementptrInst final : public Inst {
   public:
+    static bool classof(const Inst *inst) {
+        return inst->kind == kGetelementptr;
+    }
+
     GetelementptrInst(Var *result,
                       Var *ptr,
                       std::vector<std::shared_ptr<Value>> idx_list)
@@ -392,6 +482,7 @@ class GetelementptrInst final : public Inst {
     void SetPtr(Var *ptr) { this->ptr.reset(ptr); }
     void SetPtr(std::shared_ptr<Var> ptr) { this->ptr = std::move(ptr); }
     const Var &GetPtr() const { return *ptr; }
+    std::shared_ptr<Var> GetPtrPtr() const { return ptr; }
 
     const std::vector<std::shared_ptr<Value>> &GetIdxList() const {
         return idx_list;
@@ -404,12 +495,16 @@ class GetelementptrInst final : public Inst {
         return idx_list[index];
     }
 
-    std::string Str() const override;
+    void Emit(util::Emitter &emitter) const override;
+    std::shared_ptr<Value> GetResultPtr() const override { return result; }
+    std::vector<std::shared_ptr<Value>> GetUseList() const override;
+    void ReplaceUse(const std::shared_ptr<Value> &from,
+                    const std::shared_ptr<Value> &to) override;
 
   private:
     std::shared_ptr<Var> result;  // ptr
     std::shared_ptr<Var> ptr;     // ptr
-    const std::vector<std::shared_ptr<Value>> idx_list;
+    std::vector<std::shared_ptr<Value>> idx_list;
 
     void Check() const override;
 };
@@ -417,6 +512,8 @@ class GetelementptrInst final : public Inst {
 // <result> = zext <ty> <value> to <ty2>
 class ZextInst final : public Inst {
   public:
+    static bool classof(const Inst *inst) { return inst->kind == kZext; }
+
     ZextInst(Value *result, Value *value)
         : Inst(kZext), result(result), value(value) {
         Check();
@@ -438,7 +535,11 @@ class ZextInst final : public Inst {
     }
     const Value &GetValue() const { return *value; }
 
-    std::string Str() const override;
+    void Emit(util::Emitter &emitter) const override;
+    std::shared_ptr<Value> GetResultPtr() const override { return result; }
+    std::vector<std::shared_ptr<Value>> GetUseList() const override;
+    void ReplaceUse(const std::shared_ptr<Value> &from,
+                    const std::shared_ptr<Value> &to) override;
 
   private:
     std::shared_ptr<Value> result;  // i32
@@ -450,6 +551,8 @@ class ZextInst final : public Inst {
 // <result> = bitcast <ty> <value> to <ty2>
 class BitcastInst final : public Inst {
   public:
+    static bool classof(const Inst *inst) { return inst->kind == kBitcast; }
+
     BitcastInst(Var *result, Var *value)
         : Inst(kBitcast), result(result), value(value) {}
     BitcastInst(std::shared_ptr<Var> result, std::shared_ptr<Var> value)
@@ -467,7 +570,11 @@ class BitcastInst final : public Inst {
     }
     const Var &GetValue() const { return *value; }
 
-    std::string Str() const override;
+    void Emit(util::Emitter &emitter) const override;
+    std::shared_ptr<Value> GetResultPtr() const override { return result; }
+    std::vector<std::shared_ptr<Value>> GetUseList() const override;
+    void ReplaceUse(const std::shared_ptr<Value> &from,
+                    const std::shared_ptr<Value> &to) override;
 
   private:
     std::shared_ptr<Var> result;
@@ -479,7 +586,10 @@ class BitcastInst final : public Inst {
 // <result> = icmp <cond> <ty> <op1>, <op2>
 class IcmpInst final : public Inst {
   public:
-    enum CmpKind { kEQ, kNE, kSGT, kSGE, kSLT, kSLE };
+    static bool classof(const Inst *inst) { return inst->kind == kIcmp; }
+
+    // the unsigned ones order pointers
+    enum CmpKind { kEQ, kNE, kSGT, kSGE, kSLT, kSLE, kUGT, kUGE, kULT, kULE };
     const CmpKind op_code;
 
     IcmpInst(const CmpKind op_code, Var *result, Value *lhs, Value *rhs)
@@ -512,7 +622,11 @@ class IcmpInst final : public Inst {
     void SetRHS(std::shared_ptr<Value> rhs) { this->rhs = std::move(rhs); }
     const Value &GetRHS() const { return *rhs; }
 
-    std::string Str() const override;
+    void Emit(util::Emitter &emitter) const override;
+    std::shared_ptr<Value> GetResultPtr() const override { return result; }
+    std::vector<std::shared_ptr<Value>> GetUseList() const override;
+    void ReplaceUse(const std::shared_ptr<Value> &from,
+                    const std::shared_ptr<Value> &to) override;
 
   private:
     std::shared_ptr<Var> result;  // i1
@@ -522,11 +636,78 @@ class IcmpInst final : public Inst {
     void Check() const override;
 };
 
+// <result> = select i1 <cond>, <ty> <val1>, <ty> <val2>
+class SelectInst final : public Inst {
+  public:
+    static bool classof(const Inst *inst) { return inst->kind == kSelect; }
+
+    SelectInst(Var *result, Value *cond, Value *if_true, Value *if_false)
+        : Inst(kSelect)
+        , result(result)
+        , cond(cond)
+        , if_true(if_true)
+        , if_false(if_false) {
+        Check();
+    }
+    SelectInst(std::shared_ptr<Var> result,
+               std::shared_ptr<Value> cond,
+               std::shared_ptr<Value> if_true,
+               std::shared_ptr<Value> if_false)
+        : Inst(kSelect)
+        , result(std::move(result))
+        , cond(std::move(cond))
+        , if_true(std::move(if_true))
+        , if_false(std::move(if_false)) {
+        Check();
+    }
+
+    void SetResult(Var *result) { this->result.reset(result); }
+    void SetResult(std::shared_ptr<Var> result) {
+        this->result = std::move(result);
+    }
+    const Var &GetResult() const { return *result; }
+
+    void SetCond(Value *cond) { this->cond.reset(cond); }
+    void SetCond(std::shared_ptr<Value> cond) { this->cond = std::move(cond); }
+    const Value &GetCond() const { return *cond; }
+    std::shared_ptr<Value> GetCondPtr() const { return cond; }
+
+    void SetTrue(Value *if_true) { this->if_true.reset(if_true); }
+    void SetTrue(std::shared_ptr<Value> if_true) {
+        this->if_true = std::move(if_true);
+    }
+    const Value &GetTrue() const { return *if_true; }
+    std::shared_ptr<Value> GetTruePtr() const { return if_true; }
+
+    void SetFalse(Value *if_false) { this->if_false.reset(if_false); }
+    void SetFalse(std::shared_ptr<Value> if_false) {
+        this->if_false = std::move(if_false);
+    }
+    const Value &GetFalse() const { return *if_false; }
+    std::shared_ptr<Value> GetFalsePtr() const { return if_false; }
+
+    void Emit(util::Emitter &emitter) const override;
+    std::shared_ptr<Value> GetResultPtr() const override { return result; }
+    std::vector<std::shared_ptr<Value>> GetUseList() const override;
+    void ReplaceUse(const std::shared_ptr<Value> &from,
+                    const std::shared_ptr<Value> &to) override;
+
+  private:
+    std::shared_ptr<Var> result;      // i32
+    std::shared_ptr<Value> cond;      // i1
+    std::shared_ptr<Value> if_true;   // i32
+    std::shared_ptr<Value> if_false;  // i32
+
+    void Check() const override;
+};
+
 // <result> = phi <ty> [<val0>, <label0>], ...
 class PhiInst final : public Inst {
   public:
+    static bool classof(const Inst *inst) { return inst->kind == kPhi; }
+
     struct PhiValue {
-        std::shared_ptr<Value> value;  // i32
+        std::shared_ptr<Value> value;  // i32 or vector
         std::shared_ptr<Var> label;    // label
 
         PhiValue(Value *value, Var *label) : value(value), label(label) {
@@ -538,6 +719,7 @@ class PhiInst final : public Inst {
         }
 
         std::string Str() const;
+        void Emit(util::Emitter &emitter) const;
 
       private:
         void Check() const;
@@ -547,6 +729,12 @@ class PhiInst final : public Inst {
         : Inst(kPhi), result(result), value_list(std::move(value_list)) {
         Check();
     }
+    PhiInst(std::shared_ptr<Value> result, std::vector<PhiValue> value_list)
+        : Inst(kPhi)
+        , result(std::move(result))
+        , value_list(std::move(value_list)) {
+        Check();
+    }
 
     void SetResult(Value *result) { this->result.reset(result); }
     void SetResult(std::shared_ptr<Value> result) {
@@ -555,6 +743,7 @@ class PhiInst final : public Inst {
     const Value &GetResult() const { return *result; }
 
     const std::vector<PhiValue> &GetValueList() const { return value_list; }
+    std::vector<PhiValue> &GetValueList() { return value_list; }
     std::vector<PhiValue>::size_type GetValueNum() const {
         return value_list.size();
     }
@@ -563,10 +752,14 @@ class PhiInst final : public Inst {
         return value_list[index];
     }
 
-    std::string Str() const override;
+    void Emit(util::Emitter &emitter) const override;
+    std::shared_ptr<Value> GetResultPtr() const override { return result; }
+    std::vector<std::shared_ptr<Value>> GetUseList() const override;
+    void ReplaceUse(const std::shared_ptr<Value> &from,
+                    const std::shared_ptr<Value> &to) override;
 
   private:
-    std::shared_ptr<Value> result;     // i32
+    std::shared_ptr<Value> result;     // i32 or vector
     std::vector<PhiValue> value_list;  // <operand, label>
 
     void Check() const override;
@@ -575,6 +768,8 @@ class PhiInst final : public Inst {
 // <result> = call <ty> <fnptrval>(<function args>)
 class CallInst final : public Inst {
   public:
+    static bool classof(const Inst *inst) { return inst->kind == kCall; }
+
     CallInst(Var *result,
              Var *func,
              std::vector<std::shared_ptr<Value>> param_list)
@@ -631,7 +826,13 @@ class CallInst final : public Inst {
         return param_list[index];
     }
 
-    std::string Str() const override;
+    void Emit(util::Emitter &emitter) const override;
+    std::shared_ptr<Value> GetResultPtr() const override {
+        return has_ret ? result : nullptr;
+    }
+    std::vector<std::shared_ptr<Value>> GetUseList() const override;
+    void ReplaceUse(const std::shared_ptr<Value> &from,
+                    const std::shared_ptr<Value> &to) override;
 
   private:
     bool has_ret;
@@ -642,6 +843,90 @@ class CallInst final : public Inst {
     void Check() const override;
 };
 
+// <result> = insertelement <n x ty> <val>, <ty> <elt>, i32 <idx>
+// @ note: without val the other lanes are undef
+class InsertElementInst final : public Inst {
+  public:
+    static bool classof(const Inst *inst) {
+        return inst->kind == kInsertElement;
+    }
+
+    InsertElementInst(std::shared_ptr<Var> result,
+                      std::shared_ptr<Value> vec,
+                      std::shared_ptr<Value> elt,
+                      const int index)
+        : Inst(kInsertElement)
+        , result(std::move(result))
+        , vec(std::move(vec))
+        , elt(std::move(elt))
+        , index(index) {
+        Check();
+    }
+
+    const Var &GetResult() const { return *result; }
+
+    bool HasVec() const { return vec != nullptr; }
+    const Value &GetVec() const { return *vec; }
+    std::shared_ptr<Value> GetVecPtr() const { return vec; }
+
+    const Value &GetElt() const { return *elt; }
+    std::shared_ptr<Value> GetEltPtr() const { return elt; }
+
+    int GetIndex() const { return index; }
+
+    void Emit(util::Emitter &emitter) const override;
+    std::shared_ptr<Value> GetResultPtr() const override { return result; }
+    std::vector<std::shared_ptr<Value>> GetUseList() const override;
+    void ReplaceUse(const std::shared_ptr<Value> &from,
+                    const std::shared_ptr<Value> &to) override;
+
+  private:
+    std::shared_ptr<Var> result;  // vector
+    std::shared_ptr<Value> vec;   // vector, or nullptr for undef
+    std::shared_ptr<Value> elt;   // i32
+    const int index;
+
+    void Check() const override;
+};
+
+// <result> = extractelement <n x ty> <val>, i32 <idx>
+class ExtractElementInst final : public Inst {
+  public:
+    static bool classof(const Inst *inst) {
+        return inst->kind == kExtractElement;
+    }
+
+    ExtractElementInst(std::shared_ptr<Var> result,
+                       std::shared_ptr<Value> vec,
+                       const int index)
+        : Inst(kExtractElement)
+        , result(std::move(result))
+        , vec(std::move(vec))
+        , index(index) {
+        Check();
+    }
+
+    const Var &GetResult() const { return *result; }
+
+    const Value &GetVec() const { return *vec; }
+    std::shared_ptr<Value> GetVecPtr() const { return vec; }
+
+    int GetIndex() const { return index; }
+
+    void Emit(util::Emitter &emitter) const override;
+    std::shared_ptr<Value> GetResultPtr() const override { return result; }
+    std::vector<std::shared_ptr<Value>> GetUseList() const override;
+    void ReplaceUse(const std::shared_ptr<Value> &from,
+                    const std::shared_ptr<Value> &to) override;
+
+  private:
+    std::shared_ptr<Var> result;  // i32
+    std::shared_ptr<Value> vec;   // vector
+    const int index;
+
+    void Check() const override;
+};
+
 class BasicBlock {
   public:
     explicit BasicBlock(Var *label) : label(label) {
@@ -651,53 +936,52 @@ class BasicBlock {
         Inst::CheckType("BasicBlock", this->label, Type::kLabel);
     }
 
-    void AddPredecessor(BasicBlock *predecessor) {
-        predecessor_list.emplace_back(predecessor);
-    }
-    void AddPredecessor(std::shared_ptr<BasicBlock> predecessor) {
-        predecessor_list.emplace_back(predecessor);
-    }
-    std::list<std::shared_ptr<BasicBlock>> &GetPredecessorList() {
-        return predecessor_list;
-    }
-    std::list<std::shared_ptr<BasicBlock>>::size_type GetPredecessorNum()
-        const {
+    // The edges as FuncDef::ComputeCFG last read them off the terminators,
+    // one entry per edge. They do not own the blocks.
+    using EdgeList = util::SmallVector<BasicBlock *, 2>;
+    const EdgeList &GetPredecessorList() const { return predecessor_list; }
+    EdgeList::size_type GetPredecessorNum() const {
         return predecessor_list.size();
     }
-
-    void AddSuccessor(BasicBlock *successor) {
-        predecessor_list.emplace_back(successor);
-    }
-    void AddSuccessor(std::shared_ptr<BasicBlock> successor) {
-        successor_list.emplace_back(successor);
-    }
-    std::list<std::shared_ptr<BasicBlock>> &GetSuccessorList() {
-        return successor_list;
-    }
-    std::list<std::shared_ptr<BasicBlock>>::size_type GetSuccessorNum() const {
+    const EdgeList &GetSuccessorList() const { return successor_list; }
+    EdgeList::size_type GetSuccessorNum() const {
         return successor_list.size();
     }
 
+    // the times the block ran by a profile, see opt::Profile
+    bool HasCount() const { return count != kNoCount; }
+    std::uint64_t GetCount() const { return count; }
+    void SetCount(const std::uint64_t count) { this->count = count; }
+
     void SetLabel(Var *label) { this->label.reset(label); }
     void SetLabel(std::shared_ptr<Var> label) {
         this->label = std::move(label);
     }
     const Var &GetLabel() const { return *label; }
+    std::shared_ptr<Var> GetLabelPtr() const { return label; }
 
     void AddInst(Inst *inst) { inst_list.emplace_back(inst); }
     void AddInst(std::shared_ptr<Inst> inst) { inst_list.emplace_back(inst); }
     std::list<std::shared_ptr<Inst>> &GetInstList() { return inst_list; }
+    const std::list<std::shared_ptr<Inst>> &GetInstList() const {
+        return inst_list;
+    }
     std::list<std::shared_ptr<Inst>>::size_type GetrInstNum() const {
         return inst_list.size();
     }
 
-    void Dump(std::ostream &ostream, const std::string &indent) const;
+    void Dump(util::Emitter &emitter, const char *indent) const;
 
   private:
-    std::list<std::shared_ptr<BasicBlock>> predecessor_list;
-    std::list<std::shared_ptr<BasicBlock>> successor_list;
+    friend class FuncDef;
+
+    static constexpr std::uint64_t kNoCount = UINT64_MAX;
+
+    EdgeList predecessor_list;
+    EdgeList successor_list;
     std::shared_ptr<Var> label;
     std::list<std::shared_ptr<Inst>> inst_list;
+    std::uint64_t count = kNoCount;
 };
 
 // @<GlobalVarName> = <global | constant> <Type> [<InitializerConstant>]
@@ -738,7 +1022,7 @@ class GlobalVarDef {
 
     bool IsZeroInit() const { return is_zero_init; }
 
-    void Dump(std::ostream &ostream) const;
+    void Dump(util::Emitter &emitter) const;
 
   private:
     const std::shared_ptr<Var> ident;
@@ -753,7 +1037,7 @@ class FuncDecl {
     explicit FuncDecl(Var *ident) : ident(ident) {}
     explicit FuncDecl(std::shared_ptr<Var> ident) : ident(std::move(ident)) {}
 
-    void Dump(std::ostream &ostream) const;
+    void Dump(util::Emitter &emitter) const;
 
   private:
     const std::shared_ptr<Var> ident;  // func
@@ -776,6 +1060,9 @@ class FuncDef {
     void AddBlock(std::shared_ptr<BasicBlock> block) {
         block_list.emplace_back(block);
     }
+    std::list<std::shared_ptr<BasicBlock>> &GetBlockList() {
+        return block_list;
+    }
     const std::list<std::shared_ptr<BasicBlock>> &GetBlockList() const {
         return block_list;
     }
@@ -787,7 +1074,17 @@ class FuncDef {
         return param_list;
     }
 
+    // Number the unnamed values and labels again from 0 in the order they are
+    // dumped, as LLVM requires, after instructions or blocks are added or
+    // removed. Return the next free number.
+    int Renumber();
+
+    // Read the predecessors and successors of every block off the
+    // terminators again, after branches are added, removed or retargeted.
+    void ComputeCFG();
+
     void Dump(std::ostream &ostream) const;
+    void Dump(util::Emitter &emitter) const;
 
   private:
     const std::shared_ptr<Var> ident;  // func
@@ -799,6 +1096,15 @@ class Module {
   public:
     Module() = default;
 
+    // Make a T in the arena of the module, one allocation with its count and
+    // nothing freed until the module goes. It must not outlive the module.
+    template <typename T, typename... Args>
+    std::shared_ptr<T> Make(Args &&...args) {
+        return std::allocate_shared<T>(ArenaAllocator<T>(&arena),
+                                       std::forward<Args>(args)...);
+    }
+    const Arena &GetArena() const { return arena; }
+
     void AddVar(GlobalVarDef *var) { var_list.emplace_back(var); }
     void AddVar(std::shared_ptr<GlobalVarDef> var) {
         var_list.emplace_back(var);
@@ -833,8 +1139,10 @@ class Module {
     }
 
     void Dump(std::ostream &ostream) const;
+    void Dump(util::Emitter &emitter) const;
 
   private:
+    Arena arena;  // first, so that it goes last
     std::list<std::shared_ptr<GlobalVarDef>> var_list;
     std::list<std::shared_ptr<FuncDecl>> func_decl_list;
     std::list<std::shared_ptr<FuncDef>> func_def_list;
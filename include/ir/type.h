@@ -6,6 +6,8 @@
 #include <utility>
 #include <vector>
 
+#include "casting.h"
+#include "emitter.h"
 namespace ir {
 
 /* declarations */
@@ -17,12 +19,13 @@ class IntType;
 class PtrType;
 class LabelType;
 class ArrayType;
+class VectorType;
 
 /* definitions */
 
 class Type {
   public:
-    enum TypeKind { kVoid, kFunc, kInt, kPtr, kLabel, kArray };
+    enum TypeKind { kVoid, kFunc, kInt, kPtr, kLabel, kArray, kVector };
     const TypeKind kind;
 
     explicit Type(const TypeKind kind) : kind(kind) {}
@@ -32,23 +35,35 @@ class Type {
     Type(Type &&) = delete;
     Type &operator=(Type &&) = delete;
 
-    virtual std::string Str() const = 0;
+    std::string Str() const;
+    virtual void Emit(util::Emitter &emitter) const = 0;
+
+    static bool classof(const Type *type) { return true; }
 
     template <typename T>
     const T &Cast() const {
-        return dynamic_cast<const T &>(*this);
+        return util::cast<T>(*this);
     }
 };
 
+inline util::Emitter &operator<<(util::Emitter &emitter, const Type &type) {
+    type.Emit(emitter);
+    return emitter;
+}
+
 class VoidType final : public Type {
   public:
+    static bool classof(const Type *type) { return type->kind == kVoid; }
+
     VoidType() : Type(kVoid) {}
 
-    std::string Str() const override { return "void"; }
+    void Emit(util::Emitter &emitter) const override { emitter << "void"; }
 };
 
 class FuncType final : public Type {
   public:
+    static bool classof(const Type *type) { return type->kind == kFunc; }
+
     FuncType(Type *ret_type, const std::vector<Type *> &param_list);
     FuncType(Type *ret_type, std::vector<std::shared_ptr<Type>> param_list)
         : Type(kFunc), ret_type(ret_type), param_list(std::move(param_list)) {}
@@ -66,10 +81,8 @@ class FuncType final : public Type {
         return *param_list[index];
     }
 
-    std::string RetTypeStr() const;
-    std::string ParamListStr() const;
     std::string ParamListWithNameStr() const;
-    std::string Str() const override;
+    void Emit(util::Emitter &emitter) const override;
 
   private:
     const std::unique_ptr<Type> ret_type;
@@ -78,13 +91,18 @@ class FuncType final : public Type {
 
 class IntType final : public Type {
   public:
+    static bool classof(const Type *type) { return type->kind == kInt; }
+
     enum Width { kI1, kI32 };
 
     explicit IntType(const Width width) : Type(kInt), width(width) {}
 
+    // the one shared instance of i1 or i32, types never change once made
+    static const std::shared_ptr<IntType> &Get(Width width);
+
     Width GetWidth() const { return width; }
 
-    std::string Str() const override;
+    void Emit(util::Emitter &emitter) const override;
 
   private:
     const Width width;
@@ -92,15 +110,22 @@ class IntType final : public Type {
 
 class PtrType final : public Type {
   public:
-    PtrType() : Type(kPtr), pointee(new IntType(IntType::kI32)) {}
+    static bool classof(const Type *type) { return type->kind == kPtr; }
+
+    PtrType() : Type(kPtr), pointee(IntType::Get(IntType::kI32)) {}
     explicit PtrType(Type *pointee) : Type(kPtr), pointee(pointee) {}
     explicit PtrType(std::shared_ptr<Type> pointee)
         : Type(kPtr), pointee(std::move(pointee)) {}
 
+    // the shared i32*
+    static const std::shared_ptr<PtrType> &Get();
+
     const Type &GetPointee() const { return *pointee; }
     std::shared_ptr<Type> GetPointeePtr() const { return pointee; }
 
-    std::string Str() const override { return pointee->Str() + '*'; }
+    void Emit(util::Emitter &emitter) const override {
+        emitter << *pointee << '*';
+    }
 
   private:
     const std::shared_ptr<Type> pointee;
@@ -108,13 +133,19 @@ class PtrType final : public Type {
 
 class LabelType final : public Type {
   public:
+    static bool classof(const Type *type) { return type->kind == kLabel; }
+
     LabelType() : Type(kLabel) {}
 
-    std::string Str() const override { return "label"; }
+    static const std::shared_ptr<LabelType> &Get();
+
+    void Emit(util::Emitter &emitter) const override { emitter << "label"; }
 };
 
 class ArrayType final : public Type {
   public:
+    static bool classof(const Type *type) { return type->kind == kArray; }
+
     explicit ArrayType(std::vector<int> arr_dim_list)
         : Type(kArray), arr_dim_list(std::move(arr_dim_list)) {}
 
@@ -126,12 +157,33 @@ class ArrayType final : public Type {
         return arr_dim_list[index];
     }
 
-    std::string Str() const override;
+    void Emit(util::Emitter &emitter) const override;
 
   private:
     const std::vector<int> arr_dim_list;
 };
 
+// <n x i32>, the lanes a SIMD instruction works on at once
+class VectorType final : public Type {
+  public:
+    static bool classof(const Type *type) { return type->kind == kVector; }
+
+    explicit VectorType(const int lane_num)
+        : Type(kVector), lane_num(lane_num) {}
+
+    // the shared <4 x i32>, as wide as a NEON q register
+    static const std::shared_ptr<VectorType> &Get();
+
+    int GetLaneNum() const { return lane_num; }
+
+    void Emit(util::Emitter &emitter) const override {
+        emitter << '<' << lane_num << " x i32>";
+    }
+
+  private:
+    const int lane_num;
+};
+
 }  // namespace ir
 
 #endif
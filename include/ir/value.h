@@ -5,6 +5,8 @@
 #include <string>
 #include <utility>
 
+#include "casting.h"
+#include "emitter.h"
 #include "ir/type.h"
 
 namespace ir {
@@ -39,33 +41,50 @@ class Value {
     const Type &GetType() const { return *type; }
     std::shared_ptr<Type> GetTypePtr() const { return type; }
 
-    virtual std::string Str() const = 0;
-    virtual std::string TypeStr() const = 0;
+    std::string Str() const;
+    // the value after its type, "i32 %1"
+    std::string TypeStr() const;
+    virtual void Emit(util::Emitter &emitter) const = 0;
+
+    // for an emitter, TypeStr without the string
+    struct Typed {
+        const Value &value;
+    };
+    Typed WithType() const { return {*this}; }
+
+    static bool classof(const Value *value) { return true; }
 
     template <typename T>
     const T &Cast() const {
-        return dynamic_cast<const T &>(*this);
+        return util::cast<T>(*this);
     }
 
   protected:
     const std::shared_ptr<Type> type;
 };
 
+inline util::Emitter &operator<<(util::Emitter &emitter, const Value &value) {
+    value.Emit(emitter);
+    return emitter;
+}
+
+inline util::Emitter &operator<<(util::Emitter &emitter,
+                                 const Value::Typed typed) {
+    return emitter << typed.value.GetType() << ' ' << typed.value;
+}
+
 class Imm final : public Value {
   public:
+    static bool classof(const Value *value) { return value->kind == kImm; }
+
     explicit Imm(const int value)
-        : Value(kImm, new IntType(IntType::kI32)), value(value) {}
+        : Value(kImm, IntType::Get(IntType::kI32)), value(value) {}
     explicit Imm(const bool i1)
-        : Value(kImm, new IntType(IntType::kI1)), value(i1 ? 1 : 0) {}
+        : Value(kImm, IntType::Get(IntType::kI1)), value(i1 ? 1 : 0) {}
 
     int GetValue() const { return value; }
 
-    std::string Str() const override { return std::to_string(value); }
-    std::string TypeStr() const override {
-        return (type->Cast<IntType>().GetWidth() == IntType::kI1 ? "i1 "
-                                                                 : "i32 ")
-               + std::to_string(value);
-    }
+    void Emit(util::Emitter &emitter) const override { emitter << value; }
 
   private:
     const int value;
@@ -73,6 +92,8 @@ class Imm final : public Value {
 
 class Var : public Value {
   public:
+    static bool classof(const Value *value) { return value->kind != kImm; }
+
     Var(const ValueKind kind, Type *type, std::string name)
         : Value(kind, type), name(std::move(name)) {}
     Var(const ValueKind kind, std::shared_ptr<Type> type, std::string name)
@@ -81,22 +102,31 @@ class Var : public Value {
     const std::string &GetName() const { return name; }
 
   protected:
-    const std::string name;
+    std::string name;
 };
 
 class GlobalVar final : public Var {
   public:
+    static bool classof(const Value *value) {
+        return value->kind == kGlobalVar;
+    }
+
     GlobalVar(Type *type, std::string name)
         : Var(kGlobalVar, type, std::move(name)) {}
     GlobalVar(std::shared_ptr<Type> type, std::string name)
         : Var(kGlobalVar, std::move(type), std::move(name)) {}
 
-    std::string Str() const override { return '@' + name; }
-    std::string TypeStr() const override { return type->Str() + " @" + name; }
+    void Emit(util::Emitter &emitter) const override {
+        emitter << '@' << name;
+    }
 };
 
 class LocalVar : public Var {
   public:
+    static bool classof(const Value *value) {
+        return value->kind == kLocalVar || value->kind == kTmpVar;
+    }
+
     LocalVar(Type *type, std::string name, const ValueKind kind = kLocalVar)
         : Var(kind, type, std::move(name)) {}
     LocalVar(std::shared_ptr<Type> type,
@@ -104,21 +134,28 @@ class LocalVar : public Var {
              const ValueKind kind = kLocalVar)
         : Var(kind, std::move(type), std::move(name)) {}
 
-    std::string Str() const override { return '%' + name; }
-    std::string TypeStr() const override { return type->Str() + " %" + name; }
+    void Emit(util::Emitter &emitter) const override {
+        emitter << '%' << name;
+    }
 };
 
 class TmpVar final : public LocalVar {
   public:
+    static bool classof(const Value *value) { return value->kind == kTmpVar; }
+
     explicit TmpVar(const int num)
-        : LocalVar(new IntType(IntType::kI32), std::to_string(num), kTmpVar)
+        : LocalVar(IntType::Get(IntType::kI32), std::to_string(num), kTmpVar)
         , id(num) {}
     TmpVar(Type *type, const int num)
         : LocalVar(type, std::to_string(num), kTmpVar), id(num) {}
     TmpVar(std::shared_ptr<Type> type, const int num)
         : LocalVar(std::move(type), std::to_string(num), kTmpVar), id(num) {}
 
-    void SetID(const int id) { this->id = id; }
+    // renames the variable too, see FuncDef::Renumber()
+    void SetID(const int id) {
+        this->id = id;
+        name = std::to_string(id);
+    }
     int GetID() const { return id; }
 
   private:
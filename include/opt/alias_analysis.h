@@ -0,0 +1,86 @@
+#ifndef __sysycompiler_opt_alias_analysis_h__
+#define __sysycompiler_opt_alias_analysis_h__
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "ir/ir.h"
+
+namespace opt {
+
+class ModRefAnalysis;
+
+// Where a pointer points: the word at offset + sum(coefficient * value) in
+// an object, a global, an alloca or what a parameter points to. Every
+// memory access is one i32 word, so offsets count words.
+struct Location {
+    enum ObjectKind { kUnknown, kGlobal, kAlloca, kParam };
+    ObjectKind kind = kUnknown;
+    // the name of the global, the alloca or the parameter
+    std::string object;
+    std::int64_t offset = 0;
+    // by the name of the value
+    std::map<std::string, std::int64_t> term_map;
+    // the words in the object, 0 if unknown
+    std::int64_t size = 0;
+};
+
+// Tells apart what the pointers of one function point to, as far as it can
+// follow them back through geps and bitcasts to an object:
+// - two globals, two allocas, or a global and an alloca never alias
+// - a parameter never points into an alloca of the function itself
+// - within one object, offsets with the same values but different
+//   constants never alias, the same offset always does
+// - an alloca whose address is only loaded, stored through or offset is
+//   private: no call and no pointer the analysis cannot follow reaches it
+// A parameter the frontend keeps in an alloca is followed through the load
+// of it. Array parameters may alias each other and the globals, unless
+// noalias is set, which takes them to be restrict as in C. Without mod_ref a
+// call may touch anything that is not private.
+class AliasAnalysis {
+  public:
+    enum AliasResult { kNoAlias, kMayAlias, kMustAlias };
+    enum ModRef { kNoModRef = 0, kRef = 1, kMod = 2, kModRef = kRef | kMod };
+
+    explicit AliasAnalysis(const ir::FuncDef &func,
+                           bool noalias = false,
+                           const ModRefAnalysis *mod_ref = nullptr);
+
+    Location GetLocation(const ir::Value &ptr) const;
+    AliasResult Alias(const ir::Value &lhs, const ir::Value &rhs) const;
+    bool IsPrivate(const ir::Value &ptr) const;
+    // if lhs and rhs may point into the same object, on any two iterations
+    // of a loop they are in
+    bool MayShareObject(const ir::Value &lhs, const ir::Value &rhs) const;
+
+    // if inst may read or write the word ptr points to, a call by the
+    // summary of the callee
+    ModRef GetModRef(const ir::Inst &inst, const ir::Value &ptr) const;
+
+  private:
+    const bool noalias;
+    const ModRefAnalysis *const mod_ref;
+    std::unordered_map<std::string, const ir::Inst *> def_map;
+    std::unordered_set<std::string> param_set;
+    // an alloca holding a pointer, by the parameter stored into it
+    std::unordered_map<std::string, std::string> slot_map;
+    std::unordered_map<std::string, Location> location_map;
+    std::unordered_set<std::string> escaped_set;
+
+    // memoized in location_map, the geps and bitcasts of a pointer never
+    // lead back to it
+    Location Resolve(const ir::Value &ptr);
+    // add scale * value to location, through adds, subs and muls by
+    // constants
+    void AddTerm(const ir::Value &value,
+                 std::int64_t scale,
+                 Location &location,
+                 int depth) const;
+};
+
+}  // namespace opt
+
+#endif
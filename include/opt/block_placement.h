@@ -0,0 +1,32 @@
+#ifndef __sysycompiler_opt_block_placement_h__
+#define __sysycompiler_opt_block_placement_h__
+
+#include "ir/ir.h"
+#include "opt/pass.h"
+
+namespace opt {
+
+// Lay the blocks out so that the likely successor of a block comes right
+// after it, and the backend can drop the branch to it (Pettis and Hansen):
+// - every edge is weighed by the counts of a profile if each block has one,
+//   or else by 10^loop depth of its source times a static probability:
+//   a branch back to a loop header or staying in the loop is taken 88% of
+//   the time, an icmp eq holds 37.5% of the time
+// - from the heaviest edge down, an edge joins the chain ending in its
+//   source with the chain starting with its target
+// - the chain of the entry goes first, then each time the chain the placed
+//   blocks branch to the most, the blocks that never run go last
+// The body of a loop thus falls through to its header, which branches back
+// to the top, so an iteration takes one branch instead of two. The entry
+// stays first. Run it last, once the blocks have their counts.
+class BlockPlacement final : public FuncPass {
+  public:
+    BlockPlacement() : FuncPass("block-placement") {}
+
+    // return the number of blocks that moved
+    int Run(ir::FuncDef &func) override;
+};
+
+}  // namespace opt
+
+#endif
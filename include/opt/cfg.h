@@ -0,0 +1,47 @@
+#ifndef __sysycompiler_opt_cfg_h__
+#define __sysycompiler_opt_cfg_h__
+
+#include <memory>
+#include <vector>
+
+#include "ir/ir.h"
+
+namespace opt {
+
+// The blocks of a function that are dumped, by index, with the edges read
+// off their terminators. Block 0 is the entry.
+struct Graph {
+    std::vector<std::shared_ptr<ir::BasicBlock>> block_list;
+    std::vector<std::vector<int>> succ_list;
+    std::vector<std::vector<int>> pred_list;  // an entry per edge
+
+    explicit Graph(ir::FuncDef &func);
+};
+
+// the blocks the entry reaches in reverse post order
+std::vector<int> ReversePostOrder(const Graph &graph);
+
+// Immediate dominators by Cooper, Harvey and Kennedy, -1 for the blocks the
+// entry does not reach. The entry is its own immediate dominator.
+std::vector<int> Dominator(const Graph &graph);
+
+// A natural loop: the blocks that reach the source of a back edge, an edge
+// to a block that dominates its source, without going through that block,
+// the header. Back edges from several latches make one loop.
+struct Loop {
+    int header;
+    std::vector<int> block_list;  // the header first
+};
+
+// the loops among the blocks the entry reaches, the inner ones first
+std::vector<Loop> FindLoops(const Graph &graph, const std::vector<int> &idom);
+
+// the number of natural loops each block is in
+std::vector<int> LoopDepth(const Graph &graph, const std::vector<int> &idom);
+
+// if a dominates b
+bool Dominates(const std::vector<int> &idom, int a, int b);
+
+}  // namespace opt
+
+#endif
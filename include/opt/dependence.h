@@ -0,0 +1,124 @@
+#ifndef __sysycompiler_opt_dependence_h__
+#define __sysycompiler_opt_dependence_h__
+
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "ir/ir.h"
+#include "opt/alias_analysis.h"
+#include "opt/cfg.h"
+
+namespace opt {
+
+// A loop that steps %iv by 1 from init while it is less than, or at most,
+// bound, the shape mem2reg and simplify-cfg leave a while loop in:
+//   header: %iv = phi [init, preheader], [%next, latch]
+//           %cond = icmp slt/sle %iv, bound
+//           br %cond, body, exit
+// with %next = add %iv, 1, and init and bound defined out of the loop. The
+// loop is left from the header only.
+struct CountedLoop {
+    int header;
+    int preheader;
+    int latch;
+    int exit;
+    ir::PhiInst *phi;
+    ir::IcmpInst *cond;
+    const ir::Inst *next;
+};
+
+// Two counted loops, the body of the outer one the inner loop alone:
+//   outer.header: ... br %cond, inner.header, outer.exit
+//   inner.exit:   %next = add %iv, 1
+//                 br outer.header
+// Nothing the outer loop defines is used out of it, the induction
+// variables and bounds of both are defined out of it.
+struct PerfectNest {
+    CountedLoop outer;
+    CountedLoop inner;
+    std::vector<int> block_list;  // of the outer loop
+};
+
+// the perfect nests of two loops among the blocks the entry reaches
+std::vector<PerfectNest> FindPerfectNests(const Graph &graph,
+                                          const std::vector<int> &idom);
+
+// the words in a line of the data cache
+constexpr std::int64_t kLineWords = 16;
+
+// The loads, stores and calls of a loop nest, and in which directions two
+// of them may touch the same word on different iterations. An index of a
+// gep is taken as an affine function of the induction variables and the
+// values defined out of the nest, each index telling apart the words of a
+// dimension of the array on its own. Whatever is not such a function, or
+// goes through a call, may depend in every direction on what it may alias.
+class DependenceAnalysis {
+  public:
+    // for an address that is no affine function of the induction variables
+    static constexpr std::int64_t kUnknownStride
+        = std::numeric_limits<std::int64_t>::max();
+
+    // a direction for each loop, outermost first: 1 if the later access is
+    // on a later iteration of it, 0 on the same and -1 on an earlier one
+    using Direction = std::vector<int>;
+
+    // the nest is block_list with the induction variables iv_list
+    DependenceAnalysis(const Graph &graph,
+                       const std::vector<int> &block_list,
+                       std::vector<std::string> iv_list,
+                       const AliasAnalysis &alias_analysis);
+
+    // of the dependences that cross iterations, each with the first loop
+    // that is not 0 at 1
+    const std::vector<Direction> &GetDirectionList() const {
+        return direction_list;
+    }
+    // by how many words the address of each load and store moves as the
+    // loop at depth steps by one
+    std::vector<std::int64_t> GetStrideList(int depth) const;
+
+    // if the loops at depth and depth + 1 may swap
+    bool CanInterchange(int depth) const;
+    // if the loops at depth and depth + 1 may run by tiles, each dependence
+    // they carry going forward on both
+    bool CanTile(int depth) const;
+
+  private:
+    // an index as the coefficients of the values in it and a constant
+    struct Subscript {
+        std::map<std::string, std::int64_t> term_map;
+        std::int64_t constant = 0;
+    };
+    struct Access {
+        const ir::Inst *inst;
+        const ir::Value *ptr;  // nullptr for a call
+        bool affine = false;
+        // what the geps start from and their indexes, with the words each
+        // steps over
+        std::string object;
+        std::vector<Subscript> subscript_list;
+        std::vector<std::int64_t> stride_list;
+    };
+
+    std::vector<std::string> iv_list;
+    std::map<std::string, const ir::Inst *> def_map;  // in the nest
+    std::vector<Access> access_list;
+    std::vector<Direction> direction_list;
+
+    Access Analyze(const ir::Inst &inst) const;
+    bool AddTerm(const ir::Value &value,
+                 std::int64_t scale,
+                 Subscript &subscript,
+                 int depth) const;
+    void AddDependence(const Access &lhs,
+                       const Access &rhs,
+                       const AliasAnalysis &alias_analysis);
+    void AddDirection(Direction direction);
+};
+
+}  // namespace opt
+
+#endif
@@ -0,0 +1,37 @@
+#ifndef __sysycompiler_opt_if_conversion_h__
+#define __sysycompiler_opt_if_conversion_h__
+
+#include "ir/ir.h"
+#include "opt/pass.h"
+
+namespace opt {
+
+// Turn short if-then and if-then-else shapes into straight-line code. The
+// arms are moved into the branching block and run on both paths, each store
+// in them is masked as
+//     %old = load <ptr>; %new = select <cond>, <value>, %old; store %new
+// and the phis of the joining block become selects. An arm qualifies when
+// all its instructions are safe to run speculatively: no calls, no division
+// by a variable, and memory accesses only to scalars, to constant in-bound
+// array elements, or to an address the branching block already accessed.
+class IfConversion final : public FuncPass {
+  public:
+    // one per instruction, two more per store for its load and select
+    static constexpr int kDefaultMaxCost = 8;
+
+    explicit IfConversion(const int max_cost = kDefaultMaxCost)
+        : FuncPass("if-conversion"), max_cost(max_cost) {}
+
+    // return the number of branches removed
+    int Run(ir::FuncDef &func) override;
+
+    // the cost of the arms of a branch must add up to no more than this
+    int GetMaxCost() const { return max_cost; }
+
+  private:
+    const int max_cost;
+};
+
+}  // namespace opt
+
+#endif
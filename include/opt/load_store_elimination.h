@@ -0,0 +1,36 @@
+#ifndef __sysycompiler_opt_load_store_elimination_h__
+#define __sysycompiler_opt_load_store_elimination_h__
+
+#include <memory>
+
+#include "ir/ir.h"
+#include "opt/mod_ref.h"
+#include "opt/pass.h"
+
+namespace opt {
+
+// Keep the words of memory in values where the alias analysis allows it:
+// - a load of a word whose value is known on every path to it, stored or
+//   loaded before with nothing that may write it in between, becomes that
+//   value
+// - a store of the value a word already holds goes
+// - a store that a later one in the block overwrites before anything may
+//   read the word goes
+// A call touches what the summary of the callee says, found when the pass
+// is prepared with the module. Run on its own a call may touch whatever is
+// not private to the function.
+class LoadStoreElimination final : public FuncPass {
+  public:
+    LoadStoreElimination() : FuncPass("load-store-elimination") {}
+
+    void Prepare(const ir::Module &module) override;
+    // return the number of loads and stores removed
+    int Run(ir::FuncDef &func) override;
+
+  private:
+    std::unique_ptr<ModRefAnalysis> mod_ref;
+};
+
+}  // namespace opt
+
+#endif
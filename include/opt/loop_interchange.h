@@ -0,0 +1,25 @@
+#ifndef __sysycompiler_opt_loop_interchange_h__
+#define __sysycompiler_opt_loop_interchange_h__
+
+#include "ir/ir.h"
+#include "opt/pass.h"
+
+namespace opt {
+
+// Swap the loops of a perfect nest where the inner one walks memory the
+// wrong way round, as a column of a matrix, and the dependences allow it.
+// Each load and store costs the words its address moves by on an
+// iteration of the innermost loop, at most a line of the cache; the loops
+// swap if that makes the nest cheaper. The ranges and conditions of the
+// loops swap, and so do the induction variables in the body.
+class LoopInterchange final : public FuncPass {
+  public:
+    LoopInterchange() : FuncPass("loop-interchange") {}
+
+    // return the number of nests interchanged
+    int Run(ir::FuncDef &func) override;
+};
+
+}  // namespace opt
+
+#endif
@@ -0,0 +1,30 @@
+#ifndef __sysycompiler_opt_loop_tiling_h__
+#define __sysycompiler_opt_loop_tiling_h__
+
+#include "ir/ir.h"
+#include "opt/pass.h"
+
+namespace opt {
+
+// Run a perfect nest by tiles of kTileSize by kTileSize iterations where a
+// load or store moves by a line of the cache or more on each iteration of
+// the inner loop but by less on one of the outer loop, so that the lines a
+// tile brings in are still there when the outer loop comes back to them,
+// as for a transpose. The dependences must allow it, and the loops count
+// up from a constant of 0 or more while less than their bounds, so that
+// the end of a tile never overflows:
+//   for (ii = init; ii < bound; ii = ii_end)
+//     ii_end = ii + min(bound - ii, kTileSize)
+//     for (jj = ...)
+//       the nest from ii to ii_end by jj to jj_end
+class LoopTiling final : public FuncPass {
+  public:
+    LoopTiling() : FuncPass("loop-tiling") {}
+
+    // return the number of nests tiled
+    int Run(ir::FuncDef &func) override;
+};
+
+}  // namespace opt
+
+#endif
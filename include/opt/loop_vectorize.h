@@ -0,0 +1,37 @@
+#ifndef __sysycompiler_opt_loop_vectorize_h__
+#define __sysycompiler_opt_loop_vectorize_h__
+
+#include "ir/ir.h"
+#include "opt/pass.h"
+
+namespace opt {
+
+// Run four iterations of an innermost loop at once on <4 x i32>, the lanes
+// of a NEON q register. The loop is a header and a body that is its latch,
+// counting %iv up by 1 while less than a bound defined out of it:
+//   header: %iv = phi [init, preheader], [%iv + 1, body]
+//           %s = phi [s0, preheader], [%s + x, body]   ; reductions
+//           br %iv < bound, body, exit
+// The loads and stores of the body move by one word as %iv steps, what they
+// store and add up is built from them, %iv and values defined out of the
+// loop by add, sub, mul and shl. On an object two of them may share, one
+// must not read or write a word the other wrote or read up to three
+// iterations before in the wrong order; pointers the analysis cannot tell
+// apart, as two array parameters, are compared before the loop. The vector
+// loop runs first, the old one finishes the iterations left:
+//   vpre:    the splats of the invariants, zero sums, checks
+//   vheader: %vi = phi [init, vpre], [%vi + 4, vbody]
+//            br %vi < bound - 3, vbody, vexit
+//   vexit:   s0 plus the lanes of each sum, into the phis of header
+// A loop whose vectors would not fit in the q registers is left alone.
+class LoopVectorize final : public FuncPass {
+  public:
+    LoopVectorize() : FuncPass("loop-vectorize") {}
+
+    // return the number of loops vectorized
+    int Run(ir::FuncDef &func) override;
+};
+
+}  // namespace opt
+
+#endif
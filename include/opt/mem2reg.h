@@ -0,0 +1,24 @@
+#ifndef __sysycompiler_opt_mem2reg_h__
+#define __sysycompiler_opt_mem2reg_h__
+
+#include "ir/ir.h"
+#include "opt/pass.h"
+
+namespace opt {
+
+// Promote the i32 allocas that are only loaded and stored to SSA values.
+// Phis go on the iterated dominance frontier of the stores (Cytron et al.),
+// a load becomes the value that reaches it along the dominator tree, and the
+// phis nothing ends up reading are dropped again. A load that no store
+// reaches reads 0.
+class Mem2Reg final : public FuncPass {
+  public:
+    Mem2Reg() : FuncPass("mem2reg") {}
+
+    // return the number of allocas promoted
+    int Run(ir::FuncDef &func) override;
+};
+
+}  // namespace opt
+
+#endif
@@ -0,0 +1,52 @@
+#ifndef __sysycompiler_opt_mod_ref_h__
+#define __sysycompiler_opt_mod_ref_h__
+
+#include <set>
+#include <string>
+#include <unordered_map>
+
+#include "ir/ir.h"
+
+namespace opt {
+
+// What a call to a function may do to the memory of its caller.
+struct ModRefSummary {
+    bool unknown = false;  // may read and write anything
+    bool io = false;       // reads input or writes output
+    // by Str() of the global
+    std::set<std::string> ref_global_set;
+    std::set<std::string> mod_global_set;
+    // by index of the pointer parameter, what it points into
+    std::set<int> ref_param_set;
+    std::set<int> mod_param_set;
+
+    // writes no memory of the caller and does no io, a call whose result
+    // goes unused can go
+    bool IsPure() const {
+        return !unknown && !io && mod_global_set.empty()
+               && mod_param_set.empty();
+    }
+};
+
+bool operator==(const ModRefSummary &lhs, const ModRefSummary &rhs);
+
+// The summaries of the functions a module defines, found bottom up over the
+// call graph: a function touches what it loads and stores itself and what
+// the functions it calls touch, the parameters of a callee taken back to
+// the arguments of the call. Recursion is iterated to a fixed point. The
+// functions of sylib have summaries written by hand, and a function
+// declared but neither defined nor in sylib may do anything.
+class ModRefAnalysis {
+  public:
+    explicit ModRefAnalysis(const ir::Module &module);
+
+    // the summary of the function named name, or nullptr if it is unknown
+    const ModRefSummary *GetSummary(const std::string &name) const;
+
+  private:
+    std::unordered_map<std::string, ModRefSummary> summary_map;
+};
+
+}  // namespace opt
+
+#endif
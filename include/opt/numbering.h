@@ -0,0 +1,51 @@
+#ifndef __sysycompiler_opt_numbering_h__
+#define __sysycompiler_opt_numbering_h__
+
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+
+#include "ir/ir.h"
+
+namespace opt {
+
+// the names of the allocas in func
+std::unordered_set<std::string> GetAllocaSet(ir::FuncDef &func);
+
+// An i32 global or local variable. It is only accessed by its own name,
+// never through a computed address.
+bool IsScalar(const ir::Value &ptr,
+              const std::unordered_set<std::string> &alloca_set);
+
+// Names values by how they are computed along a straight run of
+// instructions: two loads of a scalar with no store in between, or two geps
+// with such operands, get the same key. Adding or subtracting a constant is
+// kept as an offset, so %i - 1 + 1 and %i name the same value.
+class Numbering {
+  public:
+    explicit Numbering(const std::unordered_set<std::string> &alloca_set)
+        : alloca_set(alloca_set) {}
+
+    std::string Key(const ir::Value &value) const;
+    // the key of the base and the offset from it, the base of a constant is
+    // empty
+    std::pair<std::string, int> Linear(const ir::Value &value) const;
+
+    // call on each instruction in order
+    void Visit(const ir::Inst &inst);
+
+  private:
+    const std::unordered_set<std::string> &alloca_set;
+    std::unordered_map<std::string, std::string> key_map;
+    std::unordered_map<std::string, std::pair<std::string, int>> linear_map;
+    std::unordered_map<std::string, int> epoch;  // of each scalar
+    int memory_epoch = 0;                        // of everything else
+    int call_epoch = 0;                          // of the globals
+
+    std::string Epoch(const ir::Value &ptr) const;
+};
+
+}  // namespace opt
+
+#endif
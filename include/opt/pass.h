@@ -0,0 +1,50 @@
+#ifndef __sysycompiler_opt_pass_h__
+#define __sysycompiler_opt_pass_h__
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "ir/ir.h"
+
+namespace opt {
+
+// A transformation that works on one function at a time.
+class FuncPass {
+  public:
+    explicit FuncPass(std::string name) : name(std::move(name)) {}
+    virtual ~FuncPass() = default;
+    FuncPass(const FuncPass &) = delete;
+    FuncPass &operator=(const FuncPass &) = delete;
+    FuncPass(FuncPass &&) = delete;
+    FuncPass &operator=(FuncPass &&) = delete;
+
+    const std::string &GetName() const { return name; }
+
+    // called with the module before Run goes over its functions, for what
+    // the pass wants to know of the whole of it
+    virtual void Prepare(const ir::Module &module) {}
+    // return the number of changes made to func
+    virtual int Run(ir::FuncDef &func) = 0;
+
+  private:
+    const std::string name;
+};
+
+// the br ending bb, or nullptr
+ir::BrInst *GetBr(ir::BasicBlock &bb);
+// the labels bb branches to, by Str(), one per edge
+std::vector<std::string> GetSuccessorList(ir::BasicBlock &bb);
+
+// run pass on every function of module, return the number of changes
+int RunOnModule(FuncPass &pass, ir::Module &module);
+
+// replace every use of from in func with to
+void ReplaceAllUses(ir::FuncDef &func,
+                    const std::shared_ptr<ir::Value> &from,
+                    const std::shared_ptr<ir::Value> &to);
+
+}  // namespace opt
+
+#endif
@@ -0,0 +1,36 @@
+#ifndef __sysycompiler_opt_pipeline_h__
+#define __sysycompiler_opt_pipeline_h__
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "ir/ir.h"
+#include "opt/pass.h"
+
+namespace opt {
+
+// the pass of the name, as given by GetName(), throw
+// InvalidParameterException if there is no such pass
+std::unique_ptr<FuncPass> CreatePass(const std::string &name);
+
+// The pipeline of -O<level> as comma separated pass names, level is 0 to 2.
+// strength-reduction and if-conversion work on the loads and stores of the
+// frontend, so they run before mem2reg and simplify-cfg. The loop and memory
+// passes follow on SSA form, and simplify-cfg runs again last to merge the
+// preheaders and exits they leave behind.
+std::string GetPipeline(int level);
+
+// the passes of a comma separated pipeline in order, an empty pipeline has
+// none, throw InvalidParameterException for an empty or unknown name
+std::vector<std::unique_ptr<FuncPass>> ParsePipeline(
+    const std::string &pipeline);
+
+// run each pass on every function of module in order, return the number of
+// changes
+int RunPipeline(const std::vector<std::unique_ptr<FuncPass>> &pass_list,
+                ir::Module &module);
+
+}  // namespace opt
+
+#endif
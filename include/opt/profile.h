@@ -0,0 +1,60 @@
+#ifndef __sysycompiler_opt_profile_h__
+#define __sysycompiler_opt_profile_h__
+
+#include <cstdint>
+#include <istream>
+#include <unordered_map>
+#include <vector>
+
+#include "emitter.h"
+#include "ir/ir.h"
+
+namespace opt {
+
+// The counters of an instrumented program and the layout of them. The
+// counters are u64, one per block of each function in order, each kept as
+// two i32 words with the low one first. The layout
+// holds the number of functions, then the hash and the number of blocks of
+// each. sylib dumps both from after_main.
+constexpr char kProfileCounter[] = "__sysy_profile_counter";
+constexpr char kProfileLayout[] = "__sysy_profile_layout";
+
+// A hash of the name of func and the shape of its control flow. A profile
+// only applies to a function of the same hash, so the program it was taken
+// from must have gone through the same passes.
+std::uint32_t GetProfileHash(const ir::FuncDef &func);
+
+// -fprofile-generate: count each block of every function of module in
+// kProfileCounter and describe them in kProfileLayout.
+void InstrumentProfile(ir::Module &module);
+
+// The times each block of each function ran. In text, one line with the
+// hash and the number of blocks for each function, then one line with the
+// count of each block.
+class Profile {
+  public:
+    // throw InvalidParameterException if istream is not a profile
+    static Profile Read(std::istream &istream);
+    void Write(util::Emitter &emitter) const;
+
+    // the counts of the blocks of func in order
+    void Add(const ir::FuncDef &func, std::vector<std::uint64_t> count_list);
+
+    // -fprofile-use: set the count of each block of the functions in module
+    // that the profile has, return the number of them
+    int Annotate(ir::Module &module) const;
+
+  private:
+    struct Entry {
+        std::uint32_t hash;
+        std::vector<std::uint64_t> count_list;
+    };
+    std::vector<Entry> entry_list;
+    std::unordered_map<std::uint32_t, int> entry_map;
+
+    void Add(Entry entry);
+};
+
+}  // namespace opt
+
+#endif
@@ -0,0 +1,36 @@
+#ifndef __sysycompiler_opt_scalar_promotion_h__
+#define __sysycompiler_opt_scalar_promotion_h__
+
+#include <memory>
+
+#include "ir/ir.h"
+#include "opt/mod_ref.h"
+#include "opt/pass.h"
+
+namespace opt {
+
+// Keep a word of memory a loop reads and writes in a value for the whole of
+// the loop, with a load before it and a store on each way out of it, where
+// - each load and store of the word in the loop goes through an address
+//   that is the same on every iteration, and the alias analysis proves the
+//   other loads, stores and calls of the loop never touch it
+// - loading it before the loop is safe: the word is at a constant offset
+//   into a global or an alloca, or the loop touches it before every exit
+// The loop gets a block of its own to come in from and each edge out of it
+// one for the stores. The word goes through an alloca that mem2reg makes
+// SSA values of, with phis where the loop joins.
+class ScalarPromotion final : public FuncPass {
+  public:
+    ScalarPromotion() : FuncPass("scalar-promotion") {}
+
+    void Prepare(const ir::Module &module) override;
+    // return the number of words promoted
+    int Run(ir::FuncDef &func) override;
+
+  private:
+    std::unique_ptr<ModRefAnalysis> mod_ref;
+};
+
+}  // namespace opt
+
+#endif
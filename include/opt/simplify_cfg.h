@@ -0,0 +1,28 @@
+#ifndef __sysycompiler_opt_simplify_cfg_h__
+#define __sysycompiler_opt_simplify_cfg_h__
+
+#include "ir/ir.h"
+#include "opt/pass.h"
+
+namespace opt {
+
+// Tidy the control flow the frontend leaves behind, until nothing changes:
+// - a branch on a constant, or to the same block both ways, becomes a jump
+// - the blocks the entry does not reach are deleted
+// - a block that only jumps on is bypassed by its predecessors
+// - a block is merged into its only predecessor if that jumps to it
+// - a predecessor that already knows where a block will branch, because it
+//   branched on the same condition or feeds a constant into the phi the
+//   block compares, jumps there directly
+// - a phi with the same value on every edge is replaced by that value
+class SimplifyCFG final : public FuncPass {
+  public:
+    SimplifyCFG() : FuncPass("simplify-cfg") {}
+
+    // return the number of changes
+    int Run(ir::FuncDef &func) override;
+};
+
+}  // namespace opt
+
+#endif
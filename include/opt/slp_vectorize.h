@@ -0,0 +1,40 @@
+#ifndef __sysycompiler_opt_slp_vectorize_h__
+#define __sysycompiler_opt_slp_vectorize_h__
+
+#include <memory>
+
+#include "ir/ir.h"
+#include "opt/mod_ref.h"
+#include "opt/pass.h"
+
+namespace opt {
+
+// Pack straight-line code of a block into <4 x i32>. Four stores to
+// consecutive words of an object are the seed, the values they store the
+// lanes of a vector; lanes computed by the same add, sub or mul are packed
+// again from their operands, lanes loaded from consecutive words become a
+// vector load, and the rest is put together lane by lane:
+//   a[0] = b[0] + x   ...   a[3] = b[3] + x
+// becomes
+//   %v = load <4 x i32>, <4 x i32>* (b)
+//   store (%v + <x, x, x, x>), <4 x i32>* (a)
+// The vector code goes where the last store of the seed was, so nothing in
+// between may touch the words moved past it. The vectors must cost less
+// than the scalars they replace: a lane packed from scalars costs one move,
+// the same scalar on every lane one, and a scalar still used out of the
+// tree stays as it was.
+class SLPVectorize final : public FuncPass {
+  public:
+    SLPVectorize() : FuncPass("slp-vectorize") {}
+
+    void Prepare(const ir::Module &module) override;
+    // return the number of seeds vectorized
+    int Run(ir::FuncDef &func) override;
+
+  private:
+    std::unique_ptr<ModRefAnalysis> mod_ref;
+};
+
+}  // namespace opt
+
+#endif
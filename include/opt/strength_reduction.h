@@ -0,0 +1,35 @@
+#ifndef __sysycompiler_opt_strength_reduction_h__
+#define __sysycompiler_opt_strength_reduction_h__
+
+#include "ir/ir.h"
+#include "opt/pass.h"
+
+namespace opt {
+
+// Replace multiplication, division and remainder by powers of two with
+// shifts and masks. Signed division rounds toward zero, so a negative
+// dividend is biased by 2^k - 1 before the arithmetic shift:
+//     x / 2^k = (x + (x >> 31 >>> 32 - k)) >> k
+//     x % 2^k = x - ((x + (x >> 31 >>> 32 - k)) & -2^k)
+// A dividend known to be non-negative needs no bias.
+//
+// The divisor may also be a variable that can only hold a power of two or
+// zero, since SysY has no shifts and programs build them by doubling:
+// - a load of t[i] from a local table filled with t[0] = 1 and
+//   t[i] = t[i - 1] * 2 holds 2^i, so both / and % become shifts and masks;
+// - a local variable that starts at a power of two and is only ever doubled
+//   holds some 2^k, so % becomes a mask; when it is divided by, a shadow
+//   variable counts k along with it and / becomes a shift.
+// Division by zero and signed overflow are undefined, so the doubling never
+// reaches 2^31 or zero.
+class StrengthReduction final : public FuncPass {
+  public:
+    StrengthReduction() : FuncPass("strength-reduction") {}
+
+    // return the number of instructions rewritten
+    int Run(ir::FuncDef &func) override;
+};
+
+}  // namespace opt
+
+#endif
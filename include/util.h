@@ -1,7 +1,11 @@
 #ifndef __sysycompiler_util_h__
 #define __sysycompiler_util_h__
 
+#include <algorithm>
+#include <cstddef>
 #include <string>
+#include <utility>
+#include <vector>
 
 namespace util {
 
@@ -78,6 +82,73 @@ void ShowAllFormat();
 
 std::string FormatHex32(std::uint32_t num);
 
+/* containers */
+
+// A vector of a trivially copyable T that keeps up to N elements inline and
+// moves to the heap only when it grows past them.
+template <typename T, std::size_t N>
+class SmallVector {
+  public:
+    using size_type = std::size_t;
+    using iterator = T *;
+    using const_iterator = const T *;
+
+    SmallVector() = default;
+    SmallVector(const SmallVector &other) { *this = other; }
+    SmallVector(SmallVector &&other) noexcept { *this = std::move(other); }
+    SmallVector &operator=(const SmallVector &other) {
+        if (this == &other) return *this;
+        clear();
+        for (const auto &value : other) push_back(value);
+        return *this;
+    }
+    // takes the heap elements of other over, other is left empty
+    SmallVector &operator=(SmallVector &&other) noexcept {
+        if (this == &other) return *this;
+        std::copy(other.inline_data, other.inline_data + N, inline_data);
+        heap_data = std::move(other.heap_data);
+        num = other.num;
+        other.clear();
+        return *this;
+    }
+
+    void push_back(const T &value) {
+        if (num < N) {
+            inline_data[num++] = value;
+            return;
+        }
+        if (num == N) heap_data.assign(inline_data, inline_data + N);
+        heap_data.push_back(value);
+        ++num;
+    }
+    void clear() {
+        num = 0;
+        heap_data.clear();
+    }
+
+    std::size_t size() const { return num; }
+    bool empty() const { return num == 0; }
+
+    T *data() { return num <= N ? inline_data : heap_data.data(); }
+    const T *data() const { return num <= N ? inline_data : heap_data.data(); }
+    T &operator[](const std::size_t i) { return data()[i]; }
+    const T &operator[](const std::size_t i) const { return data()[i]; }
+    T &front() { return data()[0]; }
+    const T &front() const { return data()[0]; }
+    T &back() { return data()[num - 1]; }
+    const T &back() const { return data()[num - 1]; }
+
+    iterator begin() { return data(); }
+    iterator end() { return data() + num; }
+    const_iterator begin() const { return data(); }
+    const_iterator end() const { return data() + num; }
+
+  private:
+    T inline_data[N]{};
+    std::vector<T> heap_data;
+    std::size_t num = 0;
+};
+
 }  // namespace util
 
 #endif
@@ -1,7 +1,10 @@
 #include "sylib.h"
 
+#include <inttypes.h>
 #include <stdarg.h>
+#include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <sys/time.h>
 
 /* Input & output functions */
@@ -29,6 +32,27 @@ void putarray(int n, int a[]) {
     printf("\n");
 }
 
+/* Profile of a program built with sysycc -fprofile-generate, the counter
+   of each block is a u64 kept as its low word then its high word */
+extern uint32_t __sysy_profile_counter[] __attribute((weak));
+extern int __sysy_profile_layout[] __attribute((weak));
+static void _sysy_dump_profile() {
+    if (!__sysy_profile_counter || !__sysy_profile_layout) return;
+    const char *path = getenv("SYSY_PROFILE");
+    FILE *file = fopen(path ? path : "sysy.profdata", "a");
+    if (!file) return;
+    const uint32_t *counter = __sysy_profile_counter;
+    for (int i = 0; i < __sysy_profile_layout[0]; i++) {
+        int block_num = __sysy_profile_layout[i * 2 + 2];
+        fprintf(file, "%u %d\n", (unsigned)__sysy_profile_layout[i * 2 + 1],
+                block_num);
+        for (int j = 0; j < block_num; j++, counter += 2)
+            fprintf(file, "%" PRIu64 "\n",
+                    (uint64_t)counter[1] << 32 | counter[0]);
+    }
+    fclose(file);
+}
+
 /* Timing function implementation */
 __attribute((constructor)) void before_main() {
     for (int i = 0; i < _SYSY_N; i++)
@@ -49,6 +73,7 @@ __attribute((destructor)) void after_main() {
     }
     fprintf(stderr, "TOTAL: %dH-%dM-%dS-%dus\n", _sysy_h[0], _sysy_m[0],
             _sysy_s[0], _sysy_us[0]);
+    _sysy_dump_profile();
 }
 void _sysy_starttime(int lineno) {
     _sysy_l1[_sysy_idx] = lineno;
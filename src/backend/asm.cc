@@ -1,26 +1,48 @@
 #include "backend/asm.h"
 
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <list>
 #include <memory>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
 #include <vector>
 
 #include "backend/backend.h"
 #include "backend/instruction.h"
 #include "backend/operand.h"
-#include "frontend/frontend.h"
+#include "backend/out_of_ssa.h"
+#include "backend/peephole.h"
+#include "backend/regalloc.h"
+#include "error.h"
 #include "ir/ir.h"
 #include "ir/type.h"
 #include "ir/value.h"
 
 backend::Assembly assembly;
-
-int Assembling() {
-    for (const auto &var : module->GetVarList()) {
+backend::Peephole peephole;
+backend::GreedyRegAlloc greedy_reg_alloc;
+backend::ColoringRegAlloc coloring_reg_alloc;
+backend::RegAlloc *reg_alloc = &greedy_reg_alloc;
+backend::QRegAlloc q_reg_alloc;
+
+int Assembling(const ir::Module &module) {
+    for (const auto &var : module.GetVarList()) {
         backend::TranslateGlobalVar(var);
     }
-    for (const auto &func : module->GetFuncDefList()) {
+    for (const auto &func : module.GetFuncDefList()) {
         backend::TranslateFunction(func);
     }
+    for (const auto &func : assembly.GetFuncList()) {
+        q_reg_alloc.Run(*func);
+        reg_alloc->Run(*func);
+        func->LowerFrame();
+        peephole.Run(*func);
+        func->PlaceLiteralPool();
+    }
     return 0;
 }
 
@@ -68,39 +90,267 @@ void TranslateGlobalVar(const std::shared_ptr<ir::GlobalVarDef> &var_def) {
 
 static RegPool reg_pool;
 
+/* per function translation state, keyed by ir::Value::Str() */
+
+// where a pointer points to
+struct Address {
+    enum AddressKind { kFrame, kGlobal, kReg };
+    AddressKind kind;
+    int object;                        // kFrame: stack object
+    std::string label;                 // kGlobal
+    std::shared_ptr<RegOperand> reg;   // kReg
+    int offset;                        // bytes
+};
+
+// compare of an icmp, emitted at each use
+struct Compare {
+    Inst::CondKind cond;
+    std::shared_ptr<RegOperand> lhs;
+    std::shared_ptr<ImmOperand> imm;  // rhs, or nullptr
+    std::shared_ptr<RegOperand> rhs;
+};
+
+static std::unordered_map<std::string, std::shared_ptr<RegOperand>> var_map;
+static std::unordered_map<std::string, Address> addr_map;
+static std::unordered_map<std::string, Compare> cmp_map;
+// the q register of each vector, and the scalar a vector of all the same
+// lanes was made from
+static std::unordered_map<std::string, std::shared_ptr<QRegOperand>> qvar_map;
+static std::unordered_map<std::string, std::string> splat_map;
+// the phis of each block by label name, and the block being translated
+static std::unordered_map<std::string, std::vector<const ir::PhiInst *>>
+    phi_map;
+static std::string block_name;
+// the count of the entry block from the profile, or 0 if there is none
+static std::uint64_t entry_count;
+
+static std::string BlockLabel(const std::shared_ptr<Function> &func,
+                              const std::string &name) {
+    return '.' + func->GetName() + '_' + name;
+}
+
+// bytes taken by an int, a pointer or an array of ints
+static int SizeOf(const ir::Type &type) {
+    if (type.kind != ir::Type::kArray) return 4;
+    int size = 4;
+    for (int dim : type.Cast<ir::ArrayType>().GetArrDimList()) size *= dim;
+    return size;
+}
+
+static void EmitCompare(const std::shared_ptr<Function> &func,
+                        const Compare &cmp) {
+    if (cmp.imm != nullptr) {
+        func->AddInst(new InsCmp(cmp.lhs, cmp.imm));
+    } else {
+        func->AddInst(new InsCmp(cmp.lhs, cmp.rhs));
+    }
+}
+
+static std::shared_ptr<RegOperand> GetReg(
+    const std::shared_ptr<Function> &func,
+    const ir::Value &value);
+
+static Address GetAddr(const std::shared_ptr<Function> &func,
+                       const ir::Value &ptr) {
+    auto addr = addr_map.find(ptr.Str());
+    if (addr != addr_map.end()) return addr->second;
+    if (ptr.kind == ir::Value::kGlobalVar) {
+        return {Address::kGlobal, -1, ptr.Cast<ir::Var>().GetName(), nullptr,
+                0};
+    }
+    return {Address::kReg, -1, "", GetReg(func, ptr), 0};
+}
+
+// the address in a register
+static std::shared_ptr<RegOperand> AddrReg(
+    const std::shared_ptr<Function> &func,
+    const Address &addr) {
+    std::shared_ptr<RegOperand> base;
+    switch (addr.kind) {
+        case Address::kFrame: {
+            auto reg = func->NewReg();
+            func->AddInst(func->FrameInst(Function::kFrameAddr, reg,
+                                          addr.object, addr.offset));
+            return reg;
+        }
+        case Address::kGlobal:
+            base = func->NewReg();
+            func->AddInst(
+                new InsLdr(base, std::make_shared<LabelOperand>(addr.label)));
+            break;
+        case Address::kReg:
+            base = addr.reg;
+            break;
+    }
+    if (addr.offset == 0) return base;
+    auto reg = func->NewReg();
+    auto imm = std::make_shared<ImmOperand>(addr.offset);
+    if (imm->IsImm8m()) {
+        func->AddInst(new InsAdd(reg, base, imm));
+    } else {
+        func->LoadImm(reg, addr.offset);
+        func->AddInst(new InsAdd(reg, base, reg));
+    }
+    return reg;
+}
+
+// the value in a register
+static std::shared_ptr<RegOperand> GetReg(
+    const std::shared_ptr<Function> &func,
+    const ir::Value &value) {
+    if (value.kind == ir::Value::kImm) {
+        auto reg = func->NewReg();
+        func->LoadImm(reg, value.Cast<ir::Imm>().GetValue());
+        return reg;
+    }
+    const auto name = value.Str();
+    auto var = var_map.find(name);
+    if (var != var_map.end()) return var->second;
+    auto cmp = cmp_map.find(name);
+    if (cmp != cmp_map.end()) {
+        auto reg = func->NewReg();
+        EmitCompare(func, cmp->second);
+        func->AddInst(new InsMov(reg, std::make_shared<ImmOperand>(0)));
+        func->AddInst(new InsMov(reg, std::make_shared<ImmOperand>(1),
+                                 cmp->second.cond));
+        return reg;
+    }
+    if (addr_map.count(name) != 0 || value.kind == ir::Value::kGlobalVar) {
+        return AddrReg(func, GetAddr(func, value));
+    }
+    throw InvalidParameterException("no register for " + name);
+}
+
+// the vector in a q register
+static std::shared_ptr<QRegOperand> GetQReg(const ir::Value &value) {
+    auto var = qvar_map.find(value.Str());
+    if (var != qvar_map.end()) return var->second;
+    throw InvalidParameterException("no q register for " + value.Str());
+}
+
+// #<imm8m> if the value is such an immediate
+static std::shared_ptr<ImmOperand> GetImm8m(const ir::Value &value) {
+    if (value.kind != ir::Value::kImm) return nullptr;
+    auto imm = std::make_shared<ImmOperand>(value.Cast<ir::Imm>().GetValue());
+    return imm->IsImm8m() ? imm : nullptr;
+}
+
+// #<imm8m> of the negated value, for add <-> sub
+static std::shared_ptr<ImmOperand> GetNegImm8m(const ir::Value &value) {
+    if (value.kind != ir::Value::kImm) return nullptr;
+    auto imm32 = value.Cast<ir::Imm>().GetValue();
+    if (imm32 == INT32_MIN) return nullptr;
+    auto imm = std::make_shared<ImmOperand>(-imm32);
+    return imm->IsImm8m() ? imm : nullptr;
+}
+
+// the blocks in reverse post order, then the ones the entry does not reach
+static std::vector<std::shared_ptr<ir::BasicBlock>> TranslateOrder(
+    ir::FuncDef &func_def) {
+    func_def.ComputeCFG();
+    const auto &block_list = func_def.GetBlockList();
+    std::unordered_map<const ir::BasicBlock *, std::shared_ptr<ir::BasicBlock>>
+        block_map;
+    for (const auto &bb : block_list) block_map[bb.get()] = bb;
+
+    std::vector<std::shared_ptr<ir::BasicBlock>> order;
+    std::unordered_set<const ir::BasicBlock *> visited;
+    std::vector<std::pair<const ir::BasicBlock *, int>> stack;
+    if (!block_list.empty()) {
+        stack.emplace_back(block_list.front().get(), 0);
+        visited.insert(block_list.front().get());
+    }
+    while (!stack.empty()) {
+        auto &[bb, next] = stack.back();
+        if (next < bb->GetSuccessorNum()) {
+            const auto *succ = bb->GetSuccessorList()[next++];
+            if (visited.insert(succ).second) stack.emplace_back(succ, 0);
+        } else {
+            order.push_back(block_map.at(bb));
+            stack.pop_back();
+        }
+    }
+    std::reverse(order.begin(), order.end());
+    for (const auto &bb : block_list) {
+        if (visited.count(bb.get()) == 0) order.push_back(bb);
+    }
+    return order;
+}
+
 void TranslateFunction(const std::shared_ptr<ir::FuncDef> &func_def) {
     auto func = std::make_shared<Function>(func_def->GetName());
+    var_map.clear();
+    addr_map.clear();
+    cmp_map.clear();
+    qvar_map.clear();
+    splat_map.clear();
+    phi_map.clear();
+
+    // AAPCS: r0-r3, then the stack
+    const auto &param_list = func_def->GetParamList();
+    for (int i = 0; i < param_list.size(); ++i) {
+        auto reg = func->NewReg();
+        if (i < 4) {
+            func->AddInst(new InsMov(reg, reg_pool[i]));
+        } else {
+            func->AddInst(func->FrameInst(Function::kFrameLoad, reg,
+                                          func->AddIncomingArg(i)));
+        }
+        var_map[param_list[i]->Str()] = reg;
+    }
 
-    func->AddInst(new InsPush);
-    func->AddInst(
-        new InsMov(reg_pool[RegOperand::kFp], reg_pool[RegOperand::kSp]));
-    func->AddInst(new InsSub(reg_pool[RegOperand::kFp],
-                             reg_pool[RegOperand::kFp],
-                             std::make_shared<ImmOperand>(4)));
-
+    // a phi is a register the predecessors copy into before they jump
+    SplitPhiEdge(*func_def);
     for (const auto &bb : func_def->GetBlockList()) {
+        for (const auto &inst : bb->GetInstList()) {
+            if (inst->kind != ir::Inst::kPhi) break;
+            phi_map[bb->GetLabel().GetName()].push_back(
+                &inst->Cast<ir::PhiInst>());
+            const auto &result = *inst->GetResultPtr();
+            if (result.GetType().kind == ir::Type::kVector) {
+                qvar_map[result.Str()] = func->NewQReg();
+            } else {
+                var_map[result.Str()] = func->NewReg();
+            }
+        }
+    }
+
+    const auto &entry = func_def->GetBlockList().front();
+    entry_count = 0;
+    if (entry->HasCount()) {
+        entry_count = std::max<std::uint64_t>(entry->GetCount(), 1);
+    }
+    // a value must be translated before its uses, so the blocks go in an
+    // order the dominators come first in, then the code is put back in the
+    // order of the block list
+    auto &inst_list = func->GetInstList();
+    std::unordered_map<const ir::BasicBlock *, std::list<std::shared_ptr<Inst>>>
+        code_map;
+    for (const auto &bb : TranslateOrder(*func_def)) {
+        const auto last = inst_list.empty() ? inst_list.end()
+                                            : std::prev(inst_list.end());
         TranslateBasicBlock(func, bb);
+        auto &code = code_map[bb.get()];
+        code.splice(code.end(), inst_list,
+                    last == inst_list.end() ? inst_list.begin()
+                                            : std::next(last),
+                    inst_list.end());
+    }
+    for (const auto &bb : func_def->GetBlockList()) {
+        inst_list.splice(inst_list.end(), code_map[bb.get()]);
     }
     assembly.AddFunc(func);
 }
 
 void TranslateBasicBlock(const std::shared_ptr<Function> &func,
                          const std::shared_ptr<ir::BasicBlock> &bb) {
-    func->AddInst(
-        new InsLabel('.' + func->GetName() + '_' + bb->GetLabel().GetName()));
-    // TODO(neatlii): if(=-!!!a), int b = !a
-    // bool check = false;
-    // for (auto iter = bb->GetInstList().cbegin();
-    //      iter != bb->GetInstList().cend(); ++iter) {
-    //     if ((*iter)->kind == ir::Inst::kIcmp) {
-    //         check = true;
-    //         continue;
-    //     }
-    //     if (check) {
-    //         if ((*iter)->kind != ir::Inst::kBr) throw "error";
-    //         check = false;
-    //     }
-    // }
+    block_name = bb->GetLabel().GetName();
+    auto label = new InsLabel(BlockLabel(func, block_name));
+    if (entry_count != 0 && bb->HasCount()) {
+        label->SetFrequency(static_cast<double>(bb->GetCount())
+                            / static_cast<double>(entry_count));
+    }
+    func->AddInst(label);
     for (const auto &inst : bb->GetInstList()) TranslateInst(func, *inst);
 }
 
@@ -115,6 +365,9 @@ void TranslateInst(const std::shared_ptr<Function> &func, ir::Inst &inst) {
         case ir::Inst::kBinaryOp:
             TranslateBinaryOpInst(func, inst.Cast<ir::BinaryOpInst>());
             break;
+        case ir::Inst::kBitwiseOp:
+            TranslateBitwiseOpInst(func, inst.Cast<ir::BitwiseOpInst>());
+            break;
         case ir::Inst::kAlloca:
             TranslateAllocaInst(func, inst.Cast<ir::AllocaInst>());
             break;
@@ -128,9 +381,32 @@ void TranslateInst(const std::shared_ptr<Function> &func, ir::Inst &inst) {
             TranslateGetelementptrInst(func,
                                        inst.Cast<ir::GetelementptrInst>());
             break;
+        case ir::Inst::kZext:
+            TranslateZextInst(func, inst.Cast<ir::ZextInst>());
+            break;
         case ir::Inst::kBitcast:
             TranslateBitcastInst(func, inst.Cast<ir::BitcastInst>());
             break;
+        case ir::Inst::kIcmp:
+            TranslateIcmpInst(func, inst.Cast<ir::IcmpInst>());
+            break;
+        case ir::Inst::kSelect:
+            TranslateSelectInst(func, inst.Cast<ir::SelectInst>());
+            break;
+        case ir::Inst::kCall:
+            TranslateCallInst(func, inst.Cast<ir::CallInst>());
+            break;
+        case ir::Inst::kInsertElement:
+            TranslateInsertElementInst(func,
+                                       inst.Cast<ir::InsertElementInst>());
+            break;
+        case ir::Inst::kExtractElement:
+            TranslateExtractElementInst(func,
+                                        inst.Cast<ir::ExtractElementInst>());
+            break;
+        case ir::Inst::kPhi:
+            // copied into by the predecessors, see EmitPhiCopy()
+            break;
         default:
             return;
     }
@@ -138,321 +414,517 @@ void TranslateInst(const std::shared_ptr<Function> &func, ir::Inst &inst) {
 
 void TranslateRetInst(const std::shared_ptr<Function> &func,
                       const ir::RetInst &inst) {
-    // recover stack
-    auto stack_size
-        = std::make_shared<ImmOperand>(func->stack_state.size() * 4);
-    if (stack_size->IsImm8m()) {
-        func->AddInst(new InsAdd(reg_pool[RegOperand::kSp],
-                                 reg_pool[RegOperand::kSp], stack_size));
-    } else {
-        func->AddInst(new InsLdr(reg_pool[4], stack_size));
-        func->AddInst(new InsAdd(reg_pool[RegOperand::kSp],
-                                 reg_pool[RegOperand::kSp], reg_pool[4]));
-    }
-    func->AddInst(new InsPop);
-
-    // store ret value to r0
     if (inst.HasRet()) {
         const auto &ret = inst.GetRet();
         if (ret.kind == ir::Value::kImm) {
-            auto ret_value = ret.Cast<ir::Imm>().GetValue();
-            auto ret_imm = std::make_shared<ImmOperand>(ret_value);
-            if (ret_imm->IsImm16() || ret_imm->IsImm8m()) {
-                func->AddInst(new InsMov(reg_pool[0], ret_imm));
-            } else {
-                func->AddInst(new InsLdr(reg_pool[0], ret_imm));
-            }
+            func->LoadImm(reg_pool[0], ret.Cast<ir::Imm>().GetValue());
         } else {
-            auto ret_name = ret.Cast<ir::Var>().GetName();
-            auto ret_state = func->var_state.find(ret_name);
-            if (ret_state->second < 0) {
-                unsigned int pos = func->stack_state.size()
-                                   - func->stack_state.find(ret_name)->second;
-                func->AddInst(
-                    new InsLdr(reg_pool[0], reg_pool[RegOperand::kSp],
-                               std::make_shared<ImmOperand>(pos * 4)));
-            } else {
-                func->AddInst(
-                    new InsMov(reg_pool[0], reg_pool[ret_state->second]));
-            }
+            func->AddInst(new InsMov(reg_pool[0], GetReg(func, ret)));
         }
     }
-
-    // return
+    // the epilogue is added by Function::LowerFrame()
     func->AddInst(new InsBx);
 }
 
-static Inst::CondKind cond;
+// the copies into the phis of dest on the edge from the current block
+static void EmitPhiCopy(const std::shared_ptr<Function> &func,
+                        const std::string &dest) {
+    auto phi_list = phi_map.find(dest);
+    if (phi_list == phi_map.end()) return;
+    ParallelCopy copy;
+    std::vector<std::pair<std::shared_ptr<RegOperand>, std::int32_t>> imm_list;
+    std::vector<std::pair<std::shared_ptr<QRegOperand>,
+                          std::shared_ptr<QRegOperand>>>
+        q_copy;
+    for (const auto *phi : phi_list->second) {
+        if (phi->GetResult().GetType().kind == ir::Type::kVector) {
+            for (const auto &value : phi->GetValueList()) {
+                if (value.label->GetName() != block_name) continue;
+                q_copy.emplace_back(qvar_map.at(phi->GetResult().Str()),
+                                    GetQReg(*value.value));
+                break;
+            }
+            continue;
+        }
+        auto rd = var_map.at(phi->GetResult().Str());
+        for (const auto &value : phi->GetValueList()) {
+            if (value.label->GetName() != block_name) continue;
+            if (value.value->kind == ir::Value::kImm) {
+                imm_list.emplace_back(
+                    rd, value.value->Cast<ir::Imm>().GetValue());
+            } else {
+                copy.emplace_back(rd, GetReg(func, *value.value));
+            }
+            break;
+        }
+    }
+    SequentializeCopy(*func, std::move(copy));
+    // after the copies, which may still read the old values
+    for (const auto &[rd, value] : imm_list) func->LoadImm(rd, value);
+    // vector phis are few, a copy reading another's destination goes
+    // through a new register the allocator mostly merges back
+    std::unordered_set<int> dest_set;
+    for (const auto &[qd, qm] : q_copy) dest_set.insert(qd->GetId());
+    for (auto &[qd, qm] : q_copy) {
+        if (dest_set.count(qm->GetId()) == 0) continue;
+        auto tmp = func->NewQReg();
+        func->AddInst(new InsVmov(tmp, qm));
+        qm = tmp;
+    }
+    for (const auto &[qd, qm] : q_copy) func->AddInst(new InsVmov(qd, qm));
+}
 
 void TranslateBrInst(const std::shared_ptr<Function> &func,
                      const ir::BrInst &inst) {
     if (inst.HasDest()) {
+        EmitPhiCopy(func, inst.GetDest().GetName());
         func->AddInst(new InsB(std::make_shared<LabelOperand>(
-            '.' + func->GetName() + '_' + inst.GetDest().GetName())));
+            BlockLabel(func, inst.GetDest().GetName()))));
+        return;
+    }
+    auto if_true = std::make_shared<LabelOperand>(
+        BlockLabel(func, inst.GetTrue().GetName()));
+    auto if_false = std::make_shared<LabelOperand>(
+        BlockLabel(func, inst.GetFalse().GetName()));
+
+    const auto &cond = inst.GetCond();
+    if (cond.kind == ir::Value::kImm) {
+        func->AddInst(
+            new InsB(cond.Cast<ir::Imm>().GetValue() != 0 ? if_true : if_false));
+        return;
+    }
+    auto cmp = cmp_map.find(cond.Str());
+    if (cmp != cmp_map.end()) {
+        EmitCompare(func, cmp->second);
+        func->AddInst(new InsB(if_true, cmp->second.cond));
     } else {
         func->AddInst(
-            new InsB(std::make_shared<LabelOperand>('.' + func->GetName() + '_'
-                                                    + inst.GetTrue().GetName()),
-                     cond));
-        func->AddInst(new InsB(std::make_shared<LabelOperand>(
-            '.' + func->GetName() + '_' + inst.GetFalse().GetName())));
+            new InsCmp(GetReg(func, cond), std::make_shared<ImmOperand>(0)));
+        func->AddInst(new InsB(if_true, Inst::kNE));
     }
+    func->AddInst(new InsB(if_false));
 }
 
-void TranslateBinaryOpInst(const std::shared_ptr<Function> &func,
-                           const ir::BinaryOpInst &inst) {
-    // store r1 in stack
-    func->GetReg(1);
-    auto result_name = inst.GetResult().GetName();
-    func->reg_state[1] = result_name;
-    func->var_state[result_name] = 1;
-
-    std::shared_ptr<RegOperand> lhs;
-    std::shared_ptr<RegOperand> rhs;
-    std::shared_ptr<ImmOperand> imm;
-    bool is_reverse = false;
-
-    // op Rd, Rn, Rm
-    // op Rd, Rn, imm
-    // imm can only be third operator
-    if (inst.GetLHS().kind == ir::Value::kImm) {
-        is_reverse = true;
-        // find rhs, or load rhs in r2
-        auto rhs_name = inst.GetRHS().Cast<ir::Var>().GetName();
-        if (func->var_state[rhs_name] < 0) {
-            auto offset = std::make_shared<ImmOperand>(
-                (func->stack_state.size()
-                 - func->stack_state.find(rhs_name)->second)
-                * 4);
-            func->AddInst(
-                new InsLdr(reg_pool[2], reg_pool[RegOperand::kSp], offset));
-            lhs = reg_pool[2];
-        } else {
-            lhs = reg_pool[func->var_state[rhs_name]];
-        }
-        // get imm
-        imm = std::make_shared<ImmOperand>(
-            inst.GetLHS().Cast<ir::Imm>().GetValue());
-    } else {
-        // find lhs, or load lhs in r2
-        auto lhs_name = inst.GetLHS().Cast<ir::Var>().GetName();
-        if (func->var_state[lhs_name] < 0) {
-            auto offset = std::make_shared<ImmOperand>(
-                (func->stack_state.size()
-                 - func->stack_state.find(lhs_name)->second)
-                * 4);
-            func->AddInst(
-                new InsLdr(reg_pool[2], reg_pool[RegOperand::kSp], offset));
-            lhs = reg_pool[2];
-        } else {
-            lhs = reg_pool[func->var_state[lhs_name]];
-        }
-        // find rhs, or load lhs in r3
-        if (inst.GetRHS().kind == ir::Value::kImm) {
-            imm = std::make_shared<ImmOperand>(
-                inst.GetLHS().Cast<ir::Imm>().GetValue());
-        } else {
-            auto rhs_name = inst.GetRHS().Cast<ir::Var>().GetName();
-            if (func->var_state[rhs_name] < 0) {
-                auto offset = std::make_shared<ImmOperand>(
-                    (func->stack_state.size()
-                     - func->stack_state.find(rhs_name)->second)
-                    * 4);
-                func->AddInst(
-                    new InsLdr(reg_pool[3], reg_pool[RegOperand::kSp], offset));
-                rhs = reg_pool[3];
-            } else {
-                rhs = reg_pool[func->var_state[rhs_name]];
-            }
-        }
+// add, sub and mul on each lane
+static void TranslateVectorOp(const std::shared_ptr<Function> &func,
+                              const ir::BinaryOpInst &inst) {
+    auto qd = func->NewQReg();
+    qvar_map[inst.GetResult().Str()] = qd;
+    auto qn = GetQReg(inst.GetLHS());
+    auto qm = GetQReg(inst.GetRHS());
+    switch (inst.op_code) {
+        case ir::BinaryOpInst::kAdd:
+            func->AddInst(new InsVadd(qd, qn, qm));
+            break;
+        case ir::BinaryOpInst::kSub:
+            func->AddInst(new InsVsub(qd, qn, qm));
+            break;
+        case ir::BinaryOpInst::kMul:
+            func->AddInst(new InsVmul(qd, qn, qm));
+            break;
+        default:
+            throw InvalidParameterException("no vector " + inst.Str());
     }
+}
 
-    if (imm != nullptr && !imm->IsImm8m() && !imm->IsImm16()) {
-        rhs = reg_pool[3];
-        func->AddInst(new InsLdr(rhs, imm));
+void TranslateBinaryOpInst(const std::shared_ptr<Function> &func,
+                           const ir::BinaryOpInst &inst) {
+    if (inst.GetResult().GetType().kind == ir::Type::kVector) {
+        TranslateVectorOp(func, inst);
+        return;
     }
+    auto rd = func->NewReg();
+    var_map[inst.GetResult().Str()] = rd;
+    const ir::Value *lhs = &inst.GetLHS();
+    const ir::Value *rhs = &inst.GetRHS();
 
     switch (inst.op_code) {
-        case ir::BinaryOpInst::kAdd:
-            if (rhs == nullptr) {
-                func->AddInst(new InsAdd(reg_pool[1], lhs, imm));
+        case ir::BinaryOpInst::kAdd: {
+            if (lhs->kind == ir::Value::kImm) std::swap(lhs, rhs);
+            if (auto imm = GetImm8m(*rhs)) {
+                func->AddInst(new InsAdd(rd, GetReg(func, *lhs), imm));
+            } else if (auto neg = GetNegImm8m(*rhs)) {
+                func->AddInst(new InsSub(rd, GetReg(func, *lhs), neg));
             } else {
-                func->AddInst(new InsAdd(reg_pool[1], lhs, rhs));
+                auto lhs_reg = GetReg(func, *lhs);
+                func->AddInst(new InsAdd(rd, lhs_reg, GetReg(func, *rhs)));
             }
             break;
-        case ir::BinaryOpInst::kSub:
-            if (rhs == nullptr) {
-                if (is_reverse) {
-                    func->AddInst(new InsRsb(reg_pool[1], lhs, imm));
-                } else {
-                    func->AddInst(new InsSub(reg_pool[1], lhs, imm));
-                }
+        }
+        case ir::BinaryOpInst::kSub: {
+            if (auto imm = GetImm8m(*rhs)) {
+                func->AddInst(new InsSub(rd, GetReg(func, *lhs), imm));
+            } else if (auto neg = GetNegImm8m(*rhs)) {
+                func->AddInst(new InsAdd(rd, GetReg(func, *lhs), neg));
+            } else if (auto rev = GetImm8m(*lhs)) {
+                func->AddInst(new InsRsb(rd, GetReg(func, *rhs), rev));
             } else {
-                if (is_reverse) {
-                    func->AddInst(new InsRsb(reg_pool[1], lhs, rhs));
-                } else {
-                    func->AddInst(new InsSub(reg_pool[1], lhs, rhs));
-                }
+                auto lhs_reg = GetReg(func, *lhs);
+                func->AddInst(new InsSub(rd, lhs_reg, GetReg(func, *rhs)));
             }
             break;
-        case ir::BinaryOpInst::kMul:
-            if (rhs == nullptr) {
-                rhs = reg_pool[3];
-                func->AddInst(new InsMov(rhs, imm));
-            }
-            func->AddInst(new InsAdd(reg_pool[1], lhs, rhs));
+        }
+        case ir::BinaryOpInst::kMul: {
+            auto lhs_reg = GetReg(func, *lhs);
+            func->AddInst(new InsMul(rd, lhs_reg, GetReg(func, *rhs)));
+            break;
+        }
+        case ir::BinaryOpInst::kSDiv: {
+            auto lhs_reg = GetReg(func, *lhs);
+            func->AddInst(new InsSDiv(rd, lhs_reg, GetReg(func, *rhs)));
+            break;
+        }
+        case ir::BinaryOpInst::kSRem: {
+            // lhs - lhs / rhs * rhs
+            auto lhs_reg = GetReg(func, *lhs);
+            auto rhs_reg = GetReg(func, *rhs);
+            auto tmp = func->NewReg();
+            func->AddInst(new InsSDiv(tmp, lhs_reg, rhs_reg));
+            func->AddInst(new InsMul(tmp, tmp, rhs_reg));
+            func->AddInst(new InsSub(rd, lhs_reg, tmp));
             break;
-        case ir::BinaryOpInst::kSDiv:
-            if (rhs == nullptr) {
-                rhs = reg_pool[3];
-                func->AddInst(new InsMov(rhs, imm));
+        }
+        case ir::BinaryOpInst::kAnd:
+        case ir::BinaryOpInst::kOr:
+        case ir::BinaryOpInst::kXor: {
+            if (lhs->kind == ir::Value::kImm) std::swap(lhs, rhs);
+            auto lhs_reg = GetReg(func, *lhs);
+            auto imm = GetImm8m(*rhs);
+            auto rhs_reg = imm == nullptr ? GetReg(func, *rhs) : nullptr;
+            if (inst.op_code == ir::BinaryOpInst::kAnd) {
+                func->AddInst(imm ? new InsAnd(rd, lhs_reg, imm)
+                                  : new InsAnd(rd, lhs_reg, rhs_reg));
+            } else if (inst.op_code == ir::BinaryOpInst::kOr) {
+                func->AddInst(imm ? new InsOrr(rd, lhs_reg, imm)
+                                  : new InsOrr(rd, lhs_reg, rhs_reg));
+            } else {
+                func->AddInst(imm ? new InsEor(rd, lhs_reg, imm)
+                                  : new InsEor(rd, lhs_reg, rhs_reg));
             }
-            func->AddInst(new InsSDiv(reg_pool[1], lhs, rhs));
             break;
-        case ir::BinaryOpInst::kSRem:
-            if (rhs == nullptr) {
-                rhs = reg_pool[3];
-                func->AddInst(new InsMov(rhs, imm));
+        }
+        case ir::BinaryOpInst::kShl:
+        case ir::BinaryOpInst::kAShr:
+        case ir::BinaryOpInst::kLShr: {
+            auto lhs_reg = GetReg(func, *lhs);
+            std::shared_ptr<ImmOperand> imm;
+            if (rhs->kind == ir::Value::kImm) {
+                const int amount = rhs->Cast<ir::Imm>().GetValue();
+                if (amount == 0) {
+                    func->AddInst(new InsMov(rd, lhs_reg));
+                    break;
+                }
+                if (0 < amount && amount < 32) {
+                    imm = std::make_shared<ImmOperand>(amount);
+                }
+            }
+            auto rhs_reg = imm == nullptr ? GetReg(func, *rhs) : nullptr;
+            if (inst.op_code == ir::BinaryOpInst::kShl) {
+                func->AddInst(imm ? new InsLsl(rd, lhs_reg, imm)
+                                  : new InsLsl(rd, lhs_reg, rhs_reg));
+            } else if (inst.op_code == ir::BinaryOpInst::kAShr) {
+                func->AddInst(imm ? new InsAsr(rd, lhs_reg, imm)
+                                  : new InsAsr(rd, lhs_reg, rhs_reg));
+            } else {
+                func->AddInst(imm ? new InsLsr(rd, lhs_reg, imm)
+                                  : new InsLsr(rd, lhs_reg, rhs_reg));
             }
-            func->AddInst(new InsSDiv(reg_pool[4], lhs, rhs));
-            func->AddInst(new InsMul(reg_pool[4], rhs, reg_pool[4]));
-            func->AddInst(new InsSub(reg_pool[1], lhs, reg_pool[4]));
             break;
+        }
+    }
+}
+
+void TranslateBitwiseOpInst(const std::shared_ptr<Function> &func,
+                            const ir::BitwiseOpInst &inst) {
+    auto rd = func->NewReg();
+    var_map[inst.GetResult().Str()] = rd;
+    auto lhs = GetReg(func, inst.GetLHS());
+    auto rhs = GetReg(func, inst.GetRHS());
+    if (inst.op_code == ir::BitwiseOpInst::kAnd) {
+        func->AddInst(new InsAnd(rd, lhs, rhs));
+    } else {
+        func->AddInst(new InsOrr(rd, lhs, rhs));
     }
 }
 
 void TranslateAllocaInst(const std::shared_ptr<Function> &func,
                          const ir::AllocaInst &inst) {
-    auto ptr_name = inst.GetResult().GetName();
     const auto &type
         = inst.GetResult().GetType().Cast<ir::PtrType>().GetPointee();
+    addr_map[inst.GetResult().Str()]
+        = {Address::kFrame, func->AddStackObject(SizeOf(type)), "", nullptr,
+           0};
+}
 
-    // alloc int
-    if (type.kind == ir::Type::kInt) {
-        func->stack_state[ptr_name] = func->stack_state.size() + 1;  // stuff
-        func->ptr_state[ptr_name] = func->stack_state.size();
-        func->AddInst(new InsSub(reg_pool[RegOperand::kSp],
-                                 reg_pool[RegOperand::kSp],
-                                 std::make_shared<ImmOperand>(4)));
-        return;
-    }
-
-    // alloc int[]
-    int size = 1;
-    for (int dim : type.Cast<ir::ArrayType>().GetArrDimList()) size *= dim;
-    func->ptr_state[ptr_name] = func->stack_state.size() + 1;
-    for (int i = 0; i < size; ++i) {  // stuffs
-        func->stack_state[ptr_name + '_' + std::to_string(i)]
-            = func->stack_state.size() + 1;
-    }
-    auto offset = std::make_shared<ImmOperand>(size * 4);
-    if (offset->IsImm8m() || offset->IsImm16()) {
-        func->AddInst(new InsSub(reg_pool[RegOperand::kSp],
-                                 reg_pool[RegOperand::kSp], offset));
-    } else {
-        func->AddInst(new InsLdr(reg_pool[4], offset));
-        func->AddInst(new InsSub(reg_pool[RegOperand::kSp],
-                                 reg_pool[RegOperand::kSp], reg_pool[4]));
-    }
+// ldr/str reach base +/- 4095
+static bool IsMemOffset(const int offset) {
+    return -4095 <= offset && offset <= 4095;
 }
 
 void TranslateLoadInst(const std::shared_ptr<Function> &func,
                        const ir::LoadInst &inst) {
-    // ldr to r6 or r7
-    std::shared_ptr<RegOperand> des_reg;
-    auto des_name = inst.GetResult().GetName();
-    if (func->reg_state[6].empty()) {
-        des_reg = reg_pool[6];
-        func->reg_state[6] = des_name;
-        func->var_state[des_name] = 6;
-    } else if (func->reg_state[7].empty()) {
-        des_reg = reg_pool[7];
-        func->reg_state[7] = des_name;
-        func->var_state[des_name] = 7;
-    } else {
-        func->GetReg(6);
-        // ldr to r6
-        des_reg = reg_pool[6];
-        func->reg_state[6] = des_name;
-        func->var_state[des_name] = 6;
-    }
-
-    auto ptr_name = inst.GetPtr().GetName();
-    if (inst.GetPtr().kind == ir::Value::kGlobalVar) {
-        auto label = std::make_shared<LabelOperand>(ptr_name);
-        func->AddInst(new InsLdr(reg_pool[5], label));
-        func->AddInst(new InsLdr(des_reg, reg_pool[5]));
+    // vld1 takes no offset
+    if (inst.GetResult().GetType().kind == ir::Type::kVector) {
+        auto qd = func->NewQReg();
+        qvar_map[inst.GetResult().Str()] = qd;
+        func->AddInst(
+            new InsVld1(qd, AddrReg(func, GetAddr(func, inst.GetPtr()))));
+        return;
+    }
+    auto rd = func->NewReg();
+    var_map[inst.GetResult().Str()] = rd;
+
+    auto addr = GetAddr(func, inst.GetPtr());
+    if (addr.kind == Address::kFrame) {
+        func->AddInst(func->FrameInst(Function::kFrameLoad, rd, addr.object,
+                                      addr.offset));
+        return;
+    }
+    if (!IsMemOffset(addr.offset)) {
+        func->AddInst(new InsLdr(rd, AddrReg(func, addr)));
+        return;
+    }
+    auto offset = addr.offset;
+    addr.offset = 0;
+    auto base = AddrReg(func, addr);
+    if (offset == 0) {
+        func->AddInst(new InsLdr(rd, base));
     } else {
-        auto offset = (func->stack_state.size()
-                       - func->ptr_state.find(ptr_name)->second)
-                      * 4;
-        func->AddInst(new InsLdr(des_reg, reg_pool[RegOperand::kSp],
-                                 std::make_shared<ImmOperand>(offset)));
+        func->AddInst(
+            new InsLdr(rd, base, std::make_shared<ImmOperand>(offset)));
     }
 }
 
 void TranslateStoreInst(const std::shared_ptr<Function> &func,
                         const ir::StoreInst &inst) {
-    std::shared_ptr<RegOperand> value_reg;
-
-    const auto &value = inst.GetValue();
-    if (value.kind == ir::Value::kImm) {
-        value_reg = reg_pool[8];
-        func->AddInst(new InsLdr(
-            value_reg,
-            std::make_shared<ImmOperand>(value.Cast<ir::Imm>().GetValue())));
-    } else {
-        value_reg = reg_pool[func->var_state[value.Cast<ir::Var>().GetName()]];
+    if (inst.GetValue().GetType().kind == ir::Type::kVector) {
+        func->AddInst(new InsVst1(GetQReg(inst.GetValue()),
+                                  AddrReg(func, GetAddr(func, inst.GetPtr()))));
+        return;
     }
+    auto value = GetReg(func, inst.GetValue());
 
-    auto ptr_name = inst.GetPtr().Cast<ir::Var>().GetName();
-    if (inst.GetPtr().kind == ir::Value::kGlobalVar) {
-        auto label = std::make_shared<LabelOperand>(ptr_name);
-        func->AddInst(new InsLdr(reg_pool[5], label));
-        func->AddInst(new InsStr(value_reg, reg_pool[5]));
+    auto addr = GetAddr(func, inst.GetPtr());
+    if (addr.kind == Address::kFrame) {
+        func->AddInst(func->FrameInst(Function::kFrameStore, value,
+                                      addr.object, addr.offset));
+        return;
+    }
+    if (!IsMemOffset(addr.offset)) {
+        func->AddInst(new InsStr(value, AddrReg(func, addr)));
+        return;
+    }
+    auto offset = addr.offset;
+    addr.offset = 0;
+    auto base = AddrReg(func, addr);
+    if (offset == 0) {
+        func->AddInst(new InsStr(value, base));
     } else {
-        auto offset = (func->stack_state.size()
-                       - func->ptr_state.find(ptr_name)->second)
-                      * 4;
-        func->AddInst(new InsStr(value_reg, reg_pool[RegOperand::kSp],
-                                 std::make_shared<ImmOperand>(offset)));
+        func->AddInst(
+            new InsStr(value, base, std::make_shared<ImmOperand>(offset)));
     }
 }
 
 void TranslateGetelementptrInst(const std::shared_ptr<Function> &func,
                                 const ir::GetelementptrInst &inst) {
-    // for (auto pair : func->ptr_state) {
-    //     std::cout << pair.first << ' ' << pair.second << std::endl;
-    // }
+    auto addr = GetAddr(func, inst.GetPtr());
+
+    // the first index steps over the whole pointee, each next one steps into
+    // an array dimension
+    const auto &pointee
+        = inst.GetPtr().GetType().Cast<ir::PtrType>().GetPointee();
+    std::vector<int> dim_list;
+    if (pointee.kind == ir::Type::kArray) {
+        dim_list = pointee.Cast<ir::ArrayType>().GetArrDimList();
+    }
+    int stride = 4;
+    for (int dim : dim_list) stride *= dim;
+
+    for (int i = 0; i < inst.GetIdxNum(); ++i) {
+        if (i > 0) stride /= dim_list[i - 1];
+        const auto &idx = *inst.GetIdxAt(i);
+        if (idx.kind == ir::Value::kImm) {
+            addr.offset += idx.Cast<ir::Imm>().GetValue() * stride;
+            continue;
+        }
+        // base + idx * stride
+        auto base = AddrReg(func, addr);
+        auto idx_reg = GetReg(func, idx);
+        auto step = func->NewReg();
+        func->LoadImm(step, stride);
+        func->AddInst(new InsMul(step, idx_reg, step));
+        auto reg = func->NewReg();
+        func->AddInst(new InsAdd(reg, base, step));
+        addr = {Address::kReg, -1, "", reg, 0};
+    }
+    addr_map[inst.GetResult().Str()] = addr;
+}
 
-    unsigned int offset = 0;
-    const auto &type = inst.GetPtr().GetType().Cast<ir::PtrType>().GetPointee();
+void TranslateZextInst(const std::shared_ptr<Function> &func,
+                       const ir::ZextInst &inst) {
+    const auto name = inst.GetResult().Str();
+    auto cmp = cmp_map.find(inst.GetValue().Str());
+    if (cmp != cmp_map.end()) {
+        cmp_map.emplace(name, cmp->second);
+        return;
+    }
+    var_map[name] = GetReg(func, inst.GetValue());
+}
 
-    if (type.kind == ir::Type::kInt) {
-        offset = inst.GetIdxList().front()->Cast<ir::Imm>().GetValue();
+void TranslateBitcastInst(const std::shared_ptr<Function> &func,
+                          const ir::BitcastInst &inst) {
+    addr_map[inst.GetResult().Str()] = GetAddr(func, inst.GetValue());
+}
+
+void TranslateIcmpInst(const std::shared_ptr<Function> &func,
+                       const ir::IcmpInst &inst) {
+    // same order as the conditions of Inst after kAL
+    auto cond = static_cast<Inst::CondKind>(inst.op_code + 1);
+    const ir::Value *lhs = &inst.GetLHS();
+    const ir::Value *rhs = &inst.GetRHS();
+    if (lhs->kind == ir::Value::kImm && rhs->kind != ir::Value::kImm) {
+        std::swap(lhs, rhs);
+        switch (cond) {
+            case Inst::kGT:
+                cond = Inst::kLT;
+                break;
+            case Inst::kGE:
+                cond = Inst::kLE;
+                break;
+            case Inst::kLT:
+                cond = Inst::kGT;
+                break;
+            case Inst::kLE:
+                cond = Inst::kGE;
+                break;
+            case Inst::kHI:
+                cond = Inst::kLO;
+                break;
+            case Inst::kHS:
+                cond = Inst::kLS;
+                break;
+            case Inst::kLO:
+                cond = Inst::kHI;
+                break;
+            case Inst::kLS:
+                cond = Inst::kHS;
+                break;
+            default:
+                break;
+        }
+    }
+    // emitted where the result is used, the flags do not live across
+    // instructions
+    Compare cmp{cond, GetReg(func, *lhs), GetImm8m(*rhs), nullptr};
+    if (cmp.imm == nullptr) cmp.rhs = GetReg(func, *rhs);
+    cmp_map.emplace(inst.GetResult().Str(), cmp);
+}
+
+void TranslateSelectInst(const std::shared_ptr<Function> &func,
+                         const ir::SelectInst &inst) {
+    // mov rd, <false>; cmp ...; mov<cond> rd, <true>
+    auto rd = func->NewReg();
+    var_map[inst.GetResult().Str()] = rd;
+    auto if_true_imm = GetImm8m(inst.GetTrue());
+    std::shared_ptr<RegOperand> if_true;
+    if (if_true_imm == nullptr) if_true = GetReg(func, inst.GetTrue());
+    if (auto imm = GetImm8m(inst.GetFalse())) {
+        func->AddInst(new InsMov(rd, imm));
+    } else {
+        func->AddInst(new InsMov(rd, GetReg(func, inst.GetFalse())));
+    }
+
+    const auto &cond_value = inst.GetCond();
+    auto cond = Inst::kNE;
+    auto cmp = cmp_map.find(cond_value.Str());
+    if (cond_value.kind == ir::Value::kImm) {
+        // the false value is already in place
+        if (cond_value.Cast<ir::Imm>().GetValue() == 0) return;
+        cond = Inst::kAL;
+    } else if (cmp != cmp_map.end()) {
+        EmitCompare(func, cmp->second);
+        cond = cmp->second.cond;
+    } else {
+        func->AddInst(new InsCmp(GetReg(func, cond_value),
+                                 std::make_shared<ImmOperand>(0)));
+    }
+    if (if_true_imm != nullptr) {
+        func->AddInst(new InsMov(rd, if_true_imm, cond));
     } else {
-        auto arr_list = type.Cast<ir::ArrayType>().GetArrDimList();
-        auto idx_list = inst.GetIdxList();
-        for (int i = 0; i < arr_list.size(); ++i) {
-            offset += arr_list[i] * idx_list[i]->Cast<ir::Imm>().GetValue();
+        func->AddInst(new InsMov(rd, if_true, cond));
+    }
+}
+
+void TranslateCallInst(const std::shared_ptr<Function> &func,
+                       const ir::CallInst &inst) {
+    // AAPCS: the first four arguments in r0-r3, the others on the stack
+    const auto &param_list = inst.GetParamList();
+    const int param_num = static_cast<int>(param_list.size());
+    std::vector<std::shared_ptr<RegOperand>> reg_list;
+    for (int i = 0; i < param_num; ++i) {
+        const auto &param = *param_list[i];
+        if (i >= 4) {
+            func->AddInst(new InsStr(GetReg(func, param),
+                                     reg_pool[RegOperand::kSp],
+                                     std::make_shared<ImmOperand>((i - 4) * 4)));
+        } else if (param.kind != ir::Value::kImm) {
+            reg_list.push_back(GetReg(func, param));
+        } else {
+            reg_list.push_back(nullptr);
+        }
+    }
+    if (param_num > 4) func->ReserveCallArg((param_num - 4) * 4);
+    // r0-r3 are set last so that they live as short as possible
+    for (int i = 0; i < reg_list.size(); ++i) {
+        if (reg_list[i] != nullptr) {
+            func->AddInst(new InsMov(reg_pool[i], reg_list[i]));
+        } else {
+            func->LoadImm(reg_pool[i], param_list[i]->Cast<ir::Imm>().GetValue());
         }
-        offset += idx_list.back()->Cast<ir::Imm>().GetValue();
     }
 
-    auto result_name = inst.GetResult().GetName();
-    auto ptr_name = inst.GetPtr().GetName();
+    func->AddInst(
+        new InsBl(std::make_shared<LabelOperand>(inst.GetFunc().GetName()),
+                  static_cast<int>(reg_list.size())));
 
-    auto pos = func->ptr_state[ptr_name];
-    func->ptr_state[result_name] = pos + offset;
+    if (inst.HasRet()) {
+        auto rd = func->NewReg();
+        func->AddInst(new InsMov(rd, reg_pool[0]));
+        var_map[inst.GetResult().Str()] = rd;
+    }
 }
 
-void TranslateBitcastInst(const std::shared_ptr<Function> &func,
-                          const ir::BitcastInst &inst) {
-    auto old_name = inst.GetValue().GetName();
-    auto new_name = inst.GetResult().GetName();
+// A vector is filled by a vdup of its first element, and the other elements
+// the same scalar are then free, as for a splat of a loop invariant.
+void TranslateInsertElementInst(const std::shared_ptr<Function> &func,
+                                const ir::InsertElementInst &inst) {
+    const auto name = inst.GetResult().Str();
+    const auto elt = inst.GetElt().Str();
+    if (!inst.HasVec()) {
+        auto qd = func->NewQReg();
+        func->AddInst(new InsVdup(qd, GetReg(func, inst.GetElt())));
+        qvar_map[name] = qd;
+        splat_map[name] = elt;
+        return;
+    }
+    auto splat = splat_map.find(inst.GetVec().Str());
+    if (splat != splat_map.end() && splat->second == elt) {
+        qvar_map[name] = GetQReg(inst.GetVec());
+        splat_map[name] = elt;
+        return;
+    }
+    auto qd = func->NewQReg();
+    func->AddInst(new InsVmov(qd, GetQReg(inst.GetVec())));
+    func->AddInst(
+        new InsVsetLane(qd, inst.GetIndex(), GetReg(func, inst.GetElt())));
+    qvar_map[name] = qd;
+}
 
-    auto iter = func->ptr_state.find(old_name);
-    func->ptr_state[new_name] = iter->second;
+void TranslateExtractElementInst(const std::shared_ptr<Function> &func,
+                                 const ir::ExtractElementInst &inst) {
+    auto rd = func->NewReg();
+    var_map[inst.GetResult().Str()] = rd;
+    func->AddInst(new InsVgetLane(rd, GetQReg(inst.GetVec()), inst.GetIndex()));
 }
 
 }  // namespace backend
@@ -1,7 +1,15 @@
+#include <unistd.h>
+
 #include <iostream>
+#include <string>
 
 #include "backend/backend.h"
+#include "emitter.h"
 #include "frontend/frontend.h"
+#include "opt/if_conversion.h"
+#include "opt/mem2reg.h"
+#include "opt/simplify_cfg.h"
+#include "opt/strength_reduction.h"
 
 int main(int argc, char **argv) {
     if (argc < 2) {
@@ -15,10 +23,38 @@ int main(int argc, char **argv) {
     result = AstToIR();
     if (result != 0) return result;
 
-    result = Assembling();
+    bool peephole_stats = false;
+    for (int i = 2; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "-if-conversion") {
+            opt::IfConversion if_conversion;
+            opt::RunOnModule(if_conversion, *module);
+        } else if (arg == "-strength-reduction") {
+            opt::StrengthReduction strength_reduction;
+            opt::RunOnModule(strength_reduction, *module);
+        } else if (arg == "-mem2reg") {
+            opt::Mem2Reg mem2reg;
+            opt::RunOnModule(mem2reg, *module);
+        } else if (arg == "-simplify-cfg") {
+            opt::SimplifyCFG simplify_cfg;
+            opt::RunOnModule(simplify_cfg, *module);
+        } else if (arg == "-regalloc=coloring") {
+            reg_alloc = &coloring_reg_alloc;
+        } else if (arg == "-regalloc=greedy") {
+            reg_alloc = &greedy_reg_alloc;
+        } else if (arg == "-peephole-stats") {
+            peephole_stats = true;
+        }
+    }
+
+    result = Assembling(*module);
     if (result != 0) return result;
 
-    assembly.Dump(std::cout);
+    std::cout.flush();
+    util::Emitter emitter(STDOUT_FILENO);
+    assembly.Dump(emitter);
+    emitter.Flush();
+    if (peephole_stats) peephole.DumpStatistic(std::cerr);
 
-    return result;
+    return emitter.Good() ? result : 1;
 }
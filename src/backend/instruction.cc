@@ -2,45 +2,161 @@
 
 #include <error.h>
 
+#include <algorithm>
 #include <memory>
+#include <string>
+#include <vector>
 
 #include "backend/operand.h"
 
 namespace backend {
 
+// keep the register operands, skip immediates and labels
+static std::vector<std::shared_ptr<RegOperand>> RegList(
+    std::initializer_list<std::shared_ptr<Operand>> operand_list) {
+    std::vector<std::shared_ptr<RegOperand>> reg_list;
+    for (const auto &operand : operand_list) {
+        if (operand != nullptr && operand->kind == Operand::kReg) {
+            reg_list.emplace_back(std::static_pointer_cast<RegOperand>(operand));
+        }
+    }
+    return reg_list;
+}
+
+static void Replace(std::shared_ptr<RegOperand> &reg,
+                    const std::shared_ptr<RegOperand> &from,
+                    const std::shared_ptr<RegOperand> &to) {
+    if (reg == from) reg = to;
+}
+
+static void Replace(std::shared_ptr<QRegOperand> &reg,
+                    const std::shared_ptr<QRegOperand> &from,
+                    const std::shared_ptr<QRegOperand> &to) {
+    if (reg == from) reg = to;
+}
+
+static void Replace(std::shared_ptr<Operand> &operand,
+                    const std::shared_ptr<RegOperand> &from,
+                    const std::shared_ptr<RegOperand> &to) {
+    if (operand == from) operand = to;
+}
+
+std::string Inst::Str() const {
+    std::string str;
+    util::Emitter emitter(str);
+    Emit(emitter);
+    return str;
+}
+
 void InsMov::CheckImm() const {
     const auto &imm = Rm_imm->Cast<ImmOperand>();
-    if (!(imm.IsImm16() || imm.IsImm8m())) {
+    if (!(imm.IsUImm16() || imm.IsImm8m() || imm.IsInvImm8m())) {
         throw InvalidParameterException(imm.Str()
                                         + " is neither #<imm16> nor #<imm8m>");
     }
 }
 
-std::string InsMov::Str() const {
-    return op_map[op] + cond_map[cond] + " \t" + Rd->Str() + ", "
-           + Rm_imm->Str();
+void InsMov::Emit(util::Emitter &emitter) const {
+    emitter << op_map[op] << cond_map[cond] << " \t" << *Rd << ", " << *Rm_imm;
+}
+
+std::vector<std::shared_ptr<RegOperand>> InsMov::GetUseList() const {
+    return RegList({Rm_imm});
+}
+
+void InsMov::ReplaceReg(const std::shared_ptr<RegOperand> &from,
+                        const std::shared_ptr<RegOperand> &to) {
+    Replace(Rd, from, to);
+    Replace(Rm_imm, from, to);
+}
+
+void InsMvn::Emit(util::Emitter &emitter) const {
+    emitter << op_map[op] << cond_map[cond] << " \t" << *Rd << ", " << *Rm_imm;
+}
+
+std::vector<std::shared_ptr<RegOperand>> InsMvn::GetUseList() const {
+    return RegList({Rm_imm});
+}
+
+void InsMvn::ReplaceReg(const std::shared_ptr<RegOperand> &from,
+                        const std::shared_ptr<RegOperand> &to) {
+    Replace(Rd, from, to);
+    Replace(Rm_imm, from, to);
+}
+
+void InsMvn::CheckImm() const {
+    const auto &imm = Rm_imm->Cast<ImmOperand>();
+    if (!imm.IsImm8m()) {
+        throw InvalidParameterException(imm.Str() + " is not #<imm8m>");
+    }
+}
+
+void InsMovw::Emit(util::Emitter &emitter) const {
+    emitter << op_map[op] << cond_map[cond] << '\t' << *Rd << ", " << *imm16;
 }
 
-std::string InsLdr::Str() const {
-    std::string str = op_map[op] + cond_map[cond] + " \t" + Rd->Str() + ", ";
+void InsMovw::CheckImm() const {
+    if (!imm16->IsUImm16()) {
+        throw InvalidParameterException(imm16->Str() + " is not #<imm16>");
+    }
+}
+
+void InsMovw::ReplaceReg(const std::shared_ptr<RegOperand> &from,
+                         const std::shared_ptr<RegOperand> &to) {
+    Replace(Rd, from, to);
+}
+
+void InsMovt::Emit(util::Emitter &emitter) const {
+    emitter << op_map[op] << cond_map[cond] << '\t' << *Rd << ", " << *imm16;
+}
+
+void InsMovt::CheckImm() const {
+    if (!imm16->IsUImm16()) {
+        throw InvalidParameterException(imm16->Str() + " is not #<imm16>");
+    }
+}
+
+void InsMovt::ReplaceReg(const std::shared_ptr<RegOperand> &from,
+                         const std::shared_ptr<RegOperand> &to) {
+    Replace(Rd, from, to);
+}
+
+void InsLdr::Emit(util::Emitter &emitter) const {
+    emitter << op_map[op] << cond_map[cond] << " \t" << *Rd << ", ";
     switch (Rn_imm_label->kind) {
         case Operand::kReg:
-            if (offset != nullptr) {
-                return str + '[' + Rn_imm_label->Str() + ", " + offset->Str()
-                       + ']';
-            }
-            return str + '[' + Rn_imm_label->Str() + ']';
+            emitter << '[' << *Rn_imm_label;
+            if (offset != nullptr) emitter << ", " << *offset;
+            emitter << ']';
+            break;
+        case Operand::kImm:
+            emitter << '=' << Rn_imm_label->Cast<ImmOperand>().GetValue();
+            break;
         default:
-            return str + '=' + Rn_imm_label->Str();
+            emitter << '=' << *Rn_imm_label;
     }
 }
 
-std::string InsStr::Str() const {
-    std::string str = op_map[op] + cond_map[cond] + " \t" + Rd->Str() + ", ";
-    if (offset != nullptr) {
-        return str + '[' + Rn->Str() + ", " + offset->Str() + ']';
-    }
-    return str + '[' + Rn->Str() + ']';
+std::vector<std::shared_ptr<RegOperand>> InsLdr::GetUseList() const {
+    return RegList({Rn_imm_label});
+}
+
+void InsLdr::ReplaceReg(const std::shared_ptr<RegOperand> &from,
+                        const std::shared_ptr<RegOperand> &to) {
+    Replace(Rd, from, to);
+    Replace(Rn_imm_label, from, to);
+}
+
+void InsStr::Emit(util::Emitter &emitter) const {
+    emitter << op_map[op] << cond_map[cond] << " \t" << *Rd << ", [" << *Rn;
+    if (offset != nullptr) emitter << ", " << *offset;
+    emitter << ']';
+}
+
+void InsStr::ReplaceReg(const std::shared_ptr<RegOperand> &from,
+                        const std::shared_ptr<RegOperand> &to) {
+    Replace(Rd, from, to);
+    Replace(Rn, from, to);
 }
 
 InsPush::InsPush() : Inst(kInsPush) {
@@ -48,13 +164,18 @@ InsPush::InsPush() : Inst(kInsPush) {
     reg_list.emplace_back(new RegOperand(RegOperand::kLr));
 }
 
-std::string InsPush::Str() const {
-    std::string str = op_map[op] + cond_map[cond] + "\t{";
+void InsPush::Emit(util::Emitter &emitter) const {
+    emitter << op_map[op] << cond_map[cond] << "\t{";
     for (auto iter = reg_list.cbegin(); iter != reg_list.cend(); ++iter) {
-        if (iter != reg_list.cbegin()) str += ", ";
-        str += (*iter)->Str();
+        if (iter != reg_list.cbegin()) emitter << ", ";
+        emitter << **iter;
     }
-    return str + '}';
+    emitter << '}';
+}
+
+void InsPush::ReplaceReg(const std::shared_ptr<RegOperand> &from,
+                         const std::shared_ptr<RegOperand> &to) {
+    for (auto &reg : reg_list) Replace(reg, from, to);
 }
 
 InsPop::InsPop() : Inst(kInsPop) {
@@ -62,18 +183,32 @@ InsPop::InsPop() : Inst(kInsPop) {
     reg_list.emplace_back(new RegOperand(RegOperand::kLr));
 }
 
-std::string InsPop::Str() const {
-    std::string str = op_map[op] + cond_map[cond] + " \t{";
+void InsPop::Emit(util::Emitter &emitter) const {
+    emitter << op_map[op] << cond_map[cond] << " \t{";
     for (auto iter = reg_list.cbegin(); iter != reg_list.cend(); ++iter) {
-        if (iter != reg_list.cbegin()) str += ", ";
-        str += (*iter)->Str();
+        if (iter != reg_list.cbegin()) emitter << ", ";
+        emitter << **iter;
     }
-    return str + '}';
+    emitter << '}';
+}
+
+void InsPop::ReplaceReg(const std::shared_ptr<RegOperand> &from,
+                        const std::shared_ptr<RegOperand> &to) {
+    for (auto &reg : reg_list) Replace(reg, from, to);
+}
+
+void InsCmp::Emit(util::Emitter &emitter) const {
+    emitter << op_map[op] << cond_map[cond] << " \t" << *Rn << ", " << *Rm_imm;
 }
 
-std::string InsCmp::Str() const {
-    return op_map[op] + cond_map[cond] + " \t" + Rn->Str() + ", "
-           + Rm_imm->Str();
+std::vector<std::shared_ptr<RegOperand>> InsCmp::GetUseList() const {
+    return RegList({Rn, Rm_imm});
+}
+
+void InsCmp::ReplaceReg(const std::shared_ptr<RegOperand> &from,
+                        const std::shared_ptr<RegOperand> &to) {
+    Replace(Rn, from, to);
+    Replace(Rm_imm, from, to);
 }
 
 void InsCmp::CheckImm() const {
@@ -83,21 +218,62 @@ void InsCmp::CheckImm() const {
     }
 }
 
-std::string InsB::Str() const {
-    return op_map[op] + cond_map[cond] + "   \t" + label->Str();
+void InsB::Emit(util::Emitter &emitter) const {
+    emitter << op_map[op] << cond_map[cond] << "   \t" << *label;
+}
+
+void InsBl::Emit(util::Emitter &emitter) const {
+    emitter << op_map[op] << cond_map[cond] << "  \t" << *label << "(PLT)";
+}
+
+std::vector<std::shared_ptr<RegOperand>> InsBl::GetDefList() const {
+    return {std::make_shared<RegOperand>(0), std::make_shared<RegOperand>(1),
+            std::make_shared<RegOperand>(2), std::make_shared<RegOperand>(3),
+            std::make_shared<RegOperand>(RegOperand::kIp),
+            std::make_shared<RegOperand>(RegOperand::kLr)};
+}
+
+std::vector<std::shared_ptr<QRegOperand>> InsBl::GetQDefList() const {
+    std::vector<std::shared_ptr<QRegOperand>> def_list;
+    for (int i = 0; i < QRegOperand::kPhysNum; ++i) {
+        if (i < 4 || i >= 8) {
+            def_list.emplace_back(std::make_shared<QRegOperand>(i));
+        }
+    }
+    return def_list;
+}
+
+std::vector<std::shared_ptr<RegOperand>> InsBl::GetUseList() const {
+    std::vector<std::shared_ptr<RegOperand>> use_list;
+    for (int i = 0; i < reg_arg_num; ++i) {
+        use_list.emplace_back(std::make_shared<RegOperand>(i));
+    }
+    return use_list;
+}
+
+void InsBx::Emit(util::Emitter &emitter) const {
+    emitter << op_map[op] << cond_map[cond] << "  \t" << *Rm;
 }
 
-std::string InsBl::Str() const {
-    return op_map[op] + cond_map[cond] + "  \t" + label->Str() + "(PLT)";
+void InsBx::ReplaceReg(const std::shared_ptr<RegOperand> &from,
+                       const std::shared_ptr<RegOperand> &to) {
+    Replace(Rm, from, to);
 }
 
-std::string InsBx::Str() const {
-    return op_map[op] + cond_map[cond] + "  \t" + Rm->Str();
+void InsAdd::Emit(util::Emitter &emitter) const {
+    emitter << op_map[op] << cond_map[cond] << " \t" << *Rd << ", " << *Rn
+            << ", " << *Rm_imm;
 }
 
-std::string InsAdd::Str() const {
-    return op_map[op] + cond_map[cond] + " \t" + Rd->Str() + ", " + Rn->Str()
-           + ", " + Rm_imm->Str();
+std::vector<std::shared_ptr<RegOperand>> InsAdd::GetUseList() const {
+    return RegList({Rn, Rm_imm});
+}
+
+void InsAdd::ReplaceReg(const std::shared_ptr<RegOperand> &from,
+                        const std::shared_ptr<RegOperand> &to) {
+    Replace(Rd, from, to);
+    Replace(Rn, from, to);
+    Replace(Rm_imm, from, to);
 }
 
 void InsAdd::CheckImm() const {
@@ -107,9 +283,20 @@ void InsAdd::CheckImm() const {
     }
 }
 
-std::string InsSub::Str() const {
-    return op_map[op] + cond_map[cond] + " \t" + Rd->Str() + ", " + Rn->Str()
-           + ", " + Rm_imm->Str();
+void InsSub::Emit(util::Emitter &emitter) const {
+    emitter << op_map[op] << cond_map[cond] << " \t" << *Rd << ", " << *Rn
+            << ", " << *Rm_imm;
+}
+
+std::vector<std::shared_ptr<RegOperand>> InsSub::GetUseList() const {
+    return RegList({Rn, Rm_imm});
+}
+
+void InsSub::ReplaceReg(const std::shared_ptr<RegOperand> &from,
+                        const std::shared_ptr<RegOperand> &to) {
+    Replace(Rd, from, to);
+    Replace(Rn, from, to);
+    Replace(Rm_imm, from, to);
 }
 
 void InsSub::CheckImm() const {
@@ -119,9 +306,20 @@ void InsSub::CheckImm() const {
     }
 }
 
-std::string InsRsb::Str() const {
-    return op_map[op] + cond_map[cond] + " \t" + Rd->Str() + ", " + Rn->Str()
-           + ", " + Rm_imm->Str();
+void InsRsb::Emit(util::Emitter &emitter) const {
+    emitter << op_map[op] << cond_map[cond] << " \t" << *Rd << ", " << *Rn
+            << ", " << *Rm_imm;
+}
+
+std::vector<std::shared_ptr<RegOperand>> InsRsb::GetUseList() const {
+    return RegList({Rn, Rm_imm});
+}
+
+void InsRsb::ReplaceReg(const std::shared_ptr<RegOperand> &from,
+                        const std::shared_ptr<RegOperand> &to) {
+    Replace(Rd, from, to);
+    Replace(Rn, from, to);
+    Replace(Rm_imm, from, to);
 }
 
 void InsRsb::CheckImm() const {
@@ -131,19 +329,52 @@ void InsRsb::CheckImm() const {
     }
 }
 
-std::string InsMul::Str() const {
-    return op_map[op] + cond_map[cond] + " \t" + Rd->Str() + ", " + Rn->Str()
-           + ", " + Rs->Str();
+void InsMul::Emit(util::Emitter &emitter) const {
+    emitter << op_map[op] << cond_map[cond] << " \t" << *Rd << ", " << *Rn
+            << ", " << *Rs;
+}
+
+std::vector<std::shared_ptr<RegOperand>> InsMul::GetUseList() const {
+    return RegList({Rn, Rs});
+}
+
+void InsMul::ReplaceReg(const std::shared_ptr<RegOperand> &from,
+                        const std::shared_ptr<RegOperand> &to) {
+    Replace(Rd, from, to);
+    Replace(Rn, from, to);
+    Replace(Rs, from, to);
+}
+
+void InsSDiv::Emit(util::Emitter &emitter) const {
+    emitter << op_map[op] << cond_map[cond] << '\t' << *Rd << ", " << *Rn
+            << ", " << *Rs;
 }
 
-std::string InsSDiv::Str() const {
-    return op_map[op] + cond_map[cond] + '\t' + Rd->Str() + ", " + Rn->Str()
-           + ", " + Rs->Str();
+std::vector<std::shared_ptr<RegOperand>> InsSDiv::GetUseList() const {
+    return RegList({Rn, Rs});
 }
 
-std::string InsAnd::Str() const {
-    return op_map[op] + cond_map[cond] + " \t" + Rd->Str() + ", " + Rn->Str()
-           + ", " + Rm_imm->Str();
+void InsSDiv::ReplaceReg(const std::shared_ptr<RegOperand> &from,
+                         const std::shared_ptr<RegOperand> &to) {
+    Replace(Rd, from, to);
+    Replace(Rn, from, to);
+    Replace(Rs, from, to);
+}
+
+void InsAnd::Emit(util::Emitter &emitter) const {
+    emitter << op_map[op] << cond_map[cond] << " \t" << *Rd << ", " << *Rn
+            << ", " << *Rm_imm;
+}
+
+std::vector<std::shared_ptr<RegOperand>> InsAnd::GetUseList() const {
+    return RegList({Rn, Rm_imm});
+}
+
+void InsAnd::ReplaceReg(const std::shared_ptr<RegOperand> &from,
+                        const std::shared_ptr<RegOperand> &to) {
+    Replace(Rd, from, to);
+    Replace(Rn, from, to);
+    Replace(Rm_imm, from, to);
 }
 
 void InsAnd::CheckImm() const {
@@ -153,9 +384,20 @@ void InsAnd::CheckImm() const {
     }
 }
 
-std::string InsOrr::Str() const {
-    return op_map[op] + cond_map[cond] + " \t" + Rd->Str() + ", " + Rn->Str()
-           + ", " + Rm_imm->Str();
+void InsOrr::Emit(util::Emitter &emitter) const {
+    emitter << op_map[op] << cond_map[cond] << " \t" << *Rd << ", " << *Rn
+            << ", " << *Rm_imm;
+}
+
+std::vector<std::shared_ptr<RegOperand>> InsOrr::GetUseList() const {
+    return RegList({Rn, Rm_imm});
+}
+
+void InsOrr::ReplaceReg(const std::shared_ptr<RegOperand> &from,
+                        const std::shared_ptr<RegOperand> &to) {
+    Replace(Rd, from, to);
+    Replace(Rn, from, to);
+    Replace(Rm_imm, from, to);
 }
 
 void InsOrr::CheckImm() const {
@@ -165,7 +407,243 @@ void InsOrr::CheckImm() const {
     }
 }
 
+void InsEor::Emit(util::Emitter &emitter) const {
+    emitter << op_map[op] << cond_map[cond] << " \t" << *Rd << ", " << *Rn
+            << ", " << *Rm_imm;
+}
+
+std::vector<std::shared_ptr<RegOperand>> InsEor::GetUseList() const {
+    return RegList({Rn, Rm_imm});
+}
+
+void InsEor::ReplaceReg(const std::shared_ptr<RegOperand> &from,
+                        const std::shared_ptr<RegOperand> &to) {
+    Replace(Rd, from, to);
+    Replace(Rn, from, to);
+    Replace(Rm_imm, from, to);
+}
+
+void InsEor::CheckImm() const {
+    const auto &imm = Rm_imm->Cast<ImmOperand>();
+    if (!imm.IsImm8m()) {
+        throw InvalidParameterException(imm.Str() + " is not #<imm8m>");
+    }
+}
+
+void InsLsl::Emit(util::Emitter &emitter) const {
+    emitter << op_map[op] << cond_map[cond] << " \t" << *Rd << ", " << *Rm
+            << ", " << *Rs_imm;
+}
+
+std::vector<std::shared_ptr<RegOperand>> InsLsl::GetUseList() const {
+    return RegList({Rm, Rs_imm});
+}
+
+void InsLsl::ReplaceReg(const std::shared_ptr<RegOperand> &from,
+                        const std::shared_ptr<RegOperand> &to) {
+    Replace(Rd, from, to);
+    Replace(Rm, from, to);
+    Replace(Rs_imm, from, to);
+}
+
+void InsLsl::CheckImm() const {
+    const auto &imm = Rs_imm->Cast<ImmOperand>();
+    if (imm.GetValue() < 0 || imm.GetValue() > 31) {
+        throw InvalidParameterException(imm.Str() + " is not #<0-31>");
+    }
+}
+
+void InsAsr::Emit(util::Emitter &emitter) const {
+    emitter << op_map[op] << cond_map[cond] << " \t" << *Rd << ", " << *Rm
+            << ", " << *Rs_imm;
+}
+
+std::vector<std::shared_ptr<RegOperand>> InsAsr::GetUseList() const {
+    return RegList({Rm, Rs_imm});
+}
+
+void InsAsr::ReplaceReg(const std::shared_ptr<RegOperand> &from,
+                        const std::shared_ptr<RegOperand> &to) {
+    Replace(Rd, from, to);
+    Replace(Rm, from, to);
+    Replace(Rs_imm, from, to);
+}
+
+void InsAsr::CheckImm() const {
+    const auto &imm = Rs_imm->Cast<ImmOperand>();
+    if (imm.GetValue() < 1 || imm.GetValue() > 32) {
+        throw InvalidParameterException(imm.Str() + " is not #<1-32>");
+    }
+}
+
+void InsLsr::Emit(util::Emitter &emitter) const {
+    emitter << op_map[op] << cond_map[cond] << " \t" << *Rd << ", " << *Rm
+            << ", " << *Rs_imm;
+}
+
+std::vector<std::shared_ptr<RegOperand>> InsLsr::GetUseList() const {
+    return RegList({Rm, Rs_imm});
+}
+
+void InsLsr::ReplaceReg(const std::shared_ptr<RegOperand> &from,
+                        const std::shared_ptr<RegOperand> &to) {
+    Replace(Rd, from, to);
+    Replace(Rm, from, to);
+    Replace(Rs_imm, from, to);
+}
+
+void InsLsr::CheckImm() const {
+    const auto &imm = Rs_imm->Cast<ImmOperand>();
+    if (imm.GetValue() < 1 || imm.GetValue() > 32) {
+        throw InvalidParameterException(imm.Str() + " is not #<1-32>");
+    }
+}
+
+// the doubleword registers of Qd, as "{d16, d17}"
+static void EmitList(util::Emitter &emitter, const QRegOperand &Qd) {
+    emitter << "{d" << 2 * Qd.GetId() << ", d" << 2 * Qd.GetId() + 1 << '}';
+}
+
+static void CheckLane(const int lane) {
+    if (lane < 0 || lane >= QRegOperand::kLaneNum) {
+        throw InvalidParameterException("lane " + std::to_string(lane)
+                                        + " is not in a q register");
+    }
+}
+
+void InsVld1::Emit(util::Emitter &emitter) const {
+    emitter << op_map[op] << cond_map[cond] << " \t";
+    EmitList(emitter, *Qd);
+    emitter << ", [" << *Rn << ']';
+}
+
+void InsVld1::ReplaceReg(const std::shared_ptr<RegOperand> &from,
+                         const std::shared_ptr<RegOperand> &to) {
+    Replace(Rn, from, to);
+}
+
+void InsVld1::ReplaceQReg(const std::shared_ptr<QRegOperand> &from,
+                          const std::shared_ptr<QRegOperand> &to) {
+    Replace(Qd, from, to);
+}
+
+void InsVst1::Emit(util::Emitter &emitter) const {
+    emitter << op_map[op] << cond_map[cond] << " \t";
+    EmitList(emitter, *Qd);
+    emitter << ", [" << *Rn << ']';
+}
+
+void InsVst1::ReplaceReg(const std::shared_ptr<RegOperand> &from,
+                         const std::shared_ptr<RegOperand> &to) {
+    Replace(Rn, from, to);
+}
+
+void InsVst1::ReplaceQReg(const std::shared_ptr<QRegOperand> &from,
+                          const std::shared_ptr<QRegOperand> &to) {
+    Replace(Qd, from, to);
+}
+
+void InsVadd::Emit(util::Emitter &emitter) const {
+    emitter << op_map[op] << cond_map[cond] << " \t" << *Qd << ", " << *Qn
+            << ", " << *Qm;
+}
+
+void InsVadd::ReplaceQReg(const std::shared_ptr<QRegOperand> &from,
+                          const std::shared_ptr<QRegOperand> &to) {
+    Replace(Qd, from, to);
+    Replace(Qn, from, to);
+    Replace(Qm, from, to);
+}
+
+void InsVsub::Emit(util::Emitter &emitter) const {
+    emitter << op_map[op] << cond_map[cond] << " \t" << *Qd << ", " << *Qn
+            << ", " << *Qm;
+}
+
+void InsVsub::ReplaceQReg(const std::shared_ptr<QRegOperand> &from,
+                          const std::shared_ptr<QRegOperand> &to) {
+    Replace(Qd, from, to);
+    Replace(Qn, from, to);
+    Replace(Qm, from, to);
+}
+
+void InsVmul::Emit(util::Emitter &emitter) const {
+    emitter << op_map[op] << cond_map[cond] << " \t" << *Qd << ", " << *Qn
+            << ", " << *Qm;
+}
+
+void InsVmul::ReplaceQReg(const std::shared_ptr<QRegOperand> &from,
+                          const std::shared_ptr<QRegOperand> &to) {
+    Replace(Qd, from, to);
+    Replace(Qn, from, to);
+    Replace(Qm, from, to);
+}
+
+void InsVdup::Emit(util::Emitter &emitter) const {
+    emitter << op_map[op] << cond_map[cond] << " \t" << *Qd << ", " << *Rm;
+}
+
+void InsVdup::ReplaceReg(const std::shared_ptr<RegOperand> &from,
+                         const std::shared_ptr<RegOperand> &to) {
+    Replace(Rm, from, to);
+}
+
+void InsVdup::ReplaceQReg(const std::shared_ptr<QRegOperand> &from,
+                          const std::shared_ptr<QRegOperand> &to) {
+    Replace(Qd, from, to);
+}
+
+void InsVmov::Emit(util::Emitter &emitter) const {
+    emitter << op_map[op] << cond_map[cond] << " \t" << *Qd << ", " << *Qm;
+}
+
+void InsVmov::ReplaceQReg(const std::shared_ptr<QRegOperand> &from,
+                          const std::shared_ptr<QRegOperand> &to) {
+    Replace(Qd, from, to);
+    Replace(Qm, from, to);
+}
+
+void InsVsetLane::Emit(util::Emitter &emitter) const {
+    emitter << op_map[op] << cond_map[cond] << " \t";
+    Qd->EmitLane(emitter, lane);
+    emitter << ", " << *Rm;
+}
+
+void InsVsetLane::ReplaceReg(const std::shared_ptr<RegOperand> &from,
+                             const std::shared_ptr<RegOperand> &to) {
+    Replace(Rm, from, to);
+}
+
+void InsVsetLane::ReplaceQReg(const std::shared_ptr<QRegOperand> &from,
+                              const std::shared_ptr<QRegOperand> &to) {
+    Replace(Qd, from, to);
+}
+
+void InsVsetLane::CheckLane() const { backend::CheckLane(lane); }
+
+void InsVgetLane::Emit(util::Emitter &emitter) const {
+    emitter << op_map[op] << cond_map[cond] << " \t" << *Rd << ", ";
+    Qn->EmitLane(emitter, lane);
+}
+
+void InsVgetLane::ReplaceReg(const std::shared_ptr<RegOperand> &from,
+                             const std::shared_ptr<RegOperand> &to) {
+    Replace(Rd, from, to);
+}
+
+void InsVgetLane::ReplaceQReg(const std::shared_ptr<QRegOperand> &from,
+                              const std::shared_ptr<QRegOperand> &to) {
+    Replace(Qn, from, to);
+}
+
+void InsVgetLane::CheckLane() const { backend::CheckLane(lane); }
+
 void GlobalVar::Dump(std::ostream &os) const {
+    util::Emitter emitter(os);
+    Dump(emitter);
+}
+
+void GlobalVar::Dump(util::Emitter &os) const {
     os << '\n';
     os << "    .global " << name << '\n';
     os << "    .type " << name << ", %object\n";
@@ -186,36 +664,315 @@ void GlobalVar::Dump(std::ostream &os) const {
     if (space != 0) os << "    .space " << space << '\n';
 }
 
-void Function::GetReg(int id) {
-    auto name = reg_state[id];
-    if (name.empty()) return;
+using InstList = std::list<std::shared_ptr<Inst>>;
+
+// build value in reg before pos
+static void BuildImm(InstList &inst_list,
+                     const InstList::iterator pos,
+                     const std::shared_ptr<RegOperand> &reg,
+                     const std::int32_t value) {
+    auto imm = std::make_shared<ImmOperand>(value);
+    if (imm->IsImm8m()) {
+        inst_list.emplace(pos, new InsMov(reg, imm));
+        return;
+    }
+    if (imm->IsInvImm8m()) {
+        inst_list.emplace(pos,
+                          new InsMvn(reg, std::make_shared<ImmOperand>(~value)));
+        return;
+    }
+    auto bits = static_cast<std::uint32_t>(value);
+    inst_list.emplace(pos, new InsMovw(reg, std::make_shared<ImmOperand>(
+                                                static_cast<std::int32_t>(
+                                                    bits & 0xffff))));
+    if ((bits >> 16) != 0) {
+        inst_list.emplace(pos,
+                          new InsMovt(reg, std::make_shared<ImmOperand>(
+                                               static_cast<std::int32_t>(
+                                                   bits >> 16))));
+    }
+}
+
+void Function::LoadImm(const std::shared_ptr<RegOperand> &reg,
+                       const std::int32_t value) {
+    BuildImm(inst_list, inst_list.end(), reg, value);
+}
+
+// ldr rX, =<literal>
+static bool UsePool(const Inst &inst) {
+    if (inst.op != Inst::kInsLdr) return false;
+    const auto &ldr = inst.Cast<InsLdr>();
+    return ldr.GetRnImmLabel()->kind != Operand::kReg;
+}
+
+// the next instruction can only be reached by a jump
+static bool IsBarrier(const Inst &inst) {
+    if (inst.cond != Inst::kAL) return false;
+    switch (inst.op) {
+        case Inst::kInsB:
+        case Inst::kInsBx:
+            return true;
+        case Inst::kInsPop:
+            for (const auto &reg : inst.GetDefList()) {
+                if (reg->GetId() == RegOperand::kPc) return true;
+            }
+            return false;
+        default:
+            return false;
+    }
+}
 
-    auto reg = std::make_shared<RegOperand>(id);
-    reg_state[id] = "";
-    var_state[name] = -1;
+int Function::PlaceLiteralPool() {
+    int pool_cnt = 0;
+    int literal_cnt = 0;  // pending literals
+    int distance = 0;     // instructions since the first pending literal
+    auto barrier = inst_list.end();  // last place to drop the pool at
+
+    for (auto iter = inst_list.begin(); iter != inst_list.end();) {
+        if (literal_cnt != 0 && distance + literal_cnt >= kPoolRange) {
+            if (barrier != inst_list.end()) {
+                // rescan what follows the pool
+                iter = inst_list.emplace(barrier, new InsLtorg);
+                ++iter;
+            } else {
+                // no safe place, jump over the pool
+                auto label = std::make_shared<LabelOperand>(
+                    '.' + name + "_pool" + std::to_string(pool_cnt));
+                inst_list.emplace(iter, new InsB(label));
+                inst_list.emplace(iter, new InsLtorg);
+                inst_list.emplace(iter, new InsLabel(label));
+            }
+            ++pool_cnt;
+            literal_cnt = 0;
+            distance = 0;
+            barrier = inst_list.end();
+            continue;
+        }
+
+        const auto &inst = **iter;
+        ++iter;
+        if (inst.op == Inst::kInsLtorg) {
+            literal_cnt = 0;
+            distance = 0;
+            barrier = inst_list.end();
+            continue;
+        }
+        if (inst.op == Inst::kInsLabel) continue;
+        if (UsePool(inst)) ++literal_cnt;
+        if (literal_cnt == 0) continue;
+        ++distance;
+        if (IsBarrier(inst)) barrier = iter;
+    }
+
+    if (literal_cnt != 0) {
+        inst_list.emplace_back(new InsLtorg);
+        ++pool_cnt;
+    }
+    return pool_cnt;
+}
+
+int Function::AddStackObject(const int size) {
+    object_list.push_back({size, 0, -1});
+    return static_cast<int>(object_list.size()) - 1;
+}
+
+int Function::AddIncomingArg(const int index) {
+    object_list.push_back({4, 0, index});
+    return static_cast<int>(object_list.size()) - 1;
+}
+
+std::shared_ptr<Inst> Function::FrameInst(
+    const FrameKind kind,
+    const std::shared_ptr<RegOperand> &reg,
+    const int object,
+    const int offset) {
+    auto sp = std::make_shared<RegOperand>(RegOperand::kSp);
+    auto zero = std::make_shared<ImmOperand>(0);
+    std::shared_ptr<Inst> inst;
+    switch (kind) {
+        case kFrameLoad:
+            inst = std::make_shared<InsLdr>(reg, sp, zero);
+            break;
+        case kFrameStore:
+            inst = std::make_shared<InsStr>(reg, sp, zero);
+            break;
+        case kFrameAddr:
+            inst = std::make_shared<InsAdd>(reg, sp, zero);
+            break;
+    }
+    frame_ref_map.emplace(inst.get(), FrameRef{kind, object, offset});
+    return inst;
+}
 
-    auto result = stack_state.find(name);
-    if (result == stack_state.end()) {
-        stack_state[name] = stack_state.size();
-        inst_list.emplace_back(new InsPush({reg}));
+// sp += value, through ip when value is too large
+static void AdjustSp(InstList &inst_list,
+                     const InstList::iterator pos,
+                     const int value) {
+    if (value == 0) return;
+    auto sp = std::make_shared<RegOperand>(RegOperand::kSp);
+    auto imm = std::make_shared<ImmOperand>(value < 0 ? -value : value);
+    if (imm->IsImm8m()) {
+        if (value < 0) {
+            inst_list.emplace(pos, new InsSub(sp, sp, imm));
+        } else {
+            inst_list.emplace(pos, new InsAdd(sp, sp, imm));
+        }
+        return;
+    }
+    auto ip = std::make_shared<RegOperand>(RegOperand::kIp);
+    BuildImm(inst_list, pos, ip, imm->GetValue());
+    if (value < 0) {
+        inst_list.emplace(pos, new InsSub(sp, sp, ip));
     } else {
-        auto sp = std::make_shared<RegOperand>(RegOperand::kSp);
-        auto offset = std::make_shared<ImmOperand>(
-            4 * (stack_state.size() - result->second));
-        inst_list.emplace_back(new InsStr(reg, sp, offset));
+        inst_list.emplace(pos, new InsAdd(sp, sp, ip));
     }
 }
 
+// ldr/str reach sp +/- 4095
+static bool IsMemOffset(const int offset) {
+    return -4095 <= offset && offset <= 4095;
+}
+
+void Function::LowerFrame() {
+    bool has_call = false;
+    std::vector<bool> is_saved(RegOperand::kFp + 1, false);
+    for (const auto &inst : inst_list) {
+        if (inst->op == Inst::kInsBl) has_call = true;
+        for (const auto &reg : inst->GetDefList()) {
+            if (4 <= reg->GetId() && reg->GetId() <= RegOperand::kFp) {
+                is_saved[reg->GetId()] = true;
+            }
+        }
+    }
+    std::vector<std::shared_ptr<RegOperand>> push_list;
+    for (int id = 4; id <= RegOperand::kFp; ++id) {
+        if (is_saved[id]) push_list.emplace_back(new RegOperand(id));
+    }
+    std::vector<std::shared_ptr<RegOperand>> pop_list = push_list;
+    if (has_call) {
+        push_list.emplace_back(new RegOperand(RegOperand::kLr));
+        pop_list.emplace_back(new RegOperand(RegOperand::kPc));
+    }
+    const int push_size = static_cast<int>(push_list.size()) * 4;
+
+    // small objects first, so that scalars stay in reach of ldr/str
+    std::vector<int> local_list;
+    for (int i = 0; i < object_list.size(); ++i) {
+        if (object_list[i].arg_index < 0) local_list.push_back(i);
+    }
+    std::stable_sort(local_list.begin(), local_list.end(),
+                     [this](const int lhs, const int rhs) {
+                         return object_list[lhs].size < object_list[rhs].size;
+                     });
+    int offset = call_arg_size;
+    for (int i : local_list) {
+        object_list[i].offset = offset;
+        offset += object_list[i].size;
+    }
+    // keep sp 8-byte aligned
+    frame_size = (offset + push_size + 7) / 8 * 8 - push_size;
+    for (auto &object : object_list) {
+        if (object.arg_index >= 0) {
+            object.offset = frame_size + push_size + (object.arg_index - 4) * 4;
+        }
+    }
+
+    auto sp = std::make_shared<RegOperand>(RegOperand::kSp);
+    auto ip = std::make_shared<RegOperand>(RegOperand::kIp);
+    for (auto iter = inst_list.begin(); iter != inst_list.end();) {
+        auto &inst = **iter;
+        auto ref = frame_ref_map.find(&inst);
+        if (ref != frame_ref_map.end()) {
+            const int pos
+                = object_list[ref->second.object].offset + ref->second.offset;
+            switch (ref->second.kind) {
+                case kFrameLoad: {
+                    const auto &Rd = inst.Cast<InsLdr>().GetRd();
+                    if (IsMemOffset(pos)) {
+                        inst_list.emplace(
+                            iter,
+                            new InsLdr(Rd, sp, std::make_shared<ImmOperand>(pos)));
+                    } else {
+                        BuildImm(inst_list, iter, ip, pos);
+                        inst_list.emplace(iter, new InsAdd(ip, sp, ip));
+                        inst_list.emplace(iter, new InsLdr(Rd, ip));
+                    }
+                    break;
+                }
+                case kFrameStore: {
+                    const auto &Rd = inst.Cast<InsStr>().GetRd();
+                    if (IsMemOffset(pos)) {
+                        inst_list.emplace(
+                            iter,
+                            new InsStr(Rd, sp, std::make_shared<ImmOperand>(pos)));
+                    } else {
+                        BuildImm(inst_list, iter, ip, pos);
+                        inst_list.emplace(iter, new InsAdd(ip, sp, ip));
+                        inst_list.emplace(iter, new InsStr(Rd, ip));
+                    }
+                    break;
+                }
+                case kFrameAddr: {
+                    const auto &Rd = inst.Cast<InsAdd>().GetRd();
+                    auto imm = std::make_shared<ImmOperand>(pos);
+                    if (imm->IsImm8m()) {
+                        inst_list.emplace(iter, new InsAdd(Rd, sp, imm));
+                    } else {
+                        BuildImm(inst_list, iter, Rd, pos);
+                        inst_list.emplace(iter, new InsAdd(Rd, sp, Rd));
+                    }
+                    break;
+                }
+            }
+            iter = inst_list.erase(iter);
+            continue;
+        }
+
+        // epilogue
+        if (inst.op == Inst::kInsBx && inst.cond == Inst::kAL
+            && inst.Cast<InsBx>().GetRm()->GetId() == RegOperand::kLr) {
+            AdjustSp(inst_list, iter, frame_size);
+            if (has_call) {
+                inst_list.emplace(iter, new InsPop(pop_list));
+                iter = inst_list.erase(iter);
+                continue;
+            }
+            if (!pop_list.empty()) {
+                inst_list.emplace(iter, new InsPop(pop_list));
+            }
+        }
+        ++iter;
+    }
+    frame_ref_map.clear();
+
+    // prologue
+    auto begin = inst_list.begin();
+    if (!push_list.empty()) inst_list.emplace(begin, new InsPush(push_list));
+    AdjustSp(inst_list, begin, -frame_size);
+}
+
 void Function::Dump(std::ostream &os) const {
+    util::Emitter emitter(os);
+    Dump(emitter);
+}
+
+void Function::Dump(util::Emitter &os) const {
     os << '\n';
     os << "    .global " << name << '\n';
     os << "    .type " << name << ", %function\n";
     os << name << ":\n";
-    for (const auto &ins : inst_list) { os << ins->Str() << '\n'; }
+    for (const auto &ins : inst_list) { os << *ins << '\n'; }
 }
 
 void Assembly::Dump(std::ostream &os) const {
+    util::Emitter emitter(os);
+    Dump(emitter);
+}
+
+void Assembly::Dump(util::Emitter &os) const {
     os << "    .arch armv7-a\n";
+    os << "    .arch_extension idiv\n";
+    os << "    .fpu neon\n";
     os << "\n    .data\n";
     for (const auto &var : var_list) { var->Dump(os); }
     os << "\n    .text\n";
@@ -6,22 +6,35 @@
 
 namespace backend {
 
-std::string RegOperand::Str() const {
+std::string Operand::Str() const {
+    std::string str;
+    util::Emitter emitter(str);
+    Emit(emitter);
+    return str;
+}
+
+void RegOperand::Emit(util::Emitter &emitter) const {
     switch (id) {
         case kFp:
-            return "fp";
+            emitter << "fp";
+            break;
         case kIp:
-            return "ip";
+            emitter << "ip";
+            break;
         case kSp:
-            return "sp";
+            emitter << "sp";
+            break;
         case kLr:
-            return "lr";
+            emitter << "lr";
+            break;
         case kPc:
-            return "pc";
+            emitter << "pc";
+            break;
         case kCpsr:
-            return "cpsr";
+            emitter << "cpsr";
+            break;
         default:
-            return 'r' + std::to_string(id);
+            emitter << 'r' << id;
     }
 }
 
@@ -33,11 +46,22 @@ void RegOperand::CheckId() const {
     }
 }
 
-bool ImmOperand::CheckImm8m() const {
-    std::uint32_t n = value;
+void QRegOperand::EmitLane(util::Emitter &emitter, const int lane) const {
+    emitter << 'd' << 2 * id + lane / 2 << '[' << lane % 2 << ']';
+}
+
+void QRegOperand::CheckId() const {
+    if (id < 0) {
+        throw InvalidParameterValueException(
+            __FILE__, __LINE__, "QRegOperand::QRegOperand(const int id)", "id",
+            std::to_string(id));
+    }
+}
+
+bool ImmOperand::CheckImm8m(const std::uint32_t n) {
     std::uint32_t window = 0xff;
-    for (uint i = 0; i < 0xf; ++i) {
-        if ((n & ~window) == 0 || (n | window) == 0xffffffff) return true;
+    for (int i = 0; i < 16; ++i) {
+        if ((n & ~window) == 0) return true;
         window = (window >> 2) | (window << (32 - 2));
     }
     return false;
@@ -0,0 +1,109 @@
+#include "backend/out_of_ssa.h"
+
+#include <iterator>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "backend/instruction.h"
+#include "backend/operand.h"
+#include "ir/ir.h"
+#include "ir/type.h"
+#include "ir/value.h"
+
+namespace backend {
+
+int SplitPhiEdge(ir::FuncDef &func) {
+    std::unordered_map<std::string, std::shared_ptr<ir::BasicBlock>> block_map;
+    for (const auto &bb : func.GetBlockList()) {
+        block_map[bb->GetLabel().Str()] = bb;
+    }
+    auto has_phi = [&block_map](const ir::Var &label) {
+        auto iter = block_map.find(label.Str());
+        if (iter == block_map.end()) return false;
+        const auto &inst_list = iter->second->GetInstList();
+        return !inst_list.empty() && inst_list.front()->kind == ir::Inst::kPhi;
+    };
+
+    int split_num = 0;
+    auto &block_list = func.GetBlockList();
+    for (auto iter = block_list.begin(); iter != block_list.end(); ++iter) {
+        const auto bb = *iter;
+        auto &inst_list = bb->GetInstList();
+        if (inst_list.empty() || inst_list.back()->kind != ir::Inst::kBr) {
+            continue;
+        }
+        auto &br = inst_list.back()->Cast<ir::BrInst>();
+        if (br.HasDest()) continue;
+
+        for (const bool if_true : {true, false}) {
+            const auto &target = if_true ? br.GetTrue() : br.GetFalse();
+            if (!has_phi(target)) continue;
+            auto &phi_block = block_map.at(target.Str());
+            auto label = std::make_shared<ir::TmpVar>(
+                std::make_shared<ir::LabelType>(), -1);
+            auto edge = std::make_shared<ir::BasicBlock>(label);
+            edge->AddInst(std::make_shared<ir::BrInst>(
+                phi_block->GetLabelPtr()));
+            // the first entry for bb, a second one belongs to the other edge
+            for (const auto &inst : phi_block->GetInstList()) {
+                if (inst->kind != ir::Inst::kPhi) break;
+                for (auto &value : inst->Cast<ir::PhiInst>().GetValueList()) {
+                    if (value.label->Str() == bb->GetLabel().Str()) {
+                        value.label = label;
+                        break;
+                    }
+                }
+            }
+            if (if_true) {
+                br.SetTrue(label);
+            } else {
+                br.SetFalse(label);
+            }
+            iter = block_list.insert(std::next(iter), edge);
+            ++split_num;
+        }
+    }
+    if (split_num != 0) func.Renumber();
+    return split_num;
+}
+
+void SequentializeCopy(Function &func, ParallelCopy copy) {
+    std::shared_ptr<RegOperand> scratch;
+    for (auto iter = copy.begin(); iter != copy.end();) {
+        if (iter->first->GetId() == iter->second->GetId()) {
+            iter = copy.erase(iter);
+        } else {
+            ++iter;
+        }
+    }
+    while (!copy.empty()) {
+        // a copy whose destination nothing reads any more
+        bool ready = false;
+        for (auto iter = copy.begin(); iter != copy.end(); ++iter) {
+            const int dst = iter->first->GetId();
+            bool read = false;
+            for (const auto &other : copy) {
+                read = read || other.second->GetId() == dst;
+            }
+            if (read) continue;
+            func.AddInst(std::make_shared<InsMov>(iter->first, iter->second));
+            copy.erase(iter);
+            ready = true;
+            break;
+        }
+        if (ready) continue;
+
+        // all cycles, free the first destination
+        const auto dst = copy.front().first;
+        if (scratch == nullptr) scratch = func.NewReg();
+        func.AddInst(std::make_shared<InsMov>(scratch, dst));
+        for (auto &other : copy) {
+            if (other.second->GetId() == dst->GetId()) other.second = scratch;
+        }
+    }
+}
+
+}  // namespace backend
@@ -0,0 +1,381 @@
+#include "backend/peephole.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <iterator>
+#include <memory>
+#include <string>
+
+#include "backend/instruction.h"
+#include "backend/operand.h"
+
+namespace backend {
+
+Peephole::Peephole() {
+    AddRule("redundant-mov", 1, RedundantMov);
+    AddRule("store-load", 2, StoreLoad);
+    AddRule("redundant-label-load", 16, RedundantLabelLoad);
+    AddRule("branch-to-next", 4, BranchToNext);
+    AddRule("invert-branch", 3, InvertBranch);
+    AddRule("zero-add-sub", 1, ZeroAddSub);
+    AddRule("predicate", 2 * kMaxPredicated + 4, Predicate);
+}
+
+void Peephole::AddRule(const std::string &name,
+                       const int window,
+                       const Matcher matcher) {
+    rule_list.push_back({name, window, matcher, 0});
+}
+
+int Peephole::Run(Function &func) {
+    auto &inst_list = func.GetInstList();
+    int total = 0;
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (auto iter = inst_list.begin(); iter != inst_list.end();) {
+            bool fired = false;
+            for (auto &rule : rule_list) {
+                if (rule.matcher(inst_list, iter, rule.window)) {
+                    ++rule.count;
+                    ++total;
+                    fired = true;
+                    break;
+                }
+            }
+            // look at the same position again after a rewrite
+            if (fired) {
+                changed = true;
+                continue;
+            }
+            ++iter;
+        }
+    }
+    return total;
+}
+
+int Peephole::GetCount(const std::string &name) const {
+    for (const auto &rule : rule_list) {
+        if (rule.name == name) return rule.count;
+    }
+    return 0;
+}
+
+void Peephole::ClearStatistic() {
+    for (auto &rule : rule_list) rule.count = 0;
+}
+
+void Peephole::DumpStatistic(std::ostream &os) const {
+    for (const auto &rule : rule_list) {
+        os << std::setw(24) << std::left << rule.name << rule.count << '\n';
+    }
+}
+
+static bool SameReg(const std::shared_ptr<RegOperand> &lhs,
+                    const std::shared_ptr<RegOperand> &rhs) {
+    return lhs->GetId() == rhs->GetId();
+}
+
+static int OffsetValue(const std::shared_ptr<ImmOperand> &offset) {
+    return offset == nullptr ? 0 : offset->GetValue();
+}
+
+static bool Defines(const Inst &inst, const std::shared_ptr<RegOperand> &reg) {
+    for (const auto &def : inst.GetDefList()) {
+        if (SameReg(def, reg)) return true;
+    }
+    return false;
+}
+
+bool RedundantMov(Peephole::InstList &inst_list,
+                  Peephole::InstList::iterator &iter,
+                  const int window) {
+    if ((*iter)->op != Inst::kInsMov) return false;
+    auto &mov = (*iter)->Cast<InsMov>();
+    if (mov.GetRmImm()->kind != Operand::kReg) return false;
+    if (!SameReg(mov.GetRd(),
+                 std::static_pointer_cast<RegOperand>(mov.GetRmImm()))) {
+        return false;
+    }
+    iter = inst_list.erase(iter);
+    return true;
+}
+
+bool StoreLoad(Peephole::InstList &inst_list,
+               Peephole::InstList::iterator &iter,
+               const int window) {
+    if ((*iter)->op != Inst::kInsStr || (*iter)->cond != Inst::kAL) {
+        return false;
+    }
+    auto next = std::next(iter);
+    if (next == inst_list.end() || (*next)->op != Inst::kInsLdr
+        || (*next)->cond != Inst::kAL) {
+        return false;
+    }
+    auto &str = (*iter)->Cast<InsStr>();
+    auto &ldr = (*next)->Cast<InsLdr>();
+    if (ldr.GetRnImmLabel()->kind != Operand::kReg) return false;
+    if (!SameReg(str.GetRn(),
+                 std::static_pointer_cast<RegOperand>(ldr.GetRnImmLabel()))
+        || OffsetValue(str.GetOffset()) != OffsetValue(ldr.GetOffset())) {
+        return false;
+    }
+    if (SameReg(str.GetRd(), ldr.GetRd())) {
+        inst_list.erase(next);
+    } else {
+        *next = std::make_shared<InsMov>(ldr.GetRd(), str.GetRd());
+    }
+    return true;
+}
+
+bool RedundantLabelLoad(Peephole::InstList &inst_list,
+                        Peephole::InstList::iterator &iter,
+                        const int window) {
+    if ((*iter)->op != Inst::kInsLdr || (*iter)->cond != Inst::kAL) {
+        return false;
+    }
+    auto &ldr = (*iter)->Cast<InsLdr>();
+    if (ldr.GetRnImmLabel()->kind != Operand::kLabel) return false;
+    const auto &name = ldr.GetRnImmLabel()->Cast<LabelOperand>().GetName();
+
+    auto next = std::next(iter);
+    for (int i = 1; i < window && next != inst_list.end(); ++i, ++next) {
+        auto &inst = **next;
+        if (inst.op == Inst::kInsLabel || inst.op == Inst::kInsB
+            || inst.op == Inst::kInsBl || inst.op == Inst::kInsBx) {
+            return false;
+        }
+        if (inst.op == Inst::kInsLdr && inst.cond == Inst::kAL) {
+            auto &other = inst.Cast<InsLdr>();
+            if (SameReg(other.GetRd(), ldr.GetRd())
+                && other.GetRnImmLabel()->kind == Operand::kLabel
+                && other.GetRnImmLabel()->Cast<LabelOperand>().GetName()
+                       == name) {
+                inst_list.erase(next);
+                return true;
+            }
+        }
+        if (Defines(inst, ldr.GetRd())) return false;
+    }
+    return false;
+}
+
+bool BranchToNext(Peephole::InstList &inst_list,
+                  Peephole::InstList::iterator &iter,
+                  const int window) {
+    if ((*iter)->op != Inst::kInsB) return false;
+    const auto &name = (*iter)->Cast<InsB>().GetLabel()->GetName();
+    auto next = std::next(iter);
+    for (int i = 1; i < window && next != inst_list.end()
+                    && (*next)->op == Inst::kInsLabel;
+         ++i, ++next) {
+        if ((*next)->Cast<InsLabel>().GetLabel()->GetName() == name) {
+            iter = inst_list.erase(iter);
+            return true;
+        }
+    }
+    return false;
+}
+
+static Inst::CondKind InvertCond(const Inst::CondKind cond) {
+    switch (cond) {
+        case Inst::kEQ:
+            return Inst::kNE;
+        case Inst::kNE:
+            return Inst::kEQ;
+        case Inst::kGT:
+            return Inst::kLE;
+        case Inst::kGE:
+            return Inst::kLT;
+        case Inst::kLT:
+            return Inst::kGE;
+        case Inst::kLE:
+            return Inst::kGT;
+        case Inst::kHI:
+            return Inst::kLS;
+        case Inst::kHS:
+            return Inst::kLO;
+        case Inst::kLO:
+            return Inst::kHS;
+        case Inst::kLS:
+            return Inst::kHI;
+        default:
+            return cond;
+    }
+}
+
+bool InvertBranch(Peephole::InstList &inst_list,
+                  Peephole::InstList::iterator &iter,
+                  const int window) {
+    if ((*iter)->op != Inst::kInsB || (*iter)->cond == Inst::kAL) {
+        return false;
+    }
+    auto jump = std::next(iter);
+    if (jump == inst_list.end() || (*jump)->op != Inst::kInsB
+        || (*jump)->cond != Inst::kAL) {
+        return false;
+    }
+    const auto &name = (*iter)->Cast<InsB>().GetLabel()->GetName();
+    auto next = std::next(jump);
+    for (int i = 2; i < window && next != inst_list.end()
+                    && (*next)->op == Inst::kInsLabel;
+         ++i, ++next) {
+        if ((*next)->Cast<InsLabel>().GetLabel()->GetName() == name) {
+            *iter = std::make_shared<InsB>((*jump)->Cast<InsB>().GetLabel(),
+                                           InvertCond((*iter)->cond));
+            inst_list.erase(jump);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ZeroAddSub(Peephole::InstList &inst_list,
+                Peephole::InstList::iterator &iter,
+                const int window) {
+    std::shared_ptr<RegOperand> Rd;
+    std::shared_ptr<RegOperand> Rn;
+    std::shared_ptr<Operand> Rm_imm;
+    if ((*iter)->op == Inst::kInsAdd) {
+        auto &add = (*iter)->Cast<InsAdd>();
+        Rd = add.GetRd();
+        Rn = add.GetRn();
+        Rm_imm = add.GetRmImm();
+    } else if ((*iter)->op == Inst::kInsSub) {
+        auto &sub = (*iter)->Cast<InsSub>();
+        Rd = sub.GetRd();
+        Rn = sub.GetRn();
+        Rm_imm = sub.GetRmImm();
+    } else {
+        return false;
+    }
+    if (Rm_imm->kind != Operand::kImm
+        || Rm_imm->Cast<ImmOperand>().GetValue() != 0 || !SameReg(Rd, Rn)) {
+        return false;
+    }
+    iter = inst_list.erase(iter);
+    return true;
+}
+
+static bool CanPredicate(const Inst &inst) {
+    if (inst.cond != Inst::kAL) return false;
+    switch (inst.op) {
+        case Inst::kInsMov:
+        case Inst::kInsMvn:
+        case Inst::kInsMovw:
+        case Inst::kInsMovt:
+        case Inst::kInsLdr:
+        case Inst::kInsStr:
+        case Inst::kInsAdd:
+        case Inst::kInsSub:
+        case Inst::kInsRsb:
+        case Inst::kInsMul:
+        case Inst::kInsSDiv:
+        case Inst::kInsAnd:
+        case Inst::kInsOrr:
+        case Inst::kInsEor:
+        case Inst::kInsLsl:
+        case Inst::kInsAsr:
+        case Inst::kInsLsr:
+            return true;
+        default:
+            return false;
+    }
+}
+
+static bool IsBranchTarget(const Peephole::InstList &inst_list,
+                           const std::string &name) {
+    for (const auto &inst : inst_list) {
+        if (inst->op == Inst::kInsB
+            && inst->Cast<InsB>().GetLabel()->GetName() == name) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Return the end of the run of predicable instructions from iter on. The run
+// has no more than kMaxPredicated of them, and may pass labels nothing jumps
+// to, which the blocks falling through start with.
+static Peephole::InstList::iterator PredicableEnd(
+    Peephole::InstList &inst_list,
+    Peephole::InstList::iterator iter,
+    const int window) {
+    int count = 0;
+    for (int i = 0; i < window && iter != inst_list.end(); ++i, ++iter) {
+        if ((*iter)->op == Inst::kInsLabel) {
+            const auto &name = (*iter)->Cast<InsLabel>().GetLabel()->GetName();
+            if (IsBranchTarget(inst_list, name)) break;
+        } else if (count == kMaxPredicated || !CanPredicate(**iter)) {
+            break;
+        } else {
+            ++count;
+        }
+    }
+    return iter;
+}
+
+static bool IsLabel(const Peephole::InstList::iterator &iter,
+                    const Peephole::InstList &inst_list,
+                    const std::string &name) {
+    return iter != inst_list.end() && (*iter)->op == Inst::kInsLabel
+           && (*iter)->Cast<InsLabel>().GetLabel()->GetName() == name;
+}
+
+static void SetCond(Peephole::InstList::iterator first,
+                    const Peephole::InstList::iterator &last,
+                    const Inst::CondKind cond) {
+    for (; first != last; ++first) (*first)->cond = cond;
+}
+
+bool Predicate(Peephole::InstList &inst_list,
+               Peephole::InstList::iterator &iter,
+               const int window) {
+    if ((*iter)->op != Inst::kInsB || (*iter)->cond == Inst::kAL) {
+        return false;
+    }
+    const auto cond = (*iter)->cond;
+    const auto &name = (*iter)->Cast<InsB>().GetLabel()->GetName();
+    auto then_begin = std::next(iter);
+    auto then_end = PredicableEnd(inst_list, then_begin, window - 2);
+    if (then_end == then_begin) return false;
+
+    // b<cond> L; <then>; L:
+    if (IsLabel(then_end, inst_list, name)) {
+        SetCond(then_begin, then_end, InvertCond(cond));
+        iter = inst_list.erase(iter);
+        return true;
+    }
+
+    // b<cond> L1; <then>; b L2; L1: <else>; L2:
+    if (then_end == inst_list.end() || (*then_end)->op != Inst::kInsB
+        || (*then_end)->cond != Inst::kAL) {
+        return false;
+    }
+    auto else_label = std::next(then_end);
+    if (!IsLabel(else_label, inst_list, name)) return false;
+    const auto join = (*then_end)->Cast<InsB>().GetLabel()->GetName();
+    const int used = std::distance(iter, else_label) + 1;
+    auto else_begin = std::next(else_label);
+    auto else_end = PredicableEnd(inst_list, else_begin, window - used - 1);
+    if (else_end == else_begin || !IsLabel(else_end, inst_list, join)) {
+        return false;
+    }
+    // nothing else may jump into the else arm
+    int jump_num = 0;
+    for (const auto &inst : inst_list) {
+        if (inst->op == Inst::kInsB
+            && inst->Cast<InsB>().GetLabel()->GetName() == name) {
+            ++jump_num;
+        }
+    }
+    if (jump_num > 1) return false;
+    SetCond(then_begin, then_end, InvertCond(cond));
+    SetCond(else_begin, else_end, cond);
+    inst_list.erase(then_end);
+    inst_list.erase(else_label);
+    iter = inst_list.erase(iter);
+    return true;
+}
+
+}  // namespace backend
@@ -0,0 +1,1046 @@
+#include "backend/regalloc.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "backend/instruction.h"
+#include "backend/operand.h"
+#include "error.h"
+
+namespace backend {
+
+namespace {
+
+class BitSet {
+  public:
+    explicit BitSet(const std::size_t size)
+        : word_list((size + 63) / 64, 0) {}
+
+    bool Test(const std::size_t i) const {
+        return (word_list[i / 64] >> (i % 64) & 1) != 0;
+    }
+    void Set(const std::size_t i) {
+        word_list[i / 64] |= std::uint64_t(1) << (i % 64);
+    }
+    void Reset(const std::size_t i) {
+        word_list[i / 64] &= ~(std::uint64_t(1) << (i % 64));
+    }
+
+    // this |= other, return whether anything changed
+    bool Union(const BitSet &other) {
+        bool changed = false;
+        for (std::size_t i = 0; i < word_list.size(); ++i) {
+            auto word = word_list[i] | other.word_list[i];
+            if (word != word_list[i]) {
+                word_list[i] = word;
+                changed = true;
+            }
+        }
+        return changed;
+    }
+    // this |= gen | (other & ~kill)
+    bool Transfer(const BitSet &gen, const BitSet &other, const BitSet &kill) {
+        bool changed = false;
+        for (std::size_t i = 0; i < word_list.size(); ++i) {
+            auto word = word_list[i] | gen.word_list[i]
+                        | (other.word_list[i] & ~kill.word_list[i]);
+            if (word != word_list[i]) {
+                word_list[i] = word;
+                changed = true;
+            }
+        }
+        return changed;
+    }
+
+    template <typename F>
+    void ForEach(F f) const {
+        for (std::size_t i = 0; i < word_list.size(); ++i) {
+            for (auto word = word_list[i]; word != 0; word &= word - 1) {
+                f(i * 64 + __builtin_ctzll(word));
+            }
+        }
+    }
+
+  private:
+    std::vector<std::uint64_t> word_list;
+};
+
+struct Block {
+    int begin;
+    int end;
+    std::vector<int> succ_list;
+};
+
+// control never falls through it
+bool IsBarrier(const Inst &inst) {
+    if (inst.cond != Inst::kAL) return false;
+    if (inst.op == Inst::kInsB || inst.op == Inst::kInsBx) return true;
+    if (inst.op == Inst::kInsPop) {
+        for (const auto &reg : inst.GetDefList()) {
+            if (reg->GetId() == RegOperand::kPc) return true;
+        }
+    }
+    return false;
+}
+
+// a conditional instruction may keep the old value of what it writes
+std::vector<std::shared_ptr<RegOperand>> ReadList(const Inst &inst) {
+    auto use_list = inst.GetUseList();
+    if (inst.cond != Inst::kAL && inst.op != Inst::kInsB) {
+        auto def_list = inst.GetDefList();
+        use_list.insert(use_list.end(), def_list.begin(), def_list.end());
+    }
+    return use_list;
+}
+
+// the ids of the tracked registers of the class an instruction reads
+std::vector<int> ReadIdList(const Inst &inst,
+                            const Liveness::RegClass reg_class) {
+    std::vector<int> id_list;
+    if (reg_class == Liveness::kQ) {
+        for (const auto &reg : inst.GetQUseList()) {
+            id_list.push_back(reg->GetId());
+        }
+        return id_list;
+    }
+    for (const auto &reg : ReadList(inst)) {
+        if (Liveness::IsTracked(reg->GetId())) id_list.push_back(reg->GetId());
+    }
+    return id_list;
+}
+
+// and writes
+std::vector<int> DefIdList(const Inst &inst,
+                           const Liveness::RegClass reg_class) {
+    std::vector<int> id_list;
+    if (reg_class == Liveness::kQ) {
+        for (const auto &reg : inst.GetQDefList()) {
+            id_list.push_back(reg->GetId());
+        }
+        return id_list;
+    }
+    for (const auto &reg : inst.GetDefList()) {
+        if (Liveness::IsTracked(reg->GetId())) id_list.push_back(reg->GetId());
+    }
+    return id_list;
+}
+
+std::vector<Block> SplitBlock(const std::vector<std::shared_ptr<Inst>> &list) {
+    std::vector<Block> block_list;
+    std::unordered_map<std::string, int> label_map;
+    for (int i = 0; i < list.size(); ++i) {
+        bool is_begin = i == 0 || list[i]->op == Inst::kInsLabel
+                        || list[i - 1]->op == Inst::kInsB
+                        || IsBarrier(*list[i - 1]);
+        if (is_begin) {
+            if (!block_list.empty()) block_list.back().end = i;
+            block_list.push_back({i, static_cast<int>(list.size()), {}});
+        }
+        if (list[i]->op == Inst::kInsLabel) {
+            label_map.emplace(list[i]->Cast<InsLabel>().GetLabel()->GetName(),
+                              static_cast<int>(block_list.size()) - 1);
+        }
+    }
+    for (int b = 0; b < block_list.size(); ++b) {
+        auto &block = block_list[b];
+        auto &last = *list[block.end - 1];
+        if (last.op == Inst::kInsB) {
+            auto target
+                = label_map.find(last.Cast<InsB>().GetLabel()->GetName());
+            if (target != label_map.end()) {
+                block.succ_list.push_back(target->second);
+            }
+        }
+        if (!IsBarrier(last) && b + 1 < block_list.size()) {
+            block.succ_list.push_back(b + 1);
+        }
+    }
+    return block_list;
+}
+
+// Loop nesting depth of each instruction. The blocks are laid out in source
+// order, so a branch back to an earlier block closes a loop over the blocks
+// in between.
+std::vector<int> LoopDepth(const std::vector<std::shared_ptr<Inst>> &list) {
+    auto block_list = SplitBlock(list);
+    std::vector<int> diff(block_list.size() + 1, 0);
+    for (int b = 0; b < block_list.size(); ++b) {
+        for (int succ : block_list[b].succ_list) {
+            if (succ > b) continue;
+            ++diff[succ];
+            --diff[b + 1];
+        }
+    }
+    std::vector<int> depth_list(list.size(), 0);
+    int depth = 0;
+    for (int b = 0; b < block_list.size(); ++b) {
+        depth += diff[b];
+        for (int i = block_list[b].begin; i < block_list[b].end; ++i) {
+            depth_list[i] = depth;
+        }
+    }
+    return depth_list;
+}
+
+// the weight of a reference at each instruction: how often its block runs
+// per call from the profile, or else 10^loop depth
+std::vector<double> BlockWeight(
+    const std::vector<std::shared_ptr<Inst>> &list) {
+    std::vector<double> weight_list(list.size(), 1);
+    bool has_profile = false;
+    for (const auto &inst : list) {
+        if (inst->op == Inst::kInsLabel
+            && inst->Cast<InsLabel>().GetFrequency() >= 0) {
+            has_profile = true;
+            break;
+        }
+    }
+    if (!has_profile) {
+        auto depth_list = LoopDepth(list);
+        for (int i = 0; i < list.size(); ++i) {
+            weight_list[i] = std::pow(10.0, std::min(depth_list[i], 8));
+        }
+        return weight_list;
+    }
+    // a label without a count, as the ones on split edges, takes the one
+    // before it; a block that never ran still costs a little
+    double weight = 1;
+    for (int i = 0; i < list.size(); ++i) {
+        if (list[i]->op == Inst::kInsLabel) {
+            const double frequency = list[i]->Cast<InsLabel>().GetFrequency();
+            if (frequency >= 0) weight = std::max(frequency, 1e-3);
+        }
+        weight_list[i] = weight;
+    }
+    return weight_list;
+}
+
+}  // namespace
+
+Liveness::Liveness(const Function &func, const RegClass reg_class)
+    : inst_list(func.GetInstList().begin(), func.GetInstList().end()) {
+    const int reg_num
+        = reg_class == kCore ? func.GetRegNum() : func.GetQRegNum();
+    range_list.resize(reg_num);
+    ref_count.resize(reg_num, 0);
+    if (inst_list.empty()) return;
+    auto block_list = SplitBlock(inst_list);
+
+    // upward exposed uses and defs of each block
+    std::vector<BitSet> gen_list(block_list.size(), BitSet(reg_num));
+    std::vector<BitSet> kill_list(block_list.size(), BitSet(reg_num));
+    for (int b = 0; b < block_list.size(); ++b) {
+        auto &gen = gen_list[b];
+        auto &kill = kill_list[b];
+        for (int i = block_list[b].begin; i < block_list[b].end; ++i) {
+            for (int id : ReadIdList(*inst_list[i], reg_class)) {
+                ++ref_count[id];
+                if (!kill.Test(id)) gen.Set(id);
+            }
+            for (int id : DefIdList(*inst_list[i], reg_class)) {
+                ++ref_count[id];
+                kill.Set(id);
+            }
+        }
+    }
+
+    std::vector<BitSet> live_in(block_list.size(), BitSet(reg_num));
+    std::vector<BitSet> live_out(block_list.size(), BitSet(reg_num));
+    for (bool changed = true; changed;) {
+        changed = false;
+        for (int b = static_cast<int>(block_list.size()) - 1; b >= 0; --b) {
+            for (int succ : block_list[b].succ_list) {
+                live_out[b].Union(live_in[succ]);
+            }
+            changed |= live_in[b].Transfer(gen_list[b], live_out[b],
+                                           kill_list[b]);
+        }
+    }
+
+    // walk each block backwards
+    std::vector<int> end(reg_num, 0);
+    BitSet live(reg_num);
+    for (int b = 0; b < block_list.size(); ++b) {
+        const auto &block = block_list[b];
+        live = live_out[b];
+        live.ForEach([&](const int id) { end[id] = 2 * block.end; });
+        for (int i = block.end - 1; i >= block.begin; --i) {
+            for (int id : DefIdList(*inst_list[i], reg_class)) {
+                if (live.Test(id)) {
+                    range_list[id].push_back({2 * i + 1, end[id]});
+                    live.Reset(id);
+                } else {
+                    range_list[id].push_back({2 * i + 1, 2 * i + 2});
+                }
+            }
+            for (int id : ReadIdList(*inst_list[i], reg_class)) {
+                if (live.Test(id)) continue;
+                live.Set(id);
+                end[id] = 2 * i + 1;
+            }
+        }
+        live.ForEach([&](const int id) {
+            range_list[id].push_back({2 * block.begin, end[id]});
+        });
+    }
+
+    for (auto &range : range_list) {
+        if (range.empty()) continue;
+        std::sort(range.begin(), range.end(),
+                  [](const Segment &lhs, const Segment &rhs) {
+                      return lhs.begin < rhs.begin;
+                  });
+        Range merged;
+        for (const auto &seg : range) {
+            if (!merged.empty() && seg.begin <= merged.back().end) {
+                merged.back().end = std::max(merged.back().end, seg.end);
+            } else {
+                merged.push_back(seg);
+            }
+        }
+        range = std::move(merged);
+    }
+}
+
+void RegAlloc::Spill(Function &func,
+                     const std::vector<int> &spill_list,
+                     std::unordered_set<int> &no_spill) {
+    std::unordered_map<int, int> slot_map;
+    for (int id : spill_list) slot_map.emplace(id, func.AddStackObject(4));
+    spill_count += static_cast<int>(spill_list.size());
+
+    auto &inst_list = func.GetInstList();
+    for (auto iter = inst_list.begin(); iter != inst_list.end(); ++iter) {
+        auto &inst = **iter;
+        // operand objects of each spilled register, read or written
+        std::map<int, std::vector<std::shared_ptr<RegOperand>>> ref_map;
+        std::unordered_set<int> read_set;
+        std::unordered_set<int> write_set;
+        for (const auto &reg : ReadList(inst)) {
+            if (slot_map.count(reg->GetId()) == 0) continue;
+            ref_map[reg->GetId()].push_back(reg);
+            read_set.insert(reg->GetId());
+        }
+        for (const auto &reg : inst.GetDefList()) {
+            if (slot_map.count(reg->GetId()) == 0) continue;
+            ref_map[reg->GetId()].push_back(reg);
+            write_set.insert(reg->GetId());
+        }
+        if (ref_map.empty()) continue;
+
+        auto next = std::next(iter);
+        for (const auto &pair : ref_map) {
+            const int slot = slot_map[pair.first];
+            auto tmp = func.NewReg();
+            no_spill.insert(tmp->GetId());
+            if (read_set.count(pair.first) != 0) {
+                inst_list.insert(
+                    iter, func.FrameInst(Function::kFrameLoad, tmp, slot));
+            }
+            if (write_set.count(pair.first) != 0) {
+                inst_list.insert(
+                    next, func.FrameInst(Function::kFrameStore, tmp, slot));
+            }
+            for (const auto &reg : pair.second) inst.ReplaceReg(reg, tmp);
+        }
+        iter = std::prev(next);
+    }
+}
+
+void RegAlloc::Assign(Function &func, const std::vector<int> &assign_list) {
+    std::vector<std::shared_ptr<RegOperand>> phys_list;
+    for (int id = 0; id < kRegNum; ++id) {
+        phys_list.emplace_back(new RegOperand(id));
+    }
+    for (auto &inst : func.GetInstList()) {
+        auto reg_list = inst->GetUseList();
+        auto def_list = inst->GetDefList();
+        reg_list.insert(reg_list.end(), def_list.begin(), def_list.end());
+        for (const auto &reg : reg_list) {
+            if (!reg->IsVirtual()) continue;
+            inst->ReplaceReg(reg, phys_list[assign_list[reg->GetId()]]);
+        }
+    }
+}
+
+// [begin, end) segments by begin
+using Occupation = std::map<int, int>;
+
+static bool Overlap(const Occupation &occupation,
+                    const Liveness::Range &range) {
+    for (const auto &seg : range) {
+        auto next = occupation.lower_bound(seg.end);
+        if (next == occupation.begin()) continue;
+        if (std::prev(next)->second > seg.begin) return true;
+    }
+    return false;
+}
+
+void RegAlloc::RunGreedy(Function &func, std::unordered_set<int> &no_spill) {
+    for (;;) {
+        Liveness liveness(func);
+        const int reg_num = func.GetRegNum();
+
+        std::vector<Occupation> occupation_list(kRegNum);
+        for (int id = 0; id < kRegNum; ++id) {
+            for (const auto &seg : liveness.GetRange(id)) {
+                occupation_list[id].emplace(seg.begin, seg.end);
+            }
+        }
+
+        // registers on the other side of a mov, tried first
+        std::unordered_map<int, std::vector<int>> hint_map;
+        for (const auto &inst : liveness.GetInstList()) {
+            if (inst->op != Inst::kInsMov || inst->cond != Inst::kAL) continue;
+            const auto &mov = inst->Cast<InsMov>();
+            if (mov.GetRmImm()->kind != Operand::kReg) continue;
+            const int rd = mov.GetRd()->GetId();
+            const int rm = mov.GetRmImm()->Cast<RegOperand>().GetId();
+            hint_map[rd].push_back(rm);
+            hint_map[rm].push_back(rd);
+        }
+
+        std::vector<int> order;
+        std::vector<double> weight(reg_num, 0);
+        for (int id = RegOperand::kCpsr + 1; id < reg_num; ++id) {
+            const auto &range = liveness.GetRange(id);
+            if (range.empty()) continue;
+            order.push_back(id);
+            if (no_spill.count(id) != 0) {
+                weight[id] = 1e30;
+                continue;
+            }
+            int length = 0;
+            for (const auto &seg : range) length += seg.end - seg.begin;
+            weight[id] = static_cast<double>(liveness.GetRefCount(id)) / length;
+        }
+        std::stable_sort(order.begin(), order.end(),
+                         [&weight](const int lhs, const int rhs) {
+                             return weight[lhs] > weight[rhs];
+                         });
+
+        std::vector<int> assign_list(reg_num, -1);
+        std::vector<int> spill_list;
+        for (int id : order) {
+            const auto &range = liveness.GetRange(id);
+            std::vector<int> try_list;
+            for (int hint : hint_map[id]) {
+                if (hint < kRegNum) {
+                    try_list.push_back(hint);
+                } else if (hint > RegOperand::kCpsr
+                           && assign_list[hint] >= 0) {
+                    try_list.push_back(assign_list[hint]);
+                }
+            }
+            for (int reg = 0; reg < kRegNum; ++reg) try_list.push_back(reg);
+
+            int phys = -1;
+            for (int reg : try_list) {
+                if (!Overlap(occupation_list[reg], range)) {
+                    phys = reg;
+                    break;
+                }
+            }
+            if (phys < 0) {
+                if (no_spill.count(id) != 0) {
+                    throw InvalidParameterException(
+                        "no register left in " + func.GetName());
+                }
+                spill_list.push_back(id);
+                continue;
+            }
+            assign_list[id] = phys;
+            for (const auto &seg : range) {
+                occupation_list[phys].emplace(seg.begin, seg.end);
+            }
+        }
+
+        if (spill_list.empty()) {
+            Assign(func, assign_list);
+            return;
+        }
+        Spill(func, spill_list, no_spill);
+    }
+}
+
+void GreedyRegAlloc::Run(Function &func) {
+    std::unordered_set<int> no_spill;
+    RunGreedy(func, no_spill);
+}
+
+namespace {
+
+// One round of iterated register coalescing, the names follow Appel's
+// "Modern Compiler Implementation", section 11.4.
+class Coloring {
+  public:
+    static constexpr int K = RegAlloc::kRegNum;
+
+    Coloring(const Liveness &liveness,
+             const std::unordered_set<int> &no_spill,
+             int reg_num);
+
+    void Run();
+
+    // r0-r11 for each register, -1 for the spilled and the unused ones
+    const std::vector<int> &GetColorList() const { return color; }
+    const std::vector<int> &GetSpillList() const { return spilled_nodes; }
+    int GetCoalesceCount() const { return coalesce_count; }
+
+  private:
+    enum NodeState {
+        kUnused,
+        kPrecolored,
+        kSimplify,
+        kFreeze,
+        kSpill,
+        kSpilled,
+        kCoalesced,
+        kColored,
+        kSelect
+    };
+    enum MoveState {
+        kWorklist,
+        kActive,
+        kCoalescedMove,
+        kConstrained,
+        kFrozen
+    };
+
+    struct Move {
+        int dst;
+        int src;
+        MoveState state;
+    };
+
+    const int reg_num;
+    BitSet adj_set;  // lower triangle of the bit matrix
+    std::vector<std::vector<int>> adj_list;
+    std::vector<int> degree;
+    std::vector<NodeState> state;
+    std::vector<int> alias;
+    std::vector<int> color;
+    std::vector<double> cost;
+
+    std::vector<Move> move_list;
+    std::vector<std::vector<int>> node_move_list;
+
+    // the worklists may hold stale entries, state tells which are current
+    std::vector<int> simplify_worklist;
+    std::vector<int> freeze_worklist;
+    std::vector<int> spill_worklist;
+    std::vector<int> worklist_moves;
+    std::vector<int> select_stack;
+    std::vector<int> spilled_nodes;
+    int coalesce_count = 0;
+
+    // in size_t, u * (u - 1) overflows an int past 46341 registers
+    static std::size_t Index(const int u, const int v) {
+        const std::size_t high = std::max(u, v);
+        const std::size_t low = std::min(u, v);
+        return high * (high - 1) / 2 + low;
+    }
+    bool Interfere(const int u, const int v) const {
+        return u != v && adj_set.Test(Index(u, v));
+    }
+    bool IsPrecolored(const int n) const { return state[n] == kPrecolored; }
+
+    void AddEdge(int u, int v);
+    void Build(const Liveness &liveness,
+               const std::unordered_set<int> &no_spill);
+    void MakeWorklist();
+
+    template <typename F>
+    void ForAdjacent(int n, F f) const;
+    template <typename F>
+    void ForNodeMoves(int n, F f) const;
+    bool MoveRelated(int n) const;
+
+    void Push(int n, NodeState to);
+    int Pop(std::vector<int> &worklist, NodeState from);
+
+    void Simplify(int n);
+    void DecrementDegree(int m);
+    void EnableMoves(int n);
+    void Coalesce(int m);
+    void AddWorkList(int u);
+    bool OK(int t, int r) const;
+    bool Conservative(int u, int v) const;
+    int GetAlias(int n) const;
+    void Combine(int u, int v);
+    void FreezeMoves(int u);
+    int SelectSpill();
+    void AssignColors();
+};
+
+Coloring::Coloring(const Liveness &liveness,
+                   const std::unordered_set<int> &no_spill,
+                   const int reg_num)
+    : reg_num(reg_num)
+    , adj_set(Index(reg_num, 0))
+    , adj_list(reg_num)
+    , degree(reg_num, 0)
+    , state(reg_num, kUnused)
+    , alias(reg_num)
+    , color(reg_num, -1)
+    , cost(reg_num, 0)
+    , node_move_list(reg_num) {
+    for (int n = 0; n < reg_num; ++n) alias[n] = n;
+    for (int n = 0; n < K; ++n) {
+        state[n] = kPrecolored;
+        color[n] = n;
+    }
+    Build(liveness, no_spill);
+    MakeWorklist();
+}
+
+void Coloring::AddEdge(const int u, const int v) {
+    if (u == v || adj_set.Test(Index(u, v))) return;
+    adj_set.Set(Index(u, v));
+    if (!IsPrecolored(u)) {
+        adj_list[u].push_back(v);
+        ++degree[u];
+    }
+    if (!IsPrecolored(v)) {
+        adj_list[v].push_back(u);
+        ++degree[v];
+    }
+}
+
+void Coloring::Build(const Liveness &liveness,
+                     const std::unordered_set<int> &no_spill) {
+    // two registers interfere when their live ranges overlap, found with a
+    // sweep over the segments by begin
+    struct Item {
+        int begin;
+        int end;
+        int id;
+    };
+    std::vector<Item> item_list;
+    for (int id = 0; id < reg_num; ++id) {
+        if (!Liveness::IsTracked(id)) continue;
+        const auto &range = liveness.GetRange(id);
+        if (range.empty()) continue;
+        if (!IsPrecolored(id)) state[id] = kSimplify;
+        for (const auto &seg : range) {
+            item_list.push_back({seg.begin, seg.end, id});
+        }
+    }
+    std::sort(item_list.begin(), item_list.end(),
+              [](const Item &lhs, const Item &rhs) {
+                  return lhs.begin < rhs.begin;
+              });
+    std::vector<Item> active;
+    for (const auto &item : item_list) {
+        active.erase(std::remove_if(active.begin(), active.end(),
+                                    [&item](const Item &other) {
+                                        return other.end <= item.begin;
+                                    }),
+                     active.end());
+        for (const auto &other : active) AddEdge(item.id, other.id);
+        active.push_back(item);
+    }
+
+    const auto &inst_list = liveness.GetInstList();
+    auto weight_list = BlockWeight(inst_list);
+    for (int i = 0; i < inst_list.size(); ++i) {
+        const auto &inst = *inst_list[i];
+        const double weight = weight_list[i];
+        for (const auto &reg : ReadList(inst)) {
+            if (state[reg->GetId()] != kUnused) cost[reg->GetId()] += weight;
+        }
+        for (const auto &reg : inst.GetDefList()) {
+            if (state[reg->GetId()] != kUnused) cost[reg->GetId()] += weight;
+        }
+
+        if (inst.op != Inst::kInsMov || inst.cond != Inst::kAL) continue;
+        const auto &mov = inst.Cast<InsMov>();
+        if (mov.GetRmImm()->kind != Operand::kReg) continue;
+        const int dst = mov.GetRd()->GetId();
+        const int src = mov.GetRmImm()->Cast<RegOperand>().GetId();
+        if (dst == src || state[dst] == kUnused || state[src] == kUnused
+            || (IsPrecolored(dst) && IsPrecolored(src))) {
+            continue;
+        }
+        const int m = static_cast<int>(move_list.size());
+        move_list.push_back({dst, src, kWorklist});
+        node_move_list[dst].push_back(m);
+        node_move_list[src].push_back(m);
+        worklist_moves.push_back(m);
+    }
+    for (int id : no_spill) {
+        if (id < reg_num) cost[id] = 1e30;
+    }
+}
+
+void Coloring::MakeWorklist() {
+    for (int n = K; n < reg_num; ++n) {
+        if (state[n] != kSimplify) continue;
+        if (degree[n] >= K) {
+            Push(n, kSpill);
+        } else if (MoveRelated(n)) {
+            Push(n, kFreeze);
+        } else {
+            Push(n, kSimplify);
+        }
+    }
+}
+
+template <typename F>
+void Coloring::ForAdjacent(const int n, F f) const {
+    for (int m : adj_list[n]) {
+        if (state[m] != kSelect && state[m] != kCoalesced) f(m);
+    }
+}
+
+template <typename F>
+void Coloring::ForNodeMoves(const int n, F f) const {
+    for (int m : node_move_list[n]) {
+        if (move_list[m].state == kActive || move_list[m].state == kWorklist) {
+            f(m);
+        }
+    }
+}
+
+bool Coloring::MoveRelated(const int n) const {
+    bool related = false;
+    ForNodeMoves(n, [&related](int) { related = true; });
+    return related;
+}
+
+void Coloring::Push(const int n, const NodeState to) {
+    state[n] = to;
+    if (to == kSimplify) simplify_worklist.push_back(n);
+    if (to == kFreeze) freeze_worklist.push_back(n);
+    if (to == kSpill) spill_worklist.push_back(n);
+}
+
+int Coloring::Pop(std::vector<int> &worklist, const NodeState from) {
+    while (!worklist.empty()) {
+        const int n = worklist.back();
+        worklist.pop_back();
+        if (state[n] == from) return n;
+    }
+    return -1;
+}
+
+void Coloring::Run() {
+    for (;;) {
+        int n = Pop(simplify_worklist, kSimplify);
+        if (n >= 0) {
+            Simplify(n);
+            continue;
+        }
+        if (!worklist_moves.empty()) {
+            const int m = worklist_moves.back();
+            worklist_moves.pop_back();
+            if (move_list[m].state == kWorklist) Coalesce(m);
+            continue;
+        }
+        n = Pop(freeze_worklist, kFreeze);
+        if (n >= 0) {
+            Push(n, kSimplify);
+            FreezeMoves(n);
+            continue;
+        }
+        n = SelectSpill();
+        if (n < 0) break;
+        Push(n, kSimplify);
+        FreezeMoves(n);
+    }
+    AssignColors();
+}
+
+void Coloring::Simplify(const int n) {
+    state[n] = kSelect;
+    select_stack.push_back(n);
+    ForAdjacent(n, [this](const int m) { DecrementDegree(m); });
+}
+
+void Coloring::DecrementDegree(const int m) {
+    if (IsPrecolored(m)) return;
+    if (degree[m]-- != K) return;
+    EnableMoves(m);
+    ForAdjacent(m, [this](const int n) { EnableMoves(n); });
+    if (state[m] != kSpill) return;
+    Push(m, MoveRelated(m) ? kFreeze : kSimplify);
+}
+
+void Coloring::EnableMoves(const int n) {
+    ForNodeMoves(n, [this](const int m) {
+        if (move_list[m].state != kActive) return;
+        move_list[m].state = kWorklist;
+        worklist_moves.push_back(m);
+    });
+}
+
+void Coloring::Coalesce(const int m) {
+    int u = GetAlias(move_list[m].dst);
+    int v = GetAlias(move_list[m].src);
+    if (IsPrecolored(v)) std::swap(u, v);
+    if (u == v) {
+        move_list[m].state = kCoalescedMove;
+        ++coalesce_count;
+        AddWorkList(u);
+    } else if (IsPrecolored(v) || Interfere(u, v)) {
+        move_list[m].state = kConstrained;
+        AddWorkList(u);
+        AddWorkList(v);
+    } else {
+        bool ok = true;
+        if (IsPrecolored(u)) {
+            ForAdjacent(v, [&](const int t) { ok = ok && OK(t, u); });
+        } else {
+            ok = Conservative(u, v);
+        }
+        if (ok) {
+            move_list[m].state = kCoalescedMove;
+            ++coalesce_count;
+            Combine(u, v);
+            AddWorkList(u);
+        } else {
+            move_list[m].state = kActive;
+        }
+    }
+}
+
+void Coloring::AddWorkList(const int u) {
+    if (!IsPrecolored(u) && !MoveRelated(u) && degree[u] < K
+        && state[u] == kFreeze) {
+        Push(u, kSimplify);
+    }
+}
+
+// George: t is harmless to coalesce into the precolored r
+bool Coloring::OK(const int t, const int r) const {
+    return degree[t] < K || IsPrecolored(t) || Interfere(t, r);
+}
+
+// Briggs: the merged node has fewer than K neighbors of significant degree
+bool Coloring::Conservative(const int u, const int v) const {
+    std::unordered_set<int> seen;
+    int k = 0;
+    auto count = [&](const int n) {
+        if (!seen.insert(n).second) return;
+        if (IsPrecolored(n) || degree[n] >= K) ++k;
+    };
+    ForAdjacent(u, count);
+    ForAdjacent(v, count);
+    return k < K;
+}
+
+int Coloring::GetAlias(int n) const {
+    while (state[n] == kCoalesced) n = alias[n];
+    return n;
+}
+
+void Coloring::Combine(const int u, const int v) {
+    state[v] = kCoalesced;
+    alias[v] = u;
+    cost[u] += cost[v];
+    node_move_list[u].insert(node_move_list[u].end(),
+                             node_move_list[v].begin(),
+                             node_move_list[v].end());
+    EnableMoves(v);
+    ForAdjacent(v, [this, u](const int t) {
+        AddEdge(t, u);
+        DecrementDegree(t);
+    });
+    if (degree[u] >= K && state[u] == kFreeze) Push(u, kSpill);
+}
+
+void Coloring::FreezeMoves(const int u) {
+    ForNodeMoves(u, [this, u](const int m) {
+        const int x = move_list[m].dst;
+        const int y = move_list[m].src;
+        const int v = GetAlias(y) == GetAlias(u) ? GetAlias(x) : GetAlias(y);
+        move_list[m].state = kFrozen;
+        if (state[v] == kFreeze && !MoveRelated(v) && degree[v] < K) {
+            Push(v, kSimplify);
+        }
+    });
+}
+
+int Coloring::SelectSpill() {
+    int best = -1;
+    std::vector<int> rest;
+    for (int n : spill_worklist) {
+        if (state[n] != kSpill) continue;
+        rest.push_back(n);
+        if (best < 0 || cost[n] * degree[best] < cost[best] * degree[n]) {
+            best = n;
+        }
+    }
+    spill_worklist = std::move(rest);
+    return best;
+}
+
+void Coloring::AssignColors() {
+    while (!select_stack.empty()) {
+        const int n = select_stack.back();
+        select_stack.pop_back();
+        std::vector<bool> ok_color(K, true);
+        for (int w : adj_list[n]) {
+            const int a = GetAlias(w);
+            if (state[a] == kColored || IsPrecolored(a)) {
+                ok_color[color[a]] = false;
+            }
+        }
+        // a color that lets a frozen or constrained move go away
+        int pick = -1;
+        for (int m : node_move_list[n]) {
+            const int other = GetAlias(move_list[m].dst) == n
+                                  ? GetAlias(move_list[m].src)
+                                  : GetAlias(move_list[m].dst);
+            if (color[other] >= 0 && ok_color[color[other]]) {
+                pick = color[other];
+                break;
+            }
+        }
+        for (int c = 0; pick < 0 && c < K; ++c) {
+            if (ok_color[c]) pick = c;
+        }
+        if (pick < 0) {
+            state[n] = kSpilled;
+            spilled_nodes.push_back(n);
+        } else {
+            state[n] = kColored;
+            color[n] = pick;
+        }
+    }
+    for (int n = K; n < reg_num; ++n) {
+        if (state[n] != kCoalesced) continue;
+        const int a = GetAlias(n);
+        if (state[a] == kSpilled) {
+            spilled_nodes.push_back(n);
+        } else {
+            color[n] = color[a];
+        }
+    }
+}
+
+}  // namespace
+
+void ColoringRegAlloc::Run(Function &func) {
+    std::unordered_set<int> no_spill;
+    for (;;) {
+        if (func.GetRegNum() > kMaxRegNum) {
+            RunGreedy(func, no_spill);
+            return;
+        }
+        Liveness liveness(func);
+        Coloring coloring(liveness, no_spill, func.GetRegNum());
+        coloring.Run();
+        const auto &spill_list = coloring.GetSpillList();
+        if (spill_list.empty()) {
+            coalesce_count += coloring.GetCoalesceCount();
+            Assign(func, coloring.GetColorList());
+            return;
+        }
+        for (int id : spill_list) {
+            if (no_spill.count(id) != 0) {
+                throw InvalidParameterException(
+                    "no register left in " + func.GetName());
+            }
+        }
+        Spill(func, spill_list, no_spill);
+    }
+}
+
+void QRegAlloc::Run(Function &func) {
+    const int reg_num = func.GetQRegNum();
+    if (reg_num == QRegOperand::kPhysNum) return;
+    Liveness liveness(func, Liveness::kQ);
+
+    // q8-q15, then q0-q3; q4-q7 are saved by the callee
+    std::vector<int> phys_order;
+    for (int id = 8; id < QRegOperand::kPhysNum; ++id) phys_order.push_back(id);
+    for (int id = 0; id < 4; ++id) phys_order.push_back(id);
+
+    std::vector<Occupation> occupation_list(QRegOperand::kPhysNum);
+    for (int id = 0; id < QRegOperand::kPhysNum; ++id) {
+        for (const auto &seg : liveness.GetRange(id)) {
+            occupation_list[id].emplace(seg.begin, seg.end);
+        }
+    }
+
+    std::unordered_map<int, std::vector<int>> hint_map;
+    for (const auto &inst : liveness.GetInstList()) {
+        if (inst->op != Inst::kInsVmov) continue;
+        const auto &vmov = inst->Cast<InsVmov>();
+        const int qd = vmov.GetQd()->GetId();
+        const int qm = vmov.GetQm()->GetId();
+        hint_map[qd].push_back(qm);
+        hint_map[qm].push_back(qd);
+    }
+
+    std::vector<int> order;
+    for (int id = QRegOperand::kPhysNum; id < reg_num; ++id) {
+        if (!liveness.GetRange(id).empty()) order.push_back(id);
+    }
+    std::stable_sort(order.begin(), order.end(),
+                     [&liveness](const int lhs, const int rhs) {
+                         return liveness.GetRange(lhs).front().begin
+                                < liveness.GetRange(rhs).front().begin;
+                     });
+
+    std::vector<int> assign_list(reg_num, -1);
+    for (int id : order) {
+        const auto &range = liveness.GetRange(id);
+        std::vector<int> try_list;
+        for (int hint : hint_map[id]) {
+            if (hint < QRegOperand::kPhysNum) {
+                try_list.push_back(hint);
+            } else if (assign_list[hint] >= 0) {
+                try_list.push_back(assign_list[hint]);
+            }
+        }
+        try_list.insert(try_list.end(), phys_order.begin(), phys_order.end());
+        auto phys = std::find_if(try_list.begin(), try_list.end(),
+                                 [&](const int reg) {
+                                     return !Overlap(occupation_list[reg],
+                                                     range);
+                                 });
+        if (phys == try_list.end()) {
+            throw InvalidParameterException("no q register left in "
+                                            + func.GetName());
+        }
+        assign_list[id] = *phys;
+        for (const auto &seg : range) {
+            occupation_list[*phys].emplace(seg.begin, seg.end);
+        }
+    }
+
+    std::vector<std::shared_ptr<QRegOperand>> phys_list;
+    for (int id = 0; id < QRegOperand::kPhysNum; ++id) {
+        phys_list.emplace_back(new QRegOperand(id));
+    }
+    auto &inst_list = func.GetInstList();
+    for (auto iter = inst_list.begin(); iter != inst_list.end();) {
+        auto &inst = **iter;
+        auto reg_list = inst.GetQUseList();
+        auto def_list = inst.GetQDefList();
+        reg_list.insert(reg_list.end(), def_list.begin(), def_list.end());
+        for (const auto &reg : reg_list) {
+            if (!reg->IsVirtual()) continue;
+            inst.ReplaceQReg(reg, phys_list[assign_list[reg->GetId()]]);
+        }
+        // the moves left between the same register
+        if (inst.op == Inst::kInsVmov
+            && inst.Cast<InsVmov>().GetQd() == inst.Cast<InsVmov>().GetQm()) {
+            iter = inst_list.erase(iter);
+        } else {
+            ++iter;
+        }
+    }
+}
+
+}  // namespace backend
@@ -0,0 +1,132 @@
+#include "emitter.h"
+
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+
+namespace util {
+
+namespace {
+
+// "00" to "99"
+constexpr char kDigitPair[] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+}  // namespace
+
+char *FormatUInt(char *first, unsigned long long value) {
+    char digit[20];
+    char *last = digit + sizeof(digit);
+    char *begin = last;
+    while (value >= 100) {
+        const auto pair = static_cast<unsigned>(value % 100) * 2;
+        value /= 100;
+        *--begin = kDigitPair[pair + 1];
+        *--begin = kDigitPair[pair];
+    }
+    if (value >= 10) {
+        const auto pair = static_cast<unsigned>(value) * 2;
+        *--begin = kDigitPair[pair + 1];
+        *--begin = kDigitPair[pair];
+    } else {
+        *--begin = static_cast<char>('0' + value);
+    }
+    std::memcpy(first, begin, last - begin);
+    return first + (last - begin);
+}
+
+char *FormatInt(char *first, const long long value) {
+    if (value >= 0) return FormatUInt(first, value);
+    *first = '-';
+    // negate in unsigned, so that the minimum does not overflow
+    return FormatUInt(first + 1, 0ULL - static_cast<unsigned long long>(value));
+}
+
+Emitter::Emitter(const int fd)
+    : fd(fd), buffer(std::make_unique<char[]>(kBufferSize)) {}
+
+Emitter::Emitter(std::ostream &ostream)
+    : ostream(&ostream), buffer(std::make_unique<char[]>(kBufferSize)) {}
+
+void Emitter::Write(const char *data, const std::size_t size) {
+    if (str != nullptr) {
+        str->append(data, size);
+        return;
+    }
+    if (this->size + size > kBufferSize) {
+        Flush();
+        // too large to be worth a copy
+        if (size > kBufferSize) {
+            Sink(data, size);
+            return;
+        }
+    }
+    std::memcpy(buffer.get() + this->size, data, size);
+    this->size += size;
+}
+
+void Emitter::Flush() {
+    if (size == 0) return;
+    const std::size_t buffered = size;
+    size = 0;
+    Sink(buffer.get(), buffered);
+}
+
+void Emitter::Sink(const char *data, std::size_t size) {
+    if (ostream != nullptr) {
+        ostream->write(data, static_cast<std::streamsize>(size));
+        good = good && ostream->good();
+        return;
+    }
+    while (size > 0) {
+        const ssize_t written = ::write(fd, data, size);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            good = false;
+            return;
+        }
+        data += written;
+        size -= written;
+    }
+}
+
+Emitter &Emitter::operator<<(const Colored &colored) {
+    BeginColor(colored.fg_color, colored.bold, colored.underline);
+    *this << colored.text;
+    EndColor();
+    return *this;
+}
+
+void Emitter::BeginColor(const ForegroundColor fg_color,
+                         const bool bold,
+                         const bool underline) {
+    if (!color) return;
+    *this << "\e[" << static_cast<int>(fg_color);
+    if (bold) *this << ';' << static_cast<int>(kBold);
+    if (underline) *this << ';' << static_cast<int>(kUnderLine);
+    *this << 'm';
+}
+
+Emitter &Emitter::Int(const long long value) {
+    char digit[20];
+    Write(digit, FormatInt(digit, value) - digit);
+    return *this;
+}
+
+Emitter &Emitter::UInt(const unsigned long long value) {
+    char digit[20];
+    Write(digit, FormatUInt(digit, value) - digit);
+    return *this;
+}
+
+}  // namespace util
@@ -85,11 +85,12 @@ void howAllFormat() {
 }
 #endif
 
-std::string FormatHex32(std::uint32_t num) {
-    std::stringstream buf;
-    buf << std::setw(sizeof(num) * 2) << std::setfill('0');
-    buf << std::hex << num;
-    return "0x" + buf.str();
+std::string FormatHex32(const std::uint32_t num) {
+    std::string hex = "0x00000000";
+    for (int i = 0; i < 8; ++i) {
+        hex[9 - i] = "0123456789abcdef"[num >> (i * 4) & 0xf];
+    }
+    return hex;
 }
 
 }  // namespace util
@@ -1,8 +1,11 @@
 #include "frontend/ast_manager.h"
 
-#include <sstream>
+#include <array>
+#include <string>
+#include <string_view>
 #include <vector>
 
+#include "emitter.h"
 #include "error.h"
 #include "util.h"
 
@@ -41,32 +44,36 @@ void ASTManager::SetRoot(std::unique_ptr<ASTNode> &root) {
 }
 
 TranslationUnit &ASTManager::GetRoot() const {
-    return node_table[root]->Cast<TranslationUnit &>();
+    return node_table[root]->Cast<TranslationUnit>();
 }
 
 Decl &ASTManager::GetDecl(const ASTLocation loc) const {
-    return node_table[loc]->Cast<Decl &>();
+    return node_table[loc]->Cast<Decl>();
 }
 
 Stmt &ASTManager::GetStmt(const ASTLocation loc) const {
-    return node_table[loc]->Cast<Stmt &>();
+    return node_table[loc]->Cast<Stmt>();
 }
 
 Expr &ASTManager::GetExpr(const ASTLocation loc) const {
-    return node_table[loc]->Cast<Expr &>();
+    return node_table[loc]->Cast<Expr>();
 }
 
 void ASTManager::Dump(std::ostream &ostream) const {
-    ostream << util::FormatTerminal("Dump AST from file", util::kFGBrightGreen,
-                                    util::kBGDefault,
-                                    {util::kBold, util::kUnderLine});
-    ostream << " '" << util::FormatTerminal(raw.GetFileName(), util::kFGYellow)
+    util::Emitter emitter(ostream);
+    Dump(emitter);
+}
+
+void ASTManager::Dump(util::Emitter &emitter) const {
+    emitter << util::Colored{"Dump AST from file", util::kFGBrightGreen, true,
+                             true};
+    emitter << " '" << util::Colored{raw.GetFileName(), util::kFGYellow}
             << '\'';
-    ostream << ", "
-            << util::FormatTerminalBold("AST node count", util::kFGBrightGreen)
+    emitter << ", "
+            << util::Colored{"AST node count", util::kFGBrightGreen, true}
             << ' ' << node_table.size();
-    ostream << std::endl;
-    node_table[root]->Dump(ostream, "", true);
+    emitter << '\n';
+    node_table[root]->Dump(emitter, "", true);
 }
 
 /* class IdentTable */
@@ -78,37 +85,41 @@ std::pair<bool, ASTLocation> IdentTable::FindIdent(
     return {true, iter->second};
 }
 
-void IdentTable::DumpIdentTable(std::ostream &ostream) const {
+void IdentTable::DumpIdentTable(util::Emitter &emitter) const {
     for (const auto &pair : ident_table) {
-        ostream << util::FormatTerminal(util::FormatHex32(pair.second),
-                                        util::kFGYellow);
-        ostream << ' '
-                << util::FormatTerminalBold(pair.first, util::kFGBrightGreen);
-        ostream << std::endl;
+        emitter << util::Colored{util::FormatHex32(pair.second),
+                                 util::kFGYellow};
+        emitter << ' '
+                << util::Colored{pair.first, util::kFGBrightGreen, true};
+        emitter << '\n';
     }
 }
 
 /* class ASTNode */
 
-void ASTNode::DumpIndentAndBranch(std::ostream &ostream,
+void ASTNode::DumpIndentAndBranch(util::Emitter &emitter,
                                   const std::string &indent,
                                   const bool is_last) {
-    ostream << util::FormatTerminal(indent + (is_last ? "`-" : "|-"),
-                                    util::kFGBlue);
+    emitter << util::Colored{indent + (is_last ? "`-" : "|-"), util::kFGBlue};
 }
 
-void ASTNode::DumpInfo(std::ostream &ostream, const std::string &kind) const {
+void ASTNode::DumpInfo(util::Emitter &emitter, const std::string &kind) const {
     // node kind
-    ostream << util::FormatTerminalBold(
-        kind, IsDecl() ? util::kFGBrightGreen : util::kFGBrightMagenta);
+    emitter << util::Colored{
+        kind, IsDecl() ? util::kFGBrightGreen : util::kFGBrightMagenta, true};
     // node location
-    ostream << ' '
-            << util::FormatTerminal(util::FormatHex32(location),
-                                    util::kFGYellow);
+    emitter << ' '
+            << util::Colored{util::FormatHex32(location), util::kFGYellow};
     // node source range
-    ostream << " <" << util::FormatTerminal(range.DumpBegin(), util::kFGYellow)
-            << ", " << util::FormatTerminal(range.DumpEnd(), util::kFGYellow)
-            << '>';
+    emitter << " <";
+    emitter.BeginColor(util::kFGYellow);
+    range.DumpBegin(emitter);
+    emitter.EndColor();
+    emitter << ", ";
+    emitter.BeginColor(util::kFGYellow);
+    range.DumpEnd(emitter);
+    emitter.EndColor();
+    emitter << '>';
 }
 
 /* class TranslationUnit */
@@ -123,19 +134,19 @@ void TranslationUnit::Visit() {
     for (auto decl : decl_list) src.GetNode(decl).Visit();
 }
 
-void TranslationUnit::Dump(std::ostream &ostream,
+void TranslationUnit::Dump(util::Emitter &emitter,
                            const std::string &indent,
                            const bool is_last) const {
-    DumpInfo(ostream, "TranslationUnit");
+    DumpInfo(emitter, "TranslationUnit");
     // newline
-    ostream << std::endl;
+    emitter << '\n';
     // decl list
     if (decl_list.empty()) return;
     auto iter = decl_list.cbegin();
     for (; iter != decl_list.cend() - 1; ++iter) {
-        src.GetDecl(*iter).Dump(ostream, "", false);
+        src.GetDecl(*iter).Dump(emitter, "", false);
     }
-    src.GetDecl(*iter).Dump(ostream, "", true);
+    src.GetDecl(*iter).Dump(emitter, "", true);
 }
 
 void TranslationUnit::BuiltIn() {
@@ -220,24 +231,26 @@ void VarDecl::Visit() {
     }
 }
 
-void VarDecl::Dump(std::ostream &ostream,
+void VarDecl::Dump(util::Emitter &emitter,
                    const std::string &indent,
                    const bool is_last) const {
-    DumpIndentAndBranch(ostream, indent, is_last);
-    DumpInfo(ostream, "VarDecl");
+    DumpIndentAndBranch(emitter, indent, is_last);
+    DumpInfo(emitter, "VarDecl");
     // var name
-    ostream << ' ' << GetIdentToken().DumpText();
+    emitter << ' ';
+    GetIdentToken().DumpText(emitter);
     // var type
-    ostream << ' '
-            << util::FormatTerminal('\'' + TypeStr() + '\'', util::kFGGreen);
+    emitter << ' '
+            << util::Colored{'\'' + TypeStr() + '\'', util::kFGGreen};
     // var name's source range
-    ostream << ' ' << GetIdentToken().DumpRange();
+    emitter << ' ';
+    GetIdentToken().DumpRange(emitter);
     // newline
-    ostream << std::endl;
+    emitter << '\n';
     // init
     if (!has_init) return;
     const std::string child_indent = indent + (is_last ? "  " : "| ");
-    GetInit().Dump(ostream, child_indent, true);
+    GetInit().Dump(emitter, child_indent, true);
 }
 
 /* class ParamVarDecl */
@@ -266,20 +279,22 @@ void ParamVarDecl::Visit() {
     for (auto expr : arr_dim_list) src.GetNode(expr).Visit();
 }
 
-void ParamVarDecl::Dump(std::ostream &ostream,
+void ParamVarDecl::Dump(util::Emitter &emitter,
                         const std::string &indent,
                         const bool is_last) const {
-    DumpIndentAndBranch(ostream, indent, is_last);
-    DumpInfo(ostream, "ParamVarDecl");
+    DumpIndentAndBranch(emitter, indent, is_last);
+    DumpInfo(emitter, "ParamVarDecl");
     // var name
-    ostream << ' ' << GetIdentToken().DumpText();
+    emitter << ' ';
+    GetIdentToken().DumpText(emitter);
     // var type
-    ostream << ' '
-            << util::FormatTerminal('\'' + TypeStr() + '\'', util::kFGGreen);
+    emitter << ' '
+            << util::Colored{'\'' + TypeStr() + '\'', util::kFGGreen};
     // var name's source range
-    ostream << ' ' << GetIdentToken().DumpRange();
+    emitter << ' ';
+    GetIdentToken().DumpRange(emitter);
     // newline
-    ostream << std::endl;
+    emitter << '\n';
 }
 
 /* class FunctionDecl */
@@ -295,7 +310,7 @@ std::string FunctionDecl::TypeStr() const {
     std::string type_str = type == kVoid ? "void (" : "int (";
     for (auto iter = param_list.cbegin(); iter != param_list.cend(); ++iter) {
         if (iter != param_list.cbegin()) type_str += ", ";
-        type_str += src.GetNode(*iter).Cast<const ParamVarDecl &>().TypeStr();
+        type_str += src.GetNode(*iter).Cast<ParamVarDecl>().TypeStr();
     }
     return type_str + ')';
 }
@@ -316,31 +331,33 @@ void FunctionDecl::Visit() {
     if (has_def) src.GetNode(def).Visit();
 }
 
-void FunctionDecl::Dump(std::ostream &ostream,
+void FunctionDecl::Dump(util::Emitter &emitter,
                         const std::string &indent,
                         const bool is_last) const {
-    DumpIndentAndBranch(ostream, indent, is_last);
-    DumpInfo(ostream, "FunctionDecl");
+    DumpIndentAndBranch(emitter, indent, is_last);
+    DumpInfo(emitter, "FunctionDecl");
     // func name
-    ostream << ' ' << GetIdentToken().DumpText();
+    emitter << ' ';
+    GetIdentToken().DumpText(emitter);
     // func type
-    ostream << ' '
-            << util::FormatTerminal('\'' + TypeStr() + '\'', util::kFGGreen);
+    emitter << ' '
+            << util::Colored{'\'' + TypeStr() + '\'', util::kFGGreen};
     // func name's source range
-    ostream << ' ' << GetIdentToken().DumpRange();
+    emitter << ' ';
+    GetIdentToken().DumpRange(emitter);
     // newline
-    ostream << std::endl;
+    emitter << '\n';
     // param list
     const std::string child_indent = indent + (is_last ? "  " : "| ");
     if (!param_list.empty()) {
         auto iter = param_list.cbegin();
         for (; iter != param_list.cend() - 1; ++iter) {
-            src.GetNode(*iter).Dump(ostream, child_indent, false);
+            src.GetNode(*iter).Dump(emitter, child_indent, false);
         }
-        src.GetNode(*iter).Dump(ostream, child_indent, !has_def);
+        src.GetNode(*iter).Dump(emitter, child_indent, !has_def);
     }
     // def
-    if (has_def) GetDef().Dump(ostream, child_indent, true);
+    if (has_def) GetDef().Dump(emitter, child_indent, true);
 }
 
 /* class Stmt */
@@ -363,21 +380,21 @@ void CompoundStmt::Visit() {
     for (auto stmt : stmt_list) src.GetNode(stmt).Visit();
 }
 
-void CompoundStmt::Dump(std::ostream &ostream,
+void CompoundStmt::Dump(util::Emitter &emitter,
                         const std::string &indent,
                         const bool is_last) const {
-    DumpIndentAndBranch(ostream, indent, is_last);
-    DumpInfo(ostream, "CompoundStmt");
+    DumpIndentAndBranch(emitter, indent, is_last);
+    DumpInfo(emitter, "CompoundStmt");
     // newline
-    ostream << std::endl;
+    emitter << '\n';
     // stmt list
     if (!stmt_list.empty()) {
         const std::string child_indent = indent + (is_last ? "  " : "| ");
         auto iter = stmt_list.cbegin();
         for (; iter != stmt_list.cend() - 1; ++iter) {
-            src.GetStmt(*iter).Dump(ostream, child_indent, false);
+            src.GetStmt(*iter).Dump(emitter, child_indent, false);
         }
-        src.GetStmt(*iter).Dump(ostream, child_indent, true);
+        src.GetStmt(*iter).Dump(emitter, child_indent, true);
     }
 }
 
@@ -391,31 +408,31 @@ void DeclStmt::Visit() {
     for (auto decl : decl_list) src.GetNode(decl).Visit();
 }
 
-void DeclStmt::Dump(std::ostream &ostream,
+void DeclStmt::Dump(util::Emitter &emitter,
                     const std::string &indent,
                     const bool is_last) const {
-    DumpIndentAndBranch(ostream, indent, is_last);
-    DumpInfo(ostream, "DeclStmt");
+    DumpIndentAndBranch(emitter, indent, is_last);
+    DumpInfo(emitter, "DeclStmt");
     // newline
-    ostream << std::endl;
+    emitter << '\n';
     // decl list
     const std::string child_indent = indent + (is_last ? "  " : "| ");
     auto iter = decl_list.cbegin();
     for (; iter != decl_list.cend() - 1; ++iter) {
-        src.GetDecl(*iter).Dump(ostream, child_indent, false);
+        src.GetDecl(*iter).Dump(emitter, child_indent, false);
     }
-    src.GetDecl(*iter).Dump(ostream, child_indent, true);
+    src.GetDecl(*iter).Dump(emitter, child_indent, true);
 }
 
 /* class NullStmt */
 
-void NullStmt::Dump(std::ostream &ostream,
+void NullStmt::Dump(util::Emitter &emitter,
                     const std::string &indent,
                     const bool is_last) const {
-    DumpIndentAndBranch(ostream, indent, is_last);
-    DumpInfo(ostream, "NullStmt");
+    DumpIndentAndBranch(emitter, indent, is_last);
+    DumpInfo(emitter, "NullStmt");
     // newline
-    ostream << std::endl;
+    emitter << '\n';
 }
 
 /* class IfStmt */
@@ -432,20 +449,20 @@ void IfStmt::Visit() {
     if (has_else) src.GetNode(else_stmt).Visit();
 }
 
-void IfStmt::Dump(std::ostream &ostream,
+void IfStmt::Dump(util::Emitter &emitter,
                   const std::string &indent,
                   const bool is_last) const {
-    DumpIndentAndBranch(ostream, indent, is_last);
-    DumpInfo(ostream, "IfStmt");
+    DumpIndentAndBranch(emitter, indent, is_last);
+    DumpInfo(emitter, "IfStmt");
     const std::string child_indent = indent + (is_last ? "  " : "| ");
     // newline
-    ostream << std::endl;
+    emitter << '\n';
     // cond
-    GetCond().Dump(ostream, child_indent, false);
+    GetCond().Dump(emitter, child_indent, false);
     // then
-    GetThen().Dump(ostream, child_indent, !has_else);
+    GetThen().Dump(emitter, child_indent, !has_else);
     // else
-    if (has_else) GetElse().Dump(ostream, child_indent, true);
+    if (has_else) GetElse().Dump(emitter, child_indent, true);
 }
 
 /* class WhileStmt */
@@ -460,40 +477,40 @@ void WhileStmt::Visit() {
     src.GetNode(body).Visit();
 }
 
-void WhileStmt::Dump(std::ostream &ostream,
+void WhileStmt::Dump(util::Emitter &emitter,
                      const std::string &indent,
                      const bool is_last) const {
-    DumpIndentAndBranch(ostream, indent, is_last);
-    DumpInfo(ostream, "WhileStmt");
+    DumpIndentAndBranch(emitter, indent, is_last);
+    DumpInfo(emitter, "WhileStmt");
     // newline
-    ostream << std::endl;
+    emitter << '\n';
     // cond
     const std::string child_indent = indent + (is_last ? "  " : "| ");
-    GetCond().Dump(ostream, child_indent, false);
+    GetCond().Dump(emitter, child_indent, false);
     // then
-    GetBody().Dump(ostream, child_indent, true);
+    GetBody().Dump(emitter, child_indent, true);
 }
 
 /* class ContinueStmt */
 
-void ContinueStmt::Dump(std::ostream &ostream,
+void ContinueStmt::Dump(util::Emitter &emitter,
                         const std::string &indent,
                         const bool is_last) const {
-    DumpIndentAndBranch(ostream, indent, is_last);
-    DumpInfo(ostream, "ContinueStmt");
+    DumpIndentAndBranch(emitter, indent, is_last);
+    DumpInfo(emitter, "ContinueStmt");
     // newline
-    ostream << std::endl;
+    emitter << '\n';
 }
 
 /* class BreakStmt */
 
-void BreakStmt::Dump(std::ostream &ostream,
+void BreakStmt::Dump(util::Emitter &emitter,
                      const std::string &indent,
                      const bool is_last) const {
-    DumpIndentAndBranch(ostream, indent, is_last);
-    DumpInfo(ostream, "BreakStmt");
+    DumpIndentAndBranch(emitter, indent, is_last);
+    DumpInfo(emitter, "BreakStmt");
     // newline
-    ostream << std::endl;
+    emitter << '\n';
 }
 
 /* class ReturnStmt */
@@ -506,46 +523,48 @@ void ReturnStmt::Visit() {
     if (has_expr) src.GetNode(expr).Visit();
 }
 
-void ReturnStmt::Dump(std::ostream &ostream,
+void ReturnStmt::Dump(util::Emitter &emitter,
                       const std::string &indent,
                       const bool is_last) const {
-    DumpIndentAndBranch(ostream, indent, is_last);
-    DumpInfo(ostream, "ReturnStmt");
+    DumpIndentAndBranch(emitter, indent, is_last);
+    DumpInfo(emitter, "ReturnStmt");
     // newline
-    ostream << std::endl;
+    emitter << '\n';
     // expr
     if (has_expr) {
         const std::string child_indent = indent + (is_last ? "  " : "| ");
-        GetExpr().Dump(ostream, child_indent, true);
+        GetExpr().Dump(emitter, child_indent, true);
     }
 }
 
 /* class Expr */
 
-void Expr::DumpConstExpr(std::ostream &ostream) const {
+void Expr::DumpConstExpr(util::Emitter &emitter) const {
     if (is_const) {
-        ostream << " const expr "
-                << util::FormatTerminalBold(std::to_string(value),
-                                            util::kFGBrightCyan);
+        char digit[20];
+        const std::string_view text(digit,
+                                    util::FormatInt(digit, value) - digit);
+        emitter << " const expr "
+                << util::Colored{text, util::kFGBrightCyan, true};
     }
 }
 
 /* class IntegerLiteral */
 
-void IntegerLiteral::Dump(std::ostream &ostream,
+void IntegerLiteral::Dump(util::Emitter &emitter,
                           const std::string &indent,
                           const bool is_last) const {
-    DumpIndentAndBranch(ostream, indent, is_last);
+    DumpIndentAndBranch(emitter, indent, is_last);
     if (is_filler) {
-        ostream << util::FormatTerminal("array_filler:", util::kFGBlue) << ' ';
+        emitter << util::Colored{"array_filler:", util::kFGBlue} << ' ';
     }
-    DumpInfo(ostream, "IntegerLiteral");
+    DumpInfo(emitter, "IntegerLiteral");
     // value type
-    ostream << ' ' << util::FormatTerminal("'int'", util::kFGGreen);
+    emitter << ' ' << util::Colored{"'int'", util::kFGGreen};
     // value
-    DumpConstExpr(ostream);
+    DumpConstExpr(emitter);
     // newline
-    ostream << std::endl;
+    emitter << '\n';
 }
 
 /* class ParenExpr */
@@ -559,20 +578,20 @@ void ParenExpr::Visit() {
     value = expr.GetValue();
 }
 
-void ParenExpr::Dump(std::ostream &ostream,
+void ParenExpr::Dump(util::Emitter &emitter,
                      const std::string &indent,
                      const bool is_last) const {
-    DumpIndentAndBranch(ostream, indent, is_last);
-    DumpInfo(ostream, "ConstExpr");
+    DumpIndentAndBranch(emitter, indent, is_last);
+    DumpInfo(emitter, "ConstExpr");
     // value type
-    ostream << ' ' << util::FormatTerminal("'int'", util::kFGGreen);
+    emitter << ' ' << util::Colored{"'int'", util::kFGGreen};
     // value
-    DumpConstExpr(ostream);
+    DumpConstExpr(emitter);
     // newline
-    ostream << std::endl;
+    emitter << '\n';
     // expr
     const std::string child_indent = indent + (is_last ? "  " : "| ");
-    GetSubExpr().Dump(ostream, child_indent, true);
+    GetSubExpr().Dump(emitter, child_indent, true);
 }
 
 /* class DeclRefExpr */
@@ -606,40 +625,40 @@ void DeclRefExpr::Visit() {
     CalculateValue();
 }
 
-void DeclRefExpr::Dump(std::ostream &ostream,
+void DeclRefExpr::Dump(util::Emitter &emitter,
                        const std::string &indent,
                        const bool is_last) const {
-    DumpIndentAndBranch(ostream, indent, is_last);
-    DumpInfo(ostream, "DeclRefExpr");
+    DumpIndentAndBranch(emitter, indent, is_last);
+    DumpInfo(emitter, "DeclRefExpr");
     // type
-    ostream << ' '
-            << util::FormatTerminal('\'' + TypeStr() + '\'', util::kFGGreen);
+    emitter << ' '
+            << util::Colored{'\'' + TypeStr() + '\'', util::kFGGreen};
     // lvalue var ref
-    ostream << ' ' << util::FormatTerminal("lvalue Var", util::kFGCyan);
+    emitter << ' ' << util::Colored{"lvalue Var", util::kFGCyan};
     // ref location
-    ostream << ' '
-            << util::FormatTerminal(
-                   has_ref ? util::FormatHex32(ref) : "unknown",
-                   util::kFGYellow);
+    emitter << ' '
+            << util::Colored{has_ref ? util::FormatHex32(ref) : "unknown",
+                             util::kFGYellow};
     // ref name
-    ostream << ' ' << GetIdentToken().DumpTextRef();
+    emitter << ' ';
+    GetIdentToken().DumpTextRef(emitter);
     // ref type
-    ostream << ' '
-            << util::FormatTerminal(
+    emitter << ' '
+            << util::Colored{
                    has_ref ? ('\'' + GetRef().TypeStr() + '\'') : "'unknown'",
-                   util::kFGGreen);
+                   util::kFGGreen};
     // value
-    DumpConstExpr(ostream);
+    DumpConstExpr(emitter);
     // newline
-    ostream << std::endl;
+    emitter << '\n';
     // arr dim
     if (!arr_dim_list.empty()) {
         const std::string child_indent = indent + (is_last ? "  " : "| ");
         auto iter = arr_dim_list.cbegin();
         for (; iter != arr_dim_list.cend() - 1; ++iter) {
-            src.GetExpr(*iter).Dump(ostream, child_indent, false);
+            src.GetExpr(*iter).Dump(emitter, child_indent, false);
         }
-        src.GetExpr(*iter).Dump(ostream, child_indent, true);
+        src.GetExpr(*iter).Dump(emitter, child_indent, true);
     }
 }
 
@@ -719,38 +738,38 @@ void CallExpr::Visit() {
     FindRef();
 }
 
-void CallExpr::Dump(std::ostream &ostream,
+void CallExpr::Dump(util::Emitter &emitter,
                     const std::string &indent,
                     const bool is_last) const {
-    DumpIndentAndBranch(ostream, indent, is_last);
-    DumpInfo(ostream, "CallExpr");
+    DumpIndentAndBranch(emitter, indent, is_last);
+    DumpInfo(emitter, "CallExpr");
     // type
-    ostream << ' '
-            << util::FormatTerminal('\'' + TypeStr() + '\'', util::kFGGreen);
+    emitter << ' '
+            << util::Colored{'\'' + TypeStr() + '\'', util::kFGGreen};
     // function ref
-    ostream << ' ' << util::FormatTerminal("function", util::kFGCyan);
+    emitter << ' ' << util::Colored{"function", util::kFGCyan};
     // ref location
-    ostream << ' '
-            << util::FormatTerminal(
-                   has_ref ? util::FormatHex32(ref) : "unknown",
-                   util::kFGYellow);
+    emitter << ' '
+            << util::Colored{has_ref ? util::FormatHex32(ref) : "unknown",
+                             util::kFGYellow};
     // ref name
-    ostream << ' ' << GetIdentToken().DumpTextRef();
+    emitter << ' ';
+    GetIdentToken().DumpTextRef(emitter);
     // ref type
-    ostream << ' '
-            << util::FormatTerminal(
+    emitter << ' '
+            << util::Colored{
                    has_ref ? ('\'' + GetRef().TypeStr() + '\'') : "'unknown'",
-                   util::kFGGreen);
+                   util::kFGGreen};
     // newline
-    ostream << std::endl;
+    emitter << '\n';
     // param list
     if (!param_list.empty()) {
         const std::string child_indent = indent + (is_last ? "  " : "| ");
         auto iter = param_list.cbegin();
         for (; iter != param_list.cend() - 1; ++iter) {
-            src.GetNode(*iter).Dump(ostream, child_indent, false);
+            src.GetNode(*iter).Dump(emitter, child_indent, false);
         }
-        src.GetNode(*iter).Dump(ostream, child_indent, true);
+        src.GetNode(*iter).Dump(emitter, child_indent, true);
     }
 }
 
@@ -786,35 +805,36 @@ void BinaryOperator::Visit() {
     CalculateValue();
 }
 
-void BinaryOperator::Dump(std::ostream &ostream,
+void BinaryOperator::Dump(util::Emitter &emitter,
                           const std::string &indent,
                           const bool is_last) const {
-    DumpIndentAndBranch(ostream, indent, is_last);
-    DumpInfo(ostream, "BinaryOperator");
+    DumpIndentAndBranch(emitter, indent, is_last);
+    DumpInfo(emitter, "BinaryOperator");
     // value type
-    ostream << ' ' << util::FormatTerminal("'int'", util::kFGGreen);
+    emitter << ' ' << util::Colored{"'int'", util::kFGGreen};
     // op
     static std::array<std::string, kAssign + 1> binary_op{
         "'+'",  "'-'",  "'*'", "'/'",  "'%'", "'||'", "'&&'",
         "'=='", "'!='", "'<'", "'<='", "'>'", "'>='", "'='"};
-    ostream << ' ' << binary_op[op_code];
+    emitter << ' ' << binary_op[op_code];
     // value
-    DumpConstExpr(ostream);
+    DumpConstExpr(emitter);
     // newline
-    ostream << std::endl;
+    emitter << '\n';
     // LHS and RHS
     const std::string child_indent = indent + (is_last ? "  " : "| ");
-    GetLHS().Dump(ostream, child_indent, false);
-    GetRHS().Dump(ostream, child_indent, true);
+    GetLHS().Dump(emitter, child_indent, false);
+    GetRHS().Dump(emitter, child_indent, true);
 }
 
 void BinaryOperator::CheckOp() const {
     if (op_code < kAdd || kAssign < op_code) {
-        std::stringstream dump;
-        GetLHS().Dump(dump, "", true);
-        dump << "\nop_code: " << std::to_string(op_code) << '\n';
-        GetRHS().Dump(dump, "", true);
-        throw InvalidOperatorException(dump.str());
+        std::string dump;
+        util::Emitter emitter(dump);
+        GetLHS().Dump(emitter, "", true);
+        emitter << "\nop_code: " << op_code << '\n';
+        GetRHS().Dump(emitter, "", true);
+        throw InvalidOperatorException(dump);
     }
 }
 
@@ -882,31 +902,32 @@ void UnaryOperator::Visit() {
     CalculateValue();
 }
 
-void UnaryOperator::Dump(std::ostream &ostream,
+void UnaryOperator::Dump(util::Emitter &emitter,
                          const std::string &indent,
                          const bool is_last) const {
-    DumpIndentAndBranch(ostream, indent, is_last);
-    DumpInfo(ostream, "UnaryOperator");
+    DumpIndentAndBranch(emitter, indent, is_last);
+    DumpInfo(emitter, "UnaryOperator");
     // value type
-    ostream << ' ' << util::FormatTerminal("'int'", util::kFGGreen);
+    emitter << ' ' << util::Colored{"'int'", util::kFGGreen};
     // op
     static std::array<std::string, kNot + 1> unary_op{"'+'", "'-'", "'!'"};
-    ostream << " prefix " << unary_op[op_code];
+    emitter << " prefix " << unary_op[op_code];
     // value
-    DumpConstExpr(ostream);
+    DumpConstExpr(emitter);
     // newline
-    ostream << std::endl;
+    emitter << '\n';
     // sub expr
     const std::string child_indent = indent + (is_last ? "  " : "| ");
-    GetSubExpr().Dump(ostream, child_indent, true);
+    GetSubExpr().Dump(emitter, child_indent, true);
 }
 
 void UnaryOperator::CheckOp() const {
     if (op_code < kPlus || kNot < op_code) {
-        std::stringstream dump;
-        dump << "op_code: " << std::to_string(op_code) << '\n';
-        GetSubExpr().Dump(dump, "", true);
-        throw InvalidOperatorException(dump.str());
+        std::string dump;
+        util::Emitter emitter(dump);
+        emitter << "op_code: " << op_code << '\n';
+        GetSubExpr().Dump(emitter, "", true);
+        throw InvalidOperatorException(dump);
     }
 }
 
@@ -1002,24 +1023,24 @@ void InitListExpr::Visit() {
     CalculateValue();
 }
 
-void InitListExpr::Dump(std::ostream &ostream,
+void InitListExpr::Dump(util::Emitter &emitter,
                         const std::string &indent,
                         const bool is_last) const {
-    DumpIndentAndBranch(ostream, indent, is_last);
+    DumpIndentAndBranch(emitter, indent, is_last);
     if (is_filler) {
-        ostream << util::FormatTerminal("array_filler:", util::kFGBlue) << ' ';
+        emitter << util::Colored{"array_filler:", util::kFGBlue} << ' ';
     }
-    DumpInfo(ostream, "ArrayInitList");
+    DumpInfo(emitter, "ArrayInitList");
     // type
-    ostream << ' '
-            << util::FormatTerminal('\'' + TypeStr() + '\'', util::kFGGreen);
+    emitter << ' '
+            << util::Colored{'\'' + TypeStr() + '\'', util::kFGGreen};
     // newline
-    ostream << std::endl;
+    emitter << '\n';
     // init list
     if (!init_list.empty()) {
         const std::string child_indent = indent + (is_last ? "  " : "| ");
         for (auto iter = init_list.cbegin(); iter != init_list.cend(); ++iter) {
-            src.GetExpr(*iter).Dump(ostream, child_indent,
+            src.GetExpr(*iter).Dump(emitter, child_indent,
                                     *iter == init_list.back());
         }
     }
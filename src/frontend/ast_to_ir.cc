@@ -26,7 +26,21 @@ static std::stack<std::list<std::shared_ptr<ir::BasicBlock>>> continue_stack;
 static std::stack<std::list<std::shared_ptr<ir::BasicBlock>>> true_stack;
 static std::stack<std::list<std::shared_ptr<ir::BasicBlock>>> false_stack;
 
+// a T in the arena of the module being built
+template <typename T, typename... Args>
+static std::shared_ptr<T> Make(Args &&...args) {
+    return module->Make<T>(std::forward<Args>(args)...);
+}
+
 int AstToIR() {
+    // a fresh module per file, what the last one made goes with its arena,
+    // so no handle into it may be left behind
+    node_map.clear();
+    break_stack = {};
+    continue_stack = {};
+    true_stack = {};
+    false_stack = {};
+    module = std::make_shared<ir::Module>();
     ast::TranslationUnit &root = ast_manager.GetRoot();
     for (auto decl_loc : root.GetDeclList()) {
         auto &decl = ast_manager.GetDecl(decl_loc);
@@ -53,9 +67,9 @@ ir::Type *GetVarType(const ast::VarDecl &decl) {
 }
 
 void TranslateGlobalVarDecl(const ast::VarDecl &decl) {
-    auto global_var = std::make_shared<ir::GlobalVar>(GetVarType(decl),
-                                                      decl.GetIdentName());
-    auto global_var_ptr = std::make_shared<ir::GlobalVar>(
+    auto global_var = Make<ir::GlobalVar>(GetVarType(decl),
+                                          decl.GetIdentName());
+    auto global_var_ptr = Make<ir::GlobalVar>(
         new ir::PtrType(GetVarType(decl)), decl.GetIdentName());
     node_map.emplace(decl.GetLocation(), global_var_ptr);
 
@@ -63,20 +77,20 @@ void TranslateGlobalVarDecl(const ast::VarDecl &decl) {
     std::vector<std::shared_ptr<ir::Imm>> init_list;
     if (decl.IsArray()) {
         if (!decl.HasInit() || decl.GetInitList().GetInitList().empty()) {
-            module->AddVar(new ir::GlobalVarDef(global_var, decl.IsConst(),
-                                                init_list, true));
+            module->AddVar(Make<ir::GlobalVarDef>(global_var, decl.IsConst(),
+                                                  init_list, true));
         } else {
             for (auto init_val : decl.GetInitList().GetInitMap()) {
-                init_list.emplace_back(new ir::Imm(init_val));
+                init_list.emplace_back(Make<ir::Imm>(init_val));
             }
-            module->AddVar(new ir::GlobalVarDef(global_var, decl.IsConst(),
-                                                init_list, false));
+            module->AddVar(Make<ir::GlobalVarDef>(global_var, decl.IsConst(),
+                                                  init_list, false));
         }
     } else {
         int init_val = decl.HasInit() ? decl.GetInit().GetValue() : 0;
-        init_list.emplace_back(new ir::Imm(init_val));
-        module->AddVar(
-            new ir::GlobalVarDef(global_var, decl.IsConst(), init_list, false));
+        init_list.emplace_back(Make<ir::Imm>(init_val));
+        module->AddVar(Make<ir::GlobalVarDef>(global_var, decl.IsConst(),
+                                              init_list, false));
     }
 }
 
@@ -84,46 +98,47 @@ void TranslateLocalVarDecl(const std::shared_ptr<ir::FuncDef> &def,
                            const std::shared_ptr<ir::BasicBlock> &bb,
                            const ast::VarDecl &decl,
                            int &tmp_id) {
-    auto local_var_ptr = std::make_shared<ir::TmpVar>(
+    auto local_var_ptr = Make<ir::TmpVar>(
         new ir::PtrType(GetVarType(decl)), tmp_id++);
     node_map.emplace(decl.GetLocation(), local_var_ptr);
 
-    bb->AddInst(new ir::AllocaInst(local_var_ptr));
+    bb->AddInst(Make<ir::AllocaInst>(local_var_ptr));
 
     if (decl.HasInit()) {
         if (decl.IsArray()) {
             auto list = decl.GetInitList().GetInitMapExpr();
             auto new_local_var_ptr
-                = std::make_shared<ir::TmpVar>(new ir::PtrType, tmp_id++);
-            bb->AddInst(new ir::BitcastInst(new_local_var_ptr, local_var_ptr));
+                = Make<ir::TmpVar>(ir::PtrType::Get(), tmp_id++);
+            bb->AddInst(
+                Make<ir::BitcastInst>(new_local_var_ptr, local_var_ptr));
             int offset = 0;
             for (auto value : list) {
                 std::shared_ptr<ir::Value> init_val;
                 if (value.first) {
                     const auto &expr = ast_manager.GetExpr(value.second);
                     if (expr.IsConst()) {
-                        init_val.reset(new ir::Imm(expr.GetValue()));
+                        init_val = Make<ir::Imm>(expr.GetValue());
                     } else {
                         init_val = TranslateExpr(def, bb, expr, tmp_id);
                     }
                 } else {
-                    init_val.reset(new ir::Imm(0));
+                    init_val = Make<ir::Imm>(0);
                 }
-                auto addr
-                    = std::make_shared<ir::TmpVar>(new ir::PtrType, tmp_id++);
-                auto idx = std::make_shared<ir::Imm>(offset++);
-                bb->AddInst(
-                    new ir::GetelementptrInst(addr, new_local_var_ptr, {idx}));
-                bb->AddInst(new ir::StoreInst(init_val, addr));
+                auto addr = Make<ir::TmpVar>(ir::PtrType::Get(), tmp_id++);
+                std::vector<std::shared_ptr<ir::Value>> idx_list{
+                    Make<ir::Imm>(offset++)};
+                bb->AddInst(Make<ir::GetelementptrInst>(
+                    addr, new_local_var_ptr, std::move(idx_list)));
+                bb->AddInst(Make<ir::StoreInst>(init_val, addr));
             }
         } else {
             std::shared_ptr<ir::Value> init_val;
             if (decl.GetInit().IsConst()) {
-                init_val.reset(new ir::Imm(decl.GetInit().GetValue()));
+                init_val = Make<ir::Imm>(decl.GetInit().GetValue());
             } else {
                 init_val = TranslateExpr(def, bb, decl.GetInit(), tmp_id);
             }
-            bb->AddInst(new ir::StoreInst(init_val, local_var_ptr));
+            bb->AddInst(Make<ir::StoreInst>(init_val, local_var_ptr));
         }
     }
 }
@@ -135,9 +150,9 @@ void TranslateParamVarDecl(const std::shared_ptr<ir::BasicBlock> &bb,
     std::shared_ptr<ir::Type> local_type
         = std::make_shared<ir::PtrType>(param->GetTypePtr());
 
-    auto param_local = std::make_shared<ir::TmpVar>(local_type, tmp_id++);
-    bb->AddInst(new ir::AllocaInst(param_local));
-    bb->AddInst(new ir::StoreInst(param, param_local));
+    auto param_local = Make<ir::TmpVar>(local_type, tmp_id++);
+    bb->AddInst(Make<ir::AllocaInst>(param_local));
+    bb->AddInst(Make<ir::StoreInst>(param, param_local));
     node_map[decl.GetLocation()] = param_local;
 }
 
@@ -165,26 +180,25 @@ void TranslateFunctionDecl(const ast::FunctionDecl &decl) {
             type = std::make_shared<ir::PtrType>(
                 new ir::ArrayType(arr_dim_list));
         } else if (param.IsPtr()) {
-            type = std::make_shared<ir::PtrType>(
-                new ir::IntType(ir::IntType::kI32));
+            type = ir::PtrType::Get();
         } else {
-            type = std::make_shared<ir::IntType>(ir::IntType::kI32);
+            type = ir::IntType::Get(ir::IntType::kI32);
         }
 
         param_type_list.emplace_back(type);
-        auto tmp_var = std::make_shared<ir::TmpVar>(type, tmp_id++);
+        auto tmp_var = Make<ir::TmpVar>(type, tmp_id++);
         node_map.emplace(param_loc, tmp_var);
         param_list.emplace_back(tmp_var);
     }
 
-    auto func = std::make_shared<ir::GlobalVar>(
+    auto func = Make<ir::GlobalVar>(
         new ir::FuncType(ret_type, param_type_list), decl.GetIdentName());
     node_map.emplace(decl.GetLocation(), func);
     if (decl.HasDef()) {
         auto func_def = std::make_shared<ir::FuncDef>(func, param_list);
         module->AddFuncDef(func_def);
-        auto bb = std::make_shared<ir::BasicBlock>(
-            new ir::LocalVar(new ir::LabelType, "entry"));
+        auto bb = Make<ir::BasicBlock>(
+            Make<ir::LocalVar>(ir::LabelType::Get(), "entry"));
         func_def->AddBlock(bb);
         for (auto param_loc : decl.GetParamList()) {
             TranslateParamVarDecl(
@@ -195,9 +209,9 @@ void TranslateFunctionDecl(const ast::FunctionDecl &decl) {
         if (bb_end->GetInstList().empty()
             || !bb_end->GetInstList().back()->IsTerminateInst()) {
             if (decl.GetType() == ast::Decl::kVoid) {
-                bb_end->AddInst(new ir::RetInst);
+                bb_end->AddInst(Make<ir::RetInst>());
             } else {
-                bb_end->AddInst(new ir::RetInst(new ir::Imm(0)));
+                bb_end->AddInst(Make<ir::RetInst>(Make<ir::Imm>(0)));
             }
         }
     } else {
@@ -223,11 +237,11 @@ std::shared_ptr<ir::BasicBlock> TranslateStmt(
             return TranslateWhileStmt(def, bb, stmt.Cast<ast::WhileStmt>(),
                                       tmp_id);
         case ast::ASTNode::kContinueStmt:
-            bb->AddInst(new ir::RetInst);
+            bb->AddInst(Make<ir::RetInst>());
             continue_stack.top().emplace_back(bb);
             return bb;
         case ast::ASTNode::kBreakStmt:
-            bb->AddInst(new ir::RetInst);
+            bb->AddInst(Make<ir::RetInst>());
             break_stack.top().emplace_back(bb);
             return bb;
         case ast::ASTNode::kReturnStmt:
@@ -278,7 +292,7 @@ std::shared_ptr<ir::BasicBlock> TranslateIfStmt(
     const std::shared_ptr<ir::BasicBlock> &bb,
     const ast::IfStmt &stmt,
     int &tmp_id) {
-    auto zero_i32 = std::make_shared<ir::Imm>(0);
+    auto zero_i32 = Make<ir::Imm>(0);
 
     const auto &cond_expr = stmt.GetCond();
     if (cond_expr.IsConst()) {
@@ -297,19 +311,17 @@ std::shared_ptr<ir::BasicBlock> TranslateIfStmt(
     if (cond_var != nullptr
         && cond_var->GetType().Cast<ir::IntType>().GetWidth()
                == ir::IntType::kI32) {
-        auto result = std::make_shared<ir::TmpVar>(
-            new ir::IntType(ir::IntType::kI1), tmp_id++);
+        auto result
+            = Make<ir::TmpVar>(ir::IntType::Get(ir::IntType::kI1), tmp_id++);
         bb->AddInst(
-            new ir::IcmpInst(ir::IcmpInst::kNE, result, cond_var, zero_i32));
+            Make<ir::IcmpInst>(ir::IcmpInst::kNE, result, cond_var, zero_i32));
         cond_var = result;
     }
 
     // Then branch
-    auto label_then = std::make_shared<ir::TmpVar>(new ir::LabelType, tmp_id++);
-    auto bb_then = std::make_shared<ir::BasicBlock>(label_then);
+    auto label_then = Make<ir::TmpVar>(ir::LabelType::Get(), tmp_id++);
+    auto bb_then = Make<ir::BasicBlock>(label_then);
     def->AddBlock(bb_then);
-    bb->AddSuccessor(bb_then);
-    bb_then->AddPredecessor(bb);
     auto then_end = TranslateStmt(def, bb_then, stmt.GetThen(), tmp_id);
 
     // Else branch
@@ -317,48 +329,38 @@ std::shared_ptr<ir::BasicBlock> TranslateIfStmt(
     std::shared_ptr<ir::BasicBlock> bb_else;
     std::shared_ptr<ir::BasicBlock> else_end;
     if (stmt.HasElse()) {
-        label_else = std::make_shared<ir::TmpVar>(new ir::LabelType, tmp_id++);
-        bb_else = std::make_shared<ir::BasicBlock>(label_else);
+        label_else = Make<ir::TmpVar>(ir::LabelType::Get(), tmp_id++);
+        bb_else = Make<ir::BasicBlock>(label_else);
         def->AddBlock(bb_else);
         else_end = TranslateStmt(def, bb_else, stmt.GetElse(), tmp_id);
     }
 
     // End branch
-    auto label_end = std::make_shared<ir::TmpVar>(new ir::LabelType, tmp_id++);
-    auto bb_end = std::make_shared<ir::BasicBlock>(label_end);
+    auto label_end = Make<ir::TmpVar>(ir::LabelType::Get(), tmp_id++);
+    auto bb_end = Make<ir::BasicBlock>(label_end);
     def->AddBlock(bb_end);
     if (then_end->GetInstList().empty()
         || then_end->GetInstList().back()->kind != ir::Inst::kRet) {
-        then_end->AddInst(new ir::BrInst(label_end));
-        then_end->AddSuccessor(bb_end);
-        bb_end->AddPredecessor(then_end);
+        then_end->AddInst(Make<ir::BrInst>(label_end));
     }
     if (stmt.HasElse()) {
         if (else_end->GetInstList().empty()
             || else_end->GetInstList().back()->kind != ir::Inst::kRet) {
-            else_end->AddInst(new ir::BrInst(label_end));
-            else_end->AddSuccessor(bb_end);
-            bb_end->AddPredecessor(else_end);
+            else_end->AddInst(Make<ir::BrInst>(label_end));
         }
         if (cond_var != nullptr) {
-            bb->AddInst(new ir::BrInst(cond_var, label_then, label_else));
-            bb->AddSuccessor(bb_else);
-            bb_else->AddPredecessor(bb);
+            bb->AddInst(Make<ir::BrInst>(cond_var, label_then, label_else));
             true_stack.pop();
             false_stack.pop();
             return bb_end;
         }
     }
     if (cond_var != nullptr) {
-        bb->AddInst(new ir::BrInst(cond_var, label_then, label_end));
-        bb->AddSuccessor(bb_end);
-        bb_end->AddPredecessor(bb);
+        bb->AddInst(Make<ir::BrInst>(cond_var, label_then, label_end));
     }
 
     for (const auto &bb_true : true_stack.top()) {
         bb_true->GetInstList().back()->Cast<ir::BrInst>().SetTrue(label_then);
-        bb_true->AddSuccessor(bb_then);
-        bb_then->AddPredecessor(bb_true);
     }
     true_stack.pop();
 
@@ -366,13 +368,9 @@ std::shared_ptr<ir::BasicBlock> TranslateIfStmt(
         if (stmt.HasElse()) {
             bb_false->GetInstList().back()->Cast<ir::BrInst>().SetFalse(
                 label_else);
-            bb_false->AddSuccessor(bb_else);
-            bb_else->AddPredecessor(bb_false);
             continue;
         }
         bb_false->GetInstList().back()->Cast<ir::BrInst>().SetFalse(label_end);
-        bb_false->AddSuccessor(bb_end);
-        bb_end->AddPredecessor(bb_false);
     }
     false_stack.pop();
 
@@ -385,7 +383,7 @@ std::shared_ptr<ir::BasicBlock> TranslateWhileStmt(
     const ast::WhileStmt &stmt,
     int &tmp_id) {
     const auto &cond_expr = stmt.GetCond();
-    auto zero_i32 = std::make_shared<ir::Imm>(0);
+    auto zero_i32 = Make<ir::Imm>(0);
 
     if (cond_expr.IsConst()) {
         if (cond_expr.GetValue() == 0) return bb;
@@ -398,13 +396,10 @@ std::shared_ptr<ir::BasicBlock> TranslateWhileStmt(
     false_stack.emplace();
 
     // Check branch
-    auto label_check
-        = std::make_shared<ir::TmpVar>(new ir::LabelType, tmp_id++);
-    auto bb_check = std::make_shared<ir::BasicBlock>(label_check);
+    auto label_check = Make<ir::TmpVar>(ir::LabelType::Get(), tmp_id++);
+    auto bb_check = Make<ir::BasicBlock>(label_check);
     def->AddBlock(bb_check);
-    bb->AddInst(new ir::BrInst(label_check));
-    bb->AddSuccessor(bb_check);
-    bb_check->AddPredecessor(bb);
+    bb->AddInst(Make<ir::BrInst>(label_check));
 
     std::shared_ptr<ir::Value> cond_var;
     if (!cond_expr.IsConst()) {
@@ -412,67 +407,56 @@ std::shared_ptr<ir::BasicBlock> TranslateWhileStmt(
         if (cond_var != nullptr
             && cond_var->GetType().Cast<ir::IntType>().GetWidth()
                    == ir::IntType::kI32) {
-            auto result = std::make_shared<ir::TmpVar>(
-                new ir::IntType(ir::IntType::kI1), tmp_id++);
-            bb_check->AddInst(new ir::IcmpInst(ir::IcmpInst::kNE, result,
-                                               cond_var, zero_i32));
+            auto result = Make<ir::TmpVar>(ir::IntType::Get(ir::IntType::kI1),
+                                           tmp_id++);
+            bb_check->AddInst(Make<ir::IcmpInst>(ir::IcmpInst::kNE, result,
+                                                 cond_var, zero_i32));
             cond_var = result;
         }
     }
 
     // Body branch
-    auto label_body = std::make_shared<ir::TmpVar>(new ir::LabelType, tmp_id++);
-    auto bb_body = std::make_shared<ir::BasicBlock>(label_body);
+    auto label_body = Make<ir::TmpVar>(ir::LabelType::Get(), tmp_id++);
+    auto bb_body = Make<ir::BasicBlock>(label_body);
     def->AddBlock(bb_body);
-    bb_check->AddSuccessor(bb_body);
-    bb_body->AddPredecessor(bb_check);
     auto body_end = TranslateStmt(def, bb_body, stmt.GetBody(), tmp_id);
     if (body_end->GetInstList().empty()
         || body_end->GetInstList().back()->kind != ir::Inst::kRet) {
-        body_end->AddInst(new ir::BrInst(label_check));
-        bb_body->AddSuccessor(bb_check);
-        bb_check->AddPredecessor(bb_body);
+        body_end->AddInst(Make<ir::BrInst>(label_check));
     }
 
     // End branch
-    auto label_end = std::make_shared<ir::TmpVar>(new ir::LabelType, tmp_id++);
-    auto bb_end = std::make_shared<ir::BasicBlock>(label_end);
+    auto label_end = Make<ir::TmpVar>(ir::LabelType::Get(), tmp_id++);
+    auto bb_end = Make<ir::BasicBlock>(label_end);
     def->AddBlock(bb_end);
     if (cond_expr.IsConst()) {
-        bb_check->AddInst(new ir::BrInst(label_body));
+        bb_check->AddInst(Make<ir::BrInst>(label_body));
     } else {
         if (cond_var != nullptr) {
-            bb_check->AddInst(new ir::BrInst(cond_var, label_body, label_end));
+            bb_check->AddInst(
+                Make<ir::BrInst>(cond_var, label_body, label_end));
         }
     }
 
     for (const auto &bb_break : break_stack.top()) {
         bb_break->GetInstList().pop_back();
-        bb_break->AddInst(new ir::BrInst(label_end));
-        bb_break->AddSuccessor(bb_end);
-        bb_end->AddPredecessor(bb_break);
+        bb_break->AddInst(Make<ir::BrInst>(label_end));
     }
     break_stack.pop();
 
     for (const auto &bb_continue : continue_stack.top()) {
         bb_continue->GetInstList().pop_back();
-        bb_continue->AddInst(new ir::BrInst(label_check));
-        bb_continue->AddSuccessor(bb_check);
-        bb_check->AddPredecessor(bb_continue);
+        bb_continue->AddInst(Make<ir::BrInst>(label_check));
     }
     continue_stack.pop();
 
     for (const auto &bb_true : true_stack.top()) {
         bb_true->GetInstList().back()->Cast<ir::BrInst>().SetTrue(label_body);
-        bb_true->AddSuccessor(bb_body);
-        bb_body->AddPredecessor(bb_true);
     }
     true_stack.pop();
 
     for (const auto &bb_false : false_stack.top()) {
         bb_false->GetInstList().back()->Cast<ir::BrInst>().SetFalse(label_end);
-        bb_false->AddSuccessor(bb_end);
-        bb_end->AddPredecessor(bb_false);
     }
     false_stack.pop();
 
@@ -486,13 +470,13 @@ void TranslateReturnStmt(const std::shared_ptr<ir::FuncDef> &def,
     if (stmt.HasExpr()) {
         std::shared_ptr<ir::Value> ret_expr;
         if (stmt.GetExpr().IsConst()) {
-            ret_expr.reset(new ir::Imm(stmt.GetExpr().GetValue()));
+            ret_expr = Make<ir::Imm>(stmt.GetExpr().GetValue());
         } else {
             ret_expr = TranslateExpr(def, bb, stmt.GetExpr(), tmp_id);
         }
-        bb->AddInst(new ir::RetInst(ret_expr));
+        bb->AddInst(Make<ir::RetInst>(ret_expr));
     } else {
-        bb->AddInst(new ir::RetInst);
+        bb->AddInst(Make<ir::RetInst>());
     }
 }
 
@@ -538,16 +522,16 @@ std::shared_ptr<ir::Value> TranslateDeclRefExpr(
         if (expr.GetRef().kind == ast::ASTNode::kVarDecl
             && expr.GetRef().Cast<ast::VarDecl>().IsArray()) {
             std::vector<std::shared_ptr<ir::Value>> idx_list;
-            idx_list.emplace_back(new ir::Imm(0));
+            idx_list.emplace_back(Make<ir::Imm>(0));
             for (auto expr_loc : expr.GetArrDimList()) {
                 const auto &expr = ast_manager.GetExpr(expr_loc);
                 if (expr.IsConst()) {
-                    idx_list.emplace_back(new ir::Imm(expr.GetValue()));
+                    idx_list.emplace_back(Make<ir::Imm>(expr.GetValue()));
                 } else {
                     idx_list.emplace_back(TranslateExpr(def, bb, expr, tmp_id));
                 }
             }
-            idx_list.emplace_back(new ir::Imm(0));
+            idx_list.emplace_back(Make<ir::Imm>(0));
 
             auto arr_dim_list = ptr->GetType()
                                     .Cast<ir::PtrType>()
@@ -557,9 +541,8 @@ std::shared_ptr<ir::Value> TranslateDeclRefExpr(
             auto ref_dim = arr_dim_list.size();
             auto index_dim = expr.GetArrDimNum();
             if (ref_dim - index_dim == 1) {
-                auto result
-                    = std::make_shared<ir::TmpVar>(new ir::PtrType, tmp_id++);
-                bb->AddInst(new ir::GetelementptrInst(result, ptr, idx_list));
+                auto result = Make<ir::TmpVar>(ir::PtrType::Get(), tmp_id++);
+                bb->AddInst(Make<ir::GetelementptrInst>(result, ptr, idx_list));
                 return result;
             }
             auto iter = arr_dim_list.cbegin();
@@ -570,9 +553,9 @@ std::shared_ptr<ir::Value> TranslateDeclRefExpr(
             }
             auto new_arr_type = std::make_shared<ir::ArrayType>(
                 std::vector<int>{iter, arr_dim_list.cend()});
-            auto result = std::make_shared<ir::TmpVar>(
+            auto result = Make<ir::TmpVar>(
                 new ir::PtrType(new_arr_type), tmp_id++);
-            bb->AddInst(new ir::GetelementptrInst(result, ptr, idx_list));
+            bb->AddInst(Make<ir::GetelementptrInst>(result, ptr, idx_list));
             return result;
         }
         // ref ParamVarDecl
@@ -580,39 +563,39 @@ std::shared_ptr<ir::Value> TranslateDeclRefExpr(
             && expr.GetRef().Cast<ast::ParamVarDecl>().IsPtr()) {
             auto param_type
                 = ptr->GetType().Cast<ir::PtrType>().GetPointeePtr();
-            auto result = std::make_shared<ir::TmpVar>(param_type, tmp_id++);
-            bb->AddInst(new ir::LoadInst(result, ptr));
+            auto result = Make<ir::TmpVar>(param_type, tmp_id++);
+            bb->AddInst(Make<ir::LoadInst>(result, ptr));
             return result;
         }
     }
 
-    if (expr.IsConst()) return std::make_shared<ir::Imm>(expr.GetValue());
+    if (expr.IsConst()) return Make<ir::Imm>(expr.GetValue());
     if (expr.IsArray()) {
         std::vector<std::shared_ptr<ir::Value>> idx_list;
         // VarDecl & ParamVarDecl
         if (expr.GetRef().kind == ast::ASTNode::kVarDecl) {
-            idx_list.emplace_back(new ir::Imm(0));
+            idx_list.emplace_back(Make<ir::Imm>(0));
         } else {
-            auto new_ptr = std::make_shared<ir::TmpVar>(
+            auto new_ptr = Make<ir::TmpVar>(
                 ptr->GetType().Cast<ir::PtrType>().GetPointeePtr(), tmp_id++);
-            bb->AddInst(new ir::LoadInst(new_ptr, ptr));
+            bb->AddInst(Make<ir::LoadInst>(new_ptr, ptr));
             ptr = new_ptr;
         }
         for (auto expr_loc : expr.GetArrDimList()) {
             const auto &expr = ast_manager.GetExpr(expr_loc);
             if (expr.IsConst()) {
-                idx_list.emplace_back(new ir::Imm(expr.GetValue()));
+                idx_list.emplace_back(Make<ir::Imm>(expr.GetValue()));
             } else {
                 idx_list.emplace_back(TranslateExpr(def, bb, expr, tmp_id));
             }
         }
-        addr = std::make_shared<ir::TmpVar>(new ir::PtrType, tmp_id++);
-        bb->AddInst(new ir::GetelementptrInst(addr, ptr, idx_list));
+        addr = Make<ir::TmpVar>(ir::PtrType::Get(), tmp_id++);
+        bb->AddInst(Make<ir::GetelementptrInst>(addr, ptr, idx_list));
     }
 
     if (need_load) {
-        auto result = std::make_shared<ir::TmpVar>(tmp_id++);
-        bb->AddInst(new ir::LoadInst(result, addr));
+        auto result = Make<ir::TmpVar>(tmp_id++);
+        bb->AddInst(Make<ir::LoadInst>(result, addr));
         return result;
     }
     return addr;
@@ -629,18 +612,18 @@ std::shared_ptr<ir::Value> TranslateCallExpr(
     for (auto expr_loc : expr.GetParamList()) {
         const auto &expr = ast_manager.GetExpr(expr_loc);
         if (expr.IsConst()) {
-            param_list.emplace_back(new ir::Imm(expr.GetValue()));
+            param_list.emplace_back(Make<ir::Imm>(expr.GetValue()));
         } else {
             param_list.emplace_back(TranslateExpr(def, bb, expr, tmp_id));
         }
     }
     if (has_ret) {
-        auto result = std::make_shared<ir::TmpVar>(tmp_id++);
-        bb->AddInst(new ir::CallInst(result, func, param_list));
+        auto result = Make<ir::TmpVar>(tmp_id++);
+        bb->AddInst(Make<ir::CallInst>(result, func, param_list));
         return result;
     }
     if (expr.GetRef().GetType() == ast::Decl::kInt) tmp_id++;
-    bb->AddInst(new ir::CallInst(func, param_list));
+    bb->AddInst(Make<ir::CallInst>(func, param_list));
     return nullptr;
 }
 
@@ -654,20 +637,20 @@ std::shared_ptr<ir::Value> TranslateBinaryOperator(
         return TranslateCondOperator(def, bb, expr, tmp_id);
     }
 
-    auto zero_i32 = std::make_shared<ir::Imm>(0);
-    auto zero_i1 = std::make_shared<ir::Imm>(false);
+    auto zero_i32 = Make<ir::Imm>(0);
+    auto zero_i1 = Make<ir::Imm>(false);
 
     std::shared_ptr<ir::TmpVar> result;
     std::shared_ptr<ir::Value> lhs;
     std::shared_ptr<ir::Value> rhs;
 
     if (expr.GetLHS().IsConst()) {
-        lhs.reset(new ir::Imm(expr.GetLHS().GetValue()));
+        lhs = Make<ir::Imm>(expr.GetLHS().GetValue());
     } else {
         lhs = TranslateExpr(def, bb, expr.GetLHS(), tmp_id);
     }
     if (expr.GetRHS().IsConst()) {
-        rhs.reset(new ir::Imm(expr.GetRHS().GetValue()));
+        rhs = Make<ir::Imm>(expr.GetRHS().GetValue());
     } else {
         rhs = TranslateExpr(def, bb, expr.GetRHS(), tmp_id);
     }
@@ -677,87 +660,93 @@ std::shared_ptr<ir::Value> TranslateBinaryOperator(
         && expr.op_code <= ast::BinaryOperator::kRem) {
         // lhs: i32
         if (lhs->GetType().Cast<ir::IntType>().GetWidth() == ir::IntType::kI1) {
-            auto new_lhs = std::make_shared<ir::TmpVar>(tmp_id++);
-            bb->AddInst(new ir::ZextInst(new_lhs, lhs));
+            auto new_lhs = Make<ir::TmpVar>(tmp_id++);
+            bb->AddInst(Make<ir::ZextInst>(new_lhs, lhs));
             lhs = new_lhs;
         }
         // rhs: i32
         if (rhs->GetType().Cast<ir::IntType>().GetWidth() == ir::IntType::kI1) {
-            auto new_rhs = std::make_shared<ir::TmpVar>(tmp_id++);
-            bb->AddInst(new ir::ZextInst(new_rhs, rhs));
+            auto new_rhs = Make<ir::TmpVar>(tmp_id++);
+            bb->AddInst(Make<ir::ZextInst>(new_rhs, rhs));
             rhs = new_rhs;
         }
         // result
-        result = std::make_shared<ir::TmpVar>(tmp_id++);
+        result = Make<ir::TmpVar>(tmp_id++);
     } else {
         // lhs: i32
         if (lhs->GetType().Cast<ir::IntType>().GetWidth() == ir::IntType::kI1) {
-            auto new_lhs = std::make_shared<ir::TmpVar>(tmp_id++);
-            bb->AddInst(new ir::ZextInst(new_lhs, lhs));
+            auto new_lhs = Make<ir::TmpVar>(tmp_id++);
+            bb->AddInst(Make<ir::ZextInst>(new_lhs, lhs));
             lhs = new_lhs;
         }
         // rhs: i32
         if (rhs->GetType().Cast<ir::IntType>().GetWidth() == ir::IntType::kI1) {
-            auto new_rhs = std::make_shared<ir::TmpVar>(tmp_id++);
-            bb->AddInst(new ir::ZextInst(new_rhs, rhs));
+            auto new_rhs = Make<ir::TmpVar>(tmp_id++);
+            bb->AddInst(Make<ir::ZextInst>(new_rhs, rhs));
             rhs = new_rhs;
         }
         // result
-        result = std::make_shared<ir::TmpVar>(new ir::IntType(ir::IntType::kI1),
-                                              tmp_id++);
+        result = Make<ir::TmpVar>(ir::IntType::Get(ir::IntType::kI1),
+                                  tmp_id++);
     }
 
     switch (expr.op_code) {
         // i32 op i32, i32
         case ast::BinaryOperator::kAdd:
-            bb->AddInst(
-                new ir::BinaryOpInst(ir::BinaryOpInst::kAdd, result, lhs, rhs));
+            bb->AddInst(Make<ir::BinaryOpInst>(ir::BinaryOpInst::kAdd, result,
+                                               lhs, rhs));
             break;
         case ast::BinaryOperator::kSub:
-            bb->AddInst(
-                new ir::BinaryOpInst(ir::BinaryOpInst::kSub, result, lhs, rhs));
+            bb->AddInst(Make<ir::BinaryOpInst>(ir::BinaryOpInst::kSub, result,
+                                               lhs, rhs));
             break;
         case ast::BinaryOperator::kMul:
-            bb->AddInst(
-                new ir::BinaryOpInst(ir::BinaryOpInst::kMul, result, lhs, rhs));
+            bb->AddInst(Make<ir::BinaryOpInst>(ir::BinaryOpInst::kMul, result,
+                                               lhs, rhs));
             break;
         case ast::BinaryOperator::kDiv:
-            bb->AddInst(new ir::BinaryOpInst(ir::BinaryOpInst::kSDiv, result,
-                                             lhs, rhs));
+            bb->AddInst(Make<ir::BinaryOpInst>(ir::BinaryOpInst::kSDiv,
+                                               result, lhs, rhs));
             break;
         case ast::BinaryOperator::kRem:
-            bb->AddInst(new ir::BinaryOpInst(ir::BinaryOpInst::kSRem, result,
-                                             lhs, rhs));
+            bb->AddInst(Make<ir::BinaryOpInst>(ir::BinaryOpInst::kSRem,
+                                               result, lhs, rhs));
             break;
         // i1 op i1 i1
         // case ast::BinaryOperator::kOr:
-        //     bb->AddInst(new ir::BitwiseOpInst(ir::BitwiseOpInst::kOr, result,
-        //                                       lhs, rhs));
+        //     bb->AddInst(Make<ir::BitwiseOpInst>(ir::BitwiseOpInst::kOr,
+        //                                         result, lhs, rhs));
         //     break;
         // case ast::BinaryOperator::kAnd:
-        //     bb->AddInst(new ir::BitwiseOpInst(ir::BitwiseOpInst::kAnd,
+        //     bb->AddInst(Make<ir::BitwiseOpInst>(ir::BitwiseOpInst::kAnd,
         //     result,
         //                                       lhs, rhs));
         //     break;
         // i1 op i32 i32
         // i1 op i1 i1
         case ast::BinaryOperator::kEQ:
-            bb->AddInst(new ir::IcmpInst(ir::IcmpInst::kEQ, result, lhs, rhs));
+            bb->AddInst(
+                Make<ir::IcmpInst>(ir::IcmpInst::kEQ, result, lhs, rhs));
             break;
         case ast::BinaryOperator::kNE:
-            bb->AddInst(new ir::IcmpInst(ir::IcmpInst::kNE, result, lhs, rhs));
+            bb->AddInst(
+                Make<ir::IcmpInst>(ir::IcmpInst::kNE, result, lhs, rhs));
             break;
         case ast::BinaryOperator::kLT:
-            bb->AddInst(new ir::IcmpInst(ir::IcmpInst::kSLT, result, lhs, rhs));
+            bb->AddInst(
+                Make<ir::IcmpInst>(ir::IcmpInst::kSLT, result, lhs, rhs));
             break;
         case ast::BinaryOperator::kLE:
-            bb->AddInst(new ir::IcmpInst(ir::IcmpInst::kSLE, result, lhs, rhs));
+            bb->AddInst(
+                Make<ir::IcmpInst>(ir::IcmpInst::kSLE, result, lhs, rhs));
             break;
         case ast::BinaryOperator::kGT:
-            bb->AddInst(new ir::IcmpInst(ir::IcmpInst::kSGT, result, lhs, rhs));
+            bb->AddInst(
+                Make<ir::IcmpInst>(ir::IcmpInst::kSGT, result, lhs, rhs));
             break;
         case ast::BinaryOperator::kGE:
-            bb->AddInst(new ir::IcmpInst(ir::IcmpInst::kSGE, result, lhs, rhs));
+            bb->AddInst(
+                Make<ir::IcmpInst>(ir::IcmpInst::kSGE, result, lhs, rhs));
             break;
         default:
             break;
@@ -771,9 +760,9 @@ std::shared_ptr<ir::Value> TranslateCondOperator(
     const std::shared_ptr<ir::BasicBlock> &bb,
     const ast::BinaryOperator &expr,
     int &tmp_id) {
-    auto zero_i32 = std::make_shared<ir::Imm>(0);
-    auto zero_i1 = std::make_shared<ir::Imm>(false);
-    auto one_i1 = std::make_shared<ir::Imm>(true);
+    auto zero_i32 = Make<ir::Imm>(0);
+    auto zero_i1 = Make<ir::Imm>(false);
+    auto one_i1 = Make<ir::Imm>(true);
 
     bool pass_lhs = false;
     std::shared_ptr<ir::TmpVar> label_lhs;
@@ -814,20 +803,18 @@ std::shared_ptr<ir::Value> TranslateCondOperator(
     true_stack.emplace();
     false_stack.emplace();
 
-    label_lhs = std::make_shared<ir::TmpVar>(new ir::LabelType, tmp_id++);
-    bb_lhs = std::make_shared<ir::BasicBlock>(label_lhs);
+    label_lhs = Make<ir::TmpVar>(ir::LabelType::Get(), tmp_id++);
+    bb_lhs = Make<ir::BasicBlock>(label_lhs);
     def->AddBlock(bb_lhs);
-    bb->AddSuccessor(bb_lhs);
-    bb_lhs->AddPredecessor(bb);
     // lhs: i1
     auto cond_lhs = TranslateExpr(def, bb_lhs, expr.GetLHS(), tmp_id);
     if (cond_lhs != nullptr
         && cond_lhs->GetType().Cast<ir::IntType>().GetWidth()
                == ir::IntType::kI32) {
-        auto new_lhs = std::make_shared<ir::TmpVar>(
-            new ir::IntType(ir::IntType::kI1), tmp_id++);
+        auto new_lhs
+            = Make<ir::TmpVar>(ir::IntType::Get(ir::IntType::kI1), tmp_id++);
         bb_lhs->AddInst(
-            new ir::IcmpInst(ir::IcmpInst::kNE, new_lhs, cond_lhs, zero_i32));
+            Make<ir::IcmpInst>(ir::IcmpInst::kNE, new_lhs, cond_lhs, zero_i32));
         cond_lhs = new_lhs;
     }
 
@@ -840,20 +827,18 @@ std::shared_ptr<ir::Value> TranslateCondOperator(
     true_stack.emplace();
     false_stack.emplace();
 
-    label_rhs = std::make_shared<ir::TmpVar>(new ir::LabelType, tmp_id++);
-    bb_rhs = std::make_shared<ir::BasicBlock>(label_rhs);
+    label_rhs = Make<ir::TmpVar>(ir::LabelType::Get(), tmp_id++);
+    bb_rhs = Make<ir::BasicBlock>(label_rhs);
     def->AddBlock(bb_rhs);
-    bb->AddSuccessor(bb_rhs);
-    bb_rhs->AddPredecessor(bb);
     // rhs: i1
     auto cond_rhs = TranslateExpr(def, bb_rhs, expr.GetRHS(), tmp_id);
     if (cond_rhs != nullptr
         && cond_rhs->GetType().Cast<ir::IntType>().GetWidth()
                == ir::IntType::kI32) {
-        auto new_rhs = std::make_shared<ir::TmpVar>(
-            new ir::IntType(ir::IntType::kI1), tmp_id++);
+        auto new_rhs
+            = Make<ir::TmpVar>(ir::IntType::Get(ir::IntType::kI1), tmp_id++);
         bb_rhs->AddInst(
-            new ir::IcmpInst(ir::IcmpInst::kNE, new_rhs, cond_rhs, zero_i32));
+            Make<ir::IcmpInst>(ir::IcmpInst::kNE, new_rhs, cond_rhs, zero_i32));
         cond_rhs = new_rhs;
     }
 
@@ -863,11 +848,11 @@ std::shared_ptr<ir::Value> TranslateCondOperator(
     false_stack.pop();
 
     // Link
-    bb->AddInst(new ir::BrInst(label_lhs));
+    bb->AddInst(Make<ir::BrInst>(label_lhs));
 
     // Link LHS
     if (cond_lhs != nullptr) {
-        bb_lhs->AddInst(new ir::BrInst(cond_lhs, label_rhs, label_rhs));
+        bb_lhs->AddInst(Make<ir::BrInst>(cond_lhs, label_rhs, label_rhs));
         if (expr.op_code == ast::BinaryOperator::kAnd) {
             false_stack.top().emplace_back(bb_lhs);
         } else {
@@ -895,7 +880,7 @@ std::shared_ptr<ir::Value> TranslateCondOperator(
 
     // Link RHS
     if (cond_rhs != nullptr) {
-        bb_rhs->AddInst(new ir::BrInst(cond_rhs, label_rhs, label_rhs));
+        bb_rhs->AddInst(Make<ir::BrInst>(cond_rhs, label_rhs, label_rhs));
         true_stack.top().emplace_back(bb_rhs);
         false_stack.top().emplace_back(bb_rhs);
     } else {
@@ -916,14 +901,14 @@ void TranslateAssignOperator(const std::shared_ptr<ir::FuncDef> &def,
                              int &tmp_id) {
     std::shared_ptr<ir::Value> value;
     if (expr.GetRHS().IsConst()) {
-        value = std::make_shared<ir::Imm>(expr.GetRHS().GetValue());
+        value = Make<ir::Imm>(expr.GetRHS().GetValue());
     } else {
         value = TranslateExpr(def, bb, expr.GetRHS(), tmp_id);
     }
 
     auto addr = TranslateDeclRefExpr(
         def, bb, expr.GetLHS().Cast<ast::DeclRefExpr>(), tmp_id, false);
-    bb->AddInst(new ir::StoreInst(value, addr));
+    bb->AddInst(Make<ir::StoreInst>(value, addr));
 }
 
 std::shared_ptr<ir::Value> TranslatekUnaryOperator(
@@ -933,11 +918,11 @@ std::shared_ptr<ir::Value> TranslatekUnaryOperator(
     int &tmp_id) {
     std::shared_ptr<ir::TmpVar> result;
     std::shared_ptr<ir::Value> sub_expr;
-    auto zero_i32 = std::make_shared<ir::Imm>(0);
-    auto zero_i1 = std::make_shared<ir::Imm>(false);
+    auto zero_i32 = Make<ir::Imm>(0);
+    auto zero_i1 = Make<ir::Imm>(false);
 
     if (expr.GetSubExpr().IsConst()) {
-        sub_expr.reset(new ir::Imm(expr.GetSubExpr().GetValue()));
+        sub_expr = Make<ir::Imm>(expr.GetSubExpr().GetValue());
     } else {
         sub_expr = TranslateExpr(def, bb, expr.GetSubExpr(), tmp_id);
     }
@@ -949,24 +934,24 @@ std::shared_ptr<ir::Value> TranslatekUnaryOperator(
         case ast::UnaryOperator::kMinus:
             if (sub_expr->GetType().Cast<ir::IntType>().GetWidth()
                 == ir::IntType::kI1) {
-                rhs = std::make_shared<ir::TmpVar>(
-                    new ir::IntType(ir::IntType::kI32), tmp_id++);
-                bb->AddInst(new ir::ZextInst(rhs, sub_expr));
+                rhs = Make<ir::TmpVar>(ir::IntType::Get(ir::IntType::kI32),
+                                       tmp_id++);
+                bb->AddInst(Make<ir::ZextInst>(rhs, sub_expr));
             }
-            result = std::make_shared<ir::TmpVar>(
-                new ir::IntType(ir::IntType::kI32), tmp_id++);
-            bb->AddInst(new ir::BinaryOpInst(ir::BinaryOpInst::kSub, result,
-                                             zero_i32, rhs));
+            result = Make<ir::TmpVar>(ir::IntType::Get(ir::IntType::kI32),
+                                      tmp_id++);
+            bb->AddInst(Make<ir::BinaryOpInst>(ir::BinaryOpInst::kSub, result,
+                                               zero_i32, rhs));
             break;
         case ast::UnaryOperator::kNot:
             auto rhs = sub_expr->GetType().Cast<ir::IntType>().GetWidth()
                                == ir::IntType::kI32
                            ? zero_i32
                            : zero_i1;
-            result = std::make_shared<ir::TmpVar>(
-                new ir::IntType(ir::IntType::kI1), tmp_id++);
+            result = Make<ir::TmpVar>(ir::IntType::Get(ir::IntType::kI1),
+                                      tmp_id++);
             bb->AddInst(
-                new ir::IcmpInst(ir::IcmpInst::kEQ, result, sub_expr, rhs));
+                Make<ir::IcmpInst>(ir::IcmpInst::kEQ, result, sub_expr, rhs));
             break;
     }
 
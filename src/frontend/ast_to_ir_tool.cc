@@ -1,6 +1,14 @@
+#include <unistd.h>
+
 #include <iostream>
+#include <string>
 
+#include "emitter.h"
 #include "frontend/frontend.h"
+#include "opt/if_conversion.h"
+#include "opt/mem2reg.h"
+#include "opt/simplify_cfg.h"
+#include "opt/strength_reduction.h"
 
 int main(int argc, char **argv) {
     if (argc < 2) {
@@ -14,7 +22,26 @@ int main(int argc, char **argv) {
     result = AstToIR();
     if (result != 0) return result;
 
-    module->Dump(std::cout);
+    for (int i = 2; i < argc; ++i) {
+        if (std::string(argv[i]) == "-if-conversion") {
+            opt::IfConversion if_conversion;
+            opt::RunOnModule(if_conversion, *module);
+        } else if (std::string(argv[i]) == "-strength-reduction") {
+            opt::StrengthReduction strength_reduction;
+            opt::RunOnModule(strength_reduction, *module);
+        } else if (std::string(argv[i]) == "-mem2reg") {
+            opt::Mem2Reg mem2reg;
+            opt::RunOnModule(mem2reg, *module);
+        } else if (std::string(argv[i]) == "-simplify-cfg") {
+            opt::SimplifyCFG simplify_cfg;
+            opt::RunOnModule(simplify_cfg, *module);
+        }
+    }
+
+    std::cout.flush();
+    util::Emitter emitter(STDOUT_FILENO);
+    module->Dump(emitter);
+    emitter.Flush();
 
-    return result;
+    return emitter.Good() ? result : 1;
 }
@@ -1,5 +1,9 @@
+#include <unistd.h>
+
 #include <iostream>
+#include <string>
 
+#include "emitter.h"
 #include "frontend/frontend.h"
 
 int main(int argc, char **argv) {
@@ -11,6 +15,13 @@ int main(int argc, char **argv) {
     int result = Parse(argv[1]);
     if (result != 0) return result;
 
-    ast_manager.Dump(std::cout);
-    return result;
+    // anything the parser printed goes first
+    std::cout.flush();
+    util::Emitter emitter(STDOUT_FILENO);
+    for (int i = 2; i < argc; ++i) {
+        if (std::string(argv[i]) == "-no-color") emitter.SetColor(false);
+    }
+    ast_manager.Dump(emitter);
+    emitter.Flush();
+    return emitter.Good() ? result : 1;
 }
@@ -1,6 +1,7 @@
 #include "frontend/source_manager.h"
 
 #include <ostream>
+#include <string>
 
 #include "util.h"
 
@@ -31,33 +32,57 @@ SourceRange SourceRange::operator+(const SourceRange &rhs) const {
 }
 
 std::string SourceRange::DumpBegin() const {
-    return "line:" + std::to_string(begin_line) + ':'
-           + std::to_string(begin_column);
+    std::string str;
+    util::Emitter emitter(str);
+    DumpBegin(emitter);
+    return str;
 }
 
 std::string SourceRange::DumpEnd() const {
-    if (begin_line == end_line) { return "col:" + std::to_string(end_column); }
-    return "line:" + std::to_string(end_line) + ':'
-           + std::to_string(end_column);
+    std::string str;
+    util::Emitter emitter(str);
+    DumpEnd(emitter);
+    return str;
 }
 
 std::string SourceRange::Dump() const {
     return '<' + DumpBegin() + ", " + DumpEnd() + '>';
 }
 
+void SourceRange::DumpBegin(util::Emitter &emitter) const {
+    emitter << "line:" << begin_line << ':' << begin_column;
+}
+
+void SourceRange::DumpEnd(util::Emitter &emitter) const {
+    if (begin_line == end_line) {
+        emitter << "col:" << end_column;
+    } else {
+        emitter << "line:" << end_line << ':' << end_column;
+    }
+}
+
 /* struct Token */
 
-std::string Token::DumpText() const {
-    return util::FormatTerminalBold(text, util::kFGBrightBlue);
+void Token::DumpText(util::Emitter &emitter) const {
+    emitter << util::Colored{text, util::kFGBrightBlue, true};
 }
 
-std::string Token::DumpTextRef() const {
-    return util::FormatTerminalBold('\'' + text + '\'', util::kFGBrightBlue);
+void Token::DumpTextRef(util::Emitter &emitter) const {
+    emitter.BeginColor(util::kFGBrightBlue, true);
+    emitter << '\'' << text << '\'';
+    emitter.EndColor();
 }
 
-std::string Token::DumpRange() const {
-    return '<' + util::FormatTerminal(range.DumpBegin(), util::kFGYellow) + ", "
-           + util::FormatTerminal(range.DumpEnd(), util::kFGYellow) + '>';
+void Token::DumpRange(util::Emitter &emitter) const {
+    emitter << '<';
+    emitter.BeginColor(util::kFGYellow);
+    range.DumpBegin(emitter);
+    emitter.EndColor();
+    emitter << ", ";
+    emitter.BeginColor(util::kFGYellow);
+    range.DumpEnd(emitter);
+    emitter.EndColor();
+    emitter << '>';
 }
 
 /* struct SourceManager */
@@ -74,16 +99,22 @@ TokenLocation SourceManager::AddToken(const std::string &text,
 }
 
 void SourceManager::Dump(std::ostream &ostream) const {
-    ostream << util::FormatTerminalBold("Dump tokens from file",
-                                        util::kFGBrightGreen)
-            << " '" << util::FormatTerminal(file_name, util::kFGYellow) << '\''
-            << std::endl;
+    util::Emitter emitter(ostream);
+    Dump(emitter);
+}
+
+void SourceManager::Dump(util::Emitter &emitter) const {
+    emitter << util::Colored{"Dump tokens from file", util::kFGBrightGreen,
+                             true}
+            << " '" << util::Colored{file_name, util::kFGYellow} << "'\n";
     TokenLocation loc = 0;
     for (const Token &token : token_table) {
-        ostream << util::FormatTerminal(util::FormatHex32(loc++),
-                                        util::kFGYellow)
-                << ' ' << token.DumpRange() << ' ' << token.DumpText()
-                << std::endl;
+        emitter << util::Colored{util::FormatHex32(loc++), util::kFGYellow}
+                << ' ';
+        token.DumpRange(emitter);
+        emitter << ' ';
+        token.DumpText(emitter);
+        emitter << '\n';
     }
 }
 
@@ -0,0 +1,35 @@
+#include "ir/arena.h"
+
+#include <cassert>
+#include <cstdint>
+#include <memory>
+
+namespace ir {
+
+Arena::~Arena() {
+    // a shared_ptr made by Module::Make outlived its module
+    assert(live_num == 0 && "an allocation outlives its arena");
+}
+
+void *Arena::Allocate(const std::size_t size, const std::size_t align) {
+    auto aligned = [align](char *ptr) {
+        const auto addr = reinterpret_cast<std::uintptr_t>(ptr);
+        return reinterpret_cast<char *>((addr + align - 1) & ~(align - 1));
+    };
+    char *ptr = aligned(cur);
+    if (cur == nullptr || ptr + size > end) {
+        // a big request gets a chunk of its own, the current one stays
+        const std::size_t chunk_size
+            = size + align > kChunkSize ? size + align : kChunkSize;
+        chunk_list.emplace_back(new char[chunk_size]);
+        capacity += chunk_size;
+        char *chunk = chunk_list.back().get();
+        ptr = aligned(chunk);
+        if (chunk_size != kChunkSize) return ptr;
+        end = chunk + chunk_size;
+    }
+    cur = ptr + size;
+    return ptr;
+}
+
+}  // namespace ir
@@ -0,0 +1,805 @@
+#include "ir/interpreter.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <istream>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "emitter.h"
+#include "error.h"
+#include "ir/ir.h"
+#include "ir/type.h"
+#include "ir/value.h"
+
+namespace ir {
+
+namespace {
+
+// the sylib functions, as the func of a Call
+enum Builtin {
+    kGetInt = -1,
+    kGetCh = -2,
+    kGetArray = -3,
+    kPutInt = -4,
+    kPutCh = -5,
+    kPutArray = -6,
+    kStartTime = -7,
+    kStopTime = -8
+};
+
+const std::unordered_map<std::string, int> kBuiltinMap{
+    {"getint", kGetInt},
+    {"getch", kGetCh},
+    {"getarray", kGetArray},
+    {"putint", kPutInt},
+    {"putch", kPutCh},
+    {"putarray", kPutArray},
+    {"_sysy_starttime", kStartTime},
+    {"_sysy_stoptime", kStopTime}};
+
+// the dimensions of an array type, none for an i32 or a pointer
+std::vector<int> GetDimList(const Type &type) {
+    if (type.kind != Type::kArray) return {};
+    return type.Cast<ArrayType>().GetArrDimList();
+}
+
+// the registers a value of the type takes, one per lane of a vector
+int GetLaneNum(const Type &type) {
+    if (type.kind != Type::kVector) return 1;
+    return type.Cast<VectorType>().GetLaneNum();
+}
+
+// the words taken by a value of the dimensions
+std::int32_t GetSize(const std::vector<int> &dim_list) {
+    std::int32_t size = 1;
+    for (auto dim : dim_list) size *= dim;
+    return size;
+}
+
+const char *GetOpName(const Inst &inst) {
+    switch (inst.kind) {
+        case Inst::kRet:
+            return "ret";
+        case Inst::kBr:
+            return "br";
+        case Inst::kBinaryOp:
+            switch (inst.Cast<BinaryOpInst>().op_code) {
+                case BinaryOpInst::kAdd:
+                    return "add";
+                case BinaryOpInst::kSub:
+                    return "sub";
+                case BinaryOpInst::kMul:
+                    return "mul";
+                case BinaryOpInst::kSDiv:
+                    return "sdiv";
+                case BinaryOpInst::kSRem:
+                    return "srem";
+                case BinaryOpInst::kShl:
+                    return "shl";
+                case BinaryOpInst::kAShr:
+                    return "ashr";
+                case BinaryOpInst::kLShr:
+                    return "lshr";
+                case BinaryOpInst::kAnd:
+                    return "and";
+                case BinaryOpInst::kOr:
+                    return "or";
+                case BinaryOpInst::kXor:
+                    return "xor";
+            }
+            break;
+        case Inst::kBitwiseOp:
+            return inst.Cast<BitwiseOpInst>().op_code == BitwiseOpInst::kAnd
+                       ? "and"
+                       : "or";
+        case Inst::kAlloca:
+            return "alloca";
+        case Inst::kLoad:
+            return "load";
+        case Inst::kStore:
+            return "store";
+        case Inst::kGetelementptr:
+            return "getelementptr";
+        case Inst::kZext:
+            return "zext";
+        case Inst::kBitcast:
+            return "bitcast";
+        case Inst::kIcmp:
+            return "icmp";
+        case Inst::kSelect:
+            return "select";
+        case Inst::kPhi:
+            return "phi";
+        case Inst::kCall:
+            return "call";
+        case Inst::kInsertElement:
+            return "insertelement";
+        case Inst::kExtractElement:
+            return "extractelement";
+    }
+    return "";
+}
+
+// i32 arithmetic wraps around, as it does on the target
+std::int32_t Wrap(const std::uint32_t value) {
+    return static_cast<std::int32_t>(value);
+}
+
+// write value in at least four digits, as %04d
+void EmitPadded(util::Emitter &emitter, const int value) {
+    for (int limit = 1000; limit > 1 && value < limit && value >= 0;
+         limit /= 10) {
+        emitter << '0';
+    }
+    emitter << value;
+}
+
+}  // namespace
+
+Interpreter::Interpreter(const Module &module,
+                         std::istream &input,
+                         util::Emitter &output)
+    : input(input), output(output) {
+    page_list.resize(kMaxMemory >> kPageBits);
+    // word 0 is the null pointer, the stack starts after the globals
+    stack_top = 1;
+    for (const auto &var : module.GetVarList()) LayoutGlobal(*var);
+
+    for (const auto &def : module.GetFuncDefList()) {
+        func_map.emplace(def->GetName(), static_cast<int>(func_list.size()));
+        func_list.emplace_back();
+        func_list.back().def = def.get();
+    }
+    for (auto &func : func_list) Decode(func);
+}
+
+void Interpreter::LayoutGlobal(const GlobalVarDef &var) {
+    const auto addr = stack_top;
+    global_map.emplace(var.GetName(), addr);
+    const auto size = GetSize(GetDimList(var.GetIdent().GetType()));
+    if (kMaxMemory - addr < size) {
+        throw RuntimeErrorException("in global '" + var.GetName()
+                                    + "', out of memory");
+    }
+    stack_top += size;
+    if (var.IsZeroInit()) return;
+    const auto init_num = std::min<std::size_t>(var.GetInitNum(), size);
+    for (std::size_t i = 0; i < init_num; ++i) {
+        At(addr + static_cast<std::int32_t>(i)) = var.GetInitAt(i).GetValue();
+    }
+}
+
+void Interpreter::Decode(Function &func) {
+    const auto &def = *func.def;
+    std::unordered_map<std::string, int> reg_map;
+    const auto reg = [&](const Value &value) {
+        const auto &name = value.Cast<Var>().GetName();
+        const auto iter = reg_map.find(name);
+        if (iter != reg_map.end()) return iter->second;
+        const auto first = func.reg_num;
+        reg_map.emplace(name, first);
+        func.reg_num += GetLaneNum(value.GetType());
+        return first;
+    };
+    const auto operand = [&](const Value &value) -> Operand {
+        switch (value.kind) {
+            case Value::kImm:
+                return {false, value.Cast<Imm>().GetValue()};
+            case Value::kGlobalVar: {
+                const auto iter = global_map.find(value.Cast<Var>().GetName());
+                if (iter == global_map.end()) {
+                    throw RuntimeErrorException(
+                        def.GetName(), "unknown global " + value.Str());
+                }
+                return {false, iter->second};
+            }
+            default:
+                return {true, reg(value)};
+        }
+    };
+    // the params come first, the caller puts the args there
+    for (const auto &param : def.GetParamList()) reg(*param);
+
+    std::unordered_map<std::string, int> block_map;
+    for (const auto &bb : def.GetBlockList()) {
+        block_map.emplace(bb->GetLabel().Str(),
+                          static_cast<int>(func.block_list.size()));
+        func.block_list.emplace_back();
+        func.block_list.back().bb = bb.get();
+    }
+    const auto edge = [&](const BasicBlock &from, const Var &to) {
+        const auto iter = block_map.find(to.Str());
+        if (iter == block_map.end()) {
+            throw RuntimeErrorException(def.GetName(),
+                                        "unknown label " + to.Str());
+        }
+        Edge edge;
+        edge.block = iter->second;
+        const auto label = from.GetLabel().Str();
+        for (const auto &inst : func.block_list[edge.block].bb->GetInstList()) {
+            if (inst->kind != Inst::kPhi) break;
+            const auto &phi = inst->Cast<PhiInst>();
+            for (const auto &value : phi.GetValueList()) {
+                if (value.label->Str() != label) continue;
+                const auto result = reg(phi.GetResult());
+                auto from = operand(*value.value);
+                // lane by lane, a vector is always in registers
+                for (int lane = 0; lane < GetLaneNum(phi.GetResult().GetType());
+                     ++lane) {
+                    edge.copy_list.emplace_back(result + lane, from);
+                    ++from.value;
+                }
+                break;
+            }
+        }
+        copy_buffer.resize(std::max(copy_buffer.size(), edge.copy_list.size()));
+        func.edge_list.push_back(std::move(edge));
+        return static_cast<int>(func.edge_list.size() - 1);
+    };
+
+    for (auto &block : func.block_list) {
+        for (const auto &inst : block.bb->GetInstList()) {
+            Code code;
+            code.kind = inst->kind;
+            switch (inst->kind) {
+                case Inst::kRet: {
+                    // op_code tells whether a holds a value
+                    const auto &ret = inst->Cast<RetInst>();
+                    code.op_code = ret.HasRet();
+                    if (ret.HasRet()) code.a = operand(ret.GetRet());
+                    break;
+                }
+                case Inst::kBr: {
+                    // index is the edge taken without a condition or when a is
+                    // true, op_code the one when a is false
+                    const auto &br = inst->Cast<BrInst>();
+                    if (br.HasDest()) {
+                        code.index = edge(*block.bb, br.GetDest());
+                        code.op_code = code.index;
+                        code.a = {false, 1};
+                    } else {
+                        code.a = operand(br.GetCond());
+                        code.index = edge(*block.bb, br.GetTrue());
+                        code.op_code = edge(*block.bb, br.GetFalse());
+                    }
+                    break;
+                }
+                case Inst::kBinaryOp: {
+                    // a vector op is one code for each lane
+                    const auto &op = inst->Cast<BinaryOpInst>();
+                    code.op_code = op.op_code;
+                    code.result = reg(op.GetResult());
+                    code.a = operand(op.GetLHS());
+                    code.b = operand(op.GetRHS());
+                    for (int lane = 1;
+                         lane < GetLaneNum(op.GetResult().GetType()); ++lane) {
+                        block.code_list.push_back(code);
+                        ++code.result;
+                        ++code.a.value;
+                        ++code.b.value;
+                    }
+                    break;
+                }
+                case Inst::kBitwiseOp: {
+                    const auto &op = inst->Cast<BitwiseOpInst>();
+                    code.op_code = op.op_code;
+                    code.result = reg(op.GetResult());
+                    code.a = operand(op.GetLHS());
+                    code.b = operand(op.GetRHS());
+                    break;
+                }
+                case Inst::kAlloca: {
+                    // a is the offset in the frame
+                    const auto &alloca = inst->Cast<AllocaInst>();
+                    const auto &type = alloca.GetResult().GetType();
+                    code.result = reg(alloca.GetResult());
+                    code.a = {false, func.frame_size};
+                    func.frame_size += GetSize(
+                        GetDimList(type.Cast<PtrType>().GetPointee()));
+                    break;
+                }
+                case Inst::kLoad: {
+                    // op_code is the word after the pointer, for the lanes of
+                    // a vector
+                    const auto &load = inst->Cast<LoadInst>();
+                    code.result = reg(load.GetResult());
+                    code.a = operand(load.GetPtr());
+                    for (int lane = 1;
+                         lane < GetLaneNum(load.GetResult().GetType());
+                         ++lane) {
+                        block.code_list.push_back(code);
+                        ++code.result;
+                        ++code.op_code;
+                    }
+                    break;
+                }
+                case Inst::kStore: {
+                    // op_code as for a load
+                    const auto &store = inst->Cast<StoreInst>();
+                    code.a = operand(store.GetValue());
+                    code.b = operand(store.GetPtr());
+                    for (int lane = 1;
+                         lane < GetLaneNum(store.GetValue().GetType());
+                         ++lane) {
+                        block.code_list.push_back(code);
+                        ++code.a.value;
+                        ++code.op_code;
+                    }
+                    break;
+                }
+                case Inst::kGetelementptr: {
+                    // the first index steps over the pointee, each further
+                    // one over an element of the array it is in
+                    const auto &gep = inst->Cast<GetelementptrInst>();
+                    code.result = reg(gep.GetResult());
+                    code.a = operand(gep.GetPtr());
+                    auto dim_list = GetDimList(
+                        gep.GetPtr().GetType().Cast<PtrType>().GetPointee());
+                    GEP decoded;
+                    for (std::size_t i = 0; i < gep.GetIdxNum(); ++i) {
+                        if (i > 0 && !dim_list.empty()) {
+                            dim_list.erase(dim_list.begin());
+                        }
+                        const auto stride = GetSize(dim_list);
+                        const auto idx = operand(*gep.GetIdxAt(i));
+                        if (idx.is_reg) {
+                            decoded.idx_list.emplace_back(idx, stride);
+                        } else {
+                            decoded.offset += idx.value * stride;
+                        }
+                    }
+                    code.index = static_cast<int>(func.gep_list.size());
+                    func.gep_list.push_back(std::move(decoded));
+                    break;
+                }
+                case Inst::kZext: {
+                    const auto &zext = inst->Cast<ZextInst>();
+                    code.result = reg(zext.GetResult());
+                    code.a = operand(zext.GetValue());
+                    break;
+                }
+                case Inst::kBitcast: {
+                    const auto &bitcast = inst->Cast<BitcastInst>();
+                    code.result = reg(bitcast.GetResult());
+                    code.a = operand(bitcast.GetValue());
+                    break;
+                }
+                case Inst::kIcmp: {
+                    const auto &icmp = inst->Cast<IcmpInst>();
+                    code.op_code = icmp.op_code;
+                    code.result = reg(icmp.GetResult());
+                    code.a = operand(icmp.GetLHS());
+                    code.b = operand(icmp.GetRHS());
+                    break;
+                }
+                case Inst::kSelect: {
+                    const auto &select = inst->Cast<SelectInst>();
+                    code.result = reg(select.GetResult());
+                    code.a = operand(select.GetCond());
+                    code.b = operand(select.GetTrue());
+                    code.c = operand(select.GetFalse());
+                    break;
+                }
+                case Inst::kPhi:
+                    // read on the edges into the block
+                    continue;
+                case Inst::kCall: {
+                    // result is -1 if nothing is returned
+                    const auto &call = inst->Cast<CallInst>();
+                    const auto &name = call.GetFunc().GetName();
+                    Call decoded;
+                    if (func_map.count(name) != 0) {
+                        decoded.func = func_map.at(name);
+                    } else if (kBuiltinMap.count(name) != 0) {
+                        decoded.func = kBuiltinMap.at(name);
+                    } else {
+                        throw RuntimeErrorException(
+                            def.GetName(), "call to undefined @" + name);
+                    }
+                    for (const auto &param : call.GetParamList()) {
+                        decoded.arg_list.push_back(operand(*param));
+                    }
+                    code.result = call.HasRet() ? reg(call.GetResult()) : -1;
+                    code.index = static_cast<int>(func.call_list.size());
+                    func.call_list.push_back(std::move(decoded));
+                    break;
+                }
+                case Inst::kInsertElement: {
+                    // a copy into each lane, of the element or the lane of
+                    // the vector, an undef lane is 0
+                    const auto &insert = inst->Cast<InsertElementInst>();
+                    code.result = reg(insert.GetResult());
+                    Operand lane_value;
+                    if (insert.HasVec()) lane_value = operand(insert.GetVec());
+                    const auto lane_num
+                        = GetLaneNum(insert.GetResult().GetType());
+                    for (int lane = 0; lane < lane_num; ++lane) {
+                        code.a = lane == insert.GetIndex()
+                                     ? operand(insert.GetElt())
+                                     : lane_value;
+                        if (lane + 1 < lane_num) {
+                            block.code_list.push_back(code);
+                            ++code.result;
+                        }
+                        if (lane_value.is_reg) ++lane_value.value;
+                    }
+                    break;
+                }
+                case Inst::kExtractElement: {
+                    // a copy of the lane
+                    const auto &extract = inst->Cast<ExtractElementInst>();
+                    code.result = reg(extract.GetResult());
+                    code.a = operand(extract.GetVec());
+                    code.a.value += extract.GetIndex();
+                    break;
+                }
+            }
+            block.code_list.push_back(code);
+        }
+    }
+}
+
+int Interpreter::Run() {
+    const auto iter = func_map.find("main");
+    if (iter == func_map.end()) {
+        throw RuntimeErrorException("main", "no definition");
+    }
+    return Execute(iter->second);
+}
+
+std::int32_t &Interpreter::At(const std::int32_t addr) {
+    if (addr <= 0 || addr >= stack_top) {
+        throw RuntimeErrorException(
+            *current, "access to invalid address " + std::to_string(addr));
+    }
+    auto &page = page_list[addr >> kPageBits];
+    if (!page) page = std::make_unique<std::int32_t[]>(1 << kPageBits);
+    return page[addr & ((1 << kPageBits) - 1)];
+}
+
+int Interpreter::Execute(const int func_index) {
+    auto &func = func_list[func_index];
+    const auto *caller = current;
+    current = &func.def->GetName();
+
+    // the args are already at the bottom of the registers
+    const auto base = reg_top;
+    reg_top += func.reg_num;
+    if (reg_stack.size() < reg_top) {
+        reg_stack.resize(std::max(reg_top, reg_stack.size() * 2));
+    }
+    const auto fp = stack_top;
+    if (kMaxMemory - stack_top < func.frame_size) {
+        throw RuntimeErrorException(*current, "stack overflow");
+    }
+    stack_top += func.frame_size;
+
+    auto *reg = reg_stack.data() + base;
+    const auto get = [&reg](const Operand &operand) {
+        return operand.is_reg ? reg[operand.value] : operand.value;
+    };
+
+    int bb = 0;
+    while (true) {
+        auto &block = func.block_list[bb];
+        ++block.count;
+        for (const auto &code : block.code_list) {
+            switch (code.kind) {
+                case Inst::kRet: {
+                    const auto value = code.op_code ? get(code.a) : 0;
+                    reg_top = base;
+                    stack_top = fp;
+                    current = caller;
+                    return value;
+                }
+                case Inst::kBr: {
+                    const auto &edge = func.edge_list[get(code.a) != 0
+                                                          ? code.index
+                                                          : code.op_code];
+                    // the phis read their values all at once
+                    const auto copy_num = edge.copy_list.size();
+                    for (std::size_t i = 0; i < copy_num; ++i) {
+                        copy_buffer[i] = get(edge.copy_list[i].second);
+                    }
+                    for (std::size_t i = 0; i < copy_num; ++i) {
+                        reg[edge.copy_list[i].first] = copy_buffer[i];
+                    }
+                    bb = edge.block;
+                    goto next;
+                }
+                case Inst::kBinaryOp: {
+                    const auto lhs = get(code.a);
+                    const auto rhs = get(code.b);
+                    const auto ulhs = static_cast<std::uint32_t>(lhs);
+                    const auto urhs = static_cast<std::uint32_t>(rhs);
+                    std::int32_t value = 0;
+                    switch (code.op_code) {
+                        case BinaryOpInst::kAdd:
+                            value = Wrap(ulhs + urhs);
+                            break;
+                        case BinaryOpInst::kSub:
+                            value = Wrap(ulhs - urhs);
+                            break;
+                        case BinaryOpInst::kMul:
+                            value = Wrap(ulhs * urhs);
+                            break;
+                        case BinaryOpInst::kSDiv:
+                        case BinaryOpInst::kSRem:
+                            if (rhs == 0) {
+                                throw RuntimeErrorException(*current,
+                                                            "division by zero");
+                            }
+                            // INT_MIN / -1 overflows, the target gives INT_MIN
+                            if (rhs == -1) {
+                                value = code.op_code == BinaryOpInst::kSDiv
+                                            ? Wrap(0U - ulhs)
+                                            : 0;
+                            } else {
+                                value = code.op_code == BinaryOpInst::kSDiv
+                                            ? lhs / rhs
+                                            : lhs % rhs;
+                            }
+                            break;
+                        case BinaryOpInst::kShl:
+                            value = Wrap(ulhs << (urhs & 31));
+                            break;
+                        case BinaryOpInst::kAShr:
+                            value = lhs >> (urhs & 31);
+                            break;
+                        case BinaryOpInst::kLShr:
+                            value = Wrap(ulhs >> (urhs & 31));
+                            break;
+                        case BinaryOpInst::kAnd:
+                            value = lhs & rhs;
+                            break;
+                        case BinaryOpInst::kOr:
+                            value = lhs | rhs;
+                            break;
+                        case BinaryOpInst::kXor:
+                            value = lhs ^ rhs;
+                            break;
+                    }
+                    reg[code.result] = value;
+                    break;
+                }
+                case Inst::kBitwiseOp:
+                    reg[code.result] = code.op_code == BitwiseOpInst::kAnd
+                                           ? get(code.a) & get(code.b)
+                                           : get(code.a) | get(code.b);
+                    break;
+                case Inst::kAlloca:
+                    reg[code.result] = fp + code.a.value;
+                    break;
+                case Inst::kLoad:
+                    reg[code.result] = At(get(code.a) + code.op_code);
+                    break;
+                case Inst::kStore:
+                    At(get(code.b) + code.op_code) = get(code.a);
+                    break;
+                case Inst::kGetelementptr: {
+                    const auto &gep = func.gep_list[code.index];
+                    auto addr = static_cast<std::uint32_t>(get(code.a))
+                                + static_cast<std::uint32_t>(gep.offset);
+                    for (const auto &idx : gep.idx_list) {
+                        addr += static_cast<std::uint32_t>(get(idx.first))
+                                * static_cast<std::uint32_t>(idx.second);
+                    }
+                    reg[code.result] = Wrap(addr);
+                    break;
+                }
+                case Inst::kZext:
+                case Inst::kBitcast:
+                case Inst::kInsertElement:
+                case Inst::kExtractElement:
+                    reg[code.result] = get(code.a);
+                    break;
+                case Inst::kIcmp: {
+                    const auto lhs = get(code.a);
+                    const auto rhs = get(code.b);
+                    bool value = false;
+                    switch (code.op_code) {
+                        case IcmpInst::kEQ:
+                            value = lhs == rhs;
+                            break;
+                        case IcmpInst::kNE:
+                            value = lhs != rhs;
+                            break;
+                        case IcmpInst::kSGT:
+                            value = lhs > rhs;
+                            break;
+                        case IcmpInst::kSGE:
+                            value = lhs >= rhs;
+                            break;
+                        case IcmpInst::kSLT:
+                            value = lhs < rhs;
+                            break;
+                        case IcmpInst::kSLE:
+                            value = lhs <= rhs;
+                            break;
+                        case IcmpInst::kUGT:
+                            value = static_cast<std::uint32_t>(lhs)
+                                    > static_cast<std::uint32_t>(rhs);
+                            break;
+                        case IcmpInst::kUGE:
+                            value = static_cast<std::uint32_t>(lhs)
+                                    >= static_cast<std::uint32_t>(rhs);
+                            break;
+                        case IcmpInst::kULT:
+                            value = static_cast<std::uint32_t>(lhs)
+                                    < static_cast<std::uint32_t>(rhs);
+                            break;
+                        case IcmpInst::kULE:
+                            value = static_cast<std::uint32_t>(lhs)
+                                    <= static_cast<std::uint32_t>(rhs);
+                            break;
+                    }
+                    reg[code.result] = value;
+                    break;
+                }
+                case Inst::kSelect:
+                    reg[code.result] = get(code.a) != 0 ? get(code.b)
+                                                        : get(code.c);
+                    break;
+                case Inst::kPhi:
+                    break;
+                case Inst::kCall: {
+                    // the args go right above the registers of the frame,
+                    // where the callee finds its params
+                    const auto &call = func.call_list[code.index];
+                    const auto arg_num = call.arg_list.size();
+                    if (reg_stack.size() < reg_top + arg_num) {
+                        reg_stack.resize(
+                            std::max(reg_top + arg_num, reg_stack.size() * 2));
+                        reg = reg_stack.data() + base;
+                    }
+                    for (std::size_t i = 0; i < arg_num; ++i) {
+                        reg_stack[reg_top + i] = get(call.arg_list[i]);
+                    }
+                    const auto value = call.func >= 0
+                                           ? Execute(call.func)
+                                           : CallBuiltin(call.func,
+                                                         &reg_stack[reg_top]);
+                    reg = reg_stack.data() + base;
+                    if (code.result >= 0) reg[code.result] = value;
+                    break;
+                }
+            }
+        }
+        throw RuntimeErrorException(*current, "block "
+                                                  + block.bb->GetLabel().Str()
+                                                  + " does not terminate");
+    next:;
+    }
+}
+
+int Interpreter::CallBuiltin(const int builtin, const std::int32_t *arg_list) {
+    switch (builtin) {
+        case kGetInt: {
+            int value = 0;
+            input >> value;
+            return value;
+        }
+        case kGetCh: {
+            const auto c = input.get();
+            return c == std::istream::traits_type::eof()
+                       ? -1
+                       : static_cast<char>(c);
+        }
+        case kGetArray: {
+            int num = 0;
+            input >> num;
+            for (int i = 0; i < num; ++i) {
+                int value = 0;
+                input >> value;
+                At(arg_list[0] + i) = value;
+            }
+            return num;
+        }
+        case kPutInt:
+            output << arg_list[0];
+            return 0;
+        case kPutCh:
+            output << static_cast<char>(arg_list[0]);
+            return 0;
+        case kPutArray:
+            output << arg_list[0] << ':';
+            for (int i = 0; i < arg_list[0]; ++i) {
+                output << ' ' << At(arg_list[1] + i);
+            }
+            output << '\n';
+            return 0;
+        case kStartTime:
+            timer_list.push_back({arg_list[0], 0, 0});
+            timer_begin = std::chrono::steady_clock::now();
+            return 0;
+        case kStopTime: {
+            using std::chrono::microseconds;
+            const auto us = std::chrono::duration_cast<microseconds>(
+                std::chrono::steady_clock::now() - timer_begin);
+            if (timer_list.empty()) timer_list.emplace_back();
+            timer_list.back().end_line = arg_list[0];
+            timer_list.back().us = us.count();
+            return 0;
+        }
+        default:
+            return 0;
+    }
+}
+
+std::uint64_t Interpreter::GetInstCount() const {
+    std::uint64_t count = 0;
+    for (const auto &func : func_list) {
+        for (const auto &block : func.block_list) {
+            count += block.count * block.bb->GetInstList().size();
+        }
+    }
+    return count;
+}
+
+std::map<std::string, std::uint64_t> Interpreter::GetOpCount() const {
+    std::map<std::string, std::uint64_t> op_count;
+    for (const auto &func : func_list) {
+        for (const auto &block : func.block_list) {
+            if (block.count == 0) continue;
+            for (const auto &inst : block.bb->GetInstList()) {
+                op_count[GetOpName(*inst)] += block.count;
+            }
+        }
+    }
+    return op_count;
+}
+
+std::uint64_t Interpreter::GetBlockCount(const std::string &func,
+                                         const std::string &label) const {
+    const auto iter = func_map.find(func);
+    if (iter == func_map.end()) return 0;
+    for (const auto &block : func_list[iter->second].block_list) {
+        if (block.bb->GetLabel().Str() == label) return block.count;
+    }
+    return 0;
+}
+
+void Interpreter::DumpProfile(util::Emitter &emitter) const {
+    emitter << "instructions: " << GetInstCount() << '\n';
+    for (const auto &op : GetOpCount()) {
+        emitter << "    " << op.first << ": " << op.second << '\n';
+    }
+    for (const auto &func : func_list) {
+        if (func.block_list.empty() || func.block_list.front().count == 0) {
+            continue;
+        }
+        emitter << func.def->GetIdent() << ":\n";
+        for (const auto &block : func.block_list) {
+            emitter << "    " << block.bb->GetLabel() << ": " << block.count
+                    << '\n';
+        }
+    }
+}
+
+void Interpreter::DumpTimer(util::Emitter &emitter) const {
+    std::int64_t total = 0;
+    const auto dump = [&emitter](std::int64_t us) {
+        emitter << static_cast<long long>(us / 3600000000) << "H-"
+                << static_cast<long long>(us / 60000000 % 60) << "M-"
+                << static_cast<long long>(us / 1000000 % 60) << "S-"
+                << static_cast<long long>(us % 1000000) << "us\n";
+    };
+    for (const auto &timer : timer_list) {
+        emitter << "Timer@";
+        EmitPadded(emitter, timer.begin_line);
+        emitter << '-';
+        EmitPadded(emitter, timer.end_line);
+        emitter << ": ";
+        dump(timer.us);
+        total += timer.us;
+    }
+    emitter << "TOTAL: ";
+    dump(total);
+}
+
+}  // namespace ir
@@ -0,0 +1,98 @@
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "emitter.h"
+#include "error.h"
+#include "frontend/frontend.h"
+#include "ir/interpreter.h"
+#include "opt/pipeline.h"
+#include "opt/profile.h"
+
+// Run a program on the interpreter after the passes given as -<pass>, with
+// stdin as its input. What it prints goes to stdout, the sylib timers and with
+// -profile the instruction and block counts to stderr, and the exit status is
+// what main returns. With -profile-out=<file> the block counts are appended
+// to file the way a program built with sysycc -fprofile-generate does, for
+// sysycc -fprofile-use with the same passes.
+int main(int argc, char **argv) {
+    // the program reads stdin through cin only
+    std::ios::sync_with_stdio(false);
+
+    if (argc < 2) {
+        std::cout << "need filename" << std::endl;
+        return 1;
+    }
+
+    int result = Parse(argv[1]);
+    if (result != 0) return result;
+
+    result = AstToIR();
+    if (result != 0) return result;
+
+    bool profile = false;
+    std::string profile_out;
+    for (int i = 2; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "-profile") {
+            profile = true;
+        } else if (arg.rfind("-profile-out=", 0) == 0) {
+            profile_out = arg.substr(13);
+        } else if (arg[0] == '-') {
+            const auto pass = opt::CreatePass(arg.substr(1));
+            opt::RunOnModule(*pass, *module);
+        }
+    }
+
+    std::cout.flush();
+    util::Emitter emitter(STDOUT_FILENO);
+    util::Emitter error(STDERR_FILENO);
+    error.SetColor(false);
+    std::unique_ptr<ir::Interpreter> interpreter;
+    try {
+        interpreter =
+            std::make_unique<ir::Interpreter>(*module, std::cin, emitter);
+        result = interpreter->Run();
+    } catch (const RuntimeErrorException &e) {
+        emitter.Flush();
+        error << e.what() << '\n';
+        return 1;
+    }
+    emitter.Flush();
+
+    interpreter->DumpTimer(error);
+    if (profile) interpreter->DumpProfile(error);
+    error.Flush();
+
+    if (!profile_out.empty()) {
+        opt::Profile block_profile;
+        for (const auto &func : module->GetFuncDefList()) {
+            std::vector<std::uint64_t> count_list;
+            for (const auto &bb : func->GetBlockList()) {
+                count_list.push_back(interpreter->GetBlockCount(
+                    func->GetName(), bb->GetLabel().Str()));
+            }
+            block_profile.Add(*func, std::move(count_list));
+        }
+        const int fd =
+            open(profile_out.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+        if (fd < 0) {
+            std::cerr << "open file '" << profile_out << "' failed"
+                      << std::endl;
+            return 1;
+        }
+        util::Emitter file(fd);
+        block_profile.Write(file);
+        file.Flush();
+        const bool good = file.Good();
+        if (close(fd) != 0 || !good) return 1;
+    }
+
+    return emitter.Good() ? result : 1;
+}
@@ -2,8 +2,12 @@
 
 #include <error.h>
 
+#include <memory>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
+#include "casting.h"
 #include "ir/type.h"
 #include "ir/value.h"
 
@@ -43,23 +47,70 @@ void Inst::CheckType(const std::string &inst,
             need = "array";
             if (value != nullptr && value->GetType().kind == kind) return;
             break;
+        case Type::kVector:
+            need = "vector";
+            if (value != nullptr && value->GetType().kind == kind) return;
+            break;
     }
     throw InvalidValueTypeException(inst, value->GetType().Str(), need);
 }
 
-std::string RetInst::Str() const {
-    if (HasRet()) { return "ret " + ret->TypeStr(); }
-    return "ret void";
+// an i32, or a vector of them where the instruction works lane by lane
+static void CheckLane(const std::string &inst,
+                      const std::shared_ptr<Value> &value) {
+    if (value != nullptr && value->GetType().kind == Type::kVector) return;
+    Inst::CheckType(inst, value, Type::kInt, IntType::kI32);
+}
+
+std::string Inst::Str() const {
+    std::string str;
+    util::Emitter emitter(str);
+    Emit(emitter);
+    return str;
+}
+
+// replace slot with to if it holds from, to must fit the type of the slot
+template <typename T>
+static void Replace(std::shared_ptr<T> &slot,
+                    const std::shared_ptr<Value> &from,
+                    const std::shared_ptr<Value> &to) {
+    if (slot != from) return;
+    if (!util::isa<T>(to.get())) {
+        throw InvalidParameterException("can not replace " + from->Str()
+                                        + " with " + to->Str());
+    }
+    slot = std::static_pointer_cast<T>(to);
+}
+
+void RetInst::Emit(util::Emitter &emitter) const {
+    if (HasRet()) {
+        emitter << "ret " << ret->WithType();
+    } else {
+        emitter << "ret void";
+    }
 }
 
 void RetInst::Check() const {
     CheckType("RetInst", ret, Type::kInt, IntType::kI32);
 }
 
-std::string BrInst::Str() const {
-    if (HasDest()) { return "br " + if_true->TypeStr(); }
-    return "br " + cond->TypeStr() + ", " + if_true->TypeStr() + ", "
-           + if_false->TypeStr();
+std::vector<std::shared_ptr<Value>> RetInst::GetUseList() const {
+    if (HasRet()) return {ret};
+    return {};
+}
+
+void RetInst::ReplaceUse(const std::shared_ptr<Value> &from,
+                         const std::shared_ptr<Value> &to) {
+    Replace(ret, from, to);
+}
+
+void BrInst::Emit(util::Emitter &emitter) const {
+    if (HasDest()) {
+        emitter << "br " << if_true->WithType();
+    } else {
+        emitter << "br " << cond->WithType() << ", " << if_true->WithType()
+                << ", " << if_false->WithType();
+    }
 }
 
 void BrInst::Check() const {
@@ -68,45 +119,91 @@ void BrInst::Check() const {
     if (if_false != nullptr) CheckType("BrInst", if_false, Type::kLabel);
 }
 
-std::string BinaryOpInst::Str() const {
-    std::string str = result->Str() + " = ";
+std::vector<std::shared_ptr<Value>> BrInst::GetUseList() const {
+    if (HasDest()) return {};
+    return {cond};
+}
+
+void BrInst::ReplaceUse(const std::shared_ptr<Value> &from,
+                        const std::shared_ptr<Value> &to) {
+    Replace(cond, from, to);
+}
+
+void BinaryOpInst::Emit(util::Emitter &emitter) const {
+    emitter << *result << " = ";
     switch (op_code) {
         case kAdd:
-            str += "add";
+            emitter << "add";
             break;
         case kSub:
-            str += "sub";
+            emitter << "sub";
             break;
         case kMul:
-            str += "mul";
+            emitter << "mul";
             break;
         case kSDiv:
-            str += "sdiv";
+            emitter << "sdiv";
             break;
         case kSRem:
-            str += "srem";
+            emitter << "srem";
+            break;
+        case kShl:
+            emitter << "shl";
+            break;
+        case kAShr:
+            emitter << "ashr";
+            break;
+        case kLShr:
+            emitter << "lshr";
+            break;
+        case kAnd:
+            emitter << "and";
+            break;
+        case kOr:
+            emitter << "or";
+            break;
+        case kXor:
+            emitter << "xor";
             break;
     }
-    return str + " i32 " + lhs->Str() + ", " + rhs->Str();
+    emitter << ' ' << result->GetType() << ' ' << *lhs << ", " << *rhs;
 }
 
 void BinaryOpInst::Check() const {
-    CheckType("BinaryOpInst", result, Type::kInt, IntType::kI32);
-    CheckType("BinaryOpInst", lhs, Type::kInt, IntType::kI32);
-    CheckType("BinaryOpInst", rhs, Type::kInt, IntType::kI32);
+    if (result->GetType().kind != Type::kVector) {
+        CheckType("BinaryOpInst", result, Type::kInt, IntType::kI32);
+        CheckType("BinaryOpInst", lhs, Type::kInt, IntType::kI32);
+        CheckType("BinaryOpInst", rhs, Type::kInt, IntType::kI32);
+        return;
+    }
+    if (op_code != kAdd && op_code != kSub && op_code != kMul) {
+        throw InvalidParameterException("BinaryOpInst: no vector " + Str());
+    }
+    CheckType("BinaryOpInst", lhs, Type::kVector);
+    CheckType("BinaryOpInst", rhs, Type::kVector);
 }
 
-std::string BitwiseOpInst::Str() const {
-    std::string str = result->Str() + " = ";
+std::vector<std::shared_ptr<Value>> BinaryOpInst::GetUseList() const {
+    return {lhs, rhs};
+}
+
+void BinaryOpInst::ReplaceUse(const std::shared_ptr<Value> &from,
+                              const std::shared_ptr<Value> &to) {
+    Replace(lhs, from, to);
+    Replace(rhs, from, to);
+}
+
+void BitwiseOpInst::Emit(util::Emitter &emitter) const {
+    emitter << *result << " = ";
     switch (op_code) {
         case kAnd:
-            str += "and";
+            emitter << "and";
             break;
         case kOr:
-            str += "or";
+            emitter << "or";
             break;
     }
-    return str + " i1 " + lhs->Str() + ", " + rhs->Str();
+    emitter << " i1 " << *lhs << ", " << *rhs;
 }
 
 void BitwiseOpInst::Check() const {
@@ -115,16 +212,32 @@ void BitwiseOpInst::Check() const {
     CheckType("BitwiseOpInst", rhs, Type::kInt, IntType::kI1);
 }
 
-std::string AllocaInst::Str() const {
-    return result->Str() + " = alloca "
-           + result->GetType().Cast<PtrType>().GetPointee().Str();
+std::vector<std::shared_ptr<Value>> BitwiseOpInst::GetUseList() const {
+    return {lhs, rhs};
+}
+
+void BitwiseOpInst::ReplaceUse(const std::shared_ptr<Value> &from,
+                               const std::shared_ptr<Value> &to) {
+    Replace(lhs, from, to);
+    Replace(rhs, from, to);
+}
+
+void AllocaInst::Emit(util::Emitter &emitter) const {
+    emitter << *result << " = alloca "
+            << result->GetType().Cast<PtrType>().GetPointee();
 }
 
 void AllocaInst::Check() const { CheckType("AllocaInst", result, Type::kPtr); }
 
-std::string LoadInst::Str() const {
-    return result->Str() + " = load " + result->GetType().Str() + ", "
-           + ptr->TypeStr();
+// a vector is only as aligned as the i32 array it is in
+static void EmitAlign(util::Emitter &emitter, const Type &type) {
+    if (type.kind == Type::kVector) emitter << ", align 4";
+}
+
+void LoadInst::Emit(util::Emitter &emitter) const {
+    emitter << *result << " = load " << result->GetType() << ", "
+            << ptr->WithType();
+    EmitAlign(emitter, result->GetType());
 }
 
 void LoadInst::Check() const {
@@ -132,8 +245,18 @@ void LoadInst::Check() const {
     CheckType("LoadInst", ptr, Type::kPtr);
 }
 
-std::string StoreInst::Str() const {
-    return "store " + value->TypeStr() + ", " + ptr->TypeStr();
+std::vector<std::shared_ptr<Value>> LoadInst::GetUseList() const {
+    return {ptr};
+}
+
+void LoadInst::ReplaceUse(const std::shared_ptr<Value> &from,
+                          const std::shared_ptr<Value> &to) {
+    Replace(ptr, from, to);
+}
+
+void StoreInst::Emit(util::Emitter &emitter) const {
+    emitter << "store " << value->WithType() << ", " << ptr->WithType();
+    EmitAlign(emitter, value->GetType());
 }
 
 void StoreInst::Check() const {
@@ -141,12 +264,21 @@ void StoreInst::Check() const {
     CheckType("StoreInst", ptr, Type::kPtr);
 }
 
-std::string GetelementptrInst::Str() const {
-    std::string str = result->Str() + " = getelementptr ";
-    str += ptr->GetType().Cast<PtrType>().GetPointee().Str();
-    str += ", " + ptr->TypeStr();
-    for (const auto &idx : idx_list) str += ", " + idx->TypeStr();
-    return str;
+std::vector<std::shared_ptr<Value>> StoreInst::GetUseList() const {
+    return {value, ptr};
+}
+
+void StoreInst::ReplaceUse(const std::shared_ptr<Value> &from,
+                           const std::shared_ptr<Value> &to) {
+    Replace(value, from, to);
+    Replace(ptr, from, to);
+}
+
+void GetelementptrInst::Emit(util::Emitter &emitter) const {
+    emitter << *result << " = getelementptr "
+            << ptr->GetType().Cast<PtrType>().GetPointee() << ", "
+            << ptr->WithType();
+    for (const auto &idx : idx_list) emitter << ", " << idx->WithType();
 }
 
 void GetelementptrInst::Check() const {
@@ -154,8 +286,20 @@ void GetelementptrInst::Check() const {
     CheckType("GetelementptrInst", ptr, Type::kPtr);
 }
 
-std::string ZextInst::Str() const {
-    return result->Str() + " = zext i1 " + value->Str() + " to i32";
+std::vector<std::shared_ptr<Value>> GetelementptrInst::GetUseList() const {
+    std::vector<std::shared_ptr<Value>> use_list{ptr};
+    use_list.insert(use_list.end(), idx_list.begin(), idx_list.end());
+    return use_list;
+}
+
+void GetelementptrInst::ReplaceUse(const std::shared_ptr<Value> &from,
+                                   const std::shared_ptr<Value> &to) {
+    Replace(ptr, from, to);
+    for (auto &idx : idx_list) Replace(idx, from, to);
+}
+
+void ZextInst::Emit(util::Emitter &emitter) const {
+    emitter << *result << " = zext i1 " << *value << " to i32";
 }
 
 void ZextInst::Check() const {
@@ -163,35 +307,64 @@ void ZextInst::Check() const {
     CheckType("ZextInst", value, Type::kInt, IntType::kI1);
 }
 
-std::string BitcastInst::Str() const {
-    return result->Str() + " = bitcast " + value->TypeStr() + " to "
-           + result->GetType().Str();
+std::vector<std::shared_ptr<Value>> ZextInst::GetUseList() const {
+    return {value};
+}
+
+void ZextInst::ReplaceUse(const std::shared_ptr<Value> &from,
+                          const std::shared_ptr<Value> &to) {
+    Replace(value, from, to);
 }
 
-std::string IcmpInst::Str() const {
-    std::string str = result->Str() + " = icmp ";
+void BitcastInst::Emit(util::Emitter &emitter) const {
+    emitter << *result << " = bitcast " << value->WithType() << " to "
+            << result->GetType();
+}
+
+std::vector<std::shared_ptr<Value>> BitcastInst::GetUseList() const {
+    return {value};
+}
+
+void BitcastInst::ReplaceUse(const std::shared_ptr<Value> &from,
+                             const std::shared_ptr<Value> &to) {
+    Replace(value, from, to);
+}
+
+void IcmpInst::Emit(util::Emitter &emitter) const {
+    emitter << *result << " = icmp ";
     switch (op_code) {
         case kEQ:
-            str += "eq";
+            emitter << "eq";
             break;
         case kNE:
-            str += "ne";
+            emitter << "ne";
             break;
         case kSGT:
-            str += "sgt";
+            emitter << "sgt";
             break;
         case kSGE:
-            str += "sge";
+            emitter << "sge";
             break;
         case kSLT:
-            str += "slt";
+            emitter << "slt";
             break;
         case kSLE:
-            str += "sle";
+            emitter << "sle";
+            break;
+        case kUGT:
+            emitter << "ugt";
+            break;
+        case kUGE:
+            emitter << "uge";
+            break;
+        case kULT:
+            emitter << "ult";
+            break;
+        case kULE:
+            emitter << "ule";
             break;
     }
-    return str + ' ' + lhs->GetType().Str() + ' ' + lhs->Str() + ", "
-           + rhs->Str();
+    emitter << ' ' << lhs->GetType() << ' ' << *lhs << ", " << *rhs;
 }
 
 void IcmpInst::Check() const {
@@ -200,38 +373,85 @@ void IcmpInst::Check() const {
     // CheckType(rhs, Type::kInt, IntType::kI32);
 }
 
+std::vector<std::shared_ptr<Value>> IcmpInst::GetUseList() const {
+    return {lhs, rhs};
+}
+
+void IcmpInst::ReplaceUse(const std::shared_ptr<Value> &from,
+                          const std::shared_ptr<Value> &to) {
+    Replace(lhs, from, to);
+    Replace(rhs, from, to);
+}
+
+void SelectInst::Emit(util::Emitter &emitter) const {
+    emitter << *result << " = select " << cond->WithType() << ", "
+            << if_true->WithType() << ", " << if_false->WithType();
+}
+
+void SelectInst::Check() const {
+    CheckType("SelectInst", result, Type::kInt, IntType::kI32);
+    CheckType("SelectInst", cond, Type::kInt, IntType::kI1);
+    CheckType("SelectInst", if_true, Type::kInt, IntType::kI32);
+    CheckType("SelectInst", if_false, Type::kInt, IntType::kI32);
+}
+
+std::vector<std::shared_ptr<Value>> SelectInst::GetUseList() const {
+    return {cond, if_true, if_false};
+}
+
+void SelectInst::ReplaceUse(const std::shared_ptr<Value> &from,
+                            const std::shared_ptr<Value> &to) {
+    Replace(cond, from, to);
+    Replace(if_true, from, to);
+    Replace(if_false, from, to);
+}
+
 std::string PhiInst::PhiValue::Str() const {
-    return "[ " + value->Str() + ", " + label->Str() + " ]";
+    std::string str;
+    util::Emitter emitter(str);
+    Emit(emitter);
+    return str;
+}
+
+void PhiInst::PhiValue::Emit(util::Emitter &emitter) const {
+    emitter << "[ " << *value << ", " << *label << " ]";
 }
 
 void PhiInst::PhiValue::Check() const {
-    CheckType("PhiValue", value, Type::kInt, IntType::kI32);
+    CheckLane("PhiValue", value);
     CheckType("PhiValue", label, Type::kLabel);
 }
 
-std::string PhiInst::Str() const {
-    std::string str = result->Str() + " = phi " + result->GetType().Str() + ' ';
+void PhiInst::Emit(util::Emitter &emitter) const {
+    emitter << *result << " = phi " << result->GetType() << ' ';
     for (auto iter = value_list.cbegin(); iter != value_list.cend(); ++iter) {
-        if (iter != value_list.cbegin()) str += ", ";
-        str += (*iter).Str();
+        if (iter != value_list.cbegin()) emitter << ", ";
+        iter->Emit(emitter);
     }
-    return str;
 }
 
-void PhiInst::Check() const {
-    CheckType("PhiInst", result, Type::kInt, IntType::kI32);
+void PhiInst::Check() const { CheckLane("PhiInst", result); }
+
+std::vector<std::shared_ptr<Value>> PhiInst::GetUseList() const {
+    std::vector<std::shared_ptr<Value>> use_list;
+    for (const auto &value : value_list) use_list.push_back(value.value);
+    return use_list;
 }
 
-std::string CallInst::Str() const {
-    std::string str;
-    if (has_ret) str += result->Str() + " = ";
-    str += "call " + func->GetType().Cast<ir::FuncType>().RetTypeStr();
-    str += ' ' + func->Str() + '(';
+void PhiInst::ReplaceUse(const std::shared_ptr<Value> &from,
+                         const std::shared_ptr<Value> &to) {
+    for (auto &value : value_list) Replace(value.value, from, to);
+}
+
+void CallInst::Emit(util::Emitter &emitter) const {
+    if (has_ret) emitter << *result << " = ";
+    emitter << "call " << func->GetType().Cast<ir::FuncType>().GetRetType()
+            << ' ' << *func << '(';
     for (auto iter = param_list.cbegin(); iter != param_list.cend(); ++iter) {
-        if (iter != param_list.cbegin()) str += ", ";
-        str += (*iter)->TypeStr();
+        if (iter != param_list.cbegin()) emitter << ", ";
+        emitter << (*iter)->WithType();
     }
-    return str + ')';
+    emitter << ')';
 }
 
 void CallInst::Check() const {
@@ -241,68 +461,187 @@ void CallInst::Check() const {
     CheckType("CallInst", func, Type::kFunc);
 }
 
-void BasicBlock::Dump(std::ostream &ostream, const std::string &indent) const {
-    if (inst_list.empty()) return;
-    ostream << label->GetName() << ':' << std::endl;
-    for (const auto &inst : inst_list) {
-        ostream << indent << inst->Str() << std::endl;
+std::vector<std::shared_ptr<Value>> CallInst::GetUseList() const {
+    return param_list;
+}
+
+void CallInst::ReplaceUse(const std::shared_ptr<Value> &from,
+                          const std::shared_ptr<Value> &to) {
+    for (auto &param : param_list) Replace(param, from, to);
+}
+
+void InsertElementInst::Emit(util::Emitter &emitter) const {
+    emitter << *result << " = insertelement " << result->GetType() << ' ';
+    if (HasVec()) {
+        emitter << *vec;
+    } else {
+        emitter << "undef";
+    }
+    emitter << ", " << elt->WithType() << ", i32 " << index;
+}
+
+void InsertElementInst::Check() const {
+    CheckType("InsertElementInst", result, Type::kVector);
+    if (HasVec()) CheckType("InsertElementInst", vec, Type::kVector);
+    CheckType("InsertElementInst", elt, Type::kInt, IntType::kI32);
+    if (index < 0
+        || index >= result->GetType().Cast<VectorType>().GetLaneNum()) {
+        throw InvalidParameterException("InsertElementInst: no lane "
+                                        + std::to_string(index));
     }
 }
 
-void GlobalVarDef::Dump(std::ostream &ostream) const {
-    ostream << ident->Str() << " = " << (is_const ? "constant" : "global");
-    ostream << ' ' << ident->GetType().Str() << ' ';
+std::vector<std::shared_ptr<Value>> InsertElementInst::GetUseList() const {
+    if (HasVec()) return {vec, elt};
+    return {elt};
+}
+
+void InsertElementInst::ReplaceUse(const std::shared_ptr<Value> &from,
+                                   const std::shared_ptr<Value> &to) {
+    Replace(vec, from, to);
+    Replace(elt, from, to);
+}
+
+void ExtractElementInst::Emit(util::Emitter &emitter) const {
+    emitter << *result << " = extractelement " << vec->WithType() << ", i32 "
+            << index;
+}
+
+void ExtractElementInst::Check() const {
+    CheckType("ExtractElementInst", result, Type::kInt, IntType::kI32);
+    CheckType("ExtractElementInst", vec, Type::kVector);
+    if (index < 0 || index >= vec->GetType().Cast<VectorType>().GetLaneNum()) {
+        throw InvalidParameterException("ExtractElementInst: no lane "
+                                        + std::to_string(index));
+    }
+}
+
+std::vector<std::shared_ptr<Value>> ExtractElementInst::GetUseList() const {
+    return {vec};
+}
+
+void ExtractElementInst::ReplaceUse(const std::shared_ptr<Value> &from,
+                                    const std::shared_ptr<Value> &to) {
+    Replace(vec, from, to);
+}
+
+void BasicBlock::Dump(util::Emitter &emitter, const char *indent) const {
+    if (inst_list.empty()) return;
+    emitter << label->GetName() << ":\n";
+    for (const auto &inst : inst_list) emitter << indent << *inst << '\n';
+}
+
+void GlobalVarDef::Dump(util::Emitter &emitter) const {
+    emitter << *ident << " = " << (is_const ? "constant" : "global");
+    emitter << ' ' << ident->GetType() << ' ';
     if (ident->GetType().kind == Type::kInt) {  // int
-        ostream << init_list.front()->Str();
+        emitter << *init_list.front();
     } else {  // array
         if (is_zero_init) {
-            ostream << "zeroinitializer";
+            emitter << "zeroinitializer";
         } else {
-            ostream << '[';
+            emitter << '[';
             for (auto iter = init_list.cbegin(); iter != init_list.cend();
                  ++iter) {
-                if (iter != init_list.cbegin()) ostream << ", ";
-                ostream << (*iter)->TypeStr();
+                if (iter != init_list.cbegin()) emitter << ", ";
+                emitter << (*iter)->WithType();
             }
-            ostream << ']';
+            emitter << ']';
         }
     }
-    ostream << std::endl;
+    emitter << '\n';
 }
 
-void FuncDecl::Dump(std::ostream &ostream) const {
-    ostream << "declare";
-    ostream << ' ' << ident->GetType().Cast<FuncType>().RetTypeStr();
-    ostream << ' ' << ident->Str();
-    ostream << ident->GetType().Cast<FuncType>().ParamListStr();
-    ostream << std::endl;
+void FuncDecl::Dump(util::Emitter &emitter) const {
+    const auto &type = ident->GetType().Cast<FuncType>();
+    emitter << "declare " << type.GetRetType() << ' ' << *ident << '(';
+    for (auto iter = type.GetParamList().cbegin();
+         iter != type.GetParamList().cend(); ++iter) {
+        if (iter != type.GetParamList().cbegin()) emitter << ", ";
+        emitter << **iter;
+    }
+    emitter << ")\n";
 }
 
 void FuncDef::Dump(std::ostream &ostream) const {
-    ostream << "define";
-    ostream << ' ' << ident->GetType().Cast<FuncType>().RetTypeStr();
-    ostream << ' ' << ident->Str();
-    ostream << '(';
+    util::Emitter emitter(ostream);
+    Dump(emitter);
+}
+
+void FuncDef::Dump(util::Emitter &emitter) const {
+    emitter << "define "
+            << ident->GetType().Cast<FuncType>().GetRetType() << ' '
+            << *ident << '(';
     for (auto iter = param_list.cbegin(); iter != param_list.cend(); ++iter) {
-        if (iter != param_list.cbegin()) ostream << ", ";
-        ostream << (*iter)->TypeStr();
+        if (iter != param_list.cbegin()) emitter << ", ";
+        emitter << (*iter)->WithType();
+    }
+    emitter << ") {\n";
+    for (const auto &bb : block_list) bb->Dump(emitter, "    ");
+    emitter << "}\n\n";
+}
+
+int FuncDef::Renumber() {
+    int id = 0;
+    for (const auto &param : param_list) param->SetID(id++);
+    for (const auto &bb : block_list) {
+        // empty blocks are not dumped
+        if (bb->GetInstList().empty()) continue;
+        if (bb->GetLabel().kind == Value::kTmpVar) {
+            std::static_pointer_cast<TmpVar>(bb->GetLabelPtr())->SetID(id++);
+        }
+        for (const auto &inst : bb->GetInstList()) {
+            auto result = inst->GetResultPtr();
+            if (result != nullptr && result->kind == Value::kTmpVar) {
+                std::static_pointer_cast<TmpVar>(result)->SetID(id++);
+            } else if (result == nullptr && inst->kind == Inst::kCall) {
+                // the unnamed result of a call still takes a number
+                const auto &func = inst->Cast<CallInst>().GetFunc();
+                const auto &func_type = func.GetType().Cast<FuncType>();
+                if (func_type.GetRetType().kind != Type::kVoid) ++id;
+            }
+        }
+    }
+    return id;
+}
+
+void FuncDef::ComputeCFG() {
+    std::unordered_map<std::string, BasicBlock *> block_map;
+    for (const auto &bb : block_list) {
+        bb->predecessor_list.clear();
+        bb->successor_list.clear();
+        block_map[bb->GetLabel().Str()] = bb.get();
+    }
+    for (const auto &bb : block_list) {
+        if (bb->GetInstList().empty()) continue;
+        const auto &last = *bb->GetInstList().back();
+        if (last.kind != Inst::kBr) continue;
+        const auto &br = last.Cast<BrInst>();
+        bb->successor_list.push_back(block_map.at(br.GetTrue().Str()));
+        if (!br.HasDest()) {
+            bb->successor_list.push_back(block_map.at(br.GetFalse().Str()));
+        }
+        for (auto *succ : bb->successor_list) {
+            succ->predecessor_list.push_back(bb.get());
+        }
     }
-    ostream << ") {" << std::endl;
-    for (const auto &bb : block_list) bb->Dump(ostream, "    ");
-    ostream << '}' << std::endl << std::endl;
 }
 
 void Module::Dump(std::ostream &ostream) const {
-    ostream << "target triple = \"x86_64-pc-linux-gnu\"" << std::endl
-            << std::endl;
+    util::Emitter emitter(ostream);
+    Dump(emitter);
+}
+
+void Module::Dump(util::Emitter &emitter) const {
+    emitter << "target triple = \"x86_64-pc-linux-gnu\"\n\n";
 
-    for (const auto &var : var_list) var->Dump(ostream);
-    if (!var_list.empty()) ostream << std::endl;
+    for (const auto &var : var_list) var->Dump(emitter);
+    if (!var_list.empty()) emitter << '\n';
 
-    for (const auto &func : func_decl_list) func->Dump(ostream);
-    if (!func_decl_list.empty()) ostream << std::endl;
+    for (const auto &func : func_decl_list) func->Dump(emitter);
+    if (!func_decl_list.empty()) emitter << '\n';
 
-    for (const auto &func : func_def_list) func->Dump(ostream);
+    for (const auto &func : func_def_list) func->Dump(emitter);
 }
 
 }  // namespace ir
@@ -1,5 +1,6 @@
 #include "ir/type.h"
 
+#include <memory>
 #include <string>
 
 namespace ir {
@@ -9,15 +10,11 @@ FuncType::FuncType(Type *ret_type, const std::vector<Type *> &param_list)
     for (auto *param : param_list) this->param_list.emplace_back(param);
 }
 
-std::string FuncType::RetTypeStr() const { return ret_type->Str(); }
-
-std::string FuncType::ParamListStr() const {
-    std::string type_str = "(";
-    for (auto iter = param_list.cbegin(); iter != param_list.cend(); ++iter) {
-        if (iter != param_list.cbegin()) type_str += ", ";
-        type_str += (*iter)->Str();
-    }
-    return type_str + ')';
+std::string Type::Str() const {
+    std::string str;
+    util::Emitter emitter(str);
+    Emit(emitter);
+    return str;
 }
 
 std::string FuncType::ParamListWithNameStr() const {
@@ -30,27 +27,47 @@ std::string FuncType::ParamListWithNameStr() const {
     return type_str + ')';
 }
 
-std::string FuncType::Str() const {
-    return RetTypeStr() + ' ' + ParamListStr();
+void FuncType::Emit(util::Emitter &emitter) const {
+    emitter << *ret_type << " (";
+    for (auto iter = param_list.cbegin(); iter != param_list.cend(); ++iter) {
+        if (iter != param_list.cbegin()) emitter << ", ";
+        emitter << **iter;
+    }
+    emitter << ')';
 }
 
-std::string IntType::Str() const {
-    switch (width) {
-        case kI1:
-            return "i1";
-        case kI32:
-            return "i32";
-    }
+const std::shared_ptr<IntType> &IntType::Get(const Width width) {
+    static const std::shared_ptr<IntType> i1 = std::make_shared<IntType>(kI1);
+    static const std::shared_ptr<IntType> i32
+        = std::make_shared<IntType>(kI32);
+    return width == kI1 ? i1 : i32;
 }
 
-std::string ArrayType::Str() const {
-    std::string type_str;
-    for (auto iter = arr_dim_list.cbegin(); iter != arr_dim_list.cend();
-         ++iter) {
-        type_str += '[' + std::to_string(*iter) + " x ";
-        if (iter + 1 == arr_dim_list.cend()) type_str += "i32";
-    }
-    return type_str + std::string(arr_dim_list.size(), ']');
+void IntType::Emit(util::Emitter &emitter) const {
+    emitter << (width == kI1 ? "i1" : "i32");
+}
+
+const std::shared_ptr<PtrType> &PtrType::Get() {
+    static const std::shared_ptr<PtrType> i32_ptr = std::make_shared<PtrType>();
+    return i32_ptr;
+}
+
+const std::shared_ptr<LabelType> &LabelType::Get() {
+    static const std::shared_ptr<LabelType> label
+        = std::make_shared<LabelType>();
+    return label;
+}
+
+const std::shared_ptr<VectorType> &VectorType::Get() {
+    static const std::shared_ptr<VectorType> i32x4
+        = std::make_shared<VectorType>(4);
+    return i32x4;
+}
+
+void ArrayType::Emit(util::Emitter &emitter) const {
+    for (int dim : arr_dim_list) emitter << '[' << dim << " x ";
+    if (!arr_dim_list.empty()) emitter << "i32";
+    for (int i = 0; i < arr_dim_list.size(); ++i) emitter << ']';
 }
 
 }  // namespace ir
@@ -1 +1,21 @@
 #include "ir/value.h"
+
+#include <string>
+
+namespace ir {
+
+std::string Value::Str() const {
+    std::string str;
+    util::Emitter emitter(str);
+    Emit(emitter);
+    return str;
+}
+
+std::string Value::TypeStr() const {
+    std::string str;
+    util::Emitter emitter(str);
+    emitter << WithType();
+    return str;
+}
+
+}  // namespace ir
@@ -0,0 +1,322 @@
+#include "opt/alias_analysis.h"
+
+#include <cstdint>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "ir/ir.h"
+#include "ir/type.h"
+#include "ir/value.h"
+#include "opt/mod_ref.h"
+
+namespace opt {
+
+namespace {
+
+// how far an index is followed back
+constexpr int kMaxDepth = 16;
+
+std::vector<int> GetDimList(const ir::Type &type) {
+    if (type.kind != ir::Type::kArray) return {};
+    return type.Cast<ir::ArrayType>().GetArrDimList();
+}
+
+bool IsPtr(const ir::Value &value) {
+    return value.GetType().kind == ir::Type::kPtr;
+}
+
+// the words in what ptr points to, 0 if it is no pointer
+std::int64_t GetPointeeSize(const ir::Value &ptr) {
+    if (!IsPtr(ptr)) return 0;
+    std::int64_t size = 1;
+    const auto &pointee = ptr.GetType().Cast<ir::PtrType>().GetPointee();
+    for (int dim : GetDimList(pointee)) size *= dim;
+    return size;
+}
+
+}  // namespace
+
+AliasAnalysis::AliasAnalysis(const ir::FuncDef &func,
+                             const bool noalias,
+                             const ModRefAnalysis *mod_ref)
+    : noalias(noalias), mod_ref(mod_ref) {
+    for (const auto &param : func.GetParamList()) {
+        if (IsPtr(*param)) param_set.insert(param->Str());
+    }
+
+    // the allocas of pointers stored to once, with a parameter
+    std::unordered_map<std::string, int> store_num;
+    for (const auto &bb : func.GetBlockList()) {
+        for (const auto &inst : bb->GetInstList()) {
+            if (auto result = inst->GetResultPtr()) {
+                def_map[result->Str()] = inst.get();
+            }
+            if (inst->kind != ir::Inst::kStore) continue;
+            const auto &store = inst->Cast<ir::StoreInst>();
+            const auto ptr = store.GetPtr().Str();
+            ++store_num[ptr];
+            if (param_set.count(store.GetValue().Str()) != 0) {
+                slot_map[ptr] = store.GetValue().Str();
+            }
+        }
+    }
+    for (auto iter = slot_map.begin(); iter != slot_map.end();) {
+        const auto def = def_map.find(iter->first);
+        if (store_num[iter->first] != 1 || def == def_map.end()
+            || def->second->kind != ir::Inst::kAlloca) {
+            iter = slot_map.erase(iter);
+        } else {
+            ++iter;
+        }
+    }
+
+    for (const auto &bb : func.GetBlockList()) {
+        for (const auto &inst : bb->GetInstList()) {
+            auto result = inst->GetResultPtr();
+            if (result != nullptr && IsPtr(*result)) {
+                location_map[result->Str()] = Resolve(*result);
+            }
+        }
+    }
+
+    // an alloca escapes through any use but as the address of a load, a
+    // store or a gep
+    auto escape = [this](const ir::Value &value) {
+        if (!IsPtr(value)) return;
+        const auto location = GetLocation(value);
+        if (location.kind == Location::kAlloca) {
+            escaped_set.insert(location.object);
+        }
+    };
+    for (const auto &bb : func.GetBlockList()) {
+        for (const auto &inst : bb->GetInstList()) {
+            switch (inst->kind) {
+                case ir::Inst::kLoad:
+                case ir::Inst::kGetelementptr:
+                case ir::Inst::kBitcast:
+                    break;
+                case ir::Inst::kStore:
+                    escape(inst->Cast<ir::StoreInst>().GetValue());
+                    break;
+                default:
+                    for (const auto &value : inst->GetUseList()) {
+                        escape(*value);
+                    }
+                    break;
+            }
+        }
+    }
+}
+
+Location AliasAnalysis::GetLocation(const ir::Value &ptr) const {
+    Location location;
+    if (ptr.kind == ir::Value::kGlobalVar) {
+        location.kind = Location::kGlobal;
+        location.object = ptr.Str();
+        location.size = GetPointeeSize(ptr);
+    } else if (param_set.count(ptr.Str()) != 0) {
+        location.kind = Location::kParam;
+        location.object = ptr.Str();
+    } else {
+        const auto iter = location_map.find(ptr.Str());
+        if (iter != location_map.end()) location = iter->second;
+    }
+    return location;
+}
+
+AliasAnalysis::AliasResult AliasAnalysis::Alias(const ir::Value &lhs,
+                                                const ir::Value &rhs) const {
+    if (lhs.Str() == rhs.Str()) return kMustAlias;
+    if (!MayShareObject(lhs, rhs)) return kNoAlias;
+    const auto a = GetLocation(lhs);
+    const auto b = GetLocation(rhs);
+    if (a.kind == Location::kUnknown || a.kind != b.kind
+        || a.object != b.object || a.term_map != b.term_map) {
+        return kMayAlias;
+    }
+    return a.offset == b.offset ? kMustAlias : kNoAlias;
+}
+
+bool AliasAnalysis::MayShareObject(const ir::Value &lhs,
+                                   const ir::Value &rhs) const {
+    const auto a = GetLocation(lhs);
+    const auto b = GetLocation(rhs);
+    if (a.kind == Location::kUnknown || b.kind == Location::kUnknown) {
+        // no pointer the analysis loses track of leads into a private alloca
+        return !IsPrivate(lhs) && !IsPrivate(rhs);
+    }
+    if (a.kind != b.kind) {
+        if (a.kind == Location::kAlloca || b.kind == Location::kAlloca) {
+            return false;
+        }
+        return !noalias;
+    }
+    return a.object == b.object || (a.kind == Location::kParam && !noalias);
+}
+
+bool AliasAnalysis::IsPrivate(const ir::Value &ptr) const {
+    const auto location = GetLocation(ptr);
+    return location.kind == Location::kAlloca
+           && escaped_set.count(location.object) == 0;
+}
+
+AliasAnalysis::ModRef AliasAnalysis::GetModRef(const ir::Inst &inst,
+                                               const ir::Value &ptr) const {
+    switch (inst.kind) {
+        case ir::Inst::kLoad:
+            return Alias(inst.Cast<ir::LoadInst>().GetPtr(), ptr) == kNoAlias
+                       ? kNoModRef
+                       : kRef;
+        case ir::Inst::kStore:
+            return Alias(inst.Cast<ir::StoreInst>().GetPtr(), ptr) == kNoAlias
+                       ? kNoModRef
+                       : kMod;
+        case ir::Inst::kCall:
+            break;
+        default:
+            return kNoModRef;
+    }
+
+    if (IsPrivate(ptr)) return kNoModRef;
+    const auto &call = inst.Cast<ir::CallInst>();
+    const auto *summary = mod_ref == nullptr
+                              ? nullptr
+                              : mod_ref->GetSummary(call.GetFunc().GetName());
+    if (summary == nullptr || summary->unknown) return kModRef;
+    // the globals the callee touches, where ptr may point
+    const auto location = GetLocation(ptr);
+    auto global = [&](const std::set<std::string> &global_set) {
+        if (global_set.empty()) return false;
+        switch (location.kind) {
+            case Location::kGlobal:
+                return global_set.count(location.object) != 0;
+            case Location::kParam:
+                return !noalias;
+            case Location::kAlloca:
+                return false;
+            default:
+                return true;
+        }
+    };
+    int mod_ref_bits = kNoModRef;
+    if (global(summary->ref_global_set)) mod_ref_bits |= kRef;
+    if (global(summary->mod_global_set)) mod_ref_bits |= kMod;
+    // and the arrays passed to it
+    for (int i = 0; i < call.GetParamNum(); ++i) {
+        const auto &param = *call.GetParamAt(i);
+        if (!IsPtr(param) || !MayShareObject(param, ptr)) continue;
+        if (summary->ref_param_set.count(i) != 0) mod_ref_bits |= kRef;
+        if (summary->mod_param_set.count(i) != 0) mod_ref_bits |= kMod;
+    }
+    return static_cast<ModRef>(mod_ref_bits);
+}
+
+Location AliasAnalysis::Resolve(const ir::Value &ptr) {
+    if (ptr.kind == ir::Value::kGlobalVar || param_set.count(ptr.Str()) != 0) {
+        return GetLocation(ptr);
+    }
+    const auto known = location_map.find(ptr.Str());
+    if (known != location_map.end()) return known->second;
+
+    Location location;
+    const auto def = def_map.find(ptr.Str());
+    if (def == def_map.end()) return location;
+    const auto &inst = *def->second;
+    switch (inst.kind) {
+        case ir::Inst::kAlloca:
+            location.kind = Location::kAlloca;
+            location.object = ptr.Str();
+            location.size = GetPointeeSize(ptr);
+            break;
+        case ir::Inst::kBitcast:
+            location = Resolve(inst.Cast<ir::BitcastInst>().GetValue());
+            break;
+        case ir::Inst::kLoad: {
+            const auto slot
+                = slot_map.find(inst.Cast<ir::LoadInst>().GetPtr().Str());
+            if (slot != slot_map.end()) {
+                location.kind = Location::kParam;
+                location.object = slot->second;
+            }
+            break;
+        }
+        case ir::Inst::kGetelementptr: {
+            // the first index steps over the pointee, each further one over
+            // an element of the array it is in
+            const auto &gep = inst.Cast<ir::GetelementptrInst>();
+            location = Resolve(gep.GetPtr());
+            if (location.kind == Location::kUnknown) break;
+            auto dim_list = GetDimList(
+                gep.GetPtr().GetType().Cast<ir::PtrType>().GetPointee());
+            for (int i = 0; i < gep.GetIdxNum(); ++i) {
+                if (i > 0 && !dim_list.empty()) {
+                    dim_list.erase(dim_list.begin());
+                }
+                std::int64_t stride = 1;
+                for (int dim : dim_list) stride *= dim;
+                AddTerm(*gep.GetIdxAt(i), stride, location, 0);
+            }
+            break;
+        }
+        default:
+            break;
+    }
+    return location;
+}
+
+void AliasAnalysis::AddTerm(const ir::Value &value,
+                            const std::int64_t scale,
+                            Location &location,
+                            const int depth) const {
+    if (value.kind == ir::Value::kImm) {
+        location.offset += scale * value.Cast<ir::Imm>().GetValue();
+        return;
+    }
+    const auto def = def_map.find(value.Str());
+    if (depth < kMaxDepth && def != def_map.end()
+        && def->second->kind == ir::Inst::kBinaryOp) {
+        const auto &op = def->second->Cast<ir::BinaryOpInst>();
+        const auto &lhs = op.GetLHS();
+        const auto &rhs = op.GetRHS();
+        switch (op.op_code) {
+            case ir::BinaryOpInst::kAdd:
+                AddTerm(lhs, scale, location, depth + 1);
+                AddTerm(rhs, scale, location, depth + 1);
+                return;
+            case ir::BinaryOpInst::kSub:
+                AddTerm(lhs, scale, location, depth + 1);
+                AddTerm(rhs, -scale, location, depth + 1);
+                return;
+            case ir::BinaryOpInst::kMul:
+                if (rhs.kind == ir::Value::kImm) {
+                    AddTerm(lhs, scale * rhs.Cast<ir::Imm>().GetValue(),
+                            location, depth + 1);
+                    return;
+                }
+                if (lhs.kind == ir::Value::kImm) {
+                    AddTerm(rhs, scale * lhs.Cast<ir::Imm>().GetValue(),
+                            location, depth + 1);
+                    return;
+                }
+                break;
+            case ir::BinaryOpInst::kShl:
+                if (rhs.kind == ir::Value::kImm
+                    && rhs.Cast<ir::Imm>().GetValue() >= 0
+                    && rhs.Cast<ir::Imm>().GetValue() < 31) {
+                    const int shift = rhs.Cast<ir::Imm>().GetValue();
+                    AddTerm(lhs, scale * (std::int64_t{1} << shift), location,
+                            depth + 1);
+                    return;
+                }
+                break;
+            default:
+                break;
+        }
+    }
+    auto &coefficient = location.term_map[value.Str()];
+    coefficient += scale;
+    if (coefficient == 0) location.term_map.erase(value.Str());
+}
+
+}  // namespace opt
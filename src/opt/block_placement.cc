@@ -0,0 +1,250 @@
+#include "opt/block_placement.h"
+
+#include <algorithm>
+#include <memory>
+#include <queue>
+#include <vector>
+
+#include "ir/ir.h"
+#include "ir/value.h"
+#include "opt/cfg.h"
+
+namespace opt {
+
+namespace {
+
+// static branch probabilities, after Ball and Larus
+constexpr double kLoopTaken = 0.88;
+constexpr double kEqualTaken = 0.375;
+// the times a loop runs for each entry into it
+constexpr double kLoopScale = 10;
+
+struct Edge {
+    int from;
+    int to;
+    double weight;
+    bool back;  // to a block that dominates from
+};
+
+// the chance that the br ending b goes to its true target
+double TrueProbability(const Graph &graph,
+                       const std::vector<int> &idom,
+                       const std::vector<int> &depth,
+                       const int b) {
+    const int if_true = graph.succ_list[b][0];
+    const int if_false = graph.succ_list[b][1];
+    const bool back_true = Dominates(idom, if_true, b);
+    const bool back_false = Dominates(idom, if_false, b);
+    if (back_true != back_false) {
+        return back_true ? kLoopTaken : 1 - kLoopTaken;
+    }
+    if (depth[if_true] != depth[if_false]) {
+        return depth[if_true] > depth[if_false] ? kLoopTaken : 1 - kLoopTaken;
+    }
+
+    const auto &inst_list = graph.block_list[b]->GetInstList();
+    const auto &cond = inst_list.back()->Cast<ir::BrInst>().GetCond();
+    for (const auto &inst : inst_list) {
+        if (inst->kind != ir::Inst::kIcmp) continue;
+        const auto &icmp = inst->Cast<ir::IcmpInst>();
+        if (icmp.GetResult().Str() != cond.Str()) continue;
+        if (icmp.op_code == ir::IcmpInst::kEQ) return kEqualTaken;
+        if (icmp.op_code == ir::IcmpInst::kNE) return 1 - kEqualTaken;
+        break;
+    }
+    return 0.5;
+}
+
+// The chance that b goes to each of its successors, by the counts of the
+// profile or else by the heuristics.
+std::vector<double> Probability(const Graph &graph,
+                                const std::vector<int> &idom,
+                                const std::vector<int> &depth,
+                                const bool has_profile,
+                                const int b) {
+    const auto &succ_list = graph.succ_list[b];
+    if (succ_list.size() != 2) return std::vector<double>(succ_list.size(), 1);
+    if (succ_list[0] == succ_list[1]) return {0.5, 0.5};
+    if (!has_profile) {
+        const double p = TrueProbability(graph, idom, depth, b);
+        return {p, 1 - p};
+    }
+    const auto count = [&graph](const int block) {
+        return static_cast<double>(graph.block_list[block]->GetCount());
+    };
+    const int if_true = succ_list[0];
+    const int if_false = succ_list[1];
+    double p = 0.5;
+    // exact when b is the only way into a target
+    if (count(b) > 0 && graph.pred_list[if_true].size() == 1) {
+        p = count(if_true) / count(b);
+    } else if (count(b) > 0 && graph.pred_list[if_false].size() == 1) {
+        p = 1 - count(if_false) / count(b);
+    } else if (count(if_true) + count(if_false) > 0) {
+        p = count(if_true) / (count(if_true) + count(if_false));
+    }
+    p = std::min(std::max(p, 0.0), 1.0);
+    return {p, 1 - p};
+}
+
+// The times each block runs, by the profile, or else passed down from the
+// entry along the edges in reverse post order, a loop header runs
+// kLoopScale times as often as the edges into the loop.
+std::vector<double> Frequency(const Graph &graph,
+                              const std::vector<int> &idom,
+                              const std::vector<std::vector<double>> &prob,
+                              const bool has_profile) {
+    const int block_num = static_cast<int>(graph.block_list.size());
+    std::vector<double> freq(block_num, 0);
+    if (has_profile) {
+        for (int b = 0; b < block_num; ++b) {
+            freq[b] = static_cast<double>(graph.block_list[b]->GetCount());
+        }
+        return freq;
+    }
+    freq[0] = 1;
+    for (int b : ReversePostOrder(graph)) {
+        for (int pred : graph.pred_list[b]) {
+            if (idom[pred] >= 0 && Dominates(idom, b, pred)) {
+                freq[b] *= kLoopScale;
+                break;
+            }
+        }
+        for (int i = 0; i < graph.succ_list[b].size(); ++i) {
+            const int succ = graph.succ_list[b][i];
+            if (!Dominates(idom, succ, b)) freq[succ] += freq[b] * prob[b][i];
+        }
+    }
+    return freq;
+}
+
+}  // namespace
+
+int BlockPlacement::Run(ir::FuncDef &func) {
+    Graph graph(func);
+    const int block_num = static_cast<int>(graph.block_list.size());
+    if (block_num < 3) return 0;
+
+    bool has_profile = true;
+    for (const auto &bb : graph.block_list) {
+        has_profile = has_profile && bb->HasCount();
+    }
+    const auto idom = Dominator(graph);
+    const auto depth = LoopDepth(graph, idom);
+    std::vector<std::vector<double>> prob(block_num);
+    for (int b = 0; b < block_num; ++b) {
+        if (idom[b] >= 0) {
+            prob[b] = Probability(graph, idom, depth, has_profile, b);
+        } else {
+            prob[b].assign(graph.succ_list[b].size(), 0);
+        }
+    }
+    const auto freq = Frequency(graph, idom, prob, has_profile);
+    std::vector<Edge> edge_list;
+    for (int b = 0; b < block_num; ++b) {
+        for (int i = 0; i < graph.succ_list[b].size(); ++i) {
+            const int succ = graph.succ_list[b][i];
+            edge_list.push_back({b, succ, freq[b] * prob[b][i],
+                                 idom[b] >= 0 && Dominates(idom, succ, b)});
+        }
+    }
+
+    // join the chains along the heaviest edges, the entry starts one
+    std::vector<std::vector<int>> chain_list(block_num);
+    std::vector<int> chain_of(block_num);
+    for (int b = 0; b < block_num; ++b) {
+        chain_list[b] = {b};
+        chain_of[b] = b;
+    }
+    // on a tie the latch of a loop falls through to the header
+    std::stable_sort(edge_list.begin(), edge_list.end(),
+                     [](const Edge &lhs, const Edge &rhs) {
+                         if (lhs.weight != rhs.weight) {
+                             return lhs.weight > rhs.weight;
+                         }
+                         return lhs.back && !rhs.back;
+                     });
+    for (const auto &edge : edge_list) {
+        if (edge.weight <= 0 || edge.to == 0) continue;
+        const int from = chain_of[edge.from];
+        const int to = chain_of[edge.to];
+        if (from == to || chain_list[from].back() != edge.from
+            || chain_list[to].front() != edge.to) {
+            continue;
+        }
+        for (int b : chain_list[to]) chain_of[b] = from;
+        auto &chain = chain_list[from];
+        chain.insert(chain.end(), chain_list[to].begin(), chain_list[to].end());
+        chain_list[to].clear();
+    }
+
+    // the chain the placed ones branch to the most goes next, by where its
+    // first block was on a tie, and a chain that never runs after the rest
+    std::vector<std::vector<Edge>> out_list(block_num);
+    for (const auto &edge : edge_list) out_list[edge.from].push_back(edge);
+    std::vector<bool> cold(block_num, true);
+    for (int b = 0; b < block_num; ++b) {
+        if (freq[b] > 0) cold[chain_of[b]] = false;
+    }
+    // a max heap of the chains not placed, an entry whose score has gone
+    // up since is stale and skipped
+    struct Candidate {
+        bool cold;
+        double score;
+        int front;
+        int chain;
+        bool operator<(const Candidate &other) const {
+            if (cold != other.cold) return cold;
+            if (score != other.score) return score < other.score;
+            return front > other.front;
+        }
+    };
+    std::vector<double> score(block_num, 0);
+    std::vector<bool> placed(block_num, false);
+    std::priority_queue<Candidate> ready;
+    auto push = [&](const int c) {
+        ready.push({cold[c], score[c], chain_list[c].front(), c});
+    };
+    for (int c = 0; c < block_num; ++c) {
+        if (c != chain_of[0] && !chain_list[c].empty()) push(c);
+    }
+    std::vector<int> order;
+    for (int next = chain_of[0]; next >= 0;) {
+        placed[next] = true;
+        for (int b : chain_list[next]) {
+            order.push_back(b);
+            for (const auto &edge : out_list[b]) {
+                const int c = chain_of[edge.to];
+                if (placed[c] || edge.weight <= 0) continue;
+                score[c] += edge.weight;
+                push(c);
+            }
+        }
+        next = -1;
+        while (!ready.empty() && next < 0) {
+            const auto top = ready.top();
+            ready.pop();
+            if (!placed[top.chain] && top.score == score[top.chain]) {
+                next = top.chain;
+            }
+        }
+    }
+
+    int moved = 0;
+    for (int i = 0; i < block_num; ++i) moved += order[i] != i;
+    if (moved == 0) return 0;
+
+    // the empty blocks are not dumped, they go at the end
+    auto &block_list = func.GetBlockList();
+    std::vector<std::shared_ptr<ir::BasicBlock>> empty_list;
+    for (const auto &bb : block_list) {
+        if (bb->GetInstList().empty()) empty_list.push_back(bb);
+    }
+    block_list.clear();
+    for (int b : order) block_list.push_back(graph.block_list[b]);
+    block_list.insert(block_list.end(), empty_list.begin(), empty_list.end());
+    func.Renumber();
+    return moved;
+}
+
+}  // namespace opt
@@ -0,0 +1,151 @@
+#include "opt/cfg.h"
+
+#include <algorithm>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "ir/ir.h"
+
+namespace opt {
+
+Graph::Graph(ir::FuncDef &func) {
+    std::unordered_map<std::string, int> index_map;
+    for (const auto &bb : func.GetBlockList()) {
+        if (bb->GetInstList().empty()) continue;
+        const int index = static_cast<int>(block_list.size());
+        index_map[bb->GetLabel().Str()] = index;
+        block_list.push_back(bb);
+    }
+    succ_list.resize(block_list.size());
+    pred_list.resize(block_list.size());
+    for (int b = 0; b < block_list.size(); ++b) {
+        const auto &last = block_list[b]->GetInstList().back();
+        if (last->kind != ir::Inst::kBr) continue;
+        const auto &br = last->Cast<ir::BrInst>();
+        std::vector<std::string> label_list{br.GetTrue().Str()};
+        if (!br.HasDest()) label_list.push_back(br.GetFalse().Str());
+        for (const auto &label : label_list) {
+            const int succ = index_map.at(label);
+            succ_list[b].push_back(succ);
+            pred_list[succ].push_back(b);
+        }
+    }
+}
+
+std::vector<int> ReversePostOrder(const Graph &graph) {
+    const int block_num = static_cast<int>(graph.block_list.size());
+    std::vector<int> order;
+    if (block_num == 0) return order;
+    // by an explicit depth-first walk
+    std::vector<bool> visited(block_num, false);
+    std::vector<std::pair<int, int>> stack{{0, 0}};
+    visited[0] = true;
+    while (!stack.empty()) {
+        auto &[b, next] = stack.back();
+        if (next < graph.succ_list[b].size()) {
+            const int succ = graph.succ_list[b][next++];
+            if (!visited[succ]) {
+                visited[succ] = true;
+                stack.emplace_back(succ, 0);
+            }
+        } else {
+            order.push_back(b);
+            stack.pop_back();
+        }
+    }
+    std::reverse(order.begin(), order.end());
+    return order;
+}
+
+std::vector<int> Dominator(const Graph &graph) {
+    const int block_num = static_cast<int>(graph.block_list.size());
+    const auto order = ReversePostOrder(graph);
+    std::vector<int> rpo(block_num, -1);
+    for (int i = 0; i < order.size(); ++i) rpo[order[i]] = i;
+
+    std::vector<int> idom(block_num, -1);
+    if (block_num == 0) return idom;
+    idom[0] = 0;
+    for (bool changed = true; changed;) {
+        changed = false;
+        for (int b : order) {
+            if (b == 0) continue;
+            int new_idom = -1;
+            for (int pred : graph.pred_list[b]) {
+                if (idom[pred] < 0) continue;
+                if (new_idom < 0) {
+                    new_idom = pred;
+                    continue;
+                }
+                int x = pred;
+                while (x != new_idom) {
+                    while (rpo[x] > rpo[new_idom]) x = idom[x];
+                    while (rpo[new_idom] > rpo[x]) new_idom = idom[new_idom];
+                }
+            }
+            if (idom[b] != new_idom) {
+                idom[b] = new_idom;
+                changed = true;
+            }
+        }
+    }
+    return idom;
+}
+
+std::vector<Loop> FindLoops(const Graph &graph, const std::vector<int> &idom) {
+    const int block_num = static_cast<int>(graph.block_list.size());
+    std::vector<Loop> loop_list;
+    // the header of the loop a block was last added to
+    std::vector<int> mark(block_num, -1);
+    for (int header = 0; header < block_num; ++header) {
+        if (idom[header] < 0) continue;
+        std::vector<int> worklist;
+        for (int pred : graph.pred_list[header]) {
+            if (idom[pred] >= 0 && Dominates(idom, header, pred)) {
+                worklist.push_back(pred);
+            }
+        }
+        if (worklist.empty()) continue;
+        Loop loop{header, {header}};
+        mark[header] = header;
+        while (!worklist.empty()) {
+            const int b = worklist.back();
+            worklist.pop_back();
+            if (mark[b] == header) continue;
+            mark[b] = header;
+            loop.block_list.push_back(b);
+            for (int pred : graph.pred_list[b]) {
+                if (idom[pred] >= 0 && mark[pred] != header) {
+                    worklist.push_back(pred);
+                }
+            }
+        }
+        loop_list.push_back(std::move(loop));
+    }
+    // a loop is larger than those nested in it
+    std::stable_sort(loop_list.begin(), loop_list.end(),
+                     [](const Loop &lhs, const Loop &rhs) {
+                         return lhs.block_list.size() < rhs.block_list.size();
+                     });
+    return loop_list;
+}
+
+std::vector<int> LoopDepth(const Graph &graph, const std::vector<int> &idom) {
+    std::vector<int> depth(graph.block_list.size(), 0);
+    for (const auto &loop : FindLoops(graph, idom)) {
+        for (int b : loop.block_list) ++depth[b];
+    }
+    return depth;
+}
+
+bool Dominates(const std::vector<int> &idom, const int a, int b) {
+    while (b != a) {
+        if (b == 0 || idom[b] < 0) return false;
+        b = idom[b];
+    }
+    return true;
+}
+
+}  // namespace opt
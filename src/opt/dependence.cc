@@ -0,0 +1,438 @@
+#include "opt/dependence.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <map>
+#include <numeric>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "ir/ir.h"
+#include "ir/type.h"
+#include "ir/value.h"
+#include "opt/alias_analysis.h"
+#include "opt/cfg.h"
+
+namespace opt {
+
+namespace {
+
+using DefMap = std::map<std::string, const ir::Inst *>;
+
+// how far an index is followed back
+constexpr int kMaxDepth = 16;
+
+bool HasKinds(const ir::BasicBlock &bb,
+              const std::vector<ir::Inst::InstKind> &kind_list) {
+    const auto &inst_list = bb.GetInstList();
+    return inst_list.size() == kind_list.size()
+           && std::equal(inst_list.begin(), inst_list.end(),
+                         kind_list.begin(),
+                         [](const std::shared_ptr<ir::Inst> &inst,
+                            const ir::Inst::InstKind kind) {
+                             return inst->kind == kind;
+                         });
+}
+
+// if inst is value + 1
+bool IsIncrement(const ir::Inst &inst, const ir::Value &value) {
+    if (inst.kind != ir::Inst::kBinaryOp) return false;
+    const auto &op = inst.Cast<ir::BinaryOpInst>();
+    auto one = [](const ir::Value &operand) {
+        return operand.kind == ir::Value::kImm
+               && operand.Cast<ir::Imm>().GetValue() == 1;
+    };
+    return op.op_code == ir::BinaryOpInst::kAdd
+           && ((op.GetLHS().Str() == value.Str() && one(op.GetRHS()))
+               || (one(op.GetLHS()) && op.GetRHS().Str() == value.Str()));
+}
+
+// match loop as a counted one, def_map is what the nest it is in defines
+bool MatchCounted(const Graph &graph,
+                  const Loop &loop,
+                  const DefMap &def_map,
+                  CountedLoop &counted) {
+    const auto &header = *graph.block_list[loop.header];
+    if (!HasKinds(header, {ir::Inst::kPhi, ir::Inst::kIcmp, ir::Inst::kBr})) {
+        return false;
+    }
+    auto iter = header.GetInstList().begin();
+    auto &phi = (*iter++)->Cast<ir::PhiInst>();
+    auto &cond = (*iter++)->Cast<ir::IcmpInst>();
+    const auto &br = (*iter)->Cast<ir::BrInst>();
+    if ((cond.op_code != ir::IcmpInst::kSLT
+         && cond.op_code != ir::IcmpInst::kSLE)
+        || cond.GetLHS().Str() != phi.GetResult().Str() || br.HasDest()
+        || br.GetCond().Str() != cond.GetResult().Str()) {
+        return false;
+    }
+
+    std::vector<bool> in_loop(graph.block_list.size(), false);
+    for (int b : loop.block_list) in_loop[b] = true;
+    for (int b : loop.block_list) {
+        for (int succ : graph.succ_list[b]) {
+            if (!in_loop[succ] && b != loop.header) return false;
+        }
+    }
+    const auto &succ_list = graph.succ_list[loop.header];
+    const auto &pred_list = graph.pred_list[loop.header];
+    if (!in_loop[succ_list[0]] || in_loop[succ_list[1]]
+        || pred_list.size() != 2
+        || in_loop[pred_list[0]] == in_loop[pred_list[1]]
+        || phi.GetValueNum() != 2) {
+        return false;
+    }
+    counted.header = loop.header;
+    counted.preheader = in_loop[pred_list[0]] ? pred_list[1] : pred_list[0];
+    counted.latch = in_loop[pred_list[0]] ? pred_list[0] : pred_list[1];
+    counted.exit = succ_list[1];
+    counted.phi = &phi;
+    counted.cond = &cond;
+
+    const ir::Value *init = nullptr;
+    const ir::Value *next = nullptr;
+    for (const auto &value : phi.GetValueList()) {
+        const auto label = value.label->Str();
+        if (label == graph.block_list[counted.preheader]->GetLabel().Str()) {
+            init = value.value.get();
+        } else if (label == graph.block_list[counted.latch]->GetLabel().Str()) {
+            next = value.value.get();
+        }
+    }
+    if (init == nullptr || next == nullptr || def_map.count(init->Str()) != 0
+        || def_map.count(cond.GetRHS().Str()) != 0) {
+        return false;
+    }
+    const auto def = def_map.find(next->Str());
+    if (def == def_map.end() || !IsIncrement(*def->second, phi.GetResult())) {
+        return false;
+    }
+    counted.next = def->second;
+    return true;
+}
+
+}  // namespace
+
+std::vector<PerfectNest> FindPerfectNests(const Graph &graph,
+                                          const std::vector<int> &idom) {
+    const int block_num = static_cast<int>(graph.block_list.size());
+    const auto loop_list = FindLoops(graph, idom);
+    std::vector<PerfectNest> nest_list;
+    for (const auto &outer : loop_list) {
+        std::vector<bool> in_nest(block_num, false);
+        for (int b : outer.block_list) in_nest[b] = true;
+        DefMap def_map;
+        for (int b : outer.block_list) {
+            for (const auto &inst : graph.block_list[b]->GetInstList()) {
+                if (auto result = inst->GetResultPtr()) {
+                    def_map[result->Str()] = inst.get();
+                }
+            }
+        }
+        PerfectNest nest;
+        if (!MatchCounted(graph, outer, def_map, nest.outer)) continue;
+        const auto inner = std::find_if(
+            loop_list.begin(), loop_list.end(), [&](const Loop &loop) {
+                return loop.header != outer.header && in_nest[loop.header]
+                       && MatchCounted(graph, loop, def_map, nest.inner)
+                       && nest.inner.preheader == outer.header;
+            });
+        if (inner == loop_list.end()
+            || inner->block_list.size() + 2 != outer.block_list.size()
+            || nest.inner.exit != nest.outer.latch
+            || !HasKinds(*graph.block_list[nest.outer.latch],
+                         {ir::Inst::kBinaryOp, ir::Inst::kBr})
+            || graph.block_list[nest.outer.latch]->GetInstList().front().get()
+                   != nest.outer.next) {
+            continue;
+        }
+
+        // the steps go to the phis alone, and nothing else leaves the nest
+        const std::string next_list[] = {
+            nest.outer.next->GetResultPtr()->Str(),
+            nest.inner.next->GetResultPtr()->Str()};
+        int next_use_num = 0;
+        bool escaped = false;
+        for (int b = 0; b < block_num; ++b) {
+            for (const auto &inst : graph.block_list[b]->GetInstList()) {
+                for (const auto &value : inst->GetUseList()) {
+                    const auto name = value->Str();
+                    if (!in_nest[b] && def_map.count(name) != 0) {
+                        escaped = true;
+                    }
+                    if (name == next_list[0] || name == next_list[1]) {
+                        ++next_use_num;
+                    }
+                }
+            }
+        }
+        if (escaped || next_use_num != 2) continue;
+        nest.block_list = outer.block_list;
+        nest_list.push_back(std::move(nest));
+    }
+    return nest_list;
+}
+
+DependenceAnalysis::DependenceAnalysis(const Graph &graph,
+                                       const std::vector<int> &block_list,
+                                       std::vector<std::string> iv_list,
+                                       const AliasAnalysis &alias_analysis)
+    : iv_list(std::move(iv_list)) {
+    for (int b : block_list) {
+        for (const auto &inst : graph.block_list[b]->GetInstList()) {
+            if (auto result = inst->GetResultPtr()) {
+                def_map[result->Str()] = inst.get();
+            }
+        }
+    }
+    for (int b : block_list) {
+        for (const auto &inst : graph.block_list[b]->GetInstList()) {
+            switch (inst->kind) {
+                case ir::Inst::kLoad:
+                case ir::Inst::kStore:
+                case ir::Inst::kCall:
+                    access_list.push_back(Analyze(*inst));
+                    break;
+                default:
+                    break;
+            }
+        }
+    }
+    for (int i = 0; i < access_list.size(); ++i) {
+        for (int j = i; j < access_list.size(); ++j) {
+            AddDependence(access_list[i], access_list[j], alias_analysis);
+        }
+    }
+}
+
+std::vector<std::int64_t> DependenceAnalysis::GetStrideList(
+    const int depth) const {
+    std::vector<std::int64_t> stride_list;
+    for (const auto &access : access_list) {
+        if (access.ptr == nullptr) continue;
+        if (!access.affine) {
+            stride_list.push_back(kUnknownStride);
+            continue;
+        }
+        std::int64_t stride = 0;
+        for (int k = 0; k < access.subscript_list.size(); ++k) {
+            const auto &term_map = access.subscript_list[k].term_map;
+            const auto term = term_map.find(iv_list[depth]);
+            if (term != term_map.end()) {
+                stride += term->second * access.stride_list[k];
+            }
+        }
+        stride_list.push_back(stride);
+    }
+    return stride_list;
+}
+
+bool DependenceAnalysis::CanInterchange(const int depth) const {
+    return std::all_of(direction_list.begin(), direction_list.end(),
+                       [depth](Direction direction) {
+                           std::swap(direction[depth], direction[depth + 1]);
+                           const auto first = std::find_if(
+                               direction.begin(), direction.end(),
+                               [](const int dir) { return dir != 0; });
+                           return first == direction.end() || *first > 0;
+                       });
+}
+
+bool DependenceAnalysis::CanTile(const int depth) const {
+    return std::all_of(direction_list.begin(), direction_list.end(),
+                       [depth](const Direction &direction) {
+                           const auto end = direction.begin() + depth;
+                           if (std::any_of(direction.begin(), end,
+                                           [](const int dir) {
+                                               return dir != 0;
+                                           })) {
+                               return true;
+                           }
+                           return direction[depth] >= 0
+                                  && direction[depth + 1] >= 0;
+                       });
+}
+
+DependenceAnalysis::Access DependenceAnalysis::Analyze(
+    const ir::Inst &inst) const {
+    Access access;
+    access.inst = &inst;
+    if (inst.kind == ir::Inst::kCall) return access;
+    access.ptr = inst.kind == ir::Inst::kLoad
+                     ? &inst.Cast<ir::LoadInst>().GetPtr()
+                     : &inst.Cast<ir::StoreInst>().GetPtr();
+    const auto def = def_map.find(access.ptr->Str());
+    if (def == def_map.end()) {
+        // the same word on every iteration
+        access.object = access.ptr->Str();
+        access.affine = true;
+        return access;
+    }
+    if (def->second->kind != ir::Inst::kGetelementptr) return access;
+
+    // the first index steps over the pointee, each further one over an
+    // element of the array it is in
+    const auto &gep = def->second->Cast<ir::GetelementptrInst>();
+    if (def_map.count(gep.GetPtr().Str()) != 0) return access;
+    access.object = gep.GetPtr().Str();
+    const auto &pointee
+        = gep.GetPtr().GetType().Cast<ir::PtrType>().GetPointee();
+    std::vector<int> dim_list;
+    if (pointee.kind == ir::Type::kArray) {
+        dim_list = pointee.Cast<ir::ArrayType>().GetArrDimList();
+    }
+    for (int i = 0; i < gep.GetIdxNum(); ++i) {
+        if (i > 0 && !dim_list.empty()) dim_list.erase(dim_list.begin());
+        std::int64_t stride = 1;
+        for (int dim : dim_list) stride *= dim;
+        Subscript subscript;
+        if (!AddTerm(*gep.GetIdxAt(i), 1, subscript, 0)) return access;
+        access.subscript_list.push_back(std::move(subscript));
+        access.stride_list.push_back(stride);
+    }
+    access.affine = true;
+    return access;
+}
+
+bool DependenceAnalysis::AddTerm(const ir::Value &value,
+                                 const std::int64_t scale,
+                                 Subscript &subscript,
+                                 const int depth) const {
+    if (value.kind == ir::Value::kImm) {
+        subscript.constant += scale * value.Cast<ir::Imm>().GetValue();
+        return true;
+    }
+    const auto def = def_map.find(value.Str());
+    const bool iv = std::find(iv_list.begin(), iv_list.end(), value.Str())
+                    != iv_list.end();
+    if (iv || def == def_map.end()) {
+        auto &coefficient = subscript.term_map[value.Str()];
+        coefficient += scale;
+        if (coefficient == 0) subscript.term_map.erase(value.Str());
+        return true;
+    }
+    if (depth >= kMaxDepth || def->second->kind != ir::Inst::kBinaryOp) {
+        return false;
+    }
+    const auto &op = def->second->Cast<ir::BinaryOpInst>();
+    const auto &lhs = op.GetLHS();
+    const auto &rhs = op.GetRHS();
+    switch (op.op_code) {
+        case ir::BinaryOpInst::kAdd:
+            return AddTerm(lhs, scale, subscript, depth + 1)
+                   && AddTerm(rhs, scale, subscript, depth + 1);
+        case ir::BinaryOpInst::kSub:
+            return AddTerm(lhs, scale, subscript, depth + 1)
+                   && AddTerm(rhs, -scale, subscript, depth + 1);
+        case ir::BinaryOpInst::kMul:
+            if (rhs.kind == ir::Value::kImm) {
+                return AddTerm(lhs, scale * rhs.Cast<ir::Imm>().GetValue(),
+                               subscript, depth + 1);
+            }
+            if (lhs.kind == ir::Value::kImm) {
+                return AddTerm(rhs, scale * lhs.Cast<ir::Imm>().GetValue(),
+                               subscript, depth + 1);
+            }
+            return false;
+        case ir::BinaryOpInst::kShl:
+            if (rhs.kind == ir::Value::kImm
+                && rhs.Cast<ir::Imm>().GetValue() >= 0
+                && rhs.Cast<ir::Imm>().GetValue() < 31) {
+                const int shift = rhs.Cast<ir::Imm>().GetValue();
+                return AddTerm(lhs, scale * (std::int64_t{1} << shift),
+                               subscript, depth + 1);
+            }
+            return false;
+        default:
+            return false;
+    }
+}
+
+void DependenceAnalysis::AddDependence(const Access &lhs,
+                                       const Access &rhs,
+                                       const AliasAnalysis &alias_analysis) {
+    if (lhs.inst->kind == ir::Inst::kLoad
+        && rhs.inst->kind == ir::Inst::kLoad) {
+        return;
+    }
+    bool known = lhs.ptr != nullptr && rhs.ptr != nullptr;
+    if (known && !alias_analysis.MayShareObject(*lhs.ptr, *rhs.ptr)) {
+        return;
+    }
+    known = known && lhs.affine && rhs.affine && lhs.object == rhs.object
+            && lhs.subscript_list.size() == rhs.subscript_list.size();
+
+    // The index k of rhs on the iteration delta after the one of lhs is the
+    // same as that of lhs where the sum of the coefficients of the steps
+    // delta takes in each direction is the difference of the constants. An
+    // induction variable with another coefficient in each, or another sum
+    // of the other values, tells nothing.
+    auto solvable = [&](const int k, const Direction &direction) {
+        const auto &a = lhs.subscript_list[k];
+        const auto &b = rhs.subscript_list[k];
+        std::vector<std::int64_t> coefficient_list;
+        auto a_rest = a.term_map;
+        auto b_rest = b.term_map;
+        for (int d = 0; d < iv_list.size(); ++d) {
+            const auto a_term = a_rest.find(iv_list[d]);
+            const auto b_term = b_rest.find(iv_list[d]);
+            const std::int64_t a_coef
+                = a_term == a_rest.end() ? 0 : a_term->second;
+            const std::int64_t b_coef
+                = b_term == b_rest.end() ? 0 : b_term->second;
+            if (a_coef != b_coef) return true;
+            if (a_term != a_rest.end()) a_rest.erase(a_term);
+            if (b_term != b_rest.end()) b_rest.erase(b_term);
+            if (direction[d] != 0 && b_coef != 0) {
+                coefficient_list.push_back(b_coef * direction[d]);
+            }
+        }
+        if (a_rest != b_rest) return true;
+        // the sum of each coefficient times a step of at least 1
+        const std::int64_t diff = a.constant - b.constant;
+        if (coefficient_list.empty()) return diff == 0;
+        if (coefficient_list.size() == 1) {
+            return diff % coefficient_list[0] == 0
+                   && diff / coefficient_list[0] >= 1;
+        }
+        std::int64_t gcd = 0;
+        for (auto coefficient : coefficient_list) {
+            gcd = std::gcd(gcd, std::abs(coefficient));
+        }
+        return diff % gcd == 0;
+    };
+
+    // every direction, the induction variable of the outermost loop the
+    // slowest
+    const int depth = static_cast<int>(iv_list.size());
+    Direction direction(depth, -1);
+    while (true) {
+        bool possible = true;
+        for (int k = 0; known && possible && k < lhs.subscript_list.size();
+             ++k) {
+            possible = solvable(k, direction);
+        }
+        if (possible) AddDirection(direction);
+        int d = depth - 1;
+        while (d >= 0 && direction[d] == 1) direction[d--] = -1;
+        if (d < 0) break;
+        ++direction[d];
+    }
+}
+
+void DependenceAnalysis::AddDirection(Direction direction) {
+    const auto first = std::find_if(direction.begin(), direction.end(),
+                                    [](const int dir) { return dir != 0; });
+    if (first == direction.end()) return;
+    if (*first < 0) {
+        for (auto &dir : direction) dir = -dir;
+    }
+    if (std::find(direction_list.begin(), direction_list.end(), direction)
+        == direction_list.end()) {
+        direction_list.push_back(std::move(direction));
+    }
+}
+
+}  // namespace opt
@@ -0,0 +1,444 @@
+#include "opt/if_conversion.h"
+
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "ir/ir.h"
+#include "ir/type.h"
+#include "ir/value.h"
+#include "opt/numbering.h"
+
+namespace opt {
+
+namespace {
+
+using BlockPtr = std::shared_ptr<ir::BasicBlock>;
+using InstPtr = std::shared_ptr<ir::Inst>;
+using ValuePtr = std::shared_ptr<ir::Value>;
+
+bool IsI32(const ir::Type &type) {
+    return type.kind == ir::Type::kInt
+           && type.Cast<ir::IntType>().GetWidth() == ir::IntType::kI32;
+}
+
+// What the pass needs to know about the function.
+struct FuncInfo {
+    std::unordered_map<std::string, BlockPtr> block_map;  // by label
+    std::unordered_map<std::string, int> pred_num;        // by label
+    std::unordered_set<std::string> alloca_set;
+    std::unordered_map<std::string, const ir::GetelementptrInst *> gep_map;
+
+    explicit FuncInfo(ir::FuncDef &func) {
+        for (const auto &bb : func.GetBlockList()) {
+            block_map[bb->GetLabel().Str()] = bb;
+            for (const auto &label : GetSuccessorList(*bb)) ++pred_num[label];
+            for (const auto &inst : bb->GetInstList()) {
+                if (inst->kind == ir::Inst::kAlloca) {
+                    alloca_set.insert(inst->GetResultPtr()->Str());
+                } else if (inst->kind == ir::Inst::kGetelementptr) {
+                    gep_map[inst->GetResultPtr()->Str()]
+                        = &inst->Cast<ir::GetelementptrInst>();
+                }
+            }
+        }
+    }
+
+    bool IsScalar(const ir::Value &ptr) const {
+        return opt::IsScalar(ptr, alloca_set);
+    }
+
+    // an element of a global or local array at constant in-bound indices
+    bool IsConstElement(const ir::Value &ptr) const {
+        auto iter = gep_map.find(ptr.Str());
+        if (iter == gep_map.end()) return false;
+        const auto &gep = *iter->second;
+        const auto &base = gep.GetPtr();
+        if (base.kind != ir::Value::kGlobalVar
+            && alloca_set.count(base.Str()) == 0) {
+            return false;
+        }
+        const auto &pointee
+            = base.GetType().Cast<ir::PtrType>().GetPointee();
+        if (pointee.kind != ir::Type::kArray) return false;
+        const auto &dim_list = pointee.Cast<ir::ArrayType>().GetArrDimList();
+        if (gep.GetIdxNum() > dim_list.size() + 1) return false;
+        for (int i = 0; i < gep.GetIdxNum(); ++i) {
+            const auto &idx = *gep.GetIdxAt(i);
+            if (idx.kind != ir::Value::kImm) return false;
+            const int value = idx.Cast<ir::Imm>().GetValue();
+            const int bound = i == 0 ? 1 : dim_list[i - 1];
+            if (value < 0 || value >= bound) return false;
+        }
+        return true;
+    }
+
+    BlockPtr GetBlock(const std::string &label) const {
+        auto iter = block_map.find(label);
+        return iter == block_map.end() ? nullptr : iter->second;
+    }
+    int GetPredNum(const std::string &label) const {
+        auto iter = pred_num.find(label);
+        return iter == pred_num.end() ? 0 : iter->second;
+    }
+};
+
+// An arm has the branching block as its only predecessor and jumps on.
+bool IsArm(const BlockPtr &bb, const FuncInfo &info) {
+    if (bb == nullptr || info.GetPredNum(bb->GetLabel().Str()) != 1) {
+        return false;
+    }
+    auto *br = GetBr(*bb);
+    if (br == nullptr || !br->HasDest()) return false;
+    return bb->GetInstList().front()->kind != ir::Inst::kPhi;
+}
+
+std::string JumpTarget(ir::BasicBlock &bb) {
+    return GetBr(bb)->GetDest().Str();
+}
+
+bool CanSpeculate(ir::Inst &inst,
+                  const FuncInfo &info,
+                  const Numbering &numbering,
+                  const std::unordered_set<std::string> &accessed) {
+    auto safe = [&](const ir::Value &ptr) {
+        return info.IsScalar(ptr) || info.IsConstElement(ptr)
+               || accessed.count(numbering.Key(ptr)) != 0;
+    };
+    switch (inst.kind) {
+        case ir::Inst::kBinaryOp: {
+            const auto &op = inst.Cast<ir::BinaryOpInst>();
+            if (op.op_code != ir::BinaryOpInst::kSDiv
+                && op.op_code != ir::BinaryOpInst::kSRem) {
+                return true;
+            }
+            // no division by zero nor INT_MIN / -1
+            const auto &rhs = op.GetRHS();
+            if (rhs.kind != ir::Value::kImm) return false;
+            const int value = rhs.Cast<ir::Imm>().GetValue();
+            return value != 0 && value != -1;
+        }
+        case ir::Inst::kBitwiseOp:
+        case ir::Inst::kAlloca:
+        case ir::Inst::kGetelementptr:
+        case ir::Inst::kZext:
+        case ir::Inst::kBitcast:
+        case ir::Inst::kIcmp:
+        case ir::Inst::kSelect:
+            return true;
+        case ir::Inst::kLoad:
+            return safe(*inst.GetUseList()[0]);
+        case ir::Inst::kStore: {
+            const auto use_list = inst.GetUseList();
+            return IsI32(use_list[0]->GetType()) && safe(*use_list[1]);
+        }
+        default:
+            return false;
+    }
+}
+
+// Move the arms into head, masking the stores on cond.
+class Merger {
+  public:
+    Merger(const FuncInfo &info,
+           std::list<InstPtr> &inst_list,
+           ValuePtr cond)
+        : info(info), inst_list(inst_list), cond(std::move(cond)) {
+        // what the head leaves in the scalars
+        for (const auto &inst : inst_list) {
+            if (inst->kind == ir::Inst::kLoad) {
+                const auto ptr = inst->GetUseList()[0];
+                if (info.IsScalar(*ptr)) {
+                    known[ptr->Str()] = inst->GetResultPtr();
+                }
+            } else if (inst->kind == ir::Inst::kStore) {
+                const auto use_list = inst->GetUseList();
+                if (info.IsScalar(*use_list[1])) {
+                    known[use_list[1]->Str()] = use_list[0];
+                }
+            } else if (inst->kind == ir::Inst::kCall) {
+                for (auto iter = known.begin(); iter != known.end();) {
+                    if (iter->first[0] == '@') {
+                        iter = known.erase(iter);
+                    } else {
+                        ++iter;
+                    }
+                }
+            }
+        }
+    }
+
+    // run on the true path if mask, else on the false path
+    void AddArm(ir::BasicBlock &arm, const bool mask) {
+        for (const auto &inst : arm.GetInstList()) {
+            if (inst->kind == ir::Inst::kBr) break;
+            if (inst->kind == ir::Inst::kStore) {
+                AddStore(inst, mask);
+                continue;
+            }
+            if (inst->kind == ir::Inst::kLoad) {
+                const auto ptr = inst->GetUseList()[0];
+                if (info.IsScalar(*ptr)) {
+                    last_store.erase(ptr->Str());
+                    known[ptr->Str()] = inst->GetResultPtr();
+                }
+            }
+            inst_list.push_back(inst);
+        }
+    }
+
+    ValuePtr AddSelect(const ValuePtr &if_true, const ValuePtr &if_false) {
+        auto result = std::make_shared<ir::TmpVar>(0);
+        inst_list.push_back(
+            std::make_shared<ir::SelectInst>(result, cond, if_true, if_false));
+        select_map[result.get()] = {if_true, if_false};
+        return result;
+    }
+
+  private:
+    struct Select {
+        ValuePtr if_true;
+        ValuePtr if_false;
+    };
+
+    const FuncInfo &info;
+    std::list<InstPtr> &inst_list;
+    const ValuePtr cond;
+    // the value in each scalar
+    std::unordered_map<std::string, ValuePtr> known;
+    // the last masked store to each scalar that nothing has read yet
+    std::unordered_map<std::string, std::list<InstPtr>::iterator> last_store;
+    // the selects on cond made so far
+    std::unordered_map<const ir::Value *, Select> select_map;
+
+    void AddStore(const InstPtr &inst, const bool mask) {
+        auto &store = inst->Cast<ir::StoreInst>();
+        const auto ptr = store.GetPtrPtr();
+        const auto name = ptr->Str();
+        const bool scalar = info.IsScalar(*ptr);
+
+        ValuePtr old;
+        if (scalar && known.count(name) != 0) {
+            old = known[name];
+        } else {
+            auto result = std::make_shared<ir::TmpVar>(0);
+            inst_list.push_back(std::make_shared<ir::LoadInst>(
+                result, std::static_pointer_cast<ir::Var>(ptr)));
+            old = result;
+        }
+
+        // select cond, (select cond, a, b), c => select cond, a, c
+        auto value = store.GetValuePtr();
+        auto other = select_map.find(old.get());
+        if (mask) {
+            store.SetValue(AddSelect(
+                value, other != select_map.end() ? other->second.if_false
+                                                 : old));
+        } else {
+            store.SetValue(AddSelect(other != select_map.end()
+                                         ? other->second.if_true
+                                         : old,
+                                     value));
+        }
+        inst_list.push_back(inst);
+
+        if (!scalar) return;
+        // overwritten before anyone reads it
+        auto prev = last_store.find(name);
+        if (prev != last_store.end()) inst_list.erase(prev->second);
+        last_store[name] = std::prev(inst_list.end());
+        known[name] = store.GetValuePtr();
+    }
+};
+
+// remove the instructions of bb with no side effect and an unused result
+void RemoveDeadInst(ir::FuncDef &func, ir::BasicBlock &bb) {
+    for (bool changed = true; changed;) {
+        changed = false;
+        std::unordered_set<const ir::Value *> used;
+        for (const auto &other : func.GetBlockList()) {
+            for (const auto &inst : other->GetInstList()) {
+                for (const auto &use : inst->GetUseList()) {
+                    used.insert(use.get());
+                }
+            }
+        }
+        auto &inst_list = bb.GetInstList();
+        for (auto iter = inst_list.begin(); iter != inst_list.end();) {
+            const auto kind = (*iter)->kind;
+            const bool pure = kind == ir::Inst::kBinaryOp
+                              || kind == ir::Inst::kBitwiseOp
+                              || kind == ir::Inst::kLoad
+                              || kind == ir::Inst::kGetelementptr
+                              || kind == ir::Inst::kZext
+                              || kind == ir::Inst::kIcmp
+                              || kind == ir::Inst::kSelect;
+            if (pure && used.count((*iter)->GetResultPtr().get()) == 0) {
+                iter = inst_list.erase(iter);
+                changed = true;
+            } else {
+                ++iter;
+            }
+        }
+    }
+}
+
+// merge join into head if head is the only way in
+void MergeJoin(ir::FuncDef &func, const BlockPtr &head, const BlockPtr &join) {
+    auto &block_list = func.GetBlockList();
+    if (join == block_list.front()) return;
+    FuncInfo info(func);
+    if (info.GetPredNum(join->GetLabel().Str()) != 1) return;
+
+    auto &join_list = join->GetInstList();
+    while (!join_list.empty() && join_list.front()->kind == ir::Inst::kPhi) {
+        auto &phi = join_list.front()->Cast<ir::PhiInst>();
+        ReplaceAllUses(func, phi.GetResultPtr(), phi.GetValueAt(0).value);
+        join_list.pop_front();
+    }
+    for (const auto &label : GetSuccessorList(*join)) {
+        for (const auto &inst : info.GetBlock(label)->GetInstList()) {
+            if (inst->kind != ir::Inst::kPhi) break;
+            for (auto &value : inst->Cast<ir::PhiInst>().GetValueList()) {
+                if (value.label->Str() == join->GetLabel().Str()) {
+                    value.label = head->GetLabelPtr();
+                }
+            }
+        }
+    }
+    head->GetInstList().pop_back();
+    head->GetInstList().splice(head->GetInstList().end(), join_list);
+    block_list.remove(join);
+}
+
+bool ConvertOne(ir::FuncDef &func, const int max_cost) {
+    FuncInfo info(func);
+    for (const auto &head : func.GetBlockList()) {
+        auto *br = GetBr(*head);
+        if (br == nullptr || br->HasDest()
+            || br->GetCond().kind == ir::Value::kImm) {
+            continue;
+        }
+        auto if_true = info.GetBlock(br->GetTrue().Str());
+        auto if_false = info.GetBlock(br->GetFalse().Str());
+        if (if_true == nullptr || if_false == nullptr || if_true == if_false
+            || if_true == head || if_false == head) {
+            continue;
+        }
+
+        BlockPtr then_bb;
+        BlockPtr else_bb;
+        BlockPtr join;
+        if (IsArm(if_true, info)
+            && JumpTarget(*if_true) == if_false->GetLabel().Str()) {
+            then_bb = if_true;
+            join = if_false;
+        } else if (IsArm(if_false, info)
+                   && JumpTarget(*if_false) == if_true->GetLabel().Str()) {
+            else_bb = if_false;
+            join = if_true;
+        } else if (IsArm(if_true, info) && IsArm(if_false, info)
+                   && JumpTarget(*if_true) == JumpTarget(*if_false)) {
+            then_bb = if_true;
+            else_bb = if_false;
+            join = info.GetBlock(JumpTarget(*if_true));
+        } else {
+            continue;
+        }
+        if (join == nullptr || join == head) continue;
+
+        // the cost model, and whether the arms can run on both paths
+        Numbering numbering(info.alloca_set);
+        std::unordered_set<std::string> accessed;
+        for (const auto &inst : head->GetInstList()) {
+            if (inst->kind == ir::Inst::kLoad) {
+                accessed.insert(numbering.Key(*inst->GetUseList()[0]));
+            } else if (inst->kind == ir::Inst::kStore) {
+                accessed.insert(numbering.Key(*inst->GetUseList()[1]));
+            }
+            numbering.Visit(*inst);
+        }
+        int cost = 0;
+        bool ok = true;
+        for (const auto &arm : {then_bb, else_bb}) {
+            if (arm == nullptr) continue;
+            for (const auto &inst : arm->GetInstList()) {
+                if (inst->kind == ir::Inst::kBr) break;
+                if (!CanSpeculate(*inst, info, numbering, accessed)) {
+                    ok = false;
+                    break;
+                }
+                cost += inst->kind == ir::Inst::kStore ? 3 : 1;
+                numbering.Visit(*inst);
+            }
+        }
+        // each phi of join becomes a select
+        std::vector<ir::PhiInst *> phi_list;
+        for (const auto &inst : join->GetInstList()) {
+            if (inst->kind != ir::Inst::kPhi) break;
+            phi_list.push_back(&inst->Cast<ir::PhiInst>());
+            ++cost;
+        }
+        if (!ok || cost > max_cost) continue;
+
+        const auto &true_label = (then_bb ? then_bb : head)->GetLabel().Str();
+        const auto &false_label = (else_bb ? else_bb : head)->GetLabel().Str();
+        auto find_value = [](const ir::PhiInst &phi, const std::string &label) {
+            for (const auto &value : phi.GetValueList()) {
+                if (value.label->Str() == label) return value.value;
+            }
+            return ValuePtr();
+        };
+        for (const auto *phi : phi_list) {
+            if (find_value(*phi, true_label) == nullptr
+                || find_value(*phi, false_label) == nullptr) {
+                ok = false;
+            }
+        }
+        if (!ok) continue;
+
+        // rebuild head
+        auto cond = br->GetCondPtr();
+        auto &inst_list = head->GetInstList();
+        inst_list.pop_back();
+        Merger merger(info, inst_list, cond);
+        if (then_bb != nullptr) merger.AddArm(*then_bb, true);
+        if (else_bb != nullptr) merger.AddArm(*else_bb, false);
+        for (auto *phi : phi_list) {
+            auto select = merger.AddSelect(find_value(*phi, true_label),
+                                           find_value(*phi, false_label));
+            std::vector<ir::PhiInst::PhiValue> value_list;
+            for (const auto &value : phi->GetValueList()) {
+                const auto &label = value.label->Str();
+                if (label != true_label && label != false_label) {
+                    value_list.push_back(value);
+                }
+            }
+            value_list.emplace_back(select, head->GetLabelPtr());
+            phi->GetValueList() = value_list;
+        }
+        inst_list.push_back(std::make_shared<ir::BrInst>(join->GetLabelPtr()));
+
+        auto &block_list = func.GetBlockList();
+        if (then_bb != nullptr) block_list.remove(then_bb);
+        if (else_bb != nullptr) block_list.remove(else_bb);
+        MergeJoin(func, head, join);
+        RemoveDeadInst(func, *head);
+        return true;
+    }
+    return false;
+}
+
+}  // namespace
+
+int IfConversion::Run(ir::FuncDef &func) {
+    int count = 0;
+    while (ConvertOne(func, max_cost)) ++count;
+    if (count > 0) func.Renumber();
+    return count;
+}
+
+}  // namespace opt
@@ -0,0 +1,279 @@
+#include "opt/load_store_elimination.h"
+
+#include <algorithm>
+#include <iterator>
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "ir/ir.h"
+#include "ir/value.h"
+#include "opt/alias_analysis.h"
+#include "opt/cfg.h"
+#include "opt/mod_ref.h"
+
+namespace opt {
+
+namespace {
+
+using ValuePtr = std::shared_ptr<ir::Value>;
+
+// how many words are kept track of at once
+constexpr int kMaxKnown = 64;
+
+// the word ptr points to holds value
+struct Known {
+    ValuePtr ptr;
+    ValuePtr value;
+};
+using KnownList = std::vector<Known>;
+
+bool Contains(const KnownList &known_list, const Known &known) {
+    return std::any_of(known_list.begin(), known_list.end(),
+                       [&known](const Known &other) {
+                           return other.ptr->Str() == known.ptr->Str()
+                                  && other.value->Str() == known.value->Str();
+                       });
+}
+
+bool Same(const KnownList &lhs, const KnownList &rhs) {
+    if (lhs.size() != rhs.size()) return false;
+    return std::all_of(lhs.begin(), lhs.end(), [&rhs](const Known &known) {
+        return Contains(rhs, known);
+    });
+}
+
+// What is known of memory through a block, the loads replaced so far go
+// to replace_map.
+class Forward {
+  public:
+    Forward(const AliasAnalysis &alias_analysis,
+            const std::unordered_map<const ir::Value *, ValuePtr> &replace_map)
+        : alias_analysis(alias_analysis), replace_map(replace_map) {}
+
+    ValuePtr Resolve(ValuePtr value) const {
+        for (auto iter = replace_map.find(value.get());
+             iter != replace_map.end();
+             iter = replace_map.find(value.get())) {
+            value = iter->second;
+        }
+        return value;
+    }
+
+    // Update known_list past inst. Return the value a redundant load reads
+    // or a redundant store writes, or nullptr.
+    ValuePtr Step(const ir::Inst &inst, KnownList &known_list) const {
+        switch (inst.kind) {
+            case ir::Inst::kLoad: {
+                const auto &load = inst.Cast<ir::LoadInst>();
+                const int i = Find(known_list, load.GetPtr());
+                if (i >= 0) return Resolve(known_list[i].value);
+                Add(known_list, {load.GetPtrPtr(), inst.GetResultPtr()});
+                return nullptr;
+            }
+            case ir::Inst::kStore: {
+                const auto &store = inst.Cast<ir::StoreInst>();
+                auto value = Resolve(store.GetValuePtr());
+                const int i = Find(known_list, store.GetPtr());
+                if (i >= 0
+                    && Resolve(known_list[i].value)->Str() == value->Str()) {
+                    return value;
+                }
+                Kill(known_list, [&](const ir::Value &ptr) {
+                    return alias_analysis.Alias(ptr, store.GetPtr())
+                           != AliasAnalysis::kNoAlias;
+                });
+                Add(known_list, {store.GetPtrPtr(), std::move(value)});
+                return nullptr;
+            }
+            case ir::Inst::kCall:
+                Kill(known_list, [&](const ir::Value &ptr) {
+                    return (alias_analysis.GetModRef(inst, ptr)
+                            & AliasAnalysis::kMod)
+                           != 0;
+                });
+                return nullptr;
+            default:
+                return nullptr;
+        }
+    }
+
+  private:
+    const AliasAnalysis &alias_analysis;
+    const std::unordered_map<const ir::Value *, ValuePtr> &replace_map;
+
+    int Find(const KnownList &known_list, const ir::Value &ptr) const {
+        for (int i = 0; i < known_list.size(); ++i) {
+            if (alias_analysis.Alias(*known_list[i].ptr, ptr)
+                == AliasAnalysis::kMustAlias) {
+                return i;
+            }
+        }
+        return -1;
+    }
+
+    static void Add(KnownList &known_list, Known known) {
+        if (known_list.size() >= kMaxKnown) {
+            known_list.erase(known_list.begin());
+        }
+        known_list.push_back(std::move(known));
+    }
+
+    template <typename Pred>
+    static void Kill(KnownList &known_list, Pred clobbered) {
+        known_list.erase(std::remove_if(known_list.begin(), known_list.end(),
+                                        [&clobbered](const Known &known) {
+                                            return clobbered(*known.ptr);
+                                        }),
+                         known_list.end());
+    }
+};
+
+// drop the stores of bb a later store overwrites before anything may read
+// the word, return how many
+int RemoveDeadStores(const AliasAnalysis &alias_analysis, ir::BasicBlock &bb) {
+    auto &inst_list = bb.GetInstList();
+    std::vector<const ir::Value *> overwritten;
+    std::unordered_set<const ir::Inst *> dead;
+    auto kill = [&overwritten](auto clobbered) {
+        overwritten.erase(std::remove_if(overwritten.begin(),
+                                         overwritten.end(), clobbered),
+                          overwritten.end());
+    };
+    for (auto iter = inst_list.rbegin(); iter != inst_list.rend(); ++iter) {
+        const auto &inst = **iter;
+        switch (inst.kind) {
+            case ir::Inst::kStore: {
+                const auto &ptr = inst.Cast<ir::StoreInst>().GetPtr();
+                const bool later = std::any_of(
+                    overwritten.begin(), overwritten.end(),
+                    [&](const ir::Value *other) {
+                        return alias_analysis.Alias(*other, ptr)
+                               == AliasAnalysis::kMustAlias;
+                    });
+                if (later) {
+                    dead.insert(&inst);
+                } else if (overwritten.size() < kMaxKnown) {
+                    overwritten.push_back(&ptr);
+                }
+                break;
+            }
+            case ir::Inst::kLoad: {
+                const auto &ptr = inst.Cast<ir::LoadInst>().GetPtr();
+                kill([&](const ir::Value *other) {
+                    return alias_analysis.Alias(*other, ptr)
+                           != AliasAnalysis::kNoAlias;
+                });
+                break;
+            }
+            case ir::Inst::kCall:
+                kill([&](const ir::Value *other) {
+                    return (alias_analysis.GetModRef(inst, *other)
+                            & AliasAnalysis::kRef)
+                           != 0;
+                });
+                break;
+            default:
+                break;
+        }
+    }
+    inst_list.remove_if([&dead](const std::shared_ptr<ir::Inst> &inst) {
+        return dead.count(inst.get()) != 0;
+    });
+    return static_cast<int>(dead.size());
+}
+
+}  // namespace
+
+void LoadStoreElimination::Prepare(const ir::Module &module) {
+    mod_ref = std::make_unique<ModRefAnalysis>(module);
+}
+
+int LoadStoreElimination::Run(ir::FuncDef &func) {
+    Graph graph(func);
+    const int block_num = static_cast<int>(graph.block_list.size());
+    if (block_num == 0) return 0;
+    const AliasAnalysis alias_analysis(func, false, mod_ref.get());
+    std::unordered_map<const ir::Value *, ValuePtr> replace_map;
+    const Forward forward(alias_analysis, replace_map);
+
+    // what is known on the way out of each block, what is known on the way
+    // in is what all the predecessors agree on, starting from everything
+    // for those not yet seen
+    const auto order = ReversePostOrder(graph);
+    std::vector<KnownList> out(block_num);
+    std::vector<bool> seen(block_num, false);
+    auto meet = [&](const int b) {
+        KnownList known_list;
+        if (b == 0) return known_list;
+        bool first = true;
+        for (int pred : graph.pred_list[b]) {
+            if (!seen[pred]) continue;
+            if (first) {
+                known_list = out[pred];
+                first = false;
+                continue;
+            }
+            known_list.erase(std::remove_if(known_list.begin(),
+                                            known_list.end(),
+                                            [&](const Known &known) {
+                                                return !Contains(out[pred],
+                                                                 known);
+                                            }),
+                             known_list.end());
+        }
+        return known_list;
+    };
+    for (bool changed = true; changed;) {
+        changed = false;
+        for (int b : order) {
+            auto known_list = meet(b);
+            for (const auto &inst : graph.block_list[b]->GetInstList()) {
+                forward.Step(*inst, known_list);
+            }
+            if (!seen[b] || !Same(known_list, out[b])) {
+                out[b] = std::move(known_list);
+                seen[b] = true;
+                changed = true;
+            }
+        }
+    }
+
+    int count = 0;
+    for (int b : order) {
+        auto known_list = meet(b);
+        auto &inst_list = graph.block_list[b]->GetInstList();
+        for (auto iter = inst_list.begin(); iter != inst_list.end();) {
+            const auto &inst = **iter;
+            auto value = forward.Step(inst, known_list);
+            if (value == nullptr) {
+                ++iter;
+                continue;
+            }
+            if (inst.kind == ir::Inst::kLoad) {
+                replace_map[inst.GetResultPtr().get()] = std::move(value);
+            }
+            iter = inst_list.erase(iter);
+            ++count;
+        }
+    }
+    if (!replace_map.empty()) {
+        for (const auto &bb : graph.block_list) {
+            for (const auto &inst : bb->GetInstList()) {
+                for (const auto &use : inst->GetUseList()) {
+                    auto to = forward.Resolve(use);
+                    if (to != use) inst->ReplaceUse(use, to);
+                }
+            }
+        }
+    }
+    for (const auto &bb : graph.block_list) {
+        count += RemoveDeadStores(alias_analysis, *bb);
+    }
+
+    if (count > 0) func.Renumber();
+    return count;
+}
+
+}  // namespace opt
@@ -0,0 +1,122 @@
+#include "opt/loop_interchange.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <iterator>
+#include <memory>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "ir/ir.h"
+#include "ir/type.h"
+#include "ir/value.h"
+#include "opt/alias_analysis.h"
+#include "opt/cfg.h"
+#include "opt/dependence.h"
+
+namespace opt {
+
+namespace {
+
+std::int64_t GetCost(const std::vector<std::int64_t> &stride_list) {
+    std::int64_t cost = 0;
+    for (auto stride : stride_list) {
+        cost += std::min(std::abs(stride), kLineWords);
+    }
+    return cost;
+}
+
+ir::PhiInst::PhiValue &GetInit(const Graph &graph, const CountedLoop &loop) {
+    const auto label = graph.block_list[loop.preheader]->GetLabel().Str();
+    auto &value_list = loop.phi->GetValueList();
+    return *std::find_if(value_list.begin(), value_list.end(),
+                         [&label](const ir::PhiInst::PhiValue &value) {
+                             return value.label->Str() == label;
+                         });
+}
+
+// the condition of loop with the bound and comparison of other
+std::shared_ptr<ir::IcmpInst> SwapCond(const CountedLoop &loop,
+                                       const CountedLoop &other) {
+    return std::make_shared<ir::IcmpInst>(
+        other.cond->op_code,
+        std::static_pointer_cast<ir::Var>(loop.cond->GetResultPtr()),
+        loop.cond->GetUseList()[0], other.cond->GetUseList()[1]);
+}
+
+void Interchange(const Graph &graph, const PerfectNest &nest) {
+    std::swap(GetInit(graph, nest.outer).value,
+              GetInit(graph, nest.inner).value);
+    auto outer_cond = SwapCond(nest.outer, nest.inner);
+    auto inner_cond = SwapCond(nest.inner, nest.outer);
+    *std::next(graph.block_list[nest.outer.header]->GetInstList().begin())
+        = std::move(outer_cond);
+    *std::next(graph.block_list[nest.inner.header]->GetInstList().begin())
+        = std::move(inner_cond);
+
+    // the body sees the induction variables the other way round
+    const auto outer_iv = nest.outer.phi->GetResultPtr();
+    const auto inner_iv = nest.inner.phi->GetResultPtr();
+    const std::shared_ptr<ir::Value> placeholder
+        = std::make_shared<ir::LocalVar>(ir::IntType::Get(ir::IntType::kI32),
+                                         "interchange");
+    std::vector<ir::Inst *> body;
+    for (int b : nest.block_list) {
+        if (b == nest.outer.header || b == nest.outer.latch
+            || b == nest.inner.header) {
+            continue;
+        }
+        for (const auto &inst : graph.block_list[b]->GetInstList()) {
+            if (inst.get() != nest.inner.next) body.push_back(inst.get());
+        }
+    }
+    auto replace = [&body](const std::shared_ptr<ir::Value> &from,
+                           const std::shared_ptr<ir::Value> &to) {
+        for (auto *inst : body) {
+            for (const auto &use : inst->GetUseList()) {
+                if (use->Str() == from->Str()) inst->ReplaceUse(use, to);
+            }
+        }
+    };
+    replace(outer_iv, placeholder);
+    replace(inner_iv, outer_iv);
+    for (auto *inst : body) inst->ReplaceUse(placeholder, inner_iv);
+}
+
+}  // namespace
+
+int LoopInterchange::Run(ir::FuncDef &func) {
+    Graph graph(func);
+    if (graph.block_list.empty()) return 0;
+    const auto idom = Dominator(graph);
+    const AliasAnalysis alias_analysis(func);
+    int count = 0;
+    // a nest sharing blocks with one interchanged is left for the next run
+    std::unordered_set<int> changed;
+    for (const auto &nest : FindPerfectNests(graph, idom)) {
+        if (std::any_of(nest.block_list.begin(), nest.block_list.end(),
+                        [&changed](const int b) {
+                            return changed.count(b) != 0;
+                        })) {
+            continue;
+        }
+        const DependenceAnalysis dependence(
+            graph, nest.block_list,
+            {nest.outer.phi->GetResult().Str(),
+             nest.inner.phi->GetResult().Str()},
+            alias_analysis);
+        if (GetCost(dependence.GetStrideList(0))
+                >= GetCost(dependence.GetStrideList(1))
+            || !dependence.CanInterchange(0)) {
+            continue;
+        }
+        Interchange(graph, nest);
+        changed.insert(nest.block_list.begin(), nest.block_list.end());
+        ++count;
+    }
+    return count;
+}
+
+}  // namespace opt
@@ -0,0 +1,226 @@
+#include "opt/loop_tiling.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "ir/ir.h"
+#include "ir/type.h"
+#include "ir/value.h"
+#include "opt/alias_analysis.h"
+#include "opt/cfg.h"
+#include "opt/dependence.h"
+
+namespace opt {
+
+namespace {
+
+using BlockPtr = std::shared_ptr<ir::BasicBlock>;
+using ValuePtr = std::shared_ptr<ir::Value>;
+
+// the iterations of each loop in a tile
+constexpr int kTileSize = 32;
+
+ir::PhiInst::PhiValue &GetInit(const Graph &graph, const CountedLoop &loop) {
+    const auto label = graph.block_list[loop.preheader]->GetLabel().Str();
+    auto &value_list = loop.phi->GetValueList();
+    return *std::find_if(value_list.begin(), value_list.end(),
+                         [&label](const ir::PhiInst::PhiValue &value) {
+                             return value.label->Str() == label;
+                         });
+}
+
+// if loop counts up from a constant of 0 or more while less than its bound,
+// and the bound is no constant at most a tile away
+bool IsTileable(const Graph &graph, const CountedLoop &loop) {
+    const auto &init = *GetInit(graph, loop).value;
+    if (loop.cond->op_code != ir::IcmpInst::kSLT
+        || init.kind != ir::Value::kImm) {
+        return false;
+    }
+    const std::int64_t begin = init.Cast<ir::Imm>().GetValue();
+    const auto &bound = loop.cond->GetRHS();
+    return begin >= 0
+           && (bound.kind != ir::Value::kImm
+               || bound.Cast<ir::Imm>().GetValue() - begin > kTileSize);
+}
+
+// if a load or store leaves the lines of the cache it touches on each
+// iteration of the inner loop, but comes back to them on the next of the
+// outer one
+bool HasReuse(const DependenceAnalysis &dependence) {
+    const auto outer_list = dependence.GetStrideList(0);
+    const auto inner_list = dependence.GetStrideList(1);
+    for (int i = 0; i < outer_list.size(); ++i) {
+        if (std::abs(inner_list[i]) >= kLineWords
+            && std::abs(outer_list[i]) < kLineWords) {
+            return true;
+        }
+    }
+    return false;
+}
+
+class Tiler {
+  public:
+    Tiler(ir::FuncDef &func, const Graph &graph, int &next_id)
+        : func(func), graph(graph), next_id(next_id) {}
+
+    void Tile(const PerfectNest &nest) {
+        const auto &header = graph.block_list[nest.outer.header];
+        const auto &preheader = graph.block_list[nest.outer.preheader];
+        const auto &exit = graph.block_list[nest.outer.exit];
+        auto outer_header = NewBlock(header);
+        auto outer_body = NewBlock(header);
+        auto inner_header = NewBlock(header);
+        auto inner_body = NewBlock(header);
+
+        // for (ii = init; ii < bound; ii = ii_end)
+        auto &outer_init = GetInit(graph, nest.outer);
+        auto outer_bound = nest.outer.cond->GetUseList()[1];
+        auto ii = NewVar();
+        auto ii_end = NewVar();
+        Loop(outer_header, ii, outer_init.value, preheader, ii_end,
+             inner_header, outer_bound, outer_body, exit);
+        End(outer_body, ii_end, ii, outer_bound, inner_header);
+        // for (jj = init; jj < bound; jj = jj_end)
+        auto &inner_init = GetInit(graph, nest.inner);
+        auto inner_bound = nest.inner.cond->GetUseList()[1];
+        auto jj = NewVar();
+        auto jj_end = NewVar();
+        Loop(inner_header, jj, inner_init.value, outer_body, jj_end, header,
+             inner_bound, inner_body, outer_header);
+        End(inner_body, jj_end, jj, inner_bound, header);
+
+        // the nest runs over the tile, and is left for the next one
+        outer_init = {ii, inner_body->GetLabelPtr()};
+        nest.outer.cond->SetRHS(ii_end);
+        inner_init.value = jj;
+        nest.inner.cond->SetRHS(jj_end);
+        GetBr(*header)->SetFalse(inner_header->GetLabelPtr());
+        const auto label = header->GetLabel().Str();
+        auto *br = GetBr(*preheader);
+        if (br->GetTrue().Str() == label) {
+            br->SetTrue(outer_header->GetLabelPtr());
+        }
+        if (!br->HasDest() && br->GetFalse().Str() == label) {
+            br->SetFalse(outer_header->GetLabelPtr());
+        }
+        for (const auto &inst : exit->GetInstList()) {
+            if (inst->kind != ir::Inst::kPhi) break;
+            for (auto &value : inst->Cast<ir::PhiInst>().GetValueList()) {
+                if (value.label->Str() == label) {
+                    value.label = outer_header->GetLabelPtr();
+                }
+            }
+        }
+    }
+
+  private:
+    ir::FuncDef &func;
+    const Graph &graph;
+    int &next_id;
+
+    std::shared_ptr<ir::TmpVar> NewVar() {
+        return std::make_shared<ir::TmpVar>(next_id++);
+    }
+
+    // a new block before next
+    BlockPtr NewBlock(const BlockPtr &next) {
+        auto bb = std::make_shared<ir::BasicBlock>(
+            std::make_shared<ir::TmpVar>(ir::LabelType::Get(), next_id++));
+        auto &block_list = func.GetBlockList();
+        block_list.insert(std::find(block_list.begin(), block_list.end(), next),
+                          bb);
+        return bb;
+    }
+
+    // header: %iv = phi [init, from], [next, latch]
+    //         br %iv < bound, body, exit
+    void Loop(const BlockPtr &header,
+              const std::shared_ptr<ir::TmpVar> &iv,
+              const ValuePtr &init,
+              const BlockPtr &from,
+              const ValuePtr &next,
+              const BlockPtr &latch,
+              const ValuePtr &bound,
+              const BlockPtr &body,
+              const BlockPtr &exit) {
+        header->AddInst(std::make_shared<ir::PhiInst>(
+            iv, std::vector<ir::PhiInst::PhiValue>{
+                    {init, from->GetLabelPtr()},
+                    {next, latch->GetLabelPtr()}}));
+        auto cond = std::make_shared<ir::TmpVar>(
+            ir::IntType::Get(ir::IntType::kI1), next_id++);
+        header->AddInst(std::make_shared<ir::IcmpInst>(ir::IcmpInst::kSLT,
+                                                       cond, iv, bound));
+        header->AddInst(std::make_shared<ir::BrInst>(
+            cond, body->GetLabelPtr(), exit->GetLabelPtr()));
+    }
+
+    // bb: %end = %iv + min(bound - %iv, kTileSize)
+    //     br next
+    void End(const BlockPtr &bb,
+             const std::shared_ptr<ir::TmpVar> &end,
+             const std::shared_ptr<ir::TmpVar> &iv,
+             const ValuePtr &bound,
+             const BlockPtr &next) {
+        auto rest = NewVar();
+        bb->AddInst(std::make_shared<ir::BinaryOpInst>(ir::BinaryOpInst::kSub,
+                                                       rest, bound, iv));
+        auto size = std::make_shared<ir::Imm>(kTileSize);
+        auto less = std::make_shared<ir::TmpVar>(
+            ir::IntType::Get(ir::IntType::kI1), next_id++);
+        bb->AddInst(std::make_shared<ir::IcmpInst>(ir::IcmpInst::kSLT, less,
+                                                   rest, size));
+        auto step = NewVar();
+        bb->AddInst(std::make_shared<ir::SelectInst>(step, less, rest, size));
+        bb->AddInst(std::make_shared<ir::BinaryOpInst>(ir::BinaryOpInst::kAdd,
+                                                       end, iv, step));
+        bb->AddInst(std::make_shared<ir::BrInst>(next->GetLabelPtr()));
+    }
+};
+
+}  // namespace
+
+int LoopTiling::Run(ir::FuncDef &func) {
+    int next_id = func.Renumber();
+    Graph graph(func);
+    if (graph.block_list.empty()) return 0;
+    const auto idom = Dominator(graph);
+    const AliasAnalysis alias_analysis(func);
+    Tiler tiler(func, graph, next_id);
+    int count = 0;
+    // a nest sharing blocks with one tiled, or entered or left through
+    // them, is left for the next run
+    std::unordered_set<int> changed;
+    for (const auto &nest : FindPerfectNests(graph, idom)) {
+        auto touched = nest.block_list;
+        touched.push_back(nest.outer.preheader);
+        touched.push_back(nest.outer.exit);
+        if (std::any_of(touched.begin(), touched.end(),
+                        [&changed](const int b) {
+                            return changed.count(b) != 0;
+                        })
+            || !IsTileable(graph, nest.outer)
+            || !IsTileable(graph, nest.inner)) {
+            continue;
+        }
+        const DependenceAnalysis dependence(
+            graph, nest.block_list,
+            {nest.outer.phi->GetResult().Str(),
+             nest.inner.phi->GetResult().Str()},
+            alias_analysis);
+        if (!HasReuse(dependence) || !dependence.CanTile(0)) continue;
+        tiler.Tile(nest);
+        changed.insert(touched.begin(), touched.end());
+        ++count;
+    }
+    if (count > 0) func.Renumber();
+    return count;
+}
+
+}  // namespace opt
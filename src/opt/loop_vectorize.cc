@@ -0,0 +1,762 @@
+#include "opt/loop_vectorize.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "ir/ir.h"
+#include "ir/type.h"
+#include "ir/value.h"
+#include "opt/alias_analysis.h"
+#include "opt/cfg.h"
+
+namespace opt {
+
+namespace {
+
+using BlockPtr = std::shared_ptr<ir::BasicBlock>;
+using ValuePtr = std::shared_ptr<ir::Value>;
+using DefMap = std::unordered_map<std::string, const ir::Inst *>;
+
+// the q registers the backend hands out, q8-q15 and q0-q3
+constexpr int kMaxVector = 12;
+// pairs of pointers compared before a loop at most
+constexpr int kMaxCheck = 8;
+
+// %s = phi [init, preheader], [%s + x or %s - x, body]
+struct Reduction {
+    const ir::PhiInst *phi;
+    ValuePtr init;
+    ValuePtr x;
+    bool is_sub;
+};
+
+// a loop of a header and a body, see LoopVectorize
+struct SimpleLoop {
+    int header;
+    int preheader;
+    int body;
+    const ir::PhiInst *iv;
+    ValuePtr init;
+    ValuePtr bound;
+    std::vector<Reduction> reduction_list;
+};
+
+// a load or store of the body
+struct Access {
+    const ir::Inst *inst;
+    ValuePtr ptr;
+    Location location;
+    bool is_store;
+};
+
+bool IsImm(const ir::Value &value, const std::int32_t imm) {
+    return value.kind == ir::Value::kImm
+           && value.Cast<ir::Imm>().GetValue() == imm;
+}
+
+bool IsVector(const ir::Value &value) {
+    return value.GetType().kind == ir::Type::kVector;
+}
+
+// the value phi takes on the edge from bb
+const ir::PhiInst::PhiValue *ValueFrom(const ir::PhiInst &phi,
+                                       const ir::BasicBlock &bb) {
+    for (const auto &value : phi.GetValueList()) {
+        if (value.label->Str() == bb.GetLabel().Str()) return &value;
+    }
+    return nullptr;
+}
+
+// if bb has code on vectors, a loop already vectorized
+bool HasVectorCode(const ir::BasicBlock &bb) {
+    for (const auto &inst : bb.GetInstList()) {
+        for (const auto &use : inst->GetUseList()) {
+            if (IsVector(*use)) return true;
+        }
+        const auto result = inst->GetResultPtr();
+        if (result != nullptr && IsVector(*result)) return true;
+    }
+    return false;
+}
+
+// match loop as a header and a body that is its latch, def_map is what
+// the body defines
+bool MatchLoop(const Graph &graph,
+               const Loop &loop,
+               const DefMap &def_map,
+               SimpleLoop &simple) {
+    if (loop.block_list.size() != 2) return false;
+    simple.header = loop.header;
+    simple.body = loop.block_list[1];
+    const auto &pred_list = graph.pred_list[simple.header];
+    if (pred_list.size() != 2 || pred_list[0] == pred_list[1]) return false;
+    simple.preheader = pred_list[0] == simple.body ? pred_list[1]
+                                                   : pred_list[0];
+    const auto &header = *graph.block_list[simple.header];
+    const auto &body = *graph.block_list[simple.body];
+    const auto &preheader = *graph.block_list[simple.preheader];
+
+    const auto &inst_list = header.GetInstList();
+    auto iter = inst_list.begin();
+    std::vector<const ir::PhiInst *> phi_list;
+    std::unordered_set<std::string> header_set;
+    for (; iter != inst_list.end() && (*iter)->kind == ir::Inst::kPhi;
+         ++iter) {
+        phi_list.push_back(&(*iter)->Cast<ir::PhiInst>());
+        header_set.insert((*iter)->GetResultPtr()->Str());
+    }
+    if (std::distance(iter, inst_list.end()) != 2
+        || (*iter)->kind != ir::Inst::kIcmp
+        || (*std::next(iter))->kind != ir::Inst::kBr) {
+        return false;
+    }
+    const auto &cond = (*iter)->Cast<ir::IcmpInst>();
+    const auto &br = (*std::next(iter))->Cast<ir::BrInst>();
+    header_set.insert(cond.GetResult().Str());
+    simple.bound = cond.GetUseList()[1];
+    if (cond.op_code != ir::IcmpInst::kSLT || br.HasDest()
+        || br.GetCond().Str() != cond.GetResult().Str()
+        || br.GetTrue().Str() != body.GetLabel().Str()
+        || def_map.count(simple.bound->Str()) != 0
+        || header_set.count(simple.bound->Str()) != 0) {
+        return false;
+    }
+
+    // what reads each value defined in the header
+    std::unordered_map<std::string, std::vector<const ir::Inst *>> user_map;
+    for (const auto &inst : body.GetInstList()) {
+        for (const auto &use : inst->GetUseList()) {
+            if (header_set.count(use->Str()) != 0) {
+                user_map[use->Str()].push_back(inst.get());
+            }
+        }
+    }
+    simple.iv = nullptr;
+    simple.reduction_list.clear();
+    for (const auto *phi : phi_list) {
+        const auto *from_pre = ValueFrom(*phi, preheader);
+        const auto *from_body = ValueFrom(*phi, body);
+        const auto def = from_body == nullptr
+                             ? def_map.end()
+                             : def_map.find(from_body->value->Str());
+        if (phi->GetValueNum() != 2 || from_pre == nullptr
+            || def == def_map.end()
+            || def->second->kind != ir::Inst::kBinaryOp
+            || IsVector(phi->GetResult())) {
+            return false;
+        }
+        const auto &next = def->second->Cast<ir::BinaryOpInst>();
+        const auto name = phi->GetResult().Str();
+        const auto lhs = next.GetUseList()[0];
+        const auto rhs = next.GetUseList()[1];
+        if (name == cond.GetLHS().Str()) {
+            if (next.op_code != ir::BinaryOpInst::kAdd
+                || !((lhs->Str() == name && IsImm(*rhs, 1))
+                     || (IsImm(*lhs, 1) && rhs->Str() == name))) {
+                return false;
+            }
+            simple.iv = phi;
+            simple.init = from_pre->value;
+            continue;
+        }
+        // %s feeds %s + x alone, and %s + x only the phi
+        const auto &user_list = user_map[name];
+        if (user_list.size() != 1 || user_list[0] != &next
+            || user_map.count(next.GetResult().Str()) != 0) {
+            return false;
+        }
+        for (const auto &inst : body.GetInstList()) {
+            for (const auto &use : inst->GetUseList()) {
+                if (use->Str() == next.GetResult().Str()) return false;
+            }
+        }
+        Reduction reduction{phi, from_pre->value, nullptr, false};
+        if (next.op_code == ir::BinaryOpInst::kAdd && lhs->Str() == name) {
+            reduction.x = rhs;
+        } else if (next.op_code == ir::BinaryOpInst::kAdd
+                   && rhs->Str() == name) {
+            reduction.x = lhs;
+        } else if (next.op_code == ir::BinaryOpInst::kSub
+                   && lhs->Str() == name && rhs->Str() != name) {
+            reduction.x = rhs;
+            reduction.is_sub = true;
+        } else {
+            return false;
+        }
+        simple.reduction_list.push_back(reduction);
+    }
+    if (simple.iv == nullptr
+        || user_map.count(cond.GetResult().Str()) != 0) {
+        return false;
+    }
+    // a constant trip count of less than two vectors is not worth it
+    if (simple.init->kind == ir::Value::kImm
+        && simple.bound->kind == ir::Value::kImm) {
+        const std::int64_t trip
+            = static_cast<std::int64_t>(
+                  simple.bound->Cast<ir::Imm>().GetValue())
+              - simple.init->Cast<ir::Imm>().GetValue();
+        return trip >= 8;
+    }
+    return true;
+}
+
+class Vectorizer {
+  public:
+    Vectorizer(ir::FuncDef &func,
+               const Graph &graph,
+               const SimpleLoop &loop,
+               const DefMap &def_map,
+               const AliasAnalysis &alias_analysis,
+               int &next_id)
+        : func(func),
+          graph(graph),
+          loop(loop),
+          def_map(def_map),
+          alias_analysis(alias_analysis),
+          next_id(next_id),
+          iv_name(loop.iv->GetResult().Str()) {}
+
+    // false if the loop cannot be vectorized, func is then left as it was
+    bool Run() {
+        const auto &body = *graph.block_list[loop.body];
+        for (const auto &inst : graph.block_list[loop.header]->GetInstList()) {
+            if (auto result = inst->GetResultPtr()) {
+                header_set.insert(result->Str());
+            }
+        }
+        if (!CollectAccess(body) || !CheckDependence()) return false;
+        if (access_list.empty() && loop.reduction_list.empty()) return false;
+
+        pre = NewBlock();
+        vheader = NewBlock();
+        vbody = NewBlock();
+        vexit = NewBlock();
+        pre_env.bb = pre;
+        pre_env.iv = loop.init;
+        body_env.bb = vbody;
+        body_env.iv = vi = NewVar();
+
+        // the loads and stores in their order, what they compute as needed
+        for (const auto &access : access_list) {
+            auto ptr = Scalar(access.ptr, body_env);
+            if (ptr == nullptr) return false;
+            auto vector_ptr = std::make_shared<ir::TmpVar>(
+                std::make_shared<ir::PtrType>(ir::VectorType::Get()),
+                next_id++);
+            vbody->AddInst(std::make_shared<ir::BitcastInst>(
+                vector_ptr, std::static_pointer_cast<ir::Var>(ptr)));
+            if (access.is_store) {
+                auto value = Vector(access.inst->GetUseList()[0]);
+                if (value == nullptr) return false;
+                vbody->AddInst(
+                    std::make_shared<ir::StoreInst>(value, vector_ptr));
+            } else {
+                auto result = NewVector();
+                vbody->AddInst(
+                    std::make_shared<ir::LoadInst>(result, vector_ptr));
+                vector_map[access.inst->GetResultPtr()->Str()] = result;
+            }
+        }
+        std::vector<std::shared_ptr<ir::TmpVar>> sum_list;
+        std::vector<std::shared_ptr<ir::TmpVar>> sum_next_list;
+        for (const auto &reduction : loop.reduction_list) {
+            auto x = Vector(reduction.x);
+            if (x == nullptr) return false;
+            sum_list.push_back(NewVector());
+            sum_next_list.push_back(NewVector());
+            vbody->AddInst(std::make_shared<ir::BinaryOpInst>(
+                reduction.is_sub ? ir::BinaryOpInst::kSub
+                                 : ir::BinaryOpInst::kAdd,
+                sum_next_list.back(), sum_list.back(), x));
+        }
+        auto vi_next = NewVar();
+        vbody->AddInst(std::make_shared<ir::BinaryOpInst>(
+            ir::BinaryOpInst::kAdd, vi_next, vi, Imm(kLaneNum)));
+        if (iv_vector != nullptr) {
+            vbody->AddInst(std::make_shared<ir::BinaryOpInst>(
+                ir::BinaryOpInst::kAdd, iv_vector_next, iv_vector,
+                Vector(Imm(kLaneNum))));
+        }
+        vbody->AddInst(std::make_shared<ir::BrInst>(vheader->GetLabelPtr()));
+        auto zero = Vector(Imm(0));
+        if (!Fits(sum_next_list)) return false;
+
+        auto bound = Bound();
+        if (bound == nullptr) return false;
+        pre->AddInst(std::make_shared<ir::BrInst>(vheader->GetLabelPtr()));
+
+        // vheader: %vi = phi [init, vpre], [%vi + 4, vbody], the sums and
+        // the vector of %iv
+        auto pre_label = pre->GetLabelPtr();
+        auto body_label = vbody->GetLabelPtr();
+        vheader->AddInst(std::make_shared<ir::PhiInst>(
+            vi, std::vector<ir::PhiInst::PhiValue>{{loop.init, pre_label},
+                                                   {vi_next, body_label}}));
+        for (int i = 0; i < sum_list.size(); ++i) {
+            vheader->AddInst(std::make_shared<ir::PhiInst>(
+                sum_list[i],
+                std::vector<ir::PhiInst::PhiValue>{
+                    {zero, pre_label}, {sum_next_list[i], body_label}}));
+        }
+        if (iv_vector != nullptr) {
+            vheader->AddInst(std::make_shared<ir::PhiInst>(
+                iv_vector,
+                std::vector<ir::PhiInst::PhiValue>{
+                    {iv_vector_init, pre_label},
+                    {iv_vector_next, body_label}}));
+        }
+        auto cond = std::make_shared<ir::TmpVar>(
+            ir::IntType::Get(ir::IntType::kI1), next_id++);
+        vheader->AddInst(std::make_shared<ir::IcmpInst>(ir::IcmpInst::kSLT,
+                                                        cond, vi, bound));
+        vheader->AddInst(std::make_shared<ir::BrInst>(
+            cond, vbody->GetLabelPtr(), vexit->GetLabelPtr()));
+
+        // vexit: each sum is s0 plus its lanes
+        std::vector<ValuePtr> result_list;
+        for (int i = 0; i < sum_list.size(); ++i) {
+            ValuePtr sum = loop.reduction_list[i].init;
+            for (int lane = 0; lane < kLaneNum; ++lane) {
+                auto element = NewVar();
+                vexit->AddInst(std::make_shared<ir::ExtractElementInst>(
+                    element, sum_list[i], lane));
+                auto next = NewVar();
+                vexit->AddInst(std::make_shared<ir::BinaryOpInst>(
+                    ir::BinaryOpInst::kAdd, next, sum, element));
+                sum = next;
+            }
+            result_list.push_back(sum);
+        }
+        const auto &header = graph.block_list[loop.header];
+        vexit->AddInst(std::make_shared<ir::BrInst>(header->GetLabelPtr()));
+
+        Attach(result_list);
+        return true;
+    }
+
+  private:
+    // the values cloned into a block, with %iv as iv
+    struct Env {
+        BlockPtr bb;
+        ValuePtr iv;
+        std::unordered_map<std::string, ValuePtr> memo;
+    };
+
+    static constexpr int kLaneNum = 4;
+
+    ir::FuncDef &func;
+    const Graph &graph;
+    const SimpleLoop &loop;
+    const DefMap &def_map;
+    const AliasAnalysis &alias_analysis;
+    int &next_id;
+    const std::string iv_name;
+    std::unordered_set<std::string> header_set;
+
+    std::vector<Access> access_list;
+    // pairs of pointers that may touch the same words, by %iv = init
+    std::vector<std::pair<ValuePtr, ValuePtr>> check_list;
+
+    BlockPtr pre;
+    BlockPtr vheader;
+    BlockPtr vbody;
+    BlockPtr vexit;
+    Env pre_env;
+    Env body_env;
+    std::shared_ptr<ir::TmpVar> vi;
+    // the values of the body and the invariants as vectors, by name
+    std::unordered_map<std::string, ValuePtr> vector_map;
+    int splat_count = 0;
+    // <%vi, %vi + 1, %vi + 2, %vi + 3>, if the body uses %iv as data
+    std::shared_ptr<ir::TmpVar> iv_vector;
+    std::shared_ptr<ir::TmpVar> iv_vector_init;
+    std::shared_ptr<ir::TmpVar> iv_vector_next;
+
+    std::shared_ptr<ir::TmpVar> NewVar() {
+        return std::make_shared<ir::TmpVar>(next_id++);
+    }
+
+    std::shared_ptr<ir::TmpVar> NewVector() {
+        return std::make_shared<ir::TmpVar>(ir::VectorType::Get(), next_id++);
+    }
+
+    static std::shared_ptr<ir::Imm> Imm(const int value) {
+        return std::make_shared<ir::Imm>(value);
+    }
+
+    BlockPtr NewBlock() {
+        return std::make_shared<ir::BasicBlock>(
+            std::make_shared<ir::TmpVar>(ir::LabelType::Get(), next_id++));
+    }
+
+    // each load and store moves by a word as %iv steps, by no more than
+    // values defined out of the loop otherwise
+    bool CollectAccess(const ir::BasicBlock &body) {
+        for (const auto &inst : body.GetInstList()) {
+            switch (inst->kind) {
+                case ir::Inst::kLoad: {
+                    const auto &load = inst->Cast<ir::LoadInst>();
+                    if (load.GetResult().GetType().kind != ir::Type::kInt) {
+                        return false;
+                    }
+                    access_list.push_back(
+                        {inst.get(), inst->GetUseList()[0], {}, false});
+                    break;
+                }
+                case ir::Inst::kStore:
+                    if (inst->GetUseList()[0]->GetType().kind
+                        != ir::Type::kInt) {
+                        return false;
+                    }
+                    access_list.push_back(
+                        {inst.get(), inst->GetUseList()[1], {}, true});
+                    break;
+                case ir::Inst::kBinaryOp:
+                case ir::Inst::kGetelementptr:
+                case ir::Inst::kBr:
+                    break;
+                default:
+                    return false;
+            }
+        }
+        for (auto &access : access_list) {
+            access.location = alias_analysis.GetLocation(*access.ptr);
+            const auto &term_map = access.location.term_map;
+            const auto iv = term_map.find(iv_name);
+            if (access.location.kind == Location::kUnknown
+                || iv == term_map.end() || iv->second != 1) {
+                return false;
+            }
+            for (const auto &term : term_map) {
+                if (term.first != iv_name
+                    && (def_map.count(term.first) != 0
+                        || header_set.count(term.first) != 0)) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    // Of two accesses a before b in the body, at least one a store, b must
+    // not touch on a later lane what a touches on an earlier one: the
+    // vector of a goes first as a whole.
+    bool CheckDependence() {
+        for (int i = 0; i < access_list.size(); ++i) {
+            for (int j = i + 1; j < access_list.size(); ++j) {
+                const auto &a = access_list[i];
+                const auto &b = access_list[j];
+                if ((!a.is_store && !b.is_store)
+                    || !alias_analysis.MayShareObject(*a.ptr, *b.ptr)) {
+                    continue;
+                }
+                if (a.location.kind == b.location.kind
+                    && a.location.object == b.location.object
+                    && a.location.term_map == b.location.term_map) {
+                    const auto diff = b.location.offset - a.location.offset;
+                    if (diff > 0 && diff < kLaneNum) return false;
+                    continue;
+                }
+                check_list.emplace_back(a.ptr, b.ptr);
+                if (check_list.size() > kMaxCheck) return false;
+            }
+        }
+        return true;
+    }
+
+    // value with %iv as env.iv, the computation cloned into env.bb
+    ValuePtr Scalar(const ValuePtr &value, Env &env) {
+        const auto name = value->Str();
+        if (name == iv_name) return env.iv;
+        const auto def = def_map.find(name);
+        if (def == def_map.end()) {
+            return header_set.count(name) != 0 ? nullptr : value;
+        }
+        const auto memo = env.memo.find(name);
+        if (memo != env.memo.end()) return memo->second;
+
+        std::vector<ValuePtr> operand_list;
+        for (const auto &use : def->second->GetUseList()) {
+            operand_list.push_back(Scalar(use, env));
+            if (operand_list.back() == nullptr) return nullptr;
+        }
+        std::shared_ptr<ir::TmpVar> result;
+        switch (def->second->kind) {
+            case ir::Inst::kBinaryOp:
+                result = NewVar();
+                env.bb->AddInst(std::make_shared<ir::BinaryOpInst>(
+                    def->second->Cast<ir::BinaryOpInst>().op_code, result,
+                    operand_list[0], operand_list[1]));
+                break;
+            case ir::Inst::kGetelementptr:
+                result = std::make_shared<ir::TmpVar>(
+                    def->second->GetResultPtr()->GetTypePtr(), next_id++);
+                env.bb->AddInst(std::make_shared<ir::GetelementptrInst>(
+                    result,
+                    std::static_pointer_cast<ir::Var>(operand_list[0]),
+                    std::vector<ValuePtr>(std::next(operand_list.begin()),
+                                          operand_list.end())));
+                break;
+            default:
+                return nullptr;
+        }
+        env.memo[name] = result;
+        return result;
+    }
+
+    // value on the four lanes, nullptr if it cannot be
+    ValuePtr Vector(const ValuePtr &value) {
+        const auto name = value->Str();
+        const auto memo = vector_map.find(name);
+        if (memo != vector_map.end()) return memo->second;
+        ValuePtr result;
+        const auto def = def_map.find(name);
+        if (name == iv_name) {
+            result = IvVector();
+        } else if (def == def_map.end()) {
+            if (header_set.count(name) != 0) return nullptr;
+            result = Splat(value);
+        } else if (def->second->kind == ir::Inst::kBinaryOp) {
+            result = VectorOp(def->second->Cast<ir::BinaryOpInst>());
+        }
+        if (result != nullptr) vector_map[name] = result;
+        return result;
+    }
+
+    // add, sub and mul, a shl by a constant as a mul
+    ValuePtr VectorOp(const ir::BinaryOpInst &inst) {
+        auto op_code = inst.op_code;
+        auto rhs = inst.GetUseList()[1];
+        if (op_code == ir::BinaryOpInst::kShl) {
+            if (rhs->kind != ir::Value::kImm
+                || rhs->Cast<ir::Imm>().GetValue() < 0
+                || rhs->Cast<ir::Imm>().GetValue() > 30) {
+                return nullptr;
+            }
+            op_code = ir::BinaryOpInst::kMul;
+            rhs = Imm(1 << rhs->Cast<ir::Imm>().GetValue());
+        } else if (op_code != ir::BinaryOpInst::kAdd
+                   && op_code != ir::BinaryOpInst::kSub
+                   && op_code != ir::BinaryOpInst::kMul) {
+            return nullptr;
+        }
+        auto lhs_vector = Vector(inst.GetUseList()[0]);
+        auto rhs_vector = Vector(rhs);
+        if (lhs_vector == nullptr || rhs_vector == nullptr) return nullptr;
+        auto result = NewVector();
+        vbody->AddInst(std::make_shared<ir::BinaryOpInst>(
+            op_code, result, lhs_vector, rhs_vector));
+        return result;
+    }
+
+    // value on every lane, made in vpre
+    ValuePtr Splat(const ValuePtr &value) {
+        ++splat_count;
+        std::shared_ptr<ir::TmpVar> vector;
+        for (int lane = 0; lane < kLaneNum; ++lane) {
+            auto next = NewVector();
+            pre->AddInst(std::make_shared<ir::InsertElementInst>(
+                next, vector, value, lane));
+            vector = next;
+        }
+        return vector;
+    }
+
+    ValuePtr IvVector() {
+        iv_vector = NewVector();
+        iv_vector_next = NewVector();
+        std::shared_ptr<ir::TmpVar> vector;
+        for (int lane = 0; lane < kLaneNum; ++lane) {
+            ValuePtr element = loop.init;
+            if (lane > 0) {
+                element = NewVar();
+                pre->AddInst(std::make_shared<ir::BinaryOpInst>(
+                    ir::BinaryOpInst::kAdd,
+                    std::static_pointer_cast<ir::Var>(element), loop.init,
+                    Imm(lane)));
+            }
+            auto next = NewVector();
+            pre->AddInst(std::make_shared<ir::InsertElementInst>(
+                next, vector, element, lane));
+            vector = next;
+        }
+        iv_vector_init = vector;
+        return iv_vector;
+    }
+
+    // if the splats, the phis and the vectors live at once in vbody, with
+    // the ones live out of it, fit in the q registers
+    bool Fits(const std::vector<std::shared_ptr<ir::TmpVar>> &live_out) const {
+        std::unordered_set<std::string> live;
+        for (const auto &value : live_out) live.insert(value->Str());
+        if (iv_vector != nullptr) live.insert(iv_vector_next->Str());
+        const int phi_num = static_cast<int>(live.size());
+        int max_live = phi_num;
+        const auto &inst_list = vbody->GetInstList();
+        for (auto iter = inst_list.rbegin(); iter != inst_list.rend();
+             ++iter) {
+            if (auto result = (*iter)->GetResultPtr()) {
+                live.erase(result->Str());
+            }
+            for (const auto &use : (*iter)->GetUseList()) {
+                if (IsVector(*use)) live.insert(use->Str());
+            }
+            max_live = std::max(max_live, static_cast<int>(live.size()));
+        }
+        return splat_count + phi_num + max_live <= kMaxVector;
+    }
+
+    // the bound of %vi in vpre: bound - 3, or init where bound is within 3
+    // of INT_MIN so that wraps, or where a pair of pointers is too close for
+    // the loop to run by vectors
+    ValuePtr Bound() {
+        auto bound = NewVar();
+        pre->AddInst(std::make_shared<ir::BinaryOpInst>(
+            ir::BinaryOpInst::kSub, bound, loop.bound, Imm(kLaneNum - 1)));
+        ValuePtr result = Select(
+            Compare(ir::IcmpInst::kSGE, loop.bound,
+                    Imm(std::numeric_limits<int>::min() + (kLaneNum - 1))),
+            bound, loop.init);
+        // b is read or written after a, at or before a, or four words on;
+        // pointers are addresses, so they are compared unsigned
+        for (const auto &[a, b] : check_list) {
+            auto a_ptr = Scalar(a, pre_env);
+            auto b_ptr = Scalar(b, pre_env);
+            if (a_ptr == nullptr || b_ptr == nullptr) return nullptr;
+            auto a_end = std::make_shared<ir::TmpVar>(ir::PtrType::Get(),
+                                                      next_id++);
+            pre->AddInst(std::make_shared<ir::GetelementptrInst>(
+                a_end, std::static_pointer_cast<ir::Var>(a_ptr),
+                std::vector<ValuePtr>{Imm(kLaneNum)}));
+            auto after = Select(Compare(ir::IcmpInst::kUGE, b_ptr, a_end),
+                                result, loop.init);
+            result = Select(Compare(ir::IcmpInst::kULE, b_ptr, a_ptr), result,
+                            after);
+        }
+        return result;
+    }
+
+    std::shared_ptr<ir::TmpVar> Compare(const ir::IcmpInst::CmpKind op_code,
+                                        const ValuePtr &lhs,
+                                        const ValuePtr &rhs) {
+        auto result = std::make_shared<ir::TmpVar>(
+            ir::IntType::Get(ir::IntType::kI1), next_id++);
+        pre->AddInst(
+            std::make_shared<ir::IcmpInst>(op_code, result, lhs, rhs));
+        return result;
+    }
+
+    ValuePtr Select(const ValuePtr &cond,
+                    const ValuePtr &if_true,
+                    const ValuePtr &if_false) {
+        auto result = NewVar();
+        pre->AddInst(std::make_shared<ir::SelectInst>(result, cond, if_true,
+                                                      if_false));
+        return result;
+    }
+
+    // put the new blocks before the header, the preheader going to vpre
+    // and the header taking its first values from vexit
+    void Attach(const std::vector<ValuePtr> &result_list) {
+        const auto &header = graph.block_list[loop.header];
+        const auto &preheader = graph.block_list[loop.preheader];
+        auto &block_list = func.GetBlockList();
+        block_list.insert(std::find(block_list.begin(), block_list.end(),
+                                    header),
+                          {pre, vheader, vbody, vexit});
+
+        const auto label = header->GetLabel().Str();
+        auto &br = preheader->GetInstList().back()->Cast<ir::BrInst>();
+        if (br.HasDest()) {
+            br.SetDest(pre->GetLabelPtr());
+        } else {
+            if (br.GetTrue().Str() == label) br.SetTrue(pre->GetLabelPtr());
+            if (br.GetFalse().Str() == label) br.SetFalse(pre->GetLabelPtr());
+        }
+
+        const auto pre_label = preheader->GetLabel().Str();
+        for (const auto &inst : header->GetInstList()) {
+            if (inst->kind != ir::Inst::kPhi) break;
+            auto &phi = inst->Cast<ir::PhiInst>();
+            ValuePtr value = vi;
+            for (int i = 0; i < loop.reduction_list.size(); ++i) {
+                if (loop.reduction_list[i].phi == &phi) {
+                    value = result_list[i];
+                }
+            }
+            for (auto &phi_value : phi.GetValueList()) {
+                if (phi_value.label->Str() == pre_label) {
+                    phi_value = {value, vexit->GetLabelPtr()};
+                }
+            }
+        }
+    }
+};
+
+}  // namespace
+
+int LoopVectorize::Run(ir::FuncDef &func) {
+    int next_id = func.Renumber();
+    Graph graph(func);
+    if (graph.block_list.empty()) return 0;
+    const auto idom = Dominator(graph);
+    const AliasAnalysis alias_analysis(func);
+
+    // the phis of each block, to tell the loop finishing the iterations a
+    // vector loop left
+    std::unordered_map<std::string, int> phi_block;
+    for (int b = 0; b < graph.block_list.size(); ++b) {
+        for (const auto &inst : graph.block_list[b]->GetInstList()) {
+            if (inst->kind != ir::Inst::kPhi) break;
+            phi_block[inst->GetResultPtr()->Str()] = b;
+        }
+    }
+    auto after_vector = [&](const SimpleLoop &loop) {
+        const auto b = phi_block.find(loop.init->Str());
+        if (b == phi_block.end()) return false;
+        const auto &succ_list = graph.succ_list[b->second];
+        return std::any_of(succ_list.begin(), succ_list.end(),
+                           [&graph](const int succ) {
+                               return HasVectorCode(*graph.block_list[succ]);
+                           });
+    };
+
+    int count = 0;
+    std::unordered_set<int> changed;
+    for (const auto &loop : FindLoops(graph, idom)) {
+        if (loop.block_list.size() != 2) continue;
+        DefMap def_map;
+        for (const auto &inst :
+             graph.block_list[loop.block_list[1]]->GetInstList()) {
+            if (auto result = inst->GetResultPtr()) {
+                def_map[result->Str()] = inst.get();
+            }
+        }
+        SimpleLoop simple;
+        if (!MatchLoop(graph, loop, def_map, simple)
+            || changed.count(simple.header) != 0
+            || changed.count(simple.body) != 0
+            || changed.count(simple.preheader) != 0
+            || HasVectorCode(*graph.block_list[simple.body])
+            || after_vector(simple)) {
+            continue;
+        }
+        Vectorizer vectorizer(func, graph, simple, def_map, alias_analysis,
+                              next_id);
+        if (!vectorizer.Run()) continue;
+        changed.insert({simple.header, simple.body, simple.preheader});
+        ++count;
+    }
+    if (count > 0) func.Renumber();
+    return count;
+}
+
+}  // namespace opt
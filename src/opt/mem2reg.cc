@@ -0,0 +1,248 @@
+#include "opt/mem2reg.h"
+
+#include <iterator>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "ir/ir.h"
+#include "ir/type.h"
+#include "ir/value.h"
+#include "opt/cfg.h"
+
+namespace opt {
+
+namespace {
+
+using ValuePtr = std::shared_ptr<ir::Value>;
+
+// a phi being built for alloca in a block
+struct Phi {
+    std::shared_ptr<ir::TmpVar> result;
+    int alloca;
+    std::vector<ir::PhiInst::PhiValue> value_list;
+};
+
+}  // namespace
+
+int Mem2Reg::Run(ir::FuncDef &func) {
+    Graph graph(func);
+    const int block_num = static_cast<int>(graph.block_list.size());
+    if (block_num == 0) return 0;
+
+    // the i32 allocas whose address goes nowhere but into loads and stores
+    std::unordered_map<std::string, int> alloca_map;
+    for (const auto &bb : graph.block_list) {
+        for (const auto &inst : bb->GetInstList()) {
+            if (inst->kind != ir::Inst::kAlloca) continue;
+            const auto &result = *inst->GetResultPtr();
+            const auto &pointee
+                = result.GetType().Cast<ir::PtrType>().GetPointee();
+            if (pointee.kind == ir::Type::kInt
+                && pointee.Cast<ir::IntType>().GetWidth()
+                       == ir::IntType::kI32) {
+                const int index = static_cast<int>(alloca_map.size());
+                alloca_map.emplace(result.Str(), index);
+            }
+        }
+    }
+    std::unordered_set<std::string> escaped;
+    for (const auto &bb : graph.block_list) {
+        for (const auto &inst : bb->GetInstList()) {
+            if (inst->kind == ir::Inst::kLoad) continue;
+            if (inst->kind == ir::Inst::kStore) {
+                const auto &value = inst->Cast<ir::StoreInst>().GetValue();
+                escaped.insert(value.Str());
+                continue;
+            }
+            for (const auto &use : inst->GetUseList()) {
+                escaped.insert(use->Str());
+            }
+        }
+    }
+    for (const auto &name : escaped) alloca_map.erase(name);
+    if (alloca_map.empty()) return 0;
+    const int alloca_num = static_cast<int>(alloca_map.size());
+    auto promoted = [&alloca_map](const ir::Value &ptr) {
+        auto iter = alloca_map.find(ptr.Str());
+        return iter == alloca_map.end() ? -1 : iter->second;
+    };
+
+    auto idom = Dominator(graph);
+    std::vector<std::vector<int>> frontier(block_num);
+    std::vector<std::vector<int>> child_list(block_num);
+    for (int b = 0; b < block_num; ++b) {
+        if (idom[b] < 0) continue;
+        if (b != 0) child_list[idom[b]].push_back(b);
+        if (graph.pred_list[b].size() < 2) continue;
+        for (int pred : graph.pred_list[b]) {
+            if (idom[pred] < 0) continue;
+            for (int x = pred; x != idom[b]; x = idom[x]) {
+                auto &df = frontier[x];
+                if (df.empty() || df.back() != b) df.push_back(b);
+            }
+        }
+    }
+
+    // place the phis on the iterated frontier of the stores
+    std::vector<std::vector<int>> def_list(alloca_num);
+    for (int b = 0; b < block_num; ++b) {
+        if (idom[b] < 0) continue;
+        for (const auto &inst : graph.block_list[b]->GetInstList()) {
+            if (inst->kind != ir::Inst::kStore) continue;
+            const int a = promoted(inst->Cast<ir::StoreInst>().GetPtr());
+            if (a >= 0 && (def_list[a].empty() || def_list[a].back() != b)) {
+                def_list[a].push_back(b);
+            }
+        }
+    }
+    std::vector<Phi> phi_list;
+    std::vector<std::vector<int>> block_phi_list(block_num);  // into phi_list
+    std::vector<int> placed(block_num, -1);
+    std::vector<int> queued(block_num, -1);
+    for (int a = 0; a < alloca_num; ++a) {
+        auto worklist = def_list[a];
+        for (int b : worklist) queued[b] = a;
+        while (!worklist.empty()) {
+            const int x = worklist.back();
+            worklist.pop_back();
+            for (int y : frontier[x]) {
+                if (placed[y] == a) continue;
+                placed[y] = a;
+                block_phi_list[y].push_back(static_cast<int>(phi_list.size()));
+                phi_list.push_back({std::make_shared<ir::TmpVar>(-1), a, {}});
+                if (queued[y] != a) {
+                    queued[y] = a;
+                    worklist.push_back(y);
+                }
+            }
+        }
+    }
+
+    // walk the dominator tree with the value of each alloca, what a load
+    // reads goes to replace_map
+    const auto zero = std::make_shared<ir::Imm>(0);
+    std::unordered_map<const ir::Value *, ValuePtr> replace_map;
+    auto resolve = [&replace_map](const ValuePtr &value) {
+        auto iter = replace_map.find(value.get());
+        return iter == replace_map.end() ? value : iter->second;
+    };
+    std::vector<std::pair<int, std::vector<ValuePtr>>> stack;
+    stack.emplace_back(0, std::vector<ValuePtr>(alloca_num, zero));
+    while (!stack.empty()) {
+        const int b = stack.back().first;
+        auto value_list = std::move(stack.back().second);
+        stack.pop_back();
+        for (int p : block_phi_list[b]) {
+            value_list[phi_list[p].alloca] = phi_list[p].result;
+        }
+        auto &inst_list = graph.block_list[b]->GetInstList();
+        for (auto iter = inst_list.begin(); iter != inst_list.end();) {
+            const auto &inst = **iter;
+            int a = -1;
+            if (inst.kind == ir::Inst::kLoad) {
+                a = promoted(inst.Cast<ir::LoadInst>().GetPtr());
+                if (a >= 0) {
+                    replace_map[inst.GetResultPtr().get()] = value_list[a];
+                }
+            } else if (inst.kind == ir::Inst::kStore) {
+                const auto &store = inst.Cast<ir::StoreInst>();
+                a = promoted(store.GetPtr());
+                if (a >= 0) value_list[a] = resolve(store.GetValuePtr());
+            }
+            iter = a >= 0 ? inst_list.erase(iter) : std::next(iter);
+        }
+        const auto label = graph.block_list[b]->GetLabelPtr();
+        for (int succ : graph.succ_list[b]) {
+            for (int p : block_phi_list[succ]) {
+                auto &phi = phi_list[p];
+                phi.value_list.emplace_back(value_list[phi.alloca], label);
+            }
+        }
+        for (int child : child_list[b]) stack.emplace_back(child, value_list);
+    }
+
+    // the blocks the entry does not reach still have to be consistent
+    for (int b = 0; b < block_num; ++b) {
+        if (idom[b] >= 0) continue;
+        auto &inst_list = graph.block_list[b]->GetInstList();
+        for (auto iter = inst_list.begin(); iter != inst_list.end();) {
+            const auto &inst = **iter;
+            if (inst.kind == ir::Inst::kLoad
+                && promoted(inst.Cast<ir::LoadInst>().GetPtr()) >= 0) {
+                replace_map[inst.GetResultPtr().get()] = zero;
+                iter = inst_list.erase(iter);
+            } else if (inst.kind == ir::Inst::kStore
+                       && promoted(inst.Cast<ir::StoreInst>().GetPtr()) >= 0) {
+                iter = inst_list.erase(iter);
+            } else {
+                ++iter;
+            }
+        }
+        const auto label = graph.block_list[b]->GetLabelPtr();
+        for (int succ : graph.succ_list[b]) {
+            for (int p : block_phi_list[succ]) {
+                phi_list[p].value_list.emplace_back(zero, label);
+            }
+        }
+    }
+
+    // drop the allocas, point the uses of the loads at what they read
+    std::unordered_map<const ir::Value *, int> phi_map;
+    for (int p = 0; p < phi_list.size(); ++p) {
+        phi_map[phi_list[p].result.get()] = p;
+    }
+    std::vector<bool> live(phi_list.size(), false);
+    std::vector<int> worklist;
+    for (const auto &bb : graph.block_list) {
+        auto &inst_list = bb->GetInstList();
+        for (auto iter = inst_list.begin(); iter != inst_list.end();) {
+            auto &inst = **iter;
+            if (inst.kind == ir::Inst::kAlloca
+                && promoted(*inst.GetResultPtr()) >= 0) {
+                iter = inst_list.erase(iter);
+                continue;
+            }
+            for (const auto &use : inst.GetUseList()) {
+                auto to = resolve(use);
+                if (to != use) inst.ReplaceUse(use, to);
+                auto phi = phi_map.find(to.get());
+                if (phi != phi_map.end() && !live[phi->second]) {
+                    live[phi->second] = true;
+                    worklist.push_back(phi->second);
+                }
+            }
+            ++iter;
+        }
+    }
+    while (!worklist.empty()) {
+        const int p = worklist.back();
+        worklist.pop_back();
+        for (const auto &value : phi_list[p].value_list) {
+            auto phi = phi_map.find(value.value.get());
+            if (phi != phi_map.end() && !live[phi->second]) {
+                live[phi->second] = true;
+                worklist.push_back(phi->second);
+            }
+        }
+    }
+    for (int b = 0; b < block_num; ++b) {
+        auto &inst_list = graph.block_list[b]->GetInstList();
+        auto &phi_index_list = block_phi_list[b];
+        for (auto iter = phi_index_list.rbegin(); iter != phi_index_list.rend();
+             ++iter) {
+            auto &phi = phi_list[*iter];
+            if (!live[*iter]) continue;
+            inst_list.push_front(std::make_shared<ir::PhiInst>(
+                phi.result, std::move(phi.value_list)));
+        }
+    }
+
+    func.Renumber();
+    return alloca_num;
+}
+
+}  // namespace opt
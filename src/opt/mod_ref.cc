@@ -0,0 +1,149 @@
+#include "opt/mod_ref.h"
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "ir/ir.h"
+#include "opt/alias_analysis.h"
+
+namespace opt {
+
+namespace {
+
+using SummaryMap = std::unordered_map<std::string, ModRefSummary>;
+
+// none of sylib touches the memory of the program but through the arrays
+// passed to it
+void AddLibrary(SummaryMap &summary_map) {
+    ModRefSummary io;
+    io.io = true;
+    for (const char *name : {"getint", "getch", "putint", "putch",
+                             "_sysy_starttime", "_sysy_stoptime"}) {
+        summary_map[name] = io;
+    }
+    summary_map["getarray"] = io;
+    summary_map["getarray"].mod_param_set = {0};
+    summary_map["putarray"] = io;
+    summary_map["putarray"].ref_param_set = {1};
+}
+
+// what func touches, with the callees as summary_map has them
+ModRefSummary Summarize(const ir::FuncDef &func,
+                        const AliasAnalysis &alias_analysis,
+                        const SummaryMap &summary_map) {
+    std::unordered_map<std::string, int> param_index;
+    const auto &param_list = func.GetParamList();
+    for (int i = 0; i < param_list.size(); ++i) {
+        param_index[param_list[i]->Str()] = i;
+    }
+
+    ModRefSummary summary;
+    auto access = [&](const ir::Value &ptr, const bool mod) {
+        const auto location = alias_analysis.GetLocation(ptr);
+        switch (location.kind) {
+            case Location::kGlobal:
+                (mod ? summary.mod_global_set : summary.ref_global_set)
+                    .insert(location.object);
+                break;
+            case Location::kParam:
+                (mod ? summary.mod_param_set : summary.ref_param_set)
+                    .insert(param_index.at(location.object));
+                break;
+            case Location::kAlloca:
+                break;
+            default:
+                summary.unknown = true;
+                break;
+        }
+    };
+    for (const auto &bb : func.GetBlockList()) {
+        for (const auto &inst : bb->GetInstList()) {
+            switch (inst->kind) {
+                case ir::Inst::kLoad:
+                    access(inst->Cast<ir::LoadInst>().GetPtr(), false);
+                    break;
+                case ir::Inst::kStore:
+                    access(inst->Cast<ir::StoreInst>().GetPtr(), true);
+                    break;
+                case ir::Inst::kCall: {
+                    const auto &call = inst->Cast<ir::CallInst>();
+                    const auto iter
+                        = summary_map.find(call.GetFunc().GetName());
+                    if (iter == summary_map.end()) {
+                        summary.unknown = true;
+                        break;
+                    }
+                    const auto &callee = iter->second;
+                    summary.unknown = summary.unknown || callee.unknown;
+                    summary.io = summary.io || callee.io;
+                    summary.ref_global_set.insert(
+                        callee.ref_global_set.begin(),
+                        callee.ref_global_set.end());
+                    summary.mod_global_set.insert(
+                        callee.mod_global_set.begin(),
+                        callee.mod_global_set.end());
+                    for (int i : callee.ref_param_set) {
+                        if (i < call.GetParamNum()) {
+                            access(*call.GetParamAt(i), false);
+                        }
+                    }
+                    for (int i : callee.mod_param_set) {
+                        if (i < call.GetParamNum()) {
+                            access(*call.GetParamAt(i), true);
+                        }
+                    }
+                    break;
+                }
+                default:
+                    break;
+            }
+        }
+    }
+    return summary;
+}
+
+}  // namespace
+
+bool operator==(const ModRefSummary &lhs, const ModRefSummary &rhs) {
+    return lhs.unknown == rhs.unknown && lhs.io == rhs.io
+           && lhs.ref_global_set == rhs.ref_global_set
+           && lhs.mod_global_set == rhs.mod_global_set
+           && lhs.ref_param_set == rhs.ref_param_set
+           && lhs.mod_param_set == rhs.mod_param_set;
+}
+
+ModRefAnalysis::ModRefAnalysis(const ir::Module &module) {
+    AddLibrary(summary_map);
+
+    // the summaries only grow, from nothing for each function defined, and
+    // SysY defines the callees before their callers but for recursion
+    std::vector<const ir::FuncDef *> func_list;
+    std::vector<std::unique_ptr<AliasAnalysis>> alias_list;
+    for (const auto &func : module.GetFuncDefList()) {
+        summary_map[func->GetName()] = ModRefSummary();
+        func_list.push_back(func.get());
+        alias_list.push_back(std::make_unique<AliasAnalysis>(*func));
+    }
+    for (bool changed = true; changed;) {
+        changed = false;
+        for (int i = 0; i < func_list.size(); ++i) {
+            auto summary
+                = Summarize(*func_list[i], *alias_list[i], summary_map);
+            auto &old = summary_map[func_list[i]->GetName()];
+            if (!(summary == old)) {
+                old = std::move(summary);
+                changed = true;
+            }
+        }
+    }
+}
+
+const ModRefSummary *ModRefAnalysis::GetSummary(
+    const std::string &name) const {
+    const auto iter = summary_map.find(name);
+    return iter == summary_map.end() ? nullptr : &iter->second;
+}
+
+}  // namespace opt
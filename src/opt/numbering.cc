@@ -0,0 +1,128 @@
+#include "opt/numbering.h"
+
+#include <string>
+#include <unordered_set>
+#include <utility>
+
+#include "ir/ir.h"
+#include "ir/type.h"
+#include "ir/value.h"
+
+namespace opt {
+
+std::unordered_set<std::string> GetAllocaSet(ir::FuncDef &func) {
+    std::unordered_set<std::string> alloca_set;
+    for (const auto &bb : func.GetBlockList()) {
+        for (const auto &inst : bb->GetInstList()) {
+            if (inst->kind == ir::Inst::kAlloca) {
+                alloca_set.insert(inst->GetResultPtr()->Str());
+            }
+        }
+    }
+    return alloca_set;
+}
+
+bool IsScalar(const ir::Value &ptr,
+              const std::unordered_set<std::string> &alloca_set) {
+    if (ptr.GetType().kind != ir::Type::kPtr) return false;
+    const auto &pointee = ptr.GetType().Cast<ir::PtrType>().GetPointee();
+    if (pointee.kind != ir::Type::kInt
+        || pointee.Cast<ir::IntType>().GetWidth() != ir::IntType::kI32) {
+        return false;
+    }
+    return ptr.kind == ir::Value::kGlobalVar
+           || alloca_set.count(ptr.Str()) != 0;
+}
+
+std::string Numbering::Key(const ir::Value &value) const {
+    auto iter = key_map.find(value.Str());
+    return iter == key_map.end() ? value.Str() : iter->second;
+}
+
+std::pair<std::string, int> Numbering::Linear(const ir::Value &value) const {
+    if (value.kind == ir::Value::kImm) {
+        return {"", value.Cast<ir::Imm>().GetValue()};
+    }
+    auto iter = linear_map.find(value.Str());
+    return iter == linear_map.end() ? std::make_pair(Key(value), 0)
+                                    : iter->second;
+}
+
+void Numbering::Visit(const ir::Inst &inst) {
+    switch (inst.kind) {
+        case ir::Inst::kBinaryOp: {
+            const auto &op = inst.Cast<ir::BinaryOpInst>();
+            const auto &lhs = op.GetLHS();
+            const auto &rhs = op.GetRHS();
+            if (op.op_code == ir::BinaryOpInst::kSub
+                && rhs.kind != ir::Value::kImm) {
+                break;
+            }
+            if (op.op_code != ir::BinaryOpInst::kAdd
+                && op.op_code != ir::BinaryOpInst::kSub) {
+                break;
+            }
+            auto lhs_linear = Linear(lhs);
+            auto rhs_linear = Linear(rhs);
+            if (!lhs_linear.first.empty() && !rhs_linear.first.empty()) break;
+            if (lhs_linear.first.empty()) std::swap(lhs_linear, rhs_linear);
+            // wraps around like the instruction does
+            auto offset = static_cast<unsigned>(lhs_linear.second);
+            if (op.op_code == ir::BinaryOpInst::kAdd) {
+                offset += static_cast<unsigned>(rhs_linear.second);
+            } else {
+                offset -= static_cast<unsigned>(rhs_linear.second);
+            }
+            const std::pair<std::string, int> linear
+                = {lhs_linear.first, static_cast<int>(offset)};
+            linear_map[op.GetResult().Str()] = linear;
+            key_map[op.GetResult().Str()]
+                = linear.first.empty() ? std::to_string(linear.second)
+                                       : linear.first + '+'
+                                             + std::to_string(linear.second);
+            break;
+        }
+        case ir::Inst::kLoad: {
+            const auto ptr = inst.GetUseList()[0];
+            key_map[inst.GetResultPtr()->Str()]
+                = "load " + Key(*ptr) + '@' + Epoch(*ptr);
+            break;
+        }
+        case ir::Inst::kGetelementptr: {
+            std::string key = "gep";
+            for (const auto &use : inst.GetUseList()) key += ' ' + Key(*use);
+            key_map[inst.GetResultPtr()->Str()] = key;
+            break;
+        }
+        case ir::Inst::kBitcast:
+            key_map[inst.GetResultPtr()->Str()] = Key(*inst.GetUseList()[0]);
+            break;
+        case ir::Inst::kStore: {
+            const auto ptr = inst.GetUseList()[1];
+            if (IsScalar(*ptr, alloca_set)) {
+                ++epoch[ptr->Str()];
+            } else {
+                ++memory_epoch;
+            }
+            break;
+        }
+        case ir::Inst::kCall:
+            ++memory_epoch;
+            ++call_epoch;
+            break;
+        default:
+            break;
+    }
+}
+
+std::string Numbering::Epoch(const ir::Value &ptr) const {
+    if (!IsScalar(ptr, alloca_set)) return 'm' + std::to_string(memory_epoch);
+    auto iter = epoch.find(ptr.Str());
+    auto str = std::to_string(iter == epoch.end() ? 0 : iter->second);
+    if (ptr.kind == ir::Value::kGlobalVar) {
+        str += 'c' + std::to_string(call_epoch);
+    }
+    return str;
+}
+
+}  // namespace opt
@@ -0,0 +1,41 @@
+#include "opt/pass.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "ir/ir.h"
+
+namespace opt {
+
+ir::BrInst *GetBr(ir::BasicBlock &bb) {
+    auto &inst_list = bb.GetInstList();
+    if (inst_list.empty() || inst_list.back()->kind != ir::Inst::kBr) {
+        return nullptr;
+    }
+    return &inst_list.back()->Cast<ir::BrInst>();
+}
+
+std::vector<std::string> GetSuccessorList(ir::BasicBlock &bb) {
+    auto *br = GetBr(bb);
+    if (br == nullptr) return {};
+    if (br->HasDest()) return {br->GetDest().Str()};
+    return {br->GetTrue().Str(), br->GetFalse().Str()};
+}
+
+void ReplaceAllUses(ir::FuncDef &func,
+                    const std::shared_ptr<ir::Value> &from,
+                    const std::shared_ptr<ir::Value> &to) {
+    for (const auto &bb : func.GetBlockList()) {
+        for (const auto &inst : bb->GetInstList()) inst->ReplaceUse(from, to);
+    }
+}
+
+int RunOnModule(FuncPass &pass, ir::Module &module) {
+    pass.Prepare(module);
+    int count = 0;
+    for (const auto &func : module.GetFuncDefList()) count += pass.Run(*func);
+    return count;
+}
+
+}  // namespace opt
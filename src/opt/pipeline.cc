@@ -0,0 +1,86 @@
+#include "opt/pipeline.h"
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "error.h"
+#include "ir/ir.h"
+#include "opt/block_placement.h"
+#include "opt/if_conversion.h"
+#include "opt/load_store_elimination.h"
+#include "opt/loop_interchange.h"
+#include "opt/loop_tiling.h"
+#include "opt/loop_vectorize.h"
+#include "opt/mem2reg.h"
+#include "opt/pass.h"
+#include "opt/scalar_promotion.h"
+#include "opt/simplify_cfg.h"
+#include "opt/slp_vectorize.h"
+#include "opt/strength_reduction.h"
+
+namespace opt {
+
+std::unique_ptr<FuncPass> CreatePass(const std::string &name) {
+    if (name == "mem2reg") return std::make_unique<Mem2Reg>();
+    if (name == "simplify-cfg") return std::make_unique<SimplifyCFG>();
+    if (name == "strength-reduction") {
+        return std::make_unique<StrengthReduction>();
+    }
+    if (name == "if-conversion") return std::make_unique<IfConversion>();
+    if (name == "block-placement") return std::make_unique<BlockPlacement>();
+    if (name == "load-store-elimination") {
+        return std::make_unique<LoadStoreElimination>();
+    }
+    if (name == "scalar-promotion") return std::make_unique<ScalarPromotion>();
+    if (name == "loop-interchange") return std::make_unique<LoopInterchange>();
+    if (name == "loop-tiling") return std::make_unique<LoopTiling>();
+    if (name == "loop-vectorize") return std::make_unique<LoopVectorize>();
+    if (name == "slp-vectorize") return std::make_unique<SLPVectorize>();
+    throw InvalidParameterException("unknown pass '" + name + '\'');
+}
+
+std::string GetPipeline(const int level) {
+    switch (level) {
+        case 0:
+            return "";
+        case 1:
+            return "mem2reg,simplify-cfg";
+        case 2:
+            return "strength-reduction,if-conversion,mem2reg,simplify-cfg,"
+                   "loop-interchange,loop-tiling,load-store-elimination,"
+                   "scalar-promotion,loop-vectorize,slp-vectorize,simplify-cfg";
+        default:
+            throw InvalidParameterException("unknown optimization level "
+                                            + std::to_string(level));
+    }
+}
+
+std::vector<std::unique_ptr<FuncPass>> ParsePipeline(
+    const std::string &pipeline) {
+    std::vector<std::unique_ptr<FuncPass>> pass_list;
+    if (pipeline.empty()) return pass_list;
+    std::size_t begin = 0;
+    while (true) {
+        const auto end = pipeline.find(',', begin);
+        const auto name = pipeline.substr(begin, end - begin);
+        if (name.empty()) {
+            throw InvalidParameterException("empty pass name in '" + pipeline
+                                            + '\'');
+        }
+        pass_list.push_back(CreatePass(name));
+        if (end == std::string::npos) break;
+        begin = end + 1;
+    }
+    return pass_list;
+}
+
+int RunPipeline(const std::vector<std::unique_ptr<FuncPass>> &pass_list,
+                ir::Module &module) {
+    int count = 0;
+    for (const auto &pass : pass_list) count += RunOnModule(*pass, module);
+    return count;
+}
+
+}  // namespace opt
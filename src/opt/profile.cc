@@ -0,0 +1,200 @@
+#include "opt/profile.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "emitter.h"
+#include "error.h"
+#include "ir/ir.h"
+#include "ir/type.h"
+#include "ir/value.h"
+
+namespace opt {
+
+namespace {
+
+// FNV-1a
+constexpr std::uint32_t kHashBasis = 2166136261U;
+constexpr std::uint32_t kHashPrime = 16777619U;
+
+std::uint32_t Hash(std::uint32_t hash, const std::uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        hash = (hash ^ ((value >> (i * 8)) & 0xff)) * kHashPrime;
+    }
+    return hash;
+}
+
+}  // namespace
+
+std::uint32_t GetProfileHash(const ir::FuncDef &func) {
+    std::uint32_t hash = kHashBasis;
+    for (const char c : func.GetName()) {
+        hash = (hash ^ static_cast<unsigned char>(c)) * kHashPrime;
+    }
+    std::unordered_map<std::string, std::uint32_t> index_map;
+    for (const auto &bb : func.GetBlockList()) {
+        index_map.emplace(bb->GetLabel().Str(), index_map.size());
+    }
+    hash = Hash(hash, index_map.size());
+    for (const auto &bb : func.GetBlockList()) {
+        const auto &inst_list = bb->GetInstList();
+        if (inst_list.empty() || inst_list.back()->kind != ir::Inst::kBr) {
+            hash = Hash(hash, 0);
+            continue;
+        }
+        const auto &br = inst_list.back()->Cast<ir::BrInst>();
+        hash = Hash(hash, br.HasDest() ? 1 : 2);
+        hash = Hash(hash, index_map[br.GetTrue().Str()]);
+        if (!br.HasDest()) hash = Hash(hash, index_map[br.GetFalse().Str()]);
+    }
+    return hash;
+}
+
+void InstrumentProfile(ir::Module &module) {
+    std::vector<int> layout{static_cast<int>(module.GetFuncDefNum())};
+    int counter_num = 0;
+    for (const auto &func : module.GetFuncDefList()) {
+        layout.push_back(static_cast<int>(GetProfileHash(*func)));
+        layout.push_back(static_cast<int>(func->GetBlockNum()));
+        counter_num += static_cast<int>(func->GetBlockNum());
+    }
+    if (counter_num == 0) return;
+
+    // two i32 words a counter, the low one first as in a little-endian u64
+    auto counter_type = std::make_shared<ir::ArrayType>(
+        std::vector<int>{counter_num * 2});
+    auto counter = std::make_shared<ir::GlobalVar>(
+        std::make_shared<ir::PtrType>(counter_type), kProfileCounter);
+    int index = 0;
+    for (const auto &func : module.GetFuncDefList()) {
+        for (const auto &bb : func->GetBlockList()) {
+            const int slot = index++;
+            // the blocks that are not dumped never run
+            auto &inst_list = bb->GetInstList();
+            if (inst_list.empty()) continue;
+            auto pos = inst_list.begin();
+            while (pos != inst_list.end() && (*pos)->kind == ir::Inst::kPhi) {
+                ++pos;
+            }
+            // word = word + add, numbered by Renumber below
+            auto increment = [&](const int word,
+                                 const std::shared_ptr<ir::Value> &add) {
+                auto addr =
+                    std::make_shared<ir::TmpVar>(ir::PtrType::Get(), 0);
+                auto count = std::make_shared<ir::TmpVar>(0);
+                auto next = std::make_shared<ir::TmpVar>(0);
+                inst_list.insert(
+                    pos, std::make_shared<ir::GetelementptrInst>(
+                             addr, counter,
+                             std::vector<std::shared_ptr<ir::Value>>{
+                                 std::make_shared<ir::Imm>(0),
+                                 std::make_shared<ir::Imm>(word)}));
+                inst_list.insert(pos,
+                                 std::make_shared<ir::LoadInst>(count, addr));
+                inst_list.insert(pos, std::make_shared<ir::BinaryOpInst>(
+                                          ir::BinaryOpInst::kAdd, next, count,
+                                          add));
+                inst_list.insert(pos,
+                                 std::make_shared<ir::StoreInst>(next, addr));
+                return next;
+            };
+            // the high word takes the carry out of the low one
+            auto low = increment(slot * 2, std::make_shared<ir::Imm>(1));
+            auto wrapped = std::make_shared<ir::TmpVar>(
+                ir::IntType::Get(ir::IntType::kI1), 0);
+            auto carry = std::make_shared<ir::TmpVar>(0);
+            inst_list.insert(pos, std::make_shared<ir::IcmpInst>(
+                                      ir::IcmpInst::kEQ, wrapped, low,
+                                      std::make_shared<ir::Imm>(0)));
+            inst_list.insert(pos,
+                             std::make_shared<ir::ZextInst>(carry, wrapped));
+            increment(slot * 2 + 1, carry);
+        }
+        func->Renumber();
+    }
+
+    module.AddVar(std::make_shared<ir::GlobalVarDef>(
+        std::make_shared<ir::GlobalVar>(counter_type, kProfileCounter), false,
+        std::vector<std::shared_ptr<ir::Imm>>{}, true));
+    std::vector<std::shared_ptr<ir::Imm>> init_list;
+    for (const int value : layout) {
+        init_list.push_back(std::make_shared<ir::Imm>(value));
+    }
+    module.AddVar(std::make_shared<ir::GlobalVarDef>(
+        std::make_shared<ir::GlobalVar>(
+            std::make_shared<ir::ArrayType>(
+                std::vector<int>{static_cast<int>(layout.size())}),
+            kProfileLayout),
+        true, std::move(init_list), false));
+}
+
+Profile Profile::Read(std::istream &istream) {
+    Profile profile;
+    std::uint32_t hash = 0;
+    std::size_t block_num = 0;
+    while (istream >> hash >> block_num) {
+        Entry entry{hash, std::vector<std::uint64_t>(block_num)};
+        for (auto &count : entry.count_list) {
+            if (!(istream >> count)) {
+                throw InvalidParameterException(
+                    "profile ends in the counts of function "
+                    + std::to_string(hash));
+            }
+        }
+        profile.Add(std::move(entry));
+    }
+    if (!istream.eof()) throw InvalidParameterException("malformed profile");
+    return profile;
+}
+
+void Profile::Write(util::Emitter &emitter) const {
+    for (const auto &entry : entry_list) {
+        emitter << entry.hash << ' ' << entry.count_list.size() << '\n';
+        for (const auto count : entry.count_list) emitter << count << '\n';
+    }
+}
+
+void Profile::Add(const ir::FuncDef &func,
+                  std::vector<std::uint64_t> count_list) {
+    Add({GetProfileHash(func), std::move(count_list)});
+}
+
+void Profile::Add(Entry entry) {
+    // the runs appended to one profile add up
+    const auto iter = entry_map.find(entry.hash);
+    if (iter != entry_map.end()
+        && entry_list[iter->second].count_list.size()
+               == entry.count_list.size()) {
+        auto &count_list = entry_list[iter->second].count_list;
+        for (std::size_t i = 0; i < count_list.size(); ++i) {
+            count_list[i] += entry.count_list[i];
+        }
+        return;
+    }
+    entry_map[entry.hash] = static_cast<int>(entry_list.size());
+    entry_list.push_back(std::move(entry));
+}
+
+int Profile::Annotate(ir::Module &module) const {
+    int count = 0;
+    for (const auto &func : module.GetFuncDefList()) {
+        const auto iter = entry_map.find(GetProfileHash(*func));
+        if (iter == entry_map.end()) continue;
+        const auto &count_list = entry_list[iter->second].count_list;
+        if (count_list.size() != func->GetBlockNum()) continue;
+        auto bb = func->GetBlockList().begin();
+        for (const auto block_count : count_list) {
+            (*bb++)->SetCount(block_count);
+        }
+        ++count;
+    }
+    return count;
+}
+
+}  // namespace opt
@@ -0,0 +1,358 @@
+#include "opt/scalar_promotion.h"
+
+#include <algorithm>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "ir/ir.h"
+#include "ir/type.h"
+#include "ir/value.h"
+#include "opt/alias_analysis.h"
+#include "opt/cfg.h"
+#include "opt/mem2reg.h"
+#include "opt/mod_ref.h"
+
+namespace opt {
+
+namespace {
+
+using BlockPtr = std::shared_ptr<ir::BasicBlock>;
+using VarPtr = std::shared_ptr<ir::Var>;
+
+// a load or a store in a loop, and the block it is in
+struct Access {
+    const ir::Inst *inst;
+    int block;
+};
+
+// the loads and stores of one word in a loop
+struct Word {
+    std::vector<Access> access_list;
+    bool stored = false;
+    // an address of the word that holds before the loop, or the gep of the
+    // loop to copy in front of it for one
+    VarPtr address;
+    const ir::GetelementptrInst *gep = nullptr;
+};
+
+VarPtr GetAddress(const ir::Inst &inst) {
+    if (inst.kind == ir::Inst::kLoad) {
+        return inst.Cast<ir::LoadInst>().GetPtrPtr();
+    }
+    return std::static_pointer_cast<ir::Var>(
+        inst.Cast<ir::StoreInst>().GetPtrPtr());
+}
+
+bool IsI32Word(const ir::Value &ptr) {
+    const auto &pointee = ptr.GetType().Cast<ir::PtrType>().GetPointee();
+    return pointee.kind == ir::Type::kInt
+           && pointee.Cast<ir::IntType>().GetWidth() == ir::IntType::kI32;
+}
+
+void InsertBeforeEnd(ir::BasicBlock &bb, std::shared_ptr<ir::Inst> inst) {
+    auto &inst_list = bb.GetInstList();
+    inst_list.insert(std::prev(inst_list.end()), std::move(inst));
+}
+
+// put a block of its own on the edges from pred to succ, in front of succ
+BlockPtr SplitEdge(ir::FuncDef &func,
+                   ir::BasicBlock &pred,
+                   const BlockPtr &succ,
+                   int &next_id) {
+    auto bb = std::make_shared<ir::BasicBlock>(
+        std::make_shared<ir::TmpVar>(ir::LabelType::Get(), next_id++));
+    bb->AddInst(std::make_shared<ir::BrInst>(succ->GetLabelPtr()));
+    const auto label = succ->GetLabel().Str();
+    auto *br = GetBr(pred);
+    if (br->GetTrue().Str() == label) br->SetTrue(bb->GetLabelPtr());
+    if (!br->HasDest() && br->GetFalse().Str() == label) {
+        br->SetFalse(bb->GetLabelPtr());
+    }
+    for (const auto &inst : succ->GetInstList()) {
+        if (inst->kind != ir::Inst::kPhi) break;
+        for (auto &value : inst->Cast<ir::PhiInst>().GetValueList()) {
+            if (value.label->Str() == pred.GetLabel().Str()) {
+                value.label = bb->GetLabelPtr();
+            }
+        }
+    }
+    auto &block_list = func.GetBlockList();
+    block_list.insert(std::find(block_list.begin(), block_list.end(), succ),
+                      bb);
+    return bb;
+}
+
+// drop what computes a value nothing uses, as the geps of the addresses
+// promoted
+void RemoveDeadCode(ir::FuncDef &func) {
+    for (bool changed = true; changed;) {
+        changed = false;
+        std::unordered_set<std::string> used;
+        for (const auto &bb : func.GetBlockList()) {
+            for (const auto &inst : bb->GetInstList()) {
+                for (const auto &value : inst->GetUseList()) {
+                    used.insert(value->Str());
+                }
+            }
+        }
+        for (const auto &bb : func.GetBlockList()) {
+            bb->GetInstList().remove_if(
+                [&](const std::shared_ptr<ir::Inst> &inst) {
+                    switch (inst->kind) {
+                        case ir::Inst::kBinaryOp:
+                        case ir::Inst::kGetelementptr:
+                        case ir::Inst::kIcmp:
+                        case ir::Inst::kZext:
+                        case ir::Inst::kBitcast:
+                            break;
+                        default:
+                            return false;
+                    }
+                    if (used.count(inst->GetResultPtr()->Str()) != 0) {
+                        return false;
+                    }
+                    changed = true;
+                    return true;
+                });
+        }
+    }
+}
+
+// The words of loop that can be promoted. A word can if the alias analysis
+// tells it apart from every other load, store and call of the loop, it has
+// an address before the loop, and loading it there is safe.
+std::vector<Word> FindWords(const Graph &graph,
+                            const std::vector<int> &idom,
+                            const Loop &loop,
+                            const std::vector<int> &exiting_list,
+                            const AliasAnalysis &alias_analysis) {
+    std::unordered_map<std::string, const ir::Inst *> def_map;
+    std::vector<Access> access_list;
+    std::vector<const ir::Inst *> call_list;
+    for (int b : loop.block_list) {
+        for (const auto &inst : graph.block_list[b]->GetInstList()) {
+            if (auto result = inst->GetResultPtr()) {
+                def_map[result->Str()] = inst.get();
+            }
+            if (inst->kind == ir::Inst::kLoad
+                || inst->kind == ir::Inst::kStore) {
+                access_list.push_back({inst.get(), b});
+            } else if (inst->kind == ir::Inst::kCall) {
+                call_list.push_back(inst.get());
+            }
+        }
+    }
+
+    std::vector<Word> word_list;
+    for (const auto &access : access_list) {
+        const auto ptr = GetAddress(*access.inst);
+        auto word = std::find_if(
+            word_list.begin(), word_list.end(), [&](const Word &other) {
+                return alias_analysis.Alias(
+                           *GetAddress(*other.access_list[0].inst), *ptr)
+                       == AliasAnalysis::kMustAlias;
+            });
+        if (word == word_list.end()) {
+            word_list.emplace_back();
+            word = std::prev(word_list.end());
+        }
+        word->access_list.push_back(access);
+        word->stored = word->stored || access.inst->kind == ir::Inst::kStore;
+    }
+
+    auto invariant = [&def_map](const ir::Value &value) {
+        return value.kind == ir::Value::kImm || def_map.count(value.Str()) == 0;
+    };
+    auto promotable = [&](Word &word) {
+        const auto &ptr = *GetAddress(*word.access_list[0].inst);
+        if (!IsI32Word(ptr)) return false;
+        for (const auto &access : access_list) {
+            const auto result
+                = alias_analysis.Alias(ptr, *GetAddress(*access.inst));
+            if (result == AliasAnalysis::kMayAlias) return false;
+        }
+        for (const auto *call : call_list) {
+            if (alias_analysis.GetModRef(*call, ptr)
+                != AliasAnalysis::kNoModRef) {
+                return false;
+            }
+        }
+
+        for (const auto &access : word.access_list) {
+            auto address = GetAddress(*access.inst);
+            if (invariant(*address)) {
+                word.address = std::move(address);
+                word.gep = nullptr;
+                break;
+            }
+            const auto *def = def_map.at(address->Str());
+            if (word.gep != nullptr || def->kind != ir::Inst::kGetelementptr) {
+                continue;
+            }
+            const auto use_list = def->GetUseList();
+            if (std::all_of(use_list.begin(), use_list.end(),
+                            [&](const std::shared_ptr<ir::Value> &value) {
+                                return invariant(*value);
+                            })) {
+                word.address = std::move(address);
+                word.gep = &def->Cast<ir::GetelementptrInst>();
+            }
+        }
+        if (word.address == nullptr) return false;
+
+        const auto location = alias_analysis.GetLocation(ptr);
+        if ((location.kind == Location::kGlobal
+             || location.kind == Location::kAlloca)
+            && location.term_map.empty() && location.offset >= 0
+            && location.offset < location.size) {
+            return true;
+        }
+        if (exiting_list.empty()) return false;
+        return std::any_of(
+            word.access_list.begin(), word.access_list.end(),
+            [&](const Access &access) {
+                return std::all_of(exiting_list.begin(), exiting_list.end(),
+                                   [&](const int exiting) {
+                                       return Dominates(idom, access.block,
+                                                        exiting);
+                                   });
+            });
+    };
+    word_list.erase(
+        std::remove_if(word_list.begin(), word_list.end(),
+                       [&](Word &word) { return !promotable(word); }),
+        word_list.end());
+    return word_list;
+}
+
+// promote the words of the innermost loop that has any, return how many
+int PromoteLoop(ir::FuncDef &func, const ModRefAnalysis *mod_ref) {
+    int next_id = func.Renumber();
+    Graph graph(func);
+    const int block_num = static_cast<int>(graph.block_list.size());
+    if (block_num == 0) return 0;
+    const auto idom = Dominator(graph);
+    const AliasAnalysis alias_analysis(func, false, mod_ref);
+
+    for (const auto &loop : FindLoops(graph, idom)) {
+        std::vector<bool> in_loop(block_num, false);
+        for (int b : loop.block_list) in_loop[b] = true;
+        // a block that branches twice to the same block has no edge to split
+        auto twice = [&graph](const int b) {
+            const auto &succ_list = graph.succ_list[b];
+            return succ_list.size() == 2 && succ_list[0] == succ_list[1];
+        };
+        std::vector<int> enter_list;
+        for (int pred : graph.pred_list[loop.header]) {
+            if (in_loop[pred] || idom[pred] < 0) continue;
+            if (std::find(enter_list.begin(), enter_list.end(), pred)
+                == enter_list.end()) {
+                enter_list.push_back(pred);
+            }
+        }
+        if (enter_list.size() != 1 || twice(enter_list[0])) continue;
+        std::vector<std::pair<int, int>> exit_list;
+        std::vector<int> exiting_list;
+        bool split = true;
+        for (int b : loop.block_list) {
+            for (int succ : graph.succ_list[b]) {
+                if (in_loop[succ]) continue;
+                split = split && !twice(b);
+                exit_list.emplace_back(b, succ);
+                exiting_list.push_back(b);
+            }
+        }
+        if (!split) continue;
+        auto word_list
+            = FindWords(graph, idom, loop, exiting_list, alias_analysis);
+        if (word_list.empty()) continue;
+
+        const auto &header = graph.block_list[loop.header];
+        auto preheader = graph.block_list[enter_list[0]];
+        if (graph.succ_list[enter_list[0]].size() != 1) {
+            preheader = SplitEdge(func, *preheader, header, next_id);
+        }
+        std::vector<BlockPtr> exit_block_list;
+        if (std::any_of(word_list.begin(), word_list.end(),
+                        [](const Word &word) { return word.stored; })) {
+            for (const auto &edge : exit_list) {
+                exit_block_list.push_back(
+                    SplitEdge(func, *graph.block_list[edge.first],
+                              graph.block_list[edge.second], next_id));
+            }
+        }
+
+        for (auto &word : word_list) {
+            auto slot = std::make_shared<ir::TmpVar>(ir::PtrType::Get(),
+                                                     next_id++);
+            graph.block_list[0]->GetInstList().push_front(
+                std::make_shared<ir::AllocaInst>(slot));
+            auto address = word.address;
+            if (word.gep != nullptr) {
+                address = std::make_shared<ir::TmpVar>(
+                    word.gep->GetResult().GetTypePtr(), next_id++);
+                InsertBeforeEnd(*preheader,
+                                std::make_shared<ir::GetelementptrInst>(
+                                    address, word.gep->GetPtrPtr(),
+                                    word.gep->GetIdxList()));
+            }
+            auto value = std::make_shared<ir::TmpVar>(next_id++);
+            InsertBeforeEnd(*preheader,
+                            std::make_shared<ir::LoadInst>(value, address));
+            InsertBeforeEnd(*preheader,
+                            std::make_shared<ir::StoreInst>(value, slot));
+
+            std::unordered_set<const ir::Inst *> access_set;
+            for (const auto &access : word.access_list) {
+                access_set.insert(access.inst);
+            }
+            for (int b : loop.block_list) {
+                for (auto &inst : graph.block_list[b]->GetInstList()) {
+                    if (access_set.count(inst.get()) == 0) continue;
+                    if (inst->kind == ir::Inst::kLoad) {
+                        inst = std::make_shared<ir::LoadInst>(
+                            std::static_pointer_cast<ir::Var>(
+                                inst->GetResultPtr()),
+                            slot);
+                    } else {
+                        inst = std::make_shared<ir::StoreInst>(
+                            inst->Cast<ir::StoreInst>().GetValuePtr(), slot);
+                    }
+                }
+            }
+            if (!word.stored) continue;
+            for (const auto &bb : exit_block_list) {
+                auto result = std::make_shared<ir::TmpVar>(next_id++);
+                InsertBeforeEnd(*bb,
+                                std::make_shared<ir::LoadInst>(result, slot));
+                InsertBeforeEnd(
+                    *bb, std::make_shared<ir::StoreInst>(result, address));
+            }
+        }
+        return static_cast<int>(word_list.size());
+    }
+    return 0;
+}
+
+}  // namespace
+
+void ScalarPromotion::Prepare(const ir::Module &module) {
+    mod_ref = std::make_unique<ModRefAnalysis>(module);
+}
+
+int ScalarPromotion::Run(ir::FuncDef &func) {
+    int count = 0;
+    for (int promoted; (promoted = PromoteLoop(func, mod_ref.get())) > 0;) {
+        count += promoted;
+        RemoveDeadCode(func);
+        Mem2Reg().Run(func);
+    }
+    return count;
+}
+
+}  // namespace opt
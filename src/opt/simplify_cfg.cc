@@ -0,0 +1,478 @@
+#include "opt/simplify_cfg.h"
+
+#include <iterator>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "ir/ir.h"
+#include "ir/type.h"
+#include "ir/value.h"
+
+namespace opt {
+
+namespace {
+
+using ValuePtr = std::shared_ptr<ir::Value>;
+
+std::string Label(const ir::BasicBlock &bb) { return bb.GetLabel().Str(); }
+
+// The blocks by label, with the edges of func computed afresh.
+struct Cfg {
+    std::unordered_map<std::string, ir::BasicBlock *> block_map;
+
+    explicit Cfg(ir::FuncDef &func) {
+        func.ComputeCFG();
+        for (const auto &bb : func.GetBlockList()) {
+            block_map[Label(*bb)] = bb.get();
+        }
+    }
+
+    ir::BasicBlock *GetBlock(const std::string &label) const {
+        return block_map.at(label);
+    }
+};
+
+bool IsPred(const ir::BasicBlock &pred, const ir::BasicBlock &bb) {
+    for (const auto *other : bb.GetPredecessorList()) {
+        if (other == &pred) return true;
+    }
+    return false;
+}
+
+std::vector<ir::PhiInst *> GetPhiList(ir::BasicBlock &bb) {
+    std::vector<ir::PhiInst *> phi_list;
+    for (const auto &inst : bb.GetInstList()) {
+        if (inst->kind != ir::Inst::kPhi) break;
+        phi_list.push_back(&inst->Cast<ir::PhiInst>());
+    }
+    return phi_list;
+}
+
+// the value phi takes on the edge from the block labeled pred
+ValuePtr GetIncoming(const ir::PhiInst &phi, const std::string &pred) {
+    for (const auto &value : phi.GetValueList()) {
+        if (value.label->Str() == pred) return value.value;
+    }
+    return nullptr;
+}
+
+// drop one entry for the edge from pred from each phi of bb
+void RemoveIncoming(ir::BasicBlock &bb, const std::string &pred) {
+    for (auto *phi : GetPhiList(bb)) {
+        auto &value_list = phi->GetValueList();
+        for (auto iter = value_list.begin(); iter != value_list.end(); ++iter) {
+            if (iter->label->Str() == pred) {
+                value_list.erase(iter);
+                break;
+            }
+        }
+    }
+}
+
+// the entries of the phis of bb for the edges from from now come from to
+void RenameIncoming(ir::BasicBlock &bb,
+                    const std::string &from,
+                    const ir::BasicBlock &to) {
+    for (auto *phi : GetPhiList(bb)) {
+        for (auto &value : phi->GetValueList()) {
+            if (value.label->Str() == from) value.label = to.GetLabelPtr();
+        }
+    }
+}
+
+// point the edges of pred into from at to
+void Retarget(ir::BasicBlock &pred,
+              const std::string &from,
+              const ir::BasicBlock &to) {
+    auto *br = GetBr(pred);
+    if (br->GetTrue().Str() == from) br->SetTrue(to.GetLabelPtr());
+    if (!br->HasDest() && br->GetFalse().Str() == from) {
+        br->SetFalse(to.GetLabelPtr());
+    }
+}
+
+bool IsSame(const ir::Value &lhs, const ir::Value &rhs) {
+    if (&lhs == &rhs) return true;
+    return lhs.kind == ir::Value::kImm && rhs.kind == ir::Value::kImm
+           && lhs.Cast<ir::Imm>().GetValue() == rhs.Cast<ir::Imm>().GetValue();
+}
+
+bool Compare(const ir::IcmpInst::CmpKind op, const int lhs, const int rhs) {
+    switch (op) {
+        case ir::IcmpInst::kEQ:
+            return lhs == rhs;
+        case ir::IcmpInst::kNE:
+            return lhs != rhs;
+        case ir::IcmpInst::kSGT:
+            return lhs > rhs;
+        case ir::IcmpInst::kSGE:
+            return lhs >= rhs;
+        case ir::IcmpInst::kSLT:
+            return lhs < rhs;
+        case ir::IcmpInst::kSLE:
+            return lhs <= rhs;
+        case ir::IcmpInst::kUGT:
+            return static_cast<unsigned>(lhs) > static_cast<unsigned>(rhs);
+        case ir::IcmpInst::kUGE:
+            return static_cast<unsigned>(lhs) >= static_cast<unsigned>(rhs);
+        case ir::IcmpInst::kULT:
+            return static_cast<unsigned>(lhs) < static_cast<unsigned>(rhs);
+        case ir::IcmpInst::kULE:
+            return static_cast<unsigned>(lhs) <= static_cast<unsigned>(rhs);
+    }
+    return false;
+}
+
+// br on a constant, or to one block both ways
+int FoldBranch(ir::FuncDef &func, const Cfg &cfg) {
+    int count = 0;
+    for (const auto &bb : func.GetBlockList()) {
+        auto *br = GetBr(*bb);
+        if (br == nullptr || br->HasDest()) continue;
+        const auto &cond = br->GetCond();
+        const auto if_true = br->GetTrue().Str();
+        const auto if_false = br->GetFalse().Str();
+        std::string keep;
+        if (if_true == if_false) {
+            keep = if_true;
+        } else if (cond.kind == ir::Value::kImm) {
+            keep = cond.Cast<ir::Imm>().GetValue() != 0 ? if_true : if_false;
+        } else {
+            continue;
+        }
+        // the other edge goes away, or one of the two parallel ones
+        RemoveIncoming(*cfg.GetBlock(keep == if_true ? if_false : if_true),
+                       Label(*bb));
+        bb->GetInstList().back()
+            = std::make_shared<ir::BrInst>(cfg.GetBlock(keep)->GetLabelPtr());
+        ++count;
+    }
+    return count;
+}
+
+// the blocks the entry does not reach, and the empty ones nothing reaches
+int RemoveUnreachable(ir::FuncDef &func, const Cfg &cfg) {
+    auto &block_list = func.GetBlockList();
+    auto *entry = block_list.front().get();
+    std::unordered_set<const ir::BasicBlock *> reached{entry};
+    std::vector<ir::BasicBlock *> worklist{entry};
+    while (!worklist.empty()) {
+        auto *bb = worklist.back();
+        worklist.pop_back();
+        for (const auto &label : GetSuccessorList(*bb)) {
+            auto *succ = cfg.GetBlock(label);
+            if (reached.insert(succ).second) {
+                worklist.push_back(succ);
+            }
+        }
+    }
+    int count = 0;
+    for (auto iter = block_list.begin(); iter != block_list.end();) {
+        const auto &bb = *iter;
+        if (reached.count(bb.get()) != 0) {
+            ++iter;
+            continue;
+        }
+        for (const auto &label : GetSuccessorList(*bb)) {
+            RemoveIncoming(*cfg.GetBlock(label), Label(*bb));
+        }
+        if (!bb->GetInstList().empty()) ++count;
+        iter = block_list.erase(iter);
+    }
+    return count;
+}
+
+// phis with one value on every edge, or themselves
+int RemoveTrivialPhi(ir::FuncDef &func) {
+    std::unordered_map<const ir::Value *, ValuePtr> replace_map;
+    auto resolve = [&replace_map](ValuePtr value) {
+        for (;;) {
+            auto iter = replace_map.find(value.get());
+            if (iter == replace_map.end()) return value;
+            value = iter->second;
+        }
+    };
+    for (bool changed = true; changed;) {
+        changed = false;
+        for (const auto &bb : func.GetBlockList()) {
+            for (auto *phi : GetPhiList(*bb)) {
+                const auto result = phi->GetResultPtr();
+                if (replace_map.count(result.get()) != 0) continue;
+                ValuePtr same;
+                bool trivial = true;
+                for (const auto &value : phi->GetValueList()) {
+                    auto resolved = resolve(value.value);
+                    if (resolved == result) continue;
+                    if (same == nullptr) {
+                        same = resolved;
+                    } else if (!IsSame(*same, *resolved)) {
+                        trivial = false;
+                        break;
+                    }
+                }
+                if (!trivial || same == nullptr) continue;
+                replace_map[result.get()] = same;
+                changed = true;
+            }
+        }
+    }
+    if (replace_map.empty()) return 0;
+
+    for (const auto &bb : func.GetBlockList()) {
+        auto &inst_list = bb->GetInstList();
+        for (auto iter = inst_list.begin(); iter != inst_list.end();) {
+            auto &inst = **iter;
+            if (inst.kind == ir::Inst::kPhi
+                && replace_map.count(inst.GetResultPtr().get()) != 0) {
+                iter = inst_list.erase(iter);
+                continue;
+            }
+            for (const auto &use : inst.GetUseList()) {
+                auto to = resolve(use);
+                if (to != use) inst.ReplaceUse(use, to);
+            }
+            ++iter;
+        }
+    }
+    return static_cast<int>(replace_map.size());
+}
+
+// The block changes below look at a block and its neighbors, all of which
+// must be untouched so far in the sweep since cfg is not updated.
+class Sweep {
+  public:
+    Sweep(ir::FuncDef &func, const Cfg &cfg) : func(func), cfg(cfg) {}
+
+    int Run() {
+        auto &block_list = func.GetBlockList();
+        for (auto iter = std::next(block_list.begin());
+             iter != block_list.end(); ++iter) {
+            auto &bb = **iter;
+            if (dirty.count(&bb) != 0 || removed.count(&bb) != 0) continue;
+            if (Thread(bb) || Forward(bb) || Merge(bb)) ++count;
+        }
+        for (auto iter = block_list.begin(); iter != block_list.end();) {
+            if (removed.count(iter->get()) != 0) {
+                iter = block_list.erase(iter);
+            } else {
+                ++iter;
+            }
+        }
+        return count;
+    }
+
+  private:
+    ir::FuncDef &func;
+    const Cfg &cfg;
+    std::unordered_set<const ir::BasicBlock *> dirty;
+    std::unordered_set<const ir::BasicBlock *> removed;
+    // filled on first use, nullptr marks it filled
+    std::unordered_set<const ir::Value *> escaped;
+    int count = 0;
+
+    bool IsClean(const std::vector<ir::BasicBlock *> &block_list) const {
+        for (const auto *bb : block_list) {
+            if (dirty.count(bb) != 0 || removed.count(bb) != 0) return false;
+        }
+        return true;
+    }
+    void Touch(const std::vector<ir::BasicBlock *> &block_list) {
+        for (const auto *bb : block_list) dirty.insert(bb);
+    }
+
+    // pred jumps to x instead of going through bb, which has no phis that
+    // x reads
+    void Bypass(ir::BasicBlock &pred,
+                ir::BasicBlock &bb,
+                ir::BasicBlock &x) const {
+        const auto label = Label(bb);
+        for (auto *phi : GetPhiList(x)) {
+            phi->GetValueList().emplace_back(GetIncoming(*phi, label),
+                                             pred.GetLabelPtr());
+        }
+        RemoveIncoming(bb, Label(pred));
+        Retarget(pred, label, x);
+    }
+
+    // a predecessor that knows where bb goes jumps there
+    bool Thread(ir::BasicBlock &bb) {
+        auto *br = GetBr(bb);
+        if (br == nullptr || br->HasDest()) return false;
+        const auto cond = br->GetCondPtr();
+        auto *if_true = cfg.GetBlock(br->GetTrue().Str());
+        auto *if_false = cfg.GetBlock(br->GetFalse().Str());
+        if (if_true == &bb || if_false == &bb) return false;
+
+        // bb is only phis, the compare of one of them to a constant and br,
+        // and none of them is read elsewhere
+        auto &inst_list = bb.GetInstList();
+        const ir::IcmpInst *cmp = nullptr;
+        const ir::PhiInst *phi = nullptr;
+        const auto phi_list = GetPhiList(bb);
+        if (inst_list.size() == phi_list.size() + 2) {
+            const auto &inst = **std::prev(inst_list.end(), 2);
+            if (inst.kind != ir::Inst::kIcmp || inst.GetResultPtr() != cond) {
+                return false;
+            }
+            cmp = &inst.Cast<ir::IcmpInst>();
+            for (const auto *other : phi_list) {
+                if (&cmp->GetLHS() == other->GetResultPtr().get()
+                    && cmp->GetRHS().kind == ir::Value::kImm) {
+                    phi = other;
+                }
+            }
+            if (phi == nullptr || !IsLocal(bb)) return false;
+        } else if (inst_list.size() != 1) {
+            return false;
+        }
+
+        if (!IsClean({&bb})) return false;
+        bool threaded = false;
+        for (auto *pred : bb.GetPredecessorList()) {
+            ir::BasicBlock *x = nullptr;
+            if (cmp != nullptr) {
+                auto value = GetIncoming(*phi, Label(*pred));
+                if (value->kind != ir::Value::kImm) continue;
+                const bool taken
+                    = Compare(cmp->op_code, value->Cast<ir::Imm>().GetValue(),
+                              cmp->GetRHS().Cast<ir::Imm>().GetValue());
+                x = taken ? if_true : if_false;
+            } else {
+                auto *pred_br = GetBr(*pred);
+                if (pred_br->HasDest() || pred_br->GetCondPtr() != cond) {
+                    continue;
+                }
+                const bool on_true = pred_br->GetTrue().Str() == Label(bb);
+                const bool on_false = pred_br->GetFalse().Str() == Label(bb);
+                if (on_true == on_false) continue;
+                x = on_true ? if_true : if_false;
+            }
+            if (!IsClean({pred, x})) continue;
+            if (!GetPhiList(*x).empty() && IsPred(*pred, *x)) continue;
+            Bypass(*pred, bb, *x);
+            Touch({pred, x});
+            threaded = true;
+        }
+        if (threaded) Touch({&bb});
+        return threaded;
+    }
+
+    // what bb defines is read in bb only
+    bool IsLocal(ir::BasicBlock &bb) {
+        if (escaped.empty()) FindEscaped();
+        for (const auto &inst : bb.GetInstList()) {
+            auto result = inst->GetResultPtr();
+            if (result != nullptr && escaped.count(result.get()) != 0) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // the values read outside the block that defines them
+    void FindEscaped() {
+        std::unordered_map<const ir::Value *, const ir::BasicBlock *> def_map;
+        for (const auto &bb : func.GetBlockList()) {
+            for (const auto &inst : bb->GetInstList()) {
+                if (auto result = inst->GetResultPtr()) {
+                    def_map[result.get()] = bb.get();
+                }
+            }
+        }
+        escaped.insert(nullptr);
+        for (const auto &bb : func.GetBlockList()) {
+            for (const auto &inst : bb->GetInstList()) {
+                for (const auto &use : inst->GetUseList()) {
+                    auto iter = def_map.find(use.get());
+                    if (iter != def_map.end() && iter->second != bb.get()) {
+                        escaped.insert(use.get());
+                    }
+                }
+            }
+        }
+    }
+
+    // the predecessors of a block that only jumps on go straight on
+    bool Forward(ir::BasicBlock &bb) {
+        auto &inst_list = bb.GetInstList();
+        if (inst_list.size() != 1) return false;
+        auto *br = GetBr(bb);
+        if (br == nullptr || !br->HasDest()) return false;
+        auto *target = cfg.GetBlock(br->GetDest().Str());
+        if (target == &bb) return false;
+        const auto &pred_list = bb.GetPredecessorList();
+        if (pred_list.empty()) return false;
+
+        std::vector<ir::BasicBlock *> involved(pred_list.begin(),
+                                               pred_list.end());
+        involved.push_back(target);
+        involved.push_back(&bb);
+        if (!IsClean(involved)) return false;
+        const bool has_phi = !GetPhiList(*target).empty();
+        for (const auto *pred : pred_list) {
+            if (has_phi && IsPred(*pred, *target)) return false;
+        }
+
+        const auto label = Label(bb);
+        for (auto *phi : GetPhiList(*target)) {
+            auto value = GetIncoming(*phi, label);
+            for (const auto *pred : pred_list) {
+                phi->GetValueList().emplace_back(value, pred->GetLabelPtr());
+            }
+        }
+        RemoveIncoming(*target, label);
+        for (auto *pred : pred_list) Retarget(*pred, label, *target);
+        Touch(involved);
+        removed.insert(&bb);
+        return true;
+    }
+
+    // a block whose only predecessor jumps to it joins that predecessor
+    bool Merge(ir::BasicBlock &bb) {
+        const auto &pred_list = bb.GetPredecessorList();
+        if (pred_list.size() != 1 || pred_list.front() == &bb
+            || !GetPhiList(bb).empty()) {
+            return false;
+        }
+        auto *pred = pred_list.front();
+        auto *br = GetBr(*pred);
+        if (!br->HasDest()) return false;
+        std::vector<ir::BasicBlock *> involved{pred, &bb};
+        for (const auto &label : GetSuccessorList(bb)) {
+            involved.push_back(cfg.GetBlock(label));
+        }
+        if (!IsClean(involved)) return false;
+
+        auto &pred_inst_list = pred->GetInstList();
+        pred_inst_list.pop_back();
+        pred_inst_list.splice(pred_inst_list.end(), bb.GetInstList());
+        for (const auto &label : GetSuccessorList(*pred)) {
+            RenameIncoming(*cfg.GetBlock(label), Label(bb), *pred);
+        }
+        Touch(involved);
+        removed.insert(&bb);
+        return true;
+    }
+};
+
+}  // namespace
+
+int SimplifyCFG::Run(ir::FuncDef &func) {
+    if (func.GetBlockList().empty()) return 0;
+    int count = 0;
+    for (;;) {
+        int changed = FoldBranch(func, Cfg(func));
+        changed += RemoveUnreachable(func, Cfg(func));
+        changed += RemoveTrivialPhi(func);
+        changed += Sweep(func, Cfg(func)).Run();
+        if (changed == 0) break;
+        count += changed;
+    }
+    if (count != 0) func.Renumber();
+    return count;
+}
+
+}  // namespace opt
@@ -0,0 +1,515 @@
+#include "opt/slp_vectorize.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <list>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "ir/ir.h"
+#include "ir/type.h"
+#include "ir/value.h"
+#include "opt/alias_analysis.h"
+#include "opt/mod_ref.h"
+
+namespace opt {
+
+namespace {
+
+using ValuePtr = std::shared_ptr<ir::Value>;
+using LaneList = std::vector<ValuePtr>;
+// what reads each value of a function, by name
+using UserMap = std::unordered_map<std::string, std::vector<const ir::Inst *>>;
+
+constexpr int kLaneNum = 4;
+// the vectors of a tree at most, they may all be live at once in the q
+// registers the backend hands out
+constexpr int kMaxNode = 12;
+
+bool IsVector(const ir::Value &value) {
+    return value.GetType().kind == ir::Type::kVector;
+}
+
+// the object and the values a location moves with, the words of one key
+// differ by their offsets alone
+std::string Key(const Location &location) {
+    std::string key = std::to_string(location.kind) + ':' + location.object;
+    for (const auto &[name, coefficient] : location.term_map) {
+        key += ' ' + name + '*' + std::to_string(coefficient);
+    }
+    return key;
+}
+
+// a vector of the tree, the seed the first
+struct Node {
+    enum NodeKind { kOp, kLoad, kSplat, kGather };
+    NodeKind kind;
+    LaneList lane_list;
+    // by lane, the scalars a kOp or a kLoad packs
+    std::vector<const ir::Inst *> inst_list;
+    ir::BinaryOpInst::BinaryOpKind op_code = ir::BinaryOpInst::kAdd;
+    int lhs = -1;
+    int rhs = -1;
+};
+
+// Vectorizes the seeds of a block, keeping user_map up to date. A seed
+// whose loads and stores would move past the vector code of another is
+// left for the next round.
+class Packer {
+  public:
+    Packer(ir::BasicBlock &bb,
+           const AliasAnalysis &alias_analysis,
+           UserMap &user_map,
+           int &next_id)
+        : bb(bb),
+          alias_analysis(alias_analysis),
+          user_map(user_map),
+          next_id(next_id) {
+        for (const auto &inst : bb.GetInstList()) {
+            pos_map[inst.get()] = static_cast<int>(order.size());
+            order.push_back(inst.get());
+            if (auto result = inst->GetResultPtr()) {
+                def_map[result->Str()] = inst.get();
+            }
+        }
+    }
+
+    // return the number of seeds vectorized
+    int Run() {
+        // the stores of each key by offset, none where two hit one word
+        std::map<std::string, std::map<std::int64_t, const ir::Inst *>>
+            group_map;
+        std::unordered_set<std::string> clash_set;
+        for (const auto *inst : order) {
+            if (inst->kind != ir::Inst::kStore) continue;
+            const auto &store = inst->Cast<ir::StoreInst>();
+            if (store.GetValue().GetType().kind != ir::Type::kInt) continue;
+            const auto location = alias_analysis.GetLocation(store.GetPtr());
+            if (location.kind == Location::kUnknown) continue;
+            const auto key = Key(location);
+            if (!group_map[key].emplace(location.offset, inst).second) {
+                clash_set.insert(key);
+            }
+        }
+        int count = 0;
+        for (const auto &[key, group] : group_map) {
+            if (clash_set.count(key) != 0) continue;
+            for (auto iter = group.begin(); iter != group.end();) {
+                std::vector<const ir::Inst *> store_list;
+                for (int lane = 0; lane < kLaneNum; ++lane) {
+                    const auto next = group.find(iter->first + lane);
+                    if (next == group.end()) break;
+                    store_list.push_back(next->second);
+                }
+                if (store_list.size() == kLaneNum && Pack(store_list)) {
+                    ++count;
+                }
+                std::advance(iter, store_list.size());
+            }
+        }
+        return count;
+    }
+
+  private:
+    ir::BasicBlock &bb;
+    const AliasAnalysis &alias_analysis;
+    UserMap &user_map;
+    int &next_id;
+
+    // what bb defines, by name, and its instructions as they were
+    std::unordered_map<std::string, const ir::Inst *> def_map;
+    std::vector<const ir::Inst *> order;
+    std::unordered_map<const ir::Inst *, int> pos_map;
+    // the instructions erased since, kept alive for order and def_map
+    std::vector<std::shared_ptr<ir::Inst>> gone_list;
+    std::unordered_set<const ir::Inst *> gone;
+    // where the vector code of each seed packed went, before the position
+    // of the last store of it
+    std::vector<int> packed_list;
+
+    // the stores of the seed by lane, and the tree of the values they store
+    std::vector<const ir::Inst *> seed;
+    std::vector<Node> node_list;
+    // the scalars the tree packs
+    std::unordered_set<const ir::Inst *> claimed;
+    // the scalars nothing reads once the tree is in
+    std::unordered_set<const ir::Inst *> removed;
+
+    bool Pack(const std::vector<const ir::Inst *> &store_list) {
+        seed = store_list;
+        node_list.clear();
+        claimed = {seed.begin(), seed.end()};
+        LaneList lane_list;
+        for (const auto *store : seed) {
+            lane_list.push_back(store->Cast<ir::StoreInst>().GetValuePtr());
+        }
+        if (Build(lane_list) < 0 || !IsLegal() || !IsProfitable()) {
+            return false;
+        }
+        Emit();
+        return true;
+    }
+
+    // the instructions of kind in bb defining the lanes, none claimed, or
+    // nothing
+    std::vector<const ir::Inst *> Defs(const LaneList &lane_list,
+                                       const ir::Inst::InstKind kind) const {
+        std::vector<const ir::Inst *> inst_list;
+        for (const auto &lane : lane_list) {
+            const auto def = def_map.find(lane->Str());
+            if (def == def_map.end() || gone.count(def->second) != 0
+                || def->second->kind != kind
+                || claimed.count(def->second) != 0
+                || std::find(inst_list.begin(), inst_list.end(), def->second)
+                       != inst_list.end()) {
+                return {};
+            }
+            inst_list.push_back(def->second);
+        }
+        return inst_list;
+    }
+
+    // if a and b look alike enough to be on the lanes of one vector
+    bool IsAlike(const ValuePtr &a, const ValuePtr &b) const {
+        const auto a_def = def_map.find(a->Str());
+        const auto b_def = def_map.find(b->Str());
+        if (a_def == def_map.end() || b_def == def_map.end()) {
+            return a_def == b_def
+                   && (a->Str() == b->Str()
+                       || (a->kind == ir::Value::kImm
+                           && b->kind == ir::Value::kImm));
+        }
+        const auto &a_inst = *a_def->second;
+        const auto &b_inst = *b_def->second;
+        if (a_inst.kind != b_inst.kind) return false;
+        switch (a_inst.kind) {
+            case ir::Inst::kBinaryOp:
+                return a_inst.Cast<ir::BinaryOpInst>().op_code
+                       == b_inst.Cast<ir::BinaryOpInst>().op_code;
+            case ir::Inst::kLoad:
+                return Key(alias_analysis.GetLocation(
+                           a_inst.Cast<ir::LoadInst>().GetPtr()))
+                       == Key(alias_analysis.GetLocation(
+                           b_inst.Cast<ir::LoadInst>().GetPtr()));
+            default:
+                return false;
+        }
+    }
+
+    // the node of lane_list, -1 if the tree grows too large
+    int Build(const LaneList &lane_list) {
+        if (node_list.size() >= kMaxNode) return -1;
+        const int id = static_cast<int>(node_list.size());
+        node_list.push_back({Node::kGather, lane_list});
+        if (std::all_of(lane_list.begin(), lane_list.end(),
+                        [&lane_list](const ValuePtr &lane) {
+                            return lane->Str() == lane_list[0]->Str();
+                        })) {
+            node_list[id].kind = Node::kSplat;
+            return id;
+        }
+
+        auto inst_list = Defs(lane_list, ir::Inst::kLoad);
+        if (!inst_list.empty() && IsConsecutive(inst_list)) {
+            claimed.insert(inst_list.begin(), inst_list.end());
+            node_list[id].kind = Node::kLoad;
+            node_list[id].inst_list = std::move(inst_list);
+            return id;
+        }
+
+        inst_list = Defs(lane_list, ir::Inst::kBinaryOp);
+        if (inst_list.empty()) return id;
+        const auto op_code = inst_list[0]->Cast<ir::BinaryOpInst>().op_code;
+        if ((op_code != ir::BinaryOpInst::kAdd
+             && op_code != ir::BinaryOpInst::kSub
+             && op_code != ir::BinaryOpInst::kMul)
+            || std::any_of(inst_list.begin(), inst_list.end(),
+                           [op_code](const ir::Inst *inst) {
+                               return inst->Cast<ir::BinaryOpInst>().op_code
+                                      != op_code;
+                           })) {
+            return id;
+        }
+        claimed.insert(inst_list.begin(), inst_list.end());
+        LaneList lhs;
+        LaneList rhs;
+        for (const auto *inst : inst_list) {
+            lhs.push_back(inst->GetUseList()[0]);
+            rhs.push_back(inst->GetUseList()[1]);
+        }
+        // the operands of add and mul go to the side they look alike
+        if (op_code != ir::BinaryOpInst::kSub) {
+            for (int lane = 1; lane < kLaneNum; ++lane) {
+                if (!IsAlike(lhs[0], lhs[lane])
+                    && IsAlike(lhs[0], rhs[lane])) {
+                    std::swap(lhs[lane], rhs[lane]);
+                }
+            }
+        }
+        node_list[id].kind = Node::kOp;
+        node_list[id].inst_list = std::move(inst_list);
+        node_list[id].op_code = op_code;
+        const int lhs_id = Build(lhs);
+        if (lhs_id < 0) return -1;
+        node_list[id].lhs = lhs_id;
+        const int rhs_id = Build(rhs);
+        if (rhs_id < 0) return -1;
+        node_list[id].rhs = rhs_id;
+        return id;
+    }
+
+    // the store of the seed the vector one takes the place of
+    const ir::Inst *Last() const {
+        return *std::max_element(
+            seed.begin(), seed.end(),
+            [this](const ir::Inst *lhs, const ir::Inst *rhs) {
+                return pos_map.at(lhs) < pos_map.at(rhs);
+            });
+    }
+
+    // if the loads read consecutive words by lane
+    bool IsConsecutive(const std::vector<const ir::Inst *> &inst_list) const {
+        const auto first = alias_analysis.GetLocation(
+            inst_list[0]->Cast<ir::LoadInst>().GetPtr());
+        if (first.kind == Location::kUnknown) return false;
+        for (int lane = 1; lane < kLaneNum; ++lane) {
+            const auto location = alias_analysis.GetLocation(
+                inst_list[lane]->Cast<ir::LoadInst>().GetPtr());
+            if (Key(location) != Key(first)
+                || location.offset != first.offset + lane) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // The loads and stores of the tree move to the last store of the seed.
+    // Nothing between may write what a load reads, or touch what a store
+    // writes; a load of the tree after a store of the seed must not read
+    // what it writes either. The vector code of a seed packed before is
+    // not in order, the moves must not cross it.
+    bool IsLegal() const {
+        const int last = pos_map.at(Last());
+        std::vector<const ir::Inst *> access_list(seed.begin(), seed.end());
+        for (const auto &node : node_list) {
+            if (node.kind != Node::kLoad) continue;
+            access_list.insert(access_list.end(), node.inst_list.begin(),
+                               node.inst_list.end());
+        }
+        for (const auto *access : access_list) {
+            const bool is_store = access->kind == ir::Inst::kStore;
+            const auto &ptr = is_store
+                                  ? access->Cast<ir::StoreInst>().GetPtr()
+                                  : access->Cast<ir::LoadInst>().GetPtr();
+            const int first = pos_map.at(access);
+            if (std::any_of(packed_list.begin(), packed_list.end(),
+                            [first, last](const int pos) {
+                                return first < pos && pos < last;
+                            })) {
+                return false;
+            }
+            for (int i = first + 1; i < last; ++i) {
+                if (gone.count(order[i]) != 0) continue;
+                const auto &inst = *order[i];
+                if (inst.kind != ir::Inst::kLoad
+                    && inst.kind != ir::Inst::kStore
+                    && inst.kind != ir::Inst::kCall) {
+                    continue;
+                }
+                if (claimed.count(&inst) != 0) {
+                    if (is_store && inst.kind == ir::Inst::kLoad
+                        && alias_analysis.Alias(
+                               inst.Cast<ir::LoadInst>().GetPtr(), ptr)
+                               != AliasAnalysis::kNoAlias) {
+                        return false;
+                    }
+                    continue;
+                }
+                // a vector touches more words than its pointer tells
+                const bool is_vector
+                    = (inst.kind == ir::Inst::kLoad
+                       && IsVector(inst.Cast<ir::LoadInst>().GetResult()))
+                      || (inst.kind == ir::Inst::kStore
+                          && IsVector(inst.Cast<ir::StoreInst>().GetValue()));
+                const auto mod_ref = alias_analysis.GetModRef(inst, ptr);
+                if (is_vector
+                    || (is_store ? mod_ref != AliasAnalysis::kNoModRef
+                                 : (mod_ref & AliasAnalysis::kMod) != 0)) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    // A vector instruction costs one, a vector packed from scalars one a
+    // lane, and one more a constant that the scalars took as an operand
+    // must be moved to a register first. The scalars saved are the stores
+    // of the seed and what only the tree reads, a node before the nodes
+    // below it.
+    bool IsProfitable() {
+        removed = {seed.begin(), seed.end()};
+        int scalar_cost = kLaneNum;
+        int vector_cost = 1;
+        for (const auto &node : node_list) {
+            switch (node.kind) {
+                case Node::kSplat:
+                    vector_cost += PackCost(*node.lane_list[0]);
+                    break;
+                case Node::kGather:
+                    for (const auto &lane : node.lane_list) {
+                        vector_cost += PackCost(*lane);
+                    }
+                    break;
+                default:
+                    ++vector_cost;
+            }
+            for (const auto *inst : node.inst_list) {
+                const auto &user_list = user_map[inst->GetResultPtr()->Str()];
+                if (std::all_of(user_list.begin(), user_list.end(),
+                                [this](const ir::Inst *user) {
+                                    return removed.count(user) != 0;
+                                })) {
+                    removed.insert(inst);
+                    ++scalar_cost;
+                }
+            }
+        }
+        return vector_cost < scalar_cost;
+    }
+
+    static int PackCost(const ir::Value &value) {
+        return value.kind == ir::Value::kImm ? 2 : 1;
+    }
+
+    // the tree before the last store of the seed, then the scalars gone
+    void Emit() {
+        auto &inst_list = bb.GetInstList();
+        const auto *last = Last();
+        packed_list.push_back(pos_map.at(last));
+        const auto at = std::find_if(
+            inst_list.begin(), inst_list.end(),
+            [last](const std::shared_ptr<ir::Inst> &inst) {
+                return inst.get() == last;
+            });
+        const bool at_begin = at == inst_list.begin();
+        const auto before = at_begin ? at : std::prev(at);
+        auto vector = EmitNode(0, at);
+        auto ptr = VectorPtr(seed[0]->Cast<ir::StoreInst>().GetPtrPtr(), at);
+        inst_list.insert(at, std::make_shared<ir::StoreInst>(vector, ptr));
+        for (auto iter = at_begin ? inst_list.begin() : std::next(before);
+             iter != at; ++iter) {
+            for (const auto &use : (*iter)->GetUseList()) {
+                user_map[use->Str()].push_back(iter->get());
+            }
+        }
+        for (auto iter = inst_list.begin(); iter != inst_list.end();) {
+            if (removed.count(iter->get()) == 0) {
+                ++iter;
+                continue;
+            }
+            for (const auto &use : (*iter)->GetUseList()) {
+                auto &user_list = user_map[use->Str()];
+                user_list.erase(std::remove(user_list.begin(),
+                                            user_list.end(), iter->get()),
+                                user_list.end());
+            }
+            gone.insert(iter->get());
+            gone_list.push_back(*iter);
+            iter = inst_list.erase(iter);
+        }
+    }
+
+    using Iterator = std::list<std::shared_ptr<ir::Inst>>::iterator;
+
+    std::shared_ptr<ir::TmpVar> EmitNode(const int id, const Iterator &at) {
+        auto &inst_list = bb.GetInstList();
+        const auto &node = node_list[id];
+        switch (node.kind) {
+            case Node::kOp: {
+                auto lhs = EmitNode(node.lhs, at);
+                auto rhs = EmitNode(node.rhs, at);
+                auto result = NewVector();
+                inst_list.insert(at, std::make_shared<ir::BinaryOpInst>(
+                                         node.op_code, result, lhs, rhs));
+                return result;
+            }
+            case Node::kLoad: {
+                auto ptr = VectorPtr(
+                    node.inst_list[0]->Cast<ir::LoadInst>().GetPtrPtr(), at);
+                auto result = NewVector();
+                inst_list.insert(at,
+                                 std::make_shared<ir::LoadInst>(result, ptr));
+                return result;
+            }
+            default: {
+                std::shared_ptr<ir::TmpVar> vector;
+                for (int lane = 0; lane < kLaneNum; ++lane) {
+                    auto next = NewVector();
+                    inst_list.insert(
+                        at, std::make_shared<ir::InsertElementInst>(
+                                next, vector,
+                                node.lane_list[node.kind == Node::kSplat
+                                                   ? 0
+                                                   : lane],
+                                lane));
+                    vector = next;
+                }
+                return vector;
+            }
+        }
+    }
+
+    // ptr as a pointer to <4 x i32>
+    std::shared_ptr<ir::TmpVar> VectorPtr(const ValuePtr &ptr,
+                                          const Iterator &at) {
+        auto result = std::make_shared<ir::TmpVar>(
+            std::make_shared<ir::PtrType>(ir::VectorType::Get()), next_id++);
+        bb.GetInstList().insert(
+            at, std::make_shared<ir::BitcastInst>(
+                    result, std::static_pointer_cast<ir::Var>(ptr)));
+        return result;
+    }
+
+    std::shared_ptr<ir::TmpVar> NewVector() {
+        return std::make_shared<ir::TmpVar>(ir::VectorType::Get(), next_id++);
+    }
+};
+
+}  // namespace
+
+void SLPVectorize::Prepare(const ir::Module &module) {
+    mod_ref = std::make_unique<ModRefAnalysis>(module);
+}
+
+int SLPVectorize::Run(ir::FuncDef &func) {
+    int next_id = func.Renumber();
+    int count = 0;
+    // the analyses see the vector code of a round as nothing, the seeds
+    // left over are tried again in the next
+    for (int packed = 1; packed > 0; count += packed) {
+        packed = 0;
+        const AliasAnalysis alias_analysis(func, false, mod_ref.get());
+        UserMap user_map;
+        for (const auto &bb : func.GetBlockList()) {
+            for (const auto &inst : bb->GetInstList()) {
+                for (const auto &use : inst->GetUseList()) {
+                    user_map[use->Str()].push_back(inst.get());
+                }
+            }
+        }
+        for (const auto &bb : func.GetBlockList()) {
+            packed += Packer(*bb, alias_analysis, user_map, next_id).Run();
+        }
+    }
+    if (count > 0) func.Renumber();
+    return count;
+}
+
+}  // namespace opt
@@ -0,0 +1,509 @@
+#include "opt/strength_reduction.h"
+
+#include <climits>
+#include <iterator>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+
+#include "ir/ir.h"
+#include "ir/type.h"
+#include "ir/value.h"
+#include "opt/numbering.h"
+
+namespace opt {
+
+namespace {
+
+using InstList = std::list<std::shared_ptr<ir::Inst>>;
+using ValuePtr = std::shared_ptr<ir::Value>;
+
+// the largest power of two an i32 holds
+constexpr int kMaxExp = 30;
+
+// return k if value is 2^k, or -1
+int Log2(const int value) {
+    if (value <= 0 || (value & (value - 1)) != 0) return -1;
+    int k = 0;
+    while ((1 << k) != value) ++k;
+    return k;
+}
+
+ValuePtr Imm(const int value) { return std::make_shared<ir::Imm>(value); }
+
+// the value doubled by the definition inst, or nullptr
+const ir::Value *Doubled(const ir::Inst *inst) {
+    if (inst == nullptr || inst->kind != ir::Inst::kBinaryOp) return nullptr;
+    const auto &op = inst->Cast<ir::BinaryOpInst>();
+    auto is_imm = [](const ir::Value &value, const int imm) {
+        return value.kind == ir::Value::kImm
+               && value.Cast<ir::Imm>().GetValue() == imm;
+    };
+    switch (op.op_code) {
+        case ir::BinaryOpInst::kMul:
+            if (is_imm(op.GetRHS(), 2)) return &op.GetLHS();
+            if (is_imm(op.GetLHS(), 2)) return &op.GetRHS();
+            return nullptr;
+        case ir::BinaryOpInst::kShl:
+            return is_imm(op.GetRHS(), 1) ? &op.GetLHS() : nullptr;
+        case ir::BinaryOpInst::kAdd:
+            return op.GetLHS().Str() == op.GetRHS().Str() ? &op.GetLHS()
+                                                          : nullptr;
+        default:
+            return nullptr;
+    }
+}
+
+// What is known about the powers of two the function builds.
+class PowerFacts {
+  public:
+    explicit PowerFacts(ir::FuncDef &func);
+
+    // the exponent of value if it is loaded from a table of powers of two
+    ValuePtr GetExponent(const ir::Value &value) const;
+    // value holds a power of two, or zero
+    bool IsPowerOrZero(const ir::Value &value) const;
+    bool IsNonNegative(const ir::Value &value, int depth = 0) const;
+
+    // Give each doubling scalar that is divided by a shadow variable holding
+    // its exponent, kept in step by each load and store of the scalar.
+    void TrackExponents(ir::FuncDef &func);
+
+  private:
+    struct Element {
+        std::string table;
+        ValuePtr idx;
+    };
+
+    // the definitions as they were before any rewrite
+    std::unordered_map<std::string, std::shared_ptr<ir::Inst>> def_map;
+    std::unordered_map<std::string, Element> element_map;  // by gep
+    std::unordered_set<std::string> table_set;
+    std::unordered_set<std::string> doubling_set;  // scalars
+    // the exponent loaded along with each load of a tracked scalar
+    std::unordered_map<std::string, ValuePtr> exp_map;
+
+    const ir::Inst *GetDef(const ir::Value &value) const {
+        auto iter = def_map.find(value.Str());
+        return iter == def_map.end() ? nullptr : iter->second.get();
+    }
+    // the load from a table or a doubling scalar defining value
+    const ir::Value *GetLoadPtr(const ir::Value &value) const {
+        const auto *def = GetDef(value);
+        if (def == nullptr || def->kind != ir::Inst::kLoad) return nullptr;
+        return &def->Cast<ir::LoadInst>().GetPtr();
+    }
+};
+
+PowerFacts::PowerFacts(ir::FuncDef &func) {
+    const auto alloca_set = GetAllocaSet(func);
+    std::unordered_map<std::string, std::string> bitcast_map;
+    for (const auto &bb : func.GetBlockList()) {
+        for (const auto &inst : bb->GetInstList()) {
+            auto result = inst->GetResultPtr();
+            if (result != nullptr) def_map[result->Str()] = inst;
+            if (inst->kind != ir::Inst::kAlloca) continue;
+            if (IsScalar(*result, alloca_set)) {
+                doubling_set.insert(result->Str());
+                continue;
+            }
+            // i32 t[n] with every element small enough
+            const auto &pointee
+                = result->GetType().Cast<ir::PtrType>().GetPointee();
+            if (pointee.kind != ir::Type::kArray) continue;
+            const auto &dim_list
+                = pointee.Cast<ir::ArrayType>().GetArrDimList();
+            if (dim_list.size() == 1 && dim_list[0] <= kMaxExp + 1) {
+                table_set.insert(result->Str());
+            }
+        }
+    }
+
+    // t[i] is either gep t, 0, i or gep (bitcast t), i
+    for (const auto &bb : func.GetBlockList()) {
+        for (const auto &inst : bb->GetInstList()) {
+            const auto use_list = inst->GetUseList();
+            if (inst->kind == ir::Inst::kBitcast
+                && table_set.count(use_list[0]->Str()) != 0) {
+                bitcast_map[inst->GetResultPtr()->Str()] = use_list[0]->Str();
+            }
+            if (inst->kind != ir::Inst::kGetelementptr) continue;
+            const auto &base = use_list[0]->Str();
+            const auto &first = *use_list[1];
+            if (use_list.size() == 3 && table_set.count(base) != 0
+                && first.kind == ir::Value::kImm
+                && first.Cast<ir::Imm>().GetValue() == 0) {
+                element_map[inst->GetResultPtr()->Str()] = {base, use_list[2]};
+            } else if (use_list.size() == 2 && bitcast_map.count(base) != 0) {
+                element_map[inst->GetResultPtr()->Str()]
+                    = {bitcast_map[base], use_list[1]};
+            }
+        }
+    }
+
+    // the addresses must not be used in any other way
+    for (const auto &bb : func.GetBlockList()) {
+        for (const auto &inst : bb->GetInstList()) {
+            const auto use_list = inst->GetUseList();
+            for (std::size_t i = 0; i < use_list.size(); ++i) {
+                const auto &name = use_list[i]->Str();
+                const bool is_ptr
+                    = (inst->kind == ir::Inst::kLoad && i == 0)
+                      || (inst->kind == ir::Inst::kStore && i == 1);
+                if (doubling_set.count(name) != 0 && !is_ptr) {
+                    doubling_set.erase(name);
+                }
+                auto result = inst->GetResultPtr();
+                if (table_set.count(name) != 0
+                    && (result == nullptr
+                        || (bitcast_map.count(result->Str()) == 0
+                            && element_map.count(result->Str()) == 0))) {
+                    table_set.erase(name);
+                }
+                auto bitcast = bitcast_map.find(name);
+                if (bitcast != bitcast_map.end()
+                    && (result == nullptr
+                        || element_map.count(result->Str()) == 0)) {
+                    table_set.erase(bitcast->second);
+                }
+                auto element = element_map.find(name);
+                if (element != element_map.end() && !is_ptr) {
+                    table_set.erase(element->second.table);
+                }
+            }
+        }
+    }
+
+    // what is stored: a power of two or zero into a scalar, and 2^i or zero
+    // into t[i], where 2^i is often t[i - 1] * 2
+    for (const auto &bb : func.GetBlockList()) {
+        Numbering numbering(alloca_set);
+        std::unordered_set<std::string> seen;
+        for (const auto &inst : bb->GetInstList()) {
+            if (inst->kind == ir::Inst::kStore) {
+                const auto use_list = inst->GetUseList();
+                const auto &value = *use_list[0];
+                const auto &ptr = use_list[1]->Str();
+                const int imm = value.kind == ir::Value::kImm
+                                    ? value.Cast<ir::Imm>().GetValue()
+                                    : -1;
+                const auto *doubled = Doubled(GetDef(value));
+                const auto *doubled_ptr
+                    = doubled != nullptr ? GetLoadPtr(*doubled) : nullptr;
+
+                if (doubling_set.count(ptr) != 0 && imm != 0 && Log2(imm) < 0
+                    && (doubled_ptr == nullptr
+                        || doubled_ptr->Str() != ptr)) {
+                    doubling_set.erase(ptr);
+                }
+
+                auto element = element_map.find(ptr);
+                if (element != element_map.end()) {
+                    const auto &table = element->second.table;
+                    const auto idx = numbering.Linear(*element->second.idx);
+                    bool ok = imm == 0
+                              || (idx.first.empty() && 0 <= idx.second
+                                  && idx.second <= kMaxExp
+                                  && imm == 1 << idx.second);
+                    if (!ok && doubled_ptr != nullptr
+                        && seen.count(doubled->Str()) != 0) {
+                        auto from = element_map.find(doubled_ptr->Str());
+                        if (from != element_map.end()
+                            && from->second.table == table) {
+                            auto from_idx
+                                = numbering.Linear(*from->second.idx);
+                            ok = from_idx.first == idx.first
+                                 && from_idx.second
+                                        == static_cast<int>(
+                                            static_cast<unsigned>(idx.second)
+                                            - 1);
+                        }
+                    }
+                    if (!ok) table_set.erase(table);
+                }
+            }
+            numbering.Visit(*inst);
+            if (auto result = inst->GetResultPtr()) seen.insert(result->Str());
+        }
+    }
+}
+
+ValuePtr PowerFacts::GetExponent(const ir::Value &value) const {
+    auto exp = exp_map.find(value.Str());
+    if (exp != exp_map.end()) return exp->second;
+    const auto *ptr = GetLoadPtr(value);
+    if (ptr == nullptr) return nullptr;
+    auto element = element_map.find(ptr->Str());
+    if (element == element_map.end()
+        || table_set.count(element->second.table) == 0) {
+        return nullptr;
+    }
+    return element->second.idx;
+}
+
+bool PowerFacts::IsPowerOrZero(const ir::Value &value) const {
+    if (GetExponent(value) != nullptr) return true;
+    const auto *ptr = GetLoadPtr(value);
+    return ptr != nullptr && doubling_set.count(ptr->Str()) != 0;
+}
+
+void PowerFacts::TrackExponents(ir::FuncDef &func) {
+    // the scalars divided by
+    std::unordered_map<std::string, std::shared_ptr<ir::Var>> shadow_map;
+    for (const auto &bb : func.GetBlockList()) {
+        for (const auto &inst : bb->GetInstList()) {
+            if (inst->kind != ir::Inst::kBinaryOp
+                || inst->Cast<ir::BinaryOpInst>().op_code
+                       != ir::BinaryOpInst::kSDiv) {
+                continue;
+            }
+            const auto *ptr = GetLoadPtr(*inst->GetUseList()[1]);
+            if (ptr != nullptr && doubling_set.count(ptr->Str()) != 0
+                && shadow_map.count(ptr->Str()) == 0) {
+                auto shadow = std::make_shared<ir::TmpVar>(
+                    std::make_shared<ir::PtrType>(), 0);
+                func.GetBlockList().front()->GetInstList().push_front(
+                    std::make_shared<ir::AllocaInst>(shadow));
+                shadow_map[ptr->Str()] = shadow;
+            }
+        }
+    }
+    if (shadow_map.empty()) return;
+
+    for (const auto &bb : func.GetBlockList()) {
+        auto &inst_list = bb->GetInstList();
+        for (auto iter = inst_list.begin(); iter != inst_list.end(); ++iter) {
+            if ((*iter)->kind != ir::Inst::kLoad) continue;
+            auto shadow = shadow_map.find((*iter)->GetUseList()[0]->Str());
+            if (shadow == shadow_map.end()) continue;
+            auto exp = std::make_shared<ir::TmpVar>(0);
+            iter = inst_list.insert(
+                std::next(iter),
+                std::make_shared<ir::LoadInst>(exp, shadow->second));
+            exp_map[(*std::prev(iter))->GetResultPtr()->Str()] = exp;
+        }
+    }
+    // 2^k stores k, and doubling adds one
+    for (const auto &bb : func.GetBlockList()) {
+        auto &inst_list = bb->GetInstList();
+        for (auto iter = inst_list.begin(); iter != inst_list.end(); ++iter) {
+            if ((*iter)->kind != ir::Inst::kStore) continue;
+            const auto use_list = (*iter)->GetUseList();
+            auto shadow = shadow_map.find(use_list[1]->Str());
+            if (shadow == shadow_map.end()) continue;
+            const auto &value = *use_list[0];
+            ValuePtr exp;
+            if (value.kind == ir::Value::kImm) {
+                exp = Imm(Log2(value.Cast<ir::Imm>().GetValue()));
+            } else {
+                exp = std::make_shared<ir::TmpVar>(0);
+                const auto &doubled = exp_map[Doubled(GetDef(value))->Str()];
+                iter = inst_list.insert(
+                    std::next(iter),
+                    std::make_shared<ir::BinaryOpInst>(
+                        ir::BinaryOpInst::kAdd,
+                        std::static_pointer_cast<ir::Var>(exp), doubled,
+                        Imm(1)));
+            }
+            iter = inst_list.insert(
+                std::next(iter),
+                std::make_shared<ir::StoreInst>(exp, shadow->second));
+        }
+    }
+}
+
+bool PowerFacts::IsNonNegative(const ir::Value &value, const int depth) const {
+    if (value.kind == ir::Value::kImm) {
+        return value.Cast<ir::Imm>().GetValue() >= 0;
+    }
+    // 2^30 at most
+    if (GetExponent(value) != nullptr) return true;
+    const auto *def = GetDef(value);
+    if (def == nullptr || depth > 4) return false;
+    if (def->kind == ir::Inst::kZext) return true;
+    if (def->kind != ir::Inst::kBinaryOp) return false;
+    const auto &op = def->Cast<ir::BinaryOpInst>();
+    const auto &lhs = op.GetLHS();
+    const auto &rhs = op.GetRHS();
+    switch (op.op_code) {
+        case ir::BinaryOpInst::kLShr:
+            return rhs.kind == ir::Value::kImm
+                   && rhs.Cast<ir::Imm>().GetValue() > 0;
+        case ir::BinaryOpInst::kAnd:
+            return IsNonNegative(lhs, depth + 1)
+                   || IsNonNegative(rhs, depth + 1);
+        case ir::BinaryOpInst::kSRem:
+        case ir::BinaryOpInst::kAShr:
+            return IsNonNegative(lhs, depth + 1);
+        case ir::BinaryOpInst::kSDiv:
+            return IsNonNegative(lhs, depth + 1)
+                   && IsNonNegative(rhs, depth + 1);
+        default:
+            return false;
+    }
+}
+
+// Emits the instructions replacing *iter in front of it, the last of them
+// takes over its result.
+class Builder {
+  public:
+    Builder(InstList &inst_list, const InstList::iterator &iter)
+        : inst_list(inst_list)
+        , iter(iter)
+        , result(std::static_pointer_cast<ir::Var>((*iter)->GetResultPtr())) {
+    }
+
+    ValuePtr Add(const ir::BinaryOpInst::BinaryOpKind op_code,
+                 ValuePtr lhs,
+                 ValuePtr rhs) {
+        auto tmp = std::make_shared<ir::TmpVar>(0);
+        inst_list.insert(iter, std::make_shared<ir::BinaryOpInst>(
+                                   op_code, tmp, std::move(lhs),
+                                   std::move(rhs)));
+        return tmp;
+    }
+    void Finish(const ir::BinaryOpInst::BinaryOpKind op_code,
+                ValuePtr lhs,
+                ValuePtr rhs) {
+        *iter = std::make_shared<ir::BinaryOpInst>(op_code, result,
+                                                   std::move(lhs),
+                                                   std::move(rhs));
+    }
+
+    // x + 2^k - 1 if x is negative, else x
+    ValuePtr Bias(const ValuePtr &x, const int k) {
+        ValuePtr sign = x;
+        if (k > 1) sign = Add(ir::BinaryOpInst::kAShr, x, Imm(31));
+        auto bias = Add(ir::BinaryOpInst::kLShr, sign, Imm(32 - k));
+        return Add(ir::BinaryOpInst::kAdd, x, bias);
+    }
+    // x + d - 1 if x is negative, else x, where d is a power of two
+    ValuePtr Bias(const ValuePtr &x, const ValuePtr &d) {
+        auto sign = Add(ir::BinaryOpInst::kAShr, x, Imm(31));
+        auto mask = Add(ir::BinaryOpInst::kSub, d, Imm(1));
+        auto bias = Add(ir::BinaryOpInst::kAnd, sign, mask);
+        return Add(ir::BinaryOpInst::kAdd, x, bias);
+    }
+
+  private:
+    InstList &inst_list;
+    const InstList::iterator iter;
+    const std::shared_ptr<ir::Var> result;
+};
+
+// rewrite the instruction at iter, return whether it changed
+bool Reduce(ir::FuncDef &func,
+            const PowerFacts &facts,
+            InstList &inst_list,
+            const InstList::iterator &iter) {
+    if ((*iter)->kind != ir::Inst::kBinaryOp) return false;
+    const auto op_code = (*iter)->Cast<ir::BinaryOpInst>().op_code;
+    if (op_code != ir::BinaryOpInst::kMul && op_code != ir::BinaryOpInst::kSDiv
+        && op_code != ir::BinaryOpInst::kSRem) {
+        return false;
+    }
+    const auto use_list = (*iter)->GetUseList();
+    auto x = use_list[0];
+    auto y = use_list[1];
+    if (op_code == ir::BinaryOpInst::kMul && x->kind == ir::Value::kImm) {
+        std::swap(x, y);
+    }
+    const bool is_imm = y->kind == ir::Value::kImm;
+    const int c = is_imm ? y->Cast<ir::Imm>().GetValue() : 0;
+    // the power of two in |c|
+    const int k = c == INT_MIN ? -1 : Log2(c < 0 ? -c : c);
+
+    // x * 1, x / 1, x % 1 and x % -1
+    if (is_imm && (c == 1 || (c == -1 && op_code == ir::BinaryOpInst::kSRem))) {
+        ReplaceAllUses(func, (*iter)->GetResultPtr(),
+                       op_code == ir::BinaryOpInst::kSRem ? Imm(0) : x);
+        inst_list.erase(iter);
+        return true;
+    }
+
+    Builder builder(inst_list, iter);
+    const bool non_negative = facts.IsNonNegative(*x);
+    switch (op_code) {
+        case ir::BinaryOpInst::kMul:
+            if (!is_imm) return false;
+            if (c == INT_MIN) {
+                builder.Finish(ir::BinaryOpInst::kShl, x, Imm(31));
+            } else if (k > 0 && c > 0) {
+                builder.Finish(ir::BinaryOpInst::kShl, x, Imm(k));
+            } else if (k > 0) {
+                auto shl = builder.Add(ir::BinaryOpInst::kShl, x, Imm(k));
+                builder.Finish(ir::BinaryOpInst::kSub, Imm(0), shl);
+            } else {
+                return false;
+            }
+            return true;
+        case ir::BinaryOpInst::kSDiv:
+            if (is_imm && k > 0) {
+                auto biased = non_negative ? x : builder.Bias(x, k);
+                if (c > 0) {
+                    builder.Finish(ir::BinaryOpInst::kAShr, biased, Imm(k));
+                } else {
+                    auto quotient
+                        = builder.Add(ir::BinaryOpInst::kAShr, biased, Imm(k));
+                    builder.Finish(ir::BinaryOpInst::kSub, Imm(0), quotient);
+                }
+            } else if (auto exp = facts.GetExponent(*y)) {
+                auto biased = non_negative ? x : builder.Bias(x, y);
+                builder.Finish(ir::BinaryOpInst::kAShr, biased, exp);
+            } else {
+                return false;
+            }
+            return true;
+        default:
+            // the sign of the divisor does not matter
+            if (is_imm && k > 0) {
+                if (non_negative) {
+                    builder.Finish(ir::BinaryOpInst::kAnd, x,
+                                   Imm((1 << k) - 1));
+                    return true;
+                }
+                auto rounded = builder.Add(ir::BinaryOpInst::kAnd,
+                                           builder.Bias(x, k), Imm(-(1 << k)));
+                builder.Finish(ir::BinaryOpInst::kSub, x, rounded);
+            } else if (!is_imm && facts.IsPowerOrZero(*y)) {
+                auto mask = builder.Add(ir::BinaryOpInst::kSub, y, Imm(1));
+                if (non_negative) {
+                    builder.Finish(ir::BinaryOpInst::kAnd, x, mask);
+                    return true;
+                }
+                auto sign = builder.Add(ir::BinaryOpInst::kAShr, x, Imm(31));
+                auto bias = builder.Add(ir::BinaryOpInst::kAnd, sign, mask);
+                auto biased = builder.Add(ir::BinaryOpInst::kAdd, x, bias);
+                auto neg = builder.Add(ir::BinaryOpInst::kSub, Imm(0), y);
+                auto rounded
+                    = builder.Add(ir::BinaryOpInst::kAnd, biased, neg);
+                builder.Finish(ir::BinaryOpInst::kSub, x, rounded);
+            } else {
+                return false;
+            }
+            return true;
+    }
+}
+
+}  // namespace
+
+int StrengthReduction::Run(ir::FuncDef &func) {
+    PowerFacts facts(func);
+    facts.TrackExponents(func);
+    int count = 0;
+    for (const auto &bb : func.GetBlockList()) {
+        auto &inst_list = bb->GetInstList();
+        for (auto iter = inst_list.begin(); iter != inst_list.end();) {
+            auto next = std::next(iter);
+            if (Reduce(func, facts, inst_list, iter)) ++count;
+            iter = next;
+        }
+    }
+    if (count > 0) func.Renumber();
+    return count;
+}
+
+}  // namespace opt
@@ -1,6 +1,170 @@
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <fstream>
 #include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "backend/backend.h"
+#include "emitter.h"
+#include "error.h"
+#include "frontend/frontend.h"
+#include "opt/block_placement.h"
+#include "opt/pass.h"
+#include "opt/pipeline.h"
+#include "opt/profile.h"
+
+namespace {
+
+const char kUsage[] =
+    "usage: sysycc [-S] [-emit-llvm] [-o <file>] [-O0|-O1|-O2]\n"
+    "              [-passes=<pass>,...] [-regalloc=greedy|coloring]\n"
+    "              [-fprofile-generate|-fprofile-use=<profile>] <file>\n";
+
+struct Options {
+    const char *input = nullptr;
+    // stdout if empty
+    std::string output;
+    int level = 0;
+    bool emit_llvm = false;
+    // the pipeline of the level if not given
+    bool has_passes = false;
+    std::string passes;
+    backend::RegAlloc *reg_alloc = nullptr;
+    bool profile_generate = false;
+    // no profile if empty
+    std::string profile_use;
+};
+
+int Usage(const std::string &msg) {
+    std::cerr << "sysycc: " << msg << '\n' << kUsage;
+    return 1;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "-S") {
+            // assembly is the default output
+        } else if (arg == "-emit-llvm") {
+            options.emit_llvm = true;
+        } else if (arg == "-o") {
+            if (++i == argc) return Usage("missing file name after '-o'");
+            options.output = argv[i];
+        } else if (arg.rfind("-o", 0) == 0) {
+            options.output = arg.substr(2);
+        } else if (arg == "-O0" || arg == "-O1" || arg == "-O2") {
+            options.level = arg[2] - '0';
+        } else if (arg.rfind("-passes=", 0) == 0) {
+            options.has_passes = true;
+            options.passes = arg.substr(8);
+        } else if (arg == "-regalloc=greedy") {
+            options.reg_alloc = &greedy_reg_alloc;
+        } else if (arg == "-regalloc=coloring") {
+            options.reg_alloc = &coloring_reg_alloc;
+        } else if (arg == "-fprofile-generate") {
+            options.profile_generate = true;
+        } else if (arg.rfind("-fprofile-use=", 0) == 0) {
+            options.profile_use = arg.substr(14);
+            if (options.profile_use.empty()) {
+                return Usage("missing file name after '-fprofile-use='");
+            }
+        } else if (arg == "-h" || arg == "--help") {
+            std::cout << kUsage;
+            return 0;
+        } else if (arg[0] == '-' && arg.size() > 1) {
+            return Usage("unknown option '" + arg + '\'');
+        } else if (options.input != nullptr) {
+            return Usage("more than one input file");
+        } else {
+            options.input = argv[i];
+        }
+    }
+    if (options.input == nullptr) return Usage("no input file");
+
+    // check the pipeline before any work is done
+    std::vector<std::unique_ptr<opt::FuncPass>> pass_list;
+    try {
+        pass_list = opt::ParsePipeline(options.has_passes
+                                           ? options.passes
+                                           : opt::GetPipeline(options.level));
+    } catch (const InvalidParameterException &e) {
+        return Usage(e.msg);
+    }
+    if (options.profile_generate && !options.profile_use.empty()) {
+        return Usage("-fprofile-generate and -fprofile-use both given");
+    }
+    opt::Profile profile;
+    if (!options.profile_use.empty()) {
+        std::ifstream file(options.profile_use);
+        if (!file) {
+            std::cerr << "sysycc: open file '" << options.profile_use
+                      << "' failed" << std::endl;
+            return 1;
+        }
+        try {
+            profile = opt::Profile::Read(file);
+        } catch (const InvalidParameterException &e) {
+            std::cerr << "sysycc: " << options.profile_use << ": " << e.msg
+                      << std::endl;
+            return 1;
+        }
+    }
+    // coloring gives better code, greedy is quicker on huge functions
+    if (options.reg_alloc != nullptr) {
+        reg_alloc = options.reg_alloc;
+    } else {
+        reg_alloc = options.level == 0 ? static_cast<backend::RegAlloc *>(
+                                             &greedy_reg_alloc)
+                                       : &coloring_reg_alloc;
+    }
+
+    int result = Parse(options.input);
+    if (result != 0) return result;
+
+    result = AstToIR();
+    if (result != 0) return result;
+
+    opt::RunPipeline(pass_list, *module);
+    // after the passes, so the blocks counted are the ones compiled
+    if (options.profile_generate) opt::InstrumentProfile(*module);
+    if (!options.profile_use.empty()) profile.Annotate(*module);
+    // the layout changes the hash of a profile, and follows its counts
+    if (options.level >= 1) {
+        opt::BlockPlacement block_placement;
+        opt::RunOnModule(block_placement, *module);
+    }
+
+    if (!options.emit_llvm) {
+        result = Assembling(*module);
+        if (result != 0) return result;
+    }
+
+    int fd = STDOUT_FILENO;
+    if (!options.output.empty() && options.output != "-") {
+        fd = open(options.output.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) {
+            std::cerr << "sysycc: open file '" << options.output << "' failed"
+                      << std::endl;
+            return 1;
+        }
+    }
 
-extern FILE *yyin;
-extern int yyparse();
+    std::cout.flush();
+    util::Emitter emitter(fd);
+    if (options.emit_llvm) {
+        module->Dump(emitter);
+    } else {
+        assembly.Dump(emitter);
+    }
+    emitter.Flush();
+    bool good = emitter.Good();
+    if (fd != STDOUT_FILENO && close(fd) != 0) good = false;
 
-int main(int argc, char **argv) {}
+    return good ? result : 1;
+}
@@ -9,6 +9,7 @@
     (std::make_shared<backend::ImmOperand>(static_cast<std::int32_t>(imm)))
 #define IMM16(imm) \
     (std::make_shared<backend::ImmOperand>(static_cast<std::int16_t>(imm)))
+#define QREG(id) (std::make_shared<backend::QRegOperand>(id))
 #define LABEL(label) (std::make_shared<backend::LabelOperand>(label))
 
 TEST(InstructionTest, Mov) {
@@ -22,6 +23,27 @@ TEST(InstructionTest, Mov) {
     EXPECT_STREQ("    mov   \tr0, #10", mov1.Str().c_str());
 }
 
+TEST(InstructionTest, Mvn) {
+    ASSERT_THROW(backend::InsMvn(REG(0), IMM32(0xf0f0f0f0)),
+                 InvalidParameterException);
+    backend::InsMvn mvn(REG(0), REG(1));
+    backend::InsMvn mvn1(REG(0), IMM32(0));
+    EXPECT_STREQ("    mvn   \tr0, r1", mvn.Str().c_str());
+    EXPECT_STREQ("    mvn   \tr0, #0", mvn1.Str().c_str());
+}
+
+TEST(InstructionTest, MovwMovt) {
+    ASSERT_THROW(backend::InsMovw(REG(0), IMM32(0x10000)),
+                 InvalidParameterException);
+    ASSERT_THROW(backend::InsMovt(REG(0), IMM32(-1)),
+                 InvalidParameterException);
+    backend::InsMovw movw(REG(0), IMM32(0xffff));
+    backend::InsMovt movt(REG(0), IMM32(0x1234));
+    EXPECT_STREQ("    movw  \tr0, #65535", movw.Str().c_str());
+    EXPECT_STREQ("    movt  \tr0, #4660", movt.Str().c_str());
+    EXPECT_EQ(1, movt.GetUseList().size());
+}
+
 TEST(InstructionTest, Ldr) {
     backend::InsLdr ldr(REG(0), REG(1));
     backend::InsLdr ldr1(REG(0), REG(1), IMM32(10));
@@ -29,7 +51,7 @@ TEST(InstructionTest, Ldr) {
     backend::InsLdr ldr3(REG(0), LABEL("global_var_a"));
     EXPECT_STREQ("    ldr   \tr0, [r1]", ldr.Str().c_str());
     EXPECT_STREQ("    ldr   \tr0, [r1, #10]", ldr1.Str().c_str());
-    EXPECT_STREQ("    ldr   \tr0, =#10", ldr2.Str().c_str());
+    EXPECT_STREQ("    ldr   \tr0, =10", ldr2.Str().c_str());
     EXPECT_STREQ("    ldr   \tr0, =global_var_a", ldr3.Str().c_str());
 }
 
@@ -87,6 +109,14 @@ TEST(InstructionTest, B) {
     EXPECT_STREQ("    bge   \tfunc.true", b4.Str().c_str());
     EXPECT_STREQ("    blt   \tfunc.true", b5.Str().c_str());
     EXPECT_STREQ("    ble   \tfunc.true", b6.Str().c_str());
+    backend::InsB b7(LABEL("func.true"), backend::InsB::kHI);
+    backend::InsB b8(LABEL("func.true"), backend::InsB::kHS);
+    backend::InsB b9(LABEL("func.true"), backend::InsB::kLO);
+    backend::InsB b10(LABEL("func.true"), backend::InsB::kLS);
+    EXPECT_STREQ("    bhi   \tfunc.true", b7.Str().c_str());
+    EXPECT_STREQ("    bhs   \tfunc.true", b8.Str().c_str());
+    EXPECT_STREQ("    blo   \tfunc.true", b9.Str().c_str());
+    EXPECT_STREQ("    bls   \tfunc.true", b10.Str().c_str());
 }
 
 TEST(InstructionTest, Bl) {
@@ -149,6 +179,54 @@ TEST(InstructionTest, Orr) {
     EXPECT_STREQ("    orr   \tr0, r1, #10", orr1.Str().c_str());
 }
 
+TEST(InstructionTest, Eor) {
+    ASSERT_THROW(backend::InsEor(REG(0), REG(1), IMM32(0xfff00000)),
+                 InvalidParameterException);
+    backend::InsEor eor(REG(0), REG(1), REG(2));
+    backend::InsEor eor1(REG(0), REG(1), IMM32(10));
+    EXPECT_STREQ("    eor   \tr0, r1, r2", eor.Str().c_str());
+    EXPECT_STREQ("    eor   \tr0, r1, #10", eor1.Str().c_str());
+}
+
+TEST(InstructionTest, Shift) {
+    ASSERT_THROW(backend::InsLsl(REG(0), REG(1), IMM32(32)),
+                 InvalidParameterException);
+    ASSERT_THROW(backend::InsAsr(REG(0), REG(1), IMM32(0)),
+                 InvalidParameterException);
+    ASSERT_NO_THROW(backend::InsLsr(REG(0), REG(1), IMM32(32)));
+    backend::InsLsl lsl(REG(0), REG(1), REG(2));
+    backend::InsAsr asr(REG(0), REG(1), IMM32(31));
+    backend::InsLsr lsr(REG(0), REG(1), IMM32(1), backend::Inst::kNE);
+    EXPECT_STREQ("    lsl   \tr0, r1, r2", lsl.Str().c_str());
+    EXPECT_STREQ("    asr   \tr0, r1, #31", asr.Str().c_str());
+    EXPECT_STREQ("    lsrne \tr0, r1, #1", lsr.Str().c_str());
+    EXPECT_EQ(2, lsl.GetUseList().size());
+    EXPECT_EQ(1, asr.GetUseList().size());
+}
+
+TEST(InstructionTest, Neon) {
+    ASSERT_THROW(backend::InsVgetLane(REG(0), QREG(8), 4),
+                 InvalidParameterException);
+    backend::InsVld1 vld1(QREG(8), REG(0));
+    backend::InsVst1 vst1(QREG(8), REG(0));
+    backend::InsVmul vmul(QREG(9), QREG(8), QREG(10));
+    backend::InsVdup vdup(QREG(10), REG(1));
+    backend::InsVmov vmov(QREG(0), QREG(8));
+    backend::InsVsetLane set(QREG(9), 1, REG(2));
+    backend::InsVgetLane get(REG(3), QREG(9), 2);
+    EXPECT_STREQ("    vld1.32   \t{d16, d17}, [r0]", vld1.Str().c_str());
+    EXPECT_STREQ("    vst1.32   \t{d16, d17}, [r0]", vst1.Str().c_str());
+    EXPECT_STREQ("    vmul.i32   \tq9, q8, q10", vmul.Str().c_str());
+    EXPECT_STREQ("    vdup.32   \tq10, r1", vdup.Str().c_str());
+    EXPECT_STREQ("    vmov   \tq0, q8", vmov.Str().c_str());
+    EXPECT_STREQ("    vmov.32   \td18[1], r2", set.Str().c_str());
+    EXPECT_STREQ("    vmov.32   \tr3, d19[0]", get.Str().c_str());
+    // the lanes not set are kept
+    EXPECT_EQ(1, set.GetQUseList().size());
+    EXPECT_TRUE(vst1.GetQDefList().empty());
+    EXPECT_EQ(2, vmul.GetQUseList().size());
+}
+
 TEST(InstructionTest, Nop) {
     backend::InsNop nop;
     EXPECT_STREQ("    nop  ", nop.Str().c_str());
@@ -159,6 +237,90 @@ TEST(InstructionTest, Label) {
     EXPECT_STREQ("main:", label.Str().c_str());
 }
 
+TEST(InstructionTest, Ltorg) {
+    backend::InsLtorg ltorg;
+    EXPECT_STREQ("    .ltorg", ltorg.Str().c_str());
+}
+
+static std::string Body(const backend::Function &func) {
+    std::string str;
+    for (const auto &inst : func.GetInstList()) str += inst->Str() + '\n';
+    return str;
+}
+
+TEST(FunctionTest, LoadImm) {
+    backend::Function func("func");
+    func.LoadImm(REG(0), 0xff0);
+    func.LoadImm(REG(1), -256);
+    func.LoadImm(REG(2), 1000);
+    func.LoadImm(REG(3), 0x12345678);
+    func.LoadImm(REG(4), 0x80000001);
+    EXPECT_STREQ(
+        "    mov   \tr0, #4080\n"
+        "    mvn   \tr1, #255\n"
+        "    mov   \tr2, #1000\n"
+        "    movw  \tr3, #22136\n"
+        "    movt  \tr3, #4660\n"
+        "    mov   \tr4, #-2147483647\n",
+        Body(func).c_str());
+
+    backend::Function func1("func1");
+    func1.LoadImm(REG(0), 1001);
+    func1.LoadImm(REG(1), 0x7ffffff0);
+    func1.LoadImm(REG(2), 0xabcd1234);
+    EXPECT_STREQ(
+        "    movw  \tr0, #1001\n"
+        "    mvn   \tr1, #-2147483633\n"
+        "    movw  \tr2, #4660\n"
+        "    movt  \tr2, #43981\n",
+        Body(func1).c_str());
+}
+
+TEST(FunctionTest, PlaceLiteralPool) {
+    // nothing to place
+    backend::Function func("func");
+    func.AddInst(std::make_shared<backend::InsBx>());
+    EXPECT_EQ(0, func.PlaceLiteralPool());
+
+    // one pool at the end
+    backend::Function func1("func1");
+    func1.AddInst(std::make_shared<backend::InsLdr>(REG(5), LABEL("a")));
+    func1.AddInst(std::make_shared<backend::InsBx>());
+    EXPECT_EQ(1, func1.PlaceLiteralPool());
+    EXPECT_EQ(backend::Inst::kInsLtorg, func1.GetInstList().back()->op);
+
+    // the pool goes after the last unconditional branch in range
+    backend::Function func2("func2");
+    func2.AddInst(std::make_shared<backend::InsLdr>(REG(5), LABEL("a")));
+    func2.AddInst(std::make_shared<backend::InsB>(LABEL(".func2_1")));
+    func2.AddInst(std::make_shared<backend::InsLabel>(LABEL(".func2_1")));
+    for (int i = 0; i < backend::Function::kPoolRange; ++i) {
+        func2.AddInst(std::make_shared<backend::InsNop>());
+    }
+    func2.AddInst(std::make_shared<backend::InsBx>());
+    EXPECT_EQ(1, func2.PlaceLiteralPool());
+    auto iter = func2.GetInstList().begin();
+    std::advance(iter, 2);
+    EXPECT_EQ(backend::Inst::kInsLtorg, (*iter)->op);
+    EXPECT_EQ(backend::Inst::kInsBx, func2.GetInstList().back()->op);
+
+    // no branch at all, jump over the pool
+    backend::Function func3("func3");
+    func3.AddInst(std::make_shared<backend::InsLdr>(REG(5), LABEL("a")));
+    for (int i = 0; i < backend::Function::kPoolRange; ++i) {
+        func3.AddInst(std::make_shared<backend::InsNop>());
+    }
+    func3.AddInst(std::make_shared<backend::InsLdr>(REG(5), LABEL("b")));
+    func3.AddInst(std::make_shared<backend::InsBx>());
+    EXPECT_EQ(2, func3.PlaceLiteralPool());
+    std::string body = Body(func3);
+    EXPECT_NE(std::string::npos,
+              body.find("    b     \t.func3_pool0\n"
+                        "    .ltorg\n"
+                        ".func3_pool0:\n"));
+    EXPECT_EQ(backend::Inst::kInsLtorg, func3.GetInstList().back()->op);
+}
+
 class AssemblyTest : public testing::Test {
   protected:
     void SetUp() override {
@@ -273,6 +435,8 @@ TEST_F(AssemblyTest, FunctionDump) {
 TEST_F(AssemblyTest, AssemblyDump) {
     backend::Assembly assembly;
     std::string result = "    .arch armv7-a\n";
+    result += "    .arch_extension idiv\n";
+    result += "    .fpu neon\n";
     result += "\n    .data\n";
     for (auto &pair : vars) {
         assembly.AddVar(std::make_shared<backend::GlobalVar>(pair.first));
@@ -31,6 +31,16 @@ TEST(OperandTest, Register) {
     EXPECT_FALSE(r_virtual.IsSpecial());
 }
 
+TEST(OperandTest, QRegister) {
+    ASSERT_THROW(backend::QRegOperand reg(-1), InvalidParameterValueException);
+    backend::QRegOperand q8(8);
+    backend::QRegOperand q_virtual(16);
+    EXPECT_STREQ("q8", q8.Str().c_str());
+    EXPECT_STREQ("q16", q_virtual.Str().c_str());
+    EXPECT_FALSE(q8.IsVirtual());
+    EXPECT_TRUE(q_virtual.IsVirtual());
+}
+
 TEST(OperandTest, Immediate) {
     backend::ImmOperand imm(0);
     backend::ImmOperand imm1(1);
@@ -82,6 +92,21 @@ TEST(OperandTest, ImmediateIsImm8m) {
     EXPECT_TRUE(imm3.IsImm8m());
     EXPECT_FALSE(imm4.IsImm8m());
     EXPECT_FALSE(imm5.IsImm8m());
+
+    backend::ImmOperand imm6(
+        static_cast<std::int32_t>(0x000003fc));  // #255 ror #30
+    backend::ImmOperand imm7(
+        static_cast<std::int32_t>(0xffffff00));  // ~#255
+    backend::ImmOperand imm8(
+        static_cast<std::int32_t>(0xfffffeff));  // ~#256
+    EXPECT_TRUE(imm6.IsImm8m());
+    EXPECT_FALSE(imm7.IsImm8m());
+    EXPECT_TRUE(imm7.IsInvImm8m());
+    EXPECT_FALSE(imm8.IsImm8m());
+    EXPECT_TRUE(imm8.IsInvImm8m());
+    EXPECT_FALSE(imm5.IsInvImm8m());
+    EXPECT_TRUE(imm6.IsUImm16());
+    EXPECT_FALSE(imm7.IsUImm16());
 }
 
 TEST(OperandTest, Label) {
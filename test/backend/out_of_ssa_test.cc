@@ -0,0 +1,108 @@
+#include "backend/out_of_ssa.h"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "ir/ir.h"
+#include "ir/type.h"
+#include "ir/value.h"
+
+static std::string Body(const backend::Function &func) {
+    std::string str;
+    for (const auto &inst : func.GetInstList()) str += inst->Str() + '\n';
+    return str;
+}
+
+TEST(SequentializeCopyTest, Cycle) {
+    backend::Function func("func");
+    auto a = func.NewReg();
+    auto b = func.NewReg();
+    auto c = func.NewReg();
+    auto d = func.NewReg();
+    // a <- b, b <- a, c <- a, d <- d
+    backend::SequentializeCopy(func, {{a, b}, {b, a}, {c, a}, {d, d}});
+    EXPECT_STREQ(
+        "    mov   \tr19, r17\n"
+        "    mov   \tr21, r17\n"
+        "    mov   \tr17, r18\n"
+        "    mov   \tr18, r21\n",
+        Body(func).c_str());
+}
+
+TEST(SequentializeCopyTest, Chain) {
+    backend::Function func("func");
+    auto a = func.NewReg();
+    auto b = func.NewReg();
+    auto c = func.NewReg();
+    // a <- b, b <- c: no scratch needed
+    backend::SequentializeCopy(func, {{a, b}, {b, c}});
+    EXPECT_STREQ(
+        "    mov   \tr17, r18\n"
+        "    mov   \tr18, r19\n",
+        Body(func).c_str());
+    EXPECT_EQ(20, func.GetRegNum());
+}
+
+// a loop whose latch branches back to the header conditionally
+TEST(SplitPhiEdgeTest, Loop) {
+    using ir::BasicBlock;
+    using ir::TmpVar;
+    auto param = std::make_shared<TmpVar>(0);
+    ir::FuncDef func{
+        std::make_shared<ir::GlobalVar>(
+            new ir::FuncType(new ir::IntType(ir::IntType::kI32),
+                             std::vector<ir::Type *>{
+                                 new ir::IntType(ir::IntType::kI32)}),
+            "func"),
+        {param}};
+    auto add_block = [&func](const int id) {
+        auto bb = std::make_shared<BasicBlock>(std::make_shared<TmpVar>(
+            std::make_shared<ir::LabelType>(), id));
+        func.AddBlock(bb);
+        return bb;
+    };
+    auto entry = add_block(1);
+    auto loop = add_block(2);
+    auto exit = add_block(6);
+
+    entry->AddInst(std::make_shared<ir::BrInst>(loop->GetLabelPtr()));
+    auto i = std::make_shared<TmpVar>(3);
+    auto next = std::make_shared<TmpVar>(4);
+    auto cond = std::make_shared<TmpVar>(
+        std::make_shared<ir::IntType>(ir::IntType::kI1), 5);
+    loop->AddInst(std::make_shared<ir::PhiInst>(
+        i, std::vector<ir::PhiInst::PhiValue>{
+               {std::make_shared<ir::Imm>(0), entry->GetLabelPtr()},
+               {next, loop->GetLabelPtr()}}));
+    loop->AddInst(std::make_shared<ir::BinaryOpInst>(
+        ir::BinaryOpInst::kAdd, next, i, std::make_shared<ir::Imm>(1)));
+    loop->AddInst(std::make_shared<ir::IcmpInst>(ir::IcmpInst::kSLT, cond,
+                                                 next, param));
+    loop->AddInst(std::make_shared<ir::BrInst>(cond, loop->GetLabelPtr(),
+                                               exit->GetLabelPtr()));
+    exit->AddInst(std::make_shared<ir::RetInst>(i));
+
+    EXPECT_EQ(1, backend::SplitPhiEdge(func));
+    EXPECT_EQ(0, backend::SplitPhiEdge(func));
+    std::ostringstream ostream;
+    func.Dump(ostream);
+    EXPECT_EQ(
+        "define i32 @func(i32 %0) {\n"
+        "1:\n"
+        "    br label %2\n"
+        "2:\n"
+        "    %3 = phi i32 [ 0, %1 ], [ %4, %6 ]\n"
+        "    %4 = add i32 %3, 1\n"
+        "    %5 = icmp slt i32 %4, %0\n"
+        "    br i1 %5, label %6, label %7\n"
+        "6:\n"
+        "    br label %2\n"
+        "7:\n"
+        "    ret i32 %3\n"
+        "}\n\n",
+        ostream.str());
+}
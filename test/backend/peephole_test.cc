@@ -0,0 +1,157 @@
+#include "backend/peephole.h"
+
+#include <gtest/gtest.h>
+
+#include <sstream>
+
+#define REG(id) (std::make_shared<backend::RegOperand>(id))
+#define IMM32(imm) \
+    (std::make_shared<backend::ImmOperand>(static_cast<std::int32_t>(imm)))
+#define LABEL(label) (std::make_shared<backend::LabelOperand>(label))
+
+static std::string Body(const backend::Function &func) {
+    std::string str;
+    for (const auto &inst : func.GetInstList()) str += inst->Str() + '\n';
+    return str;
+}
+
+TEST(PeepholeTest, RedundantMov) {
+    backend::Function func("func");
+    func.AddInst(std::make_shared<backend::InsMov>(REG(1), REG(1)));
+    func.AddInst(std::make_shared<backend::InsMov>(REG(1), REG(2)));
+    backend::Peephole peephole;
+    EXPECT_EQ(1, peephole.Run(func));
+    EXPECT_EQ(1, peephole.GetCount("redundant-mov"));
+    EXPECT_STREQ("    mov   \tr1, r2\n", Body(func).c_str());
+}
+
+TEST(PeepholeTest, StoreLoad) {
+    auto sp = REG(backend::RegOperand::kSp);
+    backend::Function func("func");
+    func.AddInst(std::make_shared<backend::InsStr>(REG(8), sp, IMM32(4)));
+    func.AddInst(std::make_shared<backend::InsLdr>(REG(6), sp, IMM32(4)));
+    func.AddInst(std::make_shared<backend::InsStr>(REG(1), sp, IMM32(0)));
+    func.AddInst(std::make_shared<backend::InsLdr>(REG(1), sp));
+    func.AddInst(std::make_shared<backend::InsStr>(REG(1), sp, IMM32(0)));
+    func.AddInst(std::make_shared<backend::InsLdr>(REG(2), sp, IMM32(8)));
+    backend::Peephole peephole;
+    EXPECT_EQ(2, peephole.Run(func));
+    EXPECT_EQ(2, peephole.GetCount("store-load"));
+    EXPECT_STREQ(
+        "    str   \tr8, [sp, #4]\n"
+        "    mov   \tr6, r8\n"
+        "    str   \tr1, [sp, #0]\n"
+        "    str   \tr1, [sp, #0]\n"
+        "    ldr   \tr2, [sp, #8]\n",
+        Body(func).c_str());
+}
+
+TEST(PeepholeTest, RedundantLabelLoad) {
+    backend::Function func("func");
+    func.AddInst(std::make_shared<backend::InsLdr>(REG(5), LABEL("a")));
+    func.AddInst(std::make_shared<backend::InsLdr>(REG(6), REG(5)));
+    func.AddInst(std::make_shared<backend::InsLdr>(REG(5), LABEL("a")));
+    func.AddInst(std::make_shared<backend::InsStr>(REG(6), REG(5)));
+    func.AddInst(std::make_shared<backend::InsLdr>(REG(5), LABEL("b")));
+    func.AddInst(std::make_shared<backend::InsLdr>(REG(5), LABEL("a")));
+    func.AddInst(std::make_shared<backend::InsLabel>(LABEL(".func_1")));
+    func.AddInst(std::make_shared<backend::InsLdr>(REG(5), LABEL("a")));
+    backend::Peephole peephole;
+    EXPECT_EQ(1, peephole.Run(func));
+    EXPECT_EQ(1, peephole.GetCount("redundant-label-load"));
+    EXPECT_STREQ(
+        "    ldr   \tr5, =a\n"
+        "    ldr   \tr6, [r5]\n"
+        "    str   \tr6, [r5]\n"
+        "    ldr   \tr5, =b\n"
+        "    ldr   \tr5, =a\n"
+        ".func_1:\n"
+        "    ldr   \tr5, =a\n",
+        Body(func).c_str());
+}
+
+TEST(PeepholeTest, Branch) {
+    backend::Function func("func");
+    func.AddInst(std::make_shared<backend::InsCmp>(REG(1), REG(2)));
+    func.AddInst(std::make_shared<backend::InsB>(LABEL(".func_1"),
+                                                 backend::Inst::kGT));
+    func.AddInst(std::make_shared<backend::InsB>(LABEL(".func_2")));
+    func.AddInst(std::make_shared<backend::InsLabel>(LABEL(".func_1")));
+    func.AddInst(std::make_shared<backend::InsMov>(REG(0), IMM32(1)));
+    func.AddInst(std::make_shared<backend::InsB>(LABEL(".func_2")));
+    func.AddInst(std::make_shared<backend::InsLabel>(LABEL(".func_2")));
+    func.AddInst(std::make_shared<backend::InsBx>());
+    backend::Peephole peephole;
+    EXPECT_EQ(3, peephole.Run(func));
+    EXPECT_EQ(1, peephole.GetCount("invert-branch"));
+    EXPECT_EQ(1, peephole.GetCount("branch-to-next"));
+    EXPECT_EQ(1, peephole.GetCount("predicate"));
+    EXPECT_STREQ(
+        "    cmp   \tr1, r2\n"
+        ".func_1:\n"
+        "    movgt \tr0, #1\n"
+        ".func_2:\n"
+        "    bx    \tlr\n",
+        Body(func).c_str());
+}
+
+TEST(PeepholeTest, Predicate) {
+    backend::Function func("func");
+    func.AddInst(std::make_shared<backend::InsCmp>(REG(1), REG(2)));
+    func.AddInst(std::make_shared<backend::InsB>(LABEL(".func_2"),
+                                                 backend::Inst::kEQ));
+    func.AddInst(std::make_shared<backend::InsLabel>(LABEL(".func_1")));
+    func.AddInst(std::make_shared<backend::InsAdd>(REG(0), REG(1), IMM32(1)));
+    func.AddInst(std::make_shared<backend::InsB>(LABEL(".func_3")));
+    func.AddInst(std::make_shared<backend::InsLabel>(LABEL(".func_2")));
+    func.AddInst(std::make_shared<backend::InsSub>(REG(0), REG(1), IMM32(1)));
+    func.AddInst(std::make_shared<backend::InsLabel>(LABEL(".func_3")));
+    func.AddInst(std::make_shared<backend::InsBx>());
+    backend::Peephole peephole;
+    EXPECT_EQ(1, peephole.Run(func));
+    EXPECT_EQ(1, peephole.GetCount("predicate"));
+    EXPECT_STREQ(
+        "    cmp   \tr1, r2\n"
+        ".func_1:\n"
+        "    addne \tr0, r1, #1\n"
+        "    subeq \tr0, r1, #1\n"
+        ".func_3:\n"
+        "    bx    \tlr\n",
+        Body(func).c_str());
+
+    // the arm is too long, or some other branch jumps into it
+    backend::Function other("other");
+    other.AddInst(std::make_shared<backend::InsCmp>(REG(1), REG(2)));
+    other.AddInst(std::make_shared<backend::InsB>(LABEL(".other_2"),
+                                                  backend::Inst::kEQ));
+    for (int i = 0; i <= backend::kMaxPredicated; ++i) {
+        other.AddInst(std::make_shared<backend::InsAdd>(REG(0), REG(0),
+                                                        IMM32(1)));
+    }
+    other.AddInst(std::make_shared<backend::InsLabel>(LABEL(".other_2")));
+    other.AddInst(std::make_shared<backend::InsB>(LABEL(".other_3"),
+                                                  backend::Inst::kLT));
+    other.AddInst(std::make_shared<backend::InsLabel>(LABEL(".other_4")));
+    other.AddInst(std::make_shared<backend::InsMov>(REG(0), IMM32(0)));
+    other.AddInst(std::make_shared<backend::InsLabel>(LABEL(".other_3")));
+    other.AddInst(std::make_shared<backend::InsB>(LABEL(".other_4")));
+    EXPECT_EQ(0, peephole.Run(other));
+}
+
+TEST(PeepholeTest, ZeroAddSub) {
+    auto sp = REG(backend::RegOperand::kSp);
+    backend::Function func("func");
+    func.AddInst(std::make_shared<backend::InsAdd>(sp, sp, IMM32(0)));
+    func.AddInst(std::make_shared<backend::InsSub>(sp, sp, IMM32(0)));
+    func.AddInst(std::make_shared<backend::InsAdd>(REG(1), sp, IMM32(0)));
+    backend::Peephole peephole;
+    EXPECT_EQ(2, peephole.Run(func));
+    EXPECT_EQ(2, peephole.GetCount("zero-add-sub"));
+    EXPECT_STREQ("    add   \tr1, sp, #0\n", Body(func).c_str());
+
+    std::ostringstream s;
+    peephole.DumpStatistic(s);
+    EXPECT_NE(std::string::npos, s.str().find("zero-add-sub"));
+    peephole.ClearStatistic();
+    EXPECT_EQ(0, peephole.GetCount("zero-add-sub"));
+}
@@ -0,0 +1,279 @@
+#include "backend/regalloc.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "error.h"
+
+#define REG(id) (std::make_shared<backend::RegOperand>(id))
+#define IMM32(imm) \
+    (std::make_shared<backend::ImmOperand>(static_cast<std::int32_t>(imm)))
+#define LABEL(label) (std::make_shared<backend::LabelOperand>(label))
+
+static std::string Body(const backend::Function &func) {
+    std::string str;
+    for (const auto &inst : func.GetInstList()) str += inst->Str() + '\n';
+    return str;
+}
+
+TEST(LivenessTest, Range) {
+    backend::Function func("func");
+    auto a = func.NewReg();
+    auto b = func.NewReg();
+    func.AddInst(std::make_shared<backend::InsMov>(a, IMM32(1)));     // 0
+    func.AddInst(std::make_shared<backend::InsMov>(b, IMM32(2)));     // 1
+    func.AddInst(std::make_shared<backend::InsAdd>(a, a, b));         // 2
+    func.AddInst(std::make_shared<backend::InsMov>(REG(0), a));       // 3
+    func.AddInst(std::make_shared<backend::InsBx>());                 // 4
+    backend::Liveness liveness(func);
+
+    const auto &range_a = liveness.GetRange(a->GetId());
+    ASSERT_EQ(1, range_a.size());
+    EXPECT_EQ(1, range_a[0].begin);
+    EXPECT_EQ(7, range_a[0].end);
+    const auto &range_b = liveness.GetRange(b->GetId());
+    ASSERT_EQ(1, range_b.size());
+    EXPECT_EQ(3, range_b[0].begin);
+    EXPECT_EQ(5, range_b[0].end);
+    EXPECT_EQ(4, liveness.GetRefCount(a->GetId()));
+}
+
+TEST(LivenessTest, Loop) {
+    backend::Function func("func");
+    auto i = func.NewReg();
+    func.AddInst(std::make_shared<backend::InsMov>(i, IMM32(0)));      // 0
+    func.AddInst(std::make_shared<backend::InsLabel>(LABEL(".f_1")));  // 1
+    func.AddInst(std::make_shared<backend::InsCmp>(i, IMM32(10)));     // 2
+    func.AddInst(std::make_shared<backend::InsB>(LABEL(".f_2"),
+                                                 backend::Inst::kGE));  // 3
+    func.AddInst(std::make_shared<backend::InsAdd>(i, i, IMM32(1)));   // 4
+    func.AddInst(std::make_shared<backend::InsB>(LABEL(".f_1")));      // 5
+    func.AddInst(std::make_shared<backend::InsLabel>(LABEL(".f_2")));  // 6
+    func.AddInst(std::make_shared<backend::InsBx>());                  // 7
+    backend::Liveness liveness(func);
+
+    // live around the back edge, dead after the exit
+    const auto &range = liveness.GetRange(i->GetId());
+    ASSERT_EQ(1, range.size());
+    EXPECT_EQ(1, range[0].begin);
+    EXPECT_EQ(12, range[0].end);
+}
+
+TEST(GreedyRegAllocTest, CallClobber) {
+    backend::Function func("func");
+    auto a = func.NewReg();
+    auto b = func.NewReg();
+    func.AddInst(std::make_shared<backend::InsMov>(a, REG(0)));
+    func.AddInst(std::make_shared<backend::InsMov>(b, IMM32(1)));
+    func.AddInst(std::make_shared<backend::InsMov>(REG(0), b));
+    func.AddInst(std::make_shared<backend::InsBl>(LABEL("g"), 1));
+    func.AddInst(std::make_shared<backend::InsAdd>(REG(0), REG(0), a));
+    func.AddInst(std::make_shared<backend::InsBx>());
+    backend::GreedyRegAlloc reg_alloc;
+    reg_alloc.Run(func);
+    EXPECT_EQ(0, reg_alloc.GetSpillCount());
+    // a lives across the call, b goes to r0 as hinted
+    EXPECT_STREQ(
+        "    mov   \tr4, r0\n"
+        "    mov   \tr0, #1\n"
+        "    mov   \tr0, r0\n"
+        "    bl    \tg(PLT)\n"
+        "    add   \tr0, r0, r4\n"
+        "    bx    \tlr\n",
+        Body(func).c_str());
+}
+
+TEST(GreedyRegAllocTest, Spill) {
+    backend::Function func("func");
+    std::vector<std::shared_ptr<backend::RegOperand>> reg_list;
+    for (int i = 0; i < 14; ++i) {
+        reg_list.push_back(func.NewReg());
+        func.AddInst(std::make_shared<backend::InsMov>(reg_list[i], IMM32(i)));
+    }
+    auto sum = func.NewReg();
+    func.AddInst(std::make_shared<backend::InsMov>(sum, IMM32(0)));
+    for (const auto &reg : reg_list) {
+        func.AddInst(std::make_shared<backend::InsAdd>(sum, sum, reg));
+    }
+    func.AddInst(std::make_shared<backend::InsMov>(REG(0), sum));
+    func.AddInst(std::make_shared<backend::InsBx>());
+
+    backend::GreedyRegAlloc reg_alloc;
+    reg_alloc.Run(func);
+    EXPECT_LT(0, reg_alloc.GetSpillCount());
+    for (const auto &inst : func.GetInstList()) {
+        for (const auto &reg : inst->GetUseList()) {
+            EXPECT_FALSE(reg->IsVirtual());
+        }
+        for (const auto &reg : inst->GetDefList()) {
+            EXPECT_FALSE(reg->IsVirtual());
+        }
+    }
+    func.LowerFrame();
+    // a slot for each spilled register
+    EXPECT_LE(4 * reg_alloc.GetSpillCount(), func.GetFrameSize());
+
+    reg_alloc.ClearStatistic();
+    EXPECT_EQ(0, reg_alloc.GetSpillCount());
+}
+
+TEST(ColoringRegAllocTest, Coalesce) {
+    backend::Function func("func");
+    auto a = func.NewReg();
+    auto b = func.NewReg();
+    auto c = func.NewReg();
+    func.AddInst(std::make_shared<backend::InsMov>(a, REG(1)));
+    func.AddInst(std::make_shared<backend::InsMov>(b, a));
+    func.AddInst(std::make_shared<backend::InsAdd>(c, b, IMM32(1)));
+    func.AddInst(std::make_shared<backend::InsMov>(REG(0), c));
+    func.AddInst(std::make_shared<backend::InsBx>());
+    backend::ColoringRegAlloc reg_alloc;
+    reg_alloc.Run(func);
+    EXPECT_EQ(0, reg_alloc.GetSpillCount());
+    // a and b merge into r1, c into r0
+    EXPECT_EQ(3, reg_alloc.GetCoalesceCount());
+    EXPECT_STREQ(
+        "    mov   \tr1, r1\n"
+        "    mov   \tr1, r1\n"
+        "    add   \tr0, r1, #1\n"
+        "    mov   \tr0, r0\n"
+        "    bx    \tlr\n",
+        Body(func).c_str());
+}
+
+TEST(ColoringRegAllocTest, LoopSpill) {
+    // one register is used only outside the loop, it goes first
+    backend::Function func("func");
+    auto outer = func.NewReg();
+    func.AddInst(std::make_shared<backend::InsMov>(outer, IMM32(100)));
+    std::vector<std::shared_ptr<backend::RegOperand>> reg_list;
+    for (int i = 0; i < 12; ++i) {
+        reg_list.push_back(func.NewReg());
+        func.AddInst(std::make_shared<backend::InsMov>(reg_list[i], IMM32(i)));
+    }
+    func.AddInst(std::make_shared<backend::InsLabel>(LABEL(".f_1")));
+    for (const auto &reg : reg_list) {
+        func.AddInst(std::make_shared<backend::InsAdd>(reg, reg, IMM32(1)));
+    }
+    func.AddInst(std::make_shared<backend::InsCmp>(reg_list[0], IMM32(10)));
+    func.AddInst(std::make_shared<backend::InsB>(LABEL(".f_1"),
+                                                 backend::Inst::kLT));
+    for (int i = 1; i < 12; ++i) {
+        func.AddInst(std::make_shared<backend::InsAdd>(
+            reg_list[0], reg_list[0], reg_list[i]));
+    }
+    func.AddInst(std::make_shared<backend::InsAdd>(REG(0), reg_list[0], outer));
+    func.AddInst(std::make_shared<backend::InsBx>());
+
+    backend::ColoringRegAlloc reg_alloc;
+    reg_alloc.Run(func);
+    EXPECT_EQ(1, reg_alloc.GetSpillCount());
+    // nothing goes to the stack inside the loop
+    bool in_loop = false;
+    for (const auto &inst : func.GetInstList()) {
+        if (inst->op == backend::Inst::kInsLabel) in_loop = true;
+        if (inst->op == backend::Inst::kInsB) in_loop = false;
+        if (in_loop) {
+            EXPECT_NE(backend::Inst::kInsLdr, inst->op);
+            EXPECT_NE(backend::Inst::kInsStr, inst->op);
+        }
+        for (const auto &reg : inst->GetUseList()) {
+            EXPECT_FALSE(reg->IsVirtual());
+        }
+        for (const auto &reg : inst->GetDefList()) {
+            EXPECT_FALSE(reg->IsVirtual());
+        }
+    }
+}
+
+// too many registers for the bit matrix, the greedy allocator takes over
+TEST(ColoringRegAllocTest, Large) {
+    backend::Function func("func");
+    while (func.GetRegNum() <= backend::ColoringRegAlloc::kMaxRegNum) {
+        auto reg = func.NewReg();
+        func.AddInst(std::make_shared<backend::InsMov>(reg, IMM32(1)));
+        func.AddInst(std::make_shared<backend::InsAdd>(REG(0), REG(0), reg));
+    }
+    func.AddInst(std::make_shared<backend::InsBx>());
+
+    backend::ColoringRegAlloc reg_alloc;
+    reg_alloc.Run(func);
+    EXPECT_EQ(0, reg_alloc.GetSpillCount());
+    EXPECT_EQ(0, reg_alloc.GetCoalesceCount());
+    for (const auto &inst : func.GetInstList()) {
+        for (const auto &reg : inst->GetDefList()) {
+            EXPECT_FALSE(reg->IsVirtual());
+        }
+    }
+}
+
+TEST(QRegAllocTest, Assign) {
+    backend::Function func("func");
+    auto a = func.NewQReg();
+    auto b = func.NewQReg();
+    auto c = func.NewQReg();
+    func.AddInst(std::make_shared<backend::InsVld1>(a, REG(0)));
+    func.AddInst(std::make_shared<backend::InsVdup>(b, REG(1)));
+    func.AddInst(std::make_shared<backend::InsVadd>(c, a, b));
+    func.AddInst(std::make_shared<backend::InsVmov>(a, c));
+    func.AddInst(std::make_shared<backend::InsVst1>(a, REG(0)));
+    func.AddInst(std::make_shared<backend::InsBx>());
+    backend::QRegAlloc q_reg_alloc;
+    q_reg_alloc.Run(func);
+    // c takes the register of a as hinted, the move between them goes
+    EXPECT_STREQ(
+        "    vld1.32   \t{d16, d17}, [r0]\n"
+        "    vdup.32   \tq9, r1\n"
+        "    vadd.i32   \tq8, q8, q9\n"
+        "    vst1.32   \t{d16, d17}, [r0]\n"
+        "    bx    \tlr\n",
+        Body(func).c_str());
+}
+
+TEST(QRegAllocTest, CallClobber) {
+    backend::Function func("func");
+    auto a = func.NewQReg();
+    func.AddInst(std::make_shared<backend::InsVld1>(a, REG(4)));
+    func.AddInst(std::make_shared<backend::InsBl>(LABEL("g"), 0));
+    func.AddInst(std::make_shared<backend::InsVst1>(a, REG(4)));
+    func.AddInst(std::make_shared<backend::InsBx>());
+    backend::QRegAlloc q_reg_alloc;
+    EXPECT_THROW(q_reg_alloc.Run(func), InvalidParameterException);
+}
+
+TEST(LowerFrameTest, Leaf) {
+    backend::Function func("func");
+    func.AddInst(std::make_shared<backend::InsMov>(REG(0), IMM32(0)));
+    func.AddInst(std::make_shared<backend::InsBx>());
+    func.LowerFrame();
+    EXPECT_EQ(0, func.GetFrameSize());
+    EXPECT_STREQ(
+        "    mov   \tr0, #0\n"
+        "    bx    \tlr\n",
+        Body(func).c_str());
+}
+
+TEST(LowerFrameTest, Call) {
+    backend::Function func("func");
+    auto object = func.AddStackObject(4);
+    auto arg = func.AddIncomingArg(4);
+    func.ReserveCallArg(4);
+    func.AddInst(func.FrameInst(backend::Function::kFrameLoad, REG(4), arg));
+    func.AddInst(
+        func.FrameInst(backend::Function::kFrameStore, REG(4), object));
+    func.AddInst(std::make_shared<backend::InsBl>(LABEL("g"), 0));
+    func.AddInst(std::make_shared<backend::InsBx>());
+    func.LowerFrame();
+    // push {r4, lr}, 4 bytes of call arguments and 4 of locals
+    EXPECT_EQ(8, func.GetFrameSize());
+    EXPECT_STREQ(
+        "    push  \t{r4, lr}\n"
+        "    sub   \tsp, sp, #8\n"
+        "    ldr   \tr4, [sp, #16]\n"
+        "    str   \tr4, [sp, #4]\n"
+        "    bl    \tg(PLT)\n"
+        "    add   \tsp, sp, #8\n"
+        "    pop   \t{r4, pc}\n",
+        Body(func).c_str());
+}
@@ -0,0 +1,202 @@
+#!/bin/bash
+
+usage() {
+    echo "Usage: $0 [-t ir|arm] [-O LEVEL] [-n RUNS] [-b BASELINE] [-r PERCENT] [DIRPATH]"
+    echo "  -t  ir: run the IR built by clang natively, arm: run the assembly on qemu-arm (default ir)"
+    echo "  -O  optimization level passed to sysycc (default 2)"
+    echo "  -n  runs of each program, the fastest counts (default 3)"
+    echo "  -b  result of an earlier run to compare with"
+    echo "  -r  slowdown in percent over the baseline that is flagged (default 5)"
+    echo "  DIRPATH defaults to testcase/performance_test/sy"
+    exit 1
+}
+
+TARGET="ir"
+LEVEL=2
+RUNS=3
+BASELINE=""
+PERCENT=5
+while getopts "t:O:n:b:r:h" opt; do
+    case $opt in
+        t) TARGET=$OPTARG ;;
+        O) LEVEL=$OPTARG ;;
+        n) RUNS=$OPTARG ;;
+        b) BASELINE=$(realpath $OPTARG) ;;
+        r) PERCENT=$OPTARG ;;
+        *) usage ;;
+    esac
+done
+shift $((OPTIND - 1))
+if [ $# -gt 1 ] || { [ $TARGET != "ir" ] && [ $TARGET != "arm" ]; }; then
+    usage
+fi
+if [ -n "$BASELINE" ] && [ ! -f $BASELINE ]; then
+    echo "cannot open baseline '${BASELINE}'"
+    exit 1
+fi
+
+# 目录的绝对路径
+dirPath="$(realpath ${1:-$(dirname ${BASH_SOURCE[0]})/../testcase/performance_test/sy})"
+if [ ! -d $dirPath ]; then
+    echo "cannot open '${dirPath}': No such directory"
+    exit 1
+fi
+
+# 进入项目根目录
+cd $(dirname ${BASH_SOURCE[0]})/..
+
+DRIVER="./build/src/sysycc"
+if [ ! -x $DRIVER ]; then
+    echo "executable file '${DRIVER}' dose not exsit, please build it"
+    exit 1
+fi
+DRIVER=$(realpath $DRIVER)
+
+if [ $TARGET == "ir" ]; then
+    LIB="./build/lib/libsysy/libsysy.a"
+else
+    LIB="./lib/libsysy_arm/libsysy.a"
+fi
+if [ ! -f $LIB ]; then
+    echo "static lib file '${LIB}' dose not exsit, please build it"
+    exit 1
+fi
+LIB=$(realpath $LIB)
+
+mkdir -p "./tmp/bench/src/" "./tmp/bench/elf/" "./tmp/bench/out/"
+TMP=$(realpath "./tmp/bench/")
+
+ANS=$(cd ${dirPath}/../out; pwd)
+IN=$(cd ${dirPath}/../in; pwd)
+
+# 每次运行的结果都保留在 tmp/bench 下，作为历史记录
+resultPath=${TMP}/${TARGET}-O${LEVEL}-$(date +%Y%m%d-%H%M%S).json
+
+# 微秒
+now() {
+    echo $(($(date +%s%N) / 1000))
+}
+
+# sylib 在 after_main 中向 stderr 输出的 TOTAL: xH-xM-xS-xus
+total() {
+    sed -n 's/^TOTAL: \([0-9]*\)H-\([0-9]*\)M-\([0-9]*\)S-\([0-9]*\)us$/\1 \2 \3 \4/p' $1 \
+        | awk '{ print (($1 * 60 + $2) * 60 + $3) * 1000000 + $4 }'
+}
+
+# 基准结果中 name 的 run_us，每个程序的结果占一行
+baseline() {
+    grep "\"name\": \"$1\"" $BASELINE | sed -n 's/.*"run_us": \([0-9]*\).*/\1/p'
+}
+
+failed=0
+slower=0
+results=()
+for x in $(ls $dirPath | grep -e ".sy$");
+do
+    name=${x%.*}
+    srcPath=${dirPath}/${x}
+    elfPath=${TMP}/elf/${name}
+    outPath=${TMP}/out/${name}.out
+    errPath=${TMP}/out/${name}.err
+    ansPath=${ANS}/${name}.out
+    inPath=${IN}/${name}.in
+    [ -f ${inPath} ] || inPath=/dev/null
+
+    echo -e "\e[34m[BENCH]\e[0m \e[33m${srcPath}\e[0m"
+
+    begin=$(now)
+    if [ $TARGET == "ir" ]; then
+        genPath=${TMP}/src/${name}.ll
+        $DRIVER -emit-llvm -O${LEVEL} -o ${genPath} ${srcPath}
+    else
+        genPath=${TMP}/src/${name}.s
+        $DRIVER -S -O${LEVEL} -o ${genPath} ${srcPath}
+    fi
+    result=$?
+    compile_us=$(($(now) - begin))
+    if [ $result -ne 0 ]; then
+        echo -e "\e[31;1m[FAILED]\e[0m compile, see output in '${genPath}'"
+        failed=$((failed + 1))
+        results+=("{\"name\": \"${name}\", \"ok\": false}")
+        continue
+    fi
+
+    if [ $TARGET == "ir" ]; then
+        clang ${genPath} ${LIB} -o ${elfPath}
+    else
+        arm-linux-gnueabihf-gcc -static ${genPath} ${LIB} -o ${elfPath}
+    fi
+    if [ $? -ne 0 ]; then
+        echo -e "\e[31;1m[FAILED]\e[0m generate elf, see output in '${elfPath}'"
+        failed=$((failed + 1))
+        results+=("{\"name\": \"${name}\", \"ok\": false}")
+        continue
+    fi
+
+    ok=true
+    run_us=""
+    for ((i = 0; i < RUNS; i++)); do
+        if [ $TARGET == "ir" ]; then
+            ${elfPath} > ${outPath} 2> ${errPath} < ${inPath}
+        else
+            qemu-arm ${elfPath} > ${outPath} 2> ${errPath} < ${inPath}
+        fi
+        result=$?
+        # 若输出结果的文件不以换行符结尾，且不为空，则添加换行符
+        if [ $(tail -n1 ${outPath} | wc -l) -eq 0 ] && [ $(cat ${outPath} | wc -c) -ne 0 ]; then
+            echo >> ${outPath}
+        fi
+        echo $result >> ${outPath}
+        if ! diff -bq ${outPath} ${ansPath} > /dev/null; then
+            echo -e "\e[31;1m[FAILED]\e[0m wrong result, see answer in '${ansPath}'"
+            ok=false
+            break
+        fi
+        us=$(total ${errPath})
+        [ -n "$us" ] || us=0
+        if [ -z "$run_us" ] || [ $us -lt $run_us ]; then
+            run_us=$us
+        fi
+    done
+    if [ $ok == false ]; then
+        failed=$((failed + 1))
+        results+=("{\"name\": \"${name}\", \"compile_us\": ${compile_us}, \"ok\": false}")
+        continue
+    fi
+    results+=("{\"name\": \"${name}\", \"compile_us\": ${compile_us}, \"run_us\": ${run_us}, \"ok\": true}")
+    echo "    compile ${compile_us}us, run ${run_us}us"
+
+    if [ -n "$BASELINE" ]; then
+        base_us=$(baseline ${name})
+        # 不到 1ms 的差距视为噪声
+        if [ -n "$base_us" ] && [ $((run_us - base_us)) -gt 1000 ] \
+            && [ $((run_us * 100)) -gt $((base_us * (100 + PERCENT))) ]; then
+            echo -e "\e[31;1m[SLOWER]\e[0m ${run_us}us, baseline ${base_us}us"
+            slower=$((slower + 1))
+        fi
+    fi
+done
+
+{
+    echo "{"
+    echo "  \"target\": \"${TARGET}\","
+    echo "  \"level\": ${LEVEL},"
+    echo "  \"runs\": ${RUNS},"
+    echo "  \"results\": ["
+    for ((i = 0; i < ${#results[@]}; i++)); do
+        if [ $i -lt $((${#results[@]} - 1)) ]; then
+            echo "    ${results[$i]},"
+        else
+            echo "    ${results[$i]}"
+        fi
+    done
+    echo "  ]"
+    echo "}"
+} > ${resultPath}
+echo "result saved in '${resultPath}'"
+
+if [ $failed -ne 0 ] || [ $slower -ne 0 ]; then
+    echo -e "\e[31;1m[FAILED]\e[0m ${failed} failed, ${slower} slower than the baseline"
+    exit 1
+fi
+echo -e "\e[32;1m[SUCCESS]\e[0m"
@@ -1,7 +1,41 @@
+#include <climits>
+#include <sstream>
+#include <string>
+#include <utility>
+
+#include "casting.h"
+#include "emitter.h"
 #include "error.h"
 #include "gtest/gtest.h"
 #include "util.h"
 
+namespace {
+
+struct Shape {
+    enum ShapeKind { kCircle, kRect, kSquare };
+    const ShapeKind kind;
+
+    explicit Shape(const ShapeKind kind) : kind(kind) {}
+
+    static bool classof(const Shape *shape) { return true; }
+};
+
+struct Circle : Shape {
+    Circle() : Shape(kCircle) {}
+
+    static bool classof(const Shape *shape) { return shape->kind == kCircle; }
+};
+
+struct Rect : Shape {
+    explicit Rect(const ShapeKind kind = kRect) : Shape(kind) {}
+
+    static bool classof(const Shape *shape) {
+        return shape->kind == kRect || shape->kind == kSquare;
+    }
+};
+
+}  // namespace
+
 TEST(UtilsTest, ShellFormat) {
     ASSERT_NO_THROW(util::FormatTerminal("message", util::kFGBlue, util::kBGRed,
                                          {util::kBold, util::kItalic}));
@@ -26,3 +60,100 @@ TEST(UtilsTest, FormatHex32) {
     ASSERT_STREQ("0x00000000", util::FormatHex32(0U).c_str());
     ASSERT_STREQ("0x0000024a", util::FormatHex32(586U).c_str());
 }
+
+TEST(UtilsTest, SmallVector) {
+    util::SmallVector<int, 2> vec;
+    EXPECT_TRUE(vec.empty());
+    for (int i = 0; i < 5; ++i) vec.push_back(i);
+    ASSERT_EQ(5, vec.size());
+    int sum = 0;
+    for (int value : vec) sum += value;
+    EXPECT_EQ(10, sum);
+    EXPECT_EQ(0, vec.front());
+    EXPECT_EQ(4, vec.back());
+
+    auto copy = vec;
+    vec.clear();
+    vec.push_back(7);
+    EXPECT_EQ(1, vec.size());
+    EXPECT_EQ(7, vec[0]);
+    EXPECT_EQ(3, copy[3]);
+
+    const auto &self = copy;
+    copy = self;
+    ASSERT_EQ(5, copy.size());
+    EXPECT_EQ(4, copy[4]);
+
+    // both on the heap and inline
+    auto moved = std::move(copy);
+    EXPECT_TRUE(copy.empty());
+    ASSERT_EQ(5, moved.size());
+    EXPECT_EQ(4, moved.back());
+    moved = std::move(vec);
+    EXPECT_TRUE(vec.empty());
+    ASSERT_EQ(1, moved.size());
+    EXPECT_EQ(7, moved[0]);
+}
+
+TEST(UtilsTest, Casting) {
+    Circle circle;
+    Rect square(Shape::kSquare);
+    Shape &shape = square;
+    const Shape *null = nullptr;
+
+    EXPECT_TRUE(util::isa<Shape>(circle));
+    EXPECT_TRUE(util::isa<Circle>(&circle));
+    EXPECT_FALSE(util::isa<Rect>(circle));
+    EXPECT_TRUE(util::isa<Rect>(shape));
+    EXPECT_FALSE(util::isa<Circle>(null));
+
+    EXPECT_EQ(&square, &util::cast<Rect>(shape));
+    const Shape &const_shape = shape;
+    EXPECT_EQ(&square, &util::cast<Rect>(const_shape));
+    EXPECT_EQ(&square, util::dyn_cast<Rect>(&shape));
+    EXPECT_EQ(nullptr, util::dyn_cast<Circle>(&shape));
+    EXPECT_EQ(nullptr, util::dyn_cast<Rect>(null));
+}
+
+TEST(UtilsTest, FormatInt) {
+    char digit[20];
+    auto format = [&digit](long long value) {
+        return std::string(digit, util::FormatInt(digit, value));
+    };
+    EXPECT_EQ("0", format(0));
+    EXPECT_EQ("7", format(7));
+    EXPECT_EQ("-10", format(-10));
+    EXPECT_EQ("123456789", format(123456789));
+    EXPECT_EQ(std::to_string(INT_MIN), format(INT_MIN));
+    EXPECT_EQ(std::to_string(LLONG_MIN), format(LLONG_MIN));
+    EXPECT_EQ(std::to_string(ULLONG_MAX),
+              std::string(digit, util::FormatUInt(digit, ULLONG_MAX)));
+    EXPECT_EQ("0x0000beef", util::FormatHex32(0xbeef));
+}
+
+TEST(UtilsTest, Emitter) {
+    std::string str;
+    util::Emitter emitter(str);
+    emitter << "r" << 12 << ", #" << -3 << ' ' << std::string("x") << 4UL;
+    EXPECT_EQ("r12, #-3 x4", str);
+
+    str.clear();
+    emitter << util::Colored{"text", util::kFGBlue, true};
+    EXPECT_EQ(util::FormatTerminalBold("text", util::kFGBlue), str);
+    str.clear();
+    emitter.SetColor(false);
+    emitter << util::Colored{"text", util::kFGBlue, true};
+    EXPECT_EQ("text", str);
+
+    // the buffer goes to the ostream when it fills up and on Flush
+    std::ostringstream ostream;
+    const std::string line(1000, 'x');
+    {
+        util::Emitter buffered(ostream);
+        for (int i = 0; i < 100; ++i) buffered << line << '\n';
+        EXPECT_GT(100 * 1001, ostream.str().size());
+        buffered << std::string(util::Emitter::kBufferSize + 1, 'y');
+    }
+    EXPECT_EQ(100 * 1001 + util::Emitter::kBufferSize + 1,
+              ostream.str().size());
+}
@@ -0,0 +1,60 @@
+#include "ir/arena.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <memory>
+
+#include "ir/ir.h"
+#include "ir/value.h"
+
+TEST(ArenaTest, Allocate) {
+    ir::Arena arena;
+    auto *c = static_cast<char *>(arena.Allocate(1, 1));
+    auto *i = static_cast<int *>(arena.Allocate(sizeof(int), alignof(int)));
+    EXPECT_EQ(0, reinterpret_cast<std::uintptr_t>(i) % alignof(int));
+    EXPECT_LT(c, reinterpret_cast<char *>(i));
+    const auto capacity = arena.GetCapacity();
+
+    // a request bigger than a chunk gets its own, the next small one still
+    // comes from the current chunk
+    arena.Allocate(1 << 20, 8);
+    EXPECT_LE(capacity + (1 << 20), arena.GetCapacity());
+    auto *next = static_cast<int *>(arena.Allocate(sizeof(int), alignof(int)));
+    EXPECT_EQ(i + 1, next);
+}
+
+TEST(ArenaTest, Make) {
+    auto module = std::make_shared<ir::Module>();
+    auto imm = module->Make<ir::Imm>(42);
+    EXPECT_EQ(42, imm->GetValue());
+    EXPECT_LT(0, module->GetArena().GetCapacity());
+
+    // the interned types are shared by every value
+    auto var = module->Make<ir::TmpVar>(1);
+    EXPECT_EQ(imm->GetTypePtr(), var->GetTypePtr());
+
+    std::weak_ptr<ir::Imm> weak = imm;
+    EXPECT_EQ(2, module->GetArena().GetLiveNum());
+    imm.reset();
+    EXPECT_TRUE(weak.expired());
+    var.reset();
+    // the count stays with the block until the weak_ptr goes too
+    EXPECT_EQ(1, module->GetArena().GetLiveNum());
+    weak.reset();
+    EXPECT_EQ(0, module->GetArena().GetLiveNum());
+}
+
+#ifndef NDEBUG
+TEST(ArenaDeathTest, Outlive) {
+    EXPECT_DEATH(
+        {
+            std::shared_ptr<ir::Imm> imm;
+            {
+                ir::Module module;
+                imm = module.Make<ir::Imm>(42);
+            }
+        },
+        "outlives its arena");
+}
+#endif
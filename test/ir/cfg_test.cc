@@ -0,0 +1,81 @@
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <vector>
+
+#include "ir/ir.h"
+#include "ir/type.h"
+#include "ir/value.h"
+
+using ir::BasicBlock;
+using ir::TmpVar;
+
+namespace {
+
+std::shared_ptr<BasicBlock> AddBlock(ir::FuncDef &func, const int id) {
+    auto bb = std::make_shared<BasicBlock>(
+        std::make_shared<TmpVar>(std::make_shared<ir::LabelType>(), id));
+    func.AddBlock(bb);
+    return bb;
+}
+
+// void @func(i32 %0) { %1: br %2  %2: br %0, %2, %3  %3: ret }
+std::shared_ptr<ir::FuncDef> MakeLoop() {
+    auto param = std::make_shared<TmpVar>(
+        std::make_shared<ir::IntType>(ir::IntType::kI1), 0);
+    auto func = std::make_shared<ir::FuncDef>(
+        std::make_shared<ir::GlobalVar>(
+            new ir::FuncType(new ir::VoidType(),
+                             std::vector<ir::Type *>{
+                                 new ir::IntType(ir::IntType::kI1)}),
+            "func"),
+        std::vector<std::shared_ptr<TmpVar>>{param});
+    auto entry = AddBlock(*func, 1);
+    auto loop = AddBlock(*func, 2);
+    auto exit = AddBlock(*func, 3);
+    entry->AddInst(std::make_shared<ir::BrInst>(loop->GetLabelPtr()));
+    loop->AddInst(std::make_shared<ir::BrInst>(param, loop->GetLabelPtr(),
+                                               exit->GetLabelPtr()));
+    exit->AddInst(std::make_shared<ir::RetInst>());
+    return func;
+}
+
+}  // namespace
+
+TEST(CFGTest, ComputeCFG) {
+    auto func = MakeLoop();
+    func->ComputeCFG();
+    auto iter = func->GetBlockList().begin();
+    auto *entry = (iter++)->get();
+    auto *loop = (iter++)->get();
+    auto *exit = iter->get();
+
+    ASSERT_EQ(1, entry->GetSuccessorNum());
+    EXPECT_EQ(loop, entry->GetSuccessorList()[0]);
+    EXPECT_EQ(0, entry->GetPredecessorNum());
+    ASSERT_EQ(2, loop->GetSuccessorNum());
+    EXPECT_EQ(loop, loop->GetSuccessorList()[0]);
+    EXPECT_EQ(exit, loop->GetSuccessorList()[1]);
+    ASSERT_EQ(2, loop->GetPredecessorNum());
+    EXPECT_EQ(entry, loop->GetPredecessorList()[0]);
+    EXPECT_EQ(loop, loop->GetPredecessorList()[1]);
+    ASSERT_EQ(1, exit->GetPredecessorNum());
+    EXPECT_EQ(0, exit->GetSuccessorNum());
+
+    // retargeting a branch shows after the edges are computed again
+    entry->GetInstList().back()
+        = std::make_shared<ir::BrInst>(exit->GetLabelPtr());
+    func->ComputeCFG();
+    EXPECT_EQ(exit, entry->GetSuccessorList()[0]);
+    EXPECT_EQ(1, loop->GetPredecessorNum());
+    EXPECT_EQ(2, exit->GetPredecessorNum());
+}
+
+// a loop does not keep its blocks alive once the function is gone
+TEST(CFGTest, NoCycle) {
+    auto func = MakeLoop();
+    func->ComputeCFG();
+    std::weak_ptr<BasicBlock> loop = *std::next(func->GetBlockList().begin());
+    func.reset();
+    EXPECT_TRUE(loop.expired());
+}
@@ -0,0 +1,235 @@
+#include "ir/interpreter.h"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "emitter.h"
+#include "error.h"
+#include "ir/ir.h"
+#include "ir/type.h"
+#include "ir/value.h"
+
+using ir::BasicBlock;
+using ir::Imm;
+using ir::TmpVar;
+
+namespace {
+
+std::shared_ptr<ir::FuncDef> AddMain(ir::Module &module) {
+    auto main = std::make_shared<ir::FuncDef>(
+        std::make_shared<ir::GlobalVar>(
+            new ir::FuncType(new ir::IntType(ir::IntType::kI32),
+                             std::vector<ir::Type *>{}),
+            "main"),
+        std::vector<std::shared_ptr<TmpVar>>{});
+    module.AddFuncDef(main);
+    return main;
+}
+
+std::shared_ptr<BasicBlock> AddBlock(ir::FuncDef &func, const int id) {
+    auto bb = std::make_shared<BasicBlock>(
+        std::make_shared<TmpVar>(ir::LabelType::Get(), id));
+    func.AddBlock(bb);
+    return bb;
+}
+
+std::shared_ptr<ir::GlobalVar> Builtin(const std::string &name,
+                                       std::vector<ir::Type *> param_list) {
+    return std::make_shared<ir::GlobalVar>(
+        new ir::FuncType(new ir::VoidType(), param_list), name);
+}
+
+}  // namespace
+
+// sum 1 to 10 in a loop of phis, print it and return a global
+TEST(InterpreterTest, Loop) {
+    ir::Module module;
+    module.AddVar(std::make_shared<ir::GlobalVarDef>(
+        std::make_shared<ir::GlobalVar>(ir::IntType::Get(ir::IntType::kI32),
+                                        "g"),
+        false, std::vector<std::shared_ptr<Imm>>{std::make_shared<Imm>(5)},
+        false));
+    auto main = AddMain(module);
+    auto entry = AddBlock(*main, 0);
+    auto loop = AddBlock(*main, 1);
+    auto exit = AddBlock(*main, 7);
+
+    auto i = std::make_shared<TmpVar>(2);
+    auto sum = std::make_shared<TmpVar>(3);
+    auto next_i = std::make_shared<TmpVar>(4);
+    auto next_sum = std::make_shared<TmpVar>(5);
+    auto cond = std::make_shared<TmpVar>(ir::IntType::Get(ir::IntType::kI1),
+                                         6);
+    entry->AddInst(std::make_shared<ir::BrInst>(loop->GetLabelPtr()));
+    loop->AddInst(std::make_shared<ir::PhiInst>(
+        i, std::vector<ir::PhiInst::PhiValue>{
+               {std::make_shared<Imm>(0), entry->GetLabelPtr()},
+               {next_i, loop->GetLabelPtr()}}));
+    loop->AddInst(std::make_shared<ir::PhiInst>(
+        sum, std::vector<ir::PhiInst::PhiValue>{
+                 {std::make_shared<Imm>(0), entry->GetLabelPtr()},
+                 {next_sum, loop->GetLabelPtr()}}));
+    loop->AddInst(std::make_shared<ir::BinaryOpInst>(
+        ir::BinaryOpInst::kAdd, next_i, i, std::make_shared<Imm>(1)));
+    loop->AddInst(std::make_shared<ir::BinaryOpInst>(ir::BinaryOpInst::kAdd,
+                                                     next_sum, sum, next_i));
+    loop->AddInst(std::make_shared<ir::IcmpInst>(
+        ir::IcmpInst::kSLT, cond, next_i, std::make_shared<Imm>(10)));
+    loop->AddInst(std::make_shared<ir::BrInst>(cond, loop->GetLabelPtr(),
+                                               exit->GetLabelPtr()));
+    exit->AddInst(std::make_shared<ir::CallInst>(
+        Builtin("putint", {new ir::IntType(ir::IntType::kI32)}),
+        std::vector<std::shared_ptr<ir::Value>>{next_sum}));
+    auto value = std::make_shared<TmpVar>(8);
+    exit->AddInst(std::make_shared<ir::LoadInst>(
+        value, std::make_shared<ir::GlobalVar>(ir::PtrType::Get(), "g")));
+    exit->AddInst(std::make_shared<ir::RetInst>(value));
+
+    std::istringstream input;
+    std::string output;
+    util::Emitter emitter(output);
+    ir::Interpreter interpreter(module, input, emitter);
+    EXPECT_EQ(5, interpreter.Run());
+    EXPECT_EQ("55", output);
+
+    EXPECT_EQ(1, interpreter.GetBlockCount("main", "%0"));
+    EXPECT_EQ(10, interpreter.GetBlockCount("main", "%1"));
+    EXPECT_EQ(1, interpreter.GetBlockCount("main", "%7"));
+    EXPECT_EQ(1 + 6 * 10 + 3, interpreter.GetInstCount());
+    const auto op_count = interpreter.GetOpCount();
+    EXPECT_EQ(20, op_count.at("add"));
+    EXPECT_EQ(20, op_count.at("phi"));
+    EXPECT_EQ(11, op_count.at("br"));
+    EXPECT_EQ(1, op_count.at("call"));
+}
+
+// read an array with getarray into a local [2 x [3 x i32]], print its second
+// row and load an element through a gep with a variable index
+TEST(InterpreterTest, Array) {
+    ir::Module module;
+    auto main = AddMain(module);
+    auto entry = AddBlock(*main, 0);
+
+    auto array_type = std::make_shared<ir::ArrayType>(std::vector<int>{2, 3});
+    auto array = std::make_shared<TmpVar>(
+        std::make_shared<ir::PtrType>(array_type), 1);
+    auto row = std::make_shared<TmpVar>(ir::PtrType::Get(), 2);
+    auto elem = std::make_shared<TmpVar>(ir::PtrType::Get(), 3);
+    auto num = std::make_shared<TmpVar>(4);
+    auto value = std::make_shared<TmpVar>(5);
+    entry->AddInst(std::make_shared<ir::AllocaInst>(array));
+    entry->AddInst(std::make_shared<ir::BitcastInst>(row, array));
+    entry->AddInst(std::make_shared<ir::CallInst>(
+        num, Builtin("getarray", {new ir::PtrType()}),
+        std::vector<std::shared_ptr<ir::Value>>{row}));
+    entry->AddInst(std::make_shared<ir::GetelementptrInst>(
+        row, array,
+        std::vector<std::shared_ptr<ir::Value>>{std::make_shared<Imm>(0),
+                                                std::make_shared<Imm>(1),
+                                                std::make_shared<Imm>(0)}));
+    entry->AddInst(std::make_shared<ir::CallInst>(
+        Builtin("putarray", {new ir::IntType(ir::IntType::kI32),
+                             new ir::PtrType()}),
+        std::vector<std::shared_ptr<ir::Value>>{std::make_shared<Imm>(3),
+                                                row}));
+    entry->AddInst(std::make_shared<ir::GetelementptrInst>(
+        elem, array,
+        std::vector<std::shared_ptr<ir::Value>>{std::make_shared<Imm>(0),
+                                                std::make_shared<Imm>(-1),
+                                                num}));
+    entry->AddInst(std::make_shared<ir::LoadInst>(value, elem));
+    entry->AddInst(std::make_shared<ir::RetInst>(value));
+
+    std::istringstream input("6\n1 2 3 4 5 6\n");
+    std::string output;
+    util::Emitter emitter(output);
+    ir::Interpreter interpreter(module, input, emitter);
+    // [0][-1][6] is [1][0]
+    EXPECT_EQ(4, interpreter.Run());
+    EXPECT_EQ("3: 4 5 6\n", output);
+}
+
+// -1 is the greatest unsigned and the least signed
+TEST(InterpreterTest, UnsignedCompare) {
+    ir::Module module;
+    auto main = AddMain(module);
+    auto entry = AddBlock(*main, 0);
+    auto less = AddBlock(*main, 2);
+    auto greater = AddBlock(*main, 3);
+    auto cond = std::make_shared<TmpVar>(ir::IntType::Get(ir::IntType::kI1), 1);
+    entry->AddInst(std::make_shared<ir::IcmpInst>(
+        ir::IcmpInst::kUGT, cond, std::make_shared<Imm>(-1),
+        std::make_shared<Imm>(1)));
+    entry->AddInst(std::make_shared<ir::BrInst>(
+        cond, greater->GetLabelPtr(), less->GetLabelPtr()));
+    less->AddInst(std::make_shared<ir::RetInst>(std::make_shared<Imm>(0)));
+    greater->AddInst(std::make_shared<ir::RetInst>(std::make_shared<Imm>(1)));
+
+    std::istringstream input;
+    std::string output;
+    util::Emitter emitter(output);
+    ir::Interpreter interpreter(module, input, emitter);
+    EXPECT_EQ(1, interpreter.Run());
+}
+
+TEST(InterpreterTest, Error) {
+    ir::Module module;
+    auto main = AddMain(module);
+    auto entry = AddBlock(*main, 0);
+    auto quotient = std::make_shared<TmpVar>(1);
+    entry->AddInst(std::make_shared<ir::BinaryOpInst>(
+        ir::BinaryOpInst::kSDiv, quotient, std::make_shared<Imm>(1),
+        std::make_shared<Imm>(0)));
+    entry->AddInst(std::make_shared<ir::RetInst>(quotient));
+
+    std::istringstream input;
+    std::string output;
+    util::Emitter emitter(output);
+    ir::Interpreter interpreter(module, input, emitter);
+    EXPECT_THROW(interpreter.Run(), RuntimeErrorException);
+}
+
+// a global as big as int x[600][600][600] fits, its pages are only
+// allocated when touched; one past the limit is rejected up front
+TEST(InterpreterTest, LargeGlobal) {
+    const auto add_global = [](ir::Module &module, const std::string &name,
+                               std::vector<int> dim_list) {
+        module.AddVar(std::make_shared<ir::GlobalVarDef>(
+            std::make_shared<ir::GlobalVar>(
+                std::make_shared<ir::ArrayType>(std::move(dim_list)), name),
+            false, std::vector<std::shared_ptr<Imm>>{}, true));
+    };
+    ir::Module module;
+    add_global(module, "x", {600, 600, 600});
+    auto main = AddMain(module);
+    auto entry = AddBlock(*main, 0);
+    auto elem = std::make_shared<TmpVar>(ir::PtrType::Get(), 1);
+    auto value = std::make_shared<TmpVar>(2);
+    entry->AddInst(std::make_shared<ir::GetelementptrInst>(
+        elem,
+        std::make_shared<ir::GlobalVar>(
+            std::make_shared<ir::PtrType>(std::make_shared<ir::ArrayType>(
+                std::vector<int>{600, 600, 600})),
+            "x"),
+        std::vector<std::shared_ptr<ir::Value>>{
+            std::make_shared<Imm>(0), std::make_shared<Imm>(599),
+            std::make_shared<Imm>(599), std::make_shared<Imm>(599)}));
+    entry->AddInst(std::make_shared<ir::StoreInst>(std::make_shared<Imm>(7),
+                                                   elem));
+    entry->AddInst(std::make_shared<ir::LoadInst>(value, elem));
+    entry->AddInst(std::make_shared<ir::RetInst>(value));
+
+    std::istringstream input;
+    std::string output;
+    util::Emitter emitter(output);
+    ir::Interpreter interpreter(module, input, emitter);
+    EXPECT_EQ(7, interpreter.Run());
+
+    add_global(module, "y", {ir::Interpreter::kMaxMemory - 600 * 600 * 600});
+    EXPECT_THROW(ir::Interpreter(module, input, emitter),
+                 RuntimeErrorException);
+}
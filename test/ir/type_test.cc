@@ -37,3 +37,9 @@ TEST(TypeTest, ArrayType) {
     ArrayType array({4, 2, 1});
     EXPECT_STREQ("[4 x [2 x [1 x i32]]]", array.Str().c_str());
 }
+
+TEST(TypeTest, VectorType) {
+    EXPECT_STREQ("<4 x i32>", VectorType::Get()->Str().c_str());
+    EXPECT_EQ(4, VectorType::Get()->GetLaneNum());
+    EXPECT_STREQ("<4 x i32>*", PtrType(VectorType::Get()).Str().c_str());
+}
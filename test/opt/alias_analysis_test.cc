@@ -0,0 +1,129 @@
+#include "opt/alias_analysis.h"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "ir/ir.h"
+#include "ir/type.h"
+#include "ir/value.h"
+#include "ir_builder.h"
+
+using ir::TmpVar;
+using opt::AliasAnalysis;
+
+// i32 @func(i32* %0, i32* %1, i32 %2) over the globals @g, @h of
+// [10 x i32] and @m of [2 x [3 x i32]]
+class AliasAnalysisTest : public IRBuilderTest {
+  protected:
+    AliasAnalysisTest()
+        : IRBuilderTest({ir::Type::kPtr, ir::Type::kPtr, ir::Type::kInt}) {}
+
+    std::shared_ptr<TmpVar> p = param_list[0];
+    std::shared_ptr<TmpVar> q = param_list[1];
+    std::shared_ptr<TmpVar> n = param_list[2];
+    std::shared_ptr<ir::BasicBlock> entry = AddBlock();
+
+    std::shared_ptr<ir::GlobalVar> g = Global("g", {10});
+    std::shared_ptr<ir::GlobalVar> h = Global("h", {10});
+    std::shared_ptr<ir::GlobalVar> m = Global("m", {2, 3});
+
+    std::shared_ptr<TmpVar> Alloca(std::shared_ptr<ir::Type> type) {
+        auto result = NewVar(std::make_shared<ir::PtrType>(std::move(type)));
+        entry->AddInst(std::make_shared<ir::AllocaInst>(result));
+        return result;
+    }
+
+    std::shared_ptr<TmpVar> GEP(std::shared_ptr<ir::Var> ptr,
+                                std::vector<std::shared_ptr<ir::Value>> idx) {
+        return IRBuilderTest::GEP(entry, ptr, std::move(idx));
+    }
+
+    std::shared_ptr<TmpVar> Add(std::shared_ptr<ir::Value> lhs, const int rhs) {
+        return IRBuilderTest::Add(entry, lhs, I(rhs));
+    }
+};
+
+TEST_F(AliasAnalysisTest, Alias) {
+    auto n1 = Add(n, 1);
+    auto g_n = GEP(g, {I(0), n});
+    auto g_n1 = GEP(g, {I(0), n1});
+    auto g_n1_again = GEP(g, {I(0), n1});
+    auto h_n = GEP(h, {I(0), n});
+    // m[n][1] and m[n + 1][-2] are the same word
+    auto m_n = GEP(m, {I(0), n, I(1)});
+    auto m_n1 = GEP(m, {I(0), n1, I(-2)});
+
+    AliasAnalysis alias_analysis(func);
+    EXPECT_EQ(AliasAnalysis::kNoAlias, alias_analysis.Alias(*g_n, *h_n));
+    EXPECT_EQ(AliasAnalysis::kNoAlias, alias_analysis.Alias(*g_n, *g_n1));
+    EXPECT_EQ(AliasAnalysis::kMustAlias,
+              alias_analysis.Alias(*g_n1, *g_n1_again));
+    EXPECT_EQ(AliasAnalysis::kMustAlias, alias_analysis.Alias(*m_n, *m_n1));
+    EXPECT_EQ(AliasAnalysis::kNoAlias, alias_analysis.Alias(*g_n, *m_n));
+    EXPECT_EQ(AliasAnalysis::kNoAlias, alias_analysis.Alias(*g_n, *m));
+}
+
+// the parameter the frontend keeps in a slot is followed through it
+TEST_F(AliasAnalysisTest, Param) {
+    auto slot = Alloca(ir::PtrType::Get());
+    entry->AddInst(std::make_shared<ir::StoreInst>(p, slot));
+    auto loaded = std::make_shared<TmpVar>(ir::PtrType::Get(), next_id++);
+    entry->AddInst(std::make_shared<ir::LoadInst>(loaded, slot));
+    auto n1 = Add(n, 1);
+    auto p_n = GEP(loaded, {n});
+    auto p_n1 = GEP(p, {n1});
+    auto p_n_again = GEP(p, {n});
+    auto q_n = GEP(q, {n});
+    auto g_n = GEP(g, {I(0), n});
+    auto local = GEP(Alloca(std::make_shared<ir::ArrayType>(
+                         std::vector<int>{4})),
+                     {I(0), n});
+
+    AliasAnalysis alias_analysis(func);
+    EXPECT_EQ(AliasAnalysis::kNoAlias, alias_analysis.Alias(*p_n, *p_n1));
+    EXPECT_EQ(AliasAnalysis::kMustAlias,
+              alias_analysis.Alias(*p_n, *p_n_again));
+    EXPECT_EQ(AliasAnalysis::kMayAlias, alias_analysis.Alias(*p_n, *q_n));
+    EXPECT_EQ(AliasAnalysis::kMayAlias, alias_analysis.Alias(*p_n, *g_n));
+    EXPECT_EQ(AliasAnalysis::kNoAlias, alias_analysis.Alias(*p_n, *local));
+
+    AliasAnalysis noalias(func, true);
+    EXPECT_EQ(AliasAnalysis::kNoAlias, noalias.Alias(*p_n, *q_n));
+    EXPECT_EQ(AliasAnalysis::kNoAlias, noalias.Alias(*p_n, *g_n));
+    EXPECT_EQ(AliasAnalysis::kNoAlias, noalias.Alias(*p_n, *p_n1));
+}
+
+// an alloca whose address goes into a call escapes
+TEST_F(AliasAnalysisTest, Escape) {
+    auto array_type = std::make_shared<ir::ArrayType>(std::vector<int>{4});
+    auto local = GEP(Alloca(array_type), {I(0), I(1)});
+    auto passed = GEP(Alloca(array_type), {I(0), I(1)});
+    auto call = std::make_shared<ir::CallInst>(
+        std::make_shared<ir::GlobalVar>(
+            new ir::FuncType(new ir::VoidType(),
+                             std::vector<ir::Type *>{new ir::PtrType()}),
+            "use"),
+        std::vector<std::shared_ptr<ir::Value>>{passed});
+    entry->AddInst(call);
+    // defined nowhere the analysis can see
+    auto unknown = std::make_shared<TmpVar>(ir::PtrType::Get(), next_id++);
+
+    AliasAnalysis alias_analysis(func);
+    EXPECT_TRUE(alias_analysis.IsPrivate(*local));
+    EXPECT_FALSE(alias_analysis.IsPrivate(*passed));
+    EXPECT_EQ(AliasAnalysis::kNoAlias, alias_analysis.Alias(*local, *passed));
+    EXPECT_EQ(AliasAnalysis::kNoAlias, alias_analysis.Alias(*unknown, *local));
+    EXPECT_EQ(AliasAnalysis::kMayAlias,
+              alias_analysis.Alias(*unknown, *passed));
+    EXPECT_EQ(AliasAnalysis::kNoModRef,
+              alias_analysis.GetModRef(*call, *local));
+    EXPECT_EQ(AliasAnalysis::kModRef, alias_analysis.GetModRef(*call, *passed));
+
+    auto store = std::make_shared<ir::StoreInst>(I(1), local);
+    EXPECT_EQ(AliasAnalysis::kMod, alias_analysis.GetModRef(*store, *local));
+    EXPECT_EQ(AliasAnalysis::kNoModRef,
+              alias_analysis.GetModRef(*store, *passed));
+}
@@ -0,0 +1,107 @@
+#include "opt/block_placement.h"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <vector>
+
+#include "ir/ir.h"
+#include "ir/type.h"
+#include "ir/value.h"
+#include "ir_builder.h"
+
+using ir::BasicBlock;
+
+// i32 @func(i32 %0) with blocks added by AddBlock
+class BlockPlacementTest : public IRBuilderTest {
+  protected:
+    // br (%0 <op> 0), if_true, if_false
+    void Branch(const std::shared_ptr<BasicBlock> &bb,
+                const ir::IcmpInst::CmpKind op,
+                const std::shared_ptr<BasicBlock> &if_true,
+                const std::shared_ptr<BasicBlock> &if_false) {
+        auto cond = NewVar(ir::IntType::Get(ir::IntType::kI1));
+        bb->AddInst(
+            std::make_shared<ir::IcmpInst>(op, cond, param_list[0], I(0)));
+        bb->AddInst(std::make_shared<ir::BrInst>(
+            cond, if_true->GetLabelPtr(), if_false->GetLabelPtr()));
+    }
+
+    static void Jump(const std::shared_ptr<BasicBlock> &bb,
+                     const std::shared_ptr<BasicBlock> &dest) {
+        bb->AddInst(std::make_shared<ir::BrInst>(dest->GetLabelPtr()));
+    }
+
+    static void Ret(const std::shared_ptr<BasicBlock> &bb) {
+        bb->AddInst(std::make_shared<ir::RetInst>(I(0)));
+    }
+
+    std::vector<std::shared_ptr<BasicBlock>> Order() const {
+        return {func.GetBlockList().begin(), func.GetBlockList().end()};
+    }
+};
+
+// while (%0 != 0) {}: the body falls through to the test at the bottom
+TEST_F(BlockPlacementTest, Loop) {
+    auto entry = AddBlock();
+    auto header = AddBlock();
+    auto body = AddBlock();
+    auto exit = AddBlock();
+    Jump(entry, header);
+    Branch(header, ir::IcmpInst::kNE, body, exit);
+    Jump(body, header);
+    Ret(exit);
+
+    opt::BlockPlacement block_placement;
+    EXPECT_LT(0, block_placement.Run(func));
+    EXPECT_EQ((std::vector<std::shared_ptr<BasicBlock>>{entry, body, header,
+                                                        exit}),
+              Order());
+    // numbered again in the new order
+    EXPECT_EQ("%2", body->GetLabel().Str());
+
+    EXPECT_EQ(0, block_placement.Run(func));
+}
+
+// an equality is unlikely to hold, so the else arm falls through
+TEST_F(BlockPlacementTest, Static) {
+    auto entry = AddBlock();
+    auto then_bb = AddBlock();
+    auto else_bb = AddBlock();
+    auto join = AddBlock();
+    Branch(entry, ir::IcmpInst::kEQ, then_bb, else_bb);
+    Jump(then_bb, join);
+    Jump(else_bb, join);
+    Ret(join);
+
+    opt::BlockPlacement block_placement;
+    EXPECT_LT(0, block_placement.Run(func));
+    EXPECT_EQ((std::vector<std::shared_ptr<BasicBlock>>{entry, else_bb, join,
+                                                        then_bb}),
+              Order());
+}
+
+// the counts win over the heuristics, and a block that never ran goes last
+TEST_F(BlockPlacementTest, Profile) {
+    auto entry = AddBlock();
+    auto then_bb = AddBlock();
+    auto cold = AddBlock();
+    auto else_bb = AddBlock();
+    auto join = AddBlock();
+    Branch(entry, ir::IcmpInst::kNE, then_bb, else_bb);
+    Branch(then_bb, ir::IcmpInst::kNE, cold, join);
+    Jump(cold, join);
+    Jump(else_bb, join);
+    Ret(join);
+    entry->SetCount(10);
+    then_bb->SetCount(3);
+    cold->SetCount(0);
+    else_bb->SetCount(7);
+    join->SetCount(10);
+
+    opt::BlockPlacement block_placement;
+    EXPECT_LT(0, block_placement.Run(func));
+    EXPECT_EQ((std::vector<std::shared_ptr<BasicBlock>>{entry, else_bb, join,
+                                                        then_bb, cold}),
+              Order());
+}
@@ -0,0 +1,120 @@
+#include "opt/dependence.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "ir/ir.h"
+#include "ir/type.h"
+#include "ir/value.h"
+#include "ir_builder.h"
+#include "opt/alias_analysis.h"
+#include "opt/cfg.h"
+
+using ir::TmpVar;
+using opt::DependenceAnalysis;
+
+// i32 @func(i32 %0) over the globals @a and @b of [64 x [64 x i32]]:
+//   for (i = 0; i < %0; ++i) for (j = 0; j < %0; ++j) body
+class DependenceTest : public LoopNestTest {
+  protected:
+    std::shared_ptr<TmpVar> param = param_list[0];
+    std::shared_ptr<ir::GlobalVar> a = Global("a", {64, 64});
+    std::shared_ptr<ir::GlobalVar> b = Global("b", {64, 64});
+
+    void Finish() { LoopNestTest::Finish(param, I(0), param); }
+
+    DependenceAnalysis Analyze() {
+        Finish();
+        opt::Graph graph(func);
+        const auto nest_list
+            = opt::FindPerfectNests(graph, opt::Dominator(graph));
+        EXPECT_EQ(1, nest_list.size());
+        return DependenceAnalysis(graph, nest_list.at(0).block_list,
+                                  {i->Str(), j->Str()},
+                                  opt::AliasAnalysis(func));
+    }
+};
+
+TEST_F(DependenceTest, Nest) {
+    Store(a, i, j, I(1));
+    Finish();
+    opt::Graph graph(func);
+    const auto nest_list = opt::FindPerfectNests(graph, opt::Dominator(graph));
+    ASSERT_EQ(1, nest_list.size());
+    const auto &nest = nest_list[0];
+    EXPECT_EQ(i->Str(), nest.outer.phi->GetResult().Str());
+    EXPECT_EQ(j->Str(), nest.inner.phi->GetResult().Str());
+    EXPECT_EQ(nest.outer.latch, nest.inner.exit);
+    EXPECT_EQ(nest.outer.header, nest.inner.preheader);
+    EXPECT_EQ(4, nest.block_list.size());
+
+    // the induction variable of the outer loop used after it
+    exit->GetInstList().clear();
+    exit->AddInst(std::make_shared<ir::RetInst>(i));
+    opt::Graph escaped(func);
+    EXPECT_TRUE(
+        opt::FindPerfectNests(escaped, opt::Dominator(escaped)).empty());
+}
+
+// b[j][i] = a[i][j]: nothing depends, a row of b is a column of a
+TEST_F(DependenceTest, Transpose) {
+    Store(b, j, i, Load(a, i, j));
+    const auto dependence = Analyze();
+    EXPECT_TRUE(dependence.GetDirectionList().empty());
+    EXPECT_EQ((std::vector<std::int64_t>{64, 1}), dependence.GetStrideList(0));
+    EXPECT_EQ((std::vector<std::int64_t>{1, 64}), dependence.GetStrideList(1));
+    EXPECT_TRUE(dependence.CanInterchange(0));
+    EXPECT_TRUE(dependence.CanTile(0));
+}
+
+// a[i][j] = a[i - 1][j + 1] reads what the iteration of the outer loop
+// before wrote on a later one of the inner loop
+TEST_F(DependenceTest, Carried) {
+    Store(a, i, j, Load(a, Add(body, i, I(-1)), Add(body, j, I(1))));
+    const auto dependence = Analyze();
+    EXPECT_EQ((std::vector<DependenceAnalysis::Direction>{{1, -1}}),
+              dependence.GetDirectionList());
+    EXPECT_FALSE(dependence.CanInterchange(0));
+    EXPECT_FALSE(dependence.CanTile(0));
+}
+
+// a[i][j] = a[i][j - 1] + a[i - 2][j] goes forward on both
+TEST_F(DependenceTest, Forward) {
+    auto sum = Add(body, Load(a, i, Add(body, j, I(-1))),
+                   Load(a, Add(body, i, I(-2)), j));
+    Store(a, i, j, sum);
+    const auto dependence = Analyze();
+    EXPECT_EQ((std::vector<DependenceAnalysis::Direction>{{1, 0}, {0, 1}}),
+              dependence.GetDirectionList());
+    EXPECT_TRUE(dependence.CanInterchange(0));
+    EXPECT_TRUE(dependence.CanTile(0));
+}
+
+// a[%0][j] and a[i * i][j] may be any row
+TEST_F(DependenceTest, Unknown) {
+    auto square = std::make_shared<TmpVar>(next_id++);
+    body->AddInst(std::make_shared<ir::BinaryOpInst>(ir::BinaryOpInst::kMul,
+                                                     square, i, i));
+    Store(a, square, j, Load(a, param, j));
+    const auto dependence = Analyze();
+    EXPECT_EQ(DependenceAnalysis::kUnknownStride,
+              dependence.GetStrideList(0)[1]);
+    EXPECT_FALSE(dependence.CanInterchange(0));
+}
+
+// a call may depend on itself in any direction
+TEST_F(DependenceTest, Call) {
+    body->AddInst(std::make_shared<ir::CallInst>(
+        std::make_shared<ir::GlobalVar>(
+            new ir::FuncType(new ir::VoidType(),
+                             std::vector<ir::Type *>{
+                                 new ir::IntType(ir::IntType::kI32)}),
+            "putint"),
+        std::vector<std::shared_ptr<ir::Value>>{i}));
+    const auto dependence = Analyze();
+    EXPECT_EQ(4, dependence.GetDirectionList().size());
+    EXPECT_FALSE(dependence.CanInterchange(0));
+}
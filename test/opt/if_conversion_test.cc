@@ -0,0 +1,101 @@
+#include "opt/if_conversion.h"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+
+#include "ir/ir.h"
+#include "ir/type.h"
+#include "ir/value.h"
+#include "ir_builder.h"
+
+using ir::TmpVar;
+
+// i32 @func(i32 %0, i32 %1) with blocks entry, %2, ...
+class IfConversionTest : public IRBuilderTest {
+  protected:
+    IfConversionTest() : IRBuilderTest({ir::Type::kInt, ir::Type::kInt}) {}
+
+    const std::shared_ptr<TmpVar> &param0 = param_list[0];
+    const std::shared_ptr<TmpVar> &param1 = param_list[1];
+    std::shared_ptr<ir::GlobalVar> global = std::make_shared<ir::GlobalVar>(
+        std::make_shared<ir::PtrType>(), "g");
+};
+
+// if (%0 > %1) g = %0; else g = %1; return g;
+TEST_F(IfConversionTest, Diamond) {
+    auto entry = AddBlock("entry");
+    auto then_bb = AddBlock(3);
+    auto else_bb = AddBlock(4);
+    auto join = AddBlock(5);
+
+    auto cond = std::make_shared<TmpVar>(
+        std::make_shared<ir::IntType>(ir::IntType::kI1), 2);
+    entry->AddInst(std::make_shared<ir::IcmpInst>(ir::IcmpInst::kSGT, cond,
+                                                  param0, param1));
+    entry->AddInst(std::make_shared<ir::BrInst>(
+        cond, then_bb->GetLabelPtr(), else_bb->GetLabelPtr()));
+    then_bb->AddInst(std::make_shared<ir::StoreInst>(param0, global));
+    then_bb->AddInst(std::make_shared<ir::BrInst>(join->GetLabelPtr()));
+    else_bb->AddInst(std::make_shared<ir::StoreInst>(param1, global));
+    else_bb->AddInst(std::make_shared<ir::BrInst>(join->GetLabelPtr()));
+    auto result = std::make_shared<TmpVar>(6);
+    join->AddInst(std::make_shared<ir::LoadInst>(result, global));
+    join->AddInst(std::make_shared<ir::RetInst>(result));
+
+    opt::IfConversion if_conversion;
+    EXPECT_EQ(1, if_conversion.Run(func));
+    EXPECT_EQ(
+        "define i32 @func(i32 %0, i32 %1) {\n"
+        "entry:\n"
+        "    %2 = icmp sgt i32 %0, %1\n"
+        "    %3 = select i1 %2, i32 %0, i32 %1\n"
+        "    store i32 %3, i32* @g\n"
+        "    %4 = load i32, i32* @g\n"
+        "    ret i32 %4\n"
+        "}\n\n",
+        Str());
+}
+
+// if (%0 != 0) g = %1 / %0; return 0;
+TEST_F(IfConversionTest, Unsafe) {
+    auto entry = AddBlock(2);
+    auto then_bb = AddBlock(4);
+    auto join = AddBlock(6);
+
+    auto cond = std::make_shared<TmpVar>(
+        std::make_shared<ir::IntType>(ir::IntType::kI1), 3);
+    entry->AddInst(
+        std::make_shared<ir::IcmpInst>(ir::IcmpInst::kNE, cond, param0, I(0)));
+    entry->AddInst(std::make_shared<ir::BrInst>(cond, then_bb->GetLabelPtr(),
+                                                join->GetLabelPtr()));
+    auto quotient = std::make_shared<TmpVar>(5);
+    then_bb->AddInst(std::make_shared<ir::BinaryOpInst>(
+        ir::BinaryOpInst::kSDiv, quotient, param1, param0));
+    then_bb->AddInst(std::make_shared<ir::StoreInst>(quotient, global));
+    then_bb->AddInst(std::make_shared<ir::BrInst>(join->GetLabelPtr()));
+    join->AddInst(std::make_shared<ir::RetInst>(I(0)));
+
+    const auto before = Str();
+    opt::IfConversion if_conversion;
+    EXPECT_EQ(0, if_conversion.Run(func));
+    EXPECT_EQ(before, Str());
+
+    // a division by a constant is fine, unless the arm costs too much
+    then_bb->GetInstList().front() = std::make_shared<ir::BinaryOpInst>(
+        ir::BinaryOpInst::kSDiv, quotient, param1, I(3));
+    opt::IfConversion cheap(3);
+    EXPECT_EQ(0, cheap.Run(func));
+    EXPECT_EQ(1, if_conversion.Run(func));
+    EXPECT_EQ(
+        "define i32 @func(i32 %0, i32 %1) {\n"
+        "2:\n"
+        "    %3 = icmp ne i32 %0, 0\n"
+        "    %4 = sdiv i32 %1, 3\n"
+        "    %5 = load i32, i32* @g\n"
+        "    %6 = select i1 %3, i32 %4, i32 %5\n"
+        "    store i32 %6, i32* @g\n"
+        "    ret i32 0\n"
+        "}\n\n",
+        Str());
+}
@@ -0,0 +1,234 @@
+#ifndef __sysycompiler_test_opt_ir_builder_h__
+#define __sysycompiler_test_opt_ir_builder_h__
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "ir/ir.h"
+#include "ir/type.h"
+#include "ir/value.h"
+
+// The base of the fixtures that build a function for a pass to run on:
+//   i32 @func(%0, %1, ...)
+// with a param of each kind given, kInt for i32 and kPtr for i32*. The
+// blocks and temporaries made after are numbered on from the params.
+class IRBuilderTest : public ::testing::Test {
+  protected:
+    explicit IRBuilderTest(
+        const std::vector<ir::Type::TypeKind> &param_kind_list = {
+            ir::Type::kInt},
+        const char *name = "func")
+        : param_list(Params(param_kind_list))
+        , func_def(std::make_shared<ir::FuncDef>(
+              Func(name, true, param_kind_list), param_list))
+        , next_id(static_cast<int>(param_list.size())) {}
+
+    const std::vector<std::shared_ptr<ir::TmpVar>> param_list;
+    // the function built, shared to be added to a module
+    const std::shared_ptr<ir::FuncDef> func_def;
+    ir::FuncDef &func = *func_def;
+    int next_id;
+
+    // a block labelled with the next number
+    std::shared_ptr<ir::BasicBlock> AddBlock() { return AddBlock(next_id++); }
+
+    std::shared_ptr<ir::BasicBlock> AddBlock(const int id) {
+        auto bb = std::make_shared<ir::BasicBlock>(
+            std::make_shared<ir::TmpVar>(ir::LabelType::Get(), id));
+        func.AddBlock(bb);
+        return bb;
+    }
+
+    std::shared_ptr<ir::BasicBlock> AddBlock(const char *name) {
+        auto bb = std::make_shared<ir::BasicBlock>(
+            std::make_shared<ir::LocalVar>(ir::LabelType::Get(), name));
+        func.AddBlock(bb);
+        return bb;
+    }
+
+    // a new temporary of type, i32 unless given
+    std::shared_ptr<ir::TmpVar> NewVar(
+        std::shared_ptr<ir::Type> type = ir::IntType::Get(ir::IntType::kI32)) {
+        return std::make_shared<ir::TmpVar>(std::move(type), next_id++);
+    }
+
+    std::shared_ptr<ir::TmpVar> Op(const std::shared_ptr<ir::BasicBlock> &bb,
+                                   const ir::BinaryOpInst::BinaryOpKind op_code,
+                                   const std::shared_ptr<ir::Value> &lhs,
+                                   const std::shared_ptr<ir::Value> &rhs) {
+        auto result = NewVar();
+        bb->AddInst(
+            std::make_shared<ir::BinaryOpInst>(op_code, result, lhs, rhs));
+        return result;
+    }
+
+    std::shared_ptr<ir::TmpVar> Add(const std::shared_ptr<ir::BasicBlock> &bb,
+                                    const std::shared_ptr<ir::Value> &lhs,
+                                    const std::shared_ptr<ir::Value> &rhs) {
+        return Op(bb, ir::BinaryOpInst::kAdd, lhs, rhs);
+    }
+
+    // a new pointer to ptr[idx_list...]
+    std::shared_ptr<ir::TmpVar> GEP(
+        const std::shared_ptr<ir::BasicBlock> &bb,
+        const std::shared_ptr<ir::Var> &ptr,
+        std::vector<std::shared_ptr<ir::Value>> idx_list) {
+        auto result = NewVar(ir::PtrType::Get());
+        bb->AddInst(std::make_shared<ir::GetelementptrInst>(
+            result, ptr, std::move(idx_list)));
+        return result;
+    }
+
+    std::shared_ptr<ir::TmpVar> Load(const std::shared_ptr<ir::BasicBlock> &bb,
+                                     const std::shared_ptr<ir::Var> &ptr) {
+        auto result = NewVar();
+        bb->AddInst(std::make_shared<ir::LoadInst>(result, ptr));
+        return result;
+    }
+
+    static void Store(const std::shared_ptr<ir::BasicBlock> &bb,
+                      const std::shared_ptr<ir::Value> &value,
+                      const std::shared_ptr<ir::Var> &ptr) {
+        bb->AddInst(std::make_shared<ir::StoreInst>(value, ptr));
+    }
+
+    // the dump of the function
+    std::string Str() const {
+        std::ostringstream ostream;
+        func.Dump(ostream);
+        return ostream.str();
+    }
+
+    // a global i32 array of the dimensions
+    static std::shared_ptr<ir::GlobalVar> Global(const char *name,
+                                                 std::vector<int> dim_list) {
+        return std::make_shared<ir::GlobalVar>(
+            std::make_shared<ir::PtrType>(
+                std::make_shared<ir::ArrayType>(std::move(dim_list))),
+            name);
+    }
+
+    static std::shared_ptr<ir::Imm> I(const int value) {
+        return std::make_shared<ir::Imm>(value);
+    }
+
+    // the function name returning i32 if ret or void, with params of the
+    // kinds given
+    static std::shared_ptr<ir::GlobalVar> Func(
+        const char *name,
+        const bool ret,
+        const std::vector<ir::Type::TypeKind> &param_kind_list) {
+        std::vector<ir::Type *> param_list;
+        for (auto kind : param_kind_list) {
+            if (kind == ir::Type::kPtr) {
+                param_list.push_back(new ir::PtrType());
+            } else {
+                param_list.push_back(new ir::IntType(ir::IntType::kI32));
+            }
+        }
+        ir::Type *ret_type = ret ? static_cast<ir::Type *>(
+                                       new ir::IntType(ir::IntType::kI32))
+                                 : new ir::VoidType();
+        return std::make_shared<ir::GlobalVar>(
+            new ir::FuncType(ret_type, std::move(param_list)), name);
+    }
+
+  private:
+    static std::vector<std::shared_ptr<ir::TmpVar>> Params(
+        const std::vector<ir::Type::TypeKind> &param_kind_list) {
+        std::vector<std::shared_ptr<ir::TmpVar>> param_list;
+        for (auto kind : param_kind_list) {
+            const int id = static_cast<int>(param_list.size());
+            param_list.push_back(
+                kind == ir::Type::kPtr
+                    ? std::make_shared<ir::TmpVar>(ir::PtrType::Get(), id)
+                    : std::make_shared<ir::TmpVar>(id));
+        }
+        return param_list;
+    }
+};
+
+// Two loops nested perfectly, for the passes on loop nests:
+//   for (i = 0; i < outer bound; ++i) for (j = init; j < inner bound; ++j)
+//     body
+class LoopNestTest : public IRBuilderTest {
+  protected:
+    using IRBuilderTest::IRBuilderTest;
+    using IRBuilderTest::Load;
+    using IRBuilderTest::Store;
+
+    std::shared_ptr<ir::BasicBlock> entry = AddBlock();
+    std::shared_ptr<ir::BasicBlock> outer_header = AddBlock();
+    std::shared_ptr<ir::BasicBlock> inner_header = AddBlock();
+    std::shared_ptr<ir::BasicBlock> body = AddBlock();
+    std::shared_ptr<ir::BasicBlock> latch = AddBlock();
+    std::shared_ptr<ir::BasicBlock> exit = AddBlock();
+    std::shared_ptr<ir::TmpVar> i = NewVar();
+    std::shared_ptr<ir::TmpVar> j = NewVar();
+
+    // the nest, with the instructions of the body added before
+    void Finish(const std::shared_ptr<ir::Value> &outer_bound,
+                const std::shared_ptr<ir::Value> &inner_init,
+                const std::shared_ptr<ir::Value> &inner_bound) {
+        entry->AddInst(
+            std::make_shared<ir::BrInst>(outer_header->GetLabelPtr()));
+        Loop(outer_header, i, I(0), outer_bound, entry, Add(latch, i, I(1)),
+             latch, inner_header, exit);
+        latch->AddInst(
+            std::make_shared<ir::BrInst>(outer_header->GetLabelPtr()));
+        Loop(inner_header, j, inner_init, inner_bound, outer_header,
+             Add(body, j, I(1)), body, body, latch);
+        body->AddInst(
+            std::make_shared<ir::BrInst>(inner_header->GetLabelPtr()));
+        exit->AddInst(std::make_shared<ir::RetInst>(I(0)));
+    }
+
+    // header: %iv = phi [init, from], [next, back]
+    //         br %iv < bound, in, out
+    void Loop(const std::shared_ptr<ir::BasicBlock> &header,
+              const std::shared_ptr<ir::TmpVar> &iv,
+              const std::shared_ptr<ir::Value> &init,
+              const std::shared_ptr<ir::Value> &bound,
+              const std::shared_ptr<ir::BasicBlock> &from,
+              const std::shared_ptr<ir::TmpVar> &next,
+              const std::shared_ptr<ir::BasicBlock> &back,
+              const std::shared_ptr<ir::BasicBlock> &in,
+              const std::shared_ptr<ir::BasicBlock> &out) {
+        header->AddInst(std::make_shared<ir::PhiInst>(
+            iv, std::vector<ir::PhiInst::PhiValue>{
+                    {init, from->GetLabelPtr()}, {next, back->GetLabelPtr()}}));
+        auto cond = NewVar(ir::IntType::Get(ir::IntType::kI1));
+        header->AddInst(std::make_shared<ir::IcmpInst>(ir::IcmpInst::kSLT,
+                                                       cond, iv, bound));
+        header->AddInst(std::make_shared<ir::BrInst>(
+            cond, in->GetLabelPtr(), out->GetLabelPtr()));
+    }
+
+    // a new pointer to array[row][col] in the body
+    std::shared_ptr<ir::TmpVar> Element(const std::shared_ptr<ir::Var> &array,
+                                        const std::shared_ptr<ir::Value> &row,
+                                        const std::shared_ptr<ir::Value> &col) {
+        return GEP(body, array, {I(0), row, col});
+    }
+
+    std::shared_ptr<ir::TmpVar> Load(const std::shared_ptr<ir::Var> &array,
+                                     const std::shared_ptr<ir::Value> &row,
+                                     const std::shared_ptr<ir::Value> &col) {
+        return IRBuilderTest::Load(body, Element(array, row, col));
+    }
+
+    // array[row][col] = value in the body
+    void Store(const std::shared_ptr<ir::Var> &array,
+               const std::shared_ptr<ir::Value> &row,
+               const std::shared_ptr<ir::Value> &col,
+               const std::shared_ptr<ir::Value> &value) {
+        IRBuilderTest::Store(body, value, Element(array, row, col));
+    }
+};
+
+#endif
@@ -0,0 +1,182 @@
+#include "opt/load_store_elimination.h"
+
+#include <gtest/gtest.h>
+
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "ir/ir.h"
+#include "ir/type.h"
+#include "ir/value.h"
+#include "ir_builder.h"
+
+using ir::BasicBlock;
+using ir::Inst;
+using ir::TmpVar;
+
+// i32 @func(i32 %0) over the global @g of [10 x i32]
+class LoadStoreEliminationTest : public IRBuilderTest {
+  protected:
+    std::shared_ptr<TmpVar> param = param_list[0];
+    std::shared_ptr<ir::GlobalVar> g = Global("g", {10});
+
+    // a new pointer to g[index]
+    std::shared_ptr<TmpVar> Element(const std::shared_ptr<BasicBlock> &bb,
+                                    const std::shared_ptr<ir::Value> &index) {
+        return GEP(bb, g, {I(0), index});
+    }
+
+    static void Ret(const std::shared_ptr<BasicBlock> &bb,
+                    const std::shared_ptr<ir::Value> &value) {
+        bb->AddInst(std::make_shared<ir::RetInst>(value));
+    }
+
+    static std::vector<Inst::InstKind> Kinds(
+        const std::shared_ptr<BasicBlock> &bb) {
+        std::vector<Inst::InstKind> kind_list;
+        for (const auto &inst : bb->GetInstList()) {
+            kind_list.push_back(inst->kind);
+        }
+        return kind_list;
+    }
+
+    // the instruction before the one ending bb
+    static const Inst &BeforeEnd(const std::shared_ptr<BasicBlock> &bb) {
+        return **std::next(bb->GetInstList().rbegin());
+    }
+
+    static std::string Returned(const std::shared_ptr<BasicBlock> &bb) {
+        return bb->GetInstList().back()->Cast<ir::RetInst>().GetRet().Str();
+    }
+};
+
+// a load of a word another store leaves alone reads the stored value,
+// a second load of a word what the first one did
+TEST_F(LoadStoreEliminationTest, Forward) {
+    auto entry = AddBlock();
+    Store(entry, I(5), Element(entry, I(2)));
+    Store(entry, I(7), Element(entry, I(3)));
+    auto stored = Load(entry, Element(entry, I(2)));
+    auto first = Load(entry, Element(entry, param));
+    auto second = Load(entry, Element(entry, param));
+    auto sum = std::make_shared<TmpVar>(next_id++);
+    entry->AddInst(std::make_shared<ir::BinaryOpInst>(ir::BinaryOpInst::kAdd,
+                                                      sum, stored, second));
+    Ret(entry, sum);
+
+    opt::LoadStoreElimination load_store_elimination;
+    EXPECT_EQ(2, load_store_elimination.Run(func));
+    EXPECT_EQ((std::vector<Inst::InstKind>{
+                  Inst::kGetelementptr, Inst::kStore, Inst::kGetelementptr,
+                  Inst::kStore, Inst::kGetelementptr, Inst::kGetelementptr,
+                  Inst::kLoad, Inst::kGetelementptr, Inst::kBinaryOp,
+                  Inst::kRet}),
+              Kinds(entry));
+    const auto use_list = BeforeEnd(entry).GetUseList();
+    EXPECT_EQ("5", use_list[0]->Str());
+    EXPECT_EQ(first->Str(), use_list[1]->Str());
+
+    EXPECT_EQ(0, load_store_elimination.Run(func));
+}
+
+// a call writes the global, a store to a private alloca survives it
+TEST_F(LoadStoreEliminationTest, Call) {
+    auto entry = AddBlock();
+    auto local = std::make_shared<TmpVar>(
+        std::make_shared<ir::PtrType>(ir::IntType::Get(ir::IntType::kI32)),
+        next_id++);
+    entry->AddInst(std::make_shared<ir::AllocaInst>(local));
+    auto global = Element(entry, I(0));
+    Store(entry, I(1), global);
+    Store(entry, I(2), local);
+    entry->AddInst(std::make_shared<ir::CallInst>(
+        std::make_shared<ir::GlobalVar>(
+            new ir::FuncType(new ir::VoidType(), std::vector<ir::Type *>{}),
+            "putch"),
+        std::vector<std::shared_ptr<ir::Value>>{}));
+    auto from_global = Load(entry, global);
+    auto from_local = Load(entry, local);
+    auto sum = std::make_shared<TmpVar>(next_id++);
+    entry->AddInst(std::make_shared<ir::BinaryOpInst>(
+        ir::BinaryOpInst::kAdd, sum, from_global, from_local));
+    Ret(entry, sum);
+
+    opt::LoadStoreElimination load_store_elimination;
+    EXPECT_EQ(1, load_store_elimination.Run(func));
+    const auto use_list = BeforeEnd(entry).GetUseList();
+    EXPECT_EQ(from_global->Str(), use_list[0]->Str());
+    EXPECT_EQ("2", use_list[1]->Str());
+}
+
+// what all the predecessors agree on is known after a join, a store in a
+// loop is not known at its header
+TEST_F(LoadStoreEliminationTest, Join) {
+    auto entry = AddBlock();
+    auto then_bb = AddBlock();
+    auto else_bb = AddBlock();
+    auto header = AddBlock();
+    auto body = AddBlock();
+    auto exit = AddBlock();
+    Store(entry, I(1), Element(entry, I(0)));
+    auto cond = std::make_shared<TmpVar>(ir::IntType::Get(ir::IntType::kI1),
+                                         next_id++);
+    entry->AddInst(
+        std::make_shared<ir::IcmpInst>(ir::IcmpInst::kEQ, cond, param, I(0)));
+    entry->AddInst(std::make_shared<ir::BrInst>(
+        cond, then_bb->GetLabelPtr(), else_bb->GetLabelPtr()));
+    Store(then_bb, I(2), Element(then_bb, I(1)));
+    then_bb->AddInst(std::make_shared<ir::BrInst>(header->GetLabelPtr()));
+    Store(else_bb, I(3), Element(else_bb, I(1)));
+    else_bb->AddInst(std::make_shared<ir::BrInst>(header->GetLabelPtr()));
+    auto first = Load(header, Element(header, I(0)));
+    auto second = Load(header, Element(header, I(1)));
+    auto loop_cond = std::make_shared<TmpVar>(
+        ir::IntType::Get(ir::IntType::kI1), next_id++);
+    header->AddInst(std::make_shared<ir::IcmpInst>(ir::IcmpInst::kNE,
+                                                   loop_cond, first, second));
+    header->AddInst(std::make_shared<ir::BrInst>(
+        loop_cond, body->GetLabelPtr(), exit->GetLabelPtr()));
+    Store(body, I(4), Element(body, I(0)));
+    body->AddInst(std::make_shared<ir::BrInst>(header->GetLabelPtr()));
+    Ret(exit, I(0));
+
+    opt::LoadStoreElimination load_store_elimination;
+    EXPECT_EQ(0, load_store_elimination.Run(func));
+
+    // without the store in the loop g[0] is 1 at the header
+    body->GetInstList().clear();
+    body->AddInst(std::make_shared<ir::BrInst>(header->GetLabelPtr()));
+    EXPECT_EQ(1, load_store_elimination.Run(func));
+    const auto use_list = BeforeEnd(header).GetUseList();
+    EXPECT_EQ("1", use_list[0]->Str());
+    EXPECT_EQ(second->Str(), use_list[1]->Str());
+}
+
+// a store overwritten before anything reads the word goes, and so does
+// one of the value the word already holds
+TEST_F(LoadStoreEliminationTest, Store) {
+    auto entry = AddBlock();
+    auto ptr = Element(entry, param);
+    Store(entry, I(1), ptr);
+    Store(entry, I(2), Element(entry, param));
+    auto read = Element(entry, I(0));
+    Store(entry, I(3), read);
+    auto loaded = Load(entry, read);
+    Store(entry, I(4), read);
+    auto copied = Load(entry, ptr);
+    Store(entry, copied, Element(entry, param));
+    Ret(entry, loaded);
+
+    opt::LoadStoreElimination load_store_elimination;
+    // the load of g[0] reads 3, which leaves g[0] = 3 dead, and writing
+    // back what was read from g[%0] changes nothing
+    EXPECT_EQ(4, load_store_elimination.Run(func));
+    EXPECT_EQ((std::vector<Inst::InstKind>{
+                  Inst::kGetelementptr, Inst::kGetelementptr, Inst::kStore,
+                  Inst::kGetelementptr, Inst::kStore, Inst::kLoad,
+                  Inst::kGetelementptr, Inst::kRet}),
+              Kinds(entry));
+    EXPECT_EQ("3", Returned(entry));
+}
@@ -0,0 +1,90 @@
+#include "opt/loop_interchange.h"
+
+#include <gtest/gtest.h>
+
+#include <iterator>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "ir/ir.h"
+#include "ir/type.h"
+#include "ir/value.h"
+#include "ir_builder.h"
+
+using ir::BasicBlock;
+using ir::TmpVar;
+
+// i32 @func(i32 %0, i32 %1) over the global @a of [64 x [64 x i32]]:
+//   for (i = 0; i < %0; ++i) for (j = 1; j < %1; ++j) body
+class LoopInterchangeTest : public LoopNestTest {
+  protected:
+    LoopInterchangeTest() : LoopNestTest({ir::Type::kInt, ir::Type::kInt}) {}
+
+    std::shared_ptr<TmpVar> rows = param_list[0];
+    std::shared_ptr<TmpVar> cols = param_list[1];
+    std::shared_ptr<ir::GlobalVar> a = Global("a", {64, 64});
+    std::shared_ptr<TmpVar> ptr;
+
+    // body: a[row][col] = a[row + row_diff][col + col_diff] + 1
+    void Build(const std::shared_ptr<TmpVar> &row,
+               const std::shared_ptr<TmpVar> &col,
+               const int row_diff,
+               const int col_diff) {
+        auto loaded = Load(a, Add(body, row, I(row_diff)),
+                           Add(body, col, I(col_diff)));
+        ptr = Element(a, row, col);
+        Store(body, Add(body, loaded, I(1)), ptr);
+        Finish(rows, I(1), cols);
+    }
+
+    // the phi and the bound of the loop at header
+    static std::pair<std::string, std::string> Range(
+        const std::shared_ptr<BasicBlock> &header) {
+        const auto &inst_list = header->GetInstList();
+        const auto &phi = inst_list.front()->Cast<ir::PhiInst>();
+        const auto &cond
+            = (*std::next(inst_list.begin()))->Cast<ir::IcmpInst>();
+        return {phi.GetValueAt(0).value->Str(), cond.GetRHS().Str()};
+    }
+
+    // the indexes the store of the body goes through
+    std::vector<std::string> Indexes() const {
+        for (const auto &inst : body->GetInstList()) {
+            if (inst->GetResultPtr() != ptr) continue;
+            const auto &gep = inst->Cast<ir::GetelementptrInst>();
+            return {gep.GetIdxAt(1)->Str(), gep.GetIdxAt(2)->Str()};
+        }
+        return {};
+    }
+};
+
+// the inner loop walks a column, a[j][i] = a[j - 1][i - 1] + 1 depends
+// forward on both loops
+TEST_F(LoopInterchangeTest, Column) {
+    Build(j, i, -1, -1);
+    opt::LoopInterchange loop_interchange;
+    EXPECT_EQ(1, loop_interchange.Run(func));
+    EXPECT_EQ(std::make_pair(std::string("1"), cols->Str()),
+              Range(outer_header));
+    EXPECT_EQ(std::make_pair(std::string("0"), rows->Str()),
+              Range(inner_header));
+    EXPECT_EQ((std::vector<std::string>{i->Str(), j->Str()}), Indexes());
+    EXPECT_EQ(0, loop_interchange.Run(func));
+}
+
+// a[j][i] = a[j - 1][i + 1] + 1 reads what a later iteration of the outer
+// loop writes on an earlier one of the inner loop
+TEST_F(LoopInterchangeTest, Illegal) {
+    Build(j, i, -1, 1);
+    opt::LoopInterchange loop_interchange;
+    EXPECT_EQ(0, loop_interchange.Run(func));
+}
+
+// a row is already walked in order
+TEST_F(LoopInterchangeTest, Row) {
+    Build(i, j, -1, -1);
+    opt::LoopInterchange loop_interchange;
+    EXPECT_EQ(0, loop_interchange.Run(func));
+}
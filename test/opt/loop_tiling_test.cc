@@ -0,0 +1,60 @@
+#include "opt/loop_tiling.h"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <vector>
+
+#include "ir/ir.h"
+#include "ir/type.h"
+#include "ir/value.h"
+#include "ir_builder.h"
+
+using ir::TmpVar;
+
+// i32 @func(i32 %0) over the globals @a and @b of [64 x [64 x i32]]:
+//   for (i = 0; i < bound; ++i) for (j = 0; j < bound; ++j) body
+class LoopTilingTest : public LoopNestTest {
+  protected:
+    std::shared_ptr<TmpVar> param = param_list[0];
+    std::shared_ptr<ir::GlobalVar> a = Global("a", {64, 64});
+    std::shared_ptr<ir::GlobalVar> b = Global("b", {64, 64});
+
+    void Finish(const std::shared_ptr<ir::Value> &bound) {
+        LoopNestTest::Finish(bound, I(0), bound);
+    }
+};
+
+// b[j][i] = a[i][j] walks a column of b on the inner loop
+TEST_F(LoopTilingTest, Transpose) {
+    Store(b, j, i, Load(a, i, j));
+    Finish(param);
+    opt::LoopTiling loop_tiling;
+    EXPECT_EQ(1, loop_tiling.Run(func));
+    EXPECT_EQ(10, func.GetBlockList().size());
+    EXPECT_EQ(0, loop_tiling.Run(func));
+}
+
+// a single tile covers the whole nest
+TEST_F(LoopTilingTest, Small) {
+    Store(b, j, i, Load(a, i, j));
+    Finish(I(32));
+    opt::LoopTiling loop_tiling;
+    EXPECT_EQ(0, loop_tiling.Run(func));
+}
+
+// a row of a is already walked in order
+TEST_F(LoopTilingTest, Row) {
+    Store(b, i, j, Load(a, i, j));
+    Finish(param);
+    opt::LoopTiling loop_tiling;
+    EXPECT_EQ(0, loop_tiling.Run(func));
+}
+
+// a[j][i] = a[j - 1][i + 1] would be read in a later tile than written
+TEST_F(LoopTilingTest, Carried) {
+    Store(a, j, i, Load(a, Add(body, j, I(-1)), Add(body, i, I(1))));
+    Finish(param);
+    opt::LoopTiling loop_tiling;
+    EXPECT_EQ(0, loop_tiling.Run(func));
+}
@@ -0,0 +1,182 @@
+#include "opt/loop_vectorize.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "ir/ir.h"
+#include "ir/type.h"
+#include "ir/value.h"
+#include "ir_builder.h"
+
+using ir::BasicBlock;
+using ir::TmpVar;
+
+// i32 @func(i32 %0) over the globals @a, @b and @c of [64 x i32]:
+//   for (i = 0; i < %0; ++i) body
+class LoopVectorizeTest : public IRBuilderTest {
+  protected:
+    using IRBuilderTest::IRBuilderTest;
+
+    std::shared_ptr<TmpVar> param = param_list[0];
+    std::shared_ptr<ir::GlobalVar> a = Global("a", {64});
+    std::shared_ptr<ir::GlobalVar> b = Global("b", {64});
+    std::shared_ptr<ir::GlobalVar> c = Global("c", {64});
+    std::shared_ptr<BasicBlock> entry = AddBlock();
+    std::shared_ptr<BasicBlock> header = AddBlock();
+    std::shared_ptr<BasicBlock> body = AddBlock();
+    std::shared_ptr<BasicBlock> exit = AddBlock();
+    std::shared_ptr<TmpVar> i = NewVar();
+    std::shared_ptr<TmpVar> sum;
+
+    // the loop, with the instructions of the body added before and the
+    // sum of what is added to it returned if any
+    void Finish(const std::shared_ptr<ir::Value> &addend = nullptr) {
+        entry->AddInst(std::make_shared<ir::BrInst>(header->GetLabelPtr()));
+        header->AddInst(std::make_shared<ir::PhiInst>(
+            i, std::vector<ir::PhiInst::PhiValue>{
+                   {I(0), entry->GetLabelPtr()},
+                   {Add(i, I(1)), body->GetLabelPtr()}}));
+        if (addend != nullptr) {
+            sum = NewVar();
+            header->AddInst(std::make_shared<ir::PhiInst>(
+                sum, std::vector<ir::PhiInst::PhiValue>{
+                         {I(0), entry->GetLabelPtr()},
+                         {Add(sum, addend), body->GetLabelPtr()}}));
+        }
+        auto cond = NewVar(ir::IntType::Get(ir::IntType::kI1));
+        header->AddInst(std::make_shared<ir::IcmpInst>(ir::IcmpInst::kSLT,
+                                                       cond, i, param));
+        header->AddInst(std::make_shared<ir::BrInst>(
+            cond, body->GetLabelPtr(), exit->GetLabelPtr()));
+        body->AddInst(std::make_shared<ir::BrInst>(header->GetLabelPtr()));
+        exit->AddInst(std::make_shared<ir::RetInst>(
+            sum != nullptr ? std::static_pointer_cast<ir::Value>(sum)
+                           : I(0)));
+    }
+
+    // the number of instructions of kind reading or writing vectors
+    int CountVector(const ir::Inst::InstKind kind) const {
+        int count = 0;
+        for (const auto &bb : func.GetBlockList()) {
+            for (const auto &inst : bb->GetInstList()) {
+                if (inst->kind != kind) continue;
+                auto value_list = inst->GetUseList();
+                if (auto result = inst->GetResultPtr()) {
+                    value_list.push_back(result);
+                }
+                if (std::any_of(value_list.begin(), value_list.end(),
+                                [](const std::shared_ptr<ir::Value> &value) {
+                                    return value->GetType().kind
+                                           == ir::Type::kVector;
+                                })) {
+                    ++count;
+                }
+            }
+        }
+        return count;
+    }
+
+    std::shared_ptr<TmpVar> Add(const std::shared_ptr<ir::Value> &lhs,
+                                const std::shared_ptr<ir::Value> &rhs) {
+        return IRBuilderTest::Add(body, lhs, rhs);
+    }
+
+    // array[index] = value in the body
+    void Store(const std::shared_ptr<ir::Var> &array,
+               const std::shared_ptr<ir::Value> &index,
+               const std::shared_ptr<ir::Value> &value) {
+        IRBuilderTest::Store(body, value, GEP(body, array, {I(0), index}));
+    }
+
+    std::shared_ptr<TmpVar> Load(const std::shared_ptr<ir::Var> &array,
+                                 const std::shared_ptr<ir::Value> &index) {
+        return IRBuilderTest::Load(body, GEP(body, array, {I(0), index}));
+    }
+};
+
+// a[i] = b[i] + c[i] * %0
+TEST_F(LoopVectorizeTest, Map) {
+    auto product = Op(body, ir::BinaryOpInst::kMul, Load(c, i), param);
+    Store(a, i, Add(Load(b, i), product));
+    Finish();
+    opt::LoopVectorize loop_vectorize;
+    EXPECT_EQ(1, loop_vectorize.Run(func));
+    // vpre, vheader, vbody and vexit before the old loop
+    const auto &block_list = func.GetBlockList();
+    ASSERT_EQ(8, block_list.size());
+    EXPECT_EQ(header, *std::next(block_list.begin(), 5));
+    EXPECT_EQ(2, CountVector(ir::Inst::kLoad));
+    EXPECT_EQ(1, CountVector(ir::Inst::kStore));
+    EXPECT_EQ(2, CountVector(ir::Inst::kBinaryOp));
+    EXPECT_EQ(0, loop_vectorize.Run(func));
+}
+
+// return the sum of a[i] - i
+TEST_F(LoopVectorizeTest, Reduction) {
+    auto diff = Op(body, ir::BinaryOpInst::kSub, Load(a, i), i);
+    Finish(diff);
+    opt::LoopVectorize loop_vectorize;
+    EXPECT_EQ(1, loop_vectorize.Run(func));
+    // the lanes of the sum are added up after the vector loop
+    EXPECT_EQ(4, CountVector(ir::Inst::kExtractElement));
+    EXPECT_EQ(0, loop_vectorize.Run(func));
+}
+
+// a[i + 1] = a[i] + 1 reads what the iteration before wrote
+TEST_F(LoopVectorizeTest, Recurrence) {
+    auto loaded = Load(a, i);
+    Store(a, Add(i, I(1)), Add(loaded, I(1)));
+    Finish();
+    opt::LoopVectorize loop_vectorize;
+    EXPECT_EQ(0, loop_vectorize.Run(func));
+}
+
+// a[i] = a[i + 1] + 1 reads ahead of what it writes
+TEST_F(LoopVectorizeTest, Forward) {
+    Store(a, i, Add(Load(a, Add(i, I(1))), I(1)));
+    Finish();
+    opt::LoopVectorize loop_vectorize;
+    EXPECT_EQ(1, loop_vectorize.Run(func));
+}
+
+// i32 @func(i32 %0, i32* %1, i32* %2) of params that may overlap
+class LoopVectorizeParamTest : public LoopVectorizeTest {
+  protected:
+    LoopVectorizeParamTest()
+        : LoopVectorizeTest({ir::Type::kInt, ir::Type::kPtr, ir::Type::kPtr}) {}
+};
+
+// %2[i] = %1[i] + 1 runs by vectors only where the pointers are far apart,
+// which is checked on them as addresses
+TEST_F(LoopVectorizeParamTest, Check) {
+    auto loaded = IRBuilderTest::Load(body, GEP(body, param_list[1], {i}));
+    IRBuilderTest::Store(body, Add(loaded, I(1)),
+                         GEP(body, param_list[2], {i}));
+    Finish();
+    opt::LoopVectorize loop_vectorize;
+    EXPECT_EQ(1, loop_vectorize.Run(func));
+    const auto str = Str();
+    EXPECT_NE(std::string::npos, str.find("icmp uge i32*"));
+    EXPECT_NE(std::string::npos, str.find("icmp ule i32*"));
+    EXPECT_EQ(std::string::npos, str.find("icmp sge i32*"));
+    EXPECT_EQ(std::string::npos, str.find("icmp sle i32*"));
+}
+
+// a call in the body is left alone
+TEST_F(LoopVectorizeTest, Call) {
+    body->AddInst(std::make_shared<ir::CallInst>(
+        std::make_shared<ir::GlobalVar>(
+            new ir::FuncType(new ir::VoidType(),
+                             std::vector<ir::Type *>{
+                                 new ir::IntType(ir::IntType::kI32)}),
+            "putint"),
+        std::vector<std::shared_ptr<ir::Value>>{Load(a, i)}));
+    Finish();
+    opt::LoopVectorize loop_vectorize;
+    EXPECT_EQ(0, loop_vectorize.Run(func));
+}
@@ -0,0 +1,117 @@
+#include "opt/mem2reg.h"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <vector>
+
+#include "ir/ir.h"
+#include "ir/type.h"
+#include "ir/value.h"
+#include "ir_builder.h"
+
+using ir::TmpVar;
+
+// i32 @func(i32 %0) with blocks entry, %1, ...
+class Mem2RegTest : public IRBuilderTest {
+  protected:
+    const std::shared_ptr<TmpVar> &param = param_list[0];
+
+    static std::shared_ptr<TmpVar> Ptr(const int id) {
+        return std::make_shared<TmpVar>(std::make_shared<ir::PtrType>(), id);
+    }
+};
+
+// int s = 0, i = 0, t; while (i < %0) { s = s + i; t = s; i = i + 1; }
+// return s;
+TEST_F(Mem2RegTest, Loop) {
+    auto entry = AddBlock("entry");
+    auto cond_bb = AddBlock(4);
+    auto body = AddBlock(8);
+    auto exit = AddBlock(13);
+
+    auto s = Ptr(1);
+    auto i = Ptr(2);
+    auto t = Ptr(3);
+    auto zero = I(0);
+    entry->AddInst(std::make_shared<ir::AllocaInst>(s));
+    entry->AddInst(std::make_shared<ir::AllocaInst>(i));
+    entry->AddInst(std::make_shared<ir::AllocaInst>(t));
+    entry->AddInst(std::make_shared<ir::StoreInst>(zero, s));
+    entry->AddInst(std::make_shared<ir::StoreInst>(zero, i));
+    entry->AddInst(std::make_shared<ir::BrInst>(cond_bb->GetLabelPtr()));
+
+    auto i0 = std::make_shared<TmpVar>(5);
+    auto cond = std::make_shared<TmpVar>(
+        std::make_shared<ir::IntType>(ir::IntType::kI1), 6);
+    cond_bb->AddInst(std::make_shared<ir::LoadInst>(i0, i));
+    cond_bb->AddInst(
+        std::make_shared<ir::IcmpInst>(ir::IcmpInst::kSLT, cond, i0, param));
+    cond_bb->AddInst(std::make_shared<ir::BrInst>(cond, body->GetLabelPtr(),
+                                                  exit->GetLabelPtr()));
+
+    auto s1 = std::make_shared<TmpVar>(9);
+    auto i1 = std::make_shared<TmpVar>(10);
+    auto sum = std::make_shared<TmpVar>(11);
+    auto inc = std::make_shared<TmpVar>(12);
+    body->AddInst(std::make_shared<ir::LoadInst>(s1, s));
+    body->AddInst(std::make_shared<ir::LoadInst>(i1, i));
+    body->AddInst(std::make_shared<ir::BinaryOpInst>(ir::BinaryOpInst::kAdd,
+                                                     sum, s1, i1));
+    body->AddInst(std::make_shared<ir::StoreInst>(sum, s));
+    body->AddInst(std::make_shared<ir::StoreInst>(sum, t));
+    body->AddInst(std::make_shared<ir::BinaryOpInst>(ir::BinaryOpInst::kAdd,
+                                                     inc, i1, I(1)));
+    body->AddInst(std::make_shared<ir::StoreInst>(inc, i));
+    body->AddInst(std::make_shared<ir::BrInst>(cond_bb->GetLabelPtr()));
+
+    auto s2 = std::make_shared<TmpVar>(14);
+    exit->AddInst(std::make_shared<ir::LoadInst>(s2, s));
+    exit->AddInst(std::make_shared<ir::RetInst>(s2));
+
+    opt::Mem2Reg mem2reg;
+    EXPECT_EQ(3, mem2reg.Run(func));
+    // t is never read, so it gets no phi
+    EXPECT_EQ(
+        "define i32 @func(i32 %0) {\n"
+        "entry:\n"
+        "    br label %1\n"
+        "1:\n"
+        "    %2 = phi i32 [ 0, %entry ], [ %6, %5 ]\n"
+        "    %3 = phi i32 [ 0, %entry ], [ %7, %5 ]\n"
+        "    %4 = icmp slt i32 %3, %0\n"
+        "    br i1 %4, label %5, label %8\n"
+        "5:\n"
+        "    %6 = add i32 %2, %3\n"
+        "    %7 = add i32 %3, 1\n"
+        "    br label %1\n"
+        "8:\n"
+        "    ret i32 %2\n"
+        "}\n\n",
+        Str());
+}
+
+// an array stays in memory, a load before any store reads 0
+TEST_F(Mem2RegTest, Array) {
+    auto entry = AddBlock(1);
+    auto array = std::make_shared<TmpVar>(
+        std::make_shared<ir::PtrType>(
+            std::make_shared<ir::ArrayType>(std::vector<int>{2})),
+        2);
+    auto scalar = Ptr(3);
+    auto value = std::make_shared<TmpVar>(4);
+    entry->AddInst(std::make_shared<ir::AllocaInst>(array));
+    entry->AddInst(std::make_shared<ir::AllocaInst>(scalar));
+    entry->AddInst(std::make_shared<ir::LoadInst>(value, scalar));
+    entry->AddInst(std::make_shared<ir::RetInst>(value));
+
+    opt::Mem2Reg mem2reg;
+    EXPECT_EQ(1, mem2reg.Run(func));
+    EXPECT_EQ(
+        "define i32 @func(i32 %0) {\n"
+        "1:\n"
+        "    %2 = alloca [2 x i32]\n"
+        "    ret i32 0\n"
+        "}\n\n",
+        Str());
+}
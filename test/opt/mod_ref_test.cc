@@ -0,0 +1,160 @@
+#include "opt/mod_ref.h"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "ir/ir.h"
+#include "ir/type.h"
+#include "ir/value.h"
+#include "ir_builder.h"
+#include "opt/alias_analysis.h"
+
+using ir::TmpVar;
+using opt::AliasAnalysis;
+
+// over the globals @g and @h of [10 x i32]:
+//   void @set(i32* %0): writes %0[0], reads @g[0]
+//   i32 @fib(i32 %0): calls itself
+//   void @caller(): calls @set(@h[1]), @putint and @fib
+//   void @opaque(): calls @foo, which is declared nowhere
+class ModRefTest : public IRBuilderTest {
+  protected:
+    ir::Module module;
+    std::shared_ptr<ir::GlobalVar> g = Global("g", {10});
+    std::shared_ptr<ir::GlobalVar> h = Global("h", {10});
+    std::shared_ptr<ir::GlobalVar> set = Func("set", false, {ir::Type::kPtr});
+    std::shared_ptr<ir::GlobalVar> fib = Func("fib", true, {ir::Type::kInt});
+    std::shared_ptr<ir::GlobalVar> putint
+        = Func("putint", false, {ir::Type::kInt});
+    std::shared_ptr<ir::GlobalVar> foo = Func("foo", false, {});
+    std::shared_ptr<ir::CallInst> call_set;
+    std::shared_ptr<ir::CallInst> call_putint;
+    std::shared_ptr<ir::CallInst> call_fib;
+    std::shared_ptr<TmpVar> g_2;
+    std::shared_ptr<TmpVar> h_3;
+    std::shared_ptr<ir::FuncDef> caller;
+
+    void SetUp() override {
+        {
+            auto param = std::make_shared<TmpVar>(ir::PtrType::Get(), 0);
+            auto entry = Define(set, {param});
+            auto slot = std::make_shared<TmpVar>(
+                std::make_shared<ir::PtrType>(ir::PtrType::Get()), 1);
+            entry->AddInst(std::make_shared<ir::AllocaInst>(slot));
+            entry->AddInst(std::make_shared<ir::StoreInst>(param, slot));
+            auto loaded = std::make_shared<TmpVar>(ir::PtrType::Get(), 2);
+            entry->AddInst(std::make_shared<ir::LoadInst>(loaded, slot));
+            auto ptr = GEP(entry, loaded, {I(0)}, 3);
+            entry->AddInst(std::make_shared<ir::StoreInst>(I(1), ptr));
+            auto read = std::make_shared<TmpVar>(5);
+            entry->AddInst(std::make_shared<ir::LoadInst>(
+                read, GEP(entry, g, {I(0), I(0)}, 4)));
+            entry->AddInst(std::make_shared<ir::RetInst>());
+        }
+        {
+            auto param = std::make_shared<TmpVar>(0);
+            auto entry = Define(fib, {param});
+            auto result = std::make_shared<TmpVar>(1);
+            entry->AddInst(std::make_shared<ir::CallInst>(
+                result, fib, std::vector<std::shared_ptr<ir::Value>>{param}));
+            entry->AddInst(std::make_shared<ir::RetInst>(result));
+        }
+        {
+            auto entry = Define(Func("caller", false, {}), {});
+            caller = module.GetFuncDefList().back();
+            auto arg = GEP(entry, h, {I(0), I(1)}, 0);
+            call_set = std::make_shared<ir::CallInst>(
+                set, std::vector<std::shared_ptr<ir::Value>>{arg});
+            entry->AddInst(call_set);
+            call_putint = std::make_shared<ir::CallInst>(
+                putint, std::vector<std::shared_ptr<ir::Value>>{I(1)});
+            entry->AddInst(call_putint);
+            call_fib = std::make_shared<ir::CallInst>(
+                std::make_shared<TmpVar>(1), fib,
+                std::vector<std::shared_ptr<ir::Value>>{I(1)});
+            entry->AddInst(call_fib);
+            g_2 = GEP(entry, g, {I(0), I(2)}, 2);
+            h_3 = GEP(entry, h, {I(0), I(3)}, 3);
+            entry->AddInst(std::make_shared<ir::RetInst>());
+        }
+        {
+            auto entry = Define(Func("opaque", false, {}), {});
+            entry->AddInst(std::make_shared<ir::CallInst>(
+                foo, std::vector<std::shared_ptr<ir::Value>>{}));
+            entry->AddInst(std::make_shared<ir::RetInst>());
+        }
+    }
+
+    std::shared_ptr<ir::BasicBlock> Define(
+        const std::shared_ptr<ir::GlobalVar> &ident,
+        std::vector<std::shared_ptr<TmpVar>> params) {
+        auto def = std::make_shared<ir::FuncDef>(ident, std::move(params));
+        auto entry = std::make_shared<ir::BasicBlock>(
+            std::make_shared<ir::LocalVar>(ir::LabelType::Get(), "entry"));
+        def->AddBlock(entry);
+        module.AddFuncDef(def);
+        return entry;
+    }
+
+    static std::shared_ptr<TmpVar> GEP(
+        const std::shared_ptr<ir::BasicBlock> &bb,
+        std::shared_ptr<ir::Var> ptr,
+        std::vector<std::shared_ptr<ir::Value>> idx,
+        const int id) {
+        auto result = std::make_shared<TmpVar>(ir::PtrType::Get(), id);
+        bb->AddInst(std::make_shared<ir::GetelementptrInst>(
+            result, std::move(ptr), std::move(idx)));
+        return result;
+    }
+};
+
+TEST_F(ModRefTest, Summary) {
+    const opt::ModRefAnalysis mod_ref(module);
+    using Names = std::set<std::string>;
+
+    const auto *set_summary = mod_ref.GetSummary("set");
+    ASSERT_NE(nullptr, set_summary);
+    EXPECT_EQ(Names{g->Str()}, set_summary->ref_global_set);
+    EXPECT_TRUE(set_summary->mod_global_set.empty());
+    EXPECT_EQ(std::set<int>{0}, set_summary->mod_param_set);
+    EXPECT_FALSE(set_summary->IsPure());
+
+    // the recursion adds nothing
+    EXPECT_TRUE(mod_ref.GetSummary("fib")->IsPure());
+
+    // the write through the parameter lands in @h
+    const auto *caller_summary = mod_ref.GetSummary("caller");
+    EXPECT_EQ(Names{g->Str()}, caller_summary->ref_global_set);
+    EXPECT_EQ(Names{h->Str()}, caller_summary->mod_global_set);
+    EXPECT_TRUE(caller_summary->mod_param_set.empty());
+    EXPECT_TRUE(caller_summary->io);
+    EXPECT_FALSE(caller_summary->unknown);
+
+    const auto *putint_summary = mod_ref.GetSummary("putint");
+    EXPECT_TRUE(putint_summary->io);
+    EXPECT_TRUE(putint_summary->mod_global_set.empty());
+    EXPECT_EQ(std::set<int>{0}, mod_ref.GetSummary("getarray")->mod_param_set);
+
+    EXPECT_EQ(nullptr, mod_ref.GetSummary("foo"));
+    EXPECT_TRUE(mod_ref.GetSummary("opaque")->unknown);
+}
+
+TEST_F(ModRefTest, Call) {
+    const opt::ModRefAnalysis mod_ref(module);
+    const AliasAnalysis alias_analysis(*caller, false, &mod_ref);
+    EXPECT_EQ(AliasAnalysis::kRef, alias_analysis.GetModRef(*call_set, *g_2));
+    EXPECT_EQ(AliasAnalysis::kMod, alias_analysis.GetModRef(*call_set, *h_3));
+    EXPECT_EQ(AliasAnalysis::kNoModRef,
+              alias_analysis.GetModRef(*call_putint, *g_2));
+    EXPECT_EQ(AliasAnalysis::kNoModRef,
+              alias_analysis.GetModRef(*call_fib, *h_3));
+
+    // without the summaries
+    const AliasAnalysis conservative(*caller);
+    EXPECT_EQ(AliasAnalysis::kModRef,
+              conservative.GetModRef(*call_putint, *g_2));
+}
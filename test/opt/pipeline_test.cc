@@ -0,0 +1,49 @@
+#include "opt/pipeline.h"
+
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "error.h"
+
+TEST(PipelineTest, CreatePass) {
+    for (const std::string name :
+         {"mem2reg", "simplify-cfg", "strength-reduction", "if-conversion",
+          "block-placement", "load-store-elimination", "scalar-promotion",
+          "loop-interchange", "loop-tiling", "loop-vectorize",
+          "slp-vectorize"}) {
+        EXPECT_EQ(name, opt::CreatePass(name)->GetName());
+    }
+    EXPECT_THROW(opt::CreatePass("gvn"), InvalidParameterException);
+}
+
+TEST(PipelineTest, Parse) {
+    EXPECT_TRUE(opt::ParsePipeline("").empty());
+
+    const auto pass_list = opt::ParsePipeline("mem2reg,simplify-cfg,mem2reg");
+    std::vector<std::string> name_list;
+    for (const auto &pass : pass_list) name_list.push_back(pass->GetName());
+    EXPECT_EQ((std::vector<std::string>{"mem2reg", "simplify-cfg", "mem2reg"}),
+              name_list);
+
+    EXPECT_THROW(opt::ParsePipeline("mem2reg,"), InvalidParameterException);
+    EXPECT_THROW(opt::ParsePipeline("mem2reg,,simplify-cfg"),
+                 InvalidParameterException);
+    EXPECT_THROW(opt::ParsePipeline("mem2reg,dce"), InvalidParameterException);
+}
+
+// every level names passes that exist, and each level runs more of them
+TEST(PipelineTest, Level) {
+    std::size_t last = 0;
+    for (int level = 0; level <= 2; ++level) {
+        const auto pass_list = opt::ParsePipeline(opt::GetPipeline(level));
+        if (level > 0) {
+            EXPECT_LT(last, pass_list.size());
+        }
+        last = pass_list.size();
+    }
+    EXPECT_TRUE(opt::GetPipeline(0).empty());
+    EXPECT_THROW(opt::GetPipeline(3), InvalidParameterException);
+}
@@ -0,0 +1,136 @@
+#include "opt/profile.h"
+
+#include <gtest/gtest.h>
+
+#include <iterator>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "emitter.h"
+#include "error.h"
+#include "ir/ir.h"
+#include "ir/type.h"
+#include "ir/value.h"
+#include "ir_builder.h"
+
+using ir::BasicBlock;
+using ir::TmpVar;
+
+// i32 @main() { %0: br %1, %1: a loop on %2, %3: ret %2 }
+class ProfileTest : public IRBuilderTest {
+  protected:
+    ProfileTest() : IRBuilderTest({}, "main") {}
+
+    ir::Module module;
+    std::shared_ptr<BasicBlock> entry = AddBlock(0);
+    std::shared_ptr<BasicBlock> loop = AddBlock(1);
+    std::shared_ptr<BasicBlock> exit = AddBlock(3);
+
+    void SetUp() override {
+        module.AddFuncDef(func_def);
+        auto i = std::make_shared<TmpVar>(2);
+        auto cond = std::make_shared<TmpVar>(
+            ir::IntType::Get(ir::IntType::kI1), 4);
+        entry->AddInst(std::make_shared<ir::BrInst>(loop->GetLabelPtr()));
+        loop->AddInst(std::make_shared<ir::PhiInst>(
+            i, std::vector<ir::PhiInst::PhiValue>{{I(0), entry->GetLabelPtr()},
+                                                  {i, loop->GetLabelPtr()}}));
+        loop->AddInst(
+            std::make_shared<ir::IcmpInst>(ir::IcmpInst::kSLT, cond, i, I(10)));
+        loop->AddInst(std::make_shared<ir::BrInst>(cond, loop->GetLabelPtr(),
+                                                   exit->GetLabelPtr()));
+        exit->AddInst(std::make_shared<ir::RetInst>(i));
+    }
+
+    // the text of a profile of main with counts
+    std::string ProfileOf(const std::vector<int> &count_list) const {
+        std::string str = std::to_string(opt::GetProfileHash(func)) + ' '
+                          + std::to_string(count_list.size()) + '\n';
+        for (const int count : count_list) {
+            str += std::to_string(count) + '\n';
+        }
+        return str;
+    }
+};
+
+// the hash follows the edges, not the instructions in the blocks
+TEST_F(ProfileTest, Hash) {
+    const auto hash = opt::GetProfileHash(func);
+    exit->GetInstList().push_front(std::make_shared<ir::BinaryOpInst>(
+        ir::BinaryOpInst::kAdd, std::make_shared<TmpVar>(5), I(1), I(2)));
+    EXPECT_EQ(hash, opt::GetProfileHash(func));
+
+    loop->GetInstList().pop_back();
+    loop->AddInst(std::make_shared<ir::BrInst>(exit->GetLabelPtr()));
+    EXPECT_NE(hash, opt::GetProfileHash(func));
+}
+
+TEST_F(ProfileTest, Instrument) {
+    const auto hash = opt::GetProfileHash(func);
+    opt::InstrumentProfile(module);
+    EXPECT_EQ(hash, opt::GetProfileHash(func));
+
+    ASSERT_EQ(2, module.GetVarNum());
+    EXPECT_EQ(opt::kProfileCounter, module.GetVarList().front()->GetName());
+    EXPECT_EQ(opt::kProfileLayout, module.GetVarList().back()->GetName());
+
+    // two i32 words a counter, the high one takes the carry of the low one
+    EXPECT_EQ(1 + 10, entry->GetInstList().size());
+    EXPECT_EQ(3 + 10, loop->GetInstList().size());
+    EXPECT_EQ(1 + 10, exit->GetInstList().size());
+    std::string str;
+    for (const auto &inst : entry->GetInstList()) str += inst->Str() + '\n';
+    EXPECT_EQ(
+        "%1 = getelementptr [6 x i32], [6 x i32]* @__sysy_profile_counter, "
+        "i32 0, i32 0\n"
+        "%2 = load i32, i32* %1\n"
+        "%3 = add i32 %2, 1\n"
+        "store i32 %3, i32* %1\n"
+        "%4 = icmp eq i32 %3, 0\n"
+        "%5 = zext i1 %4 to i32\n"
+        "%6 = getelementptr [6 x i32], [6 x i32]* @__sysy_profile_counter, "
+        "i32 0, i32 1\n"
+        "%7 = load i32, i32* %6\n"
+        "%8 = add i32 %7, %5\n"
+        "store i32 %8, i32* %6\n"
+        "br label %9\n",
+        str);
+    // the counter goes after the phis
+    EXPECT_EQ(ir::Inst::kPhi, loop->GetInstList().front()->kind);
+    EXPECT_EQ(ir::Inst::kGetelementptr,
+              (*std::next(loop->GetInstList().begin()))->kind);
+}
+
+TEST_F(ProfileTest, ReadWrite) {
+    std::istringstream istream(ProfileOf({1, 10, 1}) + ProfileOf({1, 5, 1}));
+    const auto profile = opt::Profile::Read(istream);
+    std::string str;
+    {
+        util::Emitter emitter(str);
+        profile.Write(emitter);
+    }
+    // two runs of one function add up
+    EXPECT_EQ(ProfileOf({2, 15, 2}), str);
+
+    std::istringstream truncated(ProfileOf({1, 10, 1}) + "1 3\n1\n");
+    EXPECT_THROW(opt::Profile::Read(truncated), InvalidParameterException);
+    std::istringstream malformed("1 1\nx\n");
+    EXPECT_THROW(opt::Profile::Read(malformed), InvalidParameterException);
+}
+
+TEST_F(ProfileTest, Annotate) {
+    EXPECT_FALSE(loop->HasCount());
+
+    std::istringstream other(ProfileOf({1, 10}));
+    EXPECT_EQ(0, opt::Profile::Read(other).Annotate(module));
+    EXPECT_FALSE(loop->HasCount());
+
+    std::istringstream istream(ProfileOf({1, 10, 1}));
+    EXPECT_EQ(1, opt::Profile::Read(istream).Annotate(module));
+    ASSERT_TRUE(loop->HasCount());
+    EXPECT_EQ(1, entry->GetCount());
+    EXPECT_EQ(10, loop->GetCount());
+    EXPECT_EQ(1, exit->GetCount());
+}
@@ -0,0 +1,114 @@
+#include "opt/scalar_promotion.h"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <vector>
+
+#include "ir/ir.h"
+#include "ir/type.h"
+#include "ir/value.h"
+#include "ir_builder.h"
+
+using ir::BasicBlock;
+using ir::Inst;
+using ir::TmpVar;
+
+// i32 @func(i32 %0) over the globals @g of [10 x i32] and @n of i32
+class ScalarPromotionTest : public IRBuilderTest {
+  protected:
+    std::shared_ptr<TmpVar> param = param_list[0];
+    std::shared_ptr<ir::GlobalVar> g = Global("g", {10});
+    std::shared_ptr<ir::GlobalVar> n
+        = std::make_shared<ir::GlobalVar>(ir::PtrType::Get(), "n");
+    std::shared_ptr<BasicBlock> header;
+    std::shared_ptr<BasicBlock> body;
+
+    // while (n < 10) { g[index] = g[index] + 1; foo(); n = n + 1; }
+    void BuildLoop(const std::shared_ptr<ir::Value> &index, const bool call) {
+        auto entry = AddBlock();
+        header = AddBlock();
+        body = AddBlock();
+        auto exit = AddBlock();
+        entry->AddInst(std::make_shared<ir::BrInst>(header->GetLabelPtr()));
+
+        auto cond = NewVar(ir::IntType::Get(ir::IntType::kI1));
+        header->AddInst(std::make_shared<ir::IcmpInst>(
+            ir::IcmpInst::kSLT, cond, Load(header, n), I(10)));
+        header->AddInst(std::make_shared<ir::BrInst>(
+            cond, body->GetLabelPtr(), exit->GetLabelPtr()));
+
+        Increment(body, GEP(body, g, {I(0), index}));
+        if (call) {
+            body->AddInst(std::make_shared<ir::CallInst>(
+                std::make_shared<ir::GlobalVar>(
+                    new ir::FuncType(new ir::VoidType(),
+                                     std::vector<ir::Type *>{}),
+                    "foo"),
+                std::vector<std::shared_ptr<ir::Value>>{}));
+        }
+        Increment(body, n);
+        body->AddInst(std::make_shared<ir::BrInst>(header->GetLabelPtr()));
+        exit->AddInst(std::make_shared<ir::RetInst>(I(0)));
+    }
+
+    void Increment(const std::shared_ptr<BasicBlock> &bb,
+                   const std::shared_ptr<ir::Var> &ptr) {
+        Store(bb, Add(bb, Load(bb, ptr), I(1)), ptr);
+    }
+
+    static std::vector<Inst::InstKind> Kinds(
+        const std::shared_ptr<BasicBlock> &bb) {
+        std::vector<Inst::InstKind> kind_list;
+        for (const auto &inst : bb->GetInstList()) {
+            kind_list.push_back(inst->kind);
+        }
+        return kind_list;
+    }
+
+    int Count(const Inst::InstKind kind) const {
+        int count = 0;
+        for (const auto &bb : func.GetBlockList()) {
+            for (const auto &inst : bb->GetInstList()) {
+                count += inst->kind == kind ? 1 : 0;
+            }
+        }
+        return count;
+    }
+};
+
+// both words live in values through the loop, loaded before it and stored
+// on the way out
+TEST_F(ScalarPromotionTest, Promote) {
+    BuildLoop(I(0), false);
+    opt::ScalarPromotion scalar_promotion;
+    EXPECT_EQ(2, scalar_promotion.Run(func));
+    EXPECT_EQ((std::vector<Inst::InstKind>{Inst::kBinaryOp, Inst::kBinaryOp,
+                                           Inst::kBr}),
+              Kinds(body));
+    EXPECT_EQ(Inst::kPhi, header->GetInstList().front()->kind);
+    EXPECT_EQ(2, Count(Inst::kLoad));
+    EXPECT_EQ(2, Count(Inst::kStore));
+    EXPECT_EQ(0, Count(Inst::kAlloca));
+    // a block of its own for the stores on the edge out
+    EXPECT_EQ(5, func.GetBlockList().size());
+    EXPECT_EQ(0, scalar_promotion.Run(func));
+}
+
+// g[%0] may be out of bounds, and the loop may not touch it at all
+TEST_F(ScalarPromotionTest, Speculate) {
+    BuildLoop(param, false);
+    opt::ScalarPromotion scalar_promotion;
+    EXPECT_EQ(1, scalar_promotion.Run(func));
+    EXPECT_EQ((std::vector<Inst::InstKind>{
+                  Inst::kGetelementptr, Inst::kLoad, Inst::kBinaryOp,
+                  Inst::kStore, Inst::kBinaryOp, Inst::kBr}),
+              Kinds(body));
+}
+
+// a function nothing is known of may touch any global
+TEST_F(ScalarPromotionTest, Call) {
+    BuildLoop(I(0), true);
+    opt::ScalarPromotion scalar_promotion;
+    EXPECT_EQ(0, scalar_promotion.Run(func));
+}
@@ -0,0 +1,95 @@
+#include "opt/simplify_cfg.h"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <vector>
+
+#include "ir/ir.h"
+#include "ir/type.h"
+#include "ir/value.h"
+#include "ir_builder.h"
+
+using ir::TmpVar;
+
+// i32 @func(i32 %0) with blocks entry, %1, ...
+class SimplifyCFGTest : public IRBuilderTest {
+  protected:
+    const std::shared_ptr<TmpVar> &param = param_list[0];
+    std::shared_ptr<ir::BasicBlock> entry = AddBlock("entry");
+
+    static std::shared_ptr<TmpVar> Cond(const int id) {
+        return std::make_shared<TmpVar>(
+            std::make_shared<ir::IntType>(ir::IntType::kI1), id);
+    }
+};
+
+// a branch on true through a forwarding block, the false side is dead
+TEST_F(SimplifyCFGTest, Chain) {
+    auto then_bb = AddBlock(1);
+    auto else_bb = AddBlock(2);
+    auto next = AddBlock(3);
+
+    entry->AddInst(std::make_shared<ir::BrInst>(std::make_shared<ir::Imm>(true),
+                                                then_bb->GetLabelPtr(),
+                                                else_bb->GetLabelPtr()));
+    then_bb->AddInst(std::make_shared<ir::BrInst>(next->GetLabelPtr()));
+    else_bb->AddInst(std::make_shared<ir::RetInst>(I(1)));
+    auto sum = std::make_shared<TmpVar>(4);
+    next->AddInst(std::make_shared<ir::BinaryOpInst>(ir::BinaryOpInst::kAdd,
+                                                     sum, param, I(1)));
+    next->AddInst(std::make_shared<ir::RetInst>(sum));
+
+    opt::SimplifyCFG simplify_cfg;
+    EXPECT_LT(0, simplify_cfg.Run(func));
+    EXPECT_EQ(
+        "define i32 @func(i32 %0) {\n"
+        "entry:\n"
+        "    %1 = add i32 %0, 1\n"
+        "    ret i32 %1\n"
+        "}\n\n",
+        Str());
+}
+
+// return %0 > 0 ? 1 : 0 the way short circuit code joins, the join is
+// threaded away
+TEST_F(SimplifyCFGTest, Thread) {
+    auto then_bb = AddBlock(2);
+    auto join = AddBlock(3);
+    auto if_true = AddBlock(6);
+    auto if_false = AddBlock(7);
+
+    auto cond = Cond(1);
+    entry->AddInst(
+        std::make_shared<ir::IcmpInst>(ir::IcmpInst::kSGT, cond, param, I(0)));
+    entry->AddInst(std::make_shared<ir::BrInst>(cond, then_bb->GetLabelPtr(),
+                                                join->GetLabelPtr()));
+    then_bb->AddInst(std::make_shared<ir::BrInst>(join->GetLabelPtr()));
+
+    auto value = std::make_shared<TmpVar>(4);
+    auto is_true = Cond(5);
+    join->AddInst(std::make_shared<ir::PhiInst>(
+        value, std::vector<ir::PhiInst::PhiValue>{
+                   {I(0), entry->GetLabelPtr()},
+                   {I(1), then_bb->GetLabelPtr()}}));
+    join->AddInst(std::make_shared<ir::IcmpInst>(ir::IcmpInst::kNE, is_true,
+                                                 value, I(0)));
+    join->AddInst(std::make_shared<ir::BrInst>(
+        is_true, if_true->GetLabelPtr(), if_false->GetLabelPtr()));
+    if_true->AddInst(std::make_shared<ir::RetInst>(I(1)));
+    if_false->AddInst(std::make_shared<ir::RetInst>(I(0)));
+
+    opt::SimplifyCFG simplify_cfg;
+    EXPECT_LT(0, simplify_cfg.Run(func));
+    EXPECT_EQ(
+        "define i32 @func(i32 %0) {\n"
+        "entry:\n"
+        "    %1 = icmp sgt i32 %0, 0\n"
+        "    br i1 %1, label %2, label %3\n"
+        "2:\n"
+        "    ret i32 1\n"
+        "3:\n"
+        "    ret i32 0\n"
+        "}\n\n",
+        Str());
+}
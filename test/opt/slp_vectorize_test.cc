@@ -0,0 +1,133 @@
+#include "opt/slp_vectorize.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include "ir/ir.h"
+#include "ir/type.h"
+#include "ir/value.h"
+#include "ir_builder.h"
+
+using ir::BasicBlock;
+using ir::BinaryOpInst;
+using ir::TmpVar;
+
+// i32 @func(i32 %0) of a single block over the globals @a, @b and @c of
+// [16 x i32]
+class SLPVectorizeTest : public IRBuilderTest {
+  protected:
+    std::shared_ptr<TmpVar> param = param_list[0];
+    std::shared_ptr<ir::GlobalVar> a = Global("a", {16});
+    std::shared_ptr<ir::GlobalVar> b = Global("b", {16});
+    std::shared_ptr<ir::GlobalVar> c = Global("c", {16});
+    std::shared_ptr<BasicBlock> entry = AddBlock();
+
+    void Finish() { entry->AddInst(std::make_shared<ir::RetInst>(I(0))); }
+
+    // the number of instructions of kind reading or writing vectors, or
+    // not
+    int Count(const ir::Inst::InstKind kind, const bool vector) const {
+        int count = 0;
+        for (const auto &inst : entry->GetInstList()) {
+            if (inst->kind != kind) continue;
+            auto value_list = inst->GetUseList();
+            if (auto result = inst->GetResultPtr()) {
+                value_list.push_back(result);
+            }
+            if (vector
+                == std::any_of(value_list.begin(), value_list.end(),
+                               [](const std::shared_ptr<ir::Value> &value) {
+                                   return value->GetType().kind
+                                          == ir::Type::kVector;
+                               })) {
+                ++count;
+            }
+        }
+        return count;
+    }
+
+    std::shared_ptr<TmpVar> Op(const BinaryOpInst::BinaryOpKind op_code,
+                               const std::shared_ptr<ir::Value> &lhs,
+                               const std::shared_ptr<ir::Value> &rhs) {
+        return IRBuilderTest::Op(entry, op_code, lhs, rhs);
+    }
+
+    void Store(const std::shared_ptr<ir::Var> &array,
+               const int index,
+               const std::shared_ptr<ir::Value> &value) {
+        IRBuilderTest::Store(entry, value, GEP(entry, array, {I(0), I(index)}));
+    }
+
+    std::shared_ptr<TmpVar> Load(const std::shared_ptr<ir::Var> &array,
+                                 const int index) {
+        return IRBuilderTest::Load(entry, GEP(entry, array, {I(0), I(index)}));
+    }
+};
+
+// a[k] = b[k] + c[k] * %0, the operands of one lane the other way around
+TEST_F(SLPVectorizeTest, Tree) {
+    for (int k = 0; k < 4; ++k) {
+        auto product = Op(BinaryOpInst::kMul, Load(c, k), param);
+        auto sum = k == 1 ? Op(BinaryOpInst::kAdd, product, Load(b, k))
+                          : Op(BinaryOpInst::kAdd, Load(b, k), product);
+        Store(a, k, sum);
+    }
+    Finish();
+    opt::SLPVectorize slp_vectorize;
+    EXPECT_EQ(1, slp_vectorize.Run(func));
+    EXPECT_EQ(2, Count(ir::Inst::kLoad, true));
+    EXPECT_EQ(2, Count(ir::Inst::kBinaryOp, true));
+    EXPECT_EQ(1, Count(ir::Inst::kStore, true));
+    EXPECT_EQ(0, Count(ir::Inst::kLoad, false));
+    EXPECT_EQ(0, Count(ir::Inst::kBinaryOp, false));
+    EXPECT_EQ(0, Count(ir::Inst::kStore, false));
+    EXPECT_EQ(0, slp_vectorize.Run(func));
+}
+
+// a[k] = 0 on four words, the one at 4 left out
+TEST_F(SLPVectorizeTest, Splat) {
+    for (int k = 4; k >= 0; --k) Store(a, k, I(0));
+    Finish();
+    opt::SLPVectorize slp_vectorize;
+    EXPECT_EQ(1, slp_vectorize.Run(func));
+    EXPECT_EQ(1, Count(ir::Inst::kStore, true));
+    EXPECT_EQ(1, Count(ir::Inst::kStore, false));
+}
+
+// a[k] = %0 + k moves each constant to a register and into a lane, more
+// than the scalars cost
+TEST_F(SLPVectorizeTest, Gather) {
+    for (int k = 0; k < 4; ++k) {
+        Store(a, k, Op(BinaryOpInst::kAdd, param, I(k)));
+    }
+    Finish();
+    opt::SLPVectorize slp_vectorize;
+    EXPECT_EQ(0, slp_vectorize.Run(func));
+}
+
+// b[k] = a[k] + 1 with a[1] written after it is read, the store of a[2]
+// before its load is read on the lane
+TEST_F(SLPVectorizeTest, Clobber) {
+    for (int k = 0; k < 4; ++k) {
+        if (k == 2) Store(a, 2, param);
+        Store(b, k, Op(BinaryOpInst::kAdd, Load(a, k), I(1)));
+        if (k == 1) Store(a, 1, param);
+    }
+    Finish();
+    opt::SLPVectorize slp_vectorize;
+    EXPECT_EQ(0, slp_vectorize.Run(func));
+
+    // without the store of a[1]
+    entry->GetInstList().clear();
+    for (int k = 0; k < 4; ++k) {
+        if (k == 2) Store(a, 2, param);
+        Store(b, k, Op(BinaryOpInst::kAdd, Load(a, k), I(1)));
+    }
+    Finish();
+    EXPECT_EQ(1, slp_vectorize.Run(func));
+    EXPECT_EQ(1, Count(ir::Inst::kLoad, true));
+    EXPECT_EQ(1, Count(ir::Inst::kStore, false));
+}
@@ -0,0 +1,114 @@
+#include "opt/strength_reduction.h"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <string>
+
+#include "ir/ir.h"
+#include "ir/type.h"
+#include "ir/value.h"
+#include "ir_builder.h"
+
+using ir::BinaryOpInst;
+using ir::TmpVar;
+
+// i32 @func(i32 %0) with a single block
+class StrengthReductionTest : public IRBuilderTest {
+  protected:
+    const std::shared_ptr<TmpVar> &param = param_list[0];
+    std::shared_ptr<ir::BasicBlock> entry = AddBlock("entry");
+
+    std::shared_ptr<TmpVar> Op(const BinaryOpInst::BinaryOpKind op_code,
+                               const std::shared_ptr<ir::Value> &lhs,
+                               const std::shared_ptr<ir::Value> &rhs) {
+        return IRBuilderTest::Op(entry, op_code, lhs, rhs);
+    }
+
+    std::string Body() {
+        std::string str;
+        for (const auto &inst : entry->GetInstList()) {
+            str += inst->Str() + '\n';
+        }
+        return str;
+    }
+};
+
+TEST_F(StrengthReductionTest, Constant) {
+    auto a = Op(BinaryOpInst::kMul, I(8), param);
+    auto b = Op(BinaryOpInst::kSDiv, a, I(2));
+    auto c = Op(BinaryOpInst::kSRem, b, I(-16));
+    auto d = Op(BinaryOpInst::kSDiv, c, I(1));
+    auto e = Op(BinaryOpInst::kMul, d, I(6));
+    entry->AddInst(std::make_shared<ir::RetInst>(e));
+
+    opt::StrengthReduction strength_reduction;
+    EXPECT_EQ(4, strength_reduction.Run(func));
+    EXPECT_EQ(
+        "%1 = shl i32 %0, 3\n"
+        "%2 = lshr i32 %1, 31\n"
+        "%3 = add i32 %1, %2\n"
+        "%4 = ashr i32 %3, 1\n"
+        "%5 = ashr i32 %4, 31\n"
+        "%6 = lshr i32 %5, 28\n"
+        "%7 = add i32 %4, %6\n"
+        "%8 = and i32 %7, -16\n"
+        "%9 = sub i32 %4, %8\n"
+        "%10 = mul i32 %9, 6\n"
+        "ret i32 %10\n",
+        Body());
+}
+
+TEST_F(StrengthReductionTest, NonNegative) {
+    auto a = Op(BinaryOpInst::kLShr, param, I(1));
+    auto b = Op(BinaryOpInst::kSDiv, a, I(4));
+    auto c = Op(BinaryOpInst::kSRem, b, I(4));
+    entry->AddInst(std::make_shared<ir::RetInst>(c));
+
+    opt::StrengthReduction strength_reduction;
+    EXPECT_EQ(2, strength_reduction.Run(func));
+    EXPECT_EQ(
+        "%1 = lshr i32 %0, 1\n"
+        "%2 = ashr i32 %1, 2\n"
+        "%3 = and i32 %2, 3\n"
+        "ret i32 %3\n",
+        Body());
+}
+
+// int p = 1; p = p * 2; return %0 / p;
+TEST_F(StrengthReductionTest, Doubling) {
+    auto p = NewVar(std::make_shared<ir::PtrType>());
+    entry->AddInst(std::make_shared<ir::AllocaInst>(p));
+    entry->AddInst(std::make_shared<ir::StoreInst>(I(1), p));
+    auto a = NewVar();
+    entry->AddInst(std::make_shared<ir::LoadInst>(a, p));
+    auto b = Op(BinaryOpInst::kMul, a, I(2));
+    entry->AddInst(std::make_shared<ir::StoreInst>(b, p));
+    auto c = NewVar();
+    entry->AddInst(std::make_shared<ir::LoadInst>(c, p));
+    auto d = Op(BinaryOpInst::kSDiv, param, c);
+    entry->AddInst(std::make_shared<ir::RetInst>(d));
+
+    opt::StrengthReduction strength_reduction;
+    EXPECT_EQ(2, strength_reduction.Run(func));
+    EXPECT_EQ(
+        "%1 = alloca i32\n"
+        "%2 = alloca i32\n"
+        "store i32 1, i32* %2\n"
+        "store i32 0, i32* %1\n"
+        "%3 = load i32, i32* %2\n"
+        "%4 = load i32, i32* %1\n"
+        "%5 = shl i32 %3, 1\n"
+        "store i32 %5, i32* %2\n"
+        "%6 = add i32 %4, 1\n"
+        "store i32 %6, i32* %1\n"
+        "%7 = load i32, i32* %2\n"
+        "%8 = load i32, i32* %1\n"
+        "%9 = ashr i32 %0, 31\n"
+        "%10 = sub i32 %7, 1\n"
+        "%11 = and i32 %9, %10\n"
+        "%12 = add i32 %0, %11\n"
+        "%13 = ashr i32 %12, %8\n"
+        "ret i32 %13\n",
+        Body());
+}